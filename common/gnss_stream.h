@@ -0,0 +1,278 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+
+  Streaming helpers shared by the INDI GNSS drivers
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <poll.h>
+#include <unistd.h>
+
+/*
+ * Allocation free building blocks for the GNSS reader threads:
+ *  - LineBuffer frames a byte stream into lines, in place, in a fixed buffer.
+ *  - nmeaChecksumValid() checks an NMEA sentence using a hex lookup table.
+ *  - LatestSlot hands the latest fix from the reader thread to the INDI thread without locks.
+ *
+ * This header is kept identical in indi-gpsnmea and indi-rtklib.
+ */
+namespace GNSSStream
+{
+
+/** Result of LineBuffer::fill() besides the number of bytes read */
+enum
+{
+    READ_TIMEOUT = 0,
+    READ_ERROR   = -1,
+    READ_CLOSED  = -2
+};
+
+/** Value of each hex digit, 0xFF for any other character. */
+struct HexTable
+{
+    uint8_t value[256];
+
+    constexpr HexTable() : value()
+    {
+        for (int i = 0; i < 256; i++)
+            value[i] = 0xFF;
+        for (int i = 0; i < 10; i++)
+            value['0' + i] = i;
+        for (int i = 0; i < 6; i++)
+        {
+            value['A' + i] = 10 + i;
+            value['a' + i] = 10 + i;
+        }
+    }
+};
+
+static constexpr HexTable hexTable;
+
+/**
+ * @brief Checks the sentence "$...*hh" against its checksum, the XOR of all characters between '$' and '*'.
+ * @param sentence the sentence, without line terminator
+ * @param length length of the sentence
+ * @param strict if false, sentences without checksum are accepted
+ * @return true if the sentence is well formed and the checksum matches
+ */
+inline bool nmeaChecksumValid(const char *sentence, size_t length, bool strict = false)
+{
+    if (length < 2 || sentence[0] != '$')
+        return false;
+
+    uint8_t checksum = 0;
+    size_t i = 1;
+    for (; i < length && sentence[i] != '*'; i++)
+    {
+        unsigned char c = sentence[i];
+        if (c < 0x20 || c > 0x7E)
+            return false;
+        checksum ^= c;
+    }
+
+    if (i == length)
+        return !strict;
+
+    // Exactly two hex digits must follow the '*'
+    if (length - i != 3)
+        return false;
+
+    uint8_t upper = hexTable.value[static_cast<unsigned char>(sentence[i + 1])];
+    uint8_t lower = hexTable.value[static_cast<unsigned char>(sentence[i + 2])];
+    if (upper == 0xFF || lower == 0xFF)
+        return false;
+
+    return checksum == ((upper << 4) | lower);
+}
+
+/**
+ * @brief Frames a byte stream into delimited lines inside a fixed buffer.
+ * Lines are returned in place, NUL terminated, without the delimiter and a trailing CR.
+ * A returned line stays valid until the next call to fill() or append().
+ * Lines longer than the capacity are dropped and counted as overflows.
+ */
+template <size_t Capacity>
+class LineBuffer
+{
+    public:
+        explicit LineBuffer(char delimiter = '\n') : m_Delimiter(delimiter) {}
+
+        void clear()
+        {
+            m_Head = m_Scan = m_Tail = 0;
+        }
+
+        /**
+         * @brief Waits for data on the file descriptor and reads whatever is available.
+         * @param fd file descriptor to read from
+         * @param timeout timeout in milliseconds
+         * @return the number of bytes read, READ_TIMEOUT, READ_ERROR (see errno) or READ_CLOSED
+         */
+        ssize_t fill(int fd, int timeout)
+        {
+            makeRoom();
+
+            pollfd pfd = {fd, POLLIN, 0};
+            int rc = poll(&pfd, 1, timeout);
+            if (rc < 0)
+                return READ_ERROR;
+            if (rc == 0)
+                return READ_TIMEOUT;
+
+            ssize_t n = read(fd, m_Buffer + m_Tail, Capacity - m_Tail);
+            if (n < 0)
+                return (errno == EAGAIN || errno == EINTR) ? READ_TIMEOUT : READ_ERROR;
+            if (n == 0)
+                return READ_CLOSED;
+
+            m_Tail += n;
+            return n;
+        }
+
+        /**
+         * @brief Appends bytes already received, e.g. when replaying a log.
+         * @return the number of bytes taken, less than length if the buffer is full
+         */
+        size_t append(const char *data, size_t length)
+        {
+            makeRoom();
+
+            size_t n = length < Capacity - m_Tail ? length : Capacity - m_Tail;
+            memcpy(m_Buffer + m_Tail, data, n);
+            m_Tail += n;
+            return n;
+        }
+
+        /**
+         * @brief Returns the next complete line, or nullptr if none is buffered.
+         * @param length if not null, receives the length of the line
+         */
+        char *next(size_t *length = nullptr)
+        {
+            char *delimiter = static_cast<char *>(memchr(m_Buffer + m_Scan, m_Delimiter, m_Tail - m_Scan));
+            if (delimiter == nullptr)
+            {
+                m_Scan = m_Tail;
+                return nullptr;
+            }
+
+            char *line = m_Buffer + m_Head;
+            size_t end = delimiter - m_Buffer;
+
+            m_Head = m_Scan = end + 1;
+
+            if (end > static_cast<size_t>(line - m_Buffer) && m_Buffer[end - 1] == '\r')
+                end--;
+            m_Buffer[end] = '\0';
+
+            if (length)
+                *length = m_Buffer + end - line;
+
+            return line;
+        }
+
+        uint32_t getOverflows() const
+        {
+            return m_Overflows;
+        }
+
+    private:
+        void makeRoom()
+        {
+            // Everything consumed, start over at the front
+            if (m_Head == m_Tail)
+            {
+                clear();
+                return;
+            }
+
+            // Move the unterminated line to the front
+            if (m_Head > 0)
+            {
+                memmove(m_Buffer, m_Buffer + m_Head, m_Tail - m_Head);
+                m_Tail -= m_Head;
+                m_Scan -= m_Head;
+                m_Head = 0;
+            }
+
+            // A single line fills the whole buffer, it can not be framed
+            if (m_Tail == Capacity)
+            {
+                m_Overflows++;
+                clear();
+            }
+        }
+
+        char m_Buffer[Capacity + 1];
+        char m_Delimiter;
+        size_t m_Head {0};
+        size_t m_Scan {0};
+        size_t m_Tail {0};
+        uint32_t m_Overflows {0};
+};
+
+/**
+ * @brief Single producer, single consumer slot holding the latest published value.
+ * Triple buffered: the producer and the consumer each own a buffer and swap it with
+ * the shared middle one atomically, so neither side ever blocks the other.
+ */
+template <typename T>
+class LatestSlot
+{
+    public:
+        /** Producer side: publish a value, replacing any value not yet consumed. */
+        void publish(const T &value)
+        {
+            m_Buffers[m_Back] = value;
+            uint8_t previous = m_Middle.exchange(m_Back | FRESH, std::memory_order_acq_rel);
+            m_Back = previous & INDEX;
+        }
+
+        /** Consumer side: fetch the latest value if one was published since the last call. */
+        bool consume(T &value)
+        {
+            if ((m_Middle.load(std::memory_order_relaxed) & FRESH) == 0)
+                return false;
+
+            uint8_t previous = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+            m_Front = previous & INDEX;
+            value = m_Buffers[m_Front];
+            return true;
+        }
+
+    private:
+        static constexpr uint8_t INDEX = 0x03;
+        static constexpr uint8_t FRESH = 0x04;
+
+        T m_Buffers[3] {};
+        std::atomic<uint8_t> m_Middle {1};
+        uint8_t m_Back {0};
+        uint8_t m_Front {2};
+};
+
+}
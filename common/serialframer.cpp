@@ -0,0 +1,255 @@
+/*
+    Buffered serial frame reader shared by the serial drivers
+    Copyright(c) 2026. All rights reserved.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "serialframer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <poll.h>
+#include <unistd.h>
+
+SerialFramer::SerialFramer(size_t capacity) : m_Buffer(std::max<size_t>(capacity, 16))
+{
+}
+
+void SerialFramer::setFD(int fd)
+{
+    m_FD   = fd;
+    m_Head = 0;
+    m_Size = 0;
+}
+
+void SerialFramer::consume(size_t count)
+{
+    count  = std::min(count, m_Size);
+    m_Head = (m_Head + count) % m_Buffer.size();
+    m_Size -= count;
+    if (m_Size == 0)
+        m_Head = 0;
+}
+
+SerialFramer::Result SerialFramer::fill(const Deadline &deadline)
+{
+    if (m_FD < 0)
+        return FRAME_IO_ERROR;
+
+    if (m_Size == m_Buffer.size())
+        return FRAME_OVERFLOW;
+
+    while (true)
+    {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() < 0)
+            return FRAME_TIMEOUT;
+
+        pollfd pfd = { m_FD, POLLIN, 0 };
+        m_Statistics.pollCalls++;
+        int rc = poll(&pfd, 1, static_cast<int>(remaining.count()));
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc < 0)
+            return FRAME_IO_ERROR;
+        if (rc == 0)
+        {
+            if (std::chrono::steady_clock::now() >= deadline)
+                return FRAME_TIMEOUT;
+            continue;
+        }
+        break;
+    }
+
+    // As much as fits in the free space after the data
+    size_t tail  = (m_Head + m_Size) % m_Buffer.size();
+    size_t space = (tail >= m_Head) ? m_Buffer.size() - tail : m_Head - tail;
+    space = std::min(space, m_Buffer.size() - m_Size);
+
+    m_Statistics.readCalls++;
+    ssize_t n = read(m_FD, m_Buffer.data() + tail, space);
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return FRAME_OK;
+    if (n <= 0)
+        return FRAME_IO_ERROR;
+
+    m_Size += n;
+    m_Statistics.bytesRead += n;
+    return FRAME_OK;
+}
+
+size_t SerialFramer::discardInput()
+{
+    size_t discarded = m_Size;
+    m_Head = 0;
+    m_Size = 0;
+
+    if (m_FD >= 0)
+    {
+        pollfd pfd = { m_FD, POLLIN, 0 };
+        m_Statistics.pollCalls++;
+        while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN))
+        {
+            uint8_t buffer[256];
+            m_Statistics.readCalls++;
+            ssize_t n = read(m_FD, buffer, sizeof(buffer));
+            if (n <= 0)
+                break;
+            discarded += n;
+            m_Statistics.pollCalls++;
+        }
+    }
+
+    m_Statistics.bytesDiscarded += discarded;
+    return discarded;
+}
+
+SerialFramer::Result SerialFramer::write(const void *data, size_t size, int timeout)
+{
+    if (m_FD < 0)
+        return FRAME_IO_ERROR;
+
+    Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    size_t written = 0;
+
+    while (written < size)
+    {
+        m_Statistics.writeCalls++;
+        ssize_t n = ::write(m_FD, bytes + written, size - written);
+        if (n > 0)
+        {
+            written += n;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            return FRAME_IO_ERROR;
+
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0)
+            return FRAME_TIMEOUT;
+
+        pollfd pfd = { m_FD, POLLOUT, 0 };
+        m_Statistics.pollCalls++;
+        poll(&pfd, 1, static_cast<int>(remaining.count()));
+    }
+
+    return FRAME_OK;
+}
+
+SerialFramer::Result SerialFramer::readFrame(std::string &frame, const char *terminators, int timeout, bool skipEmpty)
+{
+    Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    size_t terminatorCount = strlen(terminators);
+    size_t scanned = 0;
+
+    while (true)
+    {
+        while (scanned < m_Size)
+        {
+            if (memchr(terminators, at(scanned), terminatorCount) == nullptr)
+            {
+                scanned++;
+                continue;
+            }
+
+            if (scanned == 0 && skipEmpty)
+            {
+                consume(1);
+                continue;
+            }
+
+            frame.resize(scanned);
+            for (size_t i = 0; i < scanned; i++)
+                frame[i] = static_cast<char>(at(i));
+            consume(scanned + 1);
+            return FRAME_OK;
+        }
+
+        Result result = fill(deadline);
+        if (result == FRAME_OVERFLOW)
+        {
+            // No terminator in a full buffer, the input is garbage
+            m_Statistics.bytesDiscarded += m_Size;
+            consume(m_Size);
+            return result;
+        }
+        if (result != FRAME_OK)
+            return result;
+    }
+}
+
+SerialFramer::Result SerialFramer::readPacket(char *packet, size_t capacity, const PacketFormat &format, int timeout,
+        size_t *size)
+{
+    Deadline deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+
+    while (true)
+    {
+        // Drop everything before the start byte
+        size_t start = 0;
+        while (start < m_Size && at(start) != format.startByte)
+            start++;
+        m_Statistics.bytesDiscarded += start;
+        consume(start);
+
+        if (m_Size > format.lengthOffset)
+        {
+            uint8_t length = at(format.lengthOffset);
+            size_t total   = length + format.overhead;
+            if (length < format.minLength || length > format.maxLength || total > capacity || total > m_Buffer.size())
+            {
+                // Not a packet after all, look for the next start byte
+                m_Statistics.bytesDiscarded++;
+                consume(1);
+                return FRAME_BAD_LENGTH;
+            }
+
+            if (m_Size >= total)
+            {
+                for (size_t i = 0; i < total; i++)
+                    packet[i] = static_cast<char>(at(i));
+                consume(total);
+                *size = total;
+                return FRAME_OK;
+            }
+        }
+
+        Result result = fill(deadline);
+        if (result != FRAME_OK)
+            return result;
+    }
+}
+
+const char *SerialFramer::resultMessage(Result result)
+{
+    switch (result)
+    {
+        case FRAME_OK:
+            return "OK";
+        case FRAME_TIMEOUT:
+            return "Timeout waiting for the device";
+        case FRAME_IO_ERROR:
+            return strerror(errno);
+        case FRAME_BAD_LENGTH:
+            return "Invalid declared message length";
+        case FRAME_OVERFLOW:
+            return "Message too long";
+    }
+    return "Unknown error";
+}
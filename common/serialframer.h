@@ -0,0 +1,145 @@
+/*
+    Buffered serial frame reader shared by the serial drivers
+    Copyright(c) 2026. All rights reserved.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Reads a serial port in chunks and cuts the input in frames.
+ *
+ * Every read takes whatever the port has available into a ring buffer, frames are then cut
+ * from the buffer either at a terminator or from a length byte following a start byte.
+ * Timeouts apply to a whole frame, not to each byte. Bytes received after a frame stay in
+ * the buffer for the next one, so the port never has to be flushed to stay in sync:
+ * discardInput() drops stale input when a protocol cannot tell a late answer from a new one.
+ */
+class SerialFramer
+{
+    public:
+        enum Result
+        {
+            FRAME_OK         = 0,
+            FRAME_TIMEOUT    = -1,
+            FRAME_IO_ERROR   = -2,
+            FRAME_BAD_LENGTH = -3,
+            FRAME_OVERFLOW   = -4
+        };
+
+        /** Layout of a length prefixed packet */
+        struct PacketFormat
+        {
+            uint8_t startByte;
+            size_t lengthOffset;    // offset of the length byte from the start byte
+            size_t overhead;        // bytes of the packet not counted by the length byte
+            uint8_t minLength;
+            uint8_t maxLength;
+        };
+
+        /** System calls made and bytes moved, to measure the cost of a transaction */
+        struct Statistics
+        {
+            uint64_t pollCalls { 0 };
+            uint64_t readCalls { 0 };
+            uint64_t writeCalls { 0 };
+            uint64_t bytesRead { 0 };
+            uint64_t bytesDiscarded { 0 };
+
+            uint64_t syscalls() const
+            {
+                return pollCalls + readCalls + writeCalls;
+            }
+        };
+
+        explicit SerialFramer(size_t capacity = 1024);
+
+        /** Port to use, buffered input is dropped */
+        void setFD(int fd);
+        int getFD() const
+        {
+            return m_FD;
+        }
+
+        /** Drops buffered input and the input already waiting in the port, never blocks */
+        size_t discardInput();
+
+        Result write(const void *data, size_t size, int timeout);
+        Result write(const std::string &data, int timeout)
+        {
+            return write(data.data(), data.size(), timeout);
+        }
+
+        /**
+         * @brief Reads up to the next terminator.
+         * @param frame the frame, without the terminator.
+         * @param terminators any of these bytes ends a frame.
+         * @param timeout milliseconds for the whole frame.
+         * @param skipEmpty ignore frames with nothing before their terminator, as left by CR LF.
+         */
+        Result readFrame(std::string &frame, const char *terminators, int timeout, bool skipEmpty = true);
+
+        /**
+         * @brief Reads the next packet, bytes before the start byte are dropped.
+         * @param packet receives the whole packet, start byte included.
+         * @param capacity size of packet.
+         * @param size receives the size of the packet.
+         * @param timeout milliseconds for the whole packet.
+         * @return FRAME_BAD_LENGTH if the length byte is out of range, the start byte is then dropped.
+         */
+        Result readPacket(char *packet, size_t capacity, const PacketFormat &format, int timeout, size_t *size);
+
+        size_t available() const
+        {
+            return m_Size;
+        }
+
+        const Statistics &getStatistics() const
+        {
+            return m_Statistics;
+        }
+        void resetStatistics()
+        {
+            m_Statistics = Statistics();
+        }
+
+        static const char *resultMessage(Result result);
+
+    private:
+        using Deadline = std::chrono::steady_clock::time_point;
+
+        /** Waits until the port has input or the deadline passes, then reads all there is */
+        Result fill(const Deadline &deadline);
+
+        uint8_t at(size_t index) const
+        {
+            return m_Buffer[(m_Head + index) % m_Buffer.size()];
+        }
+        void consume(size_t count);
+
+        int m_FD { -1 };
+        std::vector<uint8_t> m_Buffer;
+        size_t m_Head { 0 };
+        size_t m_Size { 0 };
+
+        Statistics m_Statistics;
+};
@@ -0,0 +1,253 @@
+/*
+    Scripted serial device on a pseudo terminal, for the serial driver tests
+    Copyright(c) 2026. All rights reserved.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+/**
+ * @brief Answers requests on a pseudo terminal from a protocol script.
+ *
+ * Each step of the script is a request and its answer. The answer is written in chunks of
+ * the given size with the given gap, as a USB serial adapter delivers it. Requests not in
+ * the script are ignored, like a device does with garbage.
+ */
+class SerialScript
+{
+    public:
+        struct Step
+        {
+            std::string request;
+            std::string response;
+        };
+
+        ~SerialScript()
+        {
+            m_Running = false;
+            if (m_Thread.joinable())
+                m_Thread.join();
+            if (m_Slave >= 0)
+                close(m_Slave);
+            if (m_Master >= 0)
+                close(m_Master);
+        }
+
+        void add(const std::string &request, const std::string &response)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Steps.push_back({request, response});
+        }
+
+        /** Answers are sent in chunks of chunkSize bytes, gap microseconds apart */
+        void setPacing(size_t chunkSize, int gap)
+        {
+            m_ChunkSize = chunkSize;
+            m_Gap = gap;
+        }
+
+        /** Delay before answering, microseconds */
+        void setLatency(int latency)
+        {
+            m_Latency = latency;
+        }
+
+        /** Writes bytes nobody asked for, as a late or spurious answer */
+        void inject(const std::string &bytes)
+        {
+            if (write(m_Master, bytes.data(), bytes.size()) < 0)
+                return;
+        }
+
+        /** Opens the pseudo terminal and returns the driver side, raw mode */
+        int start()
+        {
+            m_Master = posix_openpt(O_RDWR | O_NOCTTY);
+            if (m_Master < 0 || grantpt(m_Master) != 0 || unlockpt(m_Master) != 0)
+                return -1;
+
+            m_Slave = open(ptsname(m_Master), O_RDWR | O_NOCTTY);
+            if (m_Slave < 0)
+                return -1;
+
+            termios settings;
+            tcgetattr(m_Slave, &settings);
+            cfmakeraw(&settings);
+            tcsetattr(m_Slave, TCSANOW, &settings);
+            tcgetattr(m_Master, &settings);
+            cfmakeraw(&settings);
+            tcsetattr(m_Master, TCSANOW, &settings);
+
+            m_Running = true;
+            m_Thread = std::thread(&SerialScript::run, this);
+            return m_Slave;
+        }
+
+        uint32_t getRequestCount() const
+        {
+            return m_Requests;
+        }
+
+    private:
+        void run()
+        {
+            std::string input;
+            while (m_Running)
+            {
+                pollfd pfd = { m_Master, POLLIN, 0 };
+                if (poll(&pfd, 1, 10) <= 0 || !(pfd.revents & POLLIN))
+                    continue;
+
+                char buffer[256];
+                ssize_t n = read(m_Master, buffer, sizeof(buffer));
+                if (n <= 0)
+                    continue;
+                input.append(buffer, n);
+
+                // Answer every complete request of the script found in the input
+                bool matched = true;
+                while (matched)
+                {
+                    matched = false;
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    for (const auto &step : m_Steps)
+                    {
+                        size_t position = input.find(step.request);
+                        if (position == std::string::npos)
+                            continue;
+
+                        input.erase(0, position + step.request.size());
+                        m_Requests++;
+                        respond(step.response);
+                        matched = true;
+                        break;
+                    }
+                }
+            }
+        }
+
+        void respond(const std::string &response)
+        {
+            if (m_Latency > 0)
+                std::this_thread::sleep_for(std::chrono::microseconds(m_Latency));
+
+            size_t chunk = m_ChunkSize > 0 ? m_ChunkSize : response.size();
+            for (size_t sent = 0; sent < response.size(); sent += chunk)
+            {
+                if (sent > 0 && m_Gap > 0)
+                    std::this_thread::sleep_for(std::chrono::microseconds(m_Gap));
+                if (write(m_Master, response.data() + sent, std::min(chunk, response.size() - sent)) < 0)
+                    return;
+            }
+        }
+
+        int m_Master { -1 };
+        int m_Slave { -1 };
+        std::thread m_Thread;
+        std::atomic<bool> m_Running { false };
+        std::atomic<uint32_t> m_Requests { 0 };
+
+        std::mutex m_Mutex;
+        std::vector<Step> m_Steps;
+        size_t m_ChunkSize { 0 };
+        int m_Gap { 0 };
+        int m_Latency { 0 };
+};
+
+/**
+ * @brief The receive path the drivers used before SerialFramer, counting its system calls.
+ *
+ * Same calls as tty_read(), tty_nread_section() and tcflush(): a select and a read for
+ * every call, one byte at a time for sections.
+ */
+class LegacyTty
+{
+    public:
+        explicit LegacyTty(int fd) : m_FD(fd) {}
+
+        void flush()
+        {
+            m_Syscalls++;
+            tcflush(m_FD, TCIOFLUSH);
+        }
+
+        bool write(const std::string &data)
+        {
+            m_Syscalls++;
+            return ::write(m_FD, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+        }
+
+        /** tty_read(): waits up to timeout seconds for every read */
+        int read(char *buffer, int size, int timeout)
+        {
+            int count = 0;
+            while (count < size)
+            {
+                if (!wait(timeout))
+                    return -1;
+                m_Syscalls++;
+                ssize_t n = ::read(m_FD, buffer + count, size - count);
+                if (n <= 0)
+                    return -1;
+                count += n;
+            }
+            return count;
+        }
+
+        /** tty_nread_section(): one byte at a time up to the stop character, which is kept */
+        int readSection(std::string &section, char stop, int timeout)
+        {
+            section.clear();
+            char c = 0;
+            while (c != stop)
+            {
+                if (read(&c, 1, timeout) != 1)
+                    return -1;
+                section += c;
+            }
+            return section.size();
+        }
+
+        uint64_t getSyscalls() const
+        {
+            return m_Syscalls;
+        }
+
+    private:
+        bool wait(int timeout)
+        {
+            pollfd pfd = { m_FD, POLLIN, 0 };
+            m_Syscalls++;
+            return poll(&pfd, 1, timeout * 1000) > 0;
+        }
+
+        int m_FD;
+        uint64_t m_Syscalls { 0 };
+};
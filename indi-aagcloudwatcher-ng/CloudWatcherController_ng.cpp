@@ -29,6 +29,7 @@
 #include "indiweather.h"
 #include "connectionplugins/connectionserial.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <fstream>
@@ -37,6 +38,7 @@
 #include <vector>
 
 #include <limits.h>
+#include <termios.h>
 
 
 #define READ_TIMEOUT 20
@@ -53,6 +55,11 @@ CloudWatcherController::CloudWatcherController(bool verbose) : verbose(verbose)
 {
 }
 
+CloudWatcherController::~CloudWatcherController()
+{
+    stopSampling();
+}
+
 const char *CloudWatcherController::getDeviceName()
 {
     return "AAG Cloud Watcher NG";
@@ -65,6 +72,7 @@ void CloudWatcherController::setPortFD(int newPortFD)
 
 void CloudWatcherController::setAnemometerType(enum ANEMOMETER_TYPE type)
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
     anemometerType = type;
 }
 
@@ -75,106 +83,375 @@ void CloudWatcherController::setElevation(float elevation)
 
 bool CloudWatcherController::getAllData(CloudWatcherData *cwd)
 {
-    auto check = false;
+    if (isSampling())
+    {
+        std::unique_lock<std::mutex> lock(dataMutex);
 
-    totalReadings++;
+        auto staleTime = std::chrono::milliseconds(std::max(10000, STALE_CYCLES * samplingPeriod.load()));
+
+        // Right after the sampler started, wait for its first read cycle
+        if (samplerStatistics.cycles == 0)
+            dataCondition.wait_for(lock, staleTime, [this] { return samplerStatistics.cycles > 0; });
+
+        if (samplerStatistics.cycles == 0 || std::chrono::steady_clock::now() - lastCycleTime > staleTime)
+        {
+            LOG_ERROR( "No recent readings from the sampler" );
+            return false;
+        }
+
+        totalReadings++;
+        fillData(cwd);
+        return true;
+    }
+
+    std::lock_guard<std::recursive_mutex> portLock(portMutex);
 
     timeval begin;
     gettimeofday(&begin, nullptr);
 
-    int skyTemperature[NUMBER_OF_READS] = {0};
-    int sensorTemperature[NUMBER_OF_READS] = {0};
-    int rainFrequency[NUMBER_OF_READS] = {0};
-    int internalSupplyVoltage[NUMBER_OF_READS] = {0};
-    float tempEstimate[NUMBER_OF_READS] = {0};
-    int ldrValue[NUMBER_OF_READS] = {0};
-    int lightFreq[NUMBER_OF_READS] = {0};
-    int rainSensorTemperature[NUMBER_OF_READS] = {0};
-    float wind[NUMBER_OF_READS] = {0};
-    float temperature[NUMBER_OF_READS] = {0};
-    float humidity[NUMBER_OF_READS] = {0};
-    float pressure[NUMBER_OF_READS] = {0};
+    std::lock_guard<std::mutex> dataLock(dataMutex);
+
+    for (auto &window : windows)
+        window.clear();
 
     for (int i = 0; i < NUMBER_OF_READS; i++)
     {
-        check = getIRSkyTemperature(skyTemperature[i]);
+        CycleReadings readings;
 
-        if (!check)
-        {
-            LOG_ERROR( "ERROR in getIRSkyTemperature" );
+        // The status is read once, along with the last readings
+        bool last = (i == NUMBER_OF_READS - 1);
+
+        if (!readCycle(readings, last))
             return false;
-        }
 
-        check = getIRSensorTemperature(sensorTemperature[i]);
+        for (int j = 0; j < SAMPLED_SENSOR_COUNT; j++)
+            windows[j].push(readings.values[j]);
+
+        if (last)
+            status = readings.status;
+    }
+
+    totalReadings++;
+
+    fillData(cwd);
+
+    timeval end;
+    gettimeofday(&end, nullptr);
+
+    float rc = float(end.tv_sec - begin.tv_sec) + float(end.tv_usec - begin.tv_usec) / 1000000.0;
+
+    cwd->readCycle = rc;
+
+    return true;
+}
+
+bool CloudWatcherController::startSampling()
+{
+    if (samplerRunning)
+        return true;
+
+    if (PortFD < 0)
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(dataMutex);
+
+        for (auto &window : windows)
+            window.clear();
+
+        samplerStatistics = CloudWatcherSamplerStatistics();
+        totalCycleTime = 0;
+    }
+
+    samplerRunning = true;
+    samplerThread = std::thread(&CloudWatcherController::samplerLoop, this);
+
+    LOGF_DEBUG("sampler started, period %i ms, pipeline depth %i", samplingPeriod.load(), pipelineDepth.load());
+
+    return true;
+}
+
+void CloudWatcherController::stopSampling()
+{
+    {
+        std::lock_guard<std::mutex> lock(samplerMutex);
+        samplerRunning = false;
+    }
+
+    samplerCondition.notify_all();
+
+    if (samplerThread.joinable())
+        samplerThread.join();
+}
+
+void CloudWatcherController::setSamplingPeriod(int period)
+{
+    samplingPeriod = std::max(0, period);
+    samplerCondition.notify_all();
+}
+
+void CloudWatcherController::setSensorWindow(SAMPLED_CHANNEL sensor, int size, AGGREGATION_POLICY policy)
+{
+    std::lock_guard<std::mutex> lock(dataMutex);
+    windows[sensor].configure(size, policy);
+}
+
+void CloudWatcherController::setPipelineDepth(int depth)
+{
+    pipelineDepth = std::max(1, std::min(static_cast<int>(MAX_PIPELINE_DEPTH), depth));
+}
+
+CloudWatcherSamplerStatistics CloudWatcherController::getSamplerStatistics()
+{
+    std::lock_guard<std::mutex> lock(dataMutex);
+
+    CloudWatcherSamplerStatistics statistics = samplerStatistics;
+    statistics.pipelineDepth = pipelineDepth;
+
+    return statistics;
+}
+
+void CloudWatcherController::samplerLoop()
+{
+    std::unique_lock<std::mutex> samplerLock(samplerMutex);
+
+    while (samplerRunning)
+    {
+        samplerLock.unlock();
+
+        auto begin = std::chrono::steady_clock::now();
+
+        CycleReadings readings;
+        bool check;
 
-        if (!check)
         {
-            LOG_ERROR( "ERROR in getIRSensorTemperature" );
-            return false;
+            std::lock_guard<std::recursive_mutex> portLock(portMutex);
+            check = readCycle(readings, true);
         }
 
-        check = getRainFrequency(rainFrequency[i]);
-        if (!check)
+        auto end = std::chrono::steady_clock::now();
+        float duration = std::chrono::duration<float>(end - begin).count();
+
         {
-            LOG_ERROR( "ERROR in getIRSensorTemperature" );
-            return false;
+            std::lock_guard<std::mutex> dataLock(dataMutex);
+
+            if (check)
+            {
+                for (int i = 0; i < SAMPLED_SENSOR_COUNT; i++)
+                    windows[i].push(readings.values[i]);
+
+                status = readings.status;
+                lastCycleTime = end;
+
+                totalCycleTime += duration;
+                samplerStatistics.cycles++;
+                samplerStatistics.lastCycle = duration;
+                samplerStatistics.meanCycle = totalCycleTime / samplerStatistics.cycles;
+                samplerStatistics.maxCycle = std::max(samplerStatistics.maxCycle, duration);
+            }
+            else
+            {
+                samplerStatistics.failedCycles++;
+            }
         }
 
-        check = getValues(&internalSupplyVoltage[i], &tempEstimate[i], &ldrValue[i], &lightFreq[i],
-                          &rainSensorTemperature[i]);
+        if (check)
+            dataCondition.notify_all();
+
+        LOGF_DEBUG("read cycle %s in %.3f s", check ? "completed" : "failed", duration);
 
-        if (!check)
+        // After an error, wait at least one second before retrying
+        int period = check ? samplingPeriod.load() : std::max(1000, samplingPeriod.load());
+
+        samplerLock.lock();
+        samplerCondition.wait_until(samplerLock, begin + std::chrono::milliseconds(period), [this]
         {
-            LOG_ERROR( "ERROR in getValues" );
-            return false;
-        }
+            return !samplerRunning;
+        });
+    }
+}
+
+int CloudWatcherController::getCycleCommands(CYCLE_COMMAND commands[], bool includeStatus)
+{
+    int count = 0;
+
+    commands[count++] = CYCLE_SKY;
+    commands[count++] = CYCLE_SENSOR;
+    commands[count++] = CYCLE_RAIN;
+    commands[count++] = CYCLE_VALUES;
+
+    // Same firmware checks as the individual commands, which answer locally when unsupported
+    if (m_FirmwareVersion >= 5 && m_AnemometerStatus)
+        commands[count++] = CYCLE_WIND;
+
+    if (m_FirmwareVersion >= 5.6)
+    {
+        commands[count++] = CYCLE_TEMPERATURE;
+        commands[count++] = CYCLE_HUMIDITY;
+    }
+
+    if (m_FirmwareVersion >= 5.8)
+        commands[count++] = CYCLE_PRESSURE;
+
+    if (includeStatus)
+    {
+        commands[count++] = CYCLE_ERRORS;
+        commands[count++] = CYCLE_PWM;
+        commands[count++] = CYCLE_SWITCH;
+    }
+
+    return count;
+}
+
+bool CloudWatcherController::readCycle(CycleReadings &readings, bool includeStatus)
+{
+    static const char *commandStrings[CYCLE_COMMAND_COUNT] =
+    {
+        "S!", "T!", "E!", "C!", "V!", "t!", "h!", "p!", "D!", "Q!", "F!"
+    };
+
+    static const char *commandFunctions[CYCLE_COMMAND_COUNT] =
+    {
+        "getIRSkyTemperature", "getIRSensorTemperature", "getRainFrequency", "getValues", "getWindSpeed",
+        "getTemperature", "getHumidity", "getPressure", "getIRErrors", "getPWMDutyCycle", "getSwitchStatus"
+    };
+
+    CYCLE_COMMAND commands[CYCLE_COMMAND_COUNT];
+    int count = getCycleCommands(commands, includeStatus);
+    int depth = pipelineDepth;
 
-        check = getWindSpeed(wind[i]);
+    // Values reported when the firmware lacks the sensor
+    readings.values[SAMPLED_WIND]        = 0;
+    readings.values[SAMPLED_TEMPERATURE] = -1000;
+    readings.values[SAMPLED_HUMIDITY]    = -1;
+    readings.values[SAMPLED_PRESSURE]    = 0;
+    readings.status                      = status;
+
+    int sent = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        // Keep up to depth commands queued in the device ahead of the answer being read
+        int target = std::min(count, i + depth);
 
-        if (!check)
+        if (sent < target)
         {
-            LOG_ERROR( "ERROR in getWindSpeed" );
-            return false;
-        }
+            char batch[2 * CYCLE_COMMAND_COUNT + 1] = {0};
+            int length = 0;
 
-        check = getTemperature(temperature[i]);
+            for (; sent < target; sent++, length += 2)
+                memcpy(&batch[length], commandStrings[commands[sent]], 2);
 
-        if (!check)
+            if (!sendCloudwatcherCommand(batch, length))
+                return false;
+        }
+
+        if (!readCycleAnswer(commands[i], readings))
         {
-            LOG_ERROR( "ERROR in getTemperature" );
+            LOGF_ERROR( "ERROR in %s", commandFunctions[commands[i]] );
+
+            if (sent > i + 1)
+            {
+                // Answers to the commands still in flight would be taken for the next ones
+                tcflush(PortFD, TCIOFLUSH);
+
+                LOGF_WARN("Pipelined read of %i commands failed, falling back to one command at a time.", depth);
+                pipelineDepth = 1;
+            }
+
             return false;
         }
+    }
 
-        check = getHumidity(humidity[i]);
+    return true;
+}
 
-        if (!check)
+bool CloudWatcherController::readCycleAnswer(CYCLE_COMMAND command, CycleReadings &readings)
+{
+    switch (command)
+    {
+        case CYCLE_SKY:
         {
-            LOG_ERROR( "ERROR in getHumidity" );
-            return false;
+            int sky = 0;
+            if (!getIRSkyTemperature(sky, false))
+                return false;
+            readings.values[SAMPLED_SKY] = sky;
+            return true;
         }
 
-        check = getPressure(pressure[i]);
+        case CYCLE_SENSOR:
+        {
+            int sensor = 0;
+            if (!getIRSensorTemperature(sensor, false))
+                return false;
+            readings.values[SAMPLED_SENSOR] = sensor;
+            return true;
+        }
 
-        if (!check)
+        case CYCLE_RAIN:
         {
-            LOG_ERROR( "ERROR in getPressure" );
-            return false;
+            int rain = 0;
+            if (!getRainFrequency(rain, false))
+                return false;
+            readings.values[SAMPLED_RAIN] = rain;
+            return true;
+        }
+
+        case CYCLE_VALUES:
+        {
+            int supply = 0, ldr = 0, lightFreq = 0, rainTemperature = 0;
+            float tempEstimate = 0;
+            if (!getValues(&supply, &tempEstimate, &ldr, &lightFreq, &rainTemperature, false))
+                return false;
+            readings.values[SAMPLED_SUPPLY]           = supply;
+            readings.values[SAMPLED_TEMP_EST]         = tempEstimate; // not really present since firmware 3.x.x
+            readings.values[SAMPLED_LDR]              = ldr;
+            readings.values[SAMPLED_LIGHT_FREQ]       = lightFreq;
+            readings.values[SAMPLED_RAIN_TEMPERATURE] = rainTemperature;
+            return true;
         }
+
+        case CYCLE_WIND:
+            return getWindSpeed(readings.values[SAMPLED_WIND], false);
+
+        case CYCLE_TEMPERATURE:
+            return getTemperature(readings.values[SAMPLED_TEMPERATURE], false);
+
+        case CYCLE_HUMIDITY:
+            return getHumidity(readings.values[SAMPLED_HUMIDITY], false);
+
+        case CYCLE_PRESSURE:
+            return getPressure(readings.values[SAMPLED_PRESSURE], false);
+
+        case CYCLE_ERRORS:
+            return getIRErrors(&readings.status.firstByteErrors, &readings.status.commandByteErrors,
+                               &readings.status.secondByteErrors, &readings.status.pecByteErrors, false);
+
+        case CYCLE_PWM:
+            return getPWMDutyCycle(readings.status.rainHeater, false);
+
+        case CYCLE_SWITCH:
+            return getSwitchStatus(&readings.status.switchStatus, false);
+
+        default:
+            return false;
     }
+}
 
-    cwd->sky             = aggregateInts(skyTemperature, NUMBER_OF_READS);
-    cwd->sensor          = aggregateInts(sensorTemperature, NUMBER_OF_READS);
-    cwd->rain            = aggregateInts(rainFrequency, NUMBER_OF_READS);
-    cwd->supply          = aggregateInts(internalSupplyVoltage, NUMBER_OF_READS);
-    cwd->tempEst         = aggregateFloats(tempEstimate, NUMBER_OF_READS); // not really present since firmware 3.x.x
-    cwd->ldr             = aggregateInts(ldrValue, NUMBER_OF_READS);
-    cwd->lightFreq       = aggregateInts(lightFreq, NUMBER_OF_READS);
-    cwd->rainTemperature = aggregateInts(rainSensorTemperature, NUMBER_OF_READS);
-    cwd->windSpeed       = aggregateFloats(wind, NUMBER_OF_READS);
-    cwd->windSpeed       = aggregateFloats(wind, NUMBER_OF_READS);
-    cwd->tempAct         = aggregateFloats(temperature, NUMBER_OF_READS);
-    cwd->humidity        = aggregateFloats(humidity, NUMBER_OF_READS);
-    cwd->pressure        = aggregateFloats(pressure, NUMBER_OF_READS);
+void CloudWatcherController::fillData(CloudWatcherData *cwd)
+{
+    cwd->sky             = windows[SAMPLED_SKY].aggregate();
+    cwd->sensor          = windows[SAMPLED_SENSOR].aggregate();
+    cwd->rain            = windows[SAMPLED_RAIN].aggregate();
+    cwd->supply          = windows[SAMPLED_SUPPLY].aggregate();
+    cwd->tempEst         = windows[SAMPLED_TEMP_EST].aggregate();
+    cwd->ldr             = windows[SAMPLED_LDR].aggregate();
+    cwd->lightFreq       = windows[SAMPLED_LIGHT_FREQ].aggregate();
+    cwd->rainTemperature = windows[SAMPLED_RAIN_TEMPERATURE].aggregate();
+    cwd->windSpeed       = windows[SAMPLED_WIND].aggregate();
+    cwd->tempAct         = windows[SAMPLED_TEMPERATURE].aggregate();
+    cwd->humidity        = windows[SAMPLED_HUMIDITY].aggregate();
+    cwd->pressure        = windows[SAMPLED_PRESSURE].aggregate();
 
 
     if (m_FirmwareVersion >= 5.8)
@@ -215,46 +492,22 @@ bool CloudWatcherController::getAllData(CloudWatcherData *cwd)
         cwd->relpress = 0;
     }
 
-    check = getIRErrors(&cwd->firstByteErrors, &cwd->commandByteErrors, &cwd->secondByteErrors, &cwd->pecByteErrors);
-
-    if (!check)
-    {
-        LOG_DEBUG( "ERROR in getIRErrors" );
-        return false;
-    }
-
-    cwd->internalErrors = cwd->firstByteErrors + cwd->commandByteErrors + cwd->secondByteErrors + cwd->pecByteErrors;
-
-    check = getPWMDutyCycle(cwd->rainHeater);
-
-    if (!check)
-    {
-        LOG_DEBUG( "ERROR in getPWMDutyCycle" );
-        return false;
-    }
-
-    check = getSwitchStatus(&cwd->switchStatus);
-
-    if (!check)
-    {
-        LOG_DEBUG( "ERROR in getSwitchStatus" );
-        return false;
-    }
-
-    timeval end;
-    gettimeofday(&end, nullptr);
-
-    float rc = float(end.tv_sec - begin.tv_sec) + float(end.tv_usec - begin.tv_usec) / 1000000.0;
-
-    cwd->readCycle = rc;
-
-    cwd->totalReadings   = totalReadings;
+    cwd->firstByteErrors   = status.firstByteErrors;
+    cwd->commandByteErrors = status.commandByteErrors;
+    cwd->secondByteErrors  = status.secondByteErrors;
+    cwd->pecByteErrors     = status.pecByteErrors;
+    cwd->internalErrors    = cwd->firstByteErrors + cwd->commandByteErrors + cwd->secondByteErrors + cwd->pecByteErrors;
+    cwd->rainHeater        = status.rainHeater;
+    cwd->switchStatus      = status.switchStatus;
 
-    return true;
+    cwd->readCycle     = samplerStatistics.lastCycle;
+    cwd->totalReadings = totalReadings;
 }
 
 bool CloudWatcherController::getConstants(CloudWatcherConstants *cwc)
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     bool r = getFirmwareVersion(m_FirmwareVersion);
 
     if (!r)
@@ -322,6 +575,8 @@ bool CloudWatcherController::getConstants(CloudWatcherConstants *cwc)
 /******************************************************/
 bool CloudWatcherController::checkCloudWatcher() // CW Internal Name Cmd: A! (public)
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     sendCloudwatcherCommand("A!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
@@ -385,9 +640,10 @@ bool CloudWatcherController::getFirmwareVersion(double &version) // CW Firmware
 // N.B. Documents Rs232_Comms_v110.pdf and Rs232_Comms_v140.pdf update the information in Rs232_Comms_v100.pdf (code below reflects latest updates)
 bool CloudWatcherController::getValues(int *internalSupplyVoltage, float *tempEstimate, int *ldrValue,
                                        int *lightFreq,
-                                       int *rainSensorTemperature) // CW Get Values Cmd: C! (private)
+                                       int *rainSensorTemperature, bool send) // CW Get Values Cmd: C! (private)
 {
-    sendCloudwatcherCommand("C!");
+    if (send)
+        sendCloudwatcherCommand("C!");
 
     static const int MAX_GV_BLOCKS = 6; // as of firmware 5.89, answer can be up to 90 characters (6 blocks)
 
@@ -614,9 +870,10 @@ retry:
 }
 
 bool CloudWatcherController::getIRErrors(int *firstAddressByteErrors, int *commandByteErrors,
-        int *secondAddressByteErrors, int *pecByteErrors) // CW Cmd: D! (private)
+        int *secondAddressByteErrors, int *pecByteErrors, bool send) // CW Cmd: D! (private)
 {
-    sendCloudwatcherCommand("D!");
+    if (send)
+        sendCloudwatcherCommand("D!");
 
     char inputBuffer[BLOCK_SIZE * 5] = {0};
 
@@ -638,9 +895,10 @@ bool CloudWatcherController::getIRErrors(int *firstAddressByteErrors, int *comma
     return true;
 }
 
-bool CloudWatcherController::getRainFrequency(int &rainFreq) // CW Get Rain Frequency Cmd: E! (private)
+bool CloudWatcherController::getRainFrequency(int &rainFreq, bool send) // CW Get Rain Frequency Cmd: E! (private)
 {
-    sendCloudwatcherCommand("E!");
+    if (send)
+        sendCloudwatcherCommand("E!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
 
@@ -650,9 +908,12 @@ bool CloudWatcherController::getRainFrequency(int &rainFreq) // CW Get Rain Freq
     return matchBlock(inputBuffer, "!R", rainFreq); // range is 0 to 6,000
 }
 
-bool CloudWatcherController::getSwitchStatus(int *switchStatus) // CW Get Switch Status Cmd: F! (public)
+bool CloudWatcherController::getSwitchStatus(int *switchStatus, bool send) // CW Get Switch Status Cmd: F! (public)
 {
-    sendCloudwatcherCommand("F!");
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
+    if (send)
+        sendCloudwatcherCommand("F!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
 
@@ -682,6 +943,8 @@ bool CloudWatcherController::getSwitchStatus(int *switchStatus) // CW Get Switch
 
 bool CloudWatcherController::openSwitch() // CW Set Switch Open CMD: G! (public)
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     sendCloudwatcherCommand("G!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
@@ -704,6 +967,8 @@ bool CloudWatcherController::openSwitch() // CW Set Switch Open CMD: G! (public)
 
 bool CloudWatcherController::closeSwitch() // CW Set Switch Closed Cmd: H! (public)
 {
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     sendCloudwatcherCommand("H!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
@@ -754,6 +1019,8 @@ bool CloudWatcherController::setPWMDutyCycle(int pwmDutyCycle) // CW Set PWM Cmd
 
     message[4] = newPWM + '0';
 
+    std::lock_guard<std::recursive_mutex> lock(portMutex);
+
     sendCloudwatcherCommand(message, 6);
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
@@ -781,9 +1048,10 @@ bool CloudWatcherController::setPWMDutyCycle(int pwmDutyCycle) // CW Set PWM Cmd
     return true;
 }
 
-bool CloudWatcherController::getPWMDutyCycle(int &pwmDutyCycle) // CW Get PWM Value Cmd: Q! (private)
+bool CloudWatcherController::getPWMDutyCycle(int &pwmDutyCycle, bool send) // CW Get PWM Value Cmd: Q! (private)
 {
-    sendCloudwatcherCommand("Q!");
+    if (send)
+        sendCloudwatcherCommand("Q!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
 
@@ -794,9 +1062,10 @@ bool CloudWatcherController::getPWMDutyCycle(int &pwmDutyCycle) // CW Get PWM Va
 }
 
 bool CloudWatcherController::getIRSkyTemperature(int
-        &temp) // CW Get IR Sky Temp Cmd: S! (private); response in hundredths of a degree Celsius
+        &temp, bool send) // CW Get IR Sky Temp Cmd: S! (private); response in hundredths of a degree Celsius
 {
-    sendCloudwatcherCommand("S!");
+    if (send)
+        sendCloudwatcherCommand("S!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
 
@@ -807,9 +1076,10 @@ bool CloudWatcherController::getIRSkyTemperature(int
 }
 
 bool CloudWatcherController::getIRSensorTemperature(int
-        &temp) // CW Get IR Sensor Temp Cmd: T! (private); response in hundredths of a degree Celsius
+        &temp, bool send) // CW Get IR Sensor Temp Cmd: T! (private); response in hundredths of a degree Celsius
 {
-    sendCloudwatcherCommand("T!");
+    if (send)
+        sendCloudwatcherCommand("T!");
 
     char inputBuffer[BLOCK_SIZE * 2] = {0};
 
@@ -916,12 +1186,13 @@ bool CloudWatcherController::getAnemometerStatus(int &anemometerStatus) // CW Ch
     return true;
 }
 
-bool CloudWatcherController::getWindSpeed(float &windSpeed) // CW Get Wind Speed Cmd: V! (private)
+bool CloudWatcherController::getWindSpeed(float &windSpeed, bool send) // CW Get Wind Speed Cmd: V! (private)
 {
 
     if (m_FirmwareVersion >= 5 && m_AnemometerStatus)
     {
-        sendCloudwatcherCommand("V!");
+        if (send)
+            sendCloudwatcherCommand("V!");
 
         char inputBuffer[BLOCK_SIZE * 2] = {0};
 
@@ -967,11 +1238,12 @@ bool CloudWatcherController::getWindSpeed(float &windSpeed) // CW Get Wind Speed
 /******************************************************/
 /* CW Cmd funtions from Rs232_Comms_v130.pdf Document */
 /******************************************************/
-bool CloudWatcherController::getHumidity(float &humidity) // CW Get Relative Humidity Cmd: h! (private)
+bool CloudWatcherController::getHumidity(float &humidity, bool send) // CW Get Relative Humidity Cmd: h! (private)
 {
     if (m_FirmwareVersion >= 5.6)
     {
-        sendCloudwatcherCommand("h!");
+        if (send)
+            sendCloudwatcherCommand("h!");
 
         char inputBuffer[BLOCK_SIZE * 2] = {0};
         int h = 0;
@@ -1027,11 +1299,12 @@ bool CloudWatcherController::getHumidity(float &humidity) // CW Get Relative Hum
     return false;
 }
 
-bool CloudWatcherController::getTemperature(float &temperature) // CW Get Ambient Temperature Cmd: t! (private)
+bool CloudWatcherController::getTemperature(float &temperature, bool send) // CW Get Ambient Temperature Cmd: t! (private)
 {
     if (m_FirmwareVersion >= 5.6)
     {
-        sendCloudwatcherCommand("t!");
+        if (send)
+            sendCloudwatcherCommand("t!");
 
         char inputBuffer[BLOCK_SIZE * 2] = {0};
         int t = 0;
@@ -1096,11 +1369,12 @@ bool CloudWatcherController::getTemperature(float &temperature) // CW Get Ambien
     return false;
 }
 
-bool CloudWatcherController::getPressure(float &pressure) // CW Get Atmospheric Pressure Cmd: p! (private)
+bool CloudWatcherController::getPressure(float &pressure, bool send) // CW Get Atmospheric Pressure Cmd: p! (private)
 {
     if (m_FirmwareVersion >= 5.8)
     {
-        sendCloudwatcherCommand("p!");
+        if (send)
+            sendCloudwatcherCommand("p!");
 
         char inputBuffer[BLOCK_SIZE * 2] = {0};
         int p = 0;
@@ -1151,62 +1425,97 @@ bool CloudWatcherController::getPressure(float &pressure) // CW Get Atmospheric
 /******************************************************************/
 /* PRIVATE MEMBERS                                                */
 /******************************************************************/
-float CloudWatcherController::aggregateFloats(float values[], int numberOfValues)
+void SensorWindow::configure(int newSize, AGGREGATION_POLICY newPolicy)
 {
-    float average = 0.0;
+    newSize = std::max(1, std::min(static_cast<int>(MAX_SIZE), newSize));
 
-    for (int i = 0; i < numberOfValues; i++)
-    {
-        //    printMessage("%f\n", values[i]);
+    // Keep the newest readings
+    std::array<float, MAX_SIZE> newest {};
+    int kept = std::min(count, newSize);
 
-        average += values[i];
-    }
+    for (int i = 0; i < kept; i++)
+        newest[i] = values[(head - kept + i + size) % size];
 
-    average /= numberOfValues;
+    values = newest;
+    size   = newSize;
+    head   = kept % newSize;
+    count  = kept;
+    policy = newPolicy;
+}
 
-    float stdD = 0.0;
+void SensorWindow::push(float value)
+{
+    values[head] = value;
+    head = (head + 1) % size;
 
-    for (int i = 0; i < numberOfValues; i++)
-    {
-        stdD += (values[i] - average) * (values[i] - average);
-    }
+    if (count < size)
+        count++;
+}
+
+void SensorWindow::clear()
+{
+    head  = 0;
+    count = 0;
+}
 
-    stdD /= numberOfValues;
+float SensorWindow::aggregate() const
+{
+    // The readings always occupy the first count slots
+    if (count == 0)
+        return 0;
 
-    stdD = sqrt(stdD);
+    float average = 0.0;
 
-    //  printMessage("Average: %f, stdD: %f\n", average, stdD);
+    for (int i = 0; i < count; i++)
+        average += values[i];
 
-    float newAverage  = 0.0;
-    int numberOfItems = 0;
+    average /= count;
 
-    for (int i = 0; i < numberOfValues; i++)
+    switch (policy)
     {
-        if (fabs(values[i] - average) <= stdD)
+        case AGGREGATE_MEAN:
+            return average;
+
+        case AGGREGATE_MEDIAN:
         {
-            //      printMessage("%f\n", fabs(values[i] - average));
-            newAverage += values[i];
-            numberOfItems++;
+            std::array<float, MAX_SIZE> sorted = values;
+            int middle = count / 2;
+
+            std::nth_element(sorted.begin(), sorted.begin() + middle, sorted.begin() + count);
+            float median = sorted[middle];
+
+            if (count % 2 == 0)
+                median = (median + *std::max_element(sorted.begin(), sorted.begin() + middle)) / 2;
+
+            return median;
         }
-    }
 
-    newAverage /= numberOfItems;
+        case AGGREGATE_SIGMA_CLIPPED:
+        default:
+        {
+            // Average only the values within [average - deviation, average + deviation]
+            float stdD = 0.0;
 
-    printMessage("New average: %f\n", newAverage);
+            for (int i = 0; i < count; i++)
+                stdD += (values[i] - average) * (values[i] - average);
 
-    return newAverage;
-}
+            stdD = sqrt(stdD / count);
 
-int CloudWatcherController::aggregateInts(int values[], int numberOfValues)
-{
-    std::vector<float> newValues(numberOfValues);
+            float newAverage  = 0.0;
+            int numberOfItems = 0;
 
-    for (int i = 0; i < numberOfValues; i++)
-    {
-        newValues[i] = (float)values[i];
-    }
+            for (int i = 0; i < count; i++)
+            {
+                if (fabs(values[i] - average) <= stdD)
+                {
+                    newAverage += values[i];
+                    numberOfItems++;
+                }
+            }
 
-    return (int)aggregateFloats(newValues.data(), numberOfValues);
+            return numberOfItems > 0 ? newAverage / numberOfItems : average;
+        }
+    }
 }
 
 void CloudWatcherController::trimString(char *str)
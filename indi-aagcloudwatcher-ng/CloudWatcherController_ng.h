@@ -24,7 +24,13 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
 /**
  *  A struct to group and send all AAG Cloud Watcher constants
@@ -67,6 +73,100 @@ enum DEVICE_TYPE
     REPLICA
 };
 
+/**
+ *  How the readings kept in a sensor window are reduced to a single value
+ */
+
+enum AGGREGATION_POLICY
+{
+    AGGREGATE_MEAN,          ///< Plain average of the window
+    AGGREGATE_MEDIAN,        ///< Median of the window, robust against spikes
+    AGGREGATE_SIGMA_CLIPPED  ///< Average of the values within one standard deviation (AAG documented procedure)
+};
+
+/**
+ *  Raw sensor channels sampled on every read cycle, each one has its own window
+ */
+
+enum SAMPLED_CHANNEL
+{
+    SAMPLED_SKY,
+    SAMPLED_SENSOR,
+    SAMPLED_RAIN,
+    SAMPLED_SUPPLY,
+    SAMPLED_TEMP_EST,
+    SAMPLED_LDR,
+    SAMPLED_LIGHT_FREQ,
+    SAMPLED_RAIN_TEMPERATURE,
+    SAMPLED_WIND,
+    SAMPLED_TEMPERATURE,
+    SAMPLED_HUMIDITY,
+    SAMPLED_PRESSURE,
+    SAMPLED_SENSOR_COUNT
+};
+
+/**
+ * A rolling window of the latest readings of one sensor channel
+ */
+
+class SensorWindow
+{
+public:
+    /**
+     * Maximum number of readings a window can hold
+     */
+    static const int MAX_SIZE = 64;
+
+    /**
+     * Sets the window length and the aggregation policy. The newest readings are kept.
+     * @param size number of readings to aggregate (1 to MAX_SIZE)
+     * @param policy how the readings are aggregated
+     */
+    void configure(int size, AGGREGATION_POLICY policy);
+
+    void push(float value);
+    void clear();
+
+    int getSize() const
+    {
+        return size;
+    }
+    int getCount() const
+    {
+        return count;
+    }
+    AGGREGATION_POLICY getPolicy() const
+    {
+        return policy;
+    }
+
+    /**
+     * @return the aggregated value of the readings in the window, 0 if empty
+     */
+    float aggregate() const;
+
+private:
+    std::array<float, MAX_SIZE> values {};
+    int size = 5;
+    int head = 0;
+    int count = 0;
+    AGGREGATION_POLICY policy = AGGREGATE_SIGMA_CLIPPED;
+};
+
+/**
+ *  Timing of the background sampler read cycles
+ */
+
+struct CloudWatcherSamplerStatistics
+{
+    int cycles;            ///< Successful read cycles since sampling started
+    int failedCycles;      ///< Read cycles aborted by a communication error
+    float lastCycle;       ///< Duration of the last read cycle (s)
+    float meanCycle;       ///< Mean duration of the read cycles (s)
+    float maxCycle;        ///< Longest read cycle (s)
+    int pipelineDepth;     ///< Number of commands currently kept in flight
+};
+
 /**
  *  A struct  to group and send all AAG Cloud Watcher gathered data (RAW data,
  *  directly from the device)
@@ -126,7 +226,7 @@ public:
     /**
      * A destructor
      */
-    virtual ~CloudWatcherController() = default;
+    virtual ~CloudWatcherController();
 
     const char *getDeviceName();
 
@@ -159,20 +259,63 @@ public:
      * Obtains the status of the internal Switch of the AAG CLoud Watcher.
      * @param switchStatus where the switch status will be stored. 1 if open,
      * 0 if closed.
+     * @param send false if the command was already sent (pipelined)
      * @return true if the status of the switch has been correctly determined.
      * false otherwise.
      */
-    bool getSwitchStatus(int *switchStatus);
+    bool getSwitchStatus(int *switchStatus, bool send = true);
 
     /**
-     * Gets all raw dynamic data from the AAG Cloud Watcher. It follows the
-     * procedure described in the AAG Documents (5 readings for some values). This
-     * function takes more than 2 seconds and less than 3 to complete.
+     * Gets all raw dynamic data from the AAG Cloud Watcher. While the background
+     * sampler is running, the current aggregate of the sensor windows is returned
+     * immediately. Otherwise it follows the procedure described in the AAG Documents
+     * (5 readings for some values), which takes more than 2 seconds and less than 3.
      * @param cwd where the dynamic data of the AAG Cloud Watcher will be stored.
      * @return true if the data has been correctly gathered. false otherwise.
      */
     bool getAllData(CloudWatcherData * cwd);
 
+    /**
+     * Starts reading the sensors continuously from a background thread. Constants
+     * must have been read before, so the firmware capabilities are known.
+     * @return true if the sampler is running.
+     */
+    bool startSampling();
+
+    /**
+     * Stops the background sampler and waits for the current read cycle to finish.
+     */
+    void stopSampling();
+
+    bool isSampling() const
+    {
+        return samplerRunning;
+    }
+
+    /**
+     * Sets the minimum time between the start of two sampler read cycles.
+     * @param period period in milliseconds, 0 to sample as fast as the device answers.
+     */
+    void setSamplingPeriod(int period);
+
+    /**
+     * Sets the window length and aggregation policy of a sensor channel.
+     * @param sensor the sensor channel
+     * @param size number of readings to aggregate
+     * @param policy how the readings are aggregated
+     */
+    void setSensorWindow(SAMPLED_CHANNEL sensor, int size, AGGREGATION_POLICY policy);
+
+    /**
+     * Sets how many commands are sent ahead of the answers being read. The device
+     * executes queued commands in order, so pipelining saves one round trip per command.
+     * Falls back to 1 (no pipelining) if the device drops or garbles pipelined answers.
+     * @param depth number of commands in flight, 1 (the default) disables pipelining
+     */
+    void setPipelineDepth(int depth);
+
+    CloudWatcherSamplerStatistics getSamplerStatistics();
+
     /**
      * Gets all constants from the AAG Cloud Watcher. Some of the constants are
      * retrieved from the device (from firmware version >3.0)
@@ -235,6 +378,80 @@ private:
      */
     enum ANEMOMETER_TYPE anemometerType = BLACK;
 
+    /**
+     * Guards the serial port, shared by the sampler thread and the driver commands
+     */
+    std::recursive_mutex portMutex;
+
+    /**
+     * Guards the sensor windows and the latest status readings
+     */
+    std::mutex dataMutex;
+    std::condition_variable dataCondition;
+
+    std::thread samplerThread;
+    std::mutex samplerMutex;
+    std::condition_variable samplerCondition;
+    std::atomic<bool> samplerRunning {false};
+    std::atomic<int> samplingPeriod {1000};
+    std::atomic<int> pipelineDepth {1};
+
+    std::array<SensorWindow, SAMPLED_SENSOR_COUNT> windows;
+    std::chrono::steady_clock::time_point lastCycleTime;
+    CloudWatcherSamplerStatistics samplerStatistics {};
+    double totalCycleTime = 0;
+
+    /**
+     * Status readings, not aggregated. The latest value is reported
+     */
+    struct StatusReadings
+    {
+        int rainHeater;
+        int switchStatus;
+        int firstByteErrors;
+        int commandByteErrors;
+        int secondByteErrors;
+        int pecByteErrors;
+    } status {};
+
+    /**
+     * Commands issued on every read cycle
+     */
+    enum CYCLE_COMMAND
+    {
+        CYCLE_SKY,
+        CYCLE_SENSOR,
+        CYCLE_RAIN,
+        CYCLE_VALUES,
+        CYCLE_WIND,
+        CYCLE_TEMPERATURE,
+        CYCLE_HUMIDITY,
+        CYCLE_PRESSURE,
+        CYCLE_ERRORS,
+        CYCLE_PWM,
+        CYCLE_SWITCH,
+        CYCLE_COMMAND_COUNT
+    };
+
+    /**
+     * Readings of one read cycle
+     */
+    struct CycleReadings
+    {
+        float values[SAMPLED_SENSOR_COUNT];
+        StatusReadings status;
+    };
+
+    /**
+     * Maximum number of commands sent ahead of their answers
+     */
+    const static int MAX_PIPELINE_DEPTH = CYCLE_COMMAND_COUNT;
+
+    /**
+     * Readings older than this many sampling periods (and at least 10 seconds) are stale
+     */
+    const static int STALE_CYCLES = 10;
+
     /**
      * AAG CloudWatcher send information in 15 bytes blocks
      */
@@ -384,45 +601,58 @@ private:
     bool getSerialNumber(int &serialNumber);
 
     /**
-     * Performs an aggregation of the values stored in a float array. It computes
-     * average and standard deviation of the array and averages only the values
-     * within [average - deviation, average + deviation]
-     * @param values the values to be aggregated
-     * @param numberOfValues the size of values
-     * @return the aggregated value
+     * Sampler thread main loop
+     */
+    void samplerLoop();
+
+    /**
+     * Runs one read cycle, pipelining the commands up to pipelineDepth.
+     * @param readings where the readings will be stored
+     * @param includeStatus also read the error counters, PWM and switch status
+     * @return true if all the answers were correctly read. false otherwise.
+     */
+    bool readCycle(CycleReadings &readings, bool includeStatus);
+
+    /**
+     * Lists the commands of a read cycle supported by the firmware
+     * @return the number of commands stored in commands
+     */
+    int getCycleCommands(CYCLE_COMMAND commands[], bool includeStatus);
+
+    /**
+     * Reads and parses the answer to a command of the read cycle, previously sent.
      */
-    float aggregateFloats(float values[], int numberOfValues);
+    bool readCycleAnswer(CYCLE_COMMAND command, CycleReadings &readings);
 
     /**
-     * Performs an aggregation of the values stored in a int array. It computes
-     * average and standard deviation of the array and averages only the values
-     * within [average - deviation, average + deviation]
-     * @param values the values to be aggregated
-     * @param numberOfValues the size of values
-     * @return the aggregated value
+     * Fills cwd with the aggregate of the sensor windows and the latest status.
+     * Must be called with dataMutex held.
      */
-    int aggregateInts(int values[], int numberOfValues);
+    void fillData(CloudWatcherData *cwd);
 
     /**
      * Reads the current IR Sky Temperature value of the AAG Cloud Watcher
      * @param temp where the sensor value will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getIRSkyTemperature(int &temp);
+    bool getIRSkyTemperature(int &temp, bool send = true);
 
     /**
      * Reads the current IR Sensor Temperature value of the AAG Cloud Watcher
      * @param temp where the sensor value will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getIRSensorTemperature(int &temp);
+    bool getIRSensorTemperature(int &temp, bool send = true);
 
     /**
      * Reads the current Rain Frequency value of the AAG Cloud Watcher
      * @param rainFreq where the sensor value will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getRainFrequency(int &rainFreq);
+    bool getRainFrequency(int &rainFreq, bool send = true);
 
     /**
      * Reads the current Internal Supply Voltage, Ambient Temperature, LDR Value
@@ -432,17 +662,20 @@ private:
      * @param ldrValue where the sensor value will be
      * @param ldrFreqValue where the sensor value in K will be stored, if Firmware >= 5.88
      * @param rainSensorTemperature where the sensor value will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getValues(int *internalSupplyVoltage, float *ambientTemperature, int *ldrValue, int *ldrFreqValue, int *rainSensorTemperature);
+    bool getValues(int *internalSupplyVoltage, float *ambientTemperature, int *ldrValue, int *ldrFreqValue, int *rainSensorTemperature,
+                   bool send = true);
 
 
     /**
      * Reads the current PWM Duty Cycle value of the AAG Cloud Watcher
      * @param pwmDutyCycle where the sensor value will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getPWMDutyCycle(int &pwmDutyCycle);
+    bool getPWMDutyCycle(int &pwmDutyCycle, bool send = true);
 
     /**
      * Reads the current Error values of the AAG Cloud Watcher
@@ -450,10 +683,11 @@ private:
      * @param commandByteErrors where the command byte error count will be stored
      * @param secondAddressByteErrors where the second byte error count will be stored
      * @param pecByteErrors where the PEC byte error count will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
     bool getIRErrors(int *firstAddressByteErrors, int *commandByteErrors, int *secondAddressByteErrors,
-		     int *pecByteErrors);
+		     int *pecByteErrors, bool send = true);
 
     /**
      * Reads the electrical constants from the AAG Cloud Watcher and stores them
@@ -485,30 +719,34 @@ private:
     /**
      * Reads the wind speed from the anemomter
      * @param windSpeed where the wind speed will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getWindSpeed(float &windSpeed);
+    bool getWindSpeed(float &windSpeed, bool send = true);
 
     /**
      * Reads the humidity from external sensor
      * @param humidity where the humidity will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getHumidity(float &humidity);
+    bool getHumidity(float &humidity, bool send = true);
 
     /**
      * Reads the temperature from external sensor.
      * @param temperature where the temperature will be stored
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getTemperature(float &temperature);
+    bool getTemperature(float &temperature, bool send = true);
 
     /**
      * Reads the pressure from external sensor
      * @param pressure where the absolute pressure will be stored. Unit is hPa (a.k.a millibars) * 16
+     * @param send false if the command was already sent (pipelined)
      * @return true if succesfully read. false otherwise.
      */
-    bool getPressure(float &pressure);
+    bool getPressure(float &pressure, bool send = true);
 
     /**
      * Use regex to extract the block value, skipping any space
@@ -0,0 +1,261 @@
+/**
+   This file is part of the AAG Cloud Watcher INDI Driver.
+   A driver for the AAG Cloud Watcher (AAGware - http : //www.aagware.eu/)
+
+   Copyright (C) 2026
+
+   AAG Cloud Watcher INDI Driver is free software : you can redistribute it
+   and / or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   AAG Cloud Watcher INDI Driver is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with AAG Cloud Watcher INDI Driver.  If not, see
+   < http : //www.gnu.org/licenses/>.
+*/
+
+#include "CloudWatcherSimulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+const int BLOCK_SIZE = 15;
+const char *HANDSHAKE_BLOCK = "\x21\x11\x20\x20\x20\x20\x20\x20\x20\x20\x20\x20\x20\x20\x30";
+
+struct ScheduledAnswer
+{
+    std::chrono::steady_clock::time_point due;
+    std::string answer;
+};
+}
+
+CloudWatcherSimulator::CloudWatcherSimulator()
+{
+}
+
+CloudWatcherSimulator::~CloudWatcherSimulator()
+{
+    stop();
+}
+
+bool CloudWatcherSimulator::start()
+{
+    if (running)
+        return true;
+
+    masterFD = posix_openpt(O_RDWR | O_NOCTTY);
+    if (masterFD < 0 || grantpt(masterFD) != 0 || unlockpt(masterFD) != 0)
+    {
+        stop();
+        return false;
+    }
+
+    portName = ptsname(masterFD);
+
+    // Raw line discipline, the device talks binary blocks
+    termios settings;
+    tcgetattr(masterFD, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(masterFD, TCSANOW, &settings);
+
+    running = true;
+    deviceThread = std::thread(&CloudWatcherSimulator::deviceLoop, this);
+
+    return true;
+}
+
+void CloudWatcherSimulator::stop()
+{
+    running = false;
+
+    if (deviceThread.joinable())
+        deviceThread.join();
+
+    if (masterFD >= 0)
+    {
+        close(masterFD);
+        masterFD = -1;
+    }
+}
+
+void CloudWatcherSimulator::setDelays(int newLinkDelay, int newCommandDelay)
+{
+    linkDelay = std::chrono::milliseconds(newLinkDelay);
+    commandDelay = std::chrono::milliseconds(newCommandDelay);
+}
+
+void CloudWatcherSimulator::setConditions(const SimulatedConditions &newConditions)
+{
+    std::lock_guard<std::mutex> lock(conditionsMutex);
+    conditions = newConditions;
+}
+
+void CloudWatcherSimulator::deviceLoop()
+{
+    std::deque<ScheduledAnswer> answers;
+    std::string input;
+    auto busyUntil = std::chrono::steady_clock::now();
+
+    while (running)
+    {
+        auto now = std::chrono::steady_clock::now();
+
+        // Deliver the answers whose time has come, in order
+        while (!answers.empty() && answers.front().due <= now)
+        {
+            const std::string &answer = answers.front().answer;
+            if (write(masterFD, answer.data(), answer.size()) < 0)
+                break;
+            answers.pop_front();
+        }
+
+        int timeout = 50;
+        if (!answers.empty())
+        {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(answers.front().due - now).count();
+            timeout = std::max(0, std::min(timeout, static_cast<int>(wait)));
+        }
+
+        pollfd fd = { masterFD, POLLIN, 0 };
+        if (poll(&fd, 1, timeout) <= 0 || !(fd.revents & POLLIN))
+        {
+            // Nobody has the terminal open yet
+            if (fd.revents & POLLHUP)
+                usleep(10000);
+            continue;
+        }
+
+        char buffer[256];
+        ssize_t n = read(masterFD, buffer, sizeof(buffer));
+        if (n <= 0)
+            continue;
+
+        input.append(buffer, n);
+        auto arrival = std::chrono::steady_clock::now() + linkDelay;
+
+        // Commands end with '!', the device executes them one after the other
+        size_t end;
+        while ((end = input.find('!')) != std::string::npos)
+        {
+            std::string command = input.substr(0, end + 1);
+            input.erase(0, end + 1);
+
+            auto begin = std::max(arrival, busyUntil);
+            busyUntil = begin + commandDelay;
+
+            answers.push_back({busyUntil + linkDelay, execute(command) + HANDSHAKE_BLOCK});
+            commandCount++;
+            maxPendingCommands = std::max(maxPendingCommands.load(), static_cast<int>(answers.size()));
+        }
+    }
+}
+
+std::string CloudWatcherSimulator::block(const std::string &prefix, const std::string &value)
+{
+    std::string result = prefix;
+    result.append(std::max(0, BLOCK_SIZE - static_cast<int>(prefix.size() + value.size())), ' ');
+    result.append(value);
+    return result.substr(0, BLOCK_SIZE);
+}
+
+std::string CloudWatcherSimulator::block(const std::string &prefix, long value)
+{
+    return block(prefix, std::to_string(value));
+}
+
+std::string CloudWatcherSimulator::execute(const std::string &command)
+{
+    SimulatedConditions current;
+    {
+        std::lock_guard<std::mutex> lock(conditionsMutex);
+        current = conditions;
+    }
+
+    std::normal_distribution<float> noise(0, std::max(1e-6f, current.noise));
+
+    if (command == "A!")
+        return block("!N", "CloudWatcher");
+
+    if (command == "B!")
+        return block("!V", "5.89");
+
+    if (command == "K!")
+        return block("!K", 1234);
+
+    if (command == "M!")
+    {
+        // zener 3.00 V, LDR 1024 K and 56.0 K, rain beta 3450, rain 1.0 K at 25º and 1.0 K pull up
+        const char constants[BLOCK_SIZE] = { '!', 'M', 1, 44, 4, 0, 2, 48, 13, 122, 0, 10, 0, 10, ' ' };
+        return std::string(constants, BLOCK_SIZE);
+    }
+
+    if (command == "v!")
+        return block("!v", 1);
+
+    if (command == "C!")
+        return block("!6", 1000) + block("!4", 600) + block("!5", 520) + block("!8", current.lightFrequency);
+
+    if (command == "D!")
+        return block("!E1", 0L) + block("!E2", 0L) + block("!E3", 0L) + block("!E4", 0L);
+
+    if (command == "E!")
+        return block("!R", current.rainFrequency);
+
+    if (command == "F!")
+        return block(switchOpen ? "!X" : "!Y", "");
+
+    if (command == "G!")
+    {
+        switchOpen = true;
+        return block("!X", "");
+    }
+
+    if (command == "H!")
+    {
+        switchOpen = false;
+        return block("!Y", "");
+    }
+
+    if (command.size() == 6 && command[0] == 'P')
+    {
+        pwmDutyCycle = std::atoi(command.c_str() + 1);
+        return block("!Q", pwmDutyCycle);
+    }
+
+    if (command == "Q!")
+        return block("!Q", pwmDutyCycle);
+
+    if (command == "S!")
+        return block("!1", std::lround((current.skyTemperature + noise(generator)) * 100));
+
+    if (command == "T!")
+        return block("!2", std::lround((current.sensorTemperature + noise(generator)) * 100));
+
+    if (command == "V!")
+        return block("!w", current.windSpeed);
+
+    if (command == "t!")
+        return block("!th", std::lround((current.ambientTemperature + 46.85) * 65536 / 175.72));
+
+    if (command == "h!")
+        return block("!hh", std::lround((current.humidity + 6) * 65536 / 125));
+
+    if (command == "p!")
+        return block("!p", std::lround(current.pressure * 16));
+
+    // Unknown commands are only acknowledged
+    return std::string();
+}
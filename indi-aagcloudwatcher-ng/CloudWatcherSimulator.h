@@ -0,0 +1,130 @@
+/**
+   This file is part of the AAG Cloud Watcher INDI Driver.
+   A driver for the AAG Cloud Watcher (AAGware - http : //www.aagware.eu/)
+
+   Copyright (C) 2026
+
+   AAG Cloud Watcher INDI Driver is free software : you can redistribute it
+   and / or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   AAG Cloud Watcher INDI Driver is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with AAG Cloud Watcher INDI Driver.  If not, see
+   < http : //www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+/**
+ *  Simulated sky and weather conditions reported by the simulator
+ */
+
+struct SimulatedConditions
+{
+    float skyTemperature = -15;     ///< IR sky temperature (ºC)
+    float sensorTemperature = 10;   ///< IR sensor temperature (ºC)
+    int rainFrequency = 2800;       ///< Rain sensor frequency, lower when wet
+    float ambientTemperature = 8;   ///< Ambient temperature (ºC)
+    float humidity = 60;            ///< Relative humidity (%)
+    float pressure = 1013;          ///< Absolute pressure (hPa)
+    int windSpeed = 0;              ///< Raw anemometer reading
+    int lightFrequency = 5000;      ///< Light sensor frequency
+    float noise = 0;                ///< Gaussian noise added to the IR temperatures (ºC)
+};
+
+/**
+ * Emulates an AAG Cloud Watcher with firmware 5.89 on a pseudo terminal, so the
+ * controller can be exercised without hardware. Commands are executed one at a
+ * time, in order, after a processing delay. The link delay is applied to both
+ * directions and is what pipelined commands save.
+ */
+
+class CloudWatcherSimulator
+{
+public:
+    CloudWatcherSimulator();
+    ~CloudWatcherSimulator();
+
+    /**
+     * Opens the pseudo terminal and starts answering commands
+     * @return true if the device is ready. false otherwise.
+     */
+    bool start();
+
+    void stop();
+
+    /**
+     * @return the name of the pseudo terminal to connect to, as a serial port
+     */
+    const std::string &getPortName() const
+    {
+        return portName;
+    }
+
+    /**
+     * Sets the simulated delays
+     * @param linkDelay one way transport delay (ms), e.g. the USB serial adapter latency
+     * @param commandDelay time the device takes to execute a command (ms)
+     */
+    void setDelays(int linkDelay, int commandDelay);
+
+    void setConditions(const SimulatedConditions &newConditions);
+
+    /**
+     * @return the number of commands executed
+     */
+    int getCommandCount() const
+    {
+        return commandCount;
+    }
+
+    /**
+     * @return the most commands received and not answered yet at any time, 1 when commands are not pipelined
+     */
+    int getMaxPendingCommands() const
+    {
+        return maxPendingCommands;
+    }
+
+    void resetPendingCommands()
+    {
+        maxPendingCommands = 0;
+    }
+
+private:
+    void deviceLoop();
+    std::string execute(const std::string &command);
+    std::string block(const std::string &prefix, const std::string &value);
+    std::string block(const std::string &prefix, long value);
+
+    int masterFD = -1;
+    std::string portName;
+    std::thread deviceThread;
+    std::atomic<bool> running {false};
+    std::atomic<int> commandCount {0};
+    std::atomic<int> maxPendingCommands {0};
+
+    std::mutex conditionsMutex;
+    SimulatedConditions conditions;
+    std::mt19937 generator {42};
+
+    std::chrono::milliseconds linkDelay {0};
+    std::chrono::milliseconds commandDelay {0};
+
+    int pwmDutyCycle = 0;
+    bool switchOpen = false;
+};
@@ -27,6 +27,7 @@
 
 #include "config.h"
 
+#include <algorithm>
 #include <cstring>
 #include <cmath>
 #include <memory>
@@ -79,6 +80,10 @@ bool AAGCloudWatcher::Handshake()
         LOG_INFO("Connected to AAG Cloud Watcher (Lunatico Astro)");
         sendConstants();
 
+        // Weather updates read the aggregate of the sensor windows filled in the background
+        configureSampler();
+        cwc->startSampling();
+
         if (m_FirmwareVersion >= 5.6)
         {
             // add humidity parameter, if not already present
@@ -140,6 +145,53 @@ bool AAGCloudWatcher::initProperties()
     return true;
 }
 
+bool AAGCloudWatcher::Disconnect()
+{
+    cwc->stopSampling();
+
+    return INDI::Weather::Disconnect();
+}
+
+void AAGCloudWatcher::configureSampler()
+{
+    auto sampling = getNumber("sampling");
+    auto window   = getNumber("samplingWindow");
+    auto policy   = getSwitch("samplingPolicy");
+
+    cwc->setSamplingPeriod(getNumberValueFromVector(sampling, "period"));
+    cwc->setPipelineDepth(getNumberValueFromVector(sampling, "pipelineDepth"));
+
+    static const struct
+    {
+        const char *name;
+        SAMPLED_CHANNEL sensor;
+    } channels[] =
+    {
+        {"sky", SAMPLED_SKY},
+        {"sensor", SAMPLED_SENSOR},
+        {"rain", SAMPLED_RAIN},
+        {"values", SAMPLED_SUPPLY},
+        {"values", SAMPLED_TEMP_EST},
+        {"values", SAMPLED_LDR},
+        {"values", SAMPLED_LIGHT_FREQ},
+        {"values", SAMPLED_RAIN_TEMPERATURE},
+        {"wind", SAMPLED_WIND},
+        {"ambient", SAMPLED_TEMPERATURE},
+        {"ambient", SAMPLED_HUMIDITY},
+        {"ambient", SAMPLED_PRESSURE},
+    };
+
+    // Switches are in the order of the policies
+    int aggregation = std::max(0, policy.findOnSwitchIndex());
+
+    for (const auto &channel : channels)
+    {
+        int size = getNumberValueFromVector(window, channel.name);
+
+        cwc->setSensorWindow(channel.sensor, size, static_cast<AGGREGATION_POLICY>(aggregation));
+    }
+}
+
 IPState AAGCloudWatcher::updateWeather()
 {
     // in case elevation updated as GPS gets a better fix
@@ -263,6 +315,17 @@ bool AAGCloudWatcher::ISNewNumber(const char *dev, const char *name, double valu
                 return true;
             }
 
+            if (nvp.isNameMatch("sampling") || nvp.isNameMatch("samplingWindow"))
+            {
+                nvp.update(values, names, n);
+                nvp.setState(IPS_OK);
+                nvp.apply();
+
+                configureSampler();
+
+                return true;
+            }
+
             if (nvp.isNameMatch("heaterPIDParameters"))
             {
                 nvp.update(values, names, n);
@@ -308,6 +371,17 @@ bool AAGCloudWatcher::ISNewSwitch(const char *dev, const char *name, ISState *st
         if (svp)
         {
 
+            if (svp.isNameMatch("samplingPolicy"))
+            {
+                svp.update(states, names, n);
+                svp.setState(IPS_OK);
+                svp.apply();
+
+                configureSampler();
+
+                return true;
+            }
+
             if (svp.isNameMatch("heatingAlgorithm"))
             {
                 LOGF_INFO("Changing heating algorithm to %s\n", names[0]);
@@ -57,6 +57,7 @@ public:
 
 protected:
     virtual bool Handshake() override;
+    virtual bool Disconnect() override;
     virtual IPState updateWeather() override;
 
 
@@ -67,6 +68,7 @@ private:
 
 
     bool sendConstants();
+    void configureSampler();
     //bool resetConstants();
     bool resetData();
     double getNumberValueFromVector(INumberVectorProperty *nvp, const char *name);
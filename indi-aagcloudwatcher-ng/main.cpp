@@ -27,16 +27,51 @@
 #include "indicom.h"
 #include "indiweather.h"
 #include "CloudWatcherController_ng.h"
+#include "CloudWatcherSimulator.h"
 
+#include <cstring>
 #include <iostream>
+#include <thread>
 
 /**
  * Just a test main function. Used for debugging. Ignore it.
+ *
+ * Usage: aagcloudwatcher_test_ng [port | --simulate] [cycles]
+ * With --simulate, a simulated Cloud Watcher is served on a pseudo terminal.
+ * When a number of cycles is given, the background sampler is timed with and
+ * without pipelined commands.
  */
-int main(int /*argc*/, char ** /*argv*/)
+int main(int argc, char **argv)
 {
+    std::string port = "/dev/ttyUSB0";
+    int cycles = 0;
+
+    CloudWatcherSimulator simulator;
+
+    if (argc > 1 && strcmp(argv[1], "--simulate") == 0)
+    {
+        // Typical USB serial adapter latency and device command time
+        simulator.setDelays(4, 20);
+
+        if (!simulator.start())
+        {
+            std::cout << "Can't start simulator\n";
+            return -1;
+        }
+
+        port = simulator.getPortName();
+        std::cout << "Simulating Cloud Watcher on " << port << "\n";
+    }
+    else if (argc > 1)
+    {
+        port = argv[1];
+    }
+
+    if (argc > 2)
+        cycles = atoi(argv[2]);
+
     int PortFD = 0;
-    int r = tty_connect("/dev/ttyUSB0", 9600, 8, 0, 1, &PortFD);
+    int r = tty_connect(port.c_str(), 9600, 8, 0, 1, &PortFD);
 
     if (r != TTY_OK)
     {
@@ -120,6 +155,34 @@ int main(int /*argc*/, char ** /*argv*/)
         return -8;
     }
 
+    for (int depth = 1; cycles > 0 && depth > 0; depth = (depth == 1) ? 11 : 0)
+    {
+        cwc->setSamplingPeriod(0);
+        cwc->setPipelineDepth(depth);
+        cwc->startSampling();
+
+        CloudWatcherSamplerStatistics statistics = cwc->getSamplerStatistics();
+        int reported = 0;
+
+        while (statistics.cycles < cycles && statistics.failedCycles == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            statistics = cwc->getSamplerStatistics();
+
+            if (statistics.cycles > reported)
+            {
+                reported = statistics.cycles;
+                std::cout << "Pipeline " << depth << " cycle " << reported << ": " << statistics.lastCycle << " s\n";
+            }
+        }
+
+        cwc->stopSampling();
+
+        std::cout << "Pipeline " << statistics.pipelineDepth << ": " << statistics.cycles << " cycles, "
+                  << statistics.failedCycles << " failed, mean " << statistics.meanCycle << " s, max "
+                  << statistics.maxCycle << " s\n";
+    }
+
     delete cwc;
 
     return 0;
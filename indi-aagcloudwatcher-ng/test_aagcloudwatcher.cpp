@@ -0,0 +1,206 @@
+/**
+   This file is part of the AAG Cloud Watcher INDI Driver.
+   A driver for the AAG Cloud Watcher (AAGware - http : //www.aagware.eu/)
+
+   Copyright (C) 2026
+
+   AAG Cloud Watcher INDI Driver is free software : you can redistribute it
+   and / or modify it under the terms of the GNU General Public License as
+   published by the Free Software Foundation, either version 3 of the License,
+   or (at your option) any later version.
+
+   AAG Cloud Watcher INDI Driver is distributed in the hope that it will be
+   useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with AAG Cloud Watcher INDI Driver.  If not, see
+   < http : //www.gnu.org/licenses/>.
+*/
+
+#include <gtest/gtest.h>
+
+#include "indicom.h"
+#include "CloudWatcherController_ng.h"
+#include "CloudWatcherSimulator.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <unistd.h>
+
+TEST(SensorWindow, Policies)
+{
+    SensorWindow window;
+    window.configure(5, AGGREGATE_MEAN);
+
+    for (float value : {10.0f, 11.0f, 12.0f, 13.0f, 100.0f})
+        window.push(value);
+
+    EXPECT_FLOAT_EQ(window.aggregate(), 29.2f);
+
+    window.configure(5, AGGREGATE_MEDIAN);
+    EXPECT_FLOAT_EQ(window.aggregate(), 12.0f);
+
+    // The spike is more than one standard deviation away and ignored
+    window.configure(5, AGGREGATE_SIGMA_CLIPPED);
+    EXPECT_FLOAT_EQ(window.aggregate(), 11.5f);
+
+    window.clear();
+    EXPECT_EQ(window.getCount(), 0);
+    EXPECT_FLOAT_EQ(window.aggregate(), 0.0f);
+}
+
+TEST(SensorWindow, RollsAndResizes)
+{
+    SensorWindow window;
+    window.configure(3, AGGREGATE_MEAN);
+
+    for (int i = 1; i <= 5; i++)
+        window.push(i);
+
+    EXPECT_EQ(window.getCount(), 3);
+    EXPECT_FLOAT_EQ(window.aggregate(), 4.0f);
+
+    // Shrinking keeps the newest readings
+    window.configure(2, AGGREGATE_MEAN);
+    EXPECT_FLOAT_EQ(window.aggregate(), 4.5f);
+
+    window.configure(4, AGGREGATE_MEDIAN);
+    window.push(6);
+    window.push(7);
+    EXPECT_EQ(window.getCount(), 4);
+    EXPECT_FLOAT_EQ(window.aggregate(), 5.5f);
+}
+
+class SimulatedCloudWatcher : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            simulator.setDelays(4, 5);
+            ASSERT_TRUE(simulator.start());
+
+            ASSERT_EQ(tty_connect(simulator.getPortName().c_str(), 9600, 8, 0, 1, &PortFD), TTY_OK);
+            controller.setPortFD(PortFD);
+
+            ASSERT_TRUE(controller.checkCloudWatcher());
+            ASSERT_TRUE(controller.getConstants(&constants));
+        }
+
+        void TearDown() override
+        {
+            controller.stopSampling();
+            tty_disconnect(PortFD);
+            simulator.stop();
+        }
+
+        CloudWatcherSamplerStatistics waitForCycles(int cycles)
+        {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+            CloudWatcherSamplerStatistics statistics = controller.getSamplerStatistics();
+
+            while (statistics.cycles < cycles && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                statistics = controller.getSamplerStatistics();
+            }
+
+            return statistics;
+        }
+
+        CloudWatcherSimulator simulator;
+        CloudWatcherController controller;
+        CloudWatcherConstants constants;
+        int PortFD = -1;
+};
+
+TEST_F(SimulatedCloudWatcher, SamplerMatchesBlockingRead)
+{
+    EXPECT_DOUBLE_EQ(constants.firmwareVersion, 5.89);
+    EXPECT_EQ(constants.anemometerStatus, 1);
+
+    CloudWatcherData blocking;
+    ASSERT_TRUE(controller.getAllData(&blocking));
+
+    EXPECT_EQ(blocking.sky, -1500);
+    EXPECT_EQ(blocking.sensor, 1000);
+    EXPECT_EQ(blocking.rain, 2800);
+    EXPECT_EQ(blocking.lightFreq, 5000);
+    EXPECT_NEAR(blocking.tempAct, 8, 0.01);
+    EXPECT_NEAR(blocking.humidity, 60, 0.01);
+    EXPECT_NEAR(blocking.abspress, 1013, 0.01);
+    EXPECT_EQ(blocking.switchStatus, 0);
+
+    controller.setSamplingPeriod(0);
+    ASSERT_TRUE(controller.startSampling());
+    ASSERT_GE(waitForCycles(5).cycles, 5);
+
+    CloudWatcherData sampled;
+    ASSERT_TRUE(controller.getAllData(&sampled));
+    EXPECT_EQ(sampled.sky, blocking.sky);
+    EXPECT_EQ(sampled.rain, blocking.rain);
+    EXPECT_NEAR(sampled.humidity, blocking.humidity, 0.01);
+    EXPECT_NEAR(sampled.relpress, blocking.relpress, 0.01);
+
+    // Commands from the driver are interleaved with the read cycles
+    ASSERT_TRUE(controller.openSwitch());
+    int cycles = controller.getSamplerStatistics().cycles;
+    waitForCycles(cycles + 2);
+    ASSERT_TRUE(controller.getAllData(&sampled));
+    EXPECT_EQ(sampled.switchStatus, 1);
+    EXPECT_EQ(controller.getSamplerStatistics().failedCycles, 0);
+
+    // The aggregate is served from the sensor windows, without touching the port.
+    // With a long period the sampler is idle once its first cycle is done.
+    controller.stopSampling();
+    controller.setSamplingPeriod(60000);
+    ASSERT_TRUE(controller.startSampling());
+    ASSERT_GE(waitForCycles(1).cycles, 1);
+
+    int commands = simulator.getCommandCount();
+    ASSERT_TRUE(controller.getAllData(&sampled));
+    EXPECT_EQ(simulator.getCommandCount(), commands);
+    EXPECT_EQ(sampled.sky, blocking.sky);
+}
+
+TEST_F(SimulatedCloudWatcher, PipelinedCycleTiming)
+{
+    const int cycles = 10;
+    int depths[2] = {1, 11};
+    int pending[2] = {0, 0};
+
+    controller.setSamplingPeriod(0);
+
+    for (int i = 0; i < 2; i++)
+    {
+        controller.setPipelineDepth(depths[i]);
+        simulator.resetPendingCommands();
+        ASSERT_TRUE(controller.startSampling());
+
+        CloudWatcherSamplerStatistics statistics = waitForCycles(cycles);
+        controller.stopSampling();
+
+        ASSERT_GE(statistics.cycles, cycles);
+        EXPECT_EQ(statistics.failedCycles, 0);
+        EXPECT_EQ(statistics.pipelineDepth, depths[i]);
+
+        pending[i] = simulator.getMaxPendingCommands();
+
+        std::cout << "Pipeline depth " << depths[i] << ": " << statistics.cycles << " cycles, mean "
+                  << statistics.meanCycle * 1000 << " ms, max " << statistics.maxCycle * 1000 << " ms, "
+                  << pending[i] << " commands queued in the device at most" << std::endl;
+    }
+
+    // One command in flight at a time, against the whole cycle queued behind one link round trip
+    EXPECT_EQ(pending[0], 1);
+    EXPECT_GT(pending[1], 1);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,7 +1,18 @@
 #include "AStarBox.h"
 
-CAStarBoxPowerPorts::CAStarBoxPowerPorts()
+CAStarBoxPowerPorts::CAStarBoxPowerPorts() : CAStarBoxPowerPorts(new LinuxI2CBus(I2C_BUS_ID))
 {
+    m_pOwnedBus.reset(m_pBus);
+}
+
+CAStarBoxPowerPorts::CAStarBoxPowerPorts(I2CBus *bus, int nCommandWaitMs)
+    : m_pBus(bus), m_Scheduler(*bus, std::chrono::milliseconds(nCommandWaitMs))
+{
+    m_bFlushQueued = false;
+    m_bVoltageQueued = false;
+    m_nBusError = PLUGIN_OK;
+    m_dVoltage = 0;
+
     m_bLinked = false;
     m_bPortsOpen = false;
 
@@ -25,42 +36,66 @@ CAStarBoxPowerPorts::CAStarBoxPowerPorts()
     m_sLogFile << "[" << getTimeStamp() << "]" << " [CAStarBoxPowerPorts] Constructor Called." << std::endl;
     m_sLogFile.flush();
 #endif
-    pcaCommandTimer.Reset();
 }
 
 CAStarBoxPowerPorts::~CAStarBoxPowerPorts()
 {
-
+    // the queued commands use the port controller and the ADC
+    m_Scheduler.stop();
 }
 
 int CAStarBoxPowerPorts::connect()
 {
-    // Open up ports initiates connection and
-    // sets m_PortController.isPCA9685Present() if can connect.
+    int nErr = PLUGIN_OK;
+
+    // Open up ports initiates connection
     if(!m_bPortsOpen)
     {
-        openAllPorts();
+        nErr = openAllPorts();
+        if(nErr)
+        {
+            m_bLinked = false;
+            return P_ERROR;
+        }
     }
 
-    if (!m_PortController.isPCA9685Present())
+    m_Scheduler.start();
+
+    // The port states are read once, then kept as they are written
+    nErr = m_Scheduler.submit([this](I2CBus &)
     {
+        if (!m_PortController.isPCA9685Present())
+            return int(P_ERROR);
+        // without auto-increment every register is a transaction of its own, slower but fine
+        m_PortController.enableAutoIncrement();
+        return m_PortController.readPorts(NB_PORTS) ? int(P_ERROR) : int(PLUGIN_OK);
+    }).get();
+
+    if (nErr != PLUGIN_OK)
+    {
+        m_Scheduler.stop();
         m_bLinked = false;
         return P_ERROR;
     }
 
     // Set linked state - need this set before getting PWM duty cycles
     m_bLinked = true;
+    m_nBusError = PLUGIN_OK;
 
     // Get PWM duty cycle and store it
     getPortPWM(PWM_1, m_nPwm1DutyCycle);
     getPortPWM(PWM_2, m_nPwm2DutyCycle);
 
+    scheduleVoltageRead();
+
     return PLUGIN_OK;
 }
 
 void CAStarBoxPowerPorts::disconnect()
 {
     m_bLinked = false;
+    // port changes still queued are written before the worker stops
+    m_Scheduler.stop();
 }
 
 
@@ -68,9 +103,12 @@ int CAStarBoxPowerPorts::openAllPorts()
 {
     int nErr = PLUGIN_OK;
 
-    m_PortController.init(1, 0x40);  // bus id is 1 for /dev/i2c-1 ,  device address is 0x40
+    if(m_pBus->open())
+        return PORT_OPEN_ERROR;
 
-    m_mcp3421.setBusID(1); // /dev/i2c-1
+    m_PortController.init(m_pBus, 0x40);  // device address is 0x40
+
+    m_mcp3421.setBus(m_pBus);
     m_mcp3421Present = m_mcp3421.isMCP3421Present();
     if(m_mcp3421Present)
     {
@@ -92,18 +130,43 @@ int CAStarBoxPowerPorts::getPortCount()
     return NB_PORTS;
 }
 
-void CAStarBoxPowerPorts::cmdWait()
+void CAStarBoxPowerPorts::scheduleFlush()
 {
-    int dDelayMs;
+    // One write for all the ports changed until the scheduler gets to it
+    if(m_bFlushQueued.exchange(true))
+        return;
 
-    if(pcaCommandTimer.GetElapsedSeconds() < (INTER_COMMAND_WAIT_MS / 1000))
+    m_Scheduler.submit([this](I2CBus &)
     {
-        dDelayMs = INTER_COMMAND_WAIT_MS - int(pcaCommandTimer.GetElapsedSeconds() * 1000);
-        if(dDelayMs > 0)
-            std::this_thread::sleep_for(std::chrono::milliseconds(dDelayMs));
-    }
-    pcaCommandTimer.Reset();
+        m_bFlushQueued = false;
+        int nErr = m_PortController.flush();
+        m_nBusError = nErr ? P_ERROR : PLUGIN_OK;
+        return nErr;
+    });
+}
 
+void CAStarBoxPowerPorts::scheduleVoltageRead()
+{
+    if(!m_mcp3421Present || m_bVoltageQueued.exchange(true))
+        return;
+
+    m_Scheduler.submit([this](I2CBus &)
+    {
+        double dVolts = 0;
+
+        m_bVoltageQueued = false;
+        int nErr = m_mcp3421.readVoltValue(dVolts);
+        if(!nErr)
+            m_dVoltage = dVolts;
+        return nErr;
+    });
+}
+
+int CAStarBoxPowerPorts::waitForPendingCommands()
+{
+    if(m_Scheduler.isRunning())
+        m_Scheduler.submit([](I2CBus &) { return 0; }).wait();
+    return m_nBusError;
 }
 
 int CAStarBoxPowerPorts::setPort(const int nPortID, const bool bOn)
@@ -113,8 +176,6 @@ int CAStarBoxPowerPorts::setPort(const int nPortID, const bool bOn)
     if(!m_bLinked)
         return nErr;
 
-    cmdWait();
-
 #if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
     m_sLogFile << "[" << getTimeStamp() << "]" << " [setPort] Setting port " << nPortID << " to " <<
                (bOn ? "On" : "Off") << std::endl;
@@ -124,43 +185,23 @@ int CAStarBoxPowerPorts::setPort(const int nPortID, const bool bOn)
     switch(nPortID)
     {
         case POWER_1:
-            if(bOn)
-                nErr = m_PortController.setOn(PORT_1);
-            else
-                nErr = m_PortController.setOff(PORT_1);
+            m_PortController.stagePWM(PORT_1, bOn ? MAX_PCA_VALUE : 0);
             break;
         case POWER_2:
-            if(bOn)
-                nErr = m_PortController.setOn(PORT_2);
-            else
-                nErr = m_PortController.setOff(PORT_2);
+            m_PortController.stagePWM(PORT_2, bOn ? MAX_PCA_VALUE : 0);
             break;
         case POWER_3:
-            if(bOn)
-                nErr = m_PortController.setOn(PORT_3);
-            else
-                nErr = m_PortController.setOff(PORT_3);
+            m_PortController.stagePWM(PORT_3, bOn ? MAX_PCA_VALUE : 0);
             break;
         case POWER_4:
-            if(bOn)
-                nErr = m_PortController.setOn(PORT_4);
-            else
-                nErr = m_PortController.setOff(PORT_4);
+            m_PortController.stagePWM(PORT_4, bOn ? MAX_PCA_VALUE : 0);
             break;
         case PWM_1:
 #if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
             m_sLogFile << "[" << getTimeStamp() << "]" << " [setPort] m_nPwm1DutyCycle " << m_nPwm1DutyCycle  << std::endl;
             m_sLogFile.flush();
 #endif
-            if(bOn)
-            {
-                nErr = m_PortController.setPWM(PORT_PWM1, m_nPwm1DutyCycle);
-            }
-            else
-            {
-                nErr = m_PortController.setPWM(PORT_PWM1, 0);
-
-            }
+            m_PortController.stagePWM(PORT_PWM1, bOn ? m_nPwm1DutyCycle : 0);
             m_bPwm1On = bOn;
             break;
         case PWM_2:
@@ -168,14 +209,7 @@ int CAStarBoxPowerPorts::setPort(const int nPortID, const bool bOn)
             m_sLogFile << "[" << getTimeStamp() << "]" << " [setPort] m_nPwm2DutyCycle " << m_nPwm2DutyCycle  << std::endl;
             m_sLogFile.flush();
 #endif
-            if(bOn)
-            {
-                nErr = m_PortController.setPWM(PORT_PWM2, m_nPwm2DutyCycle);
-            }
-            else
-            {
-                nErr = m_PortController.setPWM(PORT_PWM2, 0);
-            }
+            m_PortController.stagePWM(PORT_PWM2, bOn ? m_nPwm2DutyCycle : 0);
             m_bPwm2On = bOn;
             break;
         default:
@@ -183,8 +217,8 @@ int CAStarBoxPowerPorts::setPort(const int nPortID, const bool bOn)
             return nErr;
             break;
     }
-    if(nErr == -1)
-        nErr = P_ERROR;
+
+    scheduleFlush();
 
     return nErr;
 }
@@ -192,13 +226,10 @@ int CAStarBoxPowerPorts::setPort(const int nPortID, const bool bOn)
 int CAStarBoxPowerPorts::getPortStatus(const int nPortID, bool &bOn)
 {
     int nErr = PLUGIN_OK;
-    int nValue = 0;
 
     if(!m_bLinked)
         return nErr;
 
-    cmdWait();
-
 #if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
     m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortStatus] Getting port " << nPortID << " status" << std::endl;
     m_sLogFile.flush();
@@ -207,34 +238,22 @@ int CAStarBoxPowerPorts::getPortStatus(const int nPortID, bool &bOn)
     switch(nPortID)
     {
         case POWER_1:
-            bOn = m_PortController.isPortOn(PORT_1);
+            bOn = m_PortController.isCachedPortOn(PORT_1);
             break;
         case POWER_2:
-            bOn = m_PortController.isPortOn(PORT_2);
+            bOn = m_PortController.isCachedPortOn(PORT_2);
             break;
         case POWER_3:
-            bOn = m_PortController.isPortOn(PORT_3);
+            bOn = m_PortController.isCachedPortOn(PORT_3);
             break;
         case POWER_4:
-            bOn = m_PortController.isPortOn(PORT_4);
+            bOn = m_PortController.isCachedPortOn(PORT_4);
             break;
         case PWM_1:
-            getPortPWM(PWM_1, nValue);
-            bOn = (nValue != 0);
-#if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
-            m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortStatus] PWM1 nValue " << nValue << std::endl;
-            m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortStatus] PWM1 bOn " << (bOn ? "On" : "Off") << std::endl;
-            m_sLogFile.flush();
-#endif
+            bOn = (m_PortController.getCachedDutyCycle(PORT_PWM1) != 0);
             break;
         case PWM_2:
-            getPortPWM(PWM_2, nValue);
-            bOn = (nValue != 0);
-#if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
-            m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortStatus] PWM2 nValue " << nValue << std::endl;
-            m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortStatus] PWM2 bOn " << (bOn ? "On" : "Off") << std::endl;
-            m_sLogFile.flush();
-#endif
+            bOn = (m_PortController.getCachedDutyCycle(PORT_PWM2) != 0);
             break;
         default:
             nErr = P_INVALID;
@@ -242,13 +261,15 @@ int CAStarBoxPowerPorts::getPortStatus(const int nPortID, bool &bOn)
             break;
     }
 
-    if(nErr == -1)
+    if(m_nBusError != PLUGIN_OK)
     {
+        // the ports that could not be written are still staged, try again
+        scheduleFlush();
         return P_ERROR;
     }
 
 #if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
-    m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortStatus] Port " << nPortID << " status : " << nValue << std::endl;
+    m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortStatus] Port " << nPortID << " status : " << (bOn ? "On" : "Off") << std::endl;
     m_sLogFile.flush();
 #endif
 
@@ -360,8 +381,6 @@ int CAStarBoxPowerPorts::setPortPWM(const int nPortID, const int nDutyCycle)
     if(!m_bLinked)
         return nErr;
 
-    cmdWait();
-
 #if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
     m_sLogFile << "[" << getTimeStamp() << "]" << " [setPortPWM] Port " << nPortID << " to " << nDutyCycle << std::endl;
     m_sLogFile.flush();
@@ -371,13 +390,16 @@ int CAStarBoxPowerPorts::setPortPWM(const int nPortID, const int nDutyCycle)
     {
         case PWM_1:
             m_nPwm1DutyCycle = nDutyCycle;
-            m_PortController.setPWM(PORT_PWM1, m_nPwm1DutyCycle);
+            m_PortController.stagePWM(PORT_PWM1, m_nPwm1DutyCycle);
             break;
         case PWM_2:
             m_nPwm2DutyCycle = nDutyCycle;
-            m_PortController.setPWM(PORT_PWM2, m_nPwm2DutyCycle);
+            m_PortController.stagePWM(PORT_PWM2, m_nPwm2DutyCycle);
             break;
     }
+
+    scheduleFlush();
+
     return nErr;
 }
 
@@ -388,28 +410,10 @@ int CAStarBoxPowerPorts::getPortPWM(const int nPortID, int &nDutyCycle)
     if(!m_bLinked)
         return nErr;
 
-    cmdWait();
-
-#if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
-    m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortPWM] Getting port " << nPortID << std::endl;
-    m_sLogFile.flush();
-#endif
-
     switch(nPortID)
     {
         case PWM_1:
-            m_PortController.getPWM(PORT_PWM1, nDutyCycle);
-#if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
-            m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortPWM] PWM_1 nDutyCycle " << nDutyCycle << std::endl;
-            m_sLogFile.flush();
-#endif
-            if (nDutyCycle == 4096)
-            {
-                nDutyCycle = 0;
-            }
-            else if (nDutyCycle == 0)
-                nDutyCycle = 4096;
-
+            nDutyCycle = m_PortController.getCachedDutyCycle(PORT_PWM1);
             m_nPwm1DutyCycle = nDutyCycle;
 #if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
             m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortPWM] PWM_1 m_nPwm1DutyCycle " << m_nPwm1DutyCycle << std::endl;
@@ -417,18 +421,7 @@ int CAStarBoxPowerPorts::getPortPWM(const int nPortID, int &nDutyCycle)
 #endif
             break;
         case PWM_2:
-            m_PortController.getPWM(PORT_PWM2, nDutyCycle);
-#if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
-            m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortPWM] PWM_2 nDutyCycle " << nDutyCycle << std::endl;
-            m_sLogFile.flush();
-#endif
-            if (nDutyCycle == 4096)
-            {
-                nDutyCycle = 0;
-            }
-            else if (nDutyCycle == 0)
-                nDutyCycle = 4096;
-
+            nDutyCycle = m_PortController.getCachedDutyCycle(PORT_PWM2);
             m_nPwm2DutyCycle = nDutyCycle;
 #if defined PLUGIN_DEBUG && PLUGIN_DEBUG >= 2
             m_sLogFile << "[" << getTimeStamp() << "]" << " [getPortPWM] PWM_2 m_nPwm2DutyCycle " << m_nPwm2DutyCycle << std::endl;
@@ -556,7 +549,7 @@ bool  CAStarBoxPowerPorts::isMCP3421Present()
 
 int CAStarBoxPowerPorts::openMCP3421()
 {
-    return m_mcp3421.openMCP3421();
+    return m_Scheduler.submit([this](I2CBus &) { return m_mcp3421.openMCP3421(); }).get();
 }
 
 int CAStarBoxPowerPorts::closeMCP3421()
@@ -566,9 +559,13 @@ int CAStarBoxPowerPorts::closeMCP3421()
 
 double CAStarBoxPowerPorts::getVoltage()
 {
-    if(m_mcp3421Present)
-        return m_mcp3421.getVoltValue();
-    return 0;
+    if(!m_mcp3421Present)
+        return 0;
+
+    // last value read, the next one is read by the scheduler
+    if(m_bLinked)
+        scheduleVoltageRead();
+    return m_dVoltage;
 }
 
 
@@ -18,10 +18,13 @@
 #include <thread>
 #include <ctime>
 #include <cmath>
+#include <atomic>
+#include <memory>
 
+#include "i2cbus.h"
+#include "i2cscheduler.h"
 #include "mcp3421.h"
 #include "PCA9685.h"
-#include "StopWatch.h"
 
 #define NB_PORTS    6
 #define ON true
@@ -49,11 +52,16 @@ enum methodErrors {OK, PORT_OPEN_ERROR, ERR_PARSE, ERR_FILE};
 #define PLUGIN_VERSION	1.01
 
 #define INTER_COMMAND_WAIT_MS 500	// ms
+#define I2C_BUS_ID 1                // /dev/i2c-1
 
+// Port changes are written by the I2C scheduler, the port states are read from what was
+// last written and only loaded from the PCA9685 when connecting.
 class CAStarBoxPowerPorts
 {
 public:
 	CAStarBoxPowerPorts();
+	// for a bus other than /dev/i2c-1, the bus has to outlive the ports
+	CAStarBoxPowerPorts(I2CBus *bus, int nCommandWaitMs = INTER_COMMAND_WAIT_MS);
 	~CAStarBoxPowerPorts();
 
     
@@ -75,17 +83,28 @@ public:
     virtual int		openMCP3421();
     virtual int		closeMCP3421();
     virtual double	getVoltage();
+
+    // Waits for the commands already queued, returns the last port write error
+    virtual int     waitForPendingCommands();
     
 private:
     int             setPortPWM(const int nPortID, const int nDutyCycle);
     int             getPortPWM(const int nPortID, int &nDutyCycle);
-    void            cmdWait();
+    void            scheduleFlush();
+    void            scheduleVoltageRead();
     int				parseFields(const std::string sResp, std::vector<std::string> &svFields, char cSeparator);
 	std::string&    trim(std::string &str, const std::string &filter );
 	std::string&    ltrim(std::string &str, const std::string &filter);
 	std::string&    rtrim(std::string &str, const std::string &filter);
 
-	CStopWatch pcaCommandTimer;
+    std::unique_ptr<I2CBus> m_pOwnedBus;
+    I2CBus  *m_pBus;
+    I2CScheduler m_Scheduler;
+    std::atomic<bool> m_bFlushQueued;
+    std::atomic<bool> m_bVoltageQueued;
+    std::atomic<int> m_nBusError;
+    std::atomic<double> m_dVoltage;
+
     bool    m_bLinked;
     
 	bool    m_bPortsOpen;
@@ -28,23 +28,27 @@
 
 #include "PCA9685.h"
 
-//! Constructor takes bus and address arguments
+//! Set the bus and the device address
 /*!
- \param bus the bus to use in /dev/i2c-%d.
+ \param bus the I2C bus the device is on.
  \param address the device address on bus
  */
 
-void PCA9685::init(int bus, int address)
+void PCA9685::init(I2CBus *bus, int address)
 {
-    std::stringstream ssTmp;
+    m_pBus = bus;
     m_nI2CAddr = address;
-    ssTmp << "/dev/i2c-" << bus;
-    sBusFile.assign(ssTmp.str());
+    m_bAutoIncrement = false;
 }
 
 PCA9685::PCA9685()
 {
-
+    m_pBus = nullptr;
+    m_nI2CAddr = 0x40;
+    m_bAutoIncrement = false;
+    m_nStagedPorts = 0;
+    for(int i = 0; i < PCA_PORT_COUNT; i++)
+        m_Ports[i] = portRegisters(0);
 }
 
 PCA9685::~PCA9685()
@@ -54,50 +58,27 @@ PCA9685::~PCA9685()
 
 bool PCA9685::isPCA9685Present()
 {
-	int nErr;
-	int fd;
 	uint8_t nValue;
-	bool bPresent;
-
-	bPresent = true;
-
-	fd = openfd();
-	if(fd!=-1) {
-		nErr = read_byte(fd, PORT0_ON_L + PORT_MULTIPLYER , nValue);
-		if(nErr == -1)
-			bPresent = false;
-		close(fd);
-	}
-	else {
-		bPresent = false;
-	}
-	return bPresent;
+
+	return read_byte(PORT0_ON_L + PORT_MULTIPLYER , nValue) == 0;
 }
 
 //! Sets PCA9685 mode to 00
 int PCA9685::reset()
 {
     int nErr = 0;
-    int fd = openfd();
-
-    if (fd != -1) {
-        // Sends a reset command to the PCA9685 chip over I2C
-        nErr = write_byte(fd, MODE1, MODE1_RESTART); //Normal mode
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        if(nErr) {
-            close(fd);
-            return -1;
-        }
-        nErr = write_byte(fd, MODE2, MODE2_OUTDRV); //totem pole
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        if(nErr) {
-            close(fd);
-            return -1;
-        }
-        close(fd);
-        return 0;
-    }
-    return -1;
+
+    // Sends a reset command to the PCA9685 chip over I2C
+    nErr = write_byte(MODE1, MODE1_RESTART); //Normal mode
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if(nErr)
+        return -1;
+    nErr = write_byte(MODE2, MODE2_OUTDRV); //totem pole
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if(nErr)
+        return -1;
+    m_bAutoIncrement = false;
+    return 0;
 }
 //! Set the frequency of PWM
 /*!
@@ -108,26 +89,22 @@ int PCA9685::setPWMFreq(int freq)
     int nErr = 0;
     uint8_t prescale;
 
-    int fd = openfd();
-    if (fd != -1) {
-        prescale = uint8_t(((CLOCK_FREQ / (freq * 4096.0)) + 0.5) - 1);
+    prescale = uint8_t(((CLOCK_FREQ / (freq * 4096.0)) + 0.5) - 1);
 
-        nErr |= write_byte(fd, MODE1, MODE1_SLEEP);        // go to sleep
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    nErr |= write_byte(MODE1, MODE1_SLEEP);        // go to sleep
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
-        nErr |= write_byte(fd, PRE_SCALE, prescale);
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    nErr |= write_byte(PRE_SCALE, prescale);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
-        nErr |= write_byte(fd, MODE1, MODE1_RESTART);
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    nErr |= write_byte(MODE1, MODE1_RESTART);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
-        nErr = write_byte(fd, MODE2, MODE2_OUTDRV); //totem pole
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    nErr = write_byte(MODE2, MODE2_OUTDRV); //totem pole
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
 
-        close(fd);
-        return nErr;
-    }
-    return -1;
+    m_bAutoIncrement = false;
+    return nErr;
 }
 
 
@@ -138,18 +115,9 @@ int PCA9685::setPWMFreq(int freq)
  */
 int  PCA9685::setPWM(uint8_t  nPort, int value)
 {
-    int nErr = 0;
+    PortRegisters port = portRegisters(value);
 
-    if(value <= 1) {
-        nErr = setOff(nPort);
-    }
-    else if (value>=4095) {
-        nErr = setOn(nPort);
-    }
-    else {
-        nErr = setPWM( nPort, 0, value);
-    }
-    return nErr;
+    return setPWM(nPort, port.on_value, port.off_value);
 }
 
 //! Get PWM for a single channel
@@ -193,9 +161,153 @@ bool PCA9685::isPortOn(uint8_t nPort)
     return (on_value==4096);
 }
 
+//! Let the port registers be written and read in one transaction
+int PCA9685::enableAutoIncrement()
+{
+    int nErr = 0;
+    uint8_t nMode = 0;
+
+    nErr = read_byte(MODE1, nMode);
+    if(nErr)
+        return nErr;
+
+    if(!(nMode & MODE1_AI)) {
+        // writing the restart bit back would restart the PWM outputs
+        nErr = write_byte(MODE1, (nMode & ~MODE1_RESTART) | MODE1_AI);
+        if(nErr)
+            return nErr;
+    }
+    m_bAutoIncrement = true;
+    return 0;
+}
+
+//! Load the cached port registers from the device
+/*!
+ \param nPortCount ports to read, starting with port 0
+ */
+int PCA9685::readPorts(uint8_t nPortCount)
+{
+    int nErr = 0;
+    PortRegisters ports[PCA_PORT_COUNT];
+
+    if(nPortCount > PCA_PORT_COUNT)
+        nPortCount = PCA_PORT_COUNT;
+
+    nErr = read_ports(0, ports, nPortCount);
+    if(nErr)
+        return nErr;
+
+    std::lock_guard<std::mutex> lock(m_CacheMutex);
+    for(int i = 0; i < nPortCount; i++) {
+        // a port changed in the meantime keeps its new value
+        if(!(m_nStagedPorts & (1 << i)))
+            m_Ports[i] = ports[i];
+    }
+    return 0;
+}
+
+//! Change a port in the cache, flush() writes it
+/*!
+ \param nPort channel to set PWM value for
+ \param value 0-4096 value for PWM, same as setPWM()
+ */
+void PCA9685::stagePWM(uint8_t nPort, int value)
+{
+    if(nPort >= PCA_PORT_COUNT)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_CacheMutex);
+    m_Ports[nPort] = portRegisters(value);
+    m_nStagedPorts |= (1 << nPort);
+}
+
+//! Write all the staged ports, in a single transaction when auto-increment is enabled
+int PCA9685::flush()
+{
+    int nErr = 0;
+    int nFirst, nLast;
+    uint16_t nStaged;
+    PortRegisters ports[PCA_PORT_COUNT];
+
+    {
+        std::lock_guard<std::mutex> lock(m_CacheMutex);
+        nStaged = m_nStagedPorts;
+        if(!nStaged)
+            return 0;
+
+        nFirst = 0;
+        while(!(nStaged & (1 << nFirst)))
+            nFirst++;
+        nLast = PCA_PORT_COUNT - 1;
+        while(!(nStaged & (1 << nLast)))
+            nLast--;
+
+        // ports in between are rewritten with their current value
+        for(int i = nFirst; i <= nLast; i++)
+            ports[i] = m_Ports[i];
+        m_nStagedPorts = 0;
+    }
+
+    nErr = write_ports(nFirst, ports + nFirst, nLast - nFirst + 1);
+    if(nErr) {
+        // try again with the next flush
+        std::lock_guard<std::mutex> lock(m_CacheMutex);
+        m_nStagedPorts |= nStaged;
+    }
+    return nErr;
+}
+
+bool PCA9685::hasStagedPorts()
+{
+    std::lock_guard<std::mutex> lock(m_CacheMutex);
+    return m_nStagedPorts != 0;
+}
+
+//! Duty cycle of a port from the cache, 0 when off and MAX_PCA_VALUE when fully on
+int PCA9685::getCachedDutyCycle(uint8_t nPort)
+{
+    if(nPort >= PCA_PORT_COUNT)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(m_CacheMutex);
+    if(m_Ports[nPort].on_value & MAX_PCA_VALUE)
+        return MAX_PCA_VALUE;
+    if(m_Ports[nPort].off_value & MAX_PCA_VALUE)
+        return 0;
+    return m_Ports[nPort].off_value;
+}
+
+bool PCA9685::isCachedPortOn(uint8_t nPort)
+{
+    if(nPort >= PCA_PORT_COUNT)
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_CacheMutex);
+    return (m_Ports[nPort].on_value == MAX_PCA_VALUE);
+}
+
 
 // private methods
 
+PCA9685::PortRegisters PCA9685::portRegisters(int value)
+{
+    PortRegisters port;
+
+    if(value <= 1) {
+        port.on_value = 0;
+        port.off_value = MAX_PCA_VALUE;
+    }
+    else if (value>=4095) {
+        port.on_value = MAX_PCA_VALUE;
+        port.off_value = 0;
+    }
+    else {
+        port.on_value = 0;
+        port.off_value = value;
+    }
+    return port;
+}
+
 //! PWM a single channel with custom on time
 /*!
  \param nPort  channel to set PWM value for
@@ -205,17 +317,19 @@ bool PCA9685::isPortOn(uint8_t nPort)
 int PCA9685::setPWM(uint8_t nPort, int on_value, int off_value)
 {
     int nErr = 0;
-    int fd = openfd();
-
-    if (fd != -1) {
-        nErr |= write_byte(fd, PORT0_ON_L + PORT_MULTIPLYER * nPort, on_value & 0xFF);
-        nErr |= write_byte(fd, PORT0_ON_H + PORT_MULTIPLYER * nPort, on_value >> 8);
-        nErr |= write_byte(fd, PORT0_OFF_L + PORT_MULTIPLYER * nPort, off_value & 0xFF);
-        nErr |= write_byte(fd, PORT0_OFF_H + PORT_MULTIPLYER * nPort, off_value >> 8);
-        close(fd);
-        return nErr;
+    PortRegisters port;
+
+    port.on_value = on_value;
+    port.off_value = off_value;
+    nErr = write_ports(nPort, &port, 1);
+    if(nErr)
+        return -1;
+
+    if(nPort < PCA_PORT_COUNT) {
+        std::lock_guard<std::mutex> lock(m_CacheMutex);
+        m_Ports[nPort] = port;
     }
-    return -1;
+    return 0;
 }
 
 
@@ -228,88 +342,120 @@ int PCA9685::setPWM(uint8_t nPort, int on_value, int off_value)
 int PCA9685::getPWM(uint8_t nPort, int &on_value, int &off_value)
 {
     int nErr = 0;
-    uint8_t nValue = 0;
-    int fd = openfd();
+    PortRegisters port;
 
-    if (fd != -1) {
-        nErr = read_byte(fd, PORT0_ON_L + PORT_MULTIPLYER * nPort, nValue);
-        if(nErr == -1)
-            return nErr;
-        on_value = nValue & 0xFF;
-        nErr = read_byte(fd, PORT0_ON_H + PORT_MULTIPLYER * nPort, nValue);
-        if(nErr == -1)
-            return nErr;
-        on_value |= (nValue & 0xFF) << 8;
+    nErr = read_ports(nPort, &port, 1);
+    if(nErr)
+        return -1;
 
-        nErr = read_byte(fd, PORT0_OFF_L + PORT_MULTIPLYER * nPort, nValue);
-        if(nErr == -1)
-            return nErr;
-        off_value = nValue & 0xFF;
-        nErr = read_byte(fd, PORT0_OFF_H + PORT_MULTIPLYER * nPort, nValue);
-        if(nErr == -1)
-            return nErr;
-        off_value |= (nValue & 0xFF) << 8;
-        close(fd);
-        return 0;
-    }
-    return -1;
+    on_value = port.on_value;
+    off_value = port.off_value;
+    return 0;
 }
 
 
 //! Read a single byte from PCA9685
 /*!
- \param fd file descriptor for I/O
  \param address register address to read from
  */
-int PCA9685::read_byte(int fd, uint8_t address, uint8_t &nValue)
+int PCA9685::read_byte(uint8_t address, uint8_t &nValue)
 {
-    uint8_t buff[BUFFER_SIZE];
-
-    memset(buff, 0, BUFFER_SIZE);
-    memset(dataBuffer, 0, BUFFER_SIZE);
-    buff[0] = address;
+    if(!m_pBus)
+        return -1;
 
-    if (write(fd, buff, 1) != 1) {
+    if (m_pBus->write(m_nI2CAddr, &address, 1)) {
+        return (-1);
+    }
+    if (m_pBus->read(m_nI2CAddr, &nValue, 1)) {
         return (-1);
-    } else {
-        if (read(fd, dataBuffer, 1) != 1) {
-            return (-1);
-        }
     }
-    nValue = dataBuffer[0];
     return 0;
 }
 //! Write a single byte from PCA9685
 /*!
- \param fd file descriptor for I/O
  \param address register address to write to
  \param data 8 bit data to write
  */
-int PCA9685::write_byte(int fd, uint8_t address, uint8_t data)
+int PCA9685::write_byte(uint8_t address, uint8_t data)
 {
     uint8_t buff[2];
 
+    if(!m_pBus)
+        return -1;
+
     buff[0] = address;
     buff[1] = data;
-    if (write(fd, buff, sizeof(buff)) != 2) {
+    return m_pBus->write(m_nI2CAddr, buff, sizeof(buff));
+}
+
+//! Write the registers of consecutive ports
+/*!
+ \param nFirstPort first port to write
+ \param ports on and off values of the ports
+ \param nCount number of ports
+ */
+int PCA9685::write_ports(uint8_t nFirstPort, const PortRegisters *ports, int nCount)
+{
+    int nErr = 0;
+    uint8_t nRegister = PORT0_ON_L + PORT_MULTIPLYER * nFirstPort;
+    uint8_t buff[1 + PORT_MULTIPLYER * PCA_PORT_COUNT];
+
+    if(!m_pBus || nFirstPort + nCount > PCA_PORT_COUNT)
         return -1;
-    }else{
+
+    if(!m_bAutoIncrement) {
+        // one transaction per register
+        for(int i = 0; i < nCount; i++) {
+            uint8_t nPortRegister = nRegister + PORT_MULTIPLYER * i;
+            nErr |= write_byte(nPortRegister, ports[i].on_value & 0xFF);
+            nErr |= write_byte(nPortRegister + 1, ports[i].on_value >> 8);
+            nErr |= write_byte(nPortRegister + 2, ports[i].off_value & 0xFF);
+            nErr |= write_byte(nPortRegister + 3, ports[i].off_value >> 8);
+        }
+        return nErr ? -1 : 0;
     }
-    return 0;
+
+    buff[0] = nRegister;
+    for(int i = 0; i < nCount; i++) {
+        buff[1 + PORT_MULTIPLYER * i] = ports[i].on_value & 0xFF;
+        buff[2 + PORT_MULTIPLYER * i] = ports[i].on_value >> 8;
+        buff[3 + PORT_MULTIPLYER * i] = ports[i].off_value & 0xFF;
+        buff[4 + PORT_MULTIPLYER * i] = ports[i].off_value >> 8;
+    }
+    return m_pBus->write(m_nI2CAddr, buff, 1 + PORT_MULTIPLYER * nCount);
 }
-//! Open device file for PCA9685 I2C bus
+
+//! Read the registers of consecutive ports
 /*!
- \return fd returns the file descriptor number or -1 on error
+ \param nFirstPort first port to read
+ \param ports receives the on and off values of the ports
+ \param nCount number of ports
  */
-int PCA9685::openfd() {
-    int fd = -1;
-    if ((fd = open(sBusFile.c_str(), O_RDWR)) < 0) {
+int PCA9685::read_ports(uint8_t nFirstPort, PortRegisters *ports, int nCount)
+{
+    uint8_t nRegister = PORT0_ON_L + PORT_MULTIPLYER * nFirstPort;
+    uint8_t buff[PORT_MULTIPLYER * PCA_PORT_COUNT];
+
+    if(!m_pBus || nFirstPort + nCount > PCA_PORT_COUNT)
         return -1;
+
+    if(m_bAutoIncrement) {
+        if(m_pBus->write(m_nI2CAddr, &nRegister, 1))
+            return -1;
+        if(m_pBus->read(m_nI2CAddr, buff, PORT_MULTIPLYER * nCount))
+            return -1;
     }
-    if (ioctl(fd, I2C_SLAVE, m_nI2CAddr) < 0) {
-        return -1;
+    else {
+        // one transaction per register
+        for(int i = 0; i < PORT_MULTIPLYER * nCount; i++) {
+            if(read_byte(nRegister + i, buff[i]))
+                return -1;
+        }
     }
 
-    return fd;
+    for(int i = 0; i < nCount; i++) {
+        ports[i].on_value = buff[PORT_MULTIPLYER * i] | (buff[PORT_MULTIPLYER * i + 1] << 8);
+        ports[i].off_value = buff[PORT_MULTIPLYER * i + 2] | (buff[PORT_MULTIPLYER * i + 3] << 8);
+    }
+    return 0;
 }
-
@@ -28,18 +28,17 @@
 
 #ifndef _PCA9685_H
 #define _PCA9685_H
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <linux/i2c-dev.h>
-#include <fcntl.h>
 //
 
+#include <cstdint>
+#include <mutex>
 #include <string>
 #include <cstring>
 #include <vector>
-#include <sstream>
 #include <thread>
 
+#include "i2cbus.h"
+
 // Register Definitions
 
 #define MODE1 0x00            //Mode  register  1
@@ -70,13 +69,14 @@
 #define MODE2_OUTDRV 0x04 // totem pole structure vs open-drain
 
 #define MAX_PCA_VALUE  4096
+#define PCA_PORT_COUNT 16
 
 
 class PCA9685 {
 public:
 
     PCA9685();
-    void init(int bus, int address);
+    void init(I2CBus *bus, int address);
     virtual ~PCA9685();
 	bool isPCA9685Present();
     int reset(void);
@@ -89,16 +89,39 @@ public:
     int setOff(uint8_t nPort);
     bool isPortOn(uint8_t nPort);
 
+    // Port registers as last written or read. stagePWM() only updates the copy,
+    // flush() then writes all the changed ports at once.
+    int enableAutoIncrement();
+    int readPorts(uint8_t nPortCount);
+    void stagePWM(uint8_t nPort, int value);
+    int flush();
+    bool hasStagedPorts();
+    int getCachedDutyCycle(uint8_t nPort);
+    bool isCachedPortOn(uint8_t nPort);
+
 private:
 
+    struct PortRegisters
+    {
+        uint16_t on_value;
+        uint16_t off_value;
+    };
+
     int setPWM(uint8_t nPort, int on_value, int off_value);
     int getPWM(uint8_t nPort, int &on_value, int &off_value);
+    static PortRegisters portRegisters(int value);
 
+    I2CBus *m_pBus;
     int m_nI2CAddr;
-    std::string sBusFile;
-    uint8_t dataBuffer[BUFFER_SIZE];
-    int read_byte(int fd, uint8_t address, uint8_t &nValue);
-    int write_byte(int fd, uint8_t address, uint8_t data);
-    int openfd();
+    bool m_bAutoIncrement;
+
+    std::mutex m_CacheMutex;
+    PortRegisters m_Ports[PCA_PORT_COUNT];
+    uint16_t m_nStagedPorts;
+
+    int read_byte(uint8_t address, uint8_t &nValue);
+    int write_byte(uint8_t address, uint8_t data);
+    int write_ports(uint8_t nFirstPort, const PortRegisters *ports, int nCount);
+    int read_ports(uint8_t nFirstPort, PortRegisters *ports, int nCount);
 };
 #endif
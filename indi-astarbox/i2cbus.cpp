@@ -0,0 +1,93 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : i2cbus.cpp
+ * I2C bus shared by the PCA9685 port controller and the MCP3421 ADC
+ */
+
+#include "i2cbus.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+
+LinuxI2CBus::LinuxI2CBus(int nBus)
+{
+    m_sBusFile = "/dev/i2c-" + std::to_string(nBus);
+    m_fd = -1;
+    m_nSelectedAddress = -1;
+}
+
+LinuxI2CBus::~LinuxI2CBus()
+{
+    close();
+}
+
+int LinuxI2CBus::open()
+{
+    if(m_fd >= 0)
+        return 0;
+
+    m_fd = ::open(m_sBusFile.c_str(), O_RDWR);
+    m_nSelectedAddress = -1;
+    return (m_fd < 0) ? -1 : 0;
+}
+
+void LinuxI2CBus::close()
+{
+    if(m_fd >= 0)
+        ::close(m_fd);
+    m_fd = -1;
+    m_nSelectedAddress = -1;
+}
+
+int LinuxI2CBus::selectDevice(uint8_t nAddress)
+{
+    if(m_fd < 0)
+        return -1;
+
+    // The slave address sticks to the file descriptor, only change it when the device changes
+    if(m_nSelectedAddress != nAddress)
+    {
+        if(ioctl(m_fd, I2C_SLAVE, nAddress) < 0)
+        {
+            m_nSelectedAddress = -1;
+            return -1;
+        }
+        m_nSelectedAddress = nAddress;
+    }
+    return 0;
+}
+
+int LinuxI2CBus::write(uint8_t nAddress, const uint8_t *data, size_t nSize)
+{
+    if(selectDevice(nAddress))
+        return -1;
+
+    if(::write(m_fd, data, nSize) != static_cast<ssize_t>(nSize))
+        return -1;
+    return 0;
+}
+
+int LinuxI2CBus::read(uint8_t nAddress, uint8_t *data, size_t nSize)
+{
+    if(selectDevice(nAddress))
+        return -1;
+
+    if(::read(m_fd, data, nSize) != static_cast<ssize_t>(nSize))
+        return -1;
+    return 0;
+}
@@ -0,0 +1,60 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : i2cbus.h
+ * I2C bus shared by the PCA9685 port controller and the MCP3421 ADC
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// One I2C transaction per call, all methods return 0 or -1
+class I2CBus
+{
+public:
+    virtual ~I2CBus() = default;
+
+    virtual int open() = 0;
+    virtual void close() = 0;
+
+    // Write transaction, for register based devices data[0] is the register address
+    virtual int write(uint8_t nAddress, const uint8_t *data, size_t nSize) = 0;
+    // Read transaction, from the register selected by the last write
+    virtual int read(uint8_t nAddress, uint8_t *data, size_t nSize) = 0;
+};
+
+// /dev/i2c-N, opened once for all the devices on the bus
+class LinuxI2CBus : public I2CBus
+{
+public:
+    explicit LinuxI2CBus(int nBus);
+    ~LinuxI2CBus() override;
+
+    int open() override;
+    void close() override;
+
+    int write(uint8_t nAddress, const uint8_t *data, size_t nSize) override;
+    int read(uint8_t nAddress, uint8_t *data, size_t nSize) override;
+
+private:
+    int selectDevice(uint8_t nAddress);
+
+    std::string m_sBusFile;
+    int m_fd;
+    int m_nSelectedAddress;
+};
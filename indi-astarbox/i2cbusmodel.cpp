@@ -0,0 +1,196 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : i2cbusmodel.cpp
+ * In memory PCA9685 and MCP3421, to run the ports without an AStarBox
+ */
+
+#include "i2cbusmodel.h"
+
+#include <cstring>
+#include <thread>
+
+#include "PCA9685.h"
+#include "mcp3421.h"
+
+#define PCA9685_ADDRESS 0x40
+#define MCP3421_VOLTS_PER_DIV (0.000015625 * 7)
+
+I2CBusModel::I2CBusModel()
+{
+    m_bOpen = false;
+    m_bFailing = false;
+    m_bHeld = false;
+    m_ByteTime = std::chrono::microseconds(0);
+    m_nTransactions = 0;
+    m_nBytes = 0;
+
+    // Power on state: all ports off, sleeping, no auto-increment
+    memset(m_Registers, 0, sizeof(m_Registers));
+    m_Registers[MODE1] = MODE1_SLEEP | 0x01;
+    m_Registers[MODE2] = MODE2_OUTDRV;
+    for(int i = 0; i < PCA_PORT_COUNT; i++)
+        m_Registers[PORT0_OFF_H + PORT_MULTIPLYER * i] = MAX_PCA_VALUE >> 8;
+    m_nPointer = 0;
+
+    m_nADCConfig = MCP3421_RDY;
+    m_dVolts = 12.0;
+}
+
+int I2CBusModel::open()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_bOpen = true;
+    return 0;
+}
+
+void I2CBusModel::close()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_bOpen = false;
+}
+
+void I2CBusModel::transfer(std::unique_lock<std::mutex> &lock, size_t nSize)
+{
+    m_Released.wait(lock, [this] { return !m_bHeld; });
+
+    // address byte and data
+    m_nTransactions++;
+    m_nBytes += nSize + 1;
+    if(m_ByteTime.count() > 0)
+        std::this_thread::sleep_for(m_ByteTime * (nSize + 1));
+}
+
+int I2CBusModel::write(uint8_t nAddress, const uint8_t *data, size_t nSize)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if(!m_bOpen || m_bFailing || nSize == 0)
+        return -1;
+
+    transfer(lock, nSize);
+
+    if(nAddress == PCA9685_ADDRESS)
+    {
+        m_nPointer = data[0];
+        for(size_t i = 1; i < nSize; i++)
+        {
+            m_Registers[m_nPointer] = data[i];
+            if(m_Registers[MODE1] & MODE1_AI)
+                m_nPointer++;
+        }
+        return 0;
+    }
+
+    if(nAddress == ADC_ADDR0)
+    {
+        m_nADCConfig = data[0];
+        return 0;
+    }
+
+    // nobody acknowledged the address
+    return -1;
+}
+
+int I2CBusModel::read(uint8_t nAddress, uint8_t *data, size_t nSize)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if(!m_bOpen || m_bFailing)
+        return -1;
+
+    transfer(lock, nSize);
+
+    if(nAddress == PCA9685_ADDRESS)
+    {
+        for(size_t i = 0; i < nSize; i++)
+        {
+            data[i] = m_Registers[m_nPointer];
+            if(m_Registers[MODE1] & MODE1_AI)
+                m_nPointer++;
+        }
+        return 0;
+    }
+
+    if(nAddress == ADC_ADDR0)
+    {
+        // 18 bit result then the configuration, with a new result every time
+        int nValue = int(m_dVolts / MCP3421_VOLTS_PER_DIV) & 0x3FFFF;
+        uint8_t result[4] = { uint8_t(nValue >> 16), uint8_t(nValue >> 8), uint8_t(nValue), uint8_t(m_nADCConfig & ~MCP3421_RDY) };
+        memcpy(data, result, nSize < sizeof(result) ? nSize : sizeof(result));
+        return 0;
+    }
+
+    return -1;
+}
+
+void I2CBusModel::setByteTime(std::chrono::microseconds byteTime)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_ByteTime = byteTime;
+}
+
+void I2CBusModel::setFailing(bool bFailing)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_bFailing = bFailing;
+}
+
+void I2CBusModel::setHeld(bool bHeld)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_bHeld = bHeld;
+    }
+    m_Released.notify_all();
+}
+
+void I2CBusModel::setVoltage(double dVolts)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_dVolts = dVolts;
+}
+
+uint8_t I2CBusModel::getRegister(uint8_t nRegister)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Registers[nRegister];
+}
+
+int I2CBusModel::getPortValue(uint8_t nPort, bool bOff)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    uint8_t nRegister = PORT0_ON_L + PORT_MULTIPLYER * nPort + (bOff ? 2 : 0);
+    return m_Registers[nRegister] | (m_Registers[nRegister + 1] << 8);
+}
+
+uint64_t I2CBusModel::getTransactionCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_nTransactions;
+}
+
+uint64_t I2CBusModel::getByteCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_nBytes;
+}
+
+void I2CBusModel::resetCounters()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_nTransactions = 0;
+    m_nBytes = 0;
+}
@@ -0,0 +1,73 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : i2cbusmodel.h
+ * In memory PCA9685 and MCP3421, to run the ports without an AStarBox
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "i2cbus.h"
+
+class I2CBusModel : public I2CBus
+{
+public:
+    I2CBusModel();
+
+    int open() override;
+    void close() override;
+
+    int write(uint8_t nAddress, const uint8_t *data, size_t nSize) override;
+    int read(uint8_t nAddress, uint8_t *data, size_t nSize) override;
+
+    // Time to move one byte on the bus, 100 kHz is about 90 us with start, ack and stop bits
+    void setByteTime(std::chrono::microseconds byteTime);
+    // Transactions fail while set, as if the device stopped answering
+    void setFailing(bool bFailing);
+    // Transactions wait while set, as if another master held the bus
+    void setHeld(bool bHeld);
+    // Input voltage seen by the ADC, after the resistor divider
+    void setVoltage(double dVolts);
+
+    uint8_t getRegister(uint8_t nRegister);
+    int getPortValue(uint8_t nPort, bool bOff);
+    uint64_t getTransactionCount();
+    uint64_t getByteCount();
+    void resetCounters();
+
+private:
+    void transfer(std::unique_lock<std::mutex> &lock, size_t nSize);
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Released;
+    bool m_bOpen;
+    bool m_bFailing;
+    bool m_bHeld;
+    std::chrono::microseconds m_ByteTime;
+    uint64_t m_nTransactions;
+    uint64_t m_nBytes;
+
+    // PCA9685
+    uint8_t m_Registers[256];
+    uint8_t m_nPointer;
+
+    // MCP3421
+    uint8_t m_nADCConfig;
+    double m_dVolts;
+};
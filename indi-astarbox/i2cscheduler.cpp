@@ -0,0 +1,130 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : i2cscheduler.cpp
+ * Runs the I2C commands on a worker thread, spaced by the inter command wait
+ */
+
+#include "i2cscheduler.h"
+
+I2CScheduler::I2CScheduler(I2CBus &bus, std::chrono::milliseconds spacing) : m_Bus(bus), m_Spacing(spacing)
+{
+    m_bRunning = false;
+    m_bStopping = false;
+    m_LastCommand = std::chrono::steady_clock::now() - spacing;
+}
+
+I2CScheduler::~I2CScheduler()
+{
+    stop();
+}
+
+void I2CScheduler::start()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if(m_bRunning)
+        return;
+
+    m_bRunning = true;
+    m_bStopping = false;
+    m_Worker = std::thread(&I2CScheduler::run, this);
+}
+
+void I2CScheduler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(!m_bRunning)
+            return;
+        m_bStopping = true;
+    }
+    m_Wakeup.notify_all();
+    m_Worker.join();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_bRunning = false;
+}
+
+bool I2CScheduler::isRunning()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_bRunning && !m_bStopping;
+}
+
+std::future<int> I2CScheduler::submit(Command command)
+{
+    std::packaged_task<int(I2CBus &)> task(std::move(command));
+    std::future<int> result = task.get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if(!m_bRunning || m_bStopping)
+        {
+            // Nobody will run it, fail it now rather than leave the caller waiting
+            std::promise<int> failed;
+            failed.set_value(-1);
+            return failed.get_future();
+        }
+        m_Queue.push_back(std::move(task));
+    }
+    m_Wakeup.notify_one();
+    return result;
+}
+
+size_t I2CScheduler::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Queue.size();
+}
+
+I2CScheduler::Statistics I2CScheduler::getStatistics()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Statistics;
+}
+
+void I2CScheduler::run()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    while(true)
+    {
+        m_Wakeup.wait(lock, [this] { return m_bStopping || !m_Queue.empty(); });
+        if(m_Queue.empty())
+            break;
+
+        // Keep the devices happy, they need some rest between commands
+        auto nextSlot = m_LastCommand + m_Spacing;
+        auto now = std::chrono::steady_clock::now();
+        if(now < nextSlot)
+        {
+            m_Statistics.nWaits++;
+            m_Statistics.dWaitedSeconds += std::chrono::duration<double>(nextSlot - now).count();
+            lock.unlock();
+            std::this_thread::sleep_until(nextSlot);
+            lock.lock();
+        }
+
+        std::packaged_task<int(I2CBus &)> task = std::move(m_Queue.front());
+        m_Queue.pop_front();
+        lock.unlock();
+
+        task(m_Bus);
+
+        lock.lock();
+        m_LastCommand = std::chrono::steady_clock::now();
+        m_Statistics.nCommands++;
+    }
+}
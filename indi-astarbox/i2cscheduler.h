@@ -0,0 +1,75 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : i2cscheduler.h
+ * Runs the I2C commands on a worker thread, spaced by the inter command wait
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include "i2cbus.h"
+
+// Commands are run in the order they were submitted, one at a time, and a command never
+// starts less than the spacing after the end of the previous one. Callers never wait for
+// the bus unless they wait on the returned future.
+class I2CScheduler
+{
+public:
+    typedef std::function<int(I2CBus &bus)> Command;
+
+    struct Statistics
+    {
+        uint64_t nCommands = 0;
+        uint64_t nWaits = 0;            // commands that had to wait for the spacing
+        double dWaitedSeconds = 0;
+    };
+
+    I2CScheduler(I2CBus &bus, std::chrono::milliseconds spacing);
+    ~I2CScheduler();
+
+    void start();
+    // Runs the commands already submitted, then stops the worker
+    void stop();
+    bool isRunning();
+
+    std::future<int> submit(Command command);
+
+    size_t getPendingCount();
+    Statistics getStatistics();
+
+private:
+    void run();
+
+    I2CBus &m_Bus;
+    std::chrono::milliseconds m_Spacing;
+
+    std::thread m_Worker;
+    std::mutex m_Mutex;
+    std::condition_variable m_Wakeup;
+    std::deque<std::packaged_task<int(I2CBus &)>> m_Queue;
+    bool m_bRunning;
+    bool m_bStopping;
+
+    std::chrono::steady_clock::time_point m_LastCommand;
+    Statistics m_Statistics;
+};
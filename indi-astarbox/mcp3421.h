@@ -1,38 +1,16 @@
-#include <linux/i2c-dev.h>
-#include <iostream>
-#include <fcntl.h>
-#include <unistd.h>
+#pragma once
+
 #include <cstdint>
-#include <sys/ioctl.h>
+
+#include "i2cbus.h"
 
 #define ADC_ADDR0 0x68
 #define ADC_ADDR2 0x6a
 
-// I2C definitions
-
-#define I2C_SLAVE	0x0703
-#define I2C_SMBUS	0x0720	/* SMBus-level access */
-
-#define I2C_SMBUS_READ	1
-#define I2C_SMBUS_WRITE	0
-
-// SMBus transaction types
-
-#define I2C_SMBUS_QUICK		    0
-#define I2C_SMBUS_BYTE		    1
-#define I2C_SMBUS_BYTE_DATA	    2
-#define I2C_SMBUS_WORD_DATA	    3
-#define I2C_SMBUS_PROC_CALL	    4
-#define I2C_SMBUS_BLOCK_DATA	    5
-#define I2C_SMBUS_I2C_BLOCK_BROKEN  6
-#define I2C_SMBUS_BLOCK_PROC_CALL   7		/* SMBus 2.0 */
-#define I2C_SMBUS_I2C_BLOCK_DATA    8
-
-// SMBus messages
-
-#define I2C_SMBUS_BLOCK_MAX	32	/* As specified in SMBus standard */
-#define I2C_SMBUS_I2C_BLOCK_MAX	32	/* Not specified but we use same structure */
+// Configuration register
 
+#define MCP3421_RDY         0x80    // read: 0 when the result is new, write: start a one shot conversion
+#define MCP3421_CONTINUOUS  0x10    // convert continuously
 
 #define	MCP3422_SR_240	0
 #define	MCP3422_SR_60	1
@@ -44,36 +22,26 @@
 #define	MCP3422_GAIN_4	2
 #define	MCP3422_GAIN_8	3
 
-union i2c_smbus_data {
-  uint8_t  byte ;
-  uint16_t word ;
-  uint8_t  block [I2C_SMBUS_BLOCK_MAX + 2] ;	// block [0] is used for length + one more for PEC
-} ;
-
 
 class mcp3421
 {
 public:
     mcp3421();
     ~mcp3421();
-    void setBusID(int nBus);
+    void setBus(I2CBus *bus);
     bool isMCP3421Present();
     int openMCP3421();
     int closeMCP3421();
     double getVoltValue();
+    int readVoltValue(double &dVolts);
 
 private:
     int m_nADCAdress;
 
-    int m_fd;
+    I2CBus *m_pBus;
     double m_value;
     double m_dVperDiv;
     int	m_resistorDividerRatio;
-    std::string m_sDevPath;
-    
-    static inline int i2c_smbus_access (int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data);
-    int openDevice(const char* devPath, int devAddr);
-    void waitForConversion (int fd, unsigned char *buffer, int n);
-    int readValue(int fd, int channel, int sampleRate, int gain);
 
+    int readValue(int sampleRate, int &nValue);
 };
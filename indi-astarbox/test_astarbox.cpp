@@ -0,0 +1,208 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : test_astarbox.cpp
+ * AStarBox ports on the in memory PCA9685 and MCP3421
+ */
+
+#include <gtest/gtest.h>
+
+#include "AStarBox.h"
+#include "i2cbusmodel.h"
+
+#define TEST_WAIT_MS 20
+#define POLLS 20
+
+// 100 kHz bus
+#define BYTE_TIME std::chrono::microseconds(90)
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(I2CScheduler, Spacing)
+{
+    I2CBusModel bus;
+    I2CScheduler scheduler(bus, std::chrono::milliseconds(TEST_WAIT_MS));
+    std::vector<std::chrono::steady_clock::time_point> runs;
+    std::vector<std::future<int>> results;
+
+    scheduler.start();
+    ASSERT_EQ(bus.open(), 0);
+
+    // the caller does not wait for the bus, commands are queued while another master holds it
+    bus.setHeld(true);
+    std::future<int> held = scheduler.submit([](I2CBus &bus)
+    {
+        uint8_t nValue;
+        return bus.read(ADC_ADDR0, &nValue, 1);
+    });
+    for(int i = 0; i < 4; i++)
+        results.push_back(scheduler.submit([&runs](I2CBus &)
+        {
+            runs.push_back(std::chrono::steady_clock::now());
+            return 0;
+        }));
+    for(auto &result : results)
+        EXPECT_EQ(result.wait_for(std::chrono::seconds(0)), std::future_status::timeout);
+
+    bus.setHeld(false);
+    EXPECT_EQ(held.get(), 0);
+    for(auto &result : results)
+        EXPECT_EQ(result.get(), 0);
+
+    ASSERT_EQ(runs.size(), 4u);
+    for(size_t i = 1; i < runs.size(); i++)
+    {
+        double gap = std::chrono::duration<double, std::milli>(runs[i] - runs[i - 1]).count();
+        EXPECT_GE(gap, TEST_WAIT_MS - 1);
+    }
+
+    // nothing runs once stopped, the worker is then done with the statistics
+    scheduler.stop();
+    EXPECT_EQ(scheduler.getStatistics().nCommands, 5u);
+    EXPECT_EQ(scheduler.submit([](I2CBus &) { return 0; }).get(), -1);
+}
+
+class AStarBoxPorts : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            bus.setByteTime(BYTE_TIME);
+            ASSERT_EQ(ports.connect(), PLUGIN_OK);
+            ASSERT_EQ(ports.waitForPendingCommands(), PLUGIN_OK);
+            bus.resetCounters();
+        }
+
+        void TearDown() override
+        {
+            ports.disconnect();
+        }
+
+        I2CBusModel bus;
+        CAStarBoxPowerPorts ports { &bus, TEST_WAIT_MS };
+};
+
+TEST_F(AStarBoxPorts, PollWithoutBusAccess)
+{
+    bool bOn = true;
+    int nPercent = -1;
+
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < POLLS; i++)
+    {
+        for(int nPort = POWER_1; nPort <= PWM_2; nPort++)
+        {
+            EXPECT_EQ(ports.getPortStatus(nPort, bOn), PLUGIN_OK);
+            EXPECT_FALSE(bOn);
+        }
+        EXPECT_EQ(ports.getPortPWMDutyCyclePercent(PWM_1, nPercent), PLUGIN_OK);
+        EXPECT_EQ(ports.getPortPWMDutyCyclePercent(PWM_2, nPercent), PLUGIN_OK);
+    }
+    double cached = elapsedMs(start) / POLLS;
+    EXPECT_EQ(bus.getTransactionCount(), 0u);
+
+    // The same poll read from the device, one register at a time as before
+    PCA9685 controller;
+    controller.init(&bus, 0x40);
+    start = std::chrono::steady_clock::now();
+    for(int i = 0; i < POLLS; i++)
+    {
+        int nValue;
+        for(int nPort = PORT_1; nPort <= PORT_PWM2; nPort++)
+            controller.isPortOn(nPort);
+        controller.getPWM(PORT_PWM1, nValue);
+        controller.getPWM(PORT_PWM2, nValue);
+    }
+    double direct = elapsedMs(start) / POLLS;
+
+    printf("Port poll: cached %.3f ms, read from the device %.1f ms (%.0f transactions)\n",
+           cached, direct, double(bus.getTransactionCount()) / POLLS);
+}
+
+TEST_F(AStarBoxPorts, PortChangesAreCoalesced)
+{
+    // A voltage read, queued while the bus is held, keeps the scheduler busy while the ports are changed
+    ports.getVoltage();
+    ASSERT_EQ(ports.waitForPendingCommands(), PLUGIN_OK);
+    uint64_t nVoltageTransactions = bus.getTransactionCount();
+    uint64_t nVoltageBytes = bus.getByteCount();
+    bus.resetCounters();
+
+    bus.setHeld(true);
+    ports.getVoltage();
+
+    EXPECT_EQ(ports.setPortPWMDutyCyclePercent(PWM_1, 50), PLUGIN_OK);
+    EXPECT_EQ(ports.setPortPWMDutyCyclePercent(PWM_2, 25), PLUGIN_OK);
+    for(int nPort = POWER_1; nPort <= PWM_2; nPort++)
+        EXPECT_EQ(ports.setPort(nPort, ON), PLUGIN_OK);
+
+    // none of the calls went to the bus
+    EXPECT_EQ(bus.getTransactionCount(), 0u);
+
+    // The state is the one written even before it reaches the device
+    bool bOn = false;
+    EXPECT_EQ(ports.getPortStatus(POWER_3, bOn), PLUGIN_OK);
+    EXPECT_TRUE(bOn);
+
+    bus.setHeld(false);
+    EXPECT_EQ(ports.waitForPendingCommands(), PLUGIN_OK);
+
+    // then all of them in a single auto-increment write: address, register and 4 bytes for each port
+    EXPECT_EQ(bus.getTransactionCount(), nVoltageTransactions + 1);
+    EXPECT_EQ(bus.getByteCount(), nVoltageBytes + 2 + 4 * (PORT_PWM2 - PORT_1 + 1));
+    EXPECT_TRUE(bus.getRegister(MODE1) & MODE1_AI);
+
+    for(int nPort = PORT_1; nPort <= PORT_4; nPort++)
+        EXPECT_EQ(bus.getPortValue(nPort, false), MAX_PCA_VALUE);
+    EXPECT_EQ(bus.getPortValue(PORT_PWM1, true), MAX_PCA_VALUE / 2);
+    EXPECT_EQ(bus.getPortValue(PORT_PWM2, true), MAX_PCA_VALUE / 4);
+
+    int nPercent = 0;
+    EXPECT_EQ(ports.getPortPWMDutyCyclePercent(PWM_1, nPercent), PLUGIN_OK);
+    EXPECT_EQ(nPercent, 50);
+}
+
+TEST_F(AStarBoxPorts, Voltage)
+{
+    bus.setVoltage(12.5);
+    ports.getVoltage();
+    ports.waitForPendingCommands();
+    EXPECT_NEAR(ports.getVoltage(), 12.5, 0.001);
+}
+
+TEST_F(AStarBoxPorts, WriteErrorIsReportedAndRetried)
+{
+    bool bOn = false;
+
+    bus.setFailing(true);
+    ports.setPort(POWER_2, ON);
+    EXPECT_EQ(ports.waitForPendingCommands(), P_ERROR);
+    EXPECT_EQ(ports.getPortStatus(POWER_2, bOn), P_ERROR);
+
+    bus.setFailing(false);
+    EXPECT_EQ(ports.waitForPendingCommands(), PLUGIN_OK);
+    EXPECT_EQ(ports.getPortStatus(POWER_2, bOn), PLUGIN_OK);
+    EXPECT_TRUE(bOn);
+    EXPECT_EQ(bus.getPortValue(PORT_2, false), MAX_PCA_VALUE);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
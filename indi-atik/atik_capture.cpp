@@ -0,0 +1,242 @@
+/*
+ ATIK CCD Exposure Scheduling
+
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "atik_capture.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Share of the fastest readout seen in a mode to sleep through before polling
+#define READOUT_MARGIN          0.9
+// Polls between two checks of the camera state
+#define STATE_CHECK_POLLS       20
+
+/////////////////////////////////////////////////////////
+/// SDK camera
+/////////////////////////////////////////////////////////
+int ATIKSDKCamera::startExposure(float seconds)
+{
+    pthread_mutex_lock(m_AccessMutex);
+    int rc = ArtemisStartExposure(m_Handle, seconds);
+    pthread_mutex_unlock(m_AccessMutex);
+    return rc;
+}
+
+int ATIKSDKCamera::stopExposure()
+{
+    pthread_mutex_lock(m_AccessMutex);
+    int rc = ArtemisStopExposure(m_Handle);
+    pthread_mutex_unlock(m_AccessMutex);
+    return rc;
+}
+
+bool ATIKSDKCamera::imageReady()
+{
+    pthread_mutex_lock(m_AccessMutex);
+    bool ready = ArtemisImageReady(m_Handle);
+    pthread_mutex_unlock(m_AccessMutex);
+    return ready;
+}
+
+int ATIKSDKCamera::cameraState()
+{
+    pthread_mutex_lock(m_AccessMutex);
+    int state = ArtemisCameraState(m_Handle);
+    pthread_mutex_unlock(m_AccessMutex);
+    return state;
+}
+
+/////////////////////////////////////////////////////////
+/// Scheduler
+/////////////////////////////////////////////////////////
+ATIKExposureScheduler::ATIKExposureScheduler(ATIKCameraIO &camera) : m_Camera(camera)
+{
+}
+
+void ATIKExposureScheduler::setMode(int binX, int binY, int width, int height)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    Mode mode {binX, binY, width, height};
+    if (mode == m_Mode)
+        return;
+
+    m_Mode = mode;
+    if (m_Armed)
+    {
+        m_Camera.stopExposure();
+        m_Armed = false;
+    }
+}
+
+int ATIKExposureScheduler::start(double duration)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    int rc = m_Camera.startExposure(static_cast<float>(duration));
+    if (rc != ARTEMIS_OK)
+        return rc;
+
+    m_Duration = duration;
+    m_End = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(duration));
+    m_Abort = false;
+    m_Armed = false;
+    return rc;
+}
+
+int ATIKExposureScheduler::arm(double duration)
+{
+    int rc = start(duration);
+    if (rc == ARTEMIS_OK)
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        m_Armed = true;
+    }
+    return rc;
+}
+
+bool ATIKExposureScheduler::resume(double duration)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    if (!m_Armed)
+        return false;
+
+    m_Armed = false;
+    if (std::fabs(duration - m_Duration) < 1e-6)
+    {
+        m_Abort = false;
+        return true;
+    }
+
+    m_Camera.stopExposure();
+    return false;
+}
+
+bool ATIKExposureScheduler::armed() const
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    return m_Armed;
+}
+
+void ATIKExposureScheduler::disarm()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    if (m_Armed)
+    {
+        m_Camera.stopExposure();
+        m_Armed = false;
+    }
+}
+
+void ATIKExposureScheduler::abort()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Abort = true;
+    m_Wake.notify_all();
+}
+
+ATIKExposureScheduler::ReadoutStatistics ATIKExposureScheduler::statistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    auto readout = m_Readouts.find(m_Mode);
+    return readout != m_Readouts.end() ? readout->second : ReadoutStatistics();
+}
+
+ATIKExposureScheduler::Result ATIKExposureScheduler::wait(const std::function<void(double)> &timeLeft)
+{
+    std::unique_lock<std::mutex> lock(m_Lock);
+    Clock::time_point const end = m_End;
+    Mode const mode = m_Mode;
+    // An armed exposure may be taken over long after its end. Its readout is only known if the image
+    // was not ready yet when the wait started.
+    Clock::time_point const started = Clock::now();
+    bool const waitedForEnd = started < end;
+
+    /*
+        Nothing to ask the camera until the image is due.
+        With more than a second left, wake up on whole seconds left so that the countdown is neat.
+    */
+    Clock::time_point due = end;
+    auto readout = m_Readouts.find(mode);
+    if (readout != m_Readouts.end())
+        due += std::chrono::duration_cast<Clock::duration>(
+                   std::chrono::duration<double, std::milli>(readout->second.minimum * READOUT_MARGIN));
+
+    while (!m_Abort)
+    {
+        Clock::time_point const now = Clock::now();
+        if (now >= due)
+            break;
+
+        double left = std::chrono::duration<double>(end - now).count();
+        Clock::time_point wake = due;
+        if (left > 1.1)
+        {
+            double const delay = std::max(left - std::trunc(left), 0.005);
+            wake = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(delay));
+            left = std::round(left);
+        }
+        if (timeLeft && left > 0)
+        {
+            lock.unlock();
+            timeLeft(left);
+            lock.lock();
+        }
+        m_Wake.wait_until(lock, wake, [this]()
+        {
+            return m_Abort;
+        });
+    }
+
+    /*
+        Then poll it at a short interval until the image is ready
+    */
+    Clock::time_point const deadline = std::max(end, started) + std::chrono::milliseconds(m_ReadoutTimeout);
+    for (int polls = 0; !m_Abort; polls++)
+    {
+        lock.unlock();
+        bool const ready = m_Camera.imageReady();
+        int const state = (ready || polls % STATE_CHECK_POLLS) ? CAMERA_DOWNLOADING : m_Camera.cameraState();
+        lock.lock();
+
+        Clock::time_point const now = Clock::now();
+        if (ready && (waitedForEnd || polls > 0))
+        {
+            ReadoutStatistics &statistics = m_Readouts[mode];
+            double const ms = std::max(std::chrono::duration<double, std::milli>(now - end).count(), 0.0);
+            statistics.last = ms;
+            statistics.minimum = statistics.frames == 0 ? ms : std::min(statistics.minimum, ms);
+            statistics.maximum = statistics.frames == 0 ? ms : std::max(statistics.maximum, ms);
+            statistics.frames++;
+            statistics.mean += (ms - statistics.mean) / statistics.frames;
+        }
+        if (ready)
+            return EXPOSURE_READY;
+
+        if (state == CAMERA_ERROR || now >= deadline)
+            return EXPOSURE_FAILED;
+
+        m_Wake.wait_for(lock, std::chrono::milliseconds(m_PollInterval), [this]()
+        {
+            return m_Abort;
+        });
+    }
+
+    return EXPOSURE_ABORTED;
+}
@@ -0,0 +1,150 @@
+/*
+ ATIK CCD Exposure Scheduling
+
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <AtikCameras.h>
+
+#include <pthread.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+/*
+    The Artemis calls an exposure makes, so that exposures can run against a fake camera.
+*/
+class ATIKCameraIO
+{
+    public:
+        virtual ~ATIKCameraIO() = default;
+
+        virtual int startExposure(float seconds) = 0;
+        virtual int stopExposure() = 0;
+        virtual bool imageReady() = 0;
+        virtual int cameraState() = 0;
+};
+
+/*
+    ATIKCameraIO on a connected camera. Calls are serialized with the other users of the handle by accessMutex.
+*/
+class ATIKSDKCamera : public ATIKCameraIO
+{
+    public:
+        ATIKSDKCamera(ArtemisHandle handle, pthread_mutex_t *accessMutex) : m_Handle(handle), m_AccessMutex(accessMutex) {}
+
+        int startExposure(float seconds) override;
+        int stopExposure() override;
+        bool imageReady() override;
+        int cameraState() override;
+
+    private:
+        ArtemisHandle m_Handle;
+        pthread_mutex_t *m_AccessMutex;
+};
+
+/*
+    Waits for the exposures of one camera.
+
+    An exposure sleeps until its end plus the readout time measured for the binning and ROI in use, giving
+    the time left once a second on the way, then polls the camera at a short interval until the image is
+    ready. The next exposure of a sequence may be started while the last image is processed, and taken
+    over by the next request for an exposure of the same duration.
+*/
+class ATIKExposureScheduler
+{
+    public:
+        struct ReadoutStatistics
+        {
+            uint32_t frames {0};
+            /** From the end of the exposure to the image being ready, ms */
+            double last {0};
+            double mean {0};
+            double minimum {0};
+            double maximum {0};
+        };
+
+        enum Result
+        {
+            EXPOSURE_READY,
+            EXPOSURE_ABORTED,
+            EXPOSURE_FAILED
+        };
+
+        explicit ATIKExposureScheduler(ATIKCameraIO &camera);
+
+        /** Binning and ROI of the next exposures, readout times are kept for each. Disarms on a change. */
+        void setMode(int binX, int binY, int width, int height);
+
+        /** Interval between readiness checks once the image is due, ms */
+        void setPollInterval(int ms)
+        {
+            m_PollInterval = ms;
+        }
+        /** Time the image may take to be ready after the end of an exposure, ms */
+        void setReadoutTimeout(int ms)
+        {
+            m_ReadoutTimeout = ms;
+        }
+
+        /** Starts an exposure, the camera must be idle */
+        int start(double duration);
+        /** Starts the next exposure of a sequence while the last image is processed */
+        int arm(double duration);
+        /** Takes over an armed exposure of duration, or stops one of another duration. True if taken over. */
+        bool resume(double duration);
+        bool armed() const;
+        /** Stops an armed exposure, if any */
+        void disarm();
+
+        /**
+         * Waits for the image of the exposure started last. timeLeft is called with the seconds left while
+         * exposing. Returns early once abort() is called, the camera is then left exposing.
+         */
+        Result wait(const std::function<void(double)> &timeLeft);
+        void abort();
+
+        /** Readout times of the current mode, from the images that were not ready when wait() started */
+        ReadoutStatistics statistics() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        using Mode = std::tuple<int, int, int, int>;
+
+        ATIKCameraIO &m_Camera;
+        int m_PollInterval {5};
+        int m_ReadoutTimeout {60000};
+
+        mutable std::mutex m_Lock;
+        std::condition_variable m_Wake;
+        bool m_Abort {false};
+
+        Mode m_Mode {1, 1, 0, 0};
+        std::map<Mode, ReadoutStatistics> m_Readouts;
+
+        double m_Duration {0};
+        Clock::time_point m_End;
+        bool m_Armed {false};
+};
@@ -27,6 +27,7 @@
 #include <stream/streammanager.h>
 
 #include <algorithm>
+#include <cstring>
 #include <math.h>
 #include <unistd.h>
 #include <deque>
@@ -289,6 +290,9 @@ bool ATIKCCD::Connect()
         return false;
     }
 
+    m_CameraIO.reset(new ATIKSDKCamera(hCam, &accessMutex));
+    m_Scheduler.reset(new ATIKExposureScheduler(*m_CameraIO));
+
     return setupParams();
 }
 
@@ -657,14 +661,17 @@ bool ATIKCCD::Disconnect()
     threadRequest = StateTerminate;
     pthread_cond_signal(&cv);
     pthread_mutex_unlock(&condMutex);
+    m_Scheduler->abort();
     pthread_join(imagingThread, nullptr);
     tState = StateNone;
     if (isSimulation() == false)
     {
-        if (tState == StateExposure)
+        if (tState == StateExposure || m_Scheduler->armed())
             ArtemisStopExposure(hCam);
         ArtemisDisconnect(hCam);
     }
+    m_Scheduler.reset();
+    m_CameraIO.reset();
 
     LOG_INFO("Camera is offline.");
 
@@ -1104,43 +1111,51 @@ bool ATIKCCD::StartExposure(float duration)
     PrimaryCCD.setExposureDuration(duration);
     ExposureRequest = duration;
 
-    // Camera needs to be in idle state to start exposure after previous abort
-    int maxWaitCount = 1000; // 1000 * 0.1s = 100s
-    while (ArtemisCameraState(hCam) != CAMERA_IDLE && --maxWaitCount > 0)
+    // The next frame of a sequence may already be exposing
+    if (m_Scheduler->resume(duration))
     {
-        LOG_DEBUG("Waiting camera to be idle...");
-        usleep(100000);
+        LOGF_DEBUG("Continuing armed exposure : %.3fs", duration);
     }
-    if (maxWaitCount == 0)
+    else
     {
-        LOG_ERROR("Camera not in idle state, can't start exposure");
-        return false;
-    }
+        // Camera needs to be in idle state to start exposure after previous abort
+        int maxWaitCount = 1000; // 1000 * 0.1s = 100s
+        while (ArtemisCameraState(hCam) != CAMERA_IDLE && --maxWaitCount > 0)
+        {
+            LOG_DEBUG("Waiting camera to be idle...");
+            usleep(100000);
+        }
+        if (maxWaitCount == 0)
+        {
+            LOG_ERROR("Camera not in idle state, can't start exposure");
+            return false;
+        }
 
-    LOGF_DEBUG("Start Exposure : %.3fs", duration);
+        LOGF_DEBUG("Start Exposure : %.3fs", duration);
 
-    //    if (m_CameraFlags & ARTEMIS_PROPERTIES_CAMERAFLAGS_HAS_SHUTTER)
-    //    {
-    //        if (PrimaryCCD.getFrameType() == INDI::CCDChip::DARK_FRAME ||
-    //            PrimaryCCD.getFrameType() == INDI::CCDChip::BIAS_FRAME)
-    //        {
-    //            ArtemisCloseShutter(hCam);
-    //        }
-    //        else
-    //        {
-    //            ArtemisOpenShutter(hCam);
-    //        }
-    //    }
+        //    if (m_CameraFlags & ARTEMIS_PROPERTIES_CAMERAFLAGS_HAS_SHUTTER)
+        //    {
+        //        if (PrimaryCCD.getFrameType() == INDI::CCDChip::DARK_FRAME ||
+        //            PrimaryCCD.getFrameType() == INDI::CCDChip::BIAS_FRAME)
+        //        {
+        //            ArtemisCloseShutter(hCam);
+        //        }
+        //        else
+        //        {
+        //            ArtemisOpenShutter(hCam);
+        //        }
+        //    }
 
-    ArtemisSetDarkMode(hCam, PrimaryCCD.getFrameType() == INDI::CCDChip::DARK_FRAME ||
-                       PrimaryCCD.getFrameType() == INDI::CCDChip::BIAS_FRAME);
+        ArtemisSetDarkMode(hCam, PrimaryCCD.getFrameType() == INDI::CCDChip::DARK_FRAME ||
+                           PrimaryCCD.getFrameType() == INDI::CCDChip::BIAS_FRAME);
 
-    int rc = ArtemisStartExposure(hCam, duration);
+        int rc = m_Scheduler->start(duration);
 
-    if (rc != ARTEMIS_OK)
-    {
-        LOGF_ERROR("Failed to start exposure (%d).", rc);
-        return false;
+        if (rc != ARTEMIS_OK)
+        {
+            LOGF_ERROR("Failed to start exposure (%d).", rc);
+            return false;
+        }
     }
 
     gettimeofday(&ExpStart, nullptr);
@@ -1166,11 +1181,13 @@ bool ATIKCCD::AbortExposure()
     pthread_mutex_lock(&condMutex);
     threadRequest = StateAbort;
     pthread_cond_signal(&cv);
+    m_Scheduler->abort();
     while (threadState == StateExposure)
     {
         pthread_cond_wait(&cv, &condMutex);
     }
     pthread_mutex_unlock(&condMutex);
+    m_Scheduler->disarm();
     ArtemisStopExposure(hCam);
     InExposure = false;
     return true;
@@ -1192,6 +1209,9 @@ bool ATIKCCD::UpdateCCDFrame(int x, int y, int w, int h)
     // Set UNBINNED coords
     PrimaryCCD.setFrame(x, y, w, h);
 
+    // Readout time depends on the binned size
+    m_Scheduler->setMode(PrimaryCCD.getBinX(), PrimaryCCD.getBinY(), w, h);
+
     // Total bytes required for image buffer
     PrimaryCCD.setFrameBufferSize(w / PrimaryCCD.getBinX() * h / PrimaryCCD.getBinY() * PrimaryCCD.getBPP() / 8, false);
     return true;
@@ -1215,14 +1235,18 @@ bool ATIKCCD::UpdateCCDBin(int binx, int biny)
 /////////////////////////////////////////////////////////
 /// Download from CCD
 /////////////////////////////////////////////////////////
-bool ATIKCCD::grabImage()
+bool ATIKCCD::grabImage(bool armNext)
 {
     //uint8_t *image = PrimaryCCD.getFrameBuffer();
     int x, y, w, h, binx, biny;
 
+    pthread_mutex_lock(&accessMutex);
     int rc = ArtemisGetImageData(hCam, &x, &y, &w, &h, &binx, &biny);
     if (rc != ARTEMIS_OK)
+    {
+        pthread_mutex_unlock(&accessMutex);
         return false;
+    }
 
     int bufferSize = w * binx * h * biny * PrimaryCCD.getBPP() / 8;
     if ( bufferSize < PrimaryCCD.getFrameBufferSize())
@@ -1233,8 +1257,24 @@ bool ATIKCCD::grabImage()
     }
 
     std::unique_lock<std::mutex> guard(ccdBufferLock);
-    PrimaryCCD.setFrameBuffer(reinterpret_cast<uint8_t*>(ArtemisImageBuffer(hCam)));
+    uint8_t *image = reinterpret_cast<uint8_t*>(ArtemisImageBuffer(hCam));
+    // The next exposure reuses the SDK buffer
+    if (armNext)
+    {
+        m_ImageCopy.resize(PrimaryCCD.getFrameBufferSize());
+        memcpy(m_ImageCopy.data(), image, m_ImageCopy.size());
+        image = m_ImageCopy.data();
+    }
+    PrimaryCCD.setFrameBuffer(image);
     guard.unlock();
+    pthread_mutex_unlock(&accessMutex);
+
+    if (armNext)
+    {
+        rc = m_Scheduler->arm(ExposureRequest);
+        if (rc != ARTEMIS_OK)
+            LOGF_DEBUG("Failed to start next exposure early (%d).", rc);
+    }
 
     if (ExposureRequest > VERBOSE_EXPOSURE)
         LOG_INFO("Download complete.");
@@ -1525,89 +1565,67 @@ void *ATIKCCD::imagingThreadEntry()
 void ATIKCCD::checkExposureProgress()
 {
     int expRetry = 0;
-    int uSecs = 1000000;
 
     while (threadRequest == StateExposure)
     {
         pthread_mutex_unlock(&condMutex);
-        pthread_mutex_lock(&accessMutex);
-        if (ArtemisImageReady(hCam))
+        ATIKExposureScheduler::Result result = m_Scheduler->wait([this](double timeLeft)
+        {
+            PrimaryCCD.setExposureLeft(timeLeft);
+        });
+        pthread_mutex_lock(&condMutex);
+
+        if (result == ATIKExposureScheduler::EXPOSURE_ABORTED)
+            break;
+
+        if (result == ATIKExposureScheduler::EXPOSURE_READY)
         {
             InExposure = false;
             PrimaryCCD.setExposureLeft(0.0);
             if (ExposureRequest > VERBOSE_EXPOSURE)
                 DEBUG(INDI::Logger::DBG_SESSION, "Exposure done, downloading image...");
-            pthread_mutex_lock(&condMutex);
+
+            auto readout = m_Scheduler->statistics();
+            LOGF_DEBUG("Readout %.0f ms, mean %.0f ms over %u frames.", readout.last, readout.mean, readout.frames);
+
+            // Start the next frame of a fast exposure sequence while this one is uploaded
+            bool armNext = FastExposureToggleSP[INDI_ENABLED].getState() == ISS_ON && FastExposureCountNP[0].getValue() > 1;
+
             exposureSetRequest(StateIdle);
             pthread_mutex_unlock(&condMutex);
-            grabImage();
+            grabImage(armNext);
             pthread_mutex_lock(&condMutex);
-            pthread_mutex_unlock(&accessMutex);
             break;
         }
 
-        int state = ArtemisCameraState(hCam);
-        pthread_mutex_unlock(&accessMutex);
-        if (state == -1)
+        if (++expRetry < MAX_EXP_RETRIES)
         {
-            if (++expRetry < MAX_EXP_RETRIES)
-            {
-                if (threadRequest == StateExposure)
-                {
-                    LOG_DEBUG("ASIGetExpStatus failed. Restarting exposure...");
-                }
-                InExposure = false;
-                pthread_mutex_lock(&accessMutex);
-                ArtemisStopExposure(hCam);
-                pthread_mutex_unlock(&accessMutex);
-                usleep(100000);
-                pthread_mutex_lock(&condMutex);
-                exposureSetRequest(StateRestartExposure);
-                break;
-            }
-            else
+            if (threadRequest == StateExposure)
             {
-                if (threadRequest == StateExposure)
-                {
-                    LOGF_ERROR("Exposure failed after %d attempts.", expRetry);
-                }
-                pthread_mutex_lock(&accessMutex);
-                ArtemisStopExposure(hCam);
-                pthread_mutex_unlock(&accessMutex);
-                PrimaryCCD.setExposureFailed();
-                usleep(100000);
-                pthread_mutex_lock(&condMutex);
-                exposureSetRequest(StateIdle);
-                break;
+                LOG_DEBUG("Exposure status failed. Restarting exposure...");
             }
+            InExposure = false;
+            pthread_mutex_unlock(&condMutex);
+            m_CameraIO->stopExposure();
+            usleep(100000);
+            pthread_mutex_lock(&condMutex);
+            exposureSetRequest(StateRestartExposure);
+            break;
         }
-
-        pthread_mutex_lock(&accessMutex);
-        float timeLeft = ArtemisExposureTimeRemaining(hCam);
-        pthread_mutex_unlock(&accessMutex);
-        if (timeLeft > 1.1)
+        else
         {
-            float fraction = timeLeft - static_cast<float>(static_cast<int>(timeLeft));
-            if (fraction >= 0.005)
-            {
-                uSecs = (fraction * 1000000.0f);
-            }
-            else
+            if (threadRequest == StateExposure)
             {
-                uSecs = 1000000;
+                LOGF_ERROR("Exposure failed after %d attempts.", expRetry);
             }
+            pthread_mutex_unlock(&condMutex);
+            m_CameraIO->stopExposure();
+            PrimaryCCD.setExposureFailed();
+            usleep(100000);
+            pthread_mutex_lock(&condMutex);
+            exposureSetRequest(StateIdle);
+            break;
         }
-        else
-        {
-            uSecs = 10000;
-        }
-        if (timeLeft >= 0.0049)
-        {
-            PrimaryCCD.setExposureLeft(timeLeft);
-        }
-
-        usleep(uSecs);
-        pthread_mutex_lock(&condMutex);
     }
 }
 
@@ -26,6 +26,11 @@
 #include <indifilterinterface.h>
 #include <indiccd.h>
 
+#include "atik_capture.h"
+
+#include <memory>
+#include <vector>
+
 class ATIKCCD : public INDI::CCD, public INDI::FilterInterface
 {
     public:
@@ -131,8 +136,8 @@ class ATIKCCD : public INDI::CCD, public INDI::FilterInterface
         IPState guidePulseNS(uint32_t ms, AtikGuideDirection dir, const char *dirName);
         IPState guidePulseWE(uint32_t ms, AtikGuideDirection dir, const char *dirName);
 
-        // Retrieve image from SDK
-        bool grabImage();
+        // Retrieve image from SDK, starting the next exposure of a sequence first if armNext
+        bool grabImage(bool armNext);
 
         /**
          * @brief setupParams get initial camera parameters
@@ -254,6 +259,12 @@ class ATIKCCD : public INDI::CCD, public INDI::FilterInterface
         pthread_mutex_t condMutex = PTHREAD_MUTEX_INITIALIZER;
         pthread_mutex_t accessMutex = PTHREAD_MUTEX_INITIALIZER;
 
+        // Exposure timing
+        std::unique_ptr<ATIKCameraIO> m_CameraIO;
+        std::unique_ptr<ATIKExposureScheduler> m_Scheduler;
+        // Last image, copied out of the SDK buffer while the next exposure runs
+        std::vector<uint8_t> m_ImageCopy;
+
         // Pulse Guiding
         int WEtimerID;
         int NStimerID;
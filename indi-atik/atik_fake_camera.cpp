@@ -0,0 +1,72 @@
+/*
+ ATIK CCD Fake Camera
+
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "atik_fake_camera.h"
+
+int ATIKFakeCamera::startExposure(float seconds)
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    starts++;
+
+    Clock::time_point const now = Clock::now();
+    if (m_Active && now < m_Ready)
+        return ARTEMIS_INVALID_FUNCTION;
+
+    m_Active = true;
+    m_End    = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    m_Ready  = m_End + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(readout));
+    return ARTEMIS_OK;
+}
+
+int ATIKFakeCamera::stopExposure()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    stops++;
+    m_Active = false;
+    return ARTEMIS_OK;
+}
+
+bool ATIKFakeCamera::imageReady()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    readyChecks++;
+
+    Clock::time_point const now = Clock::now();
+    if (m_Active && now < m_End)
+        earlyChecks++;
+    return m_Active && now >= m_Ready;
+}
+
+int ATIKFakeCamera::cameraState()
+{
+    std::lock_guard<std::mutex> lock(m_Lock);
+    stateChecks++;
+
+    if (failing)
+        return CAMERA_ERROR;
+
+    Clock::time_point const now = Clock::now();
+    if (m_Active && now < m_End)
+        earlyChecks++;
+    if (!m_Active || now >= m_Ready)
+        return CAMERA_IDLE;
+    return now < m_End ? CAMERA_EXPOSING : CAMERA_DOWNLOADING;
+}
@@ -0,0 +1,61 @@
+/*
+ ATIK CCD Fake Camera
+
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include "atik_capture.h"
+
+#include <atomic>
+
+/*
+    A camera with the timing of the SDK, without hardware.
+
+    An image is ready readout ms after the end of its exposure, and stays ready until the next exposure.
+    Starting an exposure fails unless the camera is idle, as it does on the hardware.
+*/
+class ATIKFakeCamera : public ATIKCameraIO
+{
+    public:
+        /** Time from the end of an exposure to its image, ms */
+        std::atomic<double> readout {50};
+        /** The camera reports an error state */
+        std::atomic_bool failing {false};
+
+        /** Calls made */
+        std::atomic_int starts {0};
+        std::atomic_int stops {0};
+        std::atomic_int readyChecks {0};
+        std::atomic_int stateChecks {0};
+        /** Calls to imageReady() and cameraState() made before the end of the exposure */
+        std::atomic_int earlyChecks {0};
+
+        int startExposure(float seconds) override;
+        int stopExposure() override;
+        bool imageReady() override;
+        int cameraState() override;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::mutex m_Lock;
+        bool m_Active {false};
+        Clock::time_point m_End, m_Ready;
+};
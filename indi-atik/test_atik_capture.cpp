@@ -0,0 +1,290 @@
+/*
+ ATIK CCD Exposure Scheduling tests
+
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include <gtest/gtest.h>
+
+#include "atik_capture.h"
+#include "atik_fake_camera.h"
+
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+TEST(ATIKExposureScheduler, FirstFrameWaitsForReadout)
+{
+    ATIKFakeCamera camera;
+    camera.readout = 50;
+    ATIKExposureScheduler scheduler(camera);
+    scheduler.setMode(1, 1, 1000, 1000);
+
+    Clock::time_point const start = Clock::now();
+    ASSERT_EQ(scheduler.start(0.2), ARTEMIS_OK);
+    EXPECT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+
+    // Sleeps never return early, a loaded machine only makes the wait longer and the polls fewer
+    EXPECT_GE(secondsSince(start), 0.25);
+    // Nothing is asked before the end of the exposure
+    EXPECT_EQ(camera.earlyChecks, 0);
+    EXPECT_LE(camera.readyChecks, 15);
+
+    auto statistics = scheduler.statistics();
+    EXPECT_EQ(statistics.frames, 1u);
+    EXPECT_GE(statistics.last, 50);
+    EXPECT_LT(statistics.last, 1000);
+}
+
+TEST(ATIKExposureScheduler, LearnsReadoutPerMode)
+{
+    ATIKFakeCamera camera;
+    camera.readout = 60;
+    ATIKExposureScheduler scheduler(camera);
+    scheduler.setMode(1, 1, 1000, 1000);
+
+    ASSERT_EQ(scheduler.start(0.05), ARTEMIS_OK);
+    ASSERT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+
+    // The next frame of the mode sleeps through most of the readout
+    camera.readyChecks = 0;
+    ASSERT_EQ(scheduler.start(0.05), ARTEMIS_OK);
+    ASSERT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+    EXPECT_EQ(camera.earlyChecks, 0);
+    EXPECT_LE(camera.readyChecks, 3);
+    EXPECT_EQ(scheduler.statistics().frames, 2u);
+
+    // Other modes have their own statistics
+    camera.readout = 20;
+    scheduler.setMode(2, 2, 500, 500);
+    EXPECT_EQ(scheduler.statistics().frames, 0u);
+    ASSERT_EQ(scheduler.start(0.05), ARTEMIS_OK);
+    ASSERT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+    EXPECT_EQ(scheduler.statistics().frames, 1u);
+    EXPECT_GE(scheduler.statistics().last, 20);
+    EXPECT_LT(scheduler.statistics().last, 60);
+
+    scheduler.setMode(1, 1, 1000, 1000);
+    EXPECT_EQ(scheduler.statistics().frames, 2u);
+    EXPECT_GE(scheduler.statistics().minimum, 60);
+}
+
+TEST(ATIKExposureScheduler, Countdown)
+{
+    ATIKFakeCamera camera;
+    camera.readout = 10;
+    ATIKExposureScheduler scheduler(camera);
+
+    std::vector<double> reports;
+    ASSERT_EQ(scheduler.start(1.7), ARTEMIS_OK);
+    ASSERT_EQ(scheduler.wait([&reports](double left)
+    {
+        reports.push_back(left);
+    }), ATIKExposureScheduler::EXPOSURE_READY);
+
+    // Whole seconds, then what is left of the last one
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[0], 2);
+    EXPECT_GT(reports[1], 0);
+    EXPECT_LE(reports[1], 1);
+}
+
+TEST(ATIKExposureScheduler, Abort)
+{
+    ATIKFakeCamera camera;
+    ATIKExposureScheduler scheduler(camera);
+
+    ASSERT_EQ(scheduler.start(5), ARTEMIS_OK);
+    Clock::time_point const start = Clock::now();
+    std::thread aborter([&scheduler]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        scheduler.abort();
+    });
+    EXPECT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_ABORTED);
+    aborter.join();
+    EXPECT_LT(secondsSince(start), 4);
+    EXPECT_EQ(camera.readyChecks, 0);
+}
+
+TEST(ATIKExposureScheduler, Failures)
+{
+    ATIKFakeCamera camera;
+    ATIKExposureScheduler scheduler(camera);
+    scheduler.setReadoutTimeout(100);
+
+    // Image never comes
+    camera.readout = 5000;
+    Clock::time_point const start = Clock::now();
+    ASSERT_EQ(scheduler.start(0.05), ARTEMIS_OK);
+    EXPECT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_FAILED);
+    EXPECT_GE(secondsSince(start), 0.15);
+    EXPECT_LT(secondsSince(start), 5);
+    EXPECT_EQ(scheduler.statistics().frames, 0u);
+
+    // Camera in error, the first state check gives up
+    camera.stopExposure();
+    camera.failing = true;
+    camera.readyChecks = 0;
+    camera.stateChecks = 0;
+    ASSERT_EQ(scheduler.start(0.05), ARTEMIS_OK);
+    EXPECT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_FAILED);
+    EXPECT_EQ(camera.readyChecks, 1);
+    EXPECT_EQ(camera.stateChecks, 1);
+}
+
+TEST(ATIKExposureScheduler, ArmedExposures)
+{
+    ATIKFakeCamera camera;
+    camera.readout = 10;
+    ATIKExposureScheduler scheduler(camera);
+    scheduler.setMode(1, 1, 100, 100);
+
+    // Same duration, taken over
+    ASSERT_EQ(scheduler.arm(0.05), ARTEMIS_OK);
+    EXPECT_TRUE(scheduler.armed());
+    EXPECT_TRUE(scheduler.resume(0.05));
+    EXPECT_FALSE(scheduler.armed());
+    EXPECT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+    EXPECT_EQ(camera.starts, 1);
+
+    // Another duration, stopped
+    ASSERT_EQ(scheduler.arm(0.05), ARTEMIS_OK);
+    EXPECT_FALSE(scheduler.resume(0.1));
+    EXPECT_EQ(camera.stops, 1);
+    EXPECT_FALSE(scheduler.resume(0.05));
+
+    // Another mode, stopped
+    ASSERT_EQ(scheduler.arm(0.05), ARTEMIS_OK);
+    scheduler.setMode(2, 2, 50, 50);
+    EXPECT_FALSE(scheduler.armed());
+    EXPECT_EQ(camera.stops, 2);
+}
+
+TEST(ATIKExposureScheduler, ResumedAfterReadout)
+{
+    ATIKFakeCamera camera;
+    camera.readout = 20;
+    ATIKExposureScheduler scheduler(camera);
+    scheduler.setMode(1, 1, 100, 100);
+    scheduler.setReadoutTimeout(200);
+
+    // The previous image took longer to upload than this exposure and its readout, the image is ready
+    // at the first poll and tells nothing of the readout
+    ASSERT_EQ(scheduler.arm(0.01), ARTEMIS_OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    ASSERT_TRUE(scheduler.resume(0.01));
+    EXPECT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+    EXPECT_EQ(camera.readyChecks, 1);
+    EXPECT_EQ(scheduler.statistics().frames, 0u);
+
+    // Still reading out when the wait starts, the time since the end of the exposure is the readout.
+    // The readout timeout runs from the start of the wait, it would be over at the end of the readout otherwise.
+    camera.readout = 300;
+    ASSERT_EQ(scheduler.arm(0.01), ARTEMIS_OK);
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    ASSERT_TRUE(scheduler.resume(0.01));
+    EXPECT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+    EXPECT_EQ(scheduler.statistics().frames, 1u);
+    EXPECT_GE(scheduler.statistics().last, 300);
+    EXPECT_LT(scheduler.statistics().last, 5000);
+}
+
+// The polling loop the scheduler replaced, for comparison
+static void pollingWait(ATIKFakeCamera &camera, Clock::time_point end)
+{
+    while (!camera.imageReady())
+    {
+        camera.cameraState();
+        double const left = std::chrono::duration<double>(end - Clock::now()).count();
+        int uSecs = 10000;
+        if (left > 1.1)
+        {
+            double const fraction = left - std::trunc(left);
+            uSecs = fraction >= 0.005 ? static_cast<int>(fraction * 1000000) : 1000000;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(uSecs));
+    }
+}
+
+// Sequences of 10 ms exposures with 50 ms of readout, and 30 ms to process each image
+TEST(ATIKExposureScheduler, SequenceFrameRate)
+{
+    constexpr int frames = 20;
+    constexpr double duration = 0.01;
+    auto process = []()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    };
+
+    ATIKFakeCamera camera;
+    camera.readout = 50;
+    ATIKExposureScheduler scheduler(camera);
+    scheduler.setMode(1, 1, 1000, 1000);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        camera.startExposure(duration);
+        pollingWait(camera, Clock::now() + std::chrono::milliseconds(10));
+        process();
+    }
+    double const pollingRate = frames / secondsSince(start);
+    double const pollingCalls = (camera.readyChecks + camera.stateChecks) / static_cast<double>(frames);
+
+    camera.readyChecks = 0;
+    camera.stateChecks = 0;
+    start = Clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        ASSERT_EQ(scheduler.start(duration), ARTEMIS_OK);
+        ASSERT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+        process();
+    }
+    double const scheduledRate = frames / secondsSince(start);
+    double const scheduledCalls = (camera.readyChecks + camera.stateChecks) / static_cast<double>(frames);
+
+    // The next exposure runs while the image is processed
+    start = Clock::now();
+    ASSERT_EQ(scheduler.start(duration), ARTEMIS_OK);
+    for (int i = 0; i < frames; i++)
+    {
+        ASSERT_EQ(scheduler.wait(nullptr), ATIKExposureScheduler::EXPOSURE_READY);
+        ASSERT_EQ(scheduler.arm(duration), ARTEMIS_OK);
+        process();
+        ASSERT_TRUE(scheduler.resume(duration));
+    }
+    double const armedRate = frames / secondsSince(start);
+    scheduler.disarm();
+
+    std::cout << "Polling: " << pollingRate << " frames/s, " << pollingCalls << " SDK calls per frame" << std::endl;
+    std::cout << "Scheduled: " << scheduledRate << " frames/s, " << scheduledCalls << " SDK calls per frame" << std::endl;
+    std::cout << "Scheduled, armed: " << armedRate << " frames/s" << std::endl;
+
+    EXPECT_LT(scheduledCalls, pollingCalls / 2);
+    EXPECT_GT(scheduledRate, pollingRate * 0.9);
+    EXPECT_GT(armedRate, scheduledRate * 1.3);
+}
@@ -96,10 +96,12 @@ AUDAUX::AUDAUX()
     features = 0;
 
     context = zmq_ctx_new();
+    client = new AUDClient(context);
 }
 
 AUDAUX::~AUDAUX()
 {
+    delete client;
 //    zmq_ctx_term(context);
 }
 
@@ -173,8 +175,6 @@ bool AUDAUX::initProperties()
     setDefaultPollingPeriod(5000);
     addPollPeriodControl();
 
-    pthread_mutex_init( &connectionmutex, NULL );
-
     return true;
 }
 
@@ -524,7 +524,6 @@ bool AUDAUX::ISNewNumber(const char * dev, const char * name, double values[], c
 bool AUDAUX::Connect()
 {
     char addr[1024], *answer;
-    int timeout = 500;
 
     if (isConnected())
         return true;
@@ -533,10 +532,8 @@ bool AUDAUX::Connect()
 
     DEBUGF(INDI::Logger::DBG_SESSION, "Attempting to connect %s aux...",IPaddress);
 
-    requester = zmq_socket(context, ZMQ_REQ);
-    zmq_setsockopt(requester, ZMQ_RCVTIMEO, &timeout, sizeof(timeout) );
     snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-    zmq_connect(requester, addr);
+    client->connect(addr);
 
     answer = sendRequest("DISCOVER");
     if ( answer ) {
@@ -555,7 +552,7 @@ bool AUDAUX::Connect()
                         !j.contains("HWIdentifier") ||
                         !j.contains("firmwareVersion") )
                 {
-                    zmq_close(requester);
+                    client->disconnect();
                     DEBUGF(INDI::Logger::DBG_ERROR, "Communication with %s AUX failed",IPaddress);
                     free(IPaddress);
                     return false;
@@ -574,20 +571,20 @@ bool AUDAUX::Connect()
                 LowLevelSWTP.apply();
             }
             if ( !(features & 0x0074) ) {
-                zmq_close(requester);
+                client->disconnect();
                 DEBUGF(INDI::Logger::DBG_ERROR, "AUX features not supported by %s hardware",IPaddress);
                 free(IPaddress);
                 return false;
             }
         } else {
-            zmq_close(requester);
+            client->disconnect();
             DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s aux",IPaddress);
             free(answer);
             free(IPaddress);
             return false;
         }
     } else {
-        zmq_close(requester);
+        client->disconnect();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s aux",IPaddress);
         free(IPaddress);
         return false;
@@ -608,7 +605,7 @@ bool AUDAUX::Disconnect()
 
     DEBUG(INDI::Logger::DBG_SESSION, "Attempting to disconnect aux...");
 
-    zmq_close(requester);
+    client->disconnect();
 
     RemoveTimer( tid );
 
@@ -752,75 +749,29 @@ const char *AUDAUX::getDefaultName()
 char* AUDAUX::sendCommand(const char *fmt, ... )
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc,retries;
-    zmq_pollitem_t item;
+    char buffer[4096], *answer;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    retries = 3;
-    do {
-        zmq_send(requester, buffer, strlen(buffer), 0);
-        item = { requester, 0, ZMQ_POLLIN, 0 };
-        rc = zmq_poll( &item, 1, 500 ); // ms
-        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) ) {
-            // communication succeeded
-            rc = zmq_recv(requester, answer, sizeof(answer), 0);
-            if ( rc >= 0 ) {
-                pthread_mutex_unlock( &connectionmutex );
-                answer[MIN(rc,(int)sizeof(answer)-1)] = '\0';
-                if ( !strncmp(answer,"OK",2) )
-                    return NULL;
-                if ( !strncmp(answer,"ERROR:",6) )
-                    return strdup(answer+6);
-                return strdup("SYNTAXERROR");
-            }
-        }
-        zmq_close(requester);
-        requester = zmq_socket(context, ZMQ_REQ);
-        snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-        zmq_connect(requester, addr);
-    } while ( --retries );
-    pthread_mutex_unlock( &connectionmutex );
-    DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
-    return strdup("COMMUNICATIONERROR");
+    answer = client->command(buffer);
+    if ( answer && !strcmp(answer,"COMMUNICATIONERROR") )
+        DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
+    return answer;
 }
 
 char* AUDAUX::sendRequest(const char *fmt, ... )
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc,retries;
-    zmq_pollitem_t item;
+    char buffer[4096], *answer;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    retries = 3;
-    do {
-        zmq_send(requester, buffer, strlen(buffer), 0);
-        item = { requester, 0, ZMQ_POLLIN, 0 };
-        rc = zmq_poll( &item, 1, 500 ); // ms
-        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) ) {
-            // communication succeeded
-            rc = zmq_recv(requester, answer, sizeof(answer), 0);
-            if ( rc >= 0 ) {
-                pthread_mutex_unlock( &connectionmutex );
-                answer[MIN(rc,(int)sizeof(answer)-1)] = '\0';
-                return strdup(answer);
-            }
-        }
-        zmq_close(requester);
-        requester = zmq_socket(context, ZMQ_REQ);
-        snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-        zmq_connect(requester, addr);
-    } while ( --retries );
-    pthread_mutex_unlock( &connectionmutex );
-    DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
-    return strdup("COMMUNICATIONERROR");
+    answer = client->request(buffer);
+    if ( answer && !strcmp(answer,"COMMUNICATIONERROR") )
+        DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
+    return answer;
 }
@@ -21,8 +21,8 @@
 #pragma once
 
 #include <time.h>
-#include <pthread.h>
 #include "defaultdevice.h"
+#include "indi_avalonud_client.h"
 
 #define MIN(a,b) (((a)<=(b))?(a):(b))
 
@@ -106,8 +106,7 @@ private:
     char* sendCommand(const char*,...);
     char* sendRequest(const char*,...);
 
-    void *context,*requester;
+    void *context;
+    AUDClient *client;
     time_t reboot_time,shutdown_time;
-
-    pthread_mutex_t connectionmutex;
 };
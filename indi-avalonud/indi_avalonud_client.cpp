@@ -0,0 +1,281 @@
+/*
+    Avalon Unified Driver ZeroMQ client
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "indi_avalonud_client.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <vector>
+#include <zmq.h>
+
+
+AUDClient::AUDClient(void *context) : context(context)
+{
+}
+
+AUDClient::~AUDClient()
+{
+    disconnect();
+}
+
+bool AUDClient::connect(const char *endpoint)
+{
+    static std::atomic<unsigned int> instances { 0 };
+    char wakeaddr[64];
+    int linger = 0, immediate = 1;
+
+    disconnect();
+
+    dealer = zmq_socket(context, ZMQ_DEALER);
+    zmq_setsockopt(dealer, ZMQ_LINGER, &linger, sizeof(linger));
+    // Requests wait in the client until the server is connected, so that one timing out is never sent late
+    zmq_setsockopt(dealer, ZMQ_IMMEDIATE, &immediate, sizeof(immediate));
+    if ( zmq_connect(dealer, endpoint) != 0 )
+    {
+        zmq_close(dealer);
+        dealer = nullptr;
+        return false;
+    }
+
+    snprintf( wakeaddr, sizeof(wakeaddr), "inproc://audclient-%u", instances++ );
+    wakeIn = zmq_socket(context, ZMQ_PULL);
+    zmq_bind(wakeIn, wakeaddr);
+    wakeOut = zmq_socket(context, ZMQ_PUSH);
+    zmq_setsockopt(wakeOut, ZMQ_LINGER, &linger, sizeof(linger));
+    zmq_connect(wakeOut, wakeaddr);
+
+    running = true;
+    worker = std::thread(&AUDClient::run, this);
+    return true;
+}
+
+void AUDClient::disconnect()
+{
+    if ( !worker.joinable() )
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        running = false;
+        zmq_send(wakeOut, "", 0, ZMQ_DONTWAIT);
+    }
+    worker.join();
+
+    zmq_close(dealer);
+    zmq_close(wakeOut);
+    zmq_close(wakeIn);
+    dealer = wakeIn = wakeOut = nullptr;
+}
+
+std::future<AUDAnswer> AUDClient::submit(const std::string &request, std::chrono::milliseconds timeout)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    if ( !running )
+    {
+        std::promise<AUDAnswer> none;
+        none.set_value(std::nullopt);
+        return none.get_future();
+    }
+
+    uint32_t id = nextId++;
+    Pending &entry = pending[id];
+    entry.deadline = std::chrono::steady_clock::now() + timeout;
+    unsent.emplace_back(id, request);
+    zmq_send(wakeOut, "", 0, ZMQ_DONTWAIT);
+    return entry.promise.get_future();
+}
+
+char *AUDClient::request(const char *request, int retries)
+{
+    do
+    {
+        AUDAnswer answer = submit(request).get();
+        if ( answer )
+            return strdup(answer->c_str());
+    }
+    while ( --retries > 0 );
+    return strdup("COMMUNICATIONERROR");
+}
+
+char *AUDClient::command(const char *command, int retries)
+{
+    do
+    {
+        AUDAnswer answer = submit(command).get();
+        if ( answer )
+            return commandAnswer(answer);
+    }
+    while ( --retries > 0 );
+    return strdup("COMMUNICATIONERROR");
+}
+
+char *AUDClient::commandAnswer(const AUDAnswer &answer)
+{
+    if ( !answer )
+        return strdup("COMMUNICATIONERROR");
+    if ( !strncmp(answer->c_str(), "OK", 2) )
+        return NULL;
+    if ( !strncmp(answer->c_str(), "ERROR:", 6) )
+        return strdup(answer->c_str() + 6);
+    return strdup("SYNTAXERROR");
+}
+
+size_t AUDClient::inFlight()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return pending.size();
+}
+
+void AUDClient::run()
+{
+    while ( running )
+    {
+        long timeout = -1;
+        bool waiting;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            auto now = std::chrono::steady_clock::now();
+            for ( auto &entry : pending )
+            {
+                long left = std::chrono::duration_cast<std::chrono::milliseconds>(entry.second.deadline - now).count() + 1;
+                if ( timeout < 0 || left < timeout )
+                    timeout = left > 0 ? left : 0;
+            }
+            waiting = !unsent.empty();
+        }
+
+        zmq_pollitem_t items[] =
+        {
+            { wakeIn, 0, ZMQ_POLLIN, 0 },
+            { dealer, 0, static_cast<short>(ZMQ_POLLIN | (waiting ? ZMQ_POLLOUT : 0)), 0 }
+        };
+        if ( zmq_poll(items, 2, timeout) < 0 && zmq_errno() != EINTR )
+            break;
+
+        if ( items[0].revents & ZMQ_POLLIN )
+        {
+            char dummy;
+            while ( zmq_recv(wakeIn, &dummy, sizeof(dummy), ZMQ_DONTWAIT) >= 0 )
+                ;
+        }
+        if ( items[1].revents & ZMQ_POLLIN )
+            receive();
+        forward();
+        expire();
+    }
+
+    failAll();
+}
+
+void AUDClient::forward()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    while ( !unsent.empty() )
+    {
+        uint32_t id = unsent.front().first;
+        const std::string &request = unsent.front().second;
+        auto entry = pending.find(id);
+
+        if ( entry != pending.end() )
+        {
+            // [request id][empty delimiter][request], the server answers with the same envelope
+            if ( zmq_send(dealer, &id, sizeof(id), ZMQ_SNDMORE | ZMQ_DONTWAIT) < 0 )
+                break;
+            zmq_send(dealer, "", 0, ZMQ_SNDMORE);
+            zmq_send(dealer, request.data(), request.size(), 0);
+        }
+        unsent.pop_front();
+    }
+}
+
+void AUDClient::receive()
+{
+    std::vector<std::string> frames;
+
+    while ( true )
+    {
+        int more = 0;
+        size_t moresize = sizeof(more);
+
+        frames.clear();
+        do
+        {
+            zmq_msg_t frame;
+            zmq_msg_init(&frame);
+            if ( zmq_msg_recv(&frame, dealer, ZMQ_DONTWAIT) < 0 )
+            {
+                zmq_msg_close(&frame);
+                break;
+            }
+            frames.emplace_back(static_cast<const char *>(zmq_msg_data(&frame)), zmq_msg_size(&frame));
+            zmq_msg_close(&frame);
+            zmq_getsockopt(dealer, ZMQ_RCVMORE, &more, &moresize);
+        }
+        while ( more );
+
+        if ( frames.empty() )
+            return;
+
+        if ( frames.size() == 3 && frames[0].size() == sizeof(uint32_t) && frames[1].empty() )
+        {
+            uint32_t id;
+            memcpy(&id, frames[0].data(), sizeof(id));
+
+            std::lock_guard<std::mutex> guard(lock);
+            auto entry = pending.find(id);
+            // Nobody waits for the answer of a request that timed out
+            if ( entry != pending.end() )
+            {
+                entry->second.promise.set_value(std::move(frames[2]));
+                pending.erase(entry);
+            }
+        }
+    }
+}
+
+void AUDClient::expire()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    auto now = std::chrono::steady_clock::now();
+
+    for ( auto entry = pending.begin(); entry != pending.end(); )
+    {
+        if ( entry->second.deadline <= now )
+        {
+            entry->second.promise.set_value(std::nullopt);
+            entry = pending.erase(entry);
+        }
+        else
+            ++entry;
+    }
+}
+
+void AUDClient::failAll()
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    for ( auto &entry : pending )
+        entry.second.promise.set_value(std::nullopt);
+    pending.clear();
+    unsent.clear();
+}
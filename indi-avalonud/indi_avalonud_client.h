@@ -0,0 +1,100 @@
+/*
+    Avalon Unified Driver ZeroMQ client
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Answer of the server, none if it did not answer in time
+using AUDAnswer = std::optional<std::string>;
+
+/*
+    Connection to an Avalon Unified server, shared by everything a driver sends.
+
+    The servers use a REP socket and handle one request at a time, in the order they arrive. This uses a DEALER
+    socket and puts a request identifier in the envelope in front of the empty delimiter frame, which REP sends back
+    untouched. A caller does not have to wait for its answer before the next request is queued, so guide pulses and
+    manual motions can be sent from the event loop without blocking it. An answer arriving after its request timed
+    out is dropped, so the connection does not have to be reset as with REQ.
+
+    A single I/O thread owns the DEALER socket. Requests are handed to it over an inproc socket.
+ */
+class AUDClient
+{
+public:
+    explicit AUDClient(void *context);
+    ~AUDClient();
+
+    AUDClient(const AUDClient &) = delete;
+    AUDClient &operator=(const AUDClient &) = delete;
+
+    bool connect(const char *endpoint);
+    void disconnect();
+    bool isConnected() const
+    {
+        return running;
+    }
+
+    // Sends request, the future holds the answer, or none after timeout
+    std::future<AUDAnswer> submit(const std::string &request, std::chrono::milliseconds timeout = std::chrono::milliseconds(500));
+
+    // Waits for the answer, sending the request again up to retries times. "COMMUNICATIONERROR" when there is none.
+    char *request(const char *request, int retries = 3);
+    // As request(), but NULL for an "OK" answer and the message of an "ERROR:" answer
+    char *command(const char *command, int retries = 3);
+    // The command() result for an answer of submit()
+    static char *commandAnswer(const AUDAnswer &answer);
+
+    size_t inFlight();
+
+private:
+    struct Pending
+    {
+        std::promise<AUDAnswer> promise;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    void run();
+    void forward();
+    void receive();
+    void expire();
+    void failAll();
+
+    void *context;
+    void *dealer { nullptr };
+    void *wakeIn { nullptr }, *wakeOut { nullptr };
+    std::thread worker;
+    std::atomic_bool running { false };
+
+    std::mutex lock;
+    uint32_t nextId { 1 };
+    std::unordered_map<uint32_t, Pending> pending;
+    // Requests the server could not take yet, oldest first
+    std::deque<std::pair<uint32_t, std::string>> unsent;
+};
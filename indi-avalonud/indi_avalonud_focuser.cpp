@@ -36,6 +36,7 @@
 #include <zmq.h>
 
 #include "indi_avalonud_focuser.h"
+#include "indi_avalonud_status.h"
 
 
 #define STEPMACHINE_DRIVER_NUM 2
@@ -93,6 +94,7 @@ AUDFOCUSER::AUDFOCUSER()
     setVersion(AVALONUD_VERSION_MAJOR,AVALONUD_VERSION_MINOR);
 
     context = zmq_ctx_new();
+    client = new AUDClient(context);
     setSupportedConnections( CONNECTION_NONE );
     FI::SetCapability(FOCUSER_CAN_ABORT |
                       FOCUSER_CAN_ABS_MOVE |
@@ -102,6 +104,7 @@ AUDFOCUSER::AUDFOCUSER()
 
 AUDFOCUSER::~AUDFOCUSER()
 {
+    delete client;
 //    zmq_ctx_term(context);
 }
 
@@ -140,8 +143,6 @@ bool AUDFOCUSER::initProperties()
     FocusSpeedNP[0].setMax(254);
     FocusSpeedNP[0].setStep(10);
 
-    pthread_mutex_init( &connectionmutex, NULL );
-
     return true;
 }
 
@@ -211,7 +212,6 @@ bool AUDFOCUSER::ISNewSwitch(const char * dev, const char * name, ISState * stat
 bool AUDFOCUSER::Connect()
 {
     char addr[1024], *answer;
-    int timeout = 500;
 
     if (isConnected())
         return true;
@@ -220,10 +220,8 @@ bool AUDFOCUSER::Connect()
 
     DEBUGF(INDI::Logger::DBG_SESSION, "Attempting to connect %s focuser...",IPaddress);
 
-    requester = zmq_socket(context, ZMQ_REQ);
-    zmq_setsockopt(requester, ZMQ_RCVTIMEO, &timeout, sizeof(timeout) );
     snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-    zmq_connect(requester, addr);
+    client->connect(addr);
 
     answer = sendRequest("DISCOVER");
     if ( answer ) {
@@ -242,7 +240,7 @@ bool AUDFOCUSER::Connect()
                         !j.contains("HWIdentifier") ||
                         !j.contains("firmwareVersion") )
                 {
-                    zmq_close(requester);
+                    client->disconnect();
                     DEBUGF(INDI::Logger::DBG_ERROR, "Communication with %s focuser failed",IPaddress);
                     free(IPaddress);
                     return false;
@@ -261,20 +259,20 @@ bool AUDFOCUSER::Connect()
                 LowLevelSWTP.apply();
             }
             if ( !(features & 0x0100) ) {
-                zmq_close(requester);
+                client->disconnect();
                 DEBUGF(INDI::Logger::DBG_ERROR, "Focuser features not supported by %s hardware",IPaddress);
                 free(IPaddress);
                 return false;
             }
         } else {
-            zmq_close(requester);
+            client->disconnect();
             DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s focuser",IPaddress);
             free(answer);
             free(IPaddress);
             return false;
         }
     } else {
-        zmq_close(requester);
+        client->disconnect();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s focuser",IPaddress);
         free(IPaddress);
         return false;
@@ -295,7 +293,7 @@ bool AUDFOCUSER::Disconnect()
 
     DEBUG(INDI::Logger::DBG_SESSION, "Attempting to disconnect focuser...");
 
-    zmq_close(requester);
+    client->disconnect();
 
     RemoveTimer( tid );
 
@@ -420,19 +418,17 @@ bool AUDFOCUSER::readPosition()
 
     answer = sendRequest("STATUS %d",STEPMACHINE_DRIVER_NUM);
     if ( answer ) {
-        json j;
+        AUDFocuserStatus status;
+        bool decoded = aud_decode_focuser_status(answer,status);
 
-        j = json::parse(answer,nullptr,false);
         free(answer);
-        if ( j.is_discarded() ||
-                !j.contains("position_step") ||
-                !j.contains("statusCode") )
+        if ( !decoded )
         {
             DEBUG(INDI::Logger::DBG_WARNING,"Status communication error");
             return false;
         }
-        j["position_step"].get_to(currentPosition);
-        j["statusCode"].get_to(statusCode);
+        currentPosition = status.position;
+        statusCode = status.statusCode;
         return true;
     }
 
@@ -456,75 +452,29 @@ const char *AUDFOCUSER::getDefaultName()
 char* AUDFOCUSER::sendCommand(const char *fmt, ... )
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc,retries;
-    zmq_pollitem_t item;
+    char buffer[4096], *answer;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    retries = 3;
-    do {
-        zmq_send(requester, buffer, strlen(buffer), 0);
-        item = { requester, 0, ZMQ_POLLIN, 0 };
-        rc = zmq_poll( &item, 1, 500 ); // ms
-        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) ) {
-            // communication succeeded
-            rc = zmq_recv(requester, answer, sizeof(answer), 0);
-            if ( rc >= 0 ) {
-                pthread_mutex_unlock( &connectionmutex );
-                answer[MIN(rc,(int)sizeof(answer)-1)] = '\0';
-                if ( !strncmp(answer,"OK",2) )
-                    return NULL;
-                if ( !strncmp(answer,"ERROR:",6) )
-                    return strdup(answer+6);
-                return strdup("SYNTAXERROR");
-            }
-        }
-        zmq_close(requester);
-        requester = zmq_socket(context, ZMQ_REQ);
-        snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-        zmq_connect(requester, addr);
-    } while ( --retries );
-    pthread_mutex_unlock( &connectionmutex );
-    DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
-    return strdup("COMMUNICATIONERROR");
+    answer = client->command(buffer);
+    if ( answer && !strcmp(answer,"COMMUNICATIONERROR") )
+        DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
+    return answer;
 }
 
 char* AUDFOCUSER::sendRequest(const char *fmt, ... )
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc,retries;
-    zmq_pollitem_t item;
+    char buffer[4096], *answer;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    retries = 3;
-    do {
-        zmq_send(requester, buffer, strlen(buffer), 0);
-        item = { requester, 0, ZMQ_POLLIN, 0 };
-        rc = zmq_poll( &item, 1, 500 ); // ms
-        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) ) {
-            // communication succeeded
-            rc = zmq_recv(requester, answer, sizeof(answer), 0);
-            if ( rc >= 0 ) {
-                pthread_mutex_unlock( &connectionmutex );
-                answer[MIN(rc,(int)sizeof(answer)-1)] = '\0';
-                return strdup(answer);
-            }
-        }
-        zmq_close(requester);
-        requester = zmq_socket(context, ZMQ_REQ);
-        snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-        zmq_connect(requester, addr);
-    } while ( --retries );
-    pthread_mutex_unlock( &connectionmutex );
-    DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
-    return strdup("COMMUNICATIONERROR");
+    answer = client->request(buffer);
+    if ( answer && !strcmp(answer,"COMMUNICATIONERROR") )
+        DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
+    return answer;
 }
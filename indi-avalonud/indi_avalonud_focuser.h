@@ -20,8 +20,8 @@
 
 #pragma once
 
-#include <pthread.h>
 #include "indifocuser.h"
+#include "indi_avalonud_client.h"
 
 #define MIN(a,b) (((a)<=(b))?(a):(b))
 
@@ -75,9 +75,8 @@ private:
     char* sendCommand(const char*,...);
     char* sendRequest(const char*,...);
 
-    void *context,*requester;
+    void *context;
+    AUDClient *client;
     int64_t currentPosition;
     int statusCode;
-
-    pthread_mutex_t connectionmutex;
 };
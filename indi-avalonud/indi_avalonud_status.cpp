@@ -0,0 +1,87 @@
+/*
+    Avalon Unified Driver status decoding
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "indi_avalonud_status.h"
+
+#ifdef _USE_SYSTEM_JSONLIB
+#include <nlohmann/json.hpp>
+#else
+#include <indijson.hpp>
+#endif
+
+
+using json = nlohmann::json;
+
+bool aud_decode_telescope_status(const char *answer, AUDTelescopeStatus &status)
+{
+    if ( !answer )
+        return false;
+
+    json j = json::parse(answer, nullptr, false);
+    if ( j.is_discarded() || !j.is_object() )
+        return false;
+
+    try
+    {
+        j.at("UTC").get_to(status.utc);
+        j.at("JD").get_to(status.jd);
+        j.at("LST").get_to(status.lst);
+        j.at("HA").get_to(status.ha);
+        j.at("RA").get_to(status.ra);
+        j.at("Dec").get_to(status.dec);
+        j.at("Az").get_to(status.az);
+        j.at("Alt").get_to(status.alt);
+        j.at("globalStatus").get_to(status.globalStatus);
+        j.at("meridianFlip").get_to(status.meridianFlip);
+        j.at("pierSide").get_to(status.pierSide);
+        j.at("meridianFlipHA").get_to(status.meridianFlipHA);
+        j.at("exposureReady").get_to(status.exposureReady);
+        status.hasErrorMsg = j.contains("errorMsg");
+        if ( status.hasErrorMsg )
+            j["errorMsg"].get_to(status.errorMsg);
+    }
+    catch ( json::exception & )
+    {
+        // A member is missing or of another type
+        return false;
+    }
+    return true;
+}
+
+bool aud_decode_focuser_status(const char *answer, AUDFocuserStatus &status)
+{
+    if ( !answer )
+        return false;
+
+    json j = json::parse(answer, nullptr, false);
+    if ( j.is_discarded() || !j.is_object() )
+        return false;
+
+    try
+    {
+        j.at("position_step").get_to(status.position);
+        j.at("statusCode").get_to(status.statusCode);
+    }
+    catch ( json::exception & )
+    {
+        return false;
+    }
+    return true;
+}
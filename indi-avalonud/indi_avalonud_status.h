@@ -0,0 +1,55 @@
+/*
+    Avalon Unified Driver status decoding
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/*
+    The status answers polled every second, decoded into the fields the drivers use. Other members are ignored.
+ */
+
+// Answer to ASTRO_STATUS
+struct AUDTelescopeStatus
+{
+    double utc { 0 }, jd { 0 }, lst { 0 };
+    double ha { 0 }, ra { 0 }, dec { 0 };
+    double az { 0 }, alt { 0 };
+    double meridianFlipHA { 0 };
+    int globalStatus { 0 };
+    int meridianFlip { 0 };
+    int pierSide { 0 };
+    int exposureReady { 0 };
+    // errorMsg is optional
+    bool hasErrorMsg { false };
+    std::string errorMsg;
+};
+
+// Answer to STATUS of a stepMachine driver
+struct AUDFocuserStatus
+{
+    int64_t position { 0 };
+    int statusCode { 0 };
+};
+
+// False if answer is not a JSON object with all the required members, of the expected types
+bool aud_decode_telescope_status(const char *answer, AUDTelescopeStatus &status);
+bool aud_decode_focuser_status(const char *answer, AUDFocuserStatus &status);
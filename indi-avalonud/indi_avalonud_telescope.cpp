@@ -44,6 +44,7 @@
 #include <zmq.h>
 
 #include "indi_avalonud_telescope.h"
+#include "indi_avalonud_status.h"
 
 
 using json = nlohmann::json;
@@ -113,6 +114,7 @@ AUDTELESCOPE::AUDTELESCOPE() : GI(this)
     setVersion(AVALONUD_VERSION_MAJOR, AVALONUD_VERSION_MINOR);
 
     context = zmq_ctx_new();
+    client = new AUDClient(context);
     setTelescopeConnection( CONNECTION_NONE );
     SetTelescopeCapability( TELESCOPE_CAN_GOTO |
                             TELESCOPE_CAN_SYNC |
@@ -134,6 +136,7 @@ AUDTELESCOPE::AUDTELESCOPE() : GI(this)
 *****************************************************************/
 AUDTELESCOPE::~AUDTELESCOPE()
 {
+    delete client;
     //    zmq_ctx_term(context);
 }
 
@@ -236,8 +239,6 @@ bool AUDTELESCOPE::initProperties()
     addDebugControl();
     addConfigurationControl();
 
-    pthread_mutex_init( &connectionmutex, NULL );
-
     return true;
 }
 
@@ -313,7 +314,6 @@ bool AUDTELESCOPE::Connect()
 {
     char *answer;
     char addr[1024];
-    int timeout = 500;
 
 
     if (isConnected())
@@ -323,10 +323,8 @@ bool AUDTELESCOPE::Connect()
 
     DEBUGF(INDI::Logger::DBG_SESSION, "Attempting to connect %s telescope...", IPaddress);
 
-    requester = zmq_socket(context, ZMQ_REQ);
-    zmq_setsockopt(requester, ZMQ_RCVTIMEO, &timeout, sizeof(timeout) );
     snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-    zmq_connect(requester, addr);
+    client->connect(addr);
 
     answer = sendRequest("ASTRO_INFO");
     if ( answer )
@@ -345,7 +343,7 @@ bool AUDTELESCOPE::Connect()
                 !j.contains("highLevelSW") ||
                 !j.contains("highLevelSWVersion") )
         {
-            zmq_close(requester);
+            client->disconnect();
             DEBUGF(INDI::Logger::DBG_ERROR, "Communication with %s telescope failed", IPaddress);
             free(IPaddress);
             return false;
@@ -373,7 +371,7 @@ bool AUDTELESCOPE::Connect()
     }
     else
     {
-        zmq_close(requester);
+        client->disconnect();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
         free(IPaddress);
         return false;
@@ -388,7 +386,7 @@ bool AUDTELESCOPE::Connect()
     }
     else
     {
-        zmq_close(requester);
+        client->disconnect();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
         free(IPaddress);
         return false;
@@ -410,7 +408,7 @@ bool AUDTELESCOPE::Connect()
     }
     else
     {
-        zmq_close(requester);
+        client->disconnect();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
         free(IPaddress);
         return false;
@@ -428,7 +426,7 @@ bool AUDTELESCOPE::Connect()
                 !j.contains("latitude") ||
                 !j.contains("elevation") )
         {
-            zmq_close(requester);
+            client->disconnect();
             DEBUGF(INDI::Logger::DBG_ERROR, "Communication with %s telescope failed", IPaddress);
             free(IPaddress);
             return false;
@@ -440,7 +438,7 @@ bool AUDTELESCOPE::Connect()
     }
     else
     {
-        zmq_close(requester);
+        client->disconnect();
         DEBUGF(INDI::Logger::DBG_ERROR, "Failed to connect %s telescope", IPaddress);
         free(IPaddress);
         return false;
@@ -467,7 +465,7 @@ bool AUDTELESCOPE::Disconnect()
 
     DEBUG(INDI::Logger::DBG_SESSION, "Attempting to disconnect telescope...");
 
-    zmq_close(requester);
+    client->disconnect();
 
     RemoveTimer( tid );
 
@@ -645,52 +643,25 @@ bool AUDTELESCOPE::updateTime(ln_date *utc, double utc_offset)
 bool AUDTELESCOPE::ReadScopeStatus()
 {
     char *answer;
-    int sts, pierside, exposureready, meridianflip;
-    double utc, lst, jd, ha, ra, dec, az, alt, meridianflipha;
+    AUDTelescopeStatus status;
 
 
     answer = sendRequest("ASTRO_STATUS");
     if ( answer )
     {
-        json j;
-
-        j = json::parse(answer, nullptr, false);
+        bool decoded = aud_decode_telescope_status(answer, status);
         free(answer);
-        if ( j.is_discarded() ||
-                !j.contains("UTC") ||
-                !j.contains("JD") ||
-                !j.contains("LST") ||
-                !j.contains("HA") ||
-                !j.contains("RA") ||
-                !j.contains("Dec") ||
-                !j.contains("Az") ||
-                !j.contains("Alt") ||
-                !j.contains("globalStatus") ||
-                !j.contains("meridianFlip") ||
-                !j.contains("pierSide") ||
-                !j.contains("meridianFlipHA") ||
-                !j.contains("exposureReady") )
+        if ( !decoded )
         {
             DEBUG(INDI::Logger::DBG_WARNING, "Status communication error");
             return false;
         }
-        j["UTC"].get_to(utc);
-        j["JD"].get_to(jd);
-        j["LST"].get_to(lst);
-        j["HA"].get_to(ha);
-        j["RA"].get_to(ra);
-        j["Dec"].get_to(dec);
-        j["Az"].get_to(az);
-        j["Alt"].get_to(alt);
-        j["globalStatus"].get_to(sts);
-        j["meridianFlip"].get_to(meridianflip);
-        j["pierSide"].get_to(pierside);
-        j["meridianFlipHA"].get_to(meridianflipha);
-        j["exposureReady"].get_to(exposureready);
-        if ( j.contains("errorMsg") )
+        int sts = status.globalStatus, pierside = status.pierSide, meridianflip = status.meridianFlip;
+        double utc = status.utc, lst = status.lst, jd = status.jd, ha = status.ha, ra = status.ra, dec = status.dec;
+        double az = status.az, alt = status.alt, meridianflipha = status.meridianFlipHA;
+        if ( status.hasErrorMsg )
         {
-            std::string msg;
-            j["errorMsg"].get_to(msg);
+            const std::string &msg = status.errorMsg;
             if ( msg.length() > 0 )
             {
                 if ( !lastErrorMsg || ( lastErrorMsg && strcmp(msg.c_str(), lastErrorMsg) ) )
@@ -1153,7 +1124,6 @@ bool AUDTELESCOPE::SetTrackEnabled(bool enabled)
 
 bool AUDTELESCOPE::MoveNS(INDI_DIR_NS dir, TelescopeMotionCommand command)
 {
-    char *answer = NULL;
     string speed[] = {"SLEWGUIDE", "SLEWCENTER", "SLEWFIND", "SLEWMAX"};
     int speedIndex;
 
@@ -1165,40 +1135,29 @@ bool AUDTELESCOPE::MoveNS(INDI_DIR_NS dir, TelescopeMotionCommand command)
     }
 
     speedIndex = SlewRateSP.findOnSwitchIndex();
-    MovementNSSP.setState(IPS_BUSY);
     if ( command == MOTION_START )
     {
         // force tracking after motion
         fTracking = true;
         if ( dir == DIRECTION_NORTH )
-            answer = sendCommand("ASTRO_SLEW * (%.8f+%s)", trackspeeddec / 3600.0, speed[speedIndex].c_str());
+            motionAnswer[0] = postCommand("ASTRO_SLEW * (%.8f+%s)", trackspeeddec / 3600.0, speed[speedIndex].c_str());
         else
-            answer = sendCommand("ASTRO_SLEW * (%.8f-%s)", trackspeeddec / 3600.0, speed[speedIndex].c_str());
+            motionAnswer[0] = postCommand("ASTRO_SLEW * (%.8f-%s)", trackspeeddec / 3600.0, speed[speedIndex].c_str());
     }
     else
     {
         if ( fTracking )
-            answer = sendCommand("ASTRO_TRACK * %.8f", trackspeeddec / 3600.0);
+            motionAnswer[0] = postCommand("ASTRO_TRACK * %.8f", trackspeeddec / 3600.0);
         else
-            answer = sendCommand("ASTRO_SLEW * 0");
+            motionAnswer[0] = postCommand("ASTRO_SLEW * 0");
     }
-    if ( !answer )
-    {
-        if ( command == MOTION_START )
-            MovementNSSP.setState(IPS_OK);
-        else
-            MovementNSSP.setState(IPS_IDLE);
-        return true;
-    }
-    MovementNSSP.setState(IPS_ALERT);
-    DEBUGF(INDI::Logger::DBG_WARNING, "MoveNS command failed due to %s", answer);
-    free(answer);
-    return false;
+    // The base class reports the motion as started or stopped, a failure is reported when the answer comes in
+    watchAnswers();
+    return true;
 }
 
 bool AUDTELESCOPE::MoveWE(INDI_DIR_WE dir, TelescopeMotionCommand command)
 {
-    char *answer = NULL;
     string speed[] = {"SLEWGUIDE", "SLEWCENTER", "SLEWFIND", "SLEWMAX"};
     int speedIndex;
 
@@ -1210,42 +1169,29 @@ bool AUDTELESCOPE::MoveWE(INDI_DIR_WE dir, TelescopeMotionCommand command)
     }
 
     speedIndex = SlewRateSP.findOnSwitchIndex();
-    MovementWESP.setState(IPS_BUSY);
     if ( command == MOTION_START )
     {
         // force tracking after motion
         fTracking = true;
         if ( dir == DIRECTION_WEST )
-            answer = sendCommand("ASTRO_SLEW (%.8f+%s) *", trackspeedra / 3600.0, speed[speedIndex].c_str());
+            motionAnswer[1] = postCommand("ASTRO_SLEW (%.8f+%s) *", trackspeedra / 3600.0, speed[speedIndex].c_str());
         else
-            answer = sendCommand("ASTRO_SLEW (%.8f-%s) *", trackspeedra / 3600.0, speed[speedIndex].c_str());
+            motionAnswer[1] = postCommand("ASTRO_SLEW (%.8f-%s) *", trackspeedra / 3600.0, speed[speedIndex].c_str());
     }
     else
     {
         if ( fTracking )
-            answer = sendCommand("ASTRO_TRACK %.8f *", trackspeedra / 3600.0);
+            motionAnswer[1] = postCommand("ASTRO_TRACK %.8f *", trackspeedra / 3600.0);
         else
-            answer = sendCommand("ASTRO_SLEW 0 *");
+            motionAnswer[1] = postCommand("ASTRO_SLEW 0 *");
     }
-    if ( !answer )
-    {
-        if ( command == MOTION_START )
-            MovementWESP.setState(IPS_OK);
-        else
-            MovementWESP.setState(IPS_IDLE);
-        return true;
-    }
-    MovementWESP.setState(IPS_ALERT);
-    DEBUGF(INDI::Logger::DBG_WARNING, "MoveWE command failed due to %s", answer);
-    free(answer);
-    return false;
+    // The base class reports the motion as started or stopped, a failure is reported when the answer comes in
+    watchAnswers();
+    return true;
 }
 
 IPState AUDTELESCOPE::GuideNorth(uint32_t ms)
 {
-    char *answer = NULL;
-    IPState rc;
-
     if (!isConnected())
     {
         DEBUG(INDI::Logger::DBG_WARNING, "GuideNorth called before driver connection");
@@ -1255,26 +1201,14 @@ IPState AUDTELESCOPE::GuideNorth(uint32_t ms)
     if ( ms == 0 )
         return IPS_OK;
 
-    answer = sendCommand("ASTRO_GUIDE * %u", ms);
-    if ( !answer )
-    {
-        rc = IPS_OK;
-    }
-    else
-    {
-        rc = IPS_ALERT;
-        DEBUGF(INDI::Logger::DBG_WARNING, "GuideNorth command failed due to %s", answer);
-        free(answer);
-    }
-    GuideComplete(INDI_EQ_AXIS::AXIS_DE);
-    return rc;
+    // GuideComplete() is called when the server answers
+    guideAnswer[INDI_EQ_AXIS::AXIS_DE] = postCommand("ASTRO_GUIDE * %u", ms);
+    watchAnswers();
+    return IPS_BUSY;
 }
 
 IPState AUDTELESCOPE::GuideSouth(uint32_t ms)
 {
-    char *answer = NULL;
-    IPState rc;
-
     if (!isConnected())
     {
         DEBUG(INDI::Logger::DBG_WARNING, "GuideSouth called before driver connection");
@@ -1284,26 +1218,14 @@ IPState AUDTELESCOPE::GuideSouth(uint32_t ms)
     if ( ms == 0 )
         return IPS_OK;
 
-    answer = sendCommand("ASTRO_GUIDE * -%u", ms);
-    if ( !answer )
-    {
-        rc = IPS_OK;
-    }
-    else
-    {
-        rc = IPS_ALERT;
-        DEBUGF(INDI::Logger::DBG_WARNING, "GuideSouth command failed due to %s", answer);
-        free(answer);
-    }
-    GuideComplete(INDI_EQ_AXIS::AXIS_DE);
-    return rc;
+    // GuideComplete() is called when the server answers
+    guideAnswer[INDI_EQ_AXIS::AXIS_DE] = postCommand("ASTRO_GUIDE * -%u", ms);
+    watchAnswers();
+    return IPS_BUSY;
 }
 
 IPState AUDTELESCOPE::GuideEast(uint32_t ms)
 {
-    char *answer = NULL;
-    IPState rc;
-
     if (!isConnected())
     {
         DEBUG(INDI::Logger::DBG_WARNING, "GuideEast called before driver connection");
@@ -1313,26 +1235,14 @@ IPState AUDTELESCOPE::GuideEast(uint32_t ms)
     if ( ms == 0 )
         return IPS_OK;
 
-    answer = sendCommand("ASTRO_GUIDE %u *", ms);
-    if ( !answer )
-    {
-        rc = IPS_OK;
-    }
-    else
-    {
-        rc = IPS_ALERT;
-        DEBUGF(INDI::Logger::DBG_WARNING, "GuideEast command failed due to %s", answer);
-        free(answer);
-    }
-    GuideComplete(INDI_EQ_AXIS::AXIS_RA);
-    return rc;
+    // GuideComplete() is called when the server answers
+    guideAnswer[INDI_EQ_AXIS::AXIS_RA] = postCommand("ASTRO_GUIDE %u *", ms);
+    watchAnswers();
+    return IPS_BUSY;
 }
 
 IPState AUDTELESCOPE::GuideWest(uint32_t ms)
 {
-    char *answer = NULL;
-    IPState rc;
-
     if (!isConnected())
     {
         DEBUG(INDI::Logger::DBG_WARNING, "GuideWest called before driver connection");
@@ -1342,19 +1252,10 @@ IPState AUDTELESCOPE::GuideWest(uint32_t ms)
     if ( ms == 0 )
         return IPS_OK;
 
-    answer = sendCommand("ASTRO_GUIDE -%u *", ms);
-    if ( !answer )
-    {
-        rc = IPS_OK;
-    }
-    else
-    {
-        rc = IPS_ALERT;
-        DEBUGF(INDI::Logger::DBG_WARNING, "GuideWest command failed due to %s", answer);
-        free(answer);
-    }
-    GuideComplete(INDI_EQ_AXIS::AXIS_RA);
-    return rc;
+    // GuideComplete() is called when the server answers
+    guideAnswer[INDI_EQ_AXIS::AXIS_RA] = postCommand("ASTRO_GUIDE -%u *", ms);
+    watchAnswers();
+    return IPS_BUSY;
 }
 
 bool AUDTELESCOPE::Abort()
@@ -1387,6 +1288,64 @@ bool AUDTELESCOPE::Abort()
     return true;
 }
 
+void AUDTELESCOPE::watchAnswers()
+{
+    if ( answerTimer < 0 )
+        answerTimer = IEAddTimer(ANSWER_POLL_MS, answerTimerHelper, this);
+}
+
+void AUDTELESCOPE::answerTimerHelper(void *context)
+{
+    static_cast<AUDTELESCOPE *>(context)->checkAnswers();
+}
+
+void AUDTELESCOPE::checkAnswers()
+{
+    const char *guideName[] = { "Guide East/West", "Guide North/South" };
+    const char *motionName[] = { "MoveNS", "MoveWE" };
+    INDI::PropertySwitch *motion[] = { &MovementNSSP, &MovementWESP };
+    bool waiting = false;
+    char *answer;
+
+    answerTimer = -1;
+    for ( int axis = 0; axis < 2; axis++ )
+    {
+        if ( guideAnswer[axis].valid() )
+        {
+            if ( guideAnswer[axis].wait_for(std::chrono::seconds(0)) != std::future_status::ready )
+                waiting = true;
+            else
+            {
+                answer = AUDClient::commandAnswer(guideAnswer[axis].get());
+                if ( answer )
+                {
+                    DEBUGF(INDI::Logger::DBG_WARNING, "%s command failed due to %s", guideName[axis], answer);
+                    free(answer);
+                }
+                GuideComplete(static_cast<INDI_EQ_AXIS>(axis));
+            }
+        }
+        if ( motionAnswer[axis].valid() )
+        {
+            if ( motionAnswer[axis].wait_for(std::chrono::seconds(0)) != std::future_status::ready )
+                waiting = true;
+            else
+            {
+                answer = AUDClient::commandAnswer(motionAnswer[axis].get());
+                if ( answer )
+                {
+                    motion[axis]->setState(IPS_ALERT);
+                    motion[axis]->apply();
+                    DEBUGF(INDI::Logger::DBG_WARNING, "%s command failed due to %s", motionName[axis], answer);
+                    free(answer);
+                }
+            }
+        }
+    }
+    if ( waiting )
+        watchAnswers();
+}
+
 void AUDTELESCOPE::TimerHit()
 {
     if (isConnected() == false)
@@ -1415,122 +1374,56 @@ const char *AUDTELESCOPE::getDefaultName()
 char* AUDTELESCOPE::sendCommand(const char *fmt, ...)
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc, retries;
-    zmq_pollitem_t item;
+    char buffer[4096], *answer;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    retries = 3;
-    do
-    {
-        zmq_send(requester, buffer, strlen(buffer), 0);
-        item = { requester, 0, ZMQ_POLLIN, 0 };
-        rc = zmq_poll( &item, 1, 500 ); // ms
-        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) )
-        {
-            // communication succeeded
-            rc = zmq_recv(requester, answer, sizeof(answer), 0);
-            if ( rc >= 0 )
-            {
-                pthread_mutex_unlock( &connectionmutex );
-                answer[MIN(rc, (int)sizeof(answer) - 1)] = '\0';
-                if ( !strncmp(answer, "OK", 2) )
-                    return NULL;
-                if ( !strncmp(answer, "ERROR:", 6) )
-                    return strdup(answer + 6);
-                return strdup("SYNTAXERROR");
-            }
-        }
-        zmq_close(requester);
-        requester = zmq_socket(context, ZMQ_REQ);
-        snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-        zmq_connect(requester, addr);
-    }
-    while ( --retries );
-    pthread_mutex_unlock( &connectionmutex );
-    DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
-    return strdup("COMMUNICATIONERROR");
+    answer = client->command(buffer);
+    if ( answer && !strcmp(answer, "COMMUNICATIONERROR") )
+        DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
+    return answer;
 }
 
 char* AUDTELESCOPE::sendCommandOnce(const char *fmt, ...)
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc;
-    zmq_pollitem_t item;
+    char buffer[4096], *answer;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    zmq_send(requester, buffer, strlen(buffer), 0);
-    item = { requester, 0, ZMQ_POLLIN, 0 };
-    rc = zmq_poll( &item, 1, 500 ); // ms
-    if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) )
-    {
-        // communication succeeded
-        rc = zmq_recv(requester, answer, sizeof(answer), 0);
-        if ( rc >= 0 )
-        {
-            pthread_mutex_unlock( &connectionmutex );
-            answer[MIN(rc, (int)sizeof(answer) - 1)] = '\0';
-            if ( !strncmp(answer, "OK", 2) )
-                return NULL;
-            if ( !strncmp(answer, "ERROR:", 6) )
-                return strdup(answer + 6);
-            return strdup("SYNTAXERROR");
-        }
-    }
-    zmq_close(requester);
-    requester = zmq_socket(context, ZMQ_REQ);
-    snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-    zmq_connect(requester, addr);
-    pthread_mutex_unlock( &connectionmutex );
-    DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
-    return strdup("COMMUNICATIONERROR");
+    answer = client->command(buffer, 1);
+    if ( answer && !strcmp(answer, "COMMUNICATIONERROR") )
+        DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
+    return answer;
+}
+
+std::future<AUDAnswer> AUDTELESCOPE::postCommand(const char *fmt, ...)
+{
+    va_list ap;
+    char buffer[4096];
+
+    va_start( ap, fmt );
+    vsnprintf( buffer, sizeof(buffer), fmt, ap );
+    va_end( ap );
+
+    return client->submit(buffer);
 }
 
 char* AUDTELESCOPE::sendRequest(const char *fmt, ...)
 {
     va_list ap;
-    char buffer[4096], answer[4096], addr[1024];
-    int rc, retries;
-    zmq_pollitem_t item;
+    char buffer[4096], *answer;
 
     va_start( ap, fmt );
     vsnprintf( buffer, sizeof(buffer), fmt, ap );
     va_end( ap );
 
-    pthread_mutex_lock( &connectionmutex );
-    retries = 3;
-    do
-    {
-        zmq_send(requester, buffer, strlen(buffer), 0);
-        item = { requester, 0, ZMQ_POLLIN, 0 };
-        rc = zmq_poll( &item, 1, 500 ); // ms
-        if ( ( rc >= 0 ) && ( item.revents & ZMQ_POLLIN ) )
-        {
-            // communication succeeded
-            rc = zmq_recv(requester, answer, sizeof(answer), 0);
-            if ( rc >= 0 )
-            {
-                pthread_mutex_unlock( &connectionmutex );
-                answer[MIN(rc, (int)sizeof(answer) - 1)] = '\0';
-                return strdup(answer);
-            }
-        }
-        zmq_close(requester);
-        requester = zmq_socket(context, ZMQ_REQ);
-        snprintf( addr, sizeof(addr), "tcp://%s:%d", IPaddress, IPport );
-        zmq_connect(requester, addr);
-    }
-    while ( --retries );
-    pthread_mutex_unlock( &connectionmutex );
-    DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
-    return strdup("COMMUNICATIONERROR");
+    answer = client->request(buffer);
+    if ( answer && !strcmp(answer, "COMMUNICATIONERROR") )
+        DEBUG(INDI::Logger::DBG_WARNING, "No answer from driver");
+    return answer;
 }
@@ -26,11 +26,14 @@
 #include <indidevapi.h>
 #include <inditelescope.h>
 #include <indiguiderinterface.h>
-#include <pthread.h>
+#include "indi_avalonud_client.h"
 
 
 #define MIN(a,b) (((a)<=(b))?(a):(b))
 
+// Period of the checks for the answers of guide pulses and manual motions
+#define ANSWER_POLL_MS 20
+
 
 using namespace std;
 
@@ -172,10 +175,18 @@ private:
     char* sendCommandOnce(const char*,...);
     char* sendRequest(const char*,...);
 
-    void *context,*requester;
+    // Guide pulses and manual motions are not waited for, their answers are checked from an event loop timer
+    std::future<AUDAnswer> postCommand(const char*,...);
+    std::future<AUDAnswer> guideAnswer[2];
+    std::future<AUDAnswer> motionAnswer[2];
+    int answerTimer { -1 };
+    void watchAnswers();
+    void checkAnswers();
+    static void answerTimerHelper(void *context);
+
+    void *context;
+    AUDClient *client;
     char *lastErrorMsg;
-
-    pthread_mutex_t connectionmutex;
 };
 
 #endif
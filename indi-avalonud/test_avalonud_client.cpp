@@ -0,0 +1,429 @@
+/*
+    Avalon Unified Driver client tests, against an in-process mock server
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <zmq.h>
+
+#include "indi_avalonud_client.h"
+#include "indi_avalonud_status.h"
+
+using namespace std::chrono;
+
+static const char *STATUS_ANSWER =
+    "{\"UTC\":12.5,\"JD\":2461000.02,\"LST\":3.25,\"HA\":-1.5,\"RA\":4.75,\"Dec\":-12.125,"
+    "\"Az\":180.5,\"Alt\":45.25,\"globalStatus\":2,\"meridianFlip\":true,\"pierSide\":1,"
+    "\"meridianFlipHA\":0.5,\"exposureReady\":0,\"motors\":{\"ra\":[1,2,{\"x\":\"}\"}],\"dec\":null},"
+    "\"errorMsg\":\"\"}";
+
+/*
+    Answers like the REP socket of a StarGO server: one request at a time, in the order they arrive, each after the
+    latency of its command. Bound to a ROUTER socket so that the envelopes can be checked.
+ */
+class MockServer
+{
+public:
+    MockServer(void *context, const char *endpoint)
+    {
+        int linger = 0;
+        socket = zmq_socket(context, ZMQ_ROUTER);
+        zmq_setsockopt(socket, ZMQ_LINGER, &linger, sizeof(linger));
+        zmq_bind(socket, endpoint);
+        worker = std::thread(&MockServer::run, this);
+    }
+
+    ~MockServer()
+    {
+        running = false;
+        worker.join();
+        zmq_close(socket);
+    }
+
+    // Commands starting with prefix are answered after latency
+    void setLatency(const std::string &prefix, milliseconds latency)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        latencies[prefix] = latency;
+    }
+
+    int received()
+    {
+        return count;
+    }
+
+private:
+    struct Reply
+    {
+        steady_clock::time_point due;
+        std::vector<std::string> envelope;
+        std::string answer;
+    };
+
+    static std::string answerTo(const std::string &request)
+    {
+        if ( request == "ASTRO_STATUS" )
+            return STATUS_ANSWER;
+        if ( request.compare(0, 4, "FAIL") == 0 )
+            return "ERROR:failed";
+        if ( request.compare(0, 4, "ECHO") == 0 )
+            return request;
+        return "OK";
+    }
+
+    void run()
+    {
+        std::vector<Reply> replies;
+
+        while ( running )
+        {
+            zmq_pollitem_t item = { socket, 0, ZMQ_POLLIN, 0 };
+            zmq_poll(&item, 1, 1);
+
+            // The next request is only read once the one before is answered
+            if ( replies.empty() && ( item.revents & ZMQ_POLLIN ) )
+            {
+                std::vector<std::string> frames;
+                int more = 1;
+                while ( more )
+                {
+                    char buffer[4096];
+                    size_t moresize = sizeof(more);
+                    int rc = zmq_recv(socket, buffer, sizeof(buffer), 0);
+                    frames.emplace_back(buffer, std::min<size_t>(rc, sizeof(buffer)));
+                    zmq_getsockopt(socket, ZMQ_RCVMORE, &more, &moresize);
+                }
+                count++;
+
+                Reply reply;
+                std::string request = frames.back();
+                frames.pop_back();
+                reply.envelope = frames;
+                reply.answer = answerTo(request);
+                reply.due = steady_clock::now();
+                std::lock_guard<std::mutex> guard(lock);
+                for ( auto &latency : latencies )
+                    if ( request.compare(0, latency.first.size(), latency.first) == 0 )
+                        reply.due += latency.second;
+                replies.push_back(reply);
+            }
+
+            if ( !replies.empty() && replies.front().due <= steady_clock::now() )
+            {
+                for ( auto &frame : replies.front().envelope )
+                    zmq_send(socket, frame.data(), frame.size(), ZMQ_SNDMORE);
+                zmq_send(socket, replies.front().answer.data(), replies.front().answer.size(), 0);
+                replies.clear();
+            }
+        }
+    }
+
+    void *socket;
+    std::thread worker;
+    std::atomic_bool running { true };
+    std::atomic_int count { 0 };
+    std::mutex lock;
+    std::map<std::string, milliseconds> latencies;
+};
+
+class AUDClientTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        context = zmq_ctx_new();
+        server.reset(new MockServer(context, "inproc://mock-stargo"));
+        client.reset(new AUDClient(context));
+        ASSERT_TRUE(client->connect("inproc://mock-stargo"));
+    }
+
+    void TearDown() override
+    {
+        client.reset();
+        server.reset();
+        zmq_ctx_term(context);
+    }
+
+    void *context;
+    std::unique_ptr<MockServer> server;
+    std::unique_ptr<AUDClient> client;
+};
+
+TEST_F(AUDClientTest, RequestAndCommand)
+{
+    char *answer = client->request("ECHO hello");
+    ASSERT_NE(answer, nullptr);
+    EXPECT_STREQ(answer, "ECHO hello");
+    free(answer);
+
+    EXPECT_EQ(client->command("ASTRO_GUIDE * 100"), nullptr);
+
+    answer = client->command("FAIL");
+    ASSERT_NE(answer, nullptr);
+    EXPECT_STREQ(answer, "failed");
+    free(answer);
+
+    answer = client->command("ECHO not a command answer");
+    ASSERT_NE(answer, nullptr);
+    EXPECT_STREQ(answer, "SYNTAXERROR");
+    free(answer);
+}
+
+TEST_F(AUDClientTest, AnswersRoutedToTheirRequests)
+{
+    server->setLatency("ECHO slow", milliseconds(50));
+
+    // Queued without waiting for the answers before them
+    auto slow = client->submit("ECHO slow");
+    std::vector<std::future<AUDAnswer>> fast;
+    for ( int i = 0; i < 20; i++ )
+        fast.push_back(client->submit("ECHO fast " + std::to_string(i)));
+
+    AUDAnswer answer = slow.get();
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(*answer, "ECHO slow");
+    for ( int i = 0; i < 20; i++ )
+    {
+        answer = fast[i].get();
+        ASSERT_TRUE(answer);
+        EXPECT_EQ(*answer, "ECHO fast " + std::to_string(i));
+    }
+    EXPECT_EQ(client->inFlight(), 0u);
+    EXPECT_EQ(server->received(), 21);
+}
+
+TEST_F(AUDClientTest, CommandAnswer)
+{
+    EXPECT_EQ(AUDClient::commandAnswer(client->submit("ASTRO_GUIDE * 100").get()), nullptr);
+
+    char *answer = AUDClient::commandAnswer(client->submit("FAIL").get());
+    EXPECT_STREQ(answer, "failed");
+    free(answer);
+
+    answer = AUDClient::commandAnswer(std::nullopt);
+    EXPECT_STREQ(answer, "COMMUNICATIONERROR");
+    free(answer);
+}
+
+TEST_F(AUDClientTest, LateAnswerIsDropped)
+{
+    server->setLatency("ECHO late", milliseconds(150));
+
+    EXPECT_FALSE(client->submit("ECHO late", milliseconds(20)).get());
+    EXPECT_EQ(client->inFlight(), 0u);
+
+    // The late answer comes in while nothing waits for it any more
+    std::this_thread::sleep_for(milliseconds(200));
+    AUDAnswer answer = client->submit("ECHO after").get();
+    ASSERT_TRUE(answer);
+    EXPECT_EQ(*answer, "ECHO after");
+}
+
+TEST_F(AUDClientTest, RetriesAfterTimeout)
+{
+    server->setLatency("ECHO", milliseconds(600));
+
+    char *answer = client->request("ECHO", 2);
+    EXPECT_STREQ(answer, "COMMUNICATIONERROR");
+    free(answer);
+    EXPECT_EQ(server->received(), 2);
+}
+
+TEST_F(AUDClientTest, ConcurrentCallers)
+{
+    std::vector<std::thread> callers;
+    std::atomic_int wrong { 0 };
+
+    server->setLatency("ECHO 0", milliseconds(2));
+    for ( int t = 0; t < 4; t++ )
+    {
+        callers.emplace_back([&, t]()
+        {
+            for ( int i = 0; i < 50; i++ )
+            {
+                std::string request = "ECHO " + std::to_string(t) + " " + std::to_string(i);
+                char *answer = client->request(request.c_str());
+                if ( strcmp(answer, request.c_str()) )
+                    wrong++;
+                free(answer);
+            }
+        });
+    }
+    for ( auto &caller : callers )
+        caller.join();
+
+    EXPECT_EQ(wrong, 0);
+}
+
+TEST(AUDClient, RepServer)
+{
+    // The envelope with the request identifier goes through a plain REP server untouched
+    void *context = zmq_ctx_new();
+    void *rep = zmq_socket(context, ZMQ_REP);
+    zmq_bind(rep, "inproc://rep-server");
+    std::thread server([rep]()
+    {
+        for ( int i = 0; i < 3; i++ )
+        {
+            char buffer[256];
+            int rc = zmq_recv(rep, buffer, sizeof(buffer), 0);
+            std::string answer = "OK:" + std::string(buffer, rc);
+            zmq_send(rep, answer.data(), answer.size(), 0);
+        }
+    });
+
+    {
+        AUDClient client(context);
+        ASSERT_TRUE(client.connect("inproc://rep-server"));
+        auto first = client.submit("ASTRO_GETMOUNTMODE");
+        auto second = client.submit("ASTRO_GETMERIDIANFLIPHA");
+        auto third = client.submit("ASTRO_INFO");
+        EXPECT_EQ(*first.get(), "OK:ASTRO_GETMOUNTMODE");
+        EXPECT_EQ(*second.get(), "OK:ASTRO_GETMERIDIANFLIPHA");
+        EXPECT_EQ(*third.get(), "OK:ASTRO_INFO");
+    }
+
+    server.join();
+    zmq_close(rep);
+    zmq_ctx_term(context);
+}
+
+TEST(AUDClient, NotConnected)
+{
+    void *context = zmq_ctx_new();
+    {
+        AUDClient client(context);
+        EXPECT_FALSE(client.submit("ASTRO_STATUS").get());
+    }
+    zmq_ctx_term(context);
+}
+
+TEST(AUDStatus, Telescope)
+{
+    AUDTelescopeStatus status;
+
+    ASSERT_TRUE(aud_decode_telescope_status(STATUS_ANSWER, status));
+    EXPECT_DOUBLE_EQ(status.utc, 12.5);
+    EXPECT_DOUBLE_EQ(status.jd, 2461000.02);
+    EXPECT_DOUBLE_EQ(status.lst, 3.25);
+    EXPECT_DOUBLE_EQ(status.ha, -1.5);
+    EXPECT_DOUBLE_EQ(status.ra, 4.75);
+    EXPECT_DOUBLE_EQ(status.dec, -12.125);
+    EXPECT_DOUBLE_EQ(status.az, 180.5);
+    EXPECT_DOUBLE_EQ(status.alt, 45.25);
+    EXPECT_EQ(status.globalStatus, 2);
+    EXPECT_EQ(status.meridianFlip, 1);
+    EXPECT_EQ(status.pierSide, 1);
+    EXPECT_DOUBLE_EQ(status.meridianFlipHA, 0.5);
+    EXPECT_EQ(status.exposureReady, 0);
+    EXPECT_TRUE(status.hasErrorMsg);
+    EXPECT_EQ(status.errorMsg, "");
+}
+
+TEST(AUDStatus, TelescopeErrorMessage)
+{
+    std::string json = STATUS_ANSWER;
+    json.replace(json.find("\"errorMsg\":\"\""), 13, "\"errorMsg\" : \"limit \\\"east\\\"\\n\\u00b0\"");
+
+    AUDTelescopeStatus status;
+    ASSERT_TRUE(aud_decode_telescope_status(json.c_str(), status));
+    EXPECT_EQ(status.errorMsg, "limit \"east\"\n\xc2\xb0");
+
+    json.erase(json.find(",\"errorMsg\""));
+    json += "}";
+    ASSERT_TRUE(aud_decode_telescope_status(json.c_str(), status));
+    EXPECT_FALSE(status.hasErrorMsg);
+}
+
+TEST(AUDStatus, TelescopeInvalid)
+{
+    AUDTelescopeStatus status;
+    std::string missing = STATUS_ANSWER;
+    missing.replace(missing.find("\"pierSide\""), 10, "\"pierside\"");
+
+    EXPECT_FALSE(aud_decode_telescope_status(missing.c_str(), status));
+    EXPECT_FALSE(aud_decode_telescope_status("COMMUNICATIONERROR", status));
+    EXPECT_FALSE(aud_decode_telescope_status("{\"UTC\":", status));
+    EXPECT_FALSE(aud_decode_telescope_status(std::string(STATUS_ANSWER).substr(0, 100).c_str(), status));
+    EXPECT_FALSE(aud_decode_telescope_status(nullptr, status));
+}
+
+TEST(AUDStatus, Focuser)
+{
+    AUDFocuserStatus status;
+
+    ASSERT_TRUE(aud_decode_focuser_status("{ \"driver\": 2, \"position_step\": -123456, \"statusCode\": 6 }", status));
+    EXPECT_EQ(status.position, -123456);
+    EXPECT_EQ(status.statusCode, 6);
+    EXPECT_FALSE(aud_decode_focuser_status("{ \"position_step\": 10 }", status));
+}
+
+/*
+    Time the event loop spends in a guide pulse the server takes 50 ms to answer, when the driver waits for the
+    answer and when it checks it later. The status poll that follows waits behind the pulse at the server either way.
+ */
+static void guidePulse(void *context, bool posted, double &caller, double &poll)
+{
+    MockServer server(context, posted ? "inproc://bench-posted" : "inproc://bench-waited");
+    server.setLatency("ASTRO_GUIDE", milliseconds(50));
+    server.setLatency("ASTRO_STATUS", milliseconds(1));
+
+    AUDClient client(context);
+    client.connect(posted ? "inproc://bench-posted" : "inproc://bench-waited");
+
+    std::vector<double> callers, polls;
+    for ( int i = 0; i < 10; i++ )
+    {
+        auto start = steady_clock::now();
+        std::future<AUDAnswer> pulse;
+        if ( posted )
+            pulse = client.submit("ASTRO_GUIDE * 100");
+        else
+            free(client.command("ASTRO_GUIDE * 100"));
+        callers.push_back(duration<double, std::milli>(steady_clock::now() - start).count());
+
+        start = steady_clock::now();
+        free(client.request("ASTRO_STATUS"));
+        polls.push_back(duration<double, std::milli>(steady_clock::now() - start).count());
+        if ( posted )
+            free(AUDClient::commandAnswer(pulse.get()));
+    }
+
+    std::sort(callers.begin(), callers.end());
+    std::sort(polls.begin(), polls.end());
+    caller = callers[callers.size() / 2];
+    poll = polls[polls.size() / 2];
+}
+
+TEST(AUDClientBenchmark, GuidePulseFromEventLoop)
+{
+    double waitedCaller, waitedPoll, postedCaller, postedPoll;
+
+    void *context = zmq_ctx_new();
+    guidePulse(context, false, waitedCaller, waitedPoll);
+    guidePulse(context, true, postedCaller, postedPoll);
+    zmq_ctx_term(context);
+
+    printf("median guide pulse call: %.1f ms waited, %.1f ms posted\n", waitedCaller, postedCaller);
+    printf("median ASTRO_STATUS round trip after it: %.1f ms waited, %.1f ms posted\n", waitedPoll, postedPoll);
+}
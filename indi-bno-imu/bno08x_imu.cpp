@@ -25,9 +25,13 @@
 #include <sh2.h>
 #include <sh2_err.h>
 #include <cmath>
+#include <chrono>
 
 std::unique_ptr<BNO08X> imu(new BNO08X());
 
+// Interval between drains of the SH2 report queue
+static constexpr auto DRAIN_INTERVAL = std::chrono::milliseconds(5);
+
 BNO08X::BNO08X()
 {
     SetCapability(IMU_HAS_ORIENTATION | IMU_HAS_ACCELERATION | IMU_HAS_GYROSCOPE | IMU_HAS_MAGNETOMETER |
@@ -37,6 +41,11 @@ BNO08X::BNO08X()
     setDriverInterface(IMU_INTERFACE);
 }
 
+BNO08X::~BNO08X()
+{
+    stopAcquisition();
+}
+
 bool BNO08X::initProperties()
 {
     IMU::initProperties();
@@ -58,6 +67,13 @@ bool BNO08X::updateProperties()
     return true;
 }
 
+bool BNO08X::Disconnect()
+{
+    // The drain thread talks to the hub through PortFD, stop it before the connection closes the port.
+    stopAcquisition();
+    return IMU::Disconnect();
+}
+
 bool BNO08X::Handshake()
 {
     try
@@ -115,6 +131,8 @@ bool BNO08X::Handshake()
             return false;
         }
         LOG_INFO("BNO08X initialized and reports enabled successfully.");
+
+        startAcquisition();
         return true;
     }
     catch (const BNO08x_exception &e)
@@ -129,47 +147,125 @@ void BNO08X::TimerHit()
     if (!isConnected())
         return;
 
-    readSensorData();
+    SensorData data;
+    {
+        std::lock_guard<std::mutex> lock(m_DataMutex);
+        data = m_Data;
+        m_Data.accelCount = m_Data.gyroCount = m_Data.magCount = m_Data.orientationCount = 0;
+    }
+
+    if (data.orientationCount > 0)
+        SetOrientationData(data.quaternion[0], data.quaternion[1], data.quaternion[2], data.quaternion[3]);
+
+    if (data.accelCount > 0)
+        SetAccelerationData(data.accel[0] / data.accelCount, data.accel[1] / data.accelCount,
+                            data.accel[2] / data.accelCount);
+
+    if (data.gyroCount > 0)
+        SetGyroscopeData(data.gyro[0] / data.gyroCount, data.gyro[1] / data.gyroCount, data.gyro[2] / data.gyroCount);
+
+    if (data.magCount > 0)
+        SetMagnetometerData(data.mag[0] / data.magCount, data.mag[1] / data.magCount, data.mag[2] / data.magCount);
+
+    if (data.orientationCount + data.accelCount + data.gyroCount + data.magCount > 0)
+    {
+        // Update calibration status if available
+        SetCalibrationStatus(data.status & 0x03, // System calibration
+                             (data.status >> 2) & 0x03, // Gyro calibration
+                             (data.status >> 4) & 0x03, // Accelerometer calibration
+                             (data.status >> 6) & 0x03); // Magnetometer calibration
+    }
+
+    LOGF_DEBUG("BNO08X: %u orientation, %u accel, %u gyro, %u mag reports since last update.",
+               data.orientationCount, data.accelCount, data.gyroCount, data.magCount);
 
     SetTimer(getPollingPeriod());
 }
 
-bool BNO08X::readSensorData()
+void BNO08X::startAcquisition()
+{
+    stopAcquisition();
+
+    {
+        std::lock_guard<std::mutex> lock(m_DataMutex);
+        m_Data = SensorData();
+    }
+
+    m_AcquisitionRunning = true;
+    m_AcquisitionThread = std::thread(&BNO08X::acquisitionLoop, this);
+}
+
+void BNO08X::stopAcquisition()
+{
+    m_AcquisitionRunning = false;
+    if (m_AcquisitionThread.joinable())
+        m_AcquisitionThread.join();
+}
+
+void BNO08X::acquisitionLoop()
+{
+    while (m_AcquisitionRunning)
+    {
+        auto next = std::chrono::steady_clock::now() + DRAIN_INTERVAL;
+        {
+            std::lock_guard<std::mutex> lock(m_SensorMutex);
+            drainSensorEvents();
+        }
+        std::this_thread::sleep_until(next);
+    }
+}
+
+int BNO08X::drainSensorEvents()
 {
     sh2_SensorValue_t sensorValue;
-    if (bno08x.getSensorEvent(&sensorValue))
+    int events = 0;
+
+    // Read every report the hub queued since the last drain
+    while (bno08x.getSensorEvent(&sensorValue))
     {
+        events++;
+
+        std::lock_guard<std::mutex> lock(m_DataMutex);
+        m_Data.status = sensorValue.status;
+
         switch (sensorValue.sensorId)
         {
             case SH2_ROTATION_VECTOR:
             case SH2_GAME_ROTATION_VECTOR:
             case SH2_GEOMAGNETIC_ROTATION_VECTOR:
-                SetOrientationData(sensorValue.un.rotationVector.i,
-                                   sensorValue.un.rotationVector.j,
-                                   sensorValue.un.rotationVector.k,
-                                   sensorValue.un.rotationVector.real);
+                m_Data.quaternion[0] = sensorValue.un.rotationVector.i;
+                m_Data.quaternion[1] = sensorValue.un.rotationVector.j;
+                m_Data.quaternion[2] = sensorValue.un.rotationVector.k;
+                m_Data.quaternion[3] = sensorValue.un.rotationVector.real;
+                m_Data.orientationCount++;
                 break;
 
             case SH2_ACCELEROMETER:
             case SH2_LINEAR_ACCELERATION:
             case SH2_GRAVITY:
-                SetAccelerationData(sensorValue.un.accelerometer.x,
-                                    sensorValue.un.accelerometer.y,
-                                    sensorValue.un.accelerometer.z);
+                if (m_Data.accelCount++ == 0)
+                    m_Data.accel[0] = m_Data.accel[1] = m_Data.accel[2] = 0;
+                m_Data.accel[0] += sensorValue.un.accelerometer.x;
+                m_Data.accel[1] += sensorValue.un.accelerometer.y;
+                m_Data.accel[2] += sensorValue.un.accelerometer.z;
                 break;
 
             case SH2_GYROSCOPE_CALIBRATED:
             case SH2_GYROSCOPE_UNCALIBRATED:
-                SetGyroscopeData(sensorValue.un.gyroscope.x,
-                                 sensorValue.un.gyroscope.y,
-                                 sensorValue.un.gyroscope.z);
+                if (m_Data.gyroCount++ == 0)
+                    m_Data.gyro[0] = m_Data.gyro[1] = m_Data.gyro[2] = 0;
+                m_Data.gyro[0] += sensorValue.un.gyroscope.x;
+                m_Data.gyro[1] += sensorValue.un.gyroscope.y;
+                m_Data.gyro[2] += sensorValue.un.gyroscope.z;
                 break;
 
             case SH2_MAGNETIC_FIELD_CALIBRATED:
             case SH2_MAGNETIC_FIELD_UNCALIBRATED:
-                SetMagnetometerData(sensorValue.un.magneticField.x,
-                                    sensorValue.un.magneticField.y,
-                                    sensorValue.un.magneticField.z);
+                if (m_Data.magCount++ == 0)
+                    m_Data.mag[0] = m_Data.mag[1] = m_Data.mag[2] = 0;
+                m_Data.mag[0] += sensorValue.un.magneticField.x;
+                m_Data.mag[1] += sensorValue.un.magneticField.y;
+                m_Data.mag[2] += sensorValue.un.magneticField.z;
                 break;
 
             case SH2_TAP_DETECTOR:
@@ -198,16 +294,9 @@ bool BNO08X::readSensorData()
                 LOGF_DEBUG("BNO08X: Unhandled sensor event ID: %d", sensorValue.sensorId);
                 break;
         }
-
-        // Update calibration status if available
-        SetCalibrationStatus(sensorValue.status & 0x03, // System calibration
-                             (sensorValue.status >> 2) & 0x03, // Gyro calibration
-                             (sensorValue.status >> 4) & 0x03, // Accelerometer calibration
-                             (sensorValue.status >> 6) & 0x03); // Magnetometer calibration
-
-        return true;
     }
-    return false;
+
+    return events;
 }
 
 bool BNO08X::SetCalibrationStatus(int sys, int gyro, int accel, int mag)
@@ -248,7 +337,9 @@ bool BNO08X::StartCalibration()
 
     // Enable dynamic calibration for Accel, Gyro, Mag, Planar Accel, On Table Cal
     uint8_t sensorsToCalibrate = SH2_CAL_ACCEL | SH2_CAL_GYRO | SH2_CAL_MAG | SH2_CAL_PLANAR;
+    std::unique_lock<std::mutex> lock(m_SensorMutex);
     int status = sh2_setCalConfig(sensorsToCalibrate);
+    lock.unlock();
 
     if (status != SH2_OK)
     {
@@ -264,7 +355,9 @@ bool BNO08X::SaveCalibrationData()
 {
     LOG_INFO("BNO08X: Saving calibration data to FRS.");
 
+    std::unique_lock<std::mutex> lock(m_SensorMutex);
     int status = sh2_saveDcdNow();
+    lock.unlock();
     if (status != SH2_OK)
     {
         LOGF_ERROR("BNO08X: Failed to save calibration data, status: %d", status);
@@ -289,7 +382,9 @@ bool BNO08X::ResetCalibration()
 {
     LOG_INFO("BNO08X: Resetting calibration data and performing a soft reset.");
 
+    std::unique_lock<std::mutex> lock(m_SensorMutex);
     int status = sh2_clearDcdAndReset();
+    lock.unlock();
     if (status != SH2_OK)
     {
         LOGF_ERROR("BNO08X: Failed to reset calibration data, status: %d", status);
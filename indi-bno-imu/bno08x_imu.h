@@ -23,13 +23,16 @@
 #include <indiimu.h>
 #include <connectionplugins/connectioni2c.h>
 #include <BNO08x.h>
+#include <atomic>
 #include <cmath>
+#include <mutex>
+#include <thread>
 
 class BNO08X : public INDI::IMU
 {
     public:
         BNO08X();
-        virtual ~BNO08X() = default;
+        virtual ~BNO08X();
 
         virtual const char *getDefaultName() override
         {
@@ -39,6 +42,7 @@ class BNO08X : public INDI::IMU
         virtual bool initProperties() override;
         virtual bool updateProperties() override;
         virtual bool Handshake() override;
+        virtual bool Disconnect() override;
         virtual void TimerHit() override;
 
     protected:
@@ -57,5 +61,32 @@ class BNO08X : public INDI::IMU
                                    const std::string &sensorStatus) override;
     private:
         BNO08x bno08x; // BNO08x sensor object
-        bool readSensorData();
+
+        // The SH2 hub queues reports in its own FIFO. A dedicated thread drains all pending
+        // reports at the hub's rate, TimerHit publishes the latest orientation and mean vectors.
+        struct SensorData
+        {
+            double quaternion[4] = {0, 0, 0, 1};
+            double accel[3] = {0, 0, 0};
+            double gyro[3] = {0, 0, 0};
+            double mag[3] = {0, 0, 0};
+            uint32_t accelCount = 0;
+            uint32_t gyroCount = 0;
+            uint32_t magCount = 0;
+            uint32_t orientationCount = 0;
+            uint8_t status = 0;
+        };
+
+        void startAcquisition();
+        void stopAcquisition();
+        void acquisitionLoop();
+        int drainSensorEvents();
+
+        std::thread m_AcquisitionThread;
+        std::atomic<bool> m_AcquisitionRunning {false};
+        // Serializes all SH2 hub access between the acquisition thread and INDI requests
+        std::mutex m_SensorMutex;
+        // Protects the accumulated data
+        std::mutex m_DataMutex;
+        SensorData m_Data;
 };
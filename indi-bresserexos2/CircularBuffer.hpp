@@ -26,6 +26,7 @@
 
 #include <cstdint>
 #include <cstring>
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include "config.h"
@@ -78,6 +79,24 @@ class CircularBuffer
             return false;
         }
 
+        //append up to count values to the back of the buffer, returns the number of values actually stored.
+        size_t PushBack(const T* values, size_t count)
+        {
+            size_t pushed = 0;
+
+            while(pushed < count && !IsFull())
+            {
+                size_t chunk = std::min(count - pushed, std::min(max_size - mEnd, max_size - mSize));
+
+                std::memcpy(&mBuffer[mEnd], &values[pushed], chunk * sizeof(T));
+                mEnd = (mEnd + chunk) % max_size;
+                mSize += chunk;
+                pushed += chunk;
+            }
+
+            return pushed;
+        }
+
         bool PopFront()
         {
             if(!IsEmpty())
@@ -144,6 +163,27 @@ class CircularBuffer
             return mSize;
         }
 
+        size_t Capacity()
+        {
+            return max_size;
+        }
+
+        size_t Free()
+        {
+            return max_size - mSize;
+        }
+
+        //return the element at the logical index, counted from the front, without copying the buffer.
+        T At(size_t logicalIndex)
+        {
+            if(logicalIndex < mSize)
+            {
+                return mBuffer[ActualIndex(logicalIndex)];
+            }
+
+            return mZeroElement;
+        }
+
         bool IsEmpty()
         {
             return mSize == 0;
@@ -166,14 +206,22 @@ class CircularBuffer
 
         bool DiscardFront(size_t count)
         {
-            bool returnval = false;
+            if(count == 0 || IsEmpty())
+            {
+                return false;
+            }
+
+            count = std::min(count, mSize);
+            mStart = (mStart + count) % max_size;
+            mSize -= count;
 
-            for(size_t i = 0; i < count; i++)
+            if(mSize == 0)
             {
-                returnval = PopFront();
+                mStart = 0;
+                mEnd = 0;
             }
 
-            return returnval;
+            return true;
         }
 
     private:
@@ -210,7 +258,7 @@ class CircularBuffer
             {
                 value = max_size;
             }
-            value++;
+            value--;
         }
 };
 }
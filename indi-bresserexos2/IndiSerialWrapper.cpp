@@ -1,5 +1,7 @@
 #include "IndiSerialWrapper.hpp"
 
+#include <algorithm>
+
 using namespace GoToDriver;
 
 #define UNUSED(x) (void)(x)
@@ -99,6 +101,50 @@ int16_t IndiSerialWrapper::ReadByte()
     return -1;
 }
 
+//Blocks until data is available to read or the timeout (in milliseconds) elapsed. Returns true if data is available.
+bool IndiSerialWrapper::WaitForData(int timeoutMs)
+{
+    if(IsOpen())
+    {
+        struct pollfd pfd;
+        pfd.fd = mTtyFd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        int result = poll(&pfd, 1, timeoutMs);
+
+        if(result > 0 && (pfd.revents & POLLIN))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//Reads up to length bytes which are already available into the buffer, returns the number of bytes read.
+size_t IndiSerialWrapper::Read(uint8_t* buffer, size_t length)
+{
+    if(IsOpen() && buffer != nullptr && length > 0)
+    {
+        size_t available = BytesToRead();
+
+        if(available == 0)
+        {
+            return 0;
+        }
+
+        ssize_t result = read(mTtyFd, buffer, std::min(available, length));
+
+        if(result > 0)
+        {
+            return (size_t)result;
+        }
+    }
+
+    return 0;
+}
+
 //writes the buffer to the serial interface.
 //this function should handle all the quirks of various serial interfaces.
 bool IndiSerialWrapper::Write(uint8_t* buffer, size_t offset, size_t length)
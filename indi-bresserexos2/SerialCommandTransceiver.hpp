@@ -30,6 +30,9 @@
 #include <deque>
 #include <queue>
 #include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
 
 #include <algorithm>
 #include "config.h"
@@ -39,8 +42,36 @@
 #include "SerialCommand.hpp"
 #include "CircularBuffer.hpp"
 
+//size of the receiver ring buffer, has to hold at least one message frame.
+#define RECEIVER_BUFFER_SIZE (1024)
+
+//maximum time the reader thread blocks waiting for data, before checking if it should terminate.
+#define RECEIVER_POLL_TIMEOUT_MS (100)
+
 namespace SerialDeviceControl
 {
+//Counters describing the work and the backpressure of the serial receiver.
+struct ReceiverStatistics
+{
+    //number of bytes read from the serial interface.
+    uint64_t BytesReceived;
+
+    //number of bulk read calls issued to the serial interface.
+    uint64_t ReadCalls;
+
+    //number of complete message frames parsed.
+    uint64_t MessagesFramed;
+
+    //number of bytes skipped because they did not belong to a message frame.
+    uint64_t BytesDiscarded;
+
+    //number of reads which were limited by the free space of the ring buffer.
+    uint64_t ThrottledReads;
+
+    //highest fill level of the ring buffer observed.
+    size_t BufferHighWaterMark;
+};
+
 //These types have to inherit/implement:
 //-The ISerialInterface.hpp as Interface type.
 //-The INotifyPointingCoordinatesReceived.hpp as callback type
@@ -57,7 +88,8 @@ class SerialCommandTransceiver
             mDataReceivedCallback(dataReceivedCallback),
             mThreadRunning(false),
             mSerialReceiverBuffer(0x00),
-            mSerialReaderThread()
+            mSerialReaderThread(),
+            mStatistics()
         {
             SerialCommand::PushHeader(mMessageHeader);
         }
@@ -65,16 +97,19 @@ class SerialCommandTransceiver
         //Destroys this transceiver, and stops the thread pulling the serial data from the mount.
         virtual ~SerialCommandTransceiver()
         {
-            bool threadRunning = mThreadRunning.Get();
-
-            if(threadRunning)
-            {
-                Stop();
-            }
+            Stop();
         }
+
         //Start the serial command dispatching.
         virtual bool Start()
         {
+            if(mThreadRunning.Get())
+            {
+                return true;
+            }
+
+            mThreadRunning.Set(true);
+
             mSerialReaderThread = std::thread(&SerialCommandTransceiver::SerialReaderThreadFunction, this);
 
             return true;
@@ -83,18 +118,40 @@ class SerialCommandTransceiver
         //Stop the serial command dispatching.
         bool Stop()
         {
-            bool running = mThreadRunning.Get();
+            mThreadRunning.Set(false);
 
-            if(running)
+            if(mSerialReaderThread.joinable())
             {
-                mThreadRunning.Set(false);
-
                 mSerialReaderThread.join();
             }
 
+            //wake up anybody still waiting for a message.
+            mMessageReceived.notify_all();
+
             return true;
         }
 
+        //Block until more than lastMessageCount messages were framed or the timeout elapsed.
+        //Returns the current message count, which can be passed in as lastMessageCount on the next call.
+        uint64_t WaitForMessage(uint64_t lastMessageCount, std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock(mStatisticsMutex);
+
+            mMessageReceived.wait_for(lock, timeout, [this, lastMessageCount]()
+            {
+                return mStatistics.MessagesFramed > lastMessageCount || !mThreadRunning.Get();
+            });
+
+            return mStatistics.MessagesFramed;
+        }
+
+        //Return a snapshot of the receiver statistics.
+        ReceiverStatistics GetStatistics()
+        {
+            std::lock_guard<std::mutex> guard(mStatisticsMutex);
+            return mStatistics;
+        }
+
     protected:
         //Send a message using the provided serial interface implementation.
         bool SendMessageBuffer(
@@ -117,7 +174,7 @@ class SerialCommandTransceiver
         CriticalData<bool> mThreadRunning;
 
         //A cicular buffer implementation to receive serial message from the mount.
-        CircularBuffer<uint8_t, 256> mSerialReceiverBuffer;
+        CircularBuffer<uint8_t, RECEIVER_BUFFER_SIZE> mSerialReceiverBuffer;
 
         //Contains a message header for convinience.
         std::vector<uint8_t> mMessageHeader;
@@ -125,113 +182,159 @@ class SerialCommandTransceiver
         //movable thread object to control.
         std::thread mSerialReaderThread;
 
-        //buffer used when serial messages are parsed.
-        std::vector<uint8_t> mParseBuffer;
+        //statistics of the receiver, protected by the statistics mutex.
+        ReceiverStatistics mStatistics;
 
-        //When messages are received, try parsing them.
-        //It may happen that messages are received in fragments, this function tries to piece together these fragments to valid messages.
-        //skip any previous junk if message was found, drop anything until the end of the parsed message, to clean up the buffer.
-        void TryParseMessagesFromBuffer()
-        {
-            mParseBuffer.clear();
+        //mutex protecting the statistics, also used for the message received condition.
+        std::mutex mStatisticsMutex;
 
-            if(mSerialReceiverBuffer.Size() > 0)
+        //signaled every time at least one message was framed.
+        std::condition_variable mMessageReceived;
+
+        //Returns true if the message header starts at the logical position in the receiver buffer.
+        bool HeaderMatchesAt(size_t position)
+        {
+            for(size_t i = 0; i < mMessageHeader.size(); i++)
             {
-                mSerialReceiverBuffer.CopyToVector(mParseBuffer);
+                if(mSerialReceiverBuffer.At(position + i) != mMessageHeader[i])
+                {
+                    return false;
+                }
+            }
 
-                std::vector<uint8_t>::iterator startPosition = std::search(mParseBuffer.begin(), mParseBuffer.end(), mMessageHeader.begin(),
-                        mMessageHeader.end());
+            return true;
+        }
 
-                std::vector<uint8_t>::iterator endPosition = startPosition + MESSAGE_FRAME_SIZE;
+        //Decode the message frame at the front of the receiver buffer and dispatch it to the callback.
+        void DispatchFrontMessage()
+        {
+            FloatByteConverter ra_bytes;
+            FloatByteConverter dec_bytes;
 
-                if(startPosition != mParseBuffer.end() && endPosition != mParseBuffer.end())
-                {
-                    FloatByteConverter ra_bytes;
-                    FloatByteConverter dec_bytes;
+            for(size_t i = 0; i < 4; i++)
+            {
+                ra_bytes.bytes[i] = mSerialReceiverBuffer.At(5 + i);
+                dec_bytes.bytes[i] = mSerialReceiverBuffer.At(9 + i);
+            }
 
-                    ra_bytes.bytes[0] = *(startPosition + 5);
-                    ra_bytes.bytes[1] = *(startPosition + 6);
-                    ra_bytes.bytes[2] = *(startPosition + 7);
-                    ra_bytes.bytes[3] = *(startPosition + 8);
+            uint8_t cid = mSerialReceiverBuffer.At(4);
+            float ra = ra_bytes.decimal_number;
+            float dec = dec_bytes.decimal_number;
 
-                    dec_bytes.bytes[0] = *(startPosition + 9);
-                    dec_bytes.bytes[1] = *(startPosition + 10);
-                    dec_bytes.bytes[2] = *(startPosition + 11);
-                    dec_bytes.bytes[3] = *(startPosition + 12);
+            //handle specific response.
+            switch(cid)
+            {
+                case SerialCommandID::TELESCOPE_SITE_LOCATION_REPORT_COMMAND_ID:
+                    mDataReceivedCallback.OnSiteLocationCoordinatesReceived(ra, dec);
+                    break;
 
-                    uint8_t cid = *(startPosition + 4);
-                    float ra = ra_bytes.decimal_number;
-                    float dec = dec_bytes.decimal_number;
+                /* The handbox unfortunately does not report "untracked" coordinates, -> reason for this big state machine.
+                 * case SerialCommandID::TELESCOPE_POSITION_REPORT_UNTRACKED_COMMAND_ID:
+                    std::cerr << "untracked pointing report:" << "RA:" << ra << " DEC:" << dec << std::endl;
+                    break;*/
 
-                    //std::cerr << "COMMAND RECEIVED:" << std::hex << (int)cid << std::endl;
+                case SerialCommandID::TELESCOPE_POSITION_REPORT_COMMAND_ID:
+                    mDataReceivedCallback.OnPointingCoordinatesReceived(ra, dec);
+                    break;
 
-                    //handle specific response.
-                    switch(cid)
-                    {
-                        case SerialCommandID::TELESCOPE_SITE_LOCATION_REPORT_COMMAND_ID:
-                            //std::cout << "new location received!" << std::endl;
-                            mDataReceivedCallback.OnSiteLocationCoordinatesReceived(ra, dec);
-                            break;
-                            
-                        /* The handbox unfortunately does not report "untracked" coordinates, -> reason for this big state machine.
-                         * case SerialCommandID::TELESCOPE_POSITION_REPORT_UNTRACKED_COMMAND_ID:
-                            std::cerr << "untracked pointing report:" << "RA:" << ra << " DEC:" << dec << std::endl;
-                            break;*/
-
-                        case SerialCommandID::TELESCOPE_POSITION_REPORT_COMMAND_ID:
-                            mDataReceivedCallback.OnPointingCoordinatesReceived(ra, dec);
-                            break;
-
-                        default:
-                            break;
-                    }
+                default:
+                    break;
+            }
+        }
 
-                    size_t dropCount = endPosition - mParseBuffer.begin();
+        //Frame all complete messages currently in the receiver buffer, in place.
+        //It may happen that messages are received in fragments, incomplete frames are kept until the rest arrived.
+        //Junk in front of a message header is dropped, returns the number of messages framed.
+        size_t TryParseMessagesFromBuffer(uint64_t &discarded)
+        {
+            size_t framed = 0;
+            const size_t headerSize = mMessageHeader.size();
 
-                    mSerialReceiverBuffer.DiscardFront(dropCount);
+            while(mSerialReceiverBuffer.Size() >= headerSize)
+            {
+                size_t position = 0;
+                size_t lastCandidate = mSerialReceiverBuffer.Size() - headerSize;
 
-                    //std::cout << "Receive size after :" << mSerialReceiverBuffer.Size() << " dropped " << dropCount << std::endl;
+                while(position <= lastCandidate && !HeaderMatchesAt(position))
+                {
+                    position++;
                 }
+
+                //drop the junk in front of the header, or everything except a possible partial header at the end.
+                if(position > 0)
+                {
+                    mSerialReceiverBuffer.DiscardFront(position);
+                    discarded += position;
+                }
+
+                if(mSerialReceiverBuffer.Size() < MESSAGE_FRAME_SIZE)
+                {
+                    break;
+                }
+
+                DispatchFrontMessage();
+
+                mSerialReceiverBuffer.DiscardFront(MESSAGE_FRAME_SIZE);
+                framed++;
             }
+
+            return framed;
         }
+
         //Endless loop function of the thread used to receive the serial messages of the mount.
+        //Blocks until data arrives, drains everything available in bulk and frames the messages incrementally.
         void SerialReaderThreadFunction()
         {
             std::cerr << "Serial Reader Thread started!" << std::endl;
-            bool running = mThreadRunning.Get();
 
             mInterfaceImplementation.Open();
 
-            if(running == false)
+            uint8_t readBuffer[RECEIVER_BUFFER_SIZE];
+
+            while(mThreadRunning.Get())
             {
-                mThreadRunning.Set(true);
+                if(!mInterfaceImplementation.WaitForData(RECEIVER_POLL_TIMEOUT_MS))
+                {
+                    continue;
+                }
+
+                size_t freeSpace = mSerialReceiverBuffer.Free();
+                size_t available = mInterfaceImplementation.BytesToRead();
+                size_t bytesRead = mInterfaceImplementation.Read(readBuffer, freeSpace);
 
-                do
+                if(bytesRead == 0)
                 {
-                    //controller sends status messages about every second so wait a bit
-                    std::this_thread::sleep_until(std::chrono::system_clock::now() + std::chrono::milliseconds(500));
+                    continue;
+                }
+
+                //reads are limited to the free space, so nothing is ever dropped here.
+                mSerialReceiverBuffer.PushBack(readBuffer, bytesRead);
+                size_t fillLevel = mSerialReceiverBuffer.Size();
 
-                    size_t bufferContent = mInterfaceImplementation.BytesToRead();
-                    int16_t data = -1;
+                uint64_t discarded = 0;
+                size_t framed = TryParseMessagesFromBuffer(discarded);
+
+                {
+                    std::lock_guard<std::mutex> guard(mStatisticsMutex);
 
-                    bool addSucceed = false;
+                    mStatistics.BytesReceived += bytesRead;
+                    mStatistics.ReadCalls++;
+                    mStatistics.MessagesFramed += framed;
+                    mStatistics.BytesDiscarded += discarded;
+                    mStatistics.BufferHighWaterMark = std::max(mStatistics.BufferHighWaterMark, fillLevel);
 
-                    if(bufferContent > 0)
+                    if(available > freeSpace)
                     {
-                        while((data = mInterfaceImplementation.ReadByte()) > -1)
-                        {
-                            addSucceed = mSerialReceiverBuffer.PushBack((uint8_t)data);
-                        }
-
-                        if(addSucceed)
-                        {
-                            TryParseMessagesFromBuffer();
-                        }
+                        mStatistics.ThrottledReads++;
                     }
-                    running = mThreadRunning.Get();
                 }
-                while(running == true);
+
+                if(framed > 0)
+                {
+                    mMessageReceived.notify_all();
+                }
             }
+
             std::cerr << "Serial Reader Thread stopped!" << std::endl;
             mInterfaceImplementation.Flush();
             mInterfaceImplementation.Close();
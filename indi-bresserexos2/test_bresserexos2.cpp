@@ -0,0 +1,216 @@
+/*
+ * test_bresserexos2.cpp
+ *
+ * Replays Exos-2 handbox traffic through a socket pair at full speed,
+ * to verify the message framing of the serial receiver and measure its throughput.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301, USA.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "IndiSerialWrapper.hpp"
+#include "SerialCommandTransceiver.hpp"
+
+using namespace SerialDeviceControl;
+
+class RecordingCallback : public INotifyPointingCoordinatesReceived
+{
+    public:
+        virtual void OnPointingCoordinatesReceived(float right_ascension, float declination)
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            Pointing.push_back(std::make_pair(right_ascension, declination));
+        }
+
+        virtual void OnSiteLocationCoordinatesReceived(float latitude, float longitude)
+        {
+            std::lock_guard<std::mutex> guard(mMutex);
+            Site.push_back(std::make_pair(latitude, longitude));
+        }
+
+        std::vector<std::pair<float, float>> Pointing;
+        std::vector<std::pair<float, float>> Site;
+
+    private:
+        std::mutex mMutex;
+};
+
+// Decrement used to step forward, so PushFront and PopBack wrapped past the end of the storage
+TEST(CircularBufferTest, PushFrontAndPopBackWrapAround)
+{
+    CircularBuffer<uint8_t, 4> buffer(0);
+
+    ASSERT_TRUE(buffer.PushFront(1));
+    ASSERT_TRUE(buffer.PushFront(2));
+    ASSERT_TRUE(buffer.PushBack(3));
+
+    uint8_t value = 0;
+    ASSERT_TRUE(buffer.Front(value));
+    EXPECT_EQ(value, 2);
+    ASSERT_TRUE(buffer.Back(value));
+    EXPECT_EQ(value, 3);
+    EXPECT_EQ(buffer.At(1), 1);
+
+    ASSERT_TRUE(buffer.PopBack());
+    ASSERT_TRUE(buffer.Back(value));
+    EXPECT_EQ(value, 1);
+    EXPECT_EQ(buffer.Size(), 2u);
+}
+
+typedef SerialCommandTransceiver<GoToDriver::IndiSerialWrapper, RecordingCallback> Transceiver;
+
+class SocketPairTest : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, mFds), 0);
+            mSerial.SetFD(mFds[0]);
+        }
+
+        void TearDown() override
+        {
+            close(mFds[0]);
+            close(mFds[1]);
+        }
+
+        // Append a report frame as the handbox sends it: header, command id, two floats.
+        static void AppendReport(std::vector<uint8_t> &traffic, uint8_t cid, float a, float b)
+        {
+            FloatByteConverter first, second;
+            first.decimal_number = a;
+            second.decimal_number = b;
+
+            SerialCommand::PushHeader(traffic);
+            traffic.push_back(cid);
+            traffic.insert(traffic.end(), first.bytes, first.bytes + 4);
+            traffic.insert(traffic.end(), second.bytes, second.bytes + 4);
+        }
+
+        // Write the traffic to the device side of the pair, in chunks of the given size.
+        void Replay(const std::vector<uint8_t> &traffic, size_t chunk)
+        {
+            for (size_t offset = 0; offset < traffic.size(); offset += chunk)
+            {
+                size_t length = std::min(chunk, traffic.size() - offset);
+                ASSERT_EQ(write(mFds[1], &traffic[offset], length), (ssize_t)length);
+            }
+        }
+
+        int mFds[2];
+        GoToDriver::IndiSerialWrapper mSerial;
+        RecordingCallback mCallback;
+};
+
+TEST_F(SocketPairTest, FramesFragmentedReportsWithJunk)
+{
+    std::vector<uint8_t> traffic;
+    const size_t reports = 200;
+
+    for (size_t i = 0; i < reports; i++)
+    {
+        // line noise and partial headers between the reports.
+        traffic.push_back(0x00);
+        if (i % 3 == 0)
+        {
+            traffic.push_back(0x55);
+            traffic.push_back(0xaa);
+        }
+        AppendReport(traffic, SerialCommandID::TELESCOPE_POSITION_REPORT_COMMAND_ID, i * 0.1f, -(float)i);
+    }
+    AppendReport(traffic, SerialCommandID::TELESCOPE_SITE_LOCATION_REPORT_COMMAND_ID, 52.5f, 13.4f);
+
+    Transceiver transceiver(mSerial, mCallback);
+    transceiver.Start();
+
+    // odd chunk size so frames are split at every possible position.
+    Replay(traffic, 7);
+
+    uint64_t messages = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (messages < reports + 1 && std::chrono::steady_clock::now() < deadline)
+        messages = transceiver.WaitForMessage(messages, std::chrono::milliseconds(500));
+
+    transceiver.Stop();
+
+    ASSERT_EQ(mCallback.Pointing.size(), reports);
+    for (size_t i = 0; i < reports; i++)
+    {
+        EXPECT_FLOAT_EQ(mCallback.Pointing[i].first, i * 0.1f);
+        EXPECT_FLOAT_EQ(mCallback.Pointing[i].second, -(float)i);
+    }
+
+    ASSERT_EQ(mCallback.Site.size(), 1u);
+    EXPECT_FLOAT_EQ(mCallback.Site[0].first, 52.5f);
+
+    ReceiverStatistics statistics = transceiver.GetStatistics();
+    EXPECT_EQ(statistics.BytesReceived, traffic.size());
+    EXPECT_EQ(statistics.MessagesFramed, reports + 1);
+    EXPECT_EQ(statistics.BytesDiscarded, traffic.size() - (reports + 1) * MESSAGE_FRAME_SIZE);
+}
+
+TEST_F(SocketPairTest, Throughput)
+{
+    std::vector<uint8_t> traffic;
+    const size_t reports = 20000;
+
+    for (size_t i = 0; i < reports; i++)
+        AppendReport(traffic, SerialCommandID::TELESCOPE_POSITION_REPORT_COMMAND_ID, 1.0f, 2.0f);
+
+    Transceiver transceiver(mSerial, mCallback);
+    transceiver.Start();
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::thread writer([&]()
+    {
+        Replay(traffic, 4096);
+    });
+
+    uint64_t messages = 0;
+    auto deadline = start + std::chrono::seconds(10);
+    while (messages < reports && std::chrono::steady_clock::now() < deadline)
+        messages = transceiver.WaitForMessage(messages, std::chrono::milliseconds(500));
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    writer.join();
+    transceiver.Stop();
+
+    ReceiverStatistics statistics = transceiver.GetStatistics();
+    EXPECT_EQ(statistics.MessagesFramed, reports);
+    EXPECT_EQ(statistics.BytesDiscarded, 0u);
+
+    std::cout << "Framed " << statistics.MessagesFramed << " reports in " << elapsed << " s ("
+              << statistics.MessagesFramed / elapsed << " reports/s), " << statistics.ReadCalls << " reads, "
+              << statistics.ThrottledReads << " throttled, high water mark " << statistics.BufferHighWaterMark
+              << " bytes" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,5 +1,4 @@
 #include "adaptive_tuner.h"
-#include <numeric> // for std::accumulate
 #include <algorithm> // for std::min, std::max
 #include <iostream> // For temporary debugging
 
@@ -10,6 +9,90 @@ T clamp(T value, T min_val, T max_val)
     return std::max(min_val, std::min(value, max_val));
 }
 
+RunningWindow::RunningWindow(size_t capacity) : m_buffer(std::max(static_cast<size_t>(1), capacity))
+{
+}
+
+void RunningWindow::setCapacity(size_t capacity)
+{
+    capacity = std::max(static_cast<size_t>(1), capacity);
+    if (capacity == m_buffer.size())
+        return;
+
+    // Rare, the latest samples are simply pushed again
+    std::vector<double> latest;
+    for (size_t i = m_count > capacity ? m_count - capacity : 0; i < m_count; ++i)
+        latest.push_back((*this)[i]);
+
+    m_buffer.assign(capacity, 0.0);
+    clear();
+    for (double value : latest)
+        push(value);
+}
+
+void RunningWindow::clear()
+{
+    m_head = 0;
+    m_count = 0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_sign_changes = 0;
+}
+
+void RunningWindow::push(double value)
+{
+    if (m_count == m_buffer.size())
+        popOldest();
+
+    if (m_count > 0)
+    {
+        double newest = (*this)[m_count - 1];
+        if ((newest > 0 && value < 0) || (newest < 0 && value > 0))
+            m_sign_changes++;
+    }
+
+    m_buffer[(m_head + m_count) % m_buffer.size()] = value;
+    m_count++;
+
+    double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+}
+
+void RunningWindow::popOldest()
+{
+    double oldest = (*this)[0];
+
+    if (m_count > 1)
+    {
+        double next = (*this)[1];
+        if ((oldest > 0 && next < 0) || (oldest < 0 && next > 0))
+            m_sign_changes--;
+    }
+
+    m_head = (m_head + 1) % m_buffer.size();
+    m_count--;
+
+    if (m_count == 0)
+    {
+        m_mean = 0.0;
+        m_m2 = 0.0;
+        return;
+    }
+
+    // Welford's update run backwards
+    double previous_mean = m_mean;
+    m_mean -= (oldest - m_mean) / m_count;
+    m_m2 -= (oldest - previous_mean) * (oldest - m_mean);
+}
+
+double RunningWindow::stddev() const
+{
+    if (m_count < 2) return 0.0;
+    // Rounding may leave a tiny negative sum when all samples are equal
+    return std::sqrt(std::max(0.0, m_m2) / (m_count - 1));
+}
+
 AdaptivePIDTuner::AdaptivePIDTuner(double dt, double initialKp, double initialKi, double initialKd,
                                    double omega_n_ref, double zeta_ref)
     : m_ref_omega_n(omega_n_ref), m_ref_zeta(zeta_ref),
@@ -58,10 +141,10 @@ void AdaptivePIDTuner::setHistorySize(size_t size)
     m_history_size = std::max(static_cast<size_t>(10), size); // Need some minimum history
     m_min_data_for_tuning = std::max(static_cast<size_t>(10), m_history_size / 2); // Update this too
 
-    // Trim histories if they are now too long
-    while (m_error_history.size() > m_history_size) m_error_history.pop_front();
-    while (m_plant_output_history.size() > m_history_size) m_plant_output_history.pop_front();
-    while (m_setpoint_history.size() > m_history_size) m_setpoint_history.pop_front();
+    // Histories keep their latest samples
+    m_error_history.setCapacity(m_history_size);
+    m_plant_output_history.setCapacity(m_history_size);
+    m_setpoint_history.setCapacity(m_history_size);
 }
 
 void AdaptivePIDTuner::startActiveTuning()
@@ -123,14 +206,10 @@ void AdaptivePIDTuner::processMeasurement(double setpoint_r, double plant_output
     // 2. Calculate adaptation error
     double error_adapt = plant_output_yp - m_ref_x1; // y_p - y_m
 
-    // 3. Store in history buffers
-    m_error_history.push_back(error_adapt);
-    m_plant_output_history.push_back(plant_output_yp);
-    m_setpoint_history.push_back(setpoint_r);
-
-    while (m_error_history.size() > m_history_size) m_error_history.pop_front();
-    while (m_plant_output_history.size() > m_history_size) m_plant_output_history.pop_front();
-    while (m_setpoint_history.size() > m_history_size) m_setpoint_history.pop_front();
+    // 3. Store in history buffers, the oldest samples are dropped once full
+    m_error_history.push(error_adapt);
+    m_plant_output_history.push(plant_output_yp);
+    m_setpoint_history.push(setpoint_r);
 
     // 4. Check if enough data gathered
     if (m_is_tuning_active && !m_has_gathered_sufficient_data)
@@ -164,49 +243,16 @@ void AdaptivePIDTuner::getCurrentReferenceModelOutput(double &outYm) const
 }
 
 
-// --- Helper methods for analysis ---
-
-double AdaptivePIDTuner::calculateMean(const std::deque<double> &data) const
-{
-    if (data.empty()) return 0.0;
-    double sum = std::accumulate(data.begin(), data.end(), 0.0);
-    return sum / data.size();
-}
-
-double AdaptivePIDTuner::calculateStdDev(const std::deque<double> &data, double mean) const
-{
-    if (data.size() < 2) return 0.0;
-    double sq_sum = 0.0;
-    for (double val : data)
-    {
-        sq_sum += (val - mean) * (val - mean);
-    }
-    return std::sqrt(sq_sum / (data.size() - 1)); // Sample standard deviation
-}
-
-int AdaptivePIDTuner::countSignChanges(const std::deque<double> &data) const
-{
-    if (data.size() < 2) return 0;
-    int changes = 0;
-    for (size_t i = 0; i < data.size() - 1; ++i)
-    {
-        if ((data[i] > 0 && data[i + 1] < 0) || (data[i] < 0 && data[i + 1] > 0))
-        {
-            changes++;
-        }
-    }
-    return changes;
-}
-
 // This is the core heuristic logic - needs careful design and testing
 void AdaptivePIDTuner::analyzeErrorAndAdjustGains()
 {
     if (m_error_history.size() < m_min_data_for_tuning) return;
 
     // Characteristics of the adaptation error (e_adapt = plant_output - model_output)
-    double error_mean   = calculateMean(m_error_history);
-    double error_stddev = calculateStdDev(m_error_history, error_mean);
-    int error_oscillations = countSignChanges(m_error_history);
+    // Kept up to date by the window as samples come in, no pass over the history
+    double error_mean   = m_error_history.mean();
+    double error_stddev = m_error_history.stddev();
+    int error_oscillations = m_error_history.signChanges();
 
     // Characteristics of the plant output (yp) relative to setpoint (r)
     // This can give clues about overall system performance, not just model following.
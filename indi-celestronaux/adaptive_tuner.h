@@ -1,12 +1,66 @@
 #pragma once
 
 #include <vector>
-#include <deque>
 #include <cmath> // For std::fabs, std::sqrt
 
 // Forward declaration
 class PID;
 
+// Window over the latest samples, in a ring buffer of fixed capacity.
+// Mean, variance (Welford) and the number of sign changes between consecutive samples
+// are updated as samples enter and leave the window, in constant time per sample.
+class RunningWindow
+{
+    public:
+        explicit RunningWindow(size_t capacity = 100);
+
+        // Keeps the latest samples that fit
+        void setCapacity(size_t capacity);
+        size_t capacity() const
+        {
+            return m_buffer.size();
+        }
+        size_t size() const
+        {
+            return m_count;
+        }
+        bool empty() const
+        {
+            return m_count == 0;
+        }
+
+        void push(double value);
+        void clear();
+
+        // Oldest sample first
+        double operator[](size_t index) const
+        {
+            return m_buffer[(m_head + index) % m_buffer.size()];
+        }
+
+        double mean() const
+        {
+            return m_count > 0 ? m_mean : 0.0;
+        }
+        // Sample standard deviation
+        double stddev() const;
+        // Consecutive samples of strictly opposite signs
+        int signChanges() const
+        {
+            return m_sign_changes;
+        }
+
+    private:
+        void popOldest();
+
+        std::vector<double> m_buffer;
+        size_t m_head { 0 };  // Oldest sample
+        size_t m_count { 0 };
+        double m_mean { 0.0 };
+        double m_m2 { 0.0 };  // Sum of squared deviations from the mean
+        int m_sign_changes { 0 };
+};
+
 class AdaptivePIDTuner
 {
     public:
@@ -64,10 +118,10 @@ class AdaptivePIDTuner
         double m_aggressiveness { 1.0 }; // Multiplier for step sizes
 
         // History buffers for analysis
-        std::deque<double> m_error_history;      // e_adapt = plant_output_yp - y_m
-        std::deque<double> m_plant_output_history; // yp
-        std::deque<double> m_setpoint_history;     // r
         size_t m_history_size { 100 }; // e.g., 10 seconds of data if dt = 0.1s
+        RunningWindow m_error_history { m_history_size };        // e_adapt = plant_output_yp - y_m
+        RunningWindow m_plant_output_history { m_history_size }; // yp
+        RunningWindow m_setpoint_history { m_history_size };     // r
         size_t m_min_data_for_tuning { 50 }; // Need at least this much data to start tuning
 
         bool m_is_tuning_active { false };
@@ -75,7 +129,4 @@ class AdaptivePIDTuner
 
         // Helper methods for analysis (to be implemented in .cpp)
         void analyzeErrorAndAdjustGains();
-        double calculateMean(const std::deque<double> &data) const;
-        double calculateStdDev(const std::deque<double> &data, double mean) const;
-        int countSignChanges(const std::deque<double> &data) const;
 };
@@ -878,6 +878,8 @@ bool CelestronAUX::ISNewBLOB(const char *dev, const char *name, int sizes[], int
     {
         // Process alignment properties
         ProcessAlignmentBLOBProperties(this, name, sizes, blobsizes, blobs, formats, names, n);
+        if (strstr(name, "ALIGNMENT"))
+            m_TrackingPredictor.invalidate();
     }
     // Pass it up the chain
     return INDI::Telescope::ISNewBLOB(dev, name, sizes, blobsizes, blobs, formats, names, n);
@@ -999,6 +1001,8 @@ bool CelestronAUX::ISNewNumber(const char *dev, const char *name, double values[
 
         // Process Alignment Properties
         ProcessAlignmentNumberProperties(this, name, values, names, n);
+        if (strstr(name, "ALIGNMENT"))
+            m_TrackingPredictor.invalidate();
 
     }
 
@@ -1219,6 +1223,8 @@ bool CelestronAUX::ISNewSwitch(const char *dev, const char *name, ISState *state
 
         // Process alignment properties
         ProcessAlignmentSwitchProperties(this, name, states, names, n);
+        if (strstr(name, "ALIGNMENT"))
+            m_TrackingPredictor.invalidate();
 
         // Process Focus Properties
         if (strstr(name, "FOCUS_"))
@@ -1237,7 +1243,11 @@ bool CelestronAUX::ISNewSwitch(const char *dev, const char *name, ISState *state
 bool CelestronAUX::ISNewText(const char *dev, const char *name, char *texts[], char *names[], int n)
 {
     if (!strcmp(dev, getDeviceName()))
+    {
         ProcessAlignmentTextProperties(this, name, texts, names, n);
+        if (strstr(name, "ALIGNMENT"))
+            m_TrackingPredictor.invalidate();
+    }
 
     return INDI::Telescope::ISNewText(dev, name, texts, names, n);
 }
@@ -1561,6 +1571,7 @@ void CelestronAUX::resetTracking()
 
     m_TrackingElapsedTimer.restart();
     m_GuideOffset[AXIS_AZ] = m_GuideOffset[AXIS_ALT] = 0;
+    m_TrackingPredictor.invalidate();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -2135,55 +2146,71 @@ void CelestronAUX::TimerHit()
             // For Equatorial mount, we simply use user-selected tracking mode and let it passively track.
             else if (m_MountType == ALT_AZ)
             {
-                TelescopeDirectionVector TDV;
-                TelescopeDirectionVector futureTDV;
-                TelescopeDirectionVector pastTDV;
                 INDI::IHorizontalCoordinates targetMountAxisCoordinates { 0, 0 };
-                INDI::IHorizontalCoordinates pastMountAxisCoordinates { 0, 0 };
-                INDI::IHorizontalCoordinates futureMountAxisCoordinates { 0, 0 };
-                double timeStep { 5.0 }; // time step for tracking rate estimation in seconds
-                double JDoffset { timeStep / (60 * 60 * 24) } ; // The same in days
                 double JDnow {ln_get_julian_from_sys()};
 
-                // Start by transforming tracking target celestial coordinates to telescope coordinates.
-                if (TransformCelestialToTelescopeJD(m_SkyTrackingTarget.rightascension, m_SkyTrackingTarget.declination,
-                                                    JDnow, TDV))
+                // Mount axis position of the tracking target at any time
+                TrackingPredictor::Transform transform = [this](double jd, double &azimuth, double &altitude)
                 {
-                    // If mount is Alt-Az then that's all we need to do
-                    AltitudeAzimuthFromTelescopeDirectionVector(TDV, targetMountAxisCoordinates);
-                    TransformCelestialToTelescopeJD(m_SkyTrackingTarget.rightascension, m_SkyTrackingTarget.declination,
-                                                    JDnow + JDoffset, futureTDV);
-                    AltitudeAzimuthFromTelescopeDirectionVector(futureTDV, futureMountAxisCoordinates);
-                    TransformCelestialToTelescopeJD(m_SkyTrackingTarget.rightascension, m_SkyTrackingTarget.declination,
-                                                    JDnow - JDoffset, pastTDV);
-                    AltitudeAzimuthFromTelescopeDirectionVector(pastTDV, pastMountAxisCoordinates);
+                    TelescopeDirectionVector TDV;
+                    INDI::IHorizontalCoordinates coordinates { 0, 0 };
+                    if (TransformCelestialToTelescopeJD(m_SkyTrackingTarget.rightascension, m_SkyTrackingTarget.declination,
+                                                        jd, TDV))
+                        AltitudeAzimuthFromTelescopeDirectionVector(TDV, coordinates);
+                    // If transformation failed.
+                    else
+                        INDI::EquatorialToHorizontal(&m_SkyTrackingTarget, &m_Location, jd, &coordinates);
 
-                }
-                // If transformation failed.
-                else
+                    azimuth = coordinates.azimuth;
+                    altitude = coordinates.altitude;
+                    return true;
+                };
+
+                // Drop the cached trajectory if the target or the alignment changed under us
+                if (m_PredictedTarget.rightascension != m_SkyTrackingTarget.rightascension ||
+                        m_PredictedTarget.declination != m_SkyTrackingTarget.declination ||
+                        m_PredictedAlignmentSize != GetAlignmentDatabase().size())
                 {
-                    INDI::IEquatorialCoordinates EquatorialCoordinates { 0, 0 };
-                    EquatorialCoordinates.rightascension  = m_SkyTrackingTarget.rightascension;
-                    EquatorialCoordinates.declination = m_SkyTrackingTarget.declination;
-                    INDI::EquatorialToHorizontal(&EquatorialCoordinates, &m_Location, JDnow, &targetMountAxisCoordinates);
-                    INDI::EquatorialToHorizontal(&EquatorialCoordinates, &m_Location, JDnow + JDoffset, &futureMountAxisCoordinates);
-                    INDI::EquatorialToHorizontal(&EquatorialCoordinates, &m_Location, JDnow - JDoffset, &pastMountAxisCoordinates);
+                    m_PredictedTarget = m_SkyTrackingTarget;
+                    m_PredictedAlignmentSize = GetAlignmentDatabase().size();
+                    m_TrackingPredictor.invalidate();
                 }
 
-
                 // Calculate expected tracking rates
-                double predRate[2] = {0, 0};
-                // Central difference, error quadratic in timestep
                 // Rates in deg/s
-                predRate[AXIS_AZ] = range180(AzimuthToDegrees(futureMountAxisCoordinates.azimuth - pastMountAxisCoordinates.azimuth)) /
-                                    timeStep / 2;
-                predRate[AXIS_ALT] = (futureMountAxisCoordinates.altitude - pastMountAxisCoordinates.altitude) / timeStep / 2;
-
-                LOGF_DEBUG("Predicted positions (AZ):  %9.4f  %9.4f (now, future, degs)",
-                           AzimuthToDegrees(targetMountAxisCoordinates.azimuth),
-                           AzimuthToDegrees(futureMountAxisCoordinates.azimuth)) ;
-                LOGF_DEBUG("Predicted positions (AL):  %9.4f  %9.4f (now, future, degs)", targetMountAxisCoordinates.altitude,
-                           futureMountAxisCoordinates.altitude);
+                double predRate[2] = {0, 0};
+                TrackingPredictor::Prediction prediction;
+                if (m_TrackingPredictor.predict(JDnow, transform, prediction))
+                {
+                    targetMountAxisCoordinates.azimuth = prediction.azimuth;
+                    targetMountAxisCoordinates.altitude = prediction.altitude;
+                    predRate[AXIS_AZ] = prediction.azimuthRate;
+                    predRate[AXIS_ALT] = prediction.altitudeRate;
+
+                    LOGF_DEBUG("Tracking model: %.0f s horizon, %.3f arcsec fit error, %u fits",
+                               m_TrackingPredictor.getSpan(), m_TrackingPredictor.getFitError(),
+                               m_TrackingPredictor.getFitCount());
+                }
+                // No model within tolerance, e.g. passing through the zenith: transform at every tick.
+                else
+                {
+                    double timeStep { 5.0 }; // time step for tracking rate estimation in seconds
+                    double JDoffset { timeStep / (60 * 60 * 24) } ; // The same in days
+                    INDI::IHorizontalCoordinates pastMountAxisCoordinates { 0, 0 };
+                    INDI::IHorizontalCoordinates futureMountAxisCoordinates { 0, 0 };
+
+                    transform(JDnow, targetMountAxisCoordinates.azimuth, targetMountAxisCoordinates.altitude);
+                    transform(JDnow + JDoffset, futureMountAxisCoordinates.azimuth, futureMountAxisCoordinates.altitude);
+                    transform(JDnow - JDoffset, pastMountAxisCoordinates.azimuth, pastMountAxisCoordinates.altitude);
+
+                    // Central difference, error quadratic in timestep
+                    predRate[AXIS_AZ] = range180(futureMountAxisCoordinates.azimuth - pastMountAxisCoordinates.azimuth) /
+                                        timeStep / 2;
+                    predRate[AXIS_ALT] = (futureMountAxisCoordinates.altitude - pastMountAxisCoordinates.altitude) / timeStep / 2;
+                }
+
+                LOGF_DEBUG("Predicted positions (AZ, AL):  %9.4f  %9.4f (now, degs)",
+                           AzimuthToDegrees(targetMountAxisCoordinates.azimuth), targetMountAxisCoordinates.altitude);
                 LOGF_DEBUG("Predicted Rates (AZ, ALT): %9.4f  %9.4f (arcsec/s)", 3600 * predRate[AXIS_AZ], 3600 * predRate[AXIS_ALT]);
 
                 // Rates in units 1024 * arcsec/s
@@ -2395,6 +2422,7 @@ bool CelestronAUX::updateLocation(double latitude, double longitude, double elev
 {
     // Update INDI Alignment Subsystem Location
     UpdateLocation(latitude, longitude, elevation);
+    m_TrackingPredictor.invalidate();
 
     // Do we really need this in update Location??
     // take care of latitude for north or south emisphere
@@ -42,6 +42,7 @@
 
 #include "auxproto.h"
 #include "adaptive_tuner.h"
+#include "tracking_predictor.h"
 
 class CelestronAUX :
     public INDI::Telescope,
@@ -318,6 +319,12 @@ class CelestronAUX :
         INDI::IEquatorialCoordinates m_SkyTrackingTarget { 0, 0 };
         INDI::IEquatorialCoordinates m_SkyGOTOTarget { 0, 0 };
 
+        // Mount axis trajectory of the tracking target, refitted a few times per minute.
+        // The model is dropped when the target, the location or the alignment changes.
+        TrackingPredictor m_TrackingPredictor;
+        INDI::IEquatorialCoordinates m_PredictedTarget { 0, 0 };
+        size_t m_PredictedAlignmentSize { 0 };
+
         // Actual Sky Equatorial Coordinates
         INDI::IEquatorialCoordinates m_SkyCurrentRADE {0, 0};
 
@@ -0,0 +1,167 @@
+/*
+    Celestron Aux Mount Driver - Closed loop simulation of an alt-az axis
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "aux_axis_simulation.h"
+
+#include "adaptive_tuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+
+namespace
+{
+// Same as the driver
+constexpr double MIN_TRACK_RATE_FACTOR = 0.1;
+constexpr double PID_LIMIT = 10000;
+constexpr double PID_TAU = 2.0;
+// Plant integration step, s
+constexpr double SUBSTEP = 0.01;
+
+double threadNanoseconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+}
+
+AuxAxisSimulation::AuxAxisSimulation(double dt, double kp, double ki, double kd)
+    : m_dt(dt), m_pid { dt, kp, ki, kd }
+{
+}
+
+double AuxAxisSimulation::PID::calculate(double setpoint, double measurement)
+{
+    double error = setpoint - measurement;
+
+    double proportional = kp * error;
+
+    integral += 0.5 * ki * dt * (error + previousError);
+    integral = std::max(-PID_LIMIT, std::min(PID_LIMIT, integral));
+
+    // Band limited derivative on the measurement
+    derivative = -(2.0 * kd * (measurement - previousMeasurement) + (2.0 * PID_TAU - dt) * derivative) /
+                 (2.0 * PID_TAU + dt);
+
+    previousError = error;
+    previousMeasurement = measurement;
+
+    return std::max(-PID_LIMIT, std::min(PID_LIMIT, proportional + integral + derivative));
+}
+
+AuxAxisSimulation::Result AuxAxisSimulation::run(AdaptivePIDTuner *tuner, double duration)
+{
+    Result result;
+    std::mt19937 random(plant.seed);
+    std::normal_distribution<double> normal(0.0, 1.0);
+
+    // Target and axis start together, the gap taken up in the tracking direction
+    const double start = 180 * AUX_STEPS_PER_DEGREE;
+    double target = start;
+    double motor = start + plant.backlash / 2;
+    double motorRate = trajectory.rate;
+    double gap = plant.backlash / 2;
+    double gust = 0;
+    double axis = start;
+
+    double sumSquares = 0;
+    size_t samples = 0;
+    double tunerTime = 0;
+
+    std::vector<double> kp, ki, kd;
+    size_t ticks = static_cast<size_t>(duration / m_dt);
+
+    for (size_t tick = 0; tick < ticks; tick++)
+    {
+        double t = tick * m_dt;
+        double encoder = std::floor(axis);
+
+        if (tuner != nullptr)
+        {
+            double begin = threadNanoseconds();
+            tuner->processMeasurement(target, encoder);
+            if (tuner->isActivelyTuning())
+                tuner->getAdaptedGains(m_pid.kp, m_pid.ki, m_pid.kd);
+            tunerTime += threadNanoseconds() - begin;
+        }
+        kp.push_back(m_pid.kp);
+        ki.push_back(m_pid.ki);
+        kd.push_back(m_pid.kd);
+
+        // Tracking law of the driver: predicted rate corrected by the PID
+        double predictedRate = trajectory.rate + trajectory.acceleration * t;
+        double offset = target - encoder;
+        double rate = predictedRate + m_pid.calculate(0, -offset);
+        double minRate = predictedRate * MIN_TRACK_RATE_FACTOR;
+        if (rate * predictedRate < 0 || std::fabs(rate) < std::fabs(minRate))
+            rate = minRate;
+
+        for (double elapsed = 0; elapsed < m_dt - SUBSTEP / 2; elapsed += SUBSTEP)
+        {
+            double now = t + elapsed;
+
+            motorRate += (rate * (1 - plant.rateError) - motorRate) * SUBSTEP / plant.motorLag;
+            motor += motorRate * SUBSTEP;
+
+            // Ornstein-Uhlenbeck gusts
+            gust += -gust * SUBSTEP / plant.windTime + plant.windGust * std::sqrt(2 * SUBSTEP / plant.windTime) * normal(random);
+            double wind = plant.windMean + gust;
+
+            // Friction keeps the axis behind the motor, a stronger wind pushes it across the gap
+            double load = plant.friction - wind;
+            gap += (load > 0 ? 1 : -1) * plant.gapSpeed * SUBSTEP;
+            gap = std::max(-plant.backlash / 2, std::min(plant.backlash / 2, gap));
+            axis = motor - gap - plant.compliance * wind;
+
+            target = start + trajectory.rate * (now + SUBSTEP) + 0.5 * trajectory.acceleration * (now + SUBSTEP) * (now + SUBSTEP);
+        }
+
+        if (t >= settleTime)
+        {
+            double error = (axis - target) / AUX_STEPS_PER_DEGREE * 3600;
+            sumSquares += error * error;
+            result.trackingPeak = std::max(result.trackingPeak, std::fabs(error));
+            samples++;
+        }
+    }
+
+    result.ticks = ticks;
+    result.trackingRMS = samples > 0 ? std::sqrt(sumSquares / samples) : 0;
+    result.finalKp = m_pid.kp;
+    result.finalKi = m_pid.ki;
+    result.finalKd = m_pid.kd;
+    result.tunerNanoseconds = ticks > 0 ? tunerTime / ticks : 0;
+
+    auto away = [](double gain, double final)
+    {
+        return std::fabs(gain - final) > 0.01 * std::max(std::fabs(final), 1e-3);
+    };
+    for (size_t tick = ticks; tick-- > 0; )
+    {
+        if (away(kp[tick], result.finalKp) || away(ki[tick], result.finalKi) || away(kd[tick], result.finalKd))
+        {
+            result.settleTime = (tick + 1) * m_dt;
+            break;
+        }
+    }
+
+    return result;
+}
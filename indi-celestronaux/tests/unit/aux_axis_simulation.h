@@ -0,0 +1,102 @@
+/*
+    Celestron Aux Mount Driver - Closed loop simulation of an alt-az axis
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+class AdaptivePIDTuner;
+
+// Encoder steps per degree of the AUX motor controllers
+constexpr double AUX_STEPS_PER_DEGREE = 16777216.0 / 360.0;
+
+/*
+    One axis of an alt-az mount under the driver's tracking loop, without a mount.
+
+    The motor follows the commanded rate with a first order lag and a rate error. The axis is driven through a
+    gear train with backlash: the gap is taken up in the tracking direction by friction, and wind gusts strong
+    enough to overcome it push the axis across the gap, besides bending the structure. The encoder reads the
+    axis in whole steps.
+
+    Every tick, as the driver does, the tuner is fed the target and the encoder, the PID gains are taken from
+    the tuner while it tunes, and the rate sent is the predicted rate plus the PID correction.
+ */
+class AuxAxisSimulation
+{
+    public:
+        struct Plant
+        {
+            double motorLag { 0.3 };        // Motor time constant, s
+            double rateError { 0.02 };      // Relative motor rate error
+            double backlash { 400 };        // Gear gap, steps
+            double gapSpeed { 2000 };       // Speed the axis crosses the gap at, steps/s
+            double friction { 1.0 };        // Load keeping the gap taken up in the tracking direction
+            double windMean { 0.3 };        // Mean wind load, relative to friction
+            double windGust { 1.0 };        // Standard deviation of the gusts, relative to friction
+            double windTime { 2.0 };        // Correlation time of the gusts, s
+            double compliance { 30 };       // Bending per unit of load, steps
+            uint32_t seed { 1 };
+        };
+
+        struct Trajectory
+        {
+            double rate { 150 };            // Initial target rate, steps/s (about 12"/s)
+            double acceleration { 0.5 };    // steps/s²
+        };
+
+        struct Result
+        {
+            size_t ticks { 0 };
+            // Axis against target, after settleTime
+            double trackingRMS { 0 };       // arcsec
+            double trackingPeak { 0 };      // arcsec
+            double finalKp { 0 }, finalKi { 0 }, finalKd { 0 };
+            // Time of the last gain change larger than 1% of the final gains, s
+            double settleTime { 0 };
+            // Thread CPU time spent in the tuner per tick
+            double tunerNanoseconds { 0 };
+        };
+
+        AuxAxisSimulation(double dt, double kp, double ki, double kd);
+
+        Plant plant;
+        Trajectory trajectory;
+        // Tracking errors before this are left out of the result, s
+        double settleTime { 60 };
+
+        // The tuner may be null, the PID then keeps its gains
+        Result run(AdaptivePIDTuner *tuner, double duration);
+
+    private:
+        // Same discretisation as INDI::PID, tau = 2
+        struct PID
+        {
+            double dt, kp, ki, kd;
+            double integral { 0 }, derivative { 0 };
+            double previousError { 0 }, previousMeasurement { 0 };
+
+            double calculate(double setpoint, double measurement);
+        };
+
+        double m_dt;
+        PID m_pid;
+};
@@ -0,0 +1,222 @@
+/*
+    Celestron Aux Mount Driver - Adaptive PID tuner offline tests
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <gtest/gtest.h>
+
+#include "adaptive_tuner.h"
+#include "aux_axis_simulation.h"
+
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <random>
+
+namespace
+{
+// Tuner set up as the driver does for the azimuth axis
+void configure(AdaptivePIDTuner &tuner, size_t history)
+{
+    tuner.setGainLimits(0, 500, 0, 500, 0, 500);
+    tuner.setAdaptationStepSizes(0.05, 0.005, 0.005);
+    tuner.setHistorySize(history);
+}
+
+// Recomputed over the whole window, as the tuner did before
+void check(const RunningWindow &window, const std::deque<double> &samples)
+{
+    ASSERT_EQ(window.size(), samples.size());
+
+    double mean = 0, squares = 0;
+    int changes = 0;
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        mean += samples[i];
+        if (i > 0 && ((samples[i - 1] > 0 && samples[i] < 0) || (samples[i - 1] < 0 && samples[i] > 0)))
+            changes++;
+    }
+    mean /= samples.size();
+    for (double sample : samples)
+        squares += (sample - mean) * (sample - mean);
+
+    EXPECT_NEAR(window.mean(), mean, 1e-9 * std::max(1.0, std::fabs(mean)));
+    EXPECT_NEAR(window.stddev(), samples.size() > 1 ? std::sqrt(squares / (samples.size() - 1)) : 0, 1e-6);
+    EXPECT_EQ(window.signChanges(), changes);
+}
+}
+
+TEST(RunningWindow, MatchesRecomputedStatistics)
+{
+    // Samples around zero, with runs of zeros, then around an encoder position
+    for (double offset : {0.0, 1e7})
+    {
+        RunningWindow window(50);
+        std::deque<double> samples;
+        std::mt19937 random(3);
+        std::normal_distribution<double> normal(0.0, 2.0);
+
+        for (int i = 0; i < 2000; i++)
+        {
+            double value = offset + (i % 97 < 5 ? 0.0 : normal(random));
+            window.push(value);
+            samples.push_back(value);
+            if (samples.size() > 50)
+                samples.pop_front();
+            check(window, samples);
+        }
+    }
+}
+
+TEST(RunningWindow, KeepsLatestSamplesOnResize)
+{
+    RunningWindow window(10);
+    std::deque<double> samples;
+
+    for (int i = 1; i <= 25; i++)
+    {
+        window.push(i % 2 ? i : -i);
+        samples.push_back(i % 2 ? i : -i);
+    }
+
+    window.setCapacity(4);
+    samples.erase(samples.begin(), samples.end() - 4);
+    check(window, samples);
+    EXPECT_EQ(window[0], -22);
+    EXPECT_EQ(window[3], 25);
+
+    window.setCapacity(20);
+    window.push(26);
+    samples.push_back(26);
+    check(window, samples);
+
+    window.clear();
+    EXPECT_TRUE(window.empty());
+    EXPECT_EQ(window.mean(), 0);
+    EXPECT_EQ(window.stddev(), 0);
+    EXPECT_EQ(window.signChanges(), 0);
+}
+
+TEST(RunningWindow, ConstantStorageAfterWrapAround)
+{
+    // Many times around the ring, at an encoder position: nothing grows and the running sums do not drift
+    const size_t capacity = 100;
+    RunningWindow window(capacity);
+    std::deque<double> samples;
+    std::mt19937 random(7);
+    std::normal_distribution<double> normal(0.0, 20.0);
+
+    for (int i = 0; i < 1000000; i++)
+    {
+        double value = 1e7 + normal(random);
+        window.push(value);
+        samples.push_back(value);
+        if (samples.size() > capacity)
+            samples.pop_front();
+    }
+
+    EXPECT_EQ(window.capacity(), capacity);
+    check(window, samples);
+    for (size_t i = 0; i < capacity; i++)
+        EXPECT_EQ(window[i], samples[i]);
+}
+
+TEST(AdaptivePIDTuner, TickCostIndependentOfHistory)
+{
+    const int ticks = 40000;
+    double seconds[2];
+    size_t histories[2] = { 100, 10000 };
+
+    for (int i = 0; i < 2; i++)
+    {
+        AdaptivePIDTuner tuner(1.0, 1.0, 0.05, 0.0, 0.5, 1.0);
+        configure(tuner, histories[i]);
+        tuner.startActiveTuning();
+
+        std::mt19937 random(5);
+        std::normal_distribution<double> noise(0.0, 20.0);
+        auto start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < ticks; tick++)
+            tuner.processMeasurement(tick * 150.0, tick * 150.0 + noise(random));
+        seconds[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        EXPECT_TRUE(tuner.isActivelyTuning());
+    }
+
+    std::cout << "Tuner tick: " << seconds[0] / ticks * 1e9 << " ns with 100 samples, "
+              << seconds[1] / ticks * 1e9 << " ns with 10000 samples" << std::endl;
+}
+
+TEST(AuxAxisSimulation, TracksWithFixedGains)
+{
+    AuxAxisSimulation simulation(1.0, 0.5, 0.05, 0.0);
+    AuxAxisSimulation::Result result = simulation.run(nullptr, 1800);
+
+    std::cout << "Fixed gains: tracking RMS " << result.trackingRMS << "\", peak " << result.trackingPeak << "\"" << std::endl;
+
+    // Backlash and gusts, about 30" of gap crossed back and forth
+    EXPECT_LT(result.trackingRMS, 20);
+    EXPECT_LT(result.trackingPeak, 60);
+    EXPECT_EQ(result.settleTime, 0);
+
+    // Without the gap and the wind, only the motor lag and the rate error are left
+    AuxAxisSimulation calm(1.0, 0.5, 0.05, 0.0);
+    calm.plant.backlash = 0;
+    calm.plant.windMean = calm.plant.windGust = 0;
+    EXPECT_LT(calm.run(nullptr, 1800).trackingRMS, 1);
+}
+
+TEST(AuxAxisSimulation, AdaptiveTuning)
+{
+    AuxAxisSimulation::Result results[2];
+
+    for (AuxAxisSimulation::Result &result : results)
+    {
+        AdaptivePIDTuner tuner(1.0, 0.5, 0.05, 0.0, 0.5, 1.0);
+        configure(tuner, 100);
+        tuner.startActiveTuning();
+
+        AuxAxisSimulation simulation(1.0, 0.5, 0.05, 0.0);
+        result = simulation.run(&tuner, 1800);
+    }
+
+    const AuxAxisSimulation::Result &result = results[0];
+    std::cout << "Adaptive tuning: Kp " << result.finalKp << " Ki " << result.finalKi << " Kd " << result.finalKd
+              << " settled after " << result.settleTime << " s, tracking RMS " << result.trackingRMS << "\", "
+              << result.tunerNanoseconds << " ns per tick" << std::endl;
+
+    // Deterministic, so that changes of the heuristics can be compared
+    EXPECT_EQ(results[1].trackingRMS, result.trackingRMS);
+    EXPECT_EQ(results[1].finalKd, result.finalKd);
+
+    EXPECT_LE(result.finalKd, 500);
+
+    // The reference model starts from zero and lags the ramp of the target, so the adaptation error never
+    // averages out: the rules drive Kp and Ki to their lower limit and tracking is lost. Pinned here so that a
+    // change of the heuristics shows up, expected to become a bound on the tracking RMS once they converge.
+    EXPECT_EQ(result.finalKp, 0);
+    EXPECT_EQ(result.finalKi, 0);
+    EXPECT_GT(result.trackingRMS, 1000);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,268 @@
+/*
+    Celestron Aux Mount Driver - Tracking prediction offline tests
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <gtest/gtest.h>
+
+#include "tracking_predictor.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+constexpr double LATITUDE = 45.0;
+constexpr double LONGITUDE = 10.0;
+constexpr double JD_START = 2461000.5;
+constexpr double SECONDS_PER_DAY = 86400.0;
+constexpr double DEG = M_PI / 180;
+
+double wrap180(double degrees)
+{
+    degrees = std::fmod(degrees, 360.0);
+    if (degrees > 180)
+        degrees -= 360;
+    else if (degrees <= -180)
+        degrees += 360;
+    return degrees;
+}
+
+// Stands in for the alignment subsystem: sidereal time, equatorial to horizontal and a
+// small mount misalignment, so the trajectory is not a pure rotation.
+struct SkyModel
+{
+    double ra { 0 };     // hours
+    double dec { 0 };    // degrees
+
+    bool operator()(double jd, double &azimuth, double &altitude) const
+    {
+        return position(jd, 0, azimuth, altitude);
+    }
+
+    // The offset in seconds is added after the epoch is removed, to keep sub millisecond resolution
+    bool position(double jd, double seconds, double &azimuth, double &altitude) const
+    {
+        double gmst = 280.46061837 + 360.98564736629 * ((jd - 2451545.0) + seconds / SECONDS_PER_DAY);
+        double ha = (gmst + LONGITUDE - ra * 15) * DEG;
+        double lat = LATITUDE * DEG, d = dec * DEG;
+
+        double x = -std::cos(d) * std::sin(ha);
+        double y = std::sin(d) * std::cos(lat) - std::cos(d) * std::cos(ha) * std::sin(lat);
+        double z = std::sin(d) * std::sin(lat) + std::cos(d) * std::cos(ha) * std::cos(lat);
+
+        // Base tilted by 0.1 degree towards the east
+        const double tilt = 0.1 * DEG;
+        double xt = x * std::cos(tilt) - z * std::sin(tilt);
+        double zt = x * std::sin(tilt) + z * std::cos(tilt);
+
+        azimuth = std::atan2(xt, y) / DEG + 0.05;
+        if (azimuth < 0)
+            azimuth += 360;
+        altitude = std::asin(std::max(-1.0, std::min(1.0, zt))) / DEG;
+        return true;
+    }
+};
+
+struct Statistics
+{
+    double maxPositionError { 0 };   // arcsec
+    double maxRateError { 0 };       // arcsec/s
+    uint64_t ticks { 0 };
+    uint64_t fallbacks { 0 };
+    uint64_t transforms { 0 };
+    double seconds { 0 };
+};
+
+// The previous method: three transforms per tick, central difference over +/- 5 s
+void directRate(const SkyModel &sky, double jd, TrackingPredictor::Prediction &prediction, uint64_t &transforms)
+{
+    const double step = 5.0;
+    double pastAz, pastAlt, futureAz, futureAlt;
+    sky(jd, prediction.azimuth, prediction.altitude);
+    sky(jd + step / SECONDS_PER_DAY, futureAz, futureAlt);
+    sky(jd - step / SECONDS_PER_DAY, pastAz, pastAlt);
+    prediction.azimuthRate = wrap180(futureAz - pastAz) / step / 2;
+    prediction.altitudeRate = (futureAlt - pastAlt) / step / 2;
+    transforms += 3;
+}
+
+void truth(const SkyModel &sky, double jd, TrackingPredictor::Prediction &prediction)
+{
+    const double step = 0.01;
+    double pastAz, pastAlt, futureAz, futureAlt;
+    sky(jd, prediction.azimuth, prediction.altitude);
+    sky.position(jd, step, futureAz, futureAlt);
+    sky.position(jd, -step, pastAz, pastAlt);
+    prediction.azimuthRate = wrap180(futureAz - pastAz) / step / 2;
+    prediction.altitudeRate = (futureAlt - pastAlt) / step / 2;
+}
+
+void accumulate(Statistics &statistics, const TrackingPredictor::Prediction &p, const TrackingPredictor::Prediction &t)
+{
+    statistics.maxPositionError = std::max({statistics.maxPositionError,
+                                            std::fabs(wrap180(p.azimuth - t.azimuth)) * 3600,
+                                            std::fabs(p.altitude - t.altitude) * 3600});
+    statistics.maxRateError = std::max({statistics.maxRateError,
+                                        std::fabs(p.azimuthRate - t.azimuthRate) * 3600,
+                                        std::fabs(p.altitudeRate - t.altitudeRate) * 3600});
+}
+
+// Targets all over the visible sky, plus targets culminating close to the zenith
+std::vector<SkyModel> targets()
+{
+    std::vector<SkyModel> result;
+
+    double lst = std::fmod(280.46061837 + 360.98564736629 * (JD_START - 2451545.0) + LONGITUDE, 360.0);
+    if (lst < 0)
+        lst += 360;
+
+    for (double ha = -75; ha <= 75; ha += 15)
+        for (double dec = -30; dec <= 86; dec += 8)
+            result.push_back({std::fmod(lst - ha + 360, 360) / 15, dec});
+
+    // Culminating 5 minutes after the start of tracking
+    for (double offset : {-2.0, -1.0, -0.5, -0.25, 0.0, 0.25, 0.5, 1.0, 2.0})
+        result.push_back({std::fmod(lst + 1.25 + 360, 360) / 15, LATITUDE + offset});
+
+    return result;
+}
+}
+
+TEST(TrackingPredictor, FitsSmoothTrajectory)
+{
+    SkyModel sky { 3, 20 };
+    TrackingPredictor predictor;
+    TrackingPredictor::Transform transform = [&](double jd, double &az, double &alt)
+    {
+        return sky(jd, az, alt);
+    };
+
+    TrackingPredictor::Prediction prediction, reference;
+    ASSERT_TRUE(predictor.predict(JD_START, transform, prediction));
+    EXPECT_TRUE(predictor.isValid());
+    EXPECT_DOUBLE_EQ(predictor.getSpan(), 120);
+    EXPECT_LT(predictor.getFitError(), 0.1);
+
+    truth(sky, JD_START + 30 / SECONDS_PER_DAY, reference);
+    ASSERT_TRUE(predictor.predict(JD_START + 30 / SECONDS_PER_DAY, transform, prediction));
+    EXPECT_NEAR(prediction.azimuth, reference.azimuth, 0.1 / 3600);
+    EXPECT_NEAR(prediction.altitudeRate, reference.altitudeRate, 0.001 / 3600);
+
+    // One fit per horizon, refit once past its end or when invalidated
+    uint32_t transforms = predictor.getTransformCount();
+    predictor.predict(JD_START + 119 / SECONDS_PER_DAY, transform, prediction);
+    EXPECT_EQ(predictor.getTransformCount(), transforms);
+    predictor.predict(JD_START + 121 / SECONDS_PER_DAY, transform, prediction);
+    EXPECT_EQ(predictor.getFitCount(), 2u);
+    predictor.invalidate();
+    predictor.predict(JD_START + 122 / SECONDS_PER_DAY, transform, prediction);
+    EXPECT_EQ(predictor.getFitCount(), 3u);
+
+    // A failing transform is reported, so the caller can fall back
+    TrackingPredictor::Transform failing = [](double, double &, double &)
+    {
+        return false;
+    };
+    predictor.invalidate();
+    EXPECT_FALSE(predictor.predict(JD_START, failing, prediction));
+    EXPECT_FALSE(predictor.isValid());
+}
+
+TEST(TrackingPredictor, SkySweepAgainstDirectTransform)
+{
+    const double duration = 600, tick = 1;
+    const double tolerance = 0.1;
+
+    Statistics direct, cached, nearZenith;
+    std::vector<SkyModel> sky = targets();
+
+    for (const SkyModel &target : sky)
+    {
+        TrackingPredictor predictor;
+        predictor.setTolerance(tolerance);
+        TrackingPredictor::Transform transform = [&](double jd, double &az, double &alt)
+        {
+            return target(jd, az, alt);
+        };
+
+        bool zenith = std::fabs(target.dec - LATITUDE) <= 2;
+        Statistics &statistics = zenith ? nearZenith : cached;
+
+        for (double t = 0; t < duration; t += tick)
+        {
+            double jd = JD_START + t / SECONDS_PER_DAY;
+            TrackingPredictor::Prediction expected, old, predicted;
+            truth(target, jd, expected);
+
+            auto start = std::chrono::steady_clock::now();
+            directRate(target, jd, old, direct.transforms);
+            auto middle = std::chrono::steady_clock::now();
+            bool valid = predictor.predict(jd, transform, predicted);
+            if (!valid)
+            {
+                directRate(target, jd, predicted, statistics.transforms);
+                statistics.fallbacks++;
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            direct.seconds += std::chrono::duration<double>(middle - start).count();
+            statistics.seconds += std::chrono::duration<double>(end - middle).count();
+            direct.ticks++;
+            statistics.ticks++;
+
+            // Rates are compared away from the zenith only, where the direct method is meaningful
+            if (!zenith)
+                accumulate(direct, old, expected);
+            if (valid)
+                accumulate(statistics, predicted, expected);
+        }
+
+        statistics.transforms += predictor.getTransformCount();
+    }
+
+    auto report = [](const char *name, const Statistics &s)
+    {
+        std::cout << name << ": " << s.ticks << " ticks, " << static_cast<double>(s.transforms) / s.ticks
+                  << " transforms/tick, " << s.seconds / s.ticks * 1e9 << " ns/tick, max position error "
+                  << s.maxPositionError << "\", max rate error " << s.maxRateError << "\"/s, "
+                  << s.fallbacks << " fallbacks" << std::endl;
+    };
+    report("Direct     ", direct);
+    report("Cached     ", cached);
+    report("Near zenith", nearZenith);
+
+    // Away from the zenith the model is always used and within tolerance
+    EXPECT_EQ(cached.fallbacks, 0u);
+    EXPECT_LE(cached.maxPositionError, tolerance);
+    EXPECT_LE(cached.maxRateError, direct.maxRateError);
+    EXPECT_LT(static_cast<double>(cached.transforms) / cached.ticks, 0.25);
+
+    // Close to the zenith the model either meets the tolerance or hands over to the transform
+    EXPECT_LE(nearZenith.maxPositionError, tolerance);
+    EXPECT_GT(nearZenith.fallbacks, 0u);
+    EXPECT_LT(nearZenith.fallbacks, nearZenith.ticks / 4);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,220 @@
+/*
+    Celestron Aux Mount Driver - Tracking trajectory prediction
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "tracking_predictor.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr double SECONDS_PER_DAY = 86400.0;
+
+double wrap180(double degrees)
+{
+    degrees = std::fmod(degrees, 360.0);
+    if (degrees > 180)
+        degrees -= 360;
+    else if (degrees <= -180)
+        degrees += 360;
+    return degrees;
+}
+
+double wrap360(double degrees)
+{
+    degrees = std::fmod(degrees, 360.0);
+    return degrees < 0 ? degrees + 360 : degrees;
+}
+}
+
+TrackingPredictor::TrackingPredictor()
+{
+    m_NextSpan = m_MaximumSpan;
+}
+
+void TrackingPredictor::setTolerance(double arcsec)
+{
+    m_Tolerance = arcsec;
+    invalidate();
+}
+
+void TrackingPredictor::setHorizon(double minimum, double maximum)
+{
+    m_MinimumSpan = std::max(0.1, minimum);
+    m_MaximumSpan = std::max(m_MinimumSpan, maximum);
+    invalidate();
+}
+
+void TrackingPredictor::invalidate()
+{
+    m_Valid = false;
+    m_RetryAfter = 0;
+    m_NextSpan = m_MaximumSpan;
+}
+
+bool TrackingPredictor::sample(const Transform &transform, double jd, double &azimuth, double &altitude)
+{
+    m_TransformCount++;
+    return transform(jd, azimuth, altitude);
+}
+
+bool TrackingPredictor::predict(double jd, const Transform &transform, Prediction &prediction)
+{
+    double elapsed = (jd - m_Start) * SECONDS_PER_DAY;
+
+    if (!m_Valid || elapsed < 0 || elapsed > m_Span)
+    {
+        // The target could not be modeled recently, let the caller use the transform
+        if (!m_Valid && jd < m_RetryAfter)
+            return false;
+
+        if (!fit(jd, transform))
+        {
+            m_RetryAfter = jd + m_MinimumSpan / SECONDS_PER_DAY;
+            return false;
+        }
+        elapsed = 0;
+    }
+
+    // Map the time to the Chebyshev domain [-1, 1]
+    double x = 2 * elapsed / m_Span - 1;
+    double scale = 2 / m_Span;
+    double azimuth, altitude;
+
+    evaluate(0, x, azimuth, prediction.azimuthRate);
+    evaluate(1, x, altitude, prediction.altitudeRate);
+
+    prediction.azimuth = wrap360(m_AzimuthOrigin + azimuth);
+    prediction.altitude = altitude;
+    prediction.azimuthRate *= scale;
+    prediction.altitudeRate *= scale;
+
+    return true;
+}
+
+bool TrackingPredictor::fit(double jd, const Transform &transform)
+{
+    m_Valid = false;
+
+    double span = std::min(std::max(m_NextSpan, m_MinimumSpan), m_MaximumSpan);
+    while (true)
+    {
+        double error = 0;
+        if (!fitSpan(jd, span, transform, error))
+            return false;
+
+        m_FitError = error;
+
+        if (error <= m_Tolerance)
+            break;
+
+        if (span <= m_MinimumSpan)
+            return false;
+
+        span = std::max(m_MinimumSpan, span / 2);
+    }
+
+    m_Valid = true;
+    m_Start = jd;
+    m_Span = span;
+    m_FitCount++;
+
+    // Try a longer horizon again next time, the trajectory may have become smoother
+    m_NextSpan = std::min(span * 2, m_MaximumSpan);
+
+    return true;
+}
+
+bool TrackingPredictor::fitSpan(double jd, double span, const Transform &transform, double &error)
+{
+    double values[2][NODES];
+    double nodes[NODES];
+
+    // Sample at the Chebyshev nodes of the horizon
+    for (int k = 0; k < NODES; k++)
+    {
+        nodes[k] = std::cos(M_PI * (k + 0.5) / NODES);
+        double t = (nodes[k] + 1) / 2 * span;
+
+        if (!sample(transform, jd + t / SECONDS_PER_DAY, values[0][k], values[1][k]))
+            return false;
+    }
+
+    m_AzimuthOrigin = values[0][0];
+    for (int k = 0; k < NODES; k++)
+        values[0][k] = wrap180(values[0][k] - m_AzimuthOrigin);
+
+    for (int axis = 0; axis < 2; axis++)
+    {
+        // c_j = 2/N sum f(x_k) T_j(x_k), with c_0 halved
+        for (int j = 0; j < NODES; j++)
+        {
+            double sum = 0;
+            for (int k = 0; k < NODES; k++)
+                sum += values[axis][k] * std::cos(M_PI * j * (k + 0.5) / NODES);
+            m_Coefficients[axis][j] = sum * 2 / NODES;
+        }
+        m_Coefficients[axis][0] /= 2;
+
+        // Coefficients of the derivative: d_{j-1} = d_{j+1} + 2 j c_j
+        double *d = m_Derivative[axis];
+        const double *c = m_Coefficients[axis];
+        d[NODES - 1] = 0;
+        d[NODES - 2] = 2 * (NODES - 1) * c[NODES - 1];
+        for (int j = NODES - 2; j >= 1; j--)
+            d[j - 1] = (j + 1 < NODES ? d[j + 1] : 0) + 2 * j * c[j];
+        d[0] /= 2;
+    }
+
+    // Interpolation error is largest at the ends of the horizon, check both against the transform
+    error = 0;
+    for (double x : {-1.0, 1.0})
+    {
+        double azimuth, altitude, value, derivative;
+        if (!sample(transform, jd + (x + 1) / 2 * span / SECONDS_PER_DAY, azimuth, altitude))
+            return false;
+
+        evaluate(0, x, value, derivative);
+        error = std::max(error, std::fabs(wrap180(m_AzimuthOrigin + value - azimuth)) * 3600);
+        evaluate(1, x, value, derivative);
+        error = std::max(error, std::fabs(value - altitude) * 3600);
+    }
+
+    return true;
+}
+
+void TrackingPredictor::evaluate(int axis, double x, double &value, double &derivative) const
+{
+    // Clenshaw recurrence for both series
+    double b1 = 0, b2 = 0, d1 = 0, d2 = 0;
+    for (int j = NODES - 1; j >= 1; j--)
+    {
+        double b = 2 * x * b1 - b2 + m_Coefficients[axis][j];
+        b2 = b1;
+        b1 = b;
+
+        double d = 2 * x * d1 - d2 + m_Derivative[axis][j];
+        d2 = d1;
+        d1 = d;
+    }
+
+    value = x * b1 - b2 + m_Coefficients[axis][0];
+    derivative = x * d1 - d2 + m_Derivative[axis][0];
+}
@@ -0,0 +1,124 @@
+/*
+    Celestron Aux Mount Driver - Tracking trajectory prediction
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+/**
+ * @brief Caches the mount axis trajectory of the tracking target.
+ *
+ * The full sky to mount transform goes through the alignment subsystem and is costly.
+ * Instead of running it several times per tracking tick, the trajectory of both axes is
+ * fitted with a Chebyshev polynomial over a short horizon, from a few transforms, and the
+ * position and rate at every tick are evaluated from the model.
+ *
+ * Each fit is checked against the transform at both ends of the horizon. If the error is
+ * above the tolerance, e.g. close to the zenith where the azimuth rate changes quickly,
+ * the horizon is halved and the fit repeated. When even the shortest horizon can not meet
+ * the tolerance, predict() fails and the caller must use the transform directly.
+ */
+class TrackingPredictor
+{
+    public:
+        /**
+         * @brief Mount axis position of the target at a Julian date.
+         * Azimuth and altitude in degrees. Returns false if the position can not be computed.
+         */
+        using Transform = std::function<bool(double jd, double &azimuth, double &altitude)>;
+
+        struct Prediction
+        {
+            double azimuth { 0 };       // degrees, 0 to 360
+            double altitude { 0 };      // degrees
+            double azimuthRate { 0 };   // degrees per second
+            double altitudeRate { 0 };  // degrees per second
+        };
+
+        TrackingPredictor();
+
+        /** Maximum axis error of the model, in arcseconds. Invalidates the model. */
+        void setTolerance(double arcsec);
+
+        /** Shortest and longest fitting horizon, in seconds. Invalidates the model. */
+        void setHorizon(double minimum, double maximum);
+
+        /** Forget the model, e.g. when the target, the location or the alignment changes. */
+        void invalidate();
+
+        /**
+         * @brief Position and rate of the target at the given time, refitting the model when needed.
+         * @return false if no model within tolerance is available, the transform must be used directly.
+         */
+        bool predict(double jd, const Transform &transform, Prediction &prediction);
+
+        bool isValid() const
+        {
+            return m_Valid;
+        }
+
+        /** Horizon of the current model in seconds */
+        double getSpan() const
+        {
+            return m_Span;
+        }
+
+        /** Maximum error of the current model at the check points, in arcseconds */
+        double getFitError() const
+        {
+            return m_FitError;
+        }
+
+        uint32_t getFitCount() const
+        {
+            return m_FitCount;
+        }
+
+        uint32_t getTransformCount() const
+        {
+            return m_TransformCount;
+        }
+
+    private:
+        static constexpr int NODES = 5;  // quartic model
+
+        bool fit(double jd, const Transform &transform);
+        bool fitSpan(double jd, double span, const Transform &transform, double &error);
+        void evaluate(int axis, double x, double &value, double &derivative) const;
+        bool sample(const Transform &transform, double jd, double &azimuth, double &altitude);
+
+        double m_Tolerance { 0.1 };
+        double m_MinimumSpan { 4 };
+        double m_MaximumSpan { 120 };
+
+        bool m_Valid { false };
+        double m_Start { 0 };            // JD of the start of the horizon
+        double m_Span { 0 };             // seconds
+        double m_NextSpan { 0 };         // horizon to try on the next fit
+        double m_RetryAfter { 0 };       // JD before which no fit is attempted after a failure
+        double m_AzimuthOrigin { 0 };    // the azimuth is modeled relative to this value to avoid wrapping
+        double m_Coefficients[2][NODES] {};
+        double m_Derivative[2][NODES] {};
+
+        double m_FitError { 0 };
+        uint32_t m_FitCount { 0 };
+        uint32_t m_TransformCount { 0 };
+};
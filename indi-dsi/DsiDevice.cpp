@@ -11,6 +11,7 @@
 #include "DsiDevice.h"
 
 #include "DsiException.h"
+#include "DsiUsbTransport.h"
 #include "Util.h"
 
 #include <cstring>
@@ -137,6 +138,7 @@ DSI::Device::~Device()
 {
     std::cerr << "in DSI::Device::~Device" << std::endl;
     int result;
+    image_transport.reset();
     if (handle != 0)
     {
         result = libusb_release_interface(handle, 0);
@@ -742,7 +744,8 @@ int DSI::Device::startExposure(int howlong, int gain, int offs)
     }
     else // This is what the DSI III monkey found while sniffing USB (gs)
     {
-        std::cerr << "Epsosure time: " << exposure_time << ", Gain: " << gain << ", Offset: " << offs << std::endl;
+        if (log_commands)
+            std::cerr << "Epsosure time: " << exposure_time << ", Gain: " << gain << ", Offset: " << offs << std::endl;
 
         // first, set gain and offset
         command(DeviceCommand::SET_GAIN, gain);
@@ -810,128 +813,17 @@ int DSI::Device::startExposure(int howlong, int gain, int offs)
 
 unsigned char *DSI::Device::downloadImage()
 {
-    int status = 0;
-    int transferred = 0;
-    int interlaced = 0;
     int rawtemp = 0;
-    unsigned int t_read_width = 0;
-    unsigned int t_read_height_even = 0;
-    unsigned int t_read_height_odd = 0;
-    unsigned int t_read_height = 0;
-    unsigned int t_read_bpp = 0;
-    unsigned int t_image_width = 0;
-    unsigned int t_image_height = 0;
-    unsigned int t_image_offset_x = 0;
-    unsigned int t_image_offset_y = 0;
-
-    if (read_height_even > 0)
-        interlaced = 1;
-    else
-        interlaced = 0;
-
-    /* binning currently only supported for DSI III (gs) */
-
-    if (binning2x2)
-    {
-        t_read_width       = ((read_bpp * read_width / 512) + 1) * 128;
-        t_read_height_even = read_height_even / 2;
-        t_read_height_odd  = read_height_odd / 2;
-        t_image_width      = image_width / 2;
-        t_image_height     = image_height / 2;
-        t_image_offset_x   = image_offset_x / 2;
-        t_image_offset_y   = image_offset_y / 2;
-    }
-    else
-    {
-        t_read_width       = ((read_bpp * read_width / 512) + 1) * 256;
-        t_read_height_even = read_height_even;
-        t_read_height_odd  = read_height_odd;
-        t_image_width      = image_width;
-        t_image_height     = image_height;
-        t_image_offset_x   = image_offset_x;
-        t_image_offset_y   = image_offset_y;
-    }
-
-    t_read_height = t_read_height_even + t_read_height_odd;
-    t_read_bpp    = read_bpp;
-
-    unsigned int odd_size  = t_read_bpp * t_read_width * t_read_height_odd;
-    unsigned int even_size = t_read_bpp * t_read_width * t_read_height_even;
-    unsigned int all_size  = t_read_bpp * t_read_width * t_read_height;
-    unsigned char *odd_data = new unsigned char[odd_size];
-    unsigned char *even_data = nullptr;
-
-    if (interlaced)
-        even_data = new unsigned char[even_size];
-
-    framebuffer = new unsigned char[all_size];
-
-    if (interlaced)
-    {
-        /* XXX: There has to be  a way to calculate a more optimal readout
-               time here. */
-        status = libusb_bulk_transfer(handle, 0x86, even_data, even_size, &transferred, 60000 * MILLISEC);
-        if (log_commands)
-        {
-            log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)even_data, 0);
-
-            std::cerr << std::dec << "read even data, status = (" << status << ") " << (status > 0 ? "" : strerror(-status))
-                      << std::endl
-                      << "    requested " << even_size << " bytes " << t_read_width << " x " << t_read_height_even
-                      << " (even pixels)" << std::endl
-                      << "Transferred: " << transferred << " bytes" << std::endl;
-        }
-
-        if (status != 0)
-        {
-            std::stringstream ss;
-            ss << std::dec << "read even data, status = (" << status << ") " << strerror(-status);
-            throw device_read_error(ss.str());
-        }
-
-        status = libusb_bulk_transfer(handle, 0x86, odd_data, odd_size, &transferred, 60000 * MILLISEC);
-        if (log_commands)
-        {
-            log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)odd_data, 0);
-
-            std::cerr << std::dec << "read odd data, status = (" << status << ") " << (status > 0 ? "" : strerror(-status))
-                      << std::endl
-                      << "    requested " << odd_size << " bytes " << t_read_width << " x " << t_read_height_odd
-                      << " (odd pixels)" << std::endl
-                      << "Transferred: " << transferred << " bytes" << std::endl;
-        }
+    ReadoutGeometry geometry = imageGeometry();
 
-        if (status != 0)
-        {
-            std::stringstream ss;
-            ss << std::dec << "read odd data, status = (" << status << ") " << strerror(-status);
-            throw device_read_error(ss.str());
-        }
-    }
-    else // progressive mode for DSI III (gs)
+    if (!geometry.interlaced()) // progressive mode for DSI III (gs)
     {
         if ((!vdd_on) && (exposure_time >= VDD_TRH))
             command(DeviceCommand::SET_VDD_MODE, VddMode::ON.value());
-
-        status = libusb_bulk_transfer(handle, 0x86, odd_data, odd_size, &transferred, 60000 * MILLISEC);
-        if (log_commands)
-        {
-            log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)odd_data, 0);
-
-            std::cerr << std::dec << "read progressive data, status = (" << status << ") " << std::endl
-                      << "    requested " << odd_size << " bytes " << t_read_width << " x " << t_read_height_odd
-                      << " (pixels)" << std::endl
-                      << "Transferred: " << transferred << " bytes" << std::endl;
-        }
-
-        if (status != 0)
-        {
-            std::stringstream ss;
-            ss << std::dec << "read progressive data, status = (" << status << ") ";
-            throw device_read_error(ss.str());
-        }
     }
 
+    readImage(geometry);
+
     /* Update temperature for devices with sensor (gs) */
 
     if (has_tempsensor)
@@ -945,85 +837,63 @@ unsigned char *DSI::Device::downloadImage()
     /* disable 2x2 binning after downloading image (gs) */
     disable2x2Binning();
 
-    unsigned char msb = 0, lsb = 0, is_odd = 0;
-    unsigned int x_ptr = 0, line_start = 0, y_ptr = 0, read_ptr = 0, write_ptr = 0;
-    char *even = (char *)even_data;
-    char *odd  = (char *)odd_data;
-
-    if (log_commands)
-        std::cerr << "t_image_height  =" << t_image_height << std::endl
-                  << "t_image_width   =" << t_image_width << std::endl
-                  << "t_image_offset_x=" << t_image_offset_x << std::endl
-                  << "t_image_offset_y=" << t_image_offset_y << std::endl
-                  << "t_read_width    =" << t_read_width << std::endl
-                  << "t_read_height   =" << t_read_height << std::endl
-                  << "t_read_bpp      =" << t_read_bpp << std::endl;
-
-    if (interlaced)
-    {
-        for (write_ptr = y_ptr = 0; y_ptr < t_image_height; y_ptr++)
-        {
-            line_start = t_read_width * ((y_ptr + t_image_offset_y) / 2);
-            is_odd     = (y_ptr + t_image_offset_y) % 2;
+    return framebuffer;
+}
 
-            std::cerr << "starting image row " << y_ptr << ", write_ptr=" << write_ptr << ", line_start=" << line_start
-                      << ", is_odd=" << (is_odd == 0 ? 0 : 1) << ", read_ptr=" << (line_start + t_image_offset_x) * 2
-                      << std::endl;
+/* Readout of the current binning, binning currently only supported for DSI III (gs) */
+DSI::ReadoutGeometry DSI::Device::imageGeometry()
+{
+    ReadoutGeometry geometry;
 
-            for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-            {
-                read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-                if (is_odd == 1) // odd line
-                {
-                    msb = odd[read_ptr];
-                    lsb = odd[read_ptr + 1];
-                }
-                else
-                {
-                    // even line
-                    msb = even[read_ptr];
-                    lsb = even[read_ptr + 1];
-                }
-                framebuffer[write_ptr++] = msb;
-                framebuffer[write_ptr++] = lsb;
-            }
-        }
+    if (binning2x2)
+    {
+        geometry.read_width       = ((read_bpp * read_width / 512) + 1) * 128;
+        geometry.read_height_even = read_height_even / 2;
+        geometry.read_height_odd  = read_height_odd / 2;
+        geometry.image_width      = image_width / 2;
+        geometry.image_height     = image_height / 2;
+        geometry.image_offset_x   = image_offset_x / 2;
+        geometry.image_offset_y   = image_offset_y / 2;
     }
     else
     {
-        for (write_ptr = y_ptr = 0; y_ptr < t_image_height; y_ptr++)
-        {
-            line_start = t_read_width * (y_ptr + t_image_offset_y);
-
-            // std::cerr << "starting image row " << y_ptr
-            //      << ", write_ptr=" << write_ptr
-            //      << ", line_start=" << line_start
-            //      << ", read_ptr=" << (line_start+t_image_offset_x)*2
-            //      << std::endl;
-            for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-            {
-                read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
+        geometry.read_width       = ((read_bpp * read_width / 512) + 1) * 256;
+        geometry.read_height_even = read_height_even;
+        geometry.read_height_odd  = read_height_odd;
+        geometry.image_width      = image_width;
+        geometry.image_height     = image_height;
+        geometry.image_offset_x   = image_offset_x;
+        geometry.image_offset_y   = image_offset_y;
+    }
 
-                msb = odd[read_ptr];
-                lsb = odd[read_ptr + 1];
+    geometry.read_bpp = read_bpp;
 
-                framebuffer[write_ptr++] = msb;
-                framebuffer[write_ptr++] = lsb;
-            }
-        }
-    }
+    return geometry;
+}
 
-    if (log_commands)
-        std::cerr << "write_ptr=" << write_ptr << std::endl;
+/* Reads both fields of the exposure and merges them into the framebuffer, in
+ * host byte order.  The framebuffer is reused from one exposure to the next. */
+unsigned char *DSI::Device::readImage(const ReadoutGeometry &geometry)
+{
+    /* XXX: There has to be  a way to calculate a more optimal readout
+       time here. */
+    if (!image_transport)
+        image_transport.reset(new UsbFieldTransport(handle, 0x86, 60000 * MILLISEC));
+
+    image_transport->setDebug(log_commands);
 
-    delete[] odd_data;
+    if (log_commands)
+        std::cerr << "t_image_height  =" << geometry.image_height << std::endl
+                  << "t_image_width   =" << geometry.image_width << std::endl
+                  << "t_image_offset_x=" << geometry.image_offset_x << std::endl
+                  << "t_image_offset_y=" << geometry.image_offset_y << std::endl
+                  << "t_read_width    =" << geometry.read_width << std::endl
+                  << "t_read_height   =" << geometry.read_height_even + geometry.read_height_odd << std::endl
+                  << "t_read_bpp      =" << geometry.read_bpp << std::endl;
 
-    if (interlaced)
-        delete[] even_data;
+    framebuffer = (unsigned char *)download_pipeline.download(*image_transport, geometry);
 
     return framebuffer;
-
-    throw dsi_exception("unsupported image command");
 }
 
 /* ask camera for remaining exposure time for long exposures (gs) */
@@ -1092,14 +962,11 @@ void DSI::Device::disable2x2Binning()
 
 unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
 {
-    int transferred = 0;
-
     if (((__command == DeviceCommand::TRIGGER)) || (__command == DeviceCommand::TEST_PATTERN))
     {
         // Monkey code.  Monkey see (SniffUSB), monkey do).  Some part of this
         // is required because w/o it, I get segfaults on the second attempt
         // to run the code.
-        int status = 0;
         int interlaced = 0;
         int rawtemp = 0;
 
@@ -1233,15 +1100,7 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
             command(__command);
         }
 
-        unsigned int t_read_width = 0;
-        unsigned int t_read_height_even = 0;
-        unsigned int t_read_height_odd = 0;
-        unsigned int t_read_height = 0;
-        unsigned int t_read_bpp = 0;
-        unsigned int t_image_width = 0;
-        unsigned int t_image_height = 0;
-        unsigned int t_image_offset_x = 0;
-        unsigned int t_image_offset_y = 0;
+        ReadoutGeometry geometry;
 
         /* XXX: I'm a bit confused about the test pattern.  It *looks* like
          * the camera always sends back the same amount of data, but the
@@ -1250,31 +1109,7 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
 
         if (__command == DeviceCommand::TRIGGER)
         {
-            if (binning2x2)
-            {
-                t_read_width       = ((read_bpp * read_width / 512) + 1) * 128;
-                t_read_height_even = read_height_even / 2;
-                t_read_height_odd  = read_height_odd / 2;
-                t_image_width      = image_width / 2;
-                t_image_height     = image_height / 2;
-                t_image_offset_x   = image_offset_x / 2;
-                t_image_offset_y   = image_offset_y / 2;
-            }
-            else
-            {
-                t_read_width       = ((read_bpp * read_width / 512) + 1) * 256;
-                t_read_height_even = read_height_even;
-                t_read_height_odd  = read_height_odd;
-                t_image_width      = image_width;
-                t_image_height     = image_height;
-                t_image_offset_x   = image_offset_x;
-                t_image_offset_y   = image_offset_y;
-            }
-
-            t_image_offset_x = image_offset_x;
-            t_image_offset_y = image_offset_y;
-            t_read_height    = t_read_height_even + t_read_height_odd;
-            t_read_bpp       = read_bpp;
+            geometry = imageGeometry();
         }
         else
         {
@@ -1282,38 +1117,26 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
              * pattern image and use our temporary values.
              */
 
-            t_read_width = 540;
+            geometry.read_width = 540;
 
             if (interlaced)
             {
-                t_read_height_even = 0xfd;
-                t_read_height_odd  = 0xfc;
+                geometry.read_height_even = 0xfd;
+                geometry.read_height_odd  = 0xfc;
             }
             else // progressive mode
             {
-                t_read_height_even = 0x000;
-                t_read_height_odd  = 0x1f9;
+                geometry.read_height_even = 0x000;
+                geometry.read_height_odd  = 0x1f9;
             }
 
-            t_read_height    = t_read_height_even + t_read_height_odd;
-            t_read_bpp       = 2;
-            t_image_width    = t_read_width;
-            t_image_height   = t_read_height;
-            t_image_offset_x = 0;
-            t_image_offset_y = 0;
+            geometry.read_bpp       = 2;
+            geometry.image_width    = geometry.read_width;
+            geometry.image_height   = geometry.read_height_even + geometry.read_height_odd;
+            geometry.image_offset_x = 0;
+            geometry.image_offset_y = 0;
         }
 
-        unsigned int odd_size  = t_read_bpp * t_read_width * t_read_height_odd;
-        unsigned int even_size = t_read_bpp * t_read_width * t_read_height_even;
-        unsigned int all_size  = t_read_bpp * t_read_width * t_read_height;
-        unsigned char *odd_data = new unsigned char[odd_size];
-        unsigned char *even_data = nullptr;
-
-        if (interlaced)
-            even_data = new unsigned char[even_size];
-
-        framebuffer = new unsigned char[all_size];
-
         /* The Meade driver seems to only issue a GET_EXP_TIME_COUNT command
          * when the exposure is over about 2 seconds (count = 20,000).  From
          * testing, it looks like if I try to issue this command for exposures
@@ -1332,46 +1155,7 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
         if (last_time == 0)
             last_time = get_sysclock_ms();
 
-        if (interlaced)
-        {
-            /* XXX: There has to be  a way to calculate a more optimal readout
-               time here. */
-            status = libusb_bulk_transfer(handle, 0x86, even_data, even_size, &transferred, 60000 * MILLISEC);
-            if (log_commands)
-            {
-                log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)even_data, 0);
-
-                std::cerr << std::dec << "read even data, status = (" << status << ") " << (status > 0 ? "" : strerror(-status))
-                          << std::endl
-                          << "    requested " << even_size << " bytes " << t_read_width << " x " << t_read_height_even
-                          << " (even pixels)" << std::endl;
-            }
-
-            if (status < 0)
-            {
-                std::stringstream ss;
-                ss << std::dec << "read even data, status = (" << status << ") " << strerror(-status);
-                throw device_read_error(ss.str());
-            }
-        }
-
-        status = libusb_bulk_transfer(handle, 0x86, odd_data, odd_size, &transferred, 60000 * MILLISEC);
-        if (log_commands)
-        {
-            log_command_info(false, "r 86", (status > 0 ? status : 0), (char *)even_data, 0);
-
-            std::cerr << std::dec << "read odd data, status = (" << status << ") " << (status > 0 ? "" : strerror(-status))
-                      << std::endl
-                      << "    requested " << odd_size << " bytes " << t_read_width << " x " << t_read_height_odd
-                      << " (odd pixels)" << std::endl;
-        }
-
-        if (status < 0)
-        {
-            std::stringstream ss;
-            ss << std::dec << "read odd data, status = (" << status << ") " << strerror(-status);
-            throw device_read_error(ss.str());
-        }
+        readImage(geometry);
 
         if (has_tempsensor)
         {
@@ -1383,80 +1167,6 @@ unsigned char *DSI::Device::getImage(DeviceCommand __command, int howlong)
 
         disable2x2Binning();
 
-        unsigned char msb = 0, lsb = 0, is_odd = 0;
-        unsigned int x_ptr = 0, line_start = 0, y_ptr = 0, read_ptr = 0, write_ptr = 0;
-        char *even = (char *)even_data;
-        char *odd  = (char *)odd_data;
-
-        if (log_commands)
-            std::cerr << "t_image_height  =" << t_image_height << std::endl
-                      << "t_image_width   =" << t_image_width << std::endl
-                      << "t_image_offset_x=" << t_image_offset_x << std::endl
-                      << "t_image_offset_y=" << t_image_offset_y << std::endl
-                      << "t_read_width    =" << t_read_width << std::endl
-                      << "t_read_height   =" << t_read_height << std::endl
-                      << "t_read_bpp      =" << t_read_bpp << std::endl;
-
-        if (interlaced)
-        {
-            for (write_ptr = y_ptr = 0; y_ptr < t_image_height; y_ptr++)
-            {
-                line_start = t_read_width * ((y_ptr + t_image_offset_y) / 2);
-                is_odd     = (y_ptr + t_image_offset_y) % 2;
-
-                std::cerr << "starting image row " << y_ptr << ", write_ptr=" << write_ptr << ", line_start=" << line_start
-                          << ", is_odd=" << (is_odd == 0 ? 0 : 1) << ", read_ptr=" << (line_start + t_image_offset_x) * 2
-                          << std::endl;
-                for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-                {
-                    read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-                    if (is_odd == 1) // odd line
-                    {
-                        msb = odd[read_ptr];
-                        lsb = odd[read_ptr + 1];
-                    }
-                    else
-                    {
-                        // even line
-                        msb = even[read_ptr];
-                        lsb = even[read_ptr + 1];
-                    }
-                    framebuffer[write_ptr++] = msb;
-                    framebuffer[write_ptr++] = lsb;
-                }
-            }
-        }
-        else
-        {
-            for (write_ptr = y_ptr = 0; y_ptr < t_image_height; y_ptr++)
-            {
-                line_start = t_read_width * (y_ptr + t_image_offset_y);
-
-                //std::cerr << "starting image row " << y_ptr
-                //     << ", write_ptr=" << write_ptr
-                //     << ", line_start=" << line_start
-                //     << ", read_ptr=" << (line_start+t_image_offset_x)*2 << std::endl;
-                for (x_ptr = 0; x_ptr < t_image_width; x_ptr++)
-                {
-                    read_ptr = (line_start + x_ptr + t_image_offset_x) * 2;
-
-                    msb = odd[read_ptr];
-                    lsb = odd[read_ptr + 1];
-
-                    framebuffer[write_ptr++] = msb;
-                    framebuffer[write_ptr++] = lsb;
-                }
-            }
-        }
-
-        if (log_commands)
-            std::cerr << "write_ptr=" << write_ptr << std::endl;
-
-        delete[] odd_data;
-
-        if (interlaced)
-            delete[] even_data;
-
         return framebuffer;
     }
 
@@ -6,10 +6,12 @@
 
 #pragma once
 
+#include "DsiDownload.h"
 #include "DsiTypes.h"
 
 #include <libusb.h>
 
+#include <memory>
 #include <string>
 
 #ifndef LONGEXP
@@ -30,9 +32,13 @@ class Device
         std::string camera_name;
 
     protected:
-        /* image frame buffer (gs) */
+        /* image frame buffer (gs), owned by download_pipeline */
         unsigned char *framebuffer;
 
+        /* Image endpoint, and the buffers the fields are merged into */
+        std::unique_ptr<FieldTransport> image_transport;
+        DownloadPipeline download_pipeline;
+
         /* These are chip-specific sizes required to parameterize the image
              * retrieval.
              */
@@ -175,6 +181,9 @@ class Device
         virtual unsigned char *getImage(int howlong);
         virtual unsigned char *getImage(DeviceCommand __command, int howlong);
 
+        ReadoutGeometry imageGeometry();
+        unsigned char *readImage(const ReadoutGeometry &geometry);
+
         void sendRegister(AdRegister adr, unsigned int arg);
 
     public:
@@ -0,0 +1,145 @@
+/*
+ * Copyright © 2026
+ *
+ */
+
+#include "DsiDownload.h"
+
+#include "DsiException.h"
+
+#include <cstring>
+#include <sstream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Copies a row of big endian pixels, swapping them to host order. */
+static void copy_row(const unsigned char *src, uint16_t *dst, unsigned int width)
+{
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    memcpy(dst, src, width * sizeof(uint16_t));
+#else
+    unsigned int x = 0;
+
+#if defined(__SSE2__)
+    for (; x + 8 <= width; x += 8)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(src + 2 * x));
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_or_si128(_mm_slli_epi16(pixels, 8), _mm_srli_epi16(pixels, 8)));
+    }
+#endif
+
+    for (; x < width; x++)
+        dst[x] = (uint16_t)((src[2 * x] << 8) | src[2 * x + 1]);
+#endif
+}
+
+/* Throws if the image does not fit in the fields, as the merge does not check. */
+static void check_geometry(const DSI::ReadoutGeometry &geometry)
+{
+    std::ostringstream ss;
+
+    if (geometry.read_bpp != 2)
+        ss << "unsupported readout of " << geometry.read_bpp << " bytes per pixel";
+    else if (geometry.image_offset_x + geometry.image_width > geometry.read_width)
+        ss << "image columns " << geometry.image_offset_x << "+" << geometry.image_width << " past readout width "
+           << geometry.read_width;
+    else if (geometry.image_height > 0)
+    {
+        unsigned int last_row = geometry.image_offset_y + geometry.image_height - 1;
+
+        if (!geometry.interlaced())
+        {
+            if (last_row >= geometry.read_height_odd)
+                ss << "image row " << last_row << " past readout height " << geometry.read_height_odd;
+        }
+        else
+        {
+            /* rows alternate between the fields, the last one of each must be there */
+            unsigned int last_even = (last_row % 2 == 0) ? last_row : last_row - 1;
+            unsigned int last_odd  = (last_row % 2 == 1) ? last_row : last_row - 1;
+
+            if (last_even >= geometry.image_offset_y && last_even / 2 >= geometry.read_height_even)
+                ss << "image row " << last_even << " past even field height " << geometry.read_height_even;
+            else if (last_odd >= geometry.image_offset_y && last_odd / 2 >= geometry.read_height_odd)
+                ss << "image row " << last_odd << " past odd field height " << geometry.read_height_odd;
+        }
+    }
+
+    if (!ss.str().empty())
+        throw DSI::dsi_exception(ss.str());
+}
+
+DSI::RecordedFieldTransport::RecordedFieldTransport(std::vector<unsigned char> even, std::vector<unsigned char> odd)
+    : even_field(std::move(even)), odd_field(std::move(odd))
+{
+}
+
+void DSI::RecordedFieldTransport::readFields(unsigned char *even, size_t even_size, unsigned char *odd,
+        size_t odd_size)
+{
+    if (even != nullptr)
+    {
+        if (even_field.size() < even_size)
+        {
+            std::ostringstream ss;
+            ss << "read even data, transferred " << even_field.size() << " of " << even_size << " bytes";
+            throw device_read_error(ss.str());
+        }
+        memcpy(even, even_field.data(), even_size);
+    }
+
+    if (odd_field.size() < odd_size)
+    {
+        std::ostringstream ss;
+        ss << "read odd data, transferred " << odd_field.size() << " of " << odd_size << " bytes";
+        throw device_read_error(ss.str());
+    }
+    memcpy(odd, odd_field.data(), odd_size);
+
+    frames_read++;
+}
+
+uint16_t *DSI::DownloadPipeline::download(FieldTransport &transport, const ReadoutGeometry &geometry)
+{
+    check_geometry(geometry);
+
+    GeometryKey key(geometry.read_width, geometry.read_height_even, geometry.read_height_odd, geometry.read_bpp,
+                    geometry.image_width, geometry.image_height, geometry.image_offset_x, geometry.image_offset_y);
+    Buffers &buffers = pool[key];
+
+    if (buffers.image.empty())
+    {
+        buffers.even.resize(geometry.evenSize());
+        buffers.odd.resize(geometry.oddSize());
+        buffers.image.resize((size_t)geometry.image_width * geometry.image_height);
+    }
+
+    transport.readFields(geometry.interlaced() ? buffers.even.data() : nullptr, buffers.even.size(), buffers.odd.data(),
+                         buffers.odd.size());
+
+    mergeFields(geometry, buffers.even.data(), buffers.odd.data(), buffers.image.data());
+
+    return buffers.image.data();
+}
+
+void DSI::DownloadPipeline::mergeFields(const ReadoutGeometry &geometry, const unsigned char *even,
+                                        const unsigned char *odd, uint16_t *image)
+{
+    const size_t row_bytes = (size_t)geometry.read_bpp * geometry.read_width;
+    const size_t x_bytes   = (size_t)geometry.read_bpp * geometry.image_offset_x;
+
+    for (unsigned int y = 0; y < geometry.image_height; y++)
+    {
+        unsigned int row = y + geometry.image_offset_y;
+        const unsigned char *src;
+
+        if (geometry.interlaced())
+            src = ((row % 2) ? odd : even) + row_bytes * (row / 2);
+        else
+            src = odd + row_bytes * row;
+
+        copy_row(src + x_bytes, image + (size_t)geometry.image_width * y, geometry.image_width);
+    }
+}
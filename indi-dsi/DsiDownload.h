@@ -0,0 +1,122 @@
+/*
+ * Copyright © 2026
+ *
+ * Image download pipeline of the DSI: both fields are read back to back and
+ * merged row by row into a frame kept from one exposure to the next.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace DSI
+{
+/* Layout of the data sent by the camera for one readout mode, and of the
+ * image cut out of it.  Widths and offsets are in pixels.  An interlaced
+ * readout sends the even rows first, then the odd rows; a progressive one only
+ * sends the "odd" field, which then holds every row.
+ */
+struct ReadoutGeometry
+{
+    unsigned int read_width       = 0;
+    unsigned int read_height_even = 0;
+    unsigned int read_height_odd  = 0;
+    unsigned int read_bpp         = 2;
+    unsigned int image_width      = 0;
+    unsigned int image_height     = 0;
+    unsigned int image_offset_x   = 0;
+    unsigned int image_offset_y   = 0;
+
+    bool interlaced() const
+    {
+        return read_height_even > 0;
+    }
+    size_t evenSize() const
+    {
+        return (size_t)read_bpp * read_width * read_height_even;
+    }
+    size_t oddSize() const
+    {
+        return (size_t)read_bpp * read_width * read_height_odd;
+    }
+};
+
+/* Source of the raw fields of a frame.  Both fields are requested at once so
+ * the second one can be queued while the first is still in flight.  Throws
+ * device_read_error when a field cannot be read in full.
+ */
+class FieldTransport
+{
+  public:
+    virtual ~FieldTransport() = default;
+
+    /* even is null for a progressive readout. */
+    virtual void readFields(unsigned char *even, size_t even_size, unsigned char *odd, size_t odd_size) = 0;
+
+    void setDebug(bool turnOn)
+    {
+        debug = turnOn;
+    }
+
+  protected:
+    bool debug = false;
+};
+
+/* Serves fields recorded from a camera, or made up, without any USB device. */
+class RecordedFieldTransport : public FieldTransport
+{
+  public:
+    RecordedFieldTransport(std::vector<unsigned char> even, std::vector<unsigned char> odd);
+
+    void readFields(unsigned char *even, size_t even_size, unsigned char *odd, size_t odd_size) override;
+
+    unsigned int framesRead() const
+    {
+        return frames_read;
+    }
+
+  private:
+    std::vector<unsigned char> even_field;
+    std::vector<unsigned char> odd_field;
+    unsigned int frames_read = 0;
+};
+
+class DownloadPipeline
+{
+  public:
+    /* Reads a frame from the transport and returns the image, in host byte
+     * order.  The buffers are kept per readout geometry, the returned image
+     * stays valid until the next download with the same geometry.
+     */
+    uint16_t *download(FieldTransport &transport, const ReadoutGeometry &geometry);
+
+    /* Cuts the image out of the fields, swapping the big endian pixels of the
+     * camera to host order.  even is unused for a progressive readout.
+     */
+    static void mergeFields(const ReadoutGeometry &geometry, const unsigned char *even, const unsigned char *odd,
+                            uint16_t *image);
+
+    /* Number of readout geometries buffers are kept for. */
+    size_t pooledModes() const
+    {
+        return pool.size();
+    }
+
+  private:
+    struct Buffers
+    {
+        std::vector<unsigned char> even;
+        std::vector<unsigned char> odd;
+        std::vector<uint16_t> image;
+    };
+
+    typedef std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int, unsigned int,
+            unsigned int> GeometryKey;
+
+    std::map<GeometryKey, Buffers> pool;
+};
+};
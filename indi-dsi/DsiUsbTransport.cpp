@@ -0,0 +1,134 @@
+/*
+ * Copyright © 2026
+ *
+ */
+
+#include "DsiUsbTransport.h"
+
+#include "DsiException.h"
+
+#include <iostream>
+#include <sstream>
+
+static const char *transfer_status_name(int status)
+{
+    switch (status)
+    {
+        case LIBUSB_TRANSFER_COMPLETED:
+            return "completed";
+        case LIBUSB_TRANSFER_ERROR:
+            return "error";
+        case LIBUSB_TRANSFER_TIMED_OUT:
+            return "timed out";
+        case LIBUSB_TRANSFER_CANCELLED:
+            return "cancelled";
+        case LIBUSB_TRANSFER_STALL:
+            return "stall";
+        case LIBUSB_TRANSFER_NO_DEVICE:
+            return "no device";
+        case LIBUSB_TRANSFER_OVERFLOW:
+            return "overflow";
+        default:
+            return "unknown";
+    }
+}
+
+DSI::UsbFieldTransport::UsbFieldTransport(libusb_device_handle *handle, unsigned char endpoint, unsigned int timeout)
+    : handle(handle), endpoint(endpoint), timeout(timeout)
+{
+    transfers[0] = libusb_alloc_transfer(0);
+    transfers[1] = libusb_alloc_transfer(0);
+
+    if (transfers[0] == nullptr || transfers[1] == nullptr)
+    {
+        libusb_free_transfer(transfers[0]);
+        libusb_free_transfer(transfers[1]);
+        throw dsi_exception("unable to allocate image transfers");
+    }
+}
+
+DSI::UsbFieldTransport::~UsbFieldTransport()
+{
+    libusb_free_transfer(transfers[0]);
+    libusb_free_transfer(transfers[1]);
+}
+
+void LIBUSB_CALL DSI::UsbFieldTransport::transferDone(libusb_transfer *transfer)
+{
+    *static_cast<int *>(transfer->user_data) = 1;
+}
+
+void DSI::UsbFieldTransport::readFields(unsigned char *even, size_t even_size, unsigned char *odd, size_t odd_size)
+{
+    static const char *field_names[2] = { "even", "odd" };
+    unsigned char *buffers[2] = { even, odd };
+    size_t sizes[2]           = { even_size, odd_size };
+    int done[2]               = { 1, 1 };
+    int submit_error          = 0;
+    int events_error          = 0;
+
+    for (int i = 0; i < 2 && submit_error == 0; i++)
+    {
+        if (buffers[i] == nullptr)
+            continue;
+
+        libusb_fill_bulk_transfer(transfers[i], handle, endpoint, buffers[i], (int)sizes[i], transferDone, &done[i],
+                                  timeout);
+        done[i]      = 0;
+        submit_error = libusb_submit_transfer(transfers[i]);
+        if (submit_error != 0)
+            done[i] = 1;
+    }
+
+    /* The fields come in order on the same endpoint: if one fails, what follows
+     * is not the other field, so the remaining transfer is cancelled. */
+    bool cancelled = false;
+    while (!done[0] || !done[1])
+    {
+        bool even_failed = done[0] && buffers[0] != nullptr &&
+                           (transfers[0]->status != LIBUSB_TRANSFER_COMPLETED || (size_t)transfers[0]->actual_length != sizes[0]);
+
+        if (!cancelled && (submit_error != 0 || events_error != 0 || even_failed))
+        {
+            for (int i = 0; i < 2; i++)
+                if (!done[i])
+                    libusb_cancel_transfer(transfers[i]);
+            cancelled = true;
+        }
+
+        int rc = libusb_handle_events_completed(nullptr, nullptr);
+        if (rc < 0 && rc != LIBUSB_ERROR_INTERRUPTED)
+            events_error = rc;
+    }
+
+    if (submit_error != 0)
+    {
+        std::ostringstream ss;
+        ss << "read image data, submit failed: " << libusb_error_name(submit_error);
+        throw device_read_error(ss.str());
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (buffers[i] == nullptr)
+            continue;
+
+        libusb_transfer *transfer = transfers[i];
+
+        if (debug)
+            std::cerr << std::dec << "read " << field_names[i] << " data, status = ("
+                      << transfer_status_name(transfer->status) << ")" << std::endl
+                      << "    requested " << sizes[i] << " bytes, transferred " << transfer->actual_length << " bytes"
+                      << std::endl;
+
+        if (transfer->status != LIBUSB_TRANSFER_COMPLETED || (size_t)transfer->actual_length != sizes[i])
+        {
+            std::ostringstream ss;
+            ss << "read " << field_names[i] << " data, status = (" << transfer_status_name(transfer->status)
+               << "), transferred " << transfer->actual_length << " of " << sizes[i] << " bytes";
+            if (events_error != 0)
+                ss << ", " << libusb_error_name(events_error);
+            throw device_read_error(ss.str());
+        }
+    }
+}
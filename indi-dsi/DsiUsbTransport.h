@@ -0,0 +1,36 @@
+/*
+ * Copyright © 2026
+ *
+ */
+
+#pragma once
+
+#include "DsiDownload.h"
+
+#include <libusb.h>
+
+namespace DSI
+{
+/* Reads the fields from the image endpoint of the camera.  Both bulk transfers
+ * are submitted before waiting for any, so the odd field is already queued
+ * when the even one completes.  The transfers are allocated once and reused.
+ */
+class UsbFieldTransport : public FieldTransport
+{
+  public:
+    UsbFieldTransport(libusb_device_handle *handle, unsigned char endpoint, unsigned int timeout);
+    ~UsbFieldTransport() override;
+
+    void readFields(unsigned char *even, size_t even_size, unsigned char *odd, size_t odd_size) override;
+
+  private:
+    static void LIBUSB_CALL transferDone(libusb_transfer *transfer);
+
+    libusb_device_handle *handle;
+    unsigned char endpoint;
+    unsigned int timeout;
+
+    /* even field, odd field */
+    libusb_transfer *transfers[2];
+};
+};
@@ -23,9 +23,9 @@
 #include "config.h"
 #include "DsiDeviceFactory.h"
 
+#include <cstring>
 #include <iostream>
 #include <math.h>
-#include <arpa/inet.h>
 #include <unistd.h>
 
 std::unique_ptr<DSICCD> dsiCCD(new DSICCD());
@@ -65,6 +65,8 @@ bool DSICCD::Connect()
         return false;
     }
 
+    dsi->setDebug(isDebug());
+
     ccd = dsi->getCcdChipName();
     if (ccd == "ICX254AL")
     {
@@ -453,6 +455,16 @@ void DSICCD::TimerHit()
     return;
 }
 
+/*******************************************************************************
+ * Forward the debug switch to the camera command and download logs
+*******************************************************************************/
+
+void DSICCD::debugTriggered(bool enable)
+{
+    if (dsi)
+        dsi->setDebug(enable);
+}
+
 /*******************************************************************************
  * Save configuration items (gs)
 *******************************************************************************/
@@ -475,7 +487,6 @@ bool DSICCD::saveConfigItems(FILE *fp)
 void DSICCD::grabImage()
 {
     uint16_t *buf = nullptr;
-    int x = 0, y = 0;
 
     std::unique_lock<std::mutex> guard(ccdBufferLock);
     // Let's get a pointer to the frame buffer
@@ -494,17 +505,10 @@ void DSICCD::grabImage()
         LOG_INFO("Image download failed!");
         return;
     }
-    guard.unlock();
 
-    for (y = 0; y < height; ++y)
-    {
-        for (x = 0; x < width; ++x)
-        {
-            ((uint16_t *)image)[x + width * y] = ntohs(buf[x + width * y]);
-        }
-    }
-
-    delete buf;
+    // The DSI frame is already in host byte order, and stays owned by the device
+    memcpy(image, buf, width * height * sizeof(uint16_t));
+    guard.unlock();
 
     // Let INDI::CCD know we're done filling the image buffer
     ExposureComplete(&PrimaryCCD);
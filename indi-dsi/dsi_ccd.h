@@ -42,6 +42,7 @@ class DSICCD : public INDI::CCD
     virtual const char *getDefaultName() override;
     virtual bool initProperties() override;
     virtual bool updateProperties() override;
+    virtual void debugTriggered(bool enable) override;
 
     // CCD specific functions
     virtual bool UpdateCCDBin(int hor, int ver) override;
@@ -0,0 +1,197 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : test_dsi.cpp
+ * DSI field merge and download pipeline, served from recorded fields
+ */
+
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "DsiDownload.h"
+#include "DsiException.h"
+
+/* DSI Pro, interlaced, as computed by DSI::Device::imageGeometry() */
+static DSI::ReadoutGeometry dsiPro()
+{
+    DSI::ReadoutGeometry geometry;
+    geometry.read_width       = 768;
+    geometry.read_height_even = 253;
+    geometry.read_height_odd  = 252;
+    geometry.image_width      = 508;
+    geometry.image_height     = 488;
+    geometry.image_offset_x   = 23;
+    geometry.image_offset_y   = 13;
+    return geometry;
+}
+
+/* DSI Pro III, progressive, 1x1 or 2x2 binning */
+static DSI::ReadoutGeometry dsiProIII(bool binned)
+{
+    DSI::ReadoutGeometry geometry;
+    geometry.read_width      = binned ? 768 : 1536;
+    geometry.read_height_odd = binned ? 525 : 1050;
+    geometry.image_width     = binned ? 680 : 1360;
+    geometry.image_height    = binned ? 512 : 1024;
+    geometry.image_offset_x  = binned ? 15 : 30;
+    geometry.image_offset_y  = binned ? 6 : 13;
+    return geometry;
+}
+
+static std::vector<unsigned char> makeField(size_t size, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::vector<unsigned char> field(size);
+    for (auto &byte : field)
+        byte = random() & 0xff;
+    return field;
+}
+
+/* The merge of the previous download: byte by byte into a new frame, then ntohs by the driver */
+static std::vector<uint16_t> referenceMerge(const DSI::ReadoutGeometry &g, const unsigned char *even,
+        const unsigned char *odd)
+{
+    unsigned char *framebuffer = new unsigned char[g.read_bpp * g.read_width * (g.read_height_even + g.read_height_odd)];
+    unsigned int write_ptr = 0;
+
+    for (unsigned int y_ptr = 0; y_ptr < g.image_height; y_ptr++)
+    {
+        unsigned int line_start, is_odd;
+        if (g.interlaced())
+        {
+            line_start = g.read_width * ((y_ptr + g.image_offset_y) / 2);
+            is_odd     = (y_ptr + g.image_offset_y) % 2;
+        }
+        else
+        {
+            line_start = g.read_width * (y_ptr + g.image_offset_y);
+            is_odd     = 1;
+        }
+
+        for (unsigned int x_ptr = 0; x_ptr < g.image_width; x_ptr++)
+        {
+            unsigned int read_ptr    = (line_start + x_ptr + g.image_offset_x) * 2;
+            const unsigned char *src = is_odd ? odd : even;
+            framebuffer[write_ptr++] = src[read_ptr];
+            framebuffer[write_ptr++] = src[read_ptr + 1];
+        }
+    }
+
+    std::vector<uint16_t> image(g.image_width * g.image_height);
+    for (size_t i = 0; i < image.size(); i++)
+        image[i] = ntohs(((uint16_t *)framebuffer)[i]);
+
+    delete[] framebuffer;
+    return image;
+}
+
+static void expectSameAsReference(const DSI::ReadoutGeometry &geometry)
+{
+    auto even = makeField(geometry.evenSize(), 1);
+    auto odd  = makeField(geometry.oddSize(), 2);
+    auto expected = referenceMerge(geometry, even.data(), odd.data());
+
+    DSI::RecordedFieldTransport transport(even, odd);
+    DSI::DownloadPipeline pipeline;
+    uint16_t *image = pipeline.download(transport, geometry);
+
+    ASSERT_EQ(transport.framesRead(), 1u);
+    for (size_t i = 0; i < expected.size(); i++)
+        ASSERT_EQ(image[i], expected[i]) << "pixel " << i % geometry.image_width << "," << i / geometry.image_width;
+}
+
+TEST(DsiDownload, InterlacedMatchesReference)
+{
+    expectSameAsReference(dsiPro());
+}
+
+TEST(DsiDownload, ProgressiveMatchesReference)
+{
+    expectSameAsReference(dsiProIII(false));
+    expectSameAsReference(dsiProIII(true));
+}
+
+TEST(DsiDownload, BuffersArePooledPerMode)
+{
+    DSI::DownloadPipeline pipeline;
+    DSI::RecordedFieldTransport full({}, makeField(dsiProIII(false).oddSize(), 3));
+    DSI::RecordedFieldTransport binned({}, makeField(dsiProIII(true).oddSize(), 4));
+
+    uint16_t *first = pipeline.download(full, dsiProIII(false));
+    EXPECT_EQ(pipeline.download(full, dsiProIII(false)), first);
+
+    uint16_t *other = pipeline.download(binned, dsiProIII(true));
+    EXPECT_NE(other, first);
+    EXPECT_EQ(pipeline.download(full, dsiProIII(false)), first);
+    EXPECT_EQ(pipeline.pooledModes(), 2u);
+}
+
+TEST(DsiDownload, ShortFieldIsRejected)
+{
+    DSI::ReadoutGeometry geometry = dsiPro();
+    DSI::RecordedFieldTransport transport(makeField(geometry.evenSize(), 5), makeField(geometry.oddSize() - 512, 6));
+    DSI::DownloadPipeline pipeline;
+
+    EXPECT_THROW(pipeline.download(transport, geometry), DSI::device_read_error);
+    EXPECT_EQ(transport.framesRead(), 0u);
+}
+
+TEST(DsiDownload, ImageOutsideFieldsIsRejected)
+{
+    DSI::ReadoutGeometry geometry = dsiPro();
+    DSI::RecordedFieldTransport transport(makeField(geometry.evenSize(), 7), makeField(geometry.oddSize(), 8));
+    DSI::DownloadPipeline pipeline;
+
+    geometry.image_offset_y = 20;
+    EXPECT_THROW(pipeline.download(transport, geometry), DSI::dsi_exception);
+
+    geometry = dsiProIII(false);
+    geometry.image_offset_x = 200;
+    EXPECT_THROW(pipeline.download(transport, geometry), DSI::dsi_exception);
+}
+
+TEST(DsiDownloadBenchmark, FramesPerSecond)
+{
+    const int frames = 50;
+    DSI::ReadoutGeometry geometry = dsiProIII(false);
+    auto odd = makeField(geometry.oddSize(), 9);
+    DSI::RecordedFieldTransport transport({}, odd);
+    DSI::DownloadPipeline pipeline;
+    uint64_t checksum = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        // previous download: new fields and frame every time, byte by byte merge
+        std::vector<unsigned char> field(geometry.oddSize());
+        transport.readFields(nullptr, 0, field.data(), field.size());
+        checksum += referenceMerge(geometry, nullptr, field.data())[i];
+    }
+    double before = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+        checksum -= pipeline.download(transport, geometry)[i];
+    double after = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(checksum, 0u);
+    printf("DSI Pro III 1360x1024: %.0f frames/s before, %.0f frames/s after\n", frames / before, frames / after);
+}
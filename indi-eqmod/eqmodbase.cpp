@@ -34,6 +34,7 @@
 
 #include "mach_gettime.h"
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 #include <cstring>
@@ -830,81 +831,7 @@ bool EQMod::ReadScopeStatus()
             LOGF_INFO("Pier side changed to %s", getPierSideStr(pierSide));
         setPierSide(pierSide);
 
-        alignedRA    = currentRA;
-        alignedDEC   = currentDEC;
-        ghalignedRA  = currentRA;
-        ghalignedDEC = currentDEC;
-        bool aligned = false;
-#ifdef WITH_ALIGN_GEEHALEL
-        if (align)
-        {
-            align->GetAlignedCoords(syncdata, juliandate, &m_Location, currentRA, currentDEC, &ghalignedRA,
-                                    &ghalignedDEC);
-            aligned = true;
-        }
-        //   else
-#endif
-#ifdef WITH_ALIGN
-        // Only use INDI Alignment Subsystem if it is active.
-        if (AlignMethodSP.sp[1].s == ISS_ON)
-        {
-            const char *maligns[3] = { "ZENITH", "NORTH", "SOUTH" };
-            INDI::IEquatorialCoordinates RaDec;
-            // Use HA/Dec as  telescope coordinate system
-            RaDec.rightascension = currentRA;
-            RaDec.declination = currentDEC;
-            TelescopeDirectionVector TDV = TelescopeDirectionVectorFromEquatorialCoordinates(RaDec);
-            DEBUGF(INDI::AlignmentSubsystem::DBG_ALIGNMENT,
-                   "Status: Mnt. Algnt. %s Date %lf encoders RA=%ld DE=%ld Telescope RA %lf DEC %lf",
-                   maligns[GetApproximateMountAlignment()], juliandate,
-                   static_cast<long>(currentRAEncoder), static_cast<long>(currentDEEncoder),
-                   currentRA, currentDEC);
-            DEBUGF(INDI::AlignmentSubsystem::DBG_ALIGNMENT, " Direction RA(deg.)  %lf DEC %lf TDV(x %lf y %lf z %lf)",
-                   RaDec.rightascension, RaDec.declination, TDV.x, TDV.y, TDV.z);
-            aligned = true;
-            if (!TransformTelescopeToCelestialJD(TDV, alignedRA, alignedDEC, juliandate))
-            {
-                aligned = false;
-                DEBUGF(INDI::AlignmentSubsystem::DBG_ALIGNMENT,
-                       "Failed TransformTelescopeToCelestial: Scope RA=%g Scope DE=%f, Aligned RA=%f DE=%f", currentRA,
-                       currentDEC, alignedRA, alignedDEC);
-            }
-            else
-            {
-                DEBUGF(INDI::AlignmentSubsystem::DBG_ALIGNMENT,
-                       "TransformTelescopeToCelestial: Scope RA=%f Scope DE=%f, Aligned RA=%f DE=%f", currentRA, currentDEC,
-                       alignedRA, alignedDEC);
-            }
-        }
-#endif
-        if (!aligned && (syncdata.lst != 0.0))
-        {
-            DEBUGF(DBG_SCOPE_STATUS, "Aligning with last sync delta RA %g DE %g", syncdata.deltaRA, syncdata.deltaDEC);
-            // should check values are in range!
-            alignedRA += syncdata.deltaRA;
-            alignedDEC += syncdata.deltaDEC;
-            if (alignedDEC > 90.0 || alignedDEC < -90.0)
-            {
-                alignedRA += 12.00;
-                if (alignedDEC > 0.0)
-                    alignedDEC = 180.0 - alignedDEC;
-                else
-                    alignedDEC = -180.0 - alignedDEC;
-            }
-            alignedRA = range24(alignedRA);
-        }
-
-#if defined WITH_ALIGN_GEEHALEL && !defined WITH_ALIGN
-        alignedRA  = ghalignedRA;
-        alignedDEC = ghalignedDEC;
-#endif
-#if defined WITH_ALIGN_GEEHALEL && defined WITH_ALIGN
-        if (AlignMethodSP.sp[0].s == ISS_ON)
-        {
-            alignedRA  = ghalignedRA;
-            alignedDEC = ghalignedDEC;
-        }
-#endif
+        AlignTelescopeCoords(juliandate, currentRA, currentDEC, &alignedRA, &alignedDEC, true);
 
         lnradec.rightascension  = alignedRA;
         lnradec.declination = alignedDEC;
@@ -1643,6 +1570,128 @@ void EQMod::EncoderTarget(GotoParams *g)
     g->detargetencoder = targetdecencoder;
 }
 
+// Sky coordinates of telescope coordinates, with the alignment in use or else the delta of the last sync
+void EQMod::AlignTelescopeCoords(double juliandate, double ra, double de, double *alignedra, double *aligneddec,
+                                 bool log)
+{
+    double skyRA = ra, skyDEC = de;
+    bool aligned = false;
+#ifdef WITH_ALIGN_GEEHALEL
+    double ghalignedRA = ra, ghalignedDEC = de;
+    if (align)
+    {
+        align->GetAlignedCoords(syncdata, juliandate, &m_Location, ra, de, &ghalignedRA,
+                                &ghalignedDEC);
+        aligned = true;
+    }
+    //   else
+#endif
+#ifdef WITH_ALIGN
+    // Only use INDI Alignment Subsystem if it is active.
+    if (AlignMethodSP.sp[1].s == ISS_ON)
+    {
+        const char *maligns[3] = { "ZENITH", "NORTH", "SOUTH" };
+        INDI::IEquatorialCoordinates RaDec;
+        // Use HA/Dec as  telescope coordinate system
+        RaDec.rightascension = ra;
+        RaDec.declination = de;
+        TelescopeDirectionVector TDV = TelescopeDirectionVectorFromEquatorialCoordinates(RaDec);
+        if (log)
+        {
+            DEBUGF(INDI::AlignmentSubsystem::DBG_ALIGNMENT,
+                   "Status: Mnt. Algnt. %s Date %lf encoders RA=%ld DE=%ld Telescope RA %lf DEC %lf",
+                   maligns[GetApproximateMountAlignment()], juliandate,
+                   static_cast<long>(currentRAEncoder), static_cast<long>(currentDEEncoder),
+                   ra, de);
+            DEBUGF(INDI::AlignmentSubsystem::DBG_ALIGNMENT, " Direction RA(deg.)  %lf DEC %lf TDV(x %lf y %lf z %lf)",
+                   RaDec.rightascension, RaDec.declination, TDV.x, TDV.y, TDV.z);
+        }
+        aligned = true;
+        if (!TransformTelescopeToCelestialJD(TDV, skyRA, skyDEC, juliandate))
+        {
+            aligned = false;
+            if (log)
+                DEBUGF(INDI::AlignmentSubsystem::DBG_ALIGNMENT,
+                       "Failed TransformTelescopeToCelestial: Scope RA=%g Scope DE=%f, Aligned RA=%f DE=%f", ra,
+                       de, skyRA, skyDEC);
+        }
+        else if (log)
+        {
+            DEBUGF(INDI::AlignmentSubsystem::DBG_ALIGNMENT,
+                   "TransformTelescopeToCelestial: Scope RA=%f Scope DE=%f, Aligned RA=%f DE=%f", ra, de,
+                   skyRA, skyDEC);
+        }
+    }
+#endif
+    if (!aligned && (syncdata.lst != 0.0))
+    {
+        if (log)
+            DEBUGF(DBG_SCOPE_STATUS, "Aligning with last sync delta RA %g DE %g", syncdata.deltaRA, syncdata.deltaDEC);
+        // should check values are in range!
+        skyRA += syncdata.deltaRA;
+        skyDEC += syncdata.deltaDEC;
+        if (skyDEC > 90.0 || skyDEC < -90.0)
+        {
+            skyRA += 12.00;
+            if (skyDEC > 0.0)
+                skyDEC = 180.0 - skyDEC;
+            else
+                skyDEC = -180.0 - skyDEC;
+        }
+        skyRA = range24(skyRA);
+    }
+
+#if defined WITH_ALIGN_GEEHALEL && !defined WITH_ALIGN
+    skyRA  = ghalignedRA;
+    skyDEC = ghalignedDEC;
+#endif
+#if defined WITH_ALIGN_GEEHALEL && defined WITH_ALIGN
+    if (AlignMethodSP.sp[0].s == ISS_ON)
+    {
+        skyRA  = ghalignedRA;
+        skyDEC = ghalignedDEC;
+    }
+#endif
+
+    *alignedra  = skyRA;
+    *aligneddec = skyDEC;
+}
+
+#ifdef WITH_SCOPE_LIMITS
+void EQMod::GotoPath(const GotoParams &g, double juliandate, std::vector<INDI::IHorizontalCoordinates> &path)
+{
+    // Both axes slew at the same speed, the shorter motion ends first. Sampled every quarter degree of the
+    // longer one, from the current to the target position.
+    const double step    = 0.25;
+    double lst           = getLst(juliandate, getLongitude());
+    int64_t radelta      = static_cast<int64_t>(g.ratargetencoder) - g.racurrentencoder;
+    int64_t dedelta      = static_cast<int64_t>(g.detargetencoder) - g.decurrentencoder;
+    double radegrees     = std::fabs(static_cast<double>(radelta)) * 360.0 / totalRAEncoder;
+    double dedegrees     = std::fabs(static_cast<double>(dedelta)) * 360.0 / totalDEEncoder;
+    unsigned int samples = static_cast<unsigned int>(std::ceil(std::max(radegrees, dedegrees) / step));
+
+    path.clear();
+    path.reserve(samples + 1);
+    for (unsigned int i = 0; i <= samples; i++)
+    {
+        double moved = i * step;
+        double rafraction = (radegrees > 0.0) ? std::min(moved / radegrees, 1.0) : 0.0;
+        double defraction = (dedegrees > 0.0) ? std::min(moved / dedegrees, 1.0) : 0.0;
+        uint32_t raencoder = static_cast<uint32_t>(g.racurrentencoder + std::llround(radelta * rafraction));
+        uint32_t deencoder = static_cast<uint32_t>(g.decurrentencoder + std::llround(dedelta * defraction));
+        INDI::IEquatorialCoordinates radec;
+        INDI::IHorizontalCoordinates altaz;
+
+        // Same coordinates as the limits are checked on while tracking
+        EncodersToRADec(raencoder, deencoder, lst, &radec.rightascension, &radec.declination, nullptr, nullptr);
+        AlignTelescopeCoords(juliandate, radec.rightascension, radec.declination, &radec.rightascension,
+                             &radec.declination, false);
+        INDI::EquatorialToHorizontal(&radec, &m_Location, juliandate, &altaz);
+        path.push_back(altaz);
+    }
+}
+#endif
+
 double EQMod::GetRATrackRate()
 {
     double rate = 0.0;
@@ -1937,6 +1986,20 @@ bool EQMod::Goto(double r, double d)
         return false;
     }
 
+#ifdef WITH_SCOPE_LIMITS
+    if (horizon)
+    {
+        std::vector<INDI::IHorizontalCoordinates> path;
+        INDI::IHorizontalCoordinates crossing;
+        GotoPath(gotoparams, juliandate, path);
+        if (!horizon->inGotoPathLimits(path, &crossing))
+        {
+            LOGF_WARN("Goto path crosses Horizon Limits at AZ=%3.3lf ALT=%3.3lf.", crossing.azimuth, crossing.altitude);
+            return false;
+        }
+    }
+#endif
+
     try
     {
         // stop motor
@@ -66,7 +66,6 @@ class EQMod : public INDI::Telescope, public INDI::GuiderInterface
         double currentRA, currentHA;
         double currentDEC;
         double alignedRA, alignedDEC;
-        double ghalignedRA, ghalignedDEC;
         double targetRA;
         double targetDEC;
 
@@ -173,6 +172,11 @@ class EQMod : public INDI::Telescope, public INDI::GuiderInterface
         double EncoderFromDec(double detarget, TelescopePierSide p, uint32_t initstep, uint32_t totalstep,
                               enum Hemisphere h);
         void EncoderTarget(GotoParams *g);
+        void AlignTelescopeCoords(double juliandate, double ra, double de, double *alignedra, double *aligneddec,
+                                  bool log);
+#ifdef WITH_SCOPE_LIMITS
+        void GotoPath(const GotoParams &g, double juliandate, std::vector<INDI::IHorizontalCoordinates> &path);
+#endif
         void SetSouthernHemisphere(bool southern);
         void UpdateDEInverted();
         double GetRATrackRate();
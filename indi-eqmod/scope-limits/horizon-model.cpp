@@ -0,0 +1,173 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "horizon-model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+static bool byAzimuth(INDI::IHorizontalCoordinates const &h1, INDI::IHorizontalCoordinates const &h2)
+{
+    return (h1.azimuth < h2.azimuth);
+}
+
+static double range360(double az)
+{
+    az = std::fmod(az, 360.0);
+    return (az < 0.0) ? az + 360.0 : az;
+}
+
+HorizonModel::HorizonModel(unsigned int binsPerDegree) : binsPerDegree(std::max(1u, binsPerDegree))
+{
+    compile(std::vector<INDI::IHorizontalCoordinates>());
+}
+
+void HorizonModel::compile(const std::vector<INDI::IHorizontalCoordinates> &points)
+{
+    size_t const count = 360 * binsPerDegree;
+    std::vector<INDI::IHorizontalCoordinates> sorted(points);
+    std::vector<double> edges(count + 1);
+
+    for (auto &point : sorted)
+        point.azimuth = range360(point.azimuth);
+    std::stable_sort(sorted.begin(), sorted.end(), byAzimuth);
+
+    // Horizon at bin boundaries, the last one is the first one again
+    for (size_t i = 0; i < count; i++)
+        edges[i] = interpolate(sorted, static_cast<double>(i) / binsPerDegree);
+    edges[count] = edges[0];
+
+    bins.resize(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        bins[i].altitude = edges[i];
+        bins[i].slope    = edges[i + 1] - edges[i];
+    }
+
+    // Raise the bins where a point sticks out above the line between boundaries
+    for (auto const &point : sorted)
+    {
+        double const x = point.azimuth * binsPerDegree;
+        size_t const i = std::min(static_cast<size_t>(x), count - 1);
+        double const above = point.altitude - (edges[i] + (edges[i + 1] - edges[i]) * (x - i));
+        if (above > 0.0)
+        {
+            // Keep the slope, the boundaries are raised by the same amount
+            double const raised = edges[i] + above;
+            if (raised > bins[i].altitude)
+                bins[i].altitude = raised;
+        }
+    }
+}
+
+double HorizonModel::altitude(double az) const
+{
+    double const x = range360(az) * binsPerDegree;
+    size_t const i = std::min(static_cast<size_t>(x), bins.size() - 1);
+    return bins[i].altitude + bins[i].slope * (x - i);
+}
+
+size_t HorizonModel::firstCrossing(const std::vector<INDI::IHorizontalCoordinates> &path) const
+{
+    size_t i = 0;
+
+    // Leaving a position already out of limits is allowed
+    while (i < path.size() && !inLimits(path[i].azimuth, path[i].altitude))
+        i++;
+    while (i < path.size() && inLimits(path[i].azimuth, path[i].altitude))
+        i++;
+    return i;
+}
+
+double HorizonModel::interpolate(const std::vector<INDI::IHorizontalCoordinates> &points, double az)
+{
+    INDI::IHorizontalCoordinates const scope{az, 0.0};
+
+    // Minimal altitude is zero if there is no horizon - arguable
+    if (points.size() == 0)
+        return 0.0;
+
+    // If there is a single horizon point, its altitude applies everywhere
+    if (points.size() == 1)
+        return points.begin()->altitude;
+
+    // Search for the horizon point just after which the tested point may be inserted - see std::lower_bound documentation
+    auto next = std::lower_bound(points.begin(), points.end(), scope, byAzimuth);
+
+    // If the tested point would be inserted at the end of the horizon list, loop next point back to first
+    if (next == points.end())
+        next = points.begin();
+
+    // If the tested azimuth is identical to the next point, use its altitude directly
+    if (next->azimuth == scope.azimuth)
+        return next->altitude;
+
+    // Grab the previous horizon point - the one after which inserting the tested point does not alter horizon ordering
+    auto const prev = ((next == points.begin()) ? points.end() : next) - 1;
+
+    // If the altitude is identical between the two horizon siblings, use it directly
+    if (prev->altitude == next->altitude)
+        return next->altitude;
+
+    // Compute azimuth distances for horizon point and scope point from reference point
+    double const delta_horizon_az = (next->azimuth - prev->azimuth) + ((next->azimuth >= prev->azimuth) ? 0.0 : 360.0);
+    double const delta_scope_az = (scope.azimuth - prev->azimuth) + ((scope.azimuth >= prev->azimuth) ? 0.0 : 360.0);
+
+    // Linear interpolation between the two horizontal points
+    double const delta_horizon_alt = next->altitude - prev->altitude;
+    return prev->altitude + delta_horizon_alt * delta_scope_az / delta_horizon_az;
+}
+
+int HorizonModel::readPoints(FILE *fp, std::vector<INDI::IHorizontalCoordinates> &points)
+{
+    char *line = nullptr;
+    size_t len = 0;
+    int nline  = 0;
+
+    while (getline(&line, &len, fp) != -1)
+    {
+        char *s = line, *end;
+        INDI::IHorizontalCoordinates point;
+
+        nline++;
+        while ((*s == ' ') || (*s == '\t'))
+            s++;
+        if ((*s == '#') || (*s == '\n') || (*s == '\r') || (*s == '\0'))
+            continue;
+
+        point.azimuth = strtod(s, &end);
+        if (end == s)
+        {
+            free(line);
+            return nline;
+        }
+        s = end;
+        while ((*s == ' ') || (*s == '\t') || (*s == ',') || (*s == ';'))
+            s++;
+        point.altitude = strtod(s, &end);
+        if (end == s)
+        {
+            free(line);
+            return nline;
+        }
+
+        points.push_back(point);
+    }
+
+    free(line);
+    return 0;
+}
@@ -0,0 +1,67 @@
+/* This file is part of the Skywatcher Protocol INDI driver.
+
+    The Skywatcher Protocol INDI driver is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Skywatcher Protocol INDI driver is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Skywatcher Protocol INDI driver.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <libastro.h>
+
+#include <cstdio>
+#include <vector>
+
+/*
+    The user horizon compiled into a table indexed by azimuth, so that a limit check costs the same whatever
+    the number of horizon points.
+
+    Each bin holds the horizon altitude at its start and the slope to the next bin, computed with the linear
+    interpolation between horizon points used so far. The horizon is thus exact in bins without a horizon point,
+    and at horizon points on a bin boundary. When a point lies inside a bin, the bin is raised by the height of
+    the point above the straight line, so that the table is never below the interpolated horizon.
+*/
+class HorizonModel
+{
+  public:
+    explicit HorizonModel(unsigned int binsPerDegree = 10);
+
+    // Points in any order, azimuths are taken modulo 360
+    void compile(const std::vector<INDI::IHorizontalCoordinates> &points);
+
+    double altitude(double az) const;
+    bool inLimits(double az, double alt) const
+    {
+        return alt >= altitude(az);
+    }
+
+    // Index of the first sample of path going out of limits, path.size() if none.
+    // A path starting out of limits is checked from its first sample back in limits.
+    size_t firstCrossing(const std::vector<INDI::IHorizontalCoordinates> &path) const;
+
+    // Interpolated altitude of the horizon, points sorted by increasing azimuth
+    static double interpolate(const std::vector<INDI::IHorizontalCoordinates> &points, double az);
+
+    // Reads "az alt" lines, separated by spaces, tabs, commas or semicolons, skipping blank and '#' lines.
+    // Returns 0, or the number of the first line that could not be read.
+    static int readPoints(FILE *fp, std::vector<INDI::IHorizontalCoordinates> &points);
+
+  private:
+    struct Bin
+    {
+        double altitude;
+        double slope;
+    };
+
+    unsigned int binsPerDegree;
+    std::vector<Bin> bins;
+};
@@ -57,6 +57,12 @@ void HorizonLimits::Reset()
 {
     if (horizon)
         horizon->erase(horizon->begin(), horizon->end());
+    Compile();
+}
+
+void HorizonLimits::Compile()
+{
+    model.compile(horizon ? *horizon : std::vector<INDI::IHorizontalCoordinates>());
 }
 void HorizonLimits::Init()
 {
@@ -166,6 +172,7 @@ bool HorizonLimits::ISNewNumber(const char *dev, const char *name, double values
             }
             horizon->push_back(hp);
             std::sort(horizon->begin(), horizon->end(), HorizonLimits::cmp);
+            Compile();
             low          = std::lower_bound(horizon->begin(), horizon->end(), hp, HorizonLimits::cmp);
             horizonindex = std::distance(horizon->begin(), low);
             DEBUGF(INDI::Logger::DBG_SESSION,
@@ -265,6 +272,7 @@ bool HorizonLimits::ISNewSwitch(const char *dev, const char *name, ISState *stat
                 }
                 horizon->push_back(hp);
                 std::sort(horizon->begin(), horizon->end(), HorizonLimits::cmp);
+                Compile();
                 low          = std::lower_bound(horizon->begin(), horizon->end(), hp, HorizonLimits::cmp);
                 horizonindex = std::distance(horizon->begin(), low);
                 DEBUGF(INDI::Logger::DBG_SESSION,
@@ -289,6 +297,7 @@ bool HorizonLimits::ISNewSwitch(const char *dev, const char *name, ISState *stat
                 LOGF_INFO("Horizon Limits: Deleted point Az = %f, Alt  = %f, Rank=%d",
                           horizon->at(horizonindex).azimuth, horizon->at(horizonindex).altitude, horizonindex);
                 horizon->erase(horizon->begin() + horizonindex);
+                Compile();
                 if (horizonindex >= (int)horizon->size())
                     horizonindex = horizon->size() - 1;
                 az->setValue(horizon->at(horizonindex).azimuth);
@@ -302,8 +311,7 @@ bool HorizonLimits::ISNewSwitch(const char *dev, const char *name, ISState *stat
             else if (sw->isNameMatch("HORIZONLIMITSLISTCLEAR"))
             {
                 LOG_INFO("Horizon Limits: List cleared");
-                if (horizon)
-                    horizon->erase(horizon->begin(), horizon->end());
+                Reset();
                 horizonindex            = -1;
                 az->setValue(0.0);
                 alt->setValue(0.0);
@@ -467,10 +475,7 @@ char *HorizonLimits::LoadDataFile(const char *filename)
 {
     wordexp_t wexp;
     FILE *fp;
-    char *line = nullptr;
-    size_t len = 0;
-    ssize_t read;
-    int nline = 0, pos = 0;
+    int nline;
     auto az  = HorizonLimitsPointNP.findWidgetByName("HORIZONLIMITS_POINT_AZ");
     auto alt = HorizonLimitsPointNP.findWidgetByName("HORIZONLIMITS_POINT_ALT");
 
@@ -489,35 +494,17 @@ char *HorizonLimits::LoadDataFile(const char *filename)
     Reset();
     setlocale(LC_NUMERIC, "C");
 
-    while ((read = getline(&line, &len, fp)) != -1)
+    // Measured horizons may hold many thousands of points, in any order
+    nline = HorizonModel::readPoints(fp, *horizon);
+    fclose(fp);
+    setlocale(LC_NUMERIC, "");
+    std::sort(horizon->begin(), horizon->end(), HorizonLimits::cmp);
+    Compile();
+
+    if (nline)
     {
-        char *s = line;
-        while ((*s == ' ') || (*s == '\t'))
-            s++;
-        if (*s == '#')
-            continue;
-        double az, alt;
-        if (sscanf(s, "%lg%n", &az, &pos) != 1)
-        {
-            fclose(fp);
-            snprintf((char *)sline, 4, "%d", nline);
-            setlocale(LC_NUMERIC, "");
-            return (char *)errorline;
-        }
-        s += pos;
-        while ((*s == ' ') || (*s == '\t'))
-            s++;
-        if (sscanf(s, "%lg%n", &alt, &pos) != 1)
-        {
-            fclose(fp);
-            snprintf((char *)sline, 4, "%d", nline);
-            setlocale(LC_NUMERIC, "");
-            return (char *)errorline;
-        }
-        INDI::IHorizontalCoordinates one{az, alt};
-        horizon->push_back(one);
-        nline++;
-        pos = 0;
+        snprintf((char *)sline, sizeof(errorline) - (sline - errorline), "%d", nline);
+        return (char *)errorline;
     }
 
     horizonindex            = -1;
@@ -526,54 +513,13 @@ char *HorizonLimits::LoadDataFile(const char *filename)
     HorizonLimitsPointNP.setState(IPS_OK);
     HorizonLimitsPointNP.apply();
 
-    if (line)
-        free(line);
-
-    fclose(fp);
-    setlocale(LC_NUMERIC, "");
     return nullptr;
 }
 
 bool HorizonLimits::inLimits(double raw_az, double raw_alt)
 {
-    INDI::IHorizontalCoordinates const scope{raw_az, raw_alt};
-
-    // Minimal altitude is zero if there is no horizon - arguable
-    if (horizon == nullptr || horizon->size() == 0)
-        return scope.altitude >= 0.0;
-
-    // If there is a single horizon point, test altitude directly
-    if (horizon->size() == 1)
-        return scope.altitude >= horizon->begin()->altitude;
-
-    // Search for the horizon point just after which the tested point may be inserted - see std::lower_bound documentation
-    std::vector<INDI::IHorizontalCoordinates>::iterator next = std::lower_bound(horizon->begin(), horizon->end(), scope,
-            HorizonLimits::cmp);
-
-    // If the tested point would be inserted at the end of the horizon list, loop next point back to first
-    if (next == horizon->end())
-        next = horizon->begin();
-
-    // If the tested azimuth is identical to the next point, test altitude directly
-    if (next->azimuth == scope.azimuth)
-        return (scope.altitude >= next->altitude);
-
-    // Grab the previous horizon point - the one after which inserting the tested point does not alter horizon ordering
-    std::vector<INDI::IHorizontalCoordinates>::iterator const prev = ((next == horizon->begin()) ? horizon->end() : next) - 1;
-
-    // If the altitude is identical between the two horizon siblings, test altitude directly
-    if (prev->altitude == next->altitude)
-        return (scope.altitude >= next->altitude);
-
-    // Compute azimuth distances for horizon point and scope point from reference point
-    double const delta_horizon_az = (next->azimuth - prev->azimuth) + ((next->azimuth >= prev->azimuth) ? 0.0 : 360.0);
-    double const delta_scope_az = (scope.azimuth - prev->azimuth) + ((scope.azimuth >= prev->azimuth) ? 0.0 : 360.0);
-
-    // Compute a linear interpolation coefficient between the two horizontal points and test against interpolated altitude
-    double const delta_horizon_alt = next->altitude - prev->altitude;
-    double const h = prev->altitude + delta_horizon_alt * delta_scope_az / delta_horizon_az;
-
-    return (scope.altitude >= h);
+    // Table lookup, the horizon is compiled when it changes
+    return model.inLimits(raw_az, raw_alt);
 }
 
 bool HorizonLimits::inGotoLimits(double az, double alt)
@@ -582,6 +528,21 @@ bool HorizonLimits::inGotoLimits(double az, double alt)
     return (inLimits(az, alt) || (swlimitgotodisable->getState() == ISS_ON));
 }
 
+bool HorizonLimits::inGotoPathLimits(const std::vector<INDI::IHorizontalCoordinates> &path,
+                                     INDI::IHorizontalCoordinates *crossing)
+{
+    auto swlimitgotodisable = HorizonLimitsLimitGotoSP.findWidgetByName("HORIZONLIMITSLIMITGOTODISABLE");
+    if (swlimitgotodisable->getState() == ISS_ON)
+        return true;
+
+    size_t i = model.firstCrossing(path);
+    if (i == path.size())
+        return true;
+    if (crossing)
+        *crossing = path[i];
+    return false;
+}
+
 bool HorizonLimits::checkLimits(double az, double alt, INDI::Telescope::TelescopeStatus status, bool ingoto)
 {
     static bool warningMessageDispatched = false;
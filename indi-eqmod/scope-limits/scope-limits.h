@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include "horizon-model.h"
+
 #include <inditelescope.h>
 
 #include <vector>
@@ -37,6 +39,9 @@ class HorizonLimits
 
     std::vector<INDI::IHorizontalCoordinates> *horizon;
     int horizonindex;
+    // Compiled from horizon whenever it changes, for the limit checks
+    HorizonModel model;
+    void Compile();
 
     char *WriteDataFile(const char *filename);
     char *LoadDataFile(const char *filename);
@@ -63,6 +68,9 @@ class HorizonLimits
     virtual void Reset();
     virtual bool inLimits(double az, double alt);
     virtual bool inGotoLimits(double az, double alt);
+    // False if the slew through path goes out of limits, crossing is then the first position out of limits
+    virtual bool inGotoPathLimits(const std::vector<INDI::IHorizontalCoordinates> &path,
+                                  INDI::IHorizontalCoordinates *crossing = nullptr);
     virtual bool checkLimits(double az, double alt, INDI::Telescope::TelescopeStatus status, bool ingoto);
     virtual bool saveConfigItems(FILE *fp);
 
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include "scope-limits/horizon-model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+static bool byAzimuth(INDI::IHorizontalCoordinates const &h1, INDI::IHorizontalCoordinates const &h2)
+{
+    return (h1.azimuth < h2.azimuth);
+}
+
+// Measured horizon: a few hills and a tree line, with the scatter of a real survey
+static std::vector<INDI::IHorizontalCoordinates> randomHorizon(size_t count, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> azimuth(0.0, 360.0);
+    std::normal_distribution<double> scatter(0.0, 2.0);
+    std::vector<INDI::IHorizontalCoordinates> points;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        double const az = azimuth(random);
+        double const alt = 15.0 + 10.0 * std::sin(az * M_PI / 60.0) + 5.0 * std::sin(az * M_PI / 7.0) + scatter(random);
+        points.push_back({az, std::max(0.0, alt)});
+    }
+    // A few points on bin boundaries
+    points.push_back({90.0, 30.0});
+    points.push_back({270.5, 2.0});
+    std::sort(points.begin(), points.end(), byAzimuth);
+    return points;
+}
+
+TEST(HorizonModelTest, empty_and_single_point)
+{
+    HorizonModel model;
+
+    EXPECT_TRUE(model.inLimits(0.0, 0.0));
+    EXPECT_FALSE(model.inLimits(123.0, -0.1));
+
+    model.compile({{200.0, 12.5}});
+    for (double az = -365.0; az <= 365.0; az += 0.7)
+    {
+        EXPECT_TRUE(model.inLimits(az, 12.5));
+        EXPECT_FALSE(model.inLimits(az, 12.4));
+    }
+}
+
+TEST(HorizonModelTest, interpolation)
+{
+    HorizonModel model;
+
+    // Same horizon as the scope_limits_altaz test of the driver, in any order
+    model.compile({{180.0, 20.0}, {0.0, 10.0}});
+    EXPECT_FALSE(model.inLimits(90.0, 14.0));
+    EXPECT_TRUE(model.inLimits(90.0, 15.0));
+    EXPECT_FALSE(model.inLimits(45.0, 12.4));
+    EXPECT_TRUE(model.inLimits(45.0, 12.5));
+    EXPECT_TRUE(model.inLimits(270.0, 15.0));
+    EXPECT_FALSE(model.inLimits(-90.0, 14.9));
+    EXPECT_TRUE(model.inLimits(360.0, 10.0));
+    EXPECT_FALSE(model.inLimits(720.0, 9.9));
+}
+
+TEST(HorizonModelTest, random_horizons_against_interpolation)
+{
+    for (unsigned int seed = 1; seed <= 5; seed++)
+    {
+        std::vector<INDI::IHorizontalCoordinates> const points = randomHorizon(50 * seed * seed, seed);
+        HorizonModel model;
+        model.compile(points);
+
+        // Bins holding a horizon point may be raised, all others follow the interpolation
+        std::vector<bool> raised(3600, false);
+        for (auto const &point : points)
+            raised[static_cast<size_t>(point.azimuth * 10.0)] = true;
+
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<double> azimuth(0.0, 360.0);
+        for (int i = 0; i < 20000; i++)
+        {
+            double const az = azimuth(random);
+            double const expected = HorizonModel::interpolate(points, az);
+
+            EXPECT_GE(model.altitude(az), expected - 1e-9) << "seed " << seed << " az " << az;
+            if (!raised[static_cast<size_t>(az * 10.0)])
+            {
+                EXPECT_NEAR(model.altitude(az), expected, 1e-9) << "seed " << seed << " az " << az;
+            }
+        }
+
+        // Every horizon point is itself on the limit
+        for (auto const &point : points)
+            EXPECT_FALSE(model.inLimits(point.azimuth, point.altitude - 1e-6)) << "seed " << seed << " az " << point.azimuth;
+    }
+}
+
+TEST(HorizonModelTest, first_crossing)
+{
+    HorizonModel model;
+    std::vector<INDI::IHorizontalCoordinates> path;
+
+    model.compile({{0.0, 10.0}, {90.0, 40.0}, {180.0, 10.0}, {270.0, 10.0}});
+
+    // Along the horizon at 20 degrees, over the hill peaking at azimuth 90
+    for (double az = 0.0; az <= 180.0; az += 0.25)
+        path.push_back({az, 20.0});
+    size_t const crossing = model.firstCrossing(path);
+    ASSERT_LT(crossing, path.size());
+    EXPECT_NEAR(path[crossing].azimuth, 30.0, 0.25);
+
+    // Same path above the hill
+    for (auto &position : path)
+        position.altitude = 45.0;
+    EXPECT_EQ(model.firstCrossing(path), path.size());
+
+    // Starting below the limit and rising out of it is allowed, dipping back is not
+    path = {{300.0, 5.0}, {300.0, 8.0}, {300.0, 12.0}, {300.0, 30.0}};
+    EXPECT_EQ(model.firstCrossing(path), path.size());
+    path.push_back({300.0, 9.0});
+    EXPECT_EQ(model.firstCrossing(path), path.size() - 1);
+
+    EXPECT_EQ(model.firstCrossing({}), 0u);
+}
+
+TEST(HorizonModelTest, read_points)
+{
+    std::vector<INDI::IHorizontalCoordinates> const points = randomHorizon(20000, 11);
+    std::vector<INDI::IHorizontalCoordinates> read;
+    FILE *fp = tmpfile();
+    ASSERT_NE(fp, nullptr);
+
+    fprintf(fp, "# Measured horizon\n\n");
+    for (size_t i = 0; i < points.size(); i++)
+        fprintf(fp, (i % 3 == 0) ? "%.17g %.17g\n" : (i % 3 == 1) ? "\t%.17g,%.17g\r\n" : "%.17g; %.17g\n",
+                points[i].azimuth, points[i].altitude);
+    rewind(fp);
+    EXPECT_EQ(HorizonModel::readPoints(fp, read), 0);
+    ASSERT_EQ(read.size(), points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        EXPECT_EQ(read[i].azimuth, points[i].azimuth);
+        EXPECT_EQ(read[i].altitude, points[i].altitude);
+    }
+
+    // Line numbers count comments and blank lines
+    fprintf(fp, "10 x\n");
+    rewind(fp);
+    read.clear();
+    EXPECT_EQ(HorizonModel::readPoints(fp, read), static_cast<int>(points.size()) + 3);
+    fclose(fp);
+}
+
+TEST(HorizonModelTest, checks_per_second)
+{
+    std::vector<INDI::IHorizontalCoordinates> const points = randomHorizon(10000, 7);
+    HorizonModel model;
+    std::vector<double> azimuths;
+    std::mt19937 random(7);
+    std::uniform_real_distribution<double> azimuth(-360.0, 720.0);
+    size_t const checks = 1000000;
+    size_t inLegacy = 0, inTable = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    model.compile(points);
+    double const compileTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < checks; i++)
+        azimuths.push_back(azimuth(random));
+
+    start = std::chrono::steady_clock::now();
+    for (double az : azimuths)
+    {
+        double const wrapped = az - 360.0 * std::floor(az / 360.0);
+        inLegacy += (20.0 >= HorizonModel::interpolate(points, wrapped));
+    }
+    double const legacyTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (double az : azimuths)
+        inTable += model.inLimits(az, 20.0);
+    double const tableTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << points.size() << " horizon points, compiled in " << compileTime * 1e3 << " ms: "
+              << checks / legacyTime << " interpolated checks/s, " << checks / tableTime << " table checks/s" << std::endl;
+
+    // The table is conservative, it never lets through a position the interpolation refuses
+    EXPECT_LE(inTable, inLegacy);
+    EXPECT_LT(tableTime, legacyTime);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -24,6 +24,7 @@
 
 #include "config.h"
 #include "gphoto_driver.h"
+#include "gphoto_liveview.h"
 #include "gphoto_readimage.h"
 
 #include <algorithm>
@@ -214,6 +215,61 @@ static class Loader
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/* Live view previews of the camera, as JPEG frames */
+class GPhotoPreviewSource : public LiveViewSource
+{
+    public:
+        GPhotoPreviewSource(gphoto_driver *driver, const char *device) : m_Driver(driver), m_Device(device)
+        {
+            int rc = gp_file_new(&m_File);
+            if (rc != GP_OK)
+            {
+                DEBUGFDEVICE(m_Device, INDI::Logger::DBG_ERROR, "Error creating gphoto file: %s", gp_result_as_string(rc));
+                m_File = nullptr;
+            }
+        }
+        ~GPhotoPreviewSource() override
+        {
+            if (m_File)
+                gp_file_unref(m_File);
+        }
+
+        bool capture(std::vector<uint8_t> &frame) override
+        {
+            char errMsg[MAXRBUF] = {0};
+            const char * previewData = nullptr;
+            unsigned long int previewSize = 0;
+
+            if (m_File == nullptr || gphoto_capture_preview(m_Driver, m_File, errMsg) != GP_OK)
+                return false;
+
+            int rc = gp_file_get_data_and_size(m_File, &previewData, &previewSize);
+            if (rc != GP_OK)
+            {
+                DEBUGFDEVICE(m_Device, INDI::Logger::DBG_ERROR, "Error getting preview image data and size: %s",
+                             gp_result_as_string(rc));
+                return false;
+            }
+
+            const uint8_t *jpeg = nullptr;
+            size_t jpegSize = 0;
+            if (liveview_find_frame(reinterpret_cast<const uint8_t *>(previewData), previewSize, &jpeg, &jpegSize) == false)
+            {
+                DEBUGDEVICE(m_Device, INDI::Logger::DBG_DEBUG, "No JPEG SOI marker found in preview frame, discarding.");
+                return false;
+            }
+
+            // The camera file is overwritten by the next preview while this one waits to be decoded
+            frame.assign(jpeg, jpeg + jpegSize);
+            return true;
+        }
+
+    private:
+        gphoto_driver *m_Driver;
+        const char *m_Device;
+        CameraFile *m_File {nullptr};
+};
+
 GPhotoCCD::GPhotoCCD() : FI(this)
 {
     memset(model, 0, MAXINDINAME);
@@ -325,6 +381,19 @@ bool GPhotoCCD::initProperties()
     ForceBULBSP[INDI_DISABLED].fill("Off", "Off", isNikon ? ISS_ON : ISS_OFF);
     ForceBULBSP.fill(getDeviceName(), "CCD_FORCE_BLOB", "Force BULB", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0, IPS_IDLE);
 
+    // Live View
+    LiveViewSizeNP[0].fill("MAX_WIDTH", "Max width", "%.f", 0, 8192, 16, 0);
+    LiveViewSizeNP.fill(getDeviceName(), "CCD_LIVE_VIEW_SIZE", "Live View Size", OPTIONS_TAB, IP_RW, 60, IPS_IDLE);
+    LiveViewSizeNP.load();
+    m_LiveViewMaxWidth = LiveViewSizeNP[0].getValue();
+
+    LiveViewColorSP[LIVE_VIEW_RGB].fill("LIVE_VIEW_RGB", "RGB", ISS_ON);
+    LiveViewColorSP[LIVE_VIEW_MONO].fill("LIVE_VIEW_MONO", "Mono", ISS_OFF);
+    LiveViewColorSP.fill(getDeviceName(), "CCD_LIVE_VIEW_COLOR", "Live View Color", OPTIONS_TAB, IP_RW, ISR_1OFMANY, 0,
+                         IPS_IDLE);
+    LiveViewColorSP.load();
+    m_LiveViewMono = LiveViewColorSP[LIVE_VIEW_MONO].getState() == ISS_ON;
+
     // Upload File
     UploadFileTP[0].fill("PATH", "Path", nullptr);
     UploadFileTP.fill(getDeviceName(), "CCD_UPLOAD_FILE", "Upload File", OPTIONS_TAB, IP_RW, 0, IPS_IDLE);
@@ -449,6 +518,8 @@ bool GPhotoCCD::updateProperties()
 
         defineProperty(ForceBULBSP);
         defineProperty(DownloadTimeoutNP);
+        defineProperty(LiveViewSizeNP);
+        defineProperty(LiveViewColorSP);
     }
     else
     {
@@ -475,6 +546,8 @@ bool GPhotoCCD::updateProperties()
 
         deleteProperty(ForceBULBSP);
         deleteProperty(DownloadTimeoutNP);
+        deleteProperty(LiveViewSizeNP);
+        deleteProperty(LiveViewColorSP);
 
         HideExtendedOptions();
     }
@@ -616,6 +689,20 @@ bool GPhotoCCD::ISNewSwitch(const char * dev, const char * name, ISState * state
             return true;
         }
 
+        ///////////////////////////////////////////////////////////////////////////////////////////////
+        // Live View Color
+        // Mono decodes the luminance only, which is all that focusing needs.
+        ///////////////////////////////////////////////////////////////////////////////////////////////
+        if (LiveViewColorSP.isNameMatch(name))
+        {
+            LiveViewColorSP.update(states, names, n);
+            LiveViewColorSP.setState(IPS_OK);
+            LiveViewColorSP.apply();
+            saveConfig(LiveViewColorSP);
+            m_LiveViewMono = LiveViewColorSP[LIVE_VIEW_MONO].getState() == ISS_ON;
+            return true;
+        }
+
         if (ExposurePresetSP.isNameMatch(name))
         {
             if (!ExposurePresetSP.update(states, names, n))
@@ -804,6 +891,17 @@ bool GPhotoCCD::ISNewNumber(const char * dev, const char * name, double values[]
             return true;
         }
 
+        // Live View Size, 0 for the full preview size
+        if (LiveViewSizeNP.isNameMatch(name))
+        {
+            LiveViewSizeNP.update(values, names, n);
+            LiveViewSizeNP.setState(IPS_OK);
+            LiveViewSizeNP.apply();
+            saveConfig(LiveViewSizeNP);
+            m_LiveViewMaxWidth = LiveViewSizeNP[0].getValue();
+            return true;
+        }
+
         // Download Timeout
         if (DownloadTimeoutNP.isNameMatch(name))
         {
@@ -1923,11 +2021,18 @@ bool GPhotoCCD::StartStreaming()
 {
     if (gphoto_start_preview(gphotodrv) == GP_OK)
     {
-        Streamer->setPixelFormat(INDI_RGB);
-        std::unique_lock<std::mutex> guard(liveStreamMutex);
-        m_RunLiveStream = true;
-        guard.unlock();
-        m_LiveViewThread = std::thread(&GPhotoCCD::streamLiveView, this);
+        Streamer->setPixelFormat(m_LiveViewMono ? INDI_MONO : INDI_RGB);
+        m_LiveView.reset();
+        m_PreviewSource.reset(new GPhotoPreviewSource(gphotodrv, getDeviceName()));
+        m_LiveView.reset(new LiveViewPipeline(*m_PreviewSource, std::bind(&GPhotoCCD::newLiveViewFrame, this,
+                         std::placeholders::_1), [this]()
+        {
+            LiveViewDecoder::Options options;
+            options.maxWidth = m_LiveViewMaxWidth;
+            options.mono     = m_LiveViewMono;
+            return options;
+        }));
+        m_LiveView->start();
         return true;
     }
 
@@ -1940,151 +2045,40 @@ bool GPhotoCCD::StartStreaming()
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 bool GPhotoCCD::StopStreaming()
 {
-    std::unique_lock<std::mutex> guard(liveStreamMutex);
-    m_RunLiveStream = false;
-    guard.unlock();
-    m_LiveViewThread.join();
+    if (m_LiveView)
+    {
+        m_LiveView->stop();
+        LOGF_DEBUG("Live view: %llu previews captured, %llu decoded, %llu dropped as stale, %llu corrupted.",
+                   static_cast<unsigned long long>(m_LiveView->captured()), static_cast<unsigned long long>(m_LiveView->decoded()),
+                   static_cast<unsigned long long>(m_LiveView->dropped()), static_cast<unsigned long long>(m_LiveView->failed()));
+        m_LiveView.reset();
+        m_PreviewSource.reset();
+    }
     return (gphoto_stop_preview(gphotodrv) == GP_OK);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-//
+/// Runs on the live view decode thread
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-void GPhotoCCD::streamLiveView()
+void GPhotoCCD::newLiveViewFrame(const LiveViewDecoder &decoder)
 {
-    //char errMsg[MAXRBUF];
-    const char * previewData = nullptr;
-    unsigned long int previewSize = 0;
-    CameraFile * previewFile = nullptr;
+    int w = decoder.width(), h = decoder.height(), naxis = decoder.components();
 
-    int rc = gp_file_new(&previewFile);
-    if (rc != GP_OK)
+    if (naxis != PrimaryCCD.getNAxis())
     {
-        LOGF_ERROR("Error creating gphoto file: %s", gp_result_as_string(rc));
-        return;
+        Streamer->setPixelFormat(naxis == 1 ? INDI_MONO : INDI_RGB);
+        PrimaryCCD.setNAxis(naxis);
     }
 
-    char errMsg[MAXRBUF] = {0};
-    while (true)
+    if (PrimaryCCD.getSubW() != w || PrimaryCCD.getSubH() != h)
     {
-        std::unique_lock<std::mutex> guard(liveStreamMutex);
-        if (m_RunLiveStream == false)
-            break;
-        guard.unlock();
-
-        rc = gphoto_capture_preview(gphotodrv, previewFile, errMsg);
-        if (rc != GP_OK)
-        {
-            //LOGF_DEBUG("%s", errMsg);
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
-        }
-
-        if (rc >= GP_OK)
-        {
-            rc = gp_file_get_data_and_size(previewFile, &previewData, &previewSize);
-            if (rc != GP_OK)
-            {
-                LOGF_ERROR("Error getting preview image data and size: %s", gp_result_as_string(rc));
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                continue;
-            }
-        }
-
-        uint8_t * inBuffer = reinterpret_cast<uint8_t *>(const_cast<char *>(previewData));
-
-        //        if (streamSubframeS[1].s == ISS_ON)
-        //        {
-        //            if (liveVideoWidth <= 0)
-        //            {
-        //                read_jpeg_size(inBuffer, previewSize, &liveVideoWidth, &liveVideoHeight);
-        //                Streamer->setSize(liveVideoWidth, liveVideoHeight);
-        //            }
-
-        //            std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
-        //            Streamer->newFrame(inBuffer, previewSize);
-        //            ccdguard.unlock();
-        //            continue;
-        //        }
-
-        // Fast path: well-behaved cameras (Canon, Nikon, etc.) always start with 0xFF 0xD8.
-        // Some cameras (e.g. Panasonic Lumix) prepend garbage bytes and/or an embedded
-        // thumbnail before the actual liveview JPEG, resulting in multiple SOI markers.
-        // Only scan when necessary: O(1) for normal cameras, O(n) only for malformed buffers.
-        uint8_t *cleanBuffer = inBuffer;
-        unsigned long cleanSize = previewSize;
-
-        if (previewSize < 2 || inBuffer[0] != 0xFF || inBuffer[1] != 0xD8)
-        {
-            // Scan for the last SOI marker: the actual liveview frame follows any
-            // prepended garbage bytes or an embedded thumbnail JPEG.
-            cleanBuffer = nullptr;
-            for (unsigned long i = 0; i + 1 < previewSize; ++i)
-            {
-                if (inBuffer[i] == 0xFF && inBuffer[i + 1] == 0xD8)
-                {
-                    cleanBuffer = &inBuffer[i];
-                    cleanSize   = previewSize - i;
-                }
-            }
-
-            if (cleanBuffer == nullptr)
-            {
-                LOG_DEBUG("No JPEG SOI marker found in preview frame, discarding.");
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                continue;
-            }
-        }
-
-        uint8_t * ccdBuffer      = PrimaryCCD.getFrameBuffer();
-        size_t size             = 0;
-        int w = 0, h = 0, naxis = 0;
-
-        // Read jpeg from memory
-        std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
-        rc = read_jpeg_mem(cleanBuffer, cleanSize, &ccdBuffer, &size, &naxis, &w, &h);
-
-        if (rc != 0)
-        {
-            LOG_ERROR("Error getting live video frame.");
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-            continue;
-        }
-
-        if (liveVideoWidth <= 0)
-        {
-            liveVideoWidth = w;
-            liveVideoHeight = h;
-            Streamer->setSize(liveVideoWidth, liveVideoHeight);
-        }
-
-        PrimaryCCD.setFrameBuffer(ccdBuffer);
-
-        // We are done with writing to CCD buffer
-        ccdguard.unlock();
-
-        if (naxis != PrimaryCCD.getNAxis())
-        {
-            if (naxis == 1)
-                Streamer->setPixelFormat(INDI_MONO);
-
-            PrimaryCCD.setNAxis(naxis);
-        }
-
-        if (PrimaryCCD.getSubW() != w || PrimaryCCD.getSubH() != h)
-        {
-            Streamer->setSize(w, h);
-            PrimaryCCD.setBin(1, 1);
-            PrimaryCCD.setFrame(0, 0, w, h);
-        }
-
-        if (PrimaryCCD.getFrameBufferSize() != static_cast<int>(size))
-            PrimaryCCD.setFrameBufferSize(size, false);
-
-        Streamer->newFrame(ccdBuffer, size);
+        Streamer->setSize(w, h);
+        PrimaryCCD.setBin(1, 1);
+        PrimaryCCD.setFrame(0, 0, w, h);
     }
 
-    gp_file_unref(previewFile);
+    // The decoded frame is streamed as is, the CCD frame buffer is left to exposures
+    Streamer->newFrame(decoder.image(), decoder.imageSize());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2127,6 +2121,10 @@ bool GPhotoCCD::saveConfigItems(FILE * fp)
     // Force BULB Mode
     ForceBULBSP.save(fp);
 
+    // Live View
+    LiveViewSizeNP.save(fp);
+    LiveViewColorSP.save(fp);
+
     return true;
 }
 
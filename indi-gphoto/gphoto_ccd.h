@@ -23,11 +23,13 @@
 #pragma once
 
 #include "gphoto_driver.h"
+#include "gphoto_liveview.h"
 
 #include <indiccd.h>
 #include <indifocuserinterface.h>
 
 #include <map>
+#include <memory>
 #include <future>
 #include <string>
 
@@ -128,10 +130,7 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
         // Streaming
         bool StartStreaming() override;
         bool StopStreaming() override;
-        void streamLiveView();
-
-        std::mutex liveStreamMutex;
-        bool m_RunLiveStream;
+        void newLiveViewFrame(const LiveViewDecoder &decoder);
 
     private:
         void createSwitch(INDI::PropertySwitch &property, const char *baseName, char ** options, int max_opts, int setidx);
@@ -167,9 +166,6 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
         bool m_CanFocus { false };
         int32_t m_TargetLargeStep {0}, m_TargetMedStep {0}, m_TargetLowStep {0}, m_FocusTimerID {-1};
 
-        int liveVideoWidth  {-1};
-        int liveVideoHeight {-1};
-
         // binning ?
         bool binning { false };
 
@@ -205,14 +201,26 @@ class GPhotoCCD : public INDI::CCD, public INDI::FocuserInterface
         INDI::PropertySwitch ForceBULBSP {2};
         // Wait this many seconds before giving up on exposure download
         INDI::PropertyNumber DownloadTimeoutNP {1};
+        // Live view decoded to at least this width, 0 for the full size
+        INDI::PropertyNumber LiveViewSizeNP {1};
+        // Live view in color, or luminance only for focusing
+        INDI::PropertySwitch LiveViewColorSP {2};
+        enum
+        {
+            LIVE_VIEW_RGB,
+            LIVE_VIEW_MONO
+        };
         // Upload file, used for testing purposes under simulation under native mode
         INDI::PropertyText UploadFileTP {1};
         INDI::PropertyBlob imageBP {INDI::Property()};
 
         Camera * camera = nullptr;
 
-        // Threading
-        std::thread m_LiveViewThread;
+        // Live view, captured and decoded off the main thread
+        std::unique_ptr<LiveViewSource> m_PreviewSource;
+        std::unique_ptr<LiveViewPipeline> m_LiveView;
+        std::atomic<uint32_t> m_LiveViewMaxWidth {0};
+        std::atomic_bool m_LiveViewMono {false};
 
         std::map <uint8_t, uint8_t> m_CaptureFormatMap;
 
@@ -0,0 +1,339 @@
+/*
+    GPhoto live view pipeline
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this library; if not, write to the Free Software Foundation,
+    Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+
+*/
+
+#include "gphoto_liveview.h"
+
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+
+#include <jpeglib.h>
+
+bool liveview_find_frame(const uint8_t *data, size_t size, const uint8_t **frame, size_t *frameSize)
+{
+    // Fast path: O(1) for normal cameras, O(n) only for malformed buffers.
+    if (size >= 2 && data[0] == 0xFF && data[1] == 0xD8)
+    {
+        *frame     = data;
+        *frameSize = size;
+        return true;
+    }
+
+    // The actual liveview frame follows any prepended garbage bytes or embedded thumbnail JPEG
+    for (size_t i = size; i-- > 1;)
+    {
+        if (data[i - 1] == 0xFF && data[i] == 0xD8)
+        {
+            *frame     = data + i - 1;
+            *frameSize = size - i + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+LiveViewRecording::LiveViewRecording(std::vector<uint8_t> mjpeg) : m_Data(std::move(mjpeg))
+{
+    // Frames run from one SOI marker to the next, or to the end of the recording
+    size_t start = m_Data.size();
+    for (size_t i = 0; i + 1 < m_Data.size(); i++)
+    {
+        if (m_Data[i] != 0xFF || m_Data[i + 1] != 0xD8)
+            continue;
+        if (start < i)
+            m_Frames.emplace_back(start, i - start);
+        start = i;
+
+        // Skip to the EOI marker, so that embedded thumbnails stay within their frame
+        for (i += 2; i + 1 < m_Data.size() && !(m_Data[i] == 0xFF && m_Data[i + 1] == 0xD9); i++)
+            ;
+    }
+    if (start < m_Data.size())
+        m_Frames.emplace_back(start, m_Data.size() - start);
+}
+
+bool LiveViewRecording::capture(std::vector<uint8_t> &frame)
+{
+    if (m_Frames.empty())
+        return false;
+
+    if (m_Interval.count() > 0)
+    {
+        std::this_thread::sleep_until(m_Last + m_Interval);
+        m_Last = std::chrono::steady_clock::now();
+    }
+
+    const auto &entry = m_Frames[m_Next];
+    m_Next = (m_Next + 1) % m_Frames.size();
+    frame.assign(m_Data.begin() + entry.first, m_Data.begin() + entry.first + entry.second);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+LiveViewQueue::LiveViewQueue(size_t capacity) : m_Capacity(capacity > 0 ? capacity : 1)
+{
+}
+
+void LiveViewQueue::push(std::vector<uint8_t> &frame)
+{
+    std::unique_lock<std::mutex> guard(m_Lock);
+
+    if (m_Frames.size() >= m_Capacity)
+    {
+        // Stale, the decoder is behind the camera
+        m_Spare.push_back(std::move(m_Frames.front()));
+        m_Frames.pop_front();
+        m_Dropped++;
+    }
+
+    m_Frames.push_back(std::move(frame));
+    frame.clear();
+    if (!m_Spare.empty())
+    {
+        frame.swap(m_Spare.back());
+        frame.clear();
+        m_Spare.pop_back();
+    }
+
+    guard.unlock();
+    m_CV.notify_one();
+}
+
+bool LiveViewQueue::pop(std::vector<uint8_t> &frame)
+{
+    std::unique_lock<std::mutex> guard(m_Lock);
+    m_CV.wait(guard, [this]()
+    {
+        return m_Stopped || !m_Frames.empty();
+    });
+
+    if (m_Stopped)
+        return false;
+
+    // Previews older than the latest one are stale by now
+    while (m_Frames.size() > 1)
+    {
+        m_Spare.push_back(std::move(m_Frames.front()));
+        m_Frames.pop_front();
+        m_Dropped++;
+    }
+
+    // The decoder gives its previous frame back for the producer to reuse
+    std::vector<uint8_t> previous;
+    previous.swap(frame);
+    frame.swap(m_Frames.front());
+    m_Frames.pop_front();
+    if (previous.capacity() > 0)
+        m_Spare.push_back(std::move(previous));
+    return true;
+}
+
+void LiveViewQueue::stop()
+{
+    std::unique_lock<std::mutex> guard(m_Lock);
+    m_Stopped = true;
+    guard.unlock();
+    m_CV.notify_all();
+}
+
+void LiveViewQueue::reset()
+{
+    std::unique_lock<std::mutex> guard(m_Lock);
+    while (!m_Frames.empty())
+    {
+        m_Spare.push_back(std::move(m_Frames.front()));
+        m_Frames.pop_front();
+    }
+    m_Stopped = false;
+    m_Dropped = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Custom libjpeg error manager that uses longjmp instead of exit(), as in read_jpeg_mem()
+struct LiveViewDecoder::Context
+{
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr pub;
+    jmp_buf setjmp_buffer;
+    // Scanline pointers into the image, one per row of a libjpeg output pass
+    std::vector<JSAMPROW> rows;
+};
+
+static void liveview_jpeg_error_exit(j_common_ptr cinfo)
+{
+    auto *context = static_cast<jmp_buf *>(cinfo->client_data);
+    longjmp(*context, 1);
+}
+
+static void liveview_jpeg_output_message(j_common_ptr)
+{
+    // Corrupted previews are dropped, no need to report each warning on stderr
+}
+
+LiveViewDecoder::LiveViewDecoder() : m_Context(new Context)
+{
+    m_Context->cinfo.err            = jpeg_std_error(&m_Context->pub);
+    m_Context->pub.error_exit       = liveview_jpeg_error_exit;
+    m_Context->pub.output_message   = liveview_jpeg_output_message;
+    m_Context->cinfo.client_data    = &m_Context->setjmp_buffer;
+    // The decompressor and its memory pools are kept from one frame to the next
+    jpeg_create_decompress(&m_Context->cinfo);
+}
+
+LiveViewDecoder::~LiveViewDecoder()
+{
+    jpeg_destroy_decompress(&m_Context->cinfo);
+    delete m_Context;
+}
+
+unsigned int LiveViewDecoder::scaleDenominator(uint32_t imageWidth, uint32_t maxWidth)
+{
+    unsigned int denominator = 1;
+    if (maxWidth == 0)
+        return denominator;
+
+    // libjpeg rounds scaled dimensions up
+    while (denominator < 8 && (imageWidth + 2 * denominator - 1) / (2 * denominator) >= maxWidth)
+        denominator *= 2;
+    return denominator;
+}
+
+bool LiveViewDecoder::decode(const uint8_t *jpeg, size_t size, const Options &options)
+{
+    struct jpeg_decompress_struct *cinfo = &m_Context->cinfo;
+
+    if (setjmp(m_Context->setjmp_buffer))
+    {
+        // Fatal libjpeg error: drop the frame and get the decompressor ready for the next one
+        jpeg_abort_decompress(cinfo);
+        return false;
+    }
+
+    jpeg_mem_src(cinfo, const_cast<unsigned char *>(jpeg), size);
+    jpeg_read_header(cinfo, TRUE);
+
+    // Scale in the DCT domain, fast integer IDCT and plain upsampling: this is a preview
+    cinfo->scale_num           = 1;
+    cinfo->scale_denom         = scaleDenominator(cinfo->image_width, options.maxWidth);
+    cinfo->dct_method          = JDCT_IFAST;
+    cinfo->do_fancy_upsampling = FALSE;
+    cinfo->do_block_smoothing  = FALSE;
+    cinfo->out_color_space     = options.mono ? JCS_GRAYSCALE : JCS_RGB;
+
+    jpeg_start_decompress(cinfo);
+
+    m_Width      = cinfo->output_width;
+    m_Height     = cinfo->output_height;
+    m_Components = cinfo->output_components;
+
+    // The image only grows, the frame of a smaller or mono stream reuses it as is
+    const size_t stride = static_cast<size_t>(m_Width) * m_Components;
+    if (m_Image.size() < stride * m_Height)
+        m_Image.resize(stride * m_Height);
+
+    m_Context->rows.resize(cinfo->rec_outbuf_height);
+    while (cinfo->output_scanline < cinfo->output_height)
+    {
+        JDIMENSION count = std::min<JDIMENSION>(cinfo->rec_outbuf_height, cinfo->output_height - cinfo->output_scanline);
+        for (JDIMENSION i = 0; i < count; i++)
+            m_Context->rows[i] = m_Image.data() + (cinfo->output_scanline + i) * stride;
+        jpeg_read_scanlines(cinfo, m_Context->rows.data(), count);
+    }
+
+    jpeg_finish_decompress(cinfo);
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+LiveViewPipeline::LiveViewPipeline(LiveViewSource &source, FrameHandler onFrame, OptionsProvider options)
+    : m_Source(source), m_OnFrame(std::move(onFrame)), m_Options(std::move(options))
+{
+}
+
+LiveViewPipeline::~LiveViewPipeline()
+{
+    stop();
+}
+
+void LiveViewPipeline::start()
+{
+    stop();
+
+    m_Queue.reset();
+    m_Captured = m_Decoded = m_Failed = 0;
+    m_Running = true;
+    m_DecodeThread  = std::thread(&LiveViewPipeline::decodeLoop, this);
+    m_CaptureThread = std::thread(&LiveViewPipeline::captureLoop, this);
+}
+
+void LiveViewPipeline::stop()
+{
+    m_Running = false;
+    if (m_CaptureThread.joinable())
+        m_CaptureThread.join();
+    m_Queue.stop();
+    if (m_DecodeThread.joinable())
+        m_DecodeThread.join();
+}
+
+void LiveViewPipeline::captureLoop()
+{
+    std::vector<uint8_t> frame;
+
+    while (m_Running)
+    {
+        if (m_Source.capture(frame) == false)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        m_Captured++;
+        m_Queue.push(frame);
+    }
+}
+
+void LiveViewPipeline::decodeLoop()
+{
+    std::vector<uint8_t> frame;
+
+    while (m_Queue.pop(frame))
+    {
+        if (m_Decoder.decode(frame.data(), frame.size(), m_Options()) == false)
+        {
+            m_Failed++;
+            continue;
+        }
+
+        m_Decoded++;
+        m_OnFrame(m_Decoder);
+    }
+}
@@ -0,0 +1,231 @@
+/*
+    GPhoto live view pipeline
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this library; if not, write to the Free Software Foundation,
+    Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Finds the JPEG frame of a live view preview.
+ * Well-behaved cameras (Canon, Nikon, etc.) start the preview with the SOI marker and the preview is the frame.
+ * Some cameras (e.g. Panasonic Lumix) prepend garbage bytes and/or an embedded thumbnail, in which case the frame
+ * starts at the last SOI marker.
+ * @return false if there is no SOI marker.
+ */
+bool liveview_find_frame(const uint8_t *data, size_t size, const uint8_t **frame, size_t *frameSize);
+
+/**
+ * @brief Where live view previews come from: the camera, or a recording under test.
+ */
+class LiveViewSource
+{
+    public:
+        virtual ~LiveViewSource() = default;
+
+        /**
+         * @brief Captures the next preview JPEG into frame, reusing its storage.
+         * @return false if no preview could be captured, the pipeline waits a little and tries again.
+         */
+        virtual bool capture(std::vector<uint8_t> &frame) = 0;
+};
+
+/**
+ * @brief Replays a recorded MJPEG preview sequence, frames back to back, in a loop.
+ */
+class LiveViewRecording : public LiveViewSource
+{
+    public:
+        /** @param mjpeg Concatenated JPEG frames, as recorded from a camera */
+        explicit LiveViewRecording(std::vector<uint8_t> mjpeg);
+
+        bool capture(std::vector<uint8_t> &frame) override;
+
+        /** @brief Wait this long between frames to stand for the camera frame rate, none by default */
+        void setFrameInterval(std::chrono::microseconds interval)
+        {
+            m_Interval = interval;
+        }
+
+        size_t frameCount() const
+        {
+            return m_Frames.size();
+        }
+
+    private:
+        std::vector<uint8_t> m_Data;
+        // Offset and size of each frame in m_Data
+        std::vector<std::pair<size_t, size_t>> m_Frames;
+        size_t m_Next {0};
+        std::chrono::microseconds m_Interval {0};
+        std::chrono::steady_clock::time_point m_Last;
+};
+
+/**
+ * @brief Bounded queue of compressed previews. When full, the oldest preview is dropped, and the decoder always takes
+ * the most recent one. Frame storage circulates between the producer, the queue and the consumer and is not freed.
+ */
+class LiveViewQueue
+{
+    public:
+        explicit LiveViewQueue(size_t capacity = 2);
+
+        /** @brief Queues frame, and hands back in it an empty buffer to capture the next preview into. */
+        void push(std::vector<uint8_t> &frame);
+
+        /**
+         * @brief Waits for the latest frame and swaps it into frame, taking the previous one back.
+         * @return false once stopped.
+         */
+        bool pop(std::vector<uint8_t> &frame);
+
+        void stop();
+        void reset();
+
+        uint64_t dropped() const
+        {
+            return m_Dropped;
+        }
+
+    private:
+        size_t m_Capacity;
+        std::deque<std::vector<uint8_t>> m_Frames;
+        std::vector<std::vector<uint8_t>> m_Spare;
+        std::mutex m_Lock;
+        std::condition_variable m_CV;
+        bool m_Stopped {false};
+        std::atomic<uint64_t> m_Dropped {0};
+};
+
+/**
+ * @brief Decodes live view JPEGs with libjpeg, straight into a buffer kept from one frame to the next.
+ * The decoder downscales in the DCT domain (1/2, 1/4 or 1/8) when the stream does not need the full size, and
+ * decodes to grayscale for focusing, skipping the chroma planes altogether.
+ */
+class LiveViewDecoder
+{
+    public:
+        struct Options
+        {
+            // Decode to at least this width, 0 for the full size
+            uint32_t maxWidth {0};
+            // Luminance only
+            bool mono {false};
+        };
+
+        LiveViewDecoder();
+        ~LiveViewDecoder();
+        LiveViewDecoder(const LiveViewDecoder &) = delete;
+        LiveViewDecoder &operator=(const LiveViewDecoder &) = delete;
+
+        /** @return false if the JPEG is corrupted, the decoder can be used again */
+        bool decode(const uint8_t *jpeg, size_t size, const Options &options);
+
+        const uint8_t *image() const
+        {
+            return m_Image.data();
+        }
+        size_t imageSize() const
+        {
+            return static_cast<size_t>(m_Width) * m_Height * m_Components;
+        }
+        uint32_t width() const
+        {
+            return m_Width;
+        }
+        uint32_t height() const
+        {
+            return m_Height;
+        }
+        // 1 for grayscale, 3 for RGB
+        int components() const
+        {
+            return m_Components;
+        }
+
+        /** @brief Largest DCT scaling denominator that still gives at least maxWidth columns */
+        static unsigned int scaleDenominator(uint32_t imageWidth, uint32_t maxWidth);
+
+    private:
+        struct Context;
+        Context *m_Context;
+        std::vector<uint8_t> m_Image;
+        uint32_t m_Width {0};
+        uint32_t m_Height {0};
+        int m_Components {0};
+};
+
+/**
+ * @brief Live view capture and decode on two threads with a small queue in between, so that a slow decode never
+ * holds back the camera and the stream is fed from the latest preview.
+ */
+class LiveViewPipeline
+{
+    public:
+        // Called on the decode thread for every decoded frame
+        using FrameHandler = std::function<void(const LiveViewDecoder &decoder)>;
+        // Called on the decode thread to read the current decoding options
+        using OptionsProvider = std::function<LiveViewDecoder::Options()>;
+
+        LiveViewPipeline(LiveViewSource &source, FrameHandler onFrame, OptionsProvider options);
+        ~LiveViewPipeline();
+
+        void start();
+        void stop();
+
+        uint64_t captured() const
+        {
+            return m_Captured;
+        }
+        uint64_t decoded() const
+        {
+            return m_Decoded;
+        }
+        uint64_t dropped() const
+        {
+            return m_Queue.dropped();
+        }
+        uint64_t failed() const
+        {
+            return m_Failed;
+        }
+
+    private:
+        void captureLoop();
+        void decodeLoop();
+
+        LiveViewSource &m_Source;
+        FrameHandler m_OnFrame;
+        OptionsProvider m_Options;
+        LiveViewQueue m_Queue;
+        LiveViewDecoder m_Decoder;
+
+        std::thread m_CaptureThread, m_DecodeThread;
+        std::atomic_bool m_Running {false};
+        std::atomic<uint64_t> m_Captured {0}, m_Decoded {0}, m_Failed {0};
+};
@@ -0,0 +1,331 @@
+/*
+    GPhoto live view pipeline tests, against a recorded MJPEG preview sequence
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this library; if not, write to the Free Software Foundation,
+    Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <jpeglib.h>
+
+#include "gphoto_liveview.h"
+
+// Canon EOS live view preview size
+static constexpr int PREVIEW_WIDTH  = 1056;
+static constexpr int PREVIEW_HEIGHT = 704;
+
+/* A preview frame: smooth gradients, a star field and the frame number, so that frames differ */
+static std::vector<uint8_t> makePreview(int width, int height, int index)
+{
+    std::vector<uint8_t> rgb(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+        {
+            uint8_t *pixel = &rgb[(static_cast<size_t>(y) * width + x) * 3];
+            pixel[0] = (x + index * 4) & 0xff;
+            pixel[1] = (y * 255) / height;
+            pixel[2] = ((x * 7 + y * 3) % 61 == 0) ? 250 : 40;
+        }
+
+    std::vector<uint8_t> jpeg;
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    unsigned char *out = nullptr;
+    unsigned long outSize = 0;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+    jpeg_mem_dest(&cinfo, &out, &outSize);
+    cinfo.image_width      = width;
+    cinfo.image_height     = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space   = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 85, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        JSAMPROW row = &rgb[static_cast<size_t>(cinfo.next_scanline) * width * 3];
+        jpeg_write_scanlines(&cinfo, &row, 1);
+    }
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    jpeg.assign(out, out + outSize);
+    free(out);
+    return jpeg;
+}
+
+static std::vector<uint8_t> makeRecording(int frames)
+{
+    std::vector<uint8_t> mjpeg;
+    for (int i = 0; i < frames; i++)
+    {
+        auto frame = makePreview(PREVIEW_WIDTH, PREVIEW_HEIGHT, i);
+        mjpeg.insert(mjpeg.end(), frame.begin(), frame.end());
+    }
+    return mjpeg;
+}
+
+/* The decode of the previous live view path: default libjpeg settings, row by row through a bounce buffer */
+static bool referenceDecode(const std::vector<uint8_t> &jpeg, uint8_t **memptr, size_t *memsize, int *w, int *h)
+{
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, const_cast<unsigned char *>(jpeg.data()), jpeg.size());
+    jpeg_read_header(&cinfo, TRUE);
+    jpeg_start_decompress(&cinfo);
+
+    *memsize = cinfo.output_width * cinfo.output_height * cinfo.num_components;
+    *memptr  = static_cast<uint8_t *>(realloc(*memptr, *memsize));
+    *w       = cinfo.output_width;
+    *h       = cinfo.output_height;
+
+    uint8_t *destmem = *memptr;
+    JSAMPROW row_pointer[1] = { static_cast<unsigned char *>(malloc(cinfo.output_width * cinfo.num_components)) };
+    for (unsigned int row = 0; row < cinfo.image_height; row++)
+    {
+        jpeg_read_scanlines(&cinfo, row_pointer, 1);
+        memcpy(destmem, row_pointer[0], cinfo.output_width * cinfo.num_components);
+        destmem += cinfo.output_width * cinfo.num_components;
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    free(row_pointer[0]);
+    return true;
+}
+
+TEST(LiveViewFrame, WellBehavedPreviewIsTheFrame)
+{
+    auto jpeg = makePreview(64, 48, 0);
+    const uint8_t *frame = nullptr;
+    size_t size = 0;
+
+    ASSERT_TRUE(liveview_find_frame(jpeg.data(), jpeg.size(), &frame, &size));
+    EXPECT_EQ(frame, jpeg.data());
+    EXPECT_EQ(size, jpeg.size());
+}
+
+TEST(LiveViewFrame, GarbageAndThumbnailAreSkipped)
+{
+    auto thumbnail = makePreview(16, 16, 1);
+    auto jpeg      = makePreview(64, 48, 2);
+    std::vector<uint8_t> preview = { 0x00, 0x12, 0xFF, 0x00 };
+    preview.insert(preview.end(), thumbnail.begin(), thumbnail.end());
+    preview.insert(preview.end(), jpeg.begin(), jpeg.end());
+
+    const uint8_t *frame = nullptr;
+    size_t size = 0;
+    ASSERT_TRUE(liveview_find_frame(preview.data(), preview.size(), &frame, &size));
+    EXPECT_EQ(size, jpeg.size());
+    EXPECT_EQ(memcmp(frame, jpeg.data(), size), 0);
+
+    std::vector<uint8_t> noise(1000, 0xFF);
+    EXPECT_FALSE(liveview_find_frame(noise.data(), noise.size(), &frame, &size));
+}
+
+TEST(LiveViewDecoder, ScaleMatchesStreamSize)
+{
+    EXPECT_EQ(LiveViewDecoder::scaleDenominator(1056, 0), 1u);
+    EXPECT_EQ(LiveViewDecoder::scaleDenominator(1056, 1056), 1u);
+    EXPECT_EQ(LiveViewDecoder::scaleDenominator(1056, 640), 1u);
+    EXPECT_EQ(LiveViewDecoder::scaleDenominator(1056, 528), 2u);
+    EXPECT_EQ(LiveViewDecoder::scaleDenominator(1056, 200), 4u);
+    EXPECT_EQ(LiveViewDecoder::scaleDenominator(1056, 1), 8u);
+
+    auto jpeg = makePreview(PREVIEW_WIDTH, PREVIEW_HEIGHT, 0);
+    LiveViewDecoder decoder;
+    LiveViewDecoder::Options options;
+    options.maxWidth = 264;
+    ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), options));
+    EXPECT_EQ(decoder.width(), 264u);
+    EXPECT_EQ(decoder.height(), 176u);
+    EXPECT_EQ(decoder.components(), 3);
+}
+
+TEST(LiveViewDecoder, CloseToReferenceDecode)
+{
+    auto jpeg = makePreview(PREVIEW_WIDTH, PREVIEW_HEIGHT, 3);
+    uint8_t *reference = nullptr;
+    size_t size = 0;
+    int w = 0, h = 0;
+    ASSERT_TRUE(referenceDecode(jpeg, &reference, &size, &w, &h));
+
+    LiveViewDecoder decoder;
+    ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), LiveViewDecoder::Options()));
+    ASSERT_EQ(decoder.width(), static_cast<uint32_t>(w));
+    ASSERT_EQ(decoder.height(), static_cast<uint32_t>(h));
+    ASSERT_EQ(decoder.imageSize(), size);
+
+    // Fast IDCT and plain upsampling are not bit exact, but visually the same
+    double error = 0;
+    for (size_t i = 0; i < size; i++)
+        error += std::abs(decoder.image()[i] - reference[i]);
+    EXPECT_LT(error / size, 2.0);
+    free(reference);
+}
+
+TEST(LiveViewDecoder, MonoAndBufferReuse)
+{
+    auto jpeg = makePreview(PREVIEW_WIDTH, PREVIEW_HEIGHT, 4);
+    LiveViewDecoder decoder;
+
+    ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), LiveViewDecoder::Options()));
+    const uint8_t *image = decoder.image();
+
+    LiveViewDecoder::Options options;
+    options.mono     = true;
+    options.maxWidth = 528;
+    ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), options));
+    EXPECT_EQ(decoder.components(), 1);
+    EXPECT_EQ(decoder.imageSize(), 528u * 352u);
+    EXPECT_EQ(decoder.image(), image);
+}
+
+TEST(LiveViewDecoder, CorruptedFrameIsDropped)
+{
+    auto jpeg = makePreview(PREVIEW_WIDTH, PREVIEW_HEIGHT, 5);
+    LiveViewDecoder decoder;
+
+    std::vector<uint8_t> header(jpeg.begin(), jpeg.begin() + 20);
+    EXPECT_FALSE(decoder.decode(header.data(), header.size(), LiveViewDecoder::Options()));
+
+    // and the decoder carries on with the next one
+    ASSERT_TRUE(decoder.decode(jpeg.data(), jpeg.size(), LiveViewDecoder::Options()));
+    EXPECT_EQ(decoder.width(), static_cast<uint32_t>(PREVIEW_WIDTH));
+}
+
+TEST(LiveViewQueue, DropsStaleFrames)
+{
+    LiveViewQueue queue(2);
+    std::vector<uint8_t> frame;
+
+    for (uint8_t i = 1; i <= 4; i++)
+    {
+        frame.assign(100, i);
+        queue.push(frame);
+        EXPECT_TRUE(frame.empty());
+    }
+    EXPECT_EQ(queue.dropped(), 2u);
+
+    std::vector<uint8_t> latest;
+    ASSERT_TRUE(queue.pop(latest));
+    EXPECT_EQ(latest[0], 4);
+    EXPECT_EQ(queue.dropped(), 3u);
+
+    // Storage circulates: the producer gets the dropped buffers back
+    queue.push(frame);
+    EXPECT_GE(frame.capacity(), 100u);
+
+    queue.stop();
+    EXPECT_FALSE(queue.pop(latest));
+}
+
+TEST(LiveViewRecording, SplitsFrames)
+{
+    auto mjpeg = makeRecording(5);
+    LiveViewRecording recording(mjpeg);
+    ASSERT_EQ(recording.frameCount(), 5u);
+
+    std::vector<uint8_t> frame;
+    LiveViewDecoder decoder;
+    for (int i = 0; i < 6; i++)
+    {
+        ASSERT_TRUE(recording.capture(frame));
+        ASSERT_TRUE(decoder.decode(frame.data(), frame.size(), LiveViewDecoder::Options()));
+    }
+}
+
+TEST(LiveViewPipeline, FeedsLatestFrames)
+{
+    LiveViewRecording recording(makeRecording(8));
+    recording.setFrameInterval(std::chrono::milliseconds(2));
+
+    std::atomic<uint32_t> width {0};
+    LiveViewPipeline pipeline(recording, [&](const LiveViewDecoder & decoder)
+    {
+        width = decoder.width();
+    }, []()
+    {
+        LiveViewDecoder::Options options;
+        options.maxWidth = 528;
+        return options;
+    });
+
+    pipeline.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pipeline.stop();
+
+    EXPECT_GT(pipeline.decoded(), 0u);
+    EXPECT_EQ(pipeline.failed(), 0u);
+    // Whatever was captured was decoded, dropped as stale or still queued when stopped
+    EXPECT_GE(pipeline.captured(), pipeline.decoded() + pipeline.dropped());
+    EXPECT_EQ(width, 528u);
+}
+
+TEST(LiveViewBenchmark, FramesPerSecond)
+{
+    const int frames = 60;
+    auto mjpeg = makeRecording(10);
+
+    auto run = [&](const char *label, const std::function<void(const std::vector<uint8_t> &)> &decode)
+    {
+        LiveViewRecording recording(mjpeg);
+        std::vector<uint8_t> frame;
+        std::clock_t cpu = std::clock();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; i++)
+        {
+            recording.capture(frame);
+            decode(frame);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double cpuMs   = 1000.0 * (std::clock() - cpu) / CLOCKS_PER_SEC / frames;
+        printf("%-24s %6.0f frames/s, %5.2f ms CPU per frame\n", label, frames / seconds, cpuMs);
+    };
+
+    uint8_t *buffer = nullptr;
+    run("previous, full RGB", [&](const std::vector<uint8_t> &frame)
+    {
+        size_t size;
+        int w, h;
+        referenceDecode(frame, &buffer, &size, &w, &h);
+    });
+    free(buffer);
+
+    LiveViewDecoder decoder;
+    LiveViewDecoder::Options options;
+    auto decode = [&](const std::vector<uint8_t> &frame)
+    {
+        ASSERT_TRUE(decoder.decode(frame.data(), frame.size(), options));
+    };
+    run("pipeline, full RGB", decode);
+    options.maxWidth = PREVIEW_WIDTH / 2;
+    run("pipeline, 1/2 RGB", decode);
+    options.maxWidth = PREVIEW_WIDTH / 4;
+    run("pipeline, 1/4 RGB", decode);
+    options.maxWidth = 0;
+    options.mono     = true;
+    run("pipeline, full mono", decode);
+}
@@ -41,6 +41,8 @@
 
 #define MAX_NMEA_PARSES     50              // Read 50 streams before giving up
 #define MAX_TIMEOUT_COUNT   5               // Maximum timeout before auto-connect
+#define READ_TIMEOUT_MS     3000            // Wait for data before counting a timeout
+#define NMEA_BUFFER_SIZE    1024            // Stream buffer, holds several sentences
 
 // We declare an auto pointer to GPSD.
 static std::unique_ptr<GPSNMEA> gpsnema(new GPSNMEA());
@@ -103,18 +105,57 @@ bool GPSNMEA::updateProperties()
 
 IPState GPSNMEA::updateGPS()
 {
-    IPState rc = IPS_BUSY;
+    GNSSFix fix;
+    if (!fixSlot.consume(fix))
+        return IPS_BUSY;
 
-    pthread_mutex_lock(&lock);
-    if (locationPending == false && timePending == false)
+    if (fix.fixType != lastFixType)
     {
-        rc = IPS_OK;
-        locationPending = true;
-        timePending = true;
+        lastFixType = fix.fixType;
+        if (fix.fixType == 1)
+        {
+            GPSstatusTP.s = IPS_BUSY;
+            IUSaveText(&GPSstatusT[0], "NO FIX");
+        }
+        else if (fix.fixType == 2)
+        {
+            GPSstatusTP.s = IPS_OK;
+            IUSaveText(&GPSstatusT[0], "2D FIX");
+        }
+        else if (fix.fixType == 3)
+        {
+            GPSstatusTP.s = IPS_OK;
+            IUSaveText(&GPSstatusT[0], "3D FIX");
+        }
+        IDSetText(&GPSstatusTP, nullptr);
     }
-    pthread_mutex_unlock(&lock);
 
-    return rc;
+    if (fix.hasLocation == false || fix.hasTime == false)
+        return IPS_BUSY;
+
+    LocationNP[LOCATION_LATITUDE].value  = fix.latitude;
+    LocationNP[LOCATION_LONGITUDE].value = fix.longitude;
+    if (fix.hasElevation)
+        LocationNP[LOCATION_ELEVATION].value = fix.elevation;
+
+    char ts[32] = {0};
+    struct tm utc, local;
+    time_t raw_time = fix.time;
+
+    m_GPSTime = raw_time;
+    gmtime_r(&raw_time, &utc);
+    strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &utc);
+    TimeTP[0].setText(ts);
+
+    setSystemTime(raw_time);
+
+    localtime_r(&raw_time, &local);
+    snprintf(ts, sizeof(ts), "%4.2f", (local.tm_gmtoff / 3600.0));
+    TimeTP[1].setText(ts);
+
+    LOG_DEBUG("Location and Time updates complete.");
+
+    return IPS_OK;
 }
 
 bool GPSNMEA::isNMEA()
@@ -141,235 +182,67 @@ void* GPSNMEA::parseNMEAHelper(void *obj)
 
 void GPSNMEA::parseNEMA()
 {
-    static char ts[32] = {0};
-
-    char line[MINMEA_MAX_LENGTH];
+    // Sentences are framed and parsed in place, nothing is allocated per sentence
+    GNSSStream::LineBuffer<NMEA_BUFFER_SIZE> buffer(0xA);
+    NMEAParser parser;
 
     while (isConnected())
     {
-        int bytes_read = 0;
-        int tty_rc = tty_nread_section(PortFD, line, MINMEA_MAX_LENGTH, 0xA, 3, &bytes_read);
-        if (tty_rc < 0)
+        ssize_t rc = buffer.fill(PortFD, READ_TIMEOUT_MS);
+        if (rc == GNSSStream::READ_CLOSED)
+        {
+            LOG_WARN("Connection closed. Possible remote GPS disconnection. Disconnecting driver...");
+            INDI::GPS::setConnected(false);
+            updateProperties();
+            break;
+        }
+        else if (rc == GNSSStream::READ_TIMEOUT || rc == GNSSStream::READ_ERROR)
         {
-            if (tty_rc == TTY_OVERFLOW)
+            if (rc == GNSSStream::READ_ERROR && errno == ECONNREFUSED)
             {
-                LOG_WARN("Overflow detected. Possible remote GPS disconnection. Disconnecting driver...");
-                INDI::GPS::setConnected(false);
-                updateProperties();
-                break;
+                // sleep for 10 seconds
+                tcpConnection->Disconnect();
+                usleep(10 * 1e6);
+                tcpConnection->Connect();
+                PortFD = tcpConnection->getPortFD();
+                buffer.clear();
             }
-            else
+            else if (timeoutCounter++ > MAX_TIMEOUT_COUNT)
             {
-                char errmsg[MAXRBUF];
-                tty_error_msg(tty_rc, errmsg, MAXRBUF);
-                if (tty_rc == TTY_TIME_OUT || errno == ECONNREFUSED)
-                {
-                    if (errno == ECONNREFUSED)
-                    {
-                        // sleep for 10 seconds
-                        tcpConnection->Disconnect();
-                        usleep(10 * 1e6);
-                        tcpConnection->Connect();
-                        PortFD = tcpConnection->getPortFD();
-                    }
-                    else if (timeoutCounter++ > MAX_TIMEOUT_COUNT)
-                    {
-                        LOG_WARN("Timeout limit reached, reconnecting...");
-
-                        tcpConnection->Disconnect();
-                        // sleep for 5 seconds
-                        usleep(5 * 1e6);
-                        tcpConnection->Connect();
-                        PortFD = tcpConnection->getPortFD();
-                        timeoutCounter = 0;
-                    }
-                }
-                continue;
+                LOG_WARN("Timeout limit reached, reconnecting...");
+
+                tcpConnection->Disconnect();
+                // sleep for 5 seconds
+                usleep(5 * 1e6);
+                tcpConnection->Connect();
+                PortFD = tcpConnection->getPortFD();
+                buffer.clear();
+                timeoutCounter = 0;
             }
+            continue;
         }
-        line[bytes_read] = '\0';
 
-        LOGF_DEBUG("%s", line);
-        switch (minmea_sentence_id(line, false))
+        timeoutCounter = 0;
+
+        size_t length = 0;
+        char *line = nullptr;
+        while ((line = buffer.next(&length)) != nullptr)
         {
-            case MINMEA_SENTENCE_RMC:
-            {
-                struct minmea_sentence_rmc frame;
-                if (minmea_parse_rmc(&frame, line))
-                {
-                    if (frame.valid)
-                    {
-                        LocationNP[LOCATION_LATITUDE].value  = minmea_tocoord(&frame.latitude);
-                        LocationNP[LOCATION_LONGITUDE].value = minmea_tocoord(&frame.longitude);
-                        if (LocationNP[LOCATION_LONGITUDE].value < 0)
-                            LocationNP[LOCATION_LONGITUDE].value += 360;
-
-                        struct timespec timesp;
-                        time_t raw_time;
-                        struct tm *utc, *local;
-
-                        if (minmea_gettime(&timesp, &frame.date, &frame.time) == -1)
-                            break;
-
-                        raw_time = timesp.tv_sec;
-                        m_GPSTime = raw_time;
-                        utc = gmtime(&raw_time);
-                        strftime(ts, 32, "%Y-%m-%dT%H:%M:%S", utc);
-                        TimeTP[0].setText(ts);
-
-                        setSystemTime(raw_time);
-
-                        local = localtime(&raw_time);
-                        snprintf(ts, 32, "%4.2f", (local->tm_gmtoff / 3600.0));
-                        TimeTP[1].setText(ts);
-
-                        pthread_mutex_lock(&lock);
-                        locationPending = false;
-                        timePending = false;
-                        LOG_DEBUG("Threaded Location and Time updates complete.");
-                        pthread_mutex_unlock(&lock);
-                    }
-                }
-                else
-                {
-                    LOG_DEBUG("$xxRMC sentence is not parsed");
-                }
-            }
-            break;
+            LOGF_DEBUG("%s", line);
 
-            case MINMEA_SENTENCE_GGA:
+            switch (parser.parse(line, length))
             {
-                struct minmea_sentence_gga frame;
-                if (minmea_parse_gga(&frame, line))
-                {
-                    if (frame.fix_quality == 1)
-                    {
-                        LocationNP[LOCATION_LATITUDE].value  = minmea_tocoord(&frame.latitude);
-                        LocationNP[LOCATION_LONGITUDE].value = minmea_tocoord(&frame.longitude);
-                        if (LocationNP[LOCATION_LONGITUDE].value < 0)
-                            LocationNP[LOCATION_LONGITUDE].value += 360;
-
-                        LocationNP[LOCATION_ELEVATION].value = minmea_tofloat(&frame.altitude);
-
-                        struct timespec timesp;
-                        time_t raw_time;
-                        struct tm *utc, *local;
-                        minmea_date gmt_date;
-
-                        time(&raw_time);
-                        utc = gmtime(&raw_time);
-                        gmt_date.day = utc->tm_mday;
-                        gmt_date.month = utc->tm_mon + 1;
-                        gmt_date.year = utc->tm_year;
-
-                        minmea_gettime(&timesp, &gmt_date, &frame.time);
-
-                        raw_time = timesp.tv_sec;
-                        utc = gmtime(&raw_time);
-                        strftime(ts, 32, "%Y-%m-%dT%H:%M:%S", utc);
-                        TimeTP[0].setText(ts);
-                        setSystemTime(raw_time);
-
-                        local = localtime(&raw_time);
-                        snprintf(ts, 32, "%4.2f", (local->tm_gmtoff / 3600.0));
-                        TimeTP[1].setText(ts);
-
-                        pthread_mutex_lock(&lock);
-                        timePending = false;
-                        locationPending = false;
-                        LOG_DEBUG("Threaded Location and Time updates complete.");
-                        pthread_mutex_unlock(&lock);
-                    }
-                }
-                else
-                {
-                    LOG_DEBUG("$xxGGA sentence is not parsed");
-                }
-            }
-            break;
+                case NMEAParser::SENTENCE_UPDATED:
+                    fixSlot.publish(parser.getFix());
+                    break;
 
-            case MINMEA_SENTENCE_GSA:
-            {
-                struct minmea_sentence_gsa frame;
-                if (minmea_parse_gsa(&frame, line))
-                {
-                    if (frame.fix_type == 1)
-                    {
-                        GPSstatusTP.s = IPS_BUSY;
-                        IUSaveText(&GPSstatusT[0], "NO FIX");
-                    }
-                    else if (frame.fix_type == 2)
-                    {
-                        GPSstatusTP.s = IPS_OK;
-                        IUSaveText(&GPSstatusT[0], "2D FIX");
-                    }
-                    else if (frame.fix_type == 3)
-                    {
-                        GPSstatusTP.s = IPS_OK;
-                        IUSaveText(&GPSstatusT[0], "3D FIX");
-                    }
-                    IDSetText(&GPSstatusTP, nullptr);
-
-                }
-                else
-                {
-                    LOG_DEBUG("$xxGSA sentence is not parsed.");
-                }
-            }
-            break;
-            case MINMEA_SENTENCE_ZDA:
-            {
-                struct minmea_sentence_zda frame;
-                if (minmea_parse_zda(&frame, line))
-                {
-                    LOGF_DEBUG("$xxZDA: %d:%d:%d %02d.%02d.%d UTC%+03d:%02d",
-                               frame.time.hours,
-                               frame.time.minutes,
-                               frame.time.seconds,
-                               frame.date.day,
-                               frame.date.month,
-                               frame.date.year,
-                               frame.hour_offset,
-                               frame.minute_offset);
-
-                    struct timespec timesp;
-                    time_t raw_time;
-                    struct tm *utc, *local;
-
-                    minmea_gettime(&timesp, &frame.date, &frame.time);
-
-                    raw_time = timesp.tv_sec;
-                    utc = gmtime(&raw_time);
-                    strftime(ts, 32, "%Y-%m-%dT%H:%M:%S", utc);
-                    TimeTP[0].setText(ts);
-                    setSystemTime(raw_time);
-
-                    local = localtime(&raw_time);
-                    snprintf(ts, 32, "%4.2f", (local->tm_gmtoff / 3600.0));
-                    TimeTP[1].setText(ts);
-
-                    pthread_mutex_lock(&lock);
-                    timePending = false;
-                    LOG_DEBUG("Threaded Time update complete.");
-                    pthread_mutex_unlock(&lock);
-                }
-                else
-                {
-                    LOG_DEBUG("$xxZDA sentence is not parsed");
-                }
-            }
-            break;
+                case NMEAParser::SENTENCE_INVALID:
+                    LOG_DEBUG("$xxxxx sentence is not parsed");
+                    break;
 
-            case MINMEA_INVALID:
-            {
-                //LOG_WARN("$xxxxx sentence is not valid");
-            } break;
-
-            default:
-            {
-                LOG_DEBUG("$xxxxx sentence is not parsed");
+                case NMEAParser::SENTENCE_IGNORED:
+                    break;
             }
-            break;
         }
     }
 
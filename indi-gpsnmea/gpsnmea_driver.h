@@ -24,6 +24,9 @@
 
 #pragma once
 
+#include "gnss_stream.h"
+#include "nmea_parser.h"
+
 #include <indigps.h>
 
 class GPSNMEA : public INDI::GPS
@@ -51,8 +54,10 @@ private:
 
     int PortFD { -1 };
     uint8_t timeoutCounter=0;
-    bool locationPending = true, timePending=true;
+    int lastFixType { 0 };
+
+    // Latest fix, published by the reader thread and consumed in updateGPS()
+    GNSSStream::LatestSlot<GNSSFix> fixSlot;
 
-    pthread_mutex_t lock;
     pthread_t nmeaThread;
 };
@@ -0,0 +1,153 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+
+  INDI GPS NMEA Driver - Sentence parser
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include "nmea_parser.h"
+#include "gnss_stream.h"
+#include "minmea.h"
+
+#include <cmath>
+
+namespace
+{
+// Sentence type, the three characters after the talker id, packed for a single comparison
+constexpr uint32_t sentenceType(char a, char b, char c)
+{
+    return (static_cast<uint32_t>(a) << 16) | (static_cast<uint32_t>(b) << 8) | static_cast<uint32_t>(c);
+}
+
+constexpr uint32_t TYPE_RMC = sentenceType('R', 'M', 'C');
+constexpr uint32_t TYPE_GGA = sentenceType('G', 'G', 'A');
+constexpr uint32_t TYPE_GSA = sentenceType('G', 'S', 'A');
+constexpr uint32_t TYPE_ZDA = sentenceType('Z', 'D', 'A');
+
+bool setLocation(GNSSFix &fix, minmea_float *latitude, minmea_float *longitude)
+{
+    double lat = minmea_tocoord(latitude);
+    double lon = minmea_tocoord(longitude);
+    if (std::isnan(lat) || std::isnan(lon))
+        return false;
+
+    fix.latitude = lat;
+    fix.longitude = lon < 0 ? lon + 360 : lon;
+    fix.hasLocation = true;
+    return true;
+}
+
+bool setTime(GNSSFix &fix, const minmea_date *date, const minmea_time *time)
+{
+    struct timespec timesp;
+    if (minmea_gettime(&timesp, date, time) == -1)
+        return false;
+
+    fix.time = timesp.tv_sec;
+    fix.hasTime = true;
+    return true;
+}
+}
+
+NMEAParser::Result NMEAParser::parse(const char *sentence, size_t length)
+{
+    // Same length limit as minmea_check, which is bypassed since the checksum is verified here
+    if (length > MINMEA_MAX_LENGTH + 3 || !GNSSStream::nmeaChecksumValid(sentence, length))
+        return SENTENCE_INVALID;
+
+    // $ttsss, where tt is the talker and sss the sentence type
+    if (length < 7 || sentence[6] != ',')
+        return SENTENCE_IGNORED;
+
+    switch (sentenceType(sentence[3], sentence[4], sentence[5]))
+    {
+        case TYPE_RMC:
+        {
+            minmea_sentence_rmc frame;
+            if (!minmea_parse_rmc(&frame, sentence))
+                return SENTENCE_INVALID;
+            if (!frame.valid)
+                return SENTENCE_IGNORED;
+
+            if (!setLocation(m_Fix, &frame.latitude, &frame.longitude))
+                return SENTENCE_IGNORED;
+            setTime(m_Fix, &frame.date, &frame.time);
+        }
+        break;
+
+        case TYPE_GGA:
+        {
+            minmea_sentence_gga frame;
+            if (!minmea_parse_gga(&frame, sentence))
+                return SENTENCE_INVALID;
+            if (frame.fix_quality != 1)
+                return SENTENCE_IGNORED;
+
+            if (!setLocation(m_Fix, &frame.latitude, &frame.longitude))
+                return SENTENCE_IGNORED;
+
+            double elevation = minmea_tofloat(&frame.altitude);
+            if (!std::isnan(elevation))
+            {
+                m_Fix.elevation = elevation;
+                m_Fix.hasElevation = true;
+            }
+
+            // GGA only carries the time of day
+            time_t now = time(nullptr);
+            struct tm utc;
+            gmtime_r(&now, &utc);
+            minmea_date date;
+            date.day = utc.tm_mday;
+            date.month = utc.tm_mon + 1;
+            date.year = utc.tm_year;
+            setTime(m_Fix, &date, &frame.time);
+        }
+        break;
+
+        case TYPE_GSA:
+        {
+            minmea_sentence_gsa frame;
+            if (!minmea_parse_gsa(&frame, sentence))
+                return SENTENCE_INVALID;
+            if (frame.fix_type < 1 || frame.fix_type > 3 || frame.fix_type == m_Fix.fixType)
+                return SENTENCE_IGNORED;
+
+            m_Fix.fixType = frame.fix_type;
+        }
+        break;
+
+        case TYPE_ZDA:
+        {
+            minmea_sentence_zda frame;
+            if (!minmea_parse_zda(&frame, sentence))
+                return SENTENCE_INVALID;
+            if (!setTime(m_Fix, &frame.date, &frame.time))
+                return SENTENCE_IGNORED;
+        }
+        break;
+
+        default:
+            return SENTENCE_IGNORED;
+    }
+
+    m_Fix.sentences++;
+    return SENTENCE_UPDATED;
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+
+  INDI GPS NMEA Driver - Sentence parser
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+
+/** Latest position and time gathered from the NMEA stream. Plain data, copied through the fix slot. */
+struct GNSSFix
+{
+    double latitude { 0 };      // degrees, north positive
+    double longitude { 0 };     // degrees east, 0 to 360
+    double elevation { 0 };     // meters above mean sea level
+    time_t time { 0 };          // UTC
+    int fixType { 0 };          // GSA fix type: 0 unknown, 1 no fix, 2 2D, 3 3D
+    bool hasLocation { false };
+    bool hasElevation { false };
+    bool hasTime { false };
+    uint32_t sentences { 0 };   // number of sentences that updated the fix
+};
+
+/**
+ * @brief Incremental NMEA 0183 parser. Sentences are validated with a table driven checksum,
+ * dispatched on their type without copying and decoded in place with minmea.
+ * RMC and GGA update the location and time, ZDA the time and GSA the fix type.
+ */
+class NMEAParser
+{
+    public:
+        enum Result
+        {
+            SENTENCE_INVALID,   // malformed sentence or checksum mismatch
+            SENTENCE_IGNORED,   // valid, but not used or not carrying a fix
+            SENTENCE_UPDATED    // the fix was updated
+        };
+
+        /**
+         * @brief Parses one sentence.
+         * @param sentence NUL terminated sentence, without line terminator
+         * @param length length of the sentence
+         */
+        Result parse(const char *sentence, size_t length);
+
+        const GNSSFix &getFix() const
+        {
+            return m_Fix;
+        }
+
+        void reset()
+        {
+            m_Fix = GNSSFix();
+        }
+
+    private:
+        GNSSFix m_Fix;
+};
@@ -0,0 +1,279 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+
+  INDI GPS NMEA Driver - Stream parser tests and replay benchmark
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "gnss_stream.h"
+#include "nmea_parser.h"
+#include "minmea.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::string withChecksum(const std::string &body)
+{
+    char checksum[8];
+    snprintf(checksum, sizeof(checksum), "*%02X", minmea_checksum(body.c_str()));
+    return body + checksum;
+}
+
+static NMEAParser::Result parse(NMEAParser &parser, std::string sentence)
+{
+    return parser.parse(&sentence[0], sentence.size());
+}
+
+TEST(NMEAChecksum, MatchesMinmea)
+{
+    const char *sentences[] =
+    {
+        "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62",
+        "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47",
+        "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*48",
+        "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*4",
+        "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*4G",
+        "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39",
+        "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1",
+        "GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39",
+    };
+
+    for (const char *sentence : sentences)
+    {
+        EXPECT_EQ(GNSSStream::nmeaChecksumValid(sentence, strlen(sentence)), minmea_check(sentence, false)) << sentence;
+        EXPECT_EQ(GNSSStream::nmeaChecksumValid(sentence, strlen(sentence), true), minmea_check(sentence, true)) << sentence;
+    }
+}
+
+TEST(NMEAParser, Sentences)
+{
+    NMEAParser parser;
+
+    EXPECT_EQ(parse(parser, "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39"), NMEAParser::SENTENCE_UPDATED);
+    EXPECT_EQ(parser.getFix().fixType, 3);
+    EXPECT_FALSE(parser.getFix().hasLocation);
+
+    // Same fix type again, nothing new
+    EXPECT_EQ(parse(parser, "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39"), NMEAParser::SENTENCE_IGNORED);
+
+    EXPECT_EQ(parse(parser, "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*62"),
+              NMEAParser::SENTENCE_UPDATED);
+    const GNSSFix &fix = parser.getFix();
+    EXPECT_TRUE(fix.hasLocation);
+    EXPECT_TRUE(fix.hasTime);
+    EXPECT_NEAR(fix.latitude, -(37 + 51.65 / 60), 1e-4);
+    EXPECT_NEAR(fix.longitude, 145 + 7.36 / 60, 1e-4);
+    EXPECT_EQ(fix.time, 905674716);
+
+    // Western longitudes are reported from 0 to 360
+    EXPECT_EQ(parse(parser, withChecksum("$GNGGA,123519,4807.038,N,01131.000,W,1,08,0.9,545.4,M,46.9,M,,")),
+              NMEAParser::SENTENCE_UPDATED);
+    EXPECT_NEAR(fix.latitude, 48 + 7.038 / 60, 1e-4);
+    EXPECT_NEAR(fix.longitude, 360 - (11 + 31.0 / 60), 1e-4);
+    EXPECT_TRUE(fix.hasElevation);
+    EXPECT_NEAR(fix.elevation, 545.4, 1e-3);
+    EXPECT_EQ(fix.time % 86400, 12 * 3600 + 35 * 60 + 19);
+
+    EXPECT_EQ(parse(parser, withChecksum("$GPZDA,160012.71,11,03,2004,-1,00")), NMEAParser::SENTENCE_UPDATED);
+    EXPECT_EQ(fix.time, 1079020812);
+
+    // Void RMC, GGA without fix, unused sentence, corrupted and truncated ones
+    uint32_t sentences = fix.sentences;
+    EXPECT_EQ(parse(parser, withChecksum("$GPRMC,081836,V,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E")),
+              NMEAParser::SENTENCE_IGNORED);
+    EXPECT_EQ(parse(parser, withChecksum("$GPGGA,123519,4807.038,N,01131.000,E,0,08,0.9,545.4,M,46.9,M,,")),
+              NMEAParser::SENTENCE_IGNORED);
+    EXPECT_EQ(parse(parser, "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48"), NMEAParser::SENTENCE_IGNORED);
+    EXPECT_EQ(parse(parser, "$GPRMC,081836,A,3751.65,S,14507.36,E,000.0,360.0,130998,011.3,E*63"),
+              NMEAParser::SENTENCE_INVALID);
+    EXPECT_EQ(parse(parser, "$GPRMC,081836,A,3751.65"), NMEAParser::SENTENCE_INVALID);
+    EXPECT_EQ(fix.sentences, sentences);
+}
+
+TEST(LineBuffer, FramesSplitAndOversizedLines)
+{
+    GNSSStream::LineBuffer<32> buffer('\n');
+    size_t length = 0;
+
+    buffer.append("first\r\nsec", 10);
+    EXPECT_STREQ(buffer.next(&length), "first");
+    EXPECT_EQ(length, 5u);
+    EXPECT_EQ(buffer.next(), nullptr);
+
+    buffer.append("ond\n\nthird", 10);
+    EXPECT_STREQ(buffer.next(&length), "second");
+    EXPECT_STREQ(buffer.next(&length), "");
+    EXPECT_EQ(length, 0u);
+    EXPECT_EQ(buffer.next(), nullptr);
+
+    // The unterminated line is moved to the front to make room
+    std::string filler(20, 'x');
+    EXPECT_EQ(buffer.append((filler + "\n").c_str(), 21), 21u);
+    EXPECT_EQ(std::string(buffer.next()), "third" + filler);
+
+    // A line that does not fit is dropped and the stream resynchronizes on the next delimiter
+    std::string garbage(40, 'g');
+    size_t taken = buffer.append(garbage.c_str(), garbage.size());
+    EXPECT_EQ(buffer.next(), nullptr);
+    buffer.append(garbage.c_str() + taken, garbage.size() - taken);
+    EXPECT_EQ(buffer.next(), nullptr);
+    buffer.append("\nlast\n", 6);
+    EXPECT_EQ(buffer.getOverflows(), 1u);
+    buffer.next();
+    EXPECT_STREQ(buffer.next(), "last");
+}
+
+TEST(LatestSlot, ProducerConsumer)
+{
+    GNSSStream::LatestSlot<GNSSFix> slot;
+    GNSSFix fix;
+
+    EXPECT_FALSE(slot.consume(fix));
+
+    const uint32_t count = 200000;
+    std::thread producer([&]()
+    {
+        GNSSFix published;
+        for (uint32_t i = 1; i <= count; i++)
+        {
+            published.sentences = i;
+            published.latitude = i;
+            published.longitude = -static_cast<double>(i);
+            slot.publish(published);
+        }
+    });
+
+    // Values are never torn and never go back in time
+    uint32_t last = 0;
+    while (last < count)
+    {
+        if (slot.consume(fix))
+        {
+            ASSERT_GT(fix.sentences, last);
+            ASSERT_EQ(fix.latitude, fix.sentences);
+            ASSERT_EQ(fix.longitude, -fix.latitude);
+            last = fix.sentences;
+        }
+    }
+
+    producer.join();
+    EXPECT_FALSE(slot.consume(fix));
+}
+
+// A receiver sending RMC, GGA, GSA, GSV and VTG every second, with a few corrupted sentences
+static std::string writeLog(int seconds)
+{
+    std::string filename = testing::TempDir() + "gpsnmea_replay.log";
+    FILE *fp = fopen(filename.c_str(), "w");
+
+    for (int i = 0; i < seconds; i++)
+    {
+        int hh = (i / 3600) % 24, mm = (i / 60) % 60, ss = i % 60;
+        char body[128];
+
+        snprintf(body, sizeof(body), "$GPRMC,%02d%02d%02d.00,A,4807.%03d,N,01131.000,E,0.0,0.0,180926,,,A", hh, mm, ss, i % 1000);
+        std::string rmc = withChecksum(body);
+        if (i % 97 == 0)
+            rmc[20] ^= 1;
+        fprintf(fp, "%s\r\n", rmc.c_str());
+
+        snprintf(body, sizeof(body), "$GPGGA,%02d%02d%02d.00,4807.%03d,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,", hh, mm, ss,
+                 i % 1000);
+        fprintf(fp, "%s\r\n", withChecksum(body).c_str());
+        fprintf(fp, "%s\r\n", withChecksum(i % 60 < 5 ? "$GPGSA,A,2,04,05,,09,12,,,24,,,,,2.5,1.3,2.1" :
+                                           "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1").c_str());
+        fprintf(fp, "%s\r\n", withChecksum("$GPGSV,3,1,11,03,03,111,00,04,15,270,00,06,01,010,00,13,06,292,00").c_str());
+        fprintf(fp, "%s\r\n", withChecksum("$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K").c_str());
+    }
+
+    fclose(fp);
+    return filename;
+}
+
+TEST(NMEAParser, ReplayThroughput)
+{
+    const int seconds = 20000;
+    std::string filename = writeLog(seconds);
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+
+    GNSSStream::LineBuffer<1024> buffer(0xA);
+    NMEAParser parser;
+    GNSSStream::LatestSlot<GNSSFix> slot;
+
+    uint32_t lines = 0, invalid = 0, published = 0;
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    ssize_t rc;
+    while ((rc = buffer.fill(fd, 0)) > 0)
+    {
+        bytes += rc;
+
+        size_t length;
+        char *line;
+        while ((line = buffer.next(&length)) != nullptr)
+        {
+            lines++;
+            NMEAParser::Result result = parser.parse(line, length);
+            if (result == NMEAParser::SENTENCE_INVALID)
+                invalid++;
+            else if (result == NMEAParser::SENTENCE_UPDATED)
+            {
+                slot.publish(parser.getFix());
+                published++;
+            }
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    close(fd);
+    remove(filename.c_str());
+
+    EXPECT_EQ(rc, GNSSStream::READ_CLOSED);
+    EXPECT_EQ(lines, 5u * seconds);
+    EXPECT_EQ(invalid, static_cast<uint32_t>((seconds + 96) / 97));
+    // RMC and GGA each second, GSA on each change of fix type
+    EXPECT_EQ(published, 2u * seconds - invalid + 2 * ((seconds + 59) / 60));
+    EXPECT_EQ(buffer.getOverflows(), 0u);
+
+    GNSSFix fix;
+    ASSERT_TRUE(slot.consume(fix));
+    EXPECT_EQ(fix.fixType, 3);
+    EXPECT_EQ(fix.time % 86400, (seconds - 1) % 86400);
+
+    std::cout << "Replayed " << lines << " sentences (" << bytes / 1024 << " KiB) in " << elapsed * 1000 << " ms, "
+              << bytes / elapsed / 1e6 << " MB/s, " << elapsed / lines * 1e9 << " ns per sentence" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
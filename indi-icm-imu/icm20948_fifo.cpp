@@ -0,0 +1,219 @@
+/*
+    ICM-20948 IMU Driver - Hardware FIFO sample source
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "icm20948_fifo.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <unistd.h>
+
+// Register map, see ICM-20948 datasheet section 7.
+namespace
+{
+constexpr uint8_t REG_BANK_SEL      = 0x7F;
+
+// Bank 0
+constexpr uint8_t USER_CTRL         = 0x03;
+constexpr uint8_t USER_CTRL_FIFO_EN = 0x40;
+constexpr uint8_t INT_STATUS_2      = 0x1B;
+constexpr uint8_t FIFO_EN_2         = 0x67;
+constexpr uint8_t FIFO_EN_2_ACCEL_GYRO = 0x1E;
+constexpr uint8_t FIFO_RST          = 0x68;
+constexpr uint8_t FIFO_MODE         = 0x69;
+constexpr uint8_t FIFO_COUNTH       = 0x70;
+constexpr uint8_t FIFO_R_W          = 0x72;
+
+// Bank 2
+constexpr uint8_t GYRO_SMPLRT_DIV   = 0x00;
+constexpr uint8_t GYRO_CONFIG_1     = 0x01;
+constexpr uint8_t ACCEL_SMPLRT_DIV_1 = 0x10;
+constexpr uint8_t ACCEL_SMPLRT_DIV_2 = 0x11;
+constexpr uint8_t ACCEL_CONFIG      = 0x14;
+
+constexpr double BASE_RATE          = 1125.0;
+constexpr size_t FIFO_SIZE          = 512;
+constexpr size_t FRAME_SIZE         = 12;
+constexpr double STANDARD_GRAVITY   = 9.80665;
+
+double monotonicSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int16_t be16(const uint8_t *p)
+{
+    return static_cast<int16_t>((p[0] << 8) | p[1]);
+}
+}
+
+bool LinuxI2CBus::read(uint8_t reg, uint8_t *data, size_t length)
+{
+    if (::write(m_FD, &reg, 1) != 1)
+        return false;
+    return ::read(m_FD, data, length) == static_cast<ssize_t>(length);
+}
+
+bool LinuxI2CBus::write(uint8_t reg, uint8_t value)
+{
+    uint8_t buffer[2] = {reg, value};
+    return ::write(m_FD, buffer, 2) == 2;
+}
+
+ICM20948FIFOSource::ICM20948FIFOSource(std::unique_ptr<I2CRegisterBus> bus, ICM20948 &library)
+    : m_Bus(std::move(bus)), m_Library(library)
+{
+}
+
+ICM20948FIFOSource::~ICM20948FIFOSource()
+{
+    // Leave the FIFO disabled so the library sees the sensor in its usual register mode.
+    uint8_t bank = 0, userCtrl = 0;
+    if (m_Bus->read(REG_BANK_SEL, &bank, 1) && selectBank(0))
+    {
+        m_Bus->write(FIFO_EN_2, 0);
+        if (m_Bus->read(USER_CTRL, &userCtrl, 1))
+            m_Bus->write(USER_CTRL, userCtrl & ~USER_CTRL_FIFO_EN);
+        m_Bus->write(REG_BANK_SEL, bank);
+    }
+}
+
+bool ICM20948FIFOSource::selectBank(uint8_t bank)
+{
+    return m_Bus->write(REG_BANK_SEL, bank << 4);
+}
+
+bool ICM20948FIFOSource::resetFIFO()
+{
+    return m_Bus->write(FIFO_RST, 0x1F) && m_Bus->write(FIFO_RST, 0x00);
+}
+
+double ICM20948FIFOSource::configure(double rateHz)
+{
+    // The library caches the selected bank, so restore whatever it left selected.
+    uint8_t previousBank = 0;
+    m_Bus->read(REG_BANK_SEL, &previousBank, 1);
+
+    int divider = std::max(0, std::min(255, static_cast<int>(std::lround(BASE_RATE / std::max(1.0, rateHz))) - 1));
+    m_Rate = BASE_RATE / (1 + divider);
+
+    uint8_t gyroConfig = 0, accelConfig = 0;
+    selectBank(2);
+    m_Bus->write(GYRO_SMPLRT_DIV, divider);
+    m_Bus->write(ACCEL_SMPLRT_DIV_1, 0);
+    m_Bus->write(ACCEL_SMPLRT_DIV_2, divider);
+    m_Bus->read(GYRO_CONFIG_1, &gyroConfig, 1);
+    m_Bus->read(ACCEL_CONFIG, &accelConfig, 1);
+
+    // Scale factors follow the full scale ranges configured by the library.
+    m_GyroScale = 250.0 * (1 << ((gyroConfig >> 1) & 0x03)) / 32768.0;
+    m_AccelScale = 2.0 * (1 << ((accelConfig >> 1) & 0x03)) * STANDARD_GRAVITY / 32768.0;
+
+    selectBank(0);
+    uint8_t userCtrl = 0;
+    m_Bus->read(USER_CTRL, &userCtrl, 1);
+    m_Bus->write(FIFO_MODE, 0x00);
+    m_Bus->write(FIFO_EN_2, FIFO_EN_2_ACCEL_GYRO);
+    m_Bus->write(USER_CTRL, userCtrl | USER_CTRL_FIFO_EN);
+    resetFIFO();
+
+    m_Bus->write(REG_BANK_SEL, previousBank);
+    m_NextTimestamp = -1;
+    return m_Rate;
+}
+
+double ICM20948FIFOSource::burstInterval() const
+{
+    // Drain when the FIFO is about a quarter full, but at least 50 times per second.
+    return std::min(0.02, (FIFO_SIZE / FRAME_SIZE) / 4.0 / m_Rate);
+}
+
+int ICM20948FIFOSource::readBurst(IMUAcquisition::Sample *samples, int maxSamples)
+{
+    uint8_t previousBank = 0;
+    if (!m_Bus->read(REG_BANK_SEL, &previousBank, 1) || !selectBank(0))
+        return -1;
+
+    uint8_t count[2] = {0, 0}, status = 0;
+    if (!m_Bus->read(FIFO_COUNTH, count, 2))
+    {
+        m_Bus->write(REG_BANK_SEL, previousBank);
+        return -1;
+    }
+
+    // Overflowed FIFO contents are no longer frame aligned, start over.
+    m_Bus->read(INT_STATUS_2, &status, 1);
+    if (status & 0x0F)
+    {
+        m_Overflows++;
+        resetFIFO();
+        m_Bus->write(REG_BANK_SEL, previousBank);
+        m_NextTimestamp = -1;
+        return 0;
+    }
+
+    size_t available = ((count[0] & 0x1F) << 8) | count[1];
+    int frames = std::min<int>({maxSamples, static_cast<int>(available / FRAME_SIZE), static_cast<int>(FIFO_SIZE / FRAME_SIZE)});
+
+    uint8_t buffer[FIFO_SIZE];
+    if (frames > 0 && !m_Bus->read(FIFO_R_W, buffer, frames * FRAME_SIZE))
+    {
+        m_Bus->write(REG_BANK_SEL, previousBank);
+        return -1;
+    }
+    m_Bus->write(REG_BANK_SEL, previousBank);
+
+    if (frames == 0)
+        return 0;
+
+    // Samples are evenly spaced at the output data rate, the newest one was taken about now.
+    double now = monotonicSeconds();
+    double period = 1.0 / m_Rate;
+    double first = now - (frames - 1) * period;
+    if (m_NextTimestamp < 0 || std::fabs(m_NextTimestamp - first) > 5 * period)
+        m_NextTimestamp = first;
+
+    for (int i = 0; i < frames; i++)
+    {
+        const uint8_t *frame = buffer + i * FRAME_SIZE;
+        IMUAcquisition::Sample &s = samples[i];
+        s.timestamp = m_NextTimestamp;
+        m_NextTimestamp += period;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            s.accel[axis] = be16(frame + 2 * axis) * m_AccelScale;
+            s.gyro[axis] = be16(frame + 6 + 2 * axis) * m_GyroScale;
+        }
+        s.hasMag = false;
+    }
+
+    // The magnetometer is sampled by the sensor's auxiliary I2C master, read it through the library.
+    icm20948_agmt_t agmt;
+    if (m_Library.readSensor(&agmt) == ICM_20948_STAT_OK)
+    {
+        IMUAcquisition::Sample &newest = samples[frames - 1];
+        newest.mag[0] = m_Library.getMagX_uT();
+        newest.mag[1] = m_Library.getMagY_uT();
+        newest.mag[2] = m_Library.getMagZ_uT();
+        newest.hasMag = true;
+    }
+
+    return frames;
+}
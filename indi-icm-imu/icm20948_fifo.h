@@ -0,0 +1,78 @@
+/*
+    ICM-20948 IMU Driver - Hardware FIFO sample source
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include "imu_acquisition.h"
+
+#include <ICM20948.h>
+
+/**
+ * @brief Register level access to the sensor, so the FIFO can be driven without the library.
+ */
+class I2CRegisterBus
+{
+    public:
+        virtual ~I2CRegisterBus() = default;
+        virtual bool read(uint8_t reg, uint8_t *data, size_t length) = 0;
+        virtual bool write(uint8_t reg, uint8_t value) = 0;
+};
+
+/**
+ * @brief Linux i2c-dev bus. The INDI I2C connection already bound the file descriptor to the device address.
+ */
+class LinuxI2CBus : public I2CRegisterBus
+{
+    public:
+        explicit LinuxI2CBus(int fd) : m_FD(fd) {}
+        virtual bool read(uint8_t reg, uint8_t *data, size_t length) override;
+        virtual bool write(uint8_t reg, uint8_t value) override;
+
+    private:
+        int m_FD;
+};
+
+/**
+ * @brief Streams accelerometer and gyroscope samples through the ICM-20948 hardware FIFO.
+ * The magnetometer is not part of the FIFO stream, it is read through the library once per burst
+ * and attached to the newest sample of that burst.
+ */
+class ICM20948FIFOSource : public IMUAcquisition::SampleSource
+{
+    public:
+        ICM20948FIFOSource(std::unique_ptr<I2CRegisterBus> bus, ICM20948 &library);
+        virtual ~ICM20948FIFOSource() override;
+
+        virtual double configure(double rateHz) override;
+        virtual int readBurst(IMUAcquisition::Sample *samples, int maxSamples) override;
+        virtual double burstInterval() const override;
+
+    private:
+        bool selectBank(uint8_t bank);
+        bool resetFIFO();
+
+        std::unique_ptr<I2CRegisterBus> m_Bus;
+        ICM20948 &m_Library;
+        double m_Rate {112.5};
+        double m_AccelScale {1};
+        double m_GyroScale {1};
+        double m_NextTimestamp {-1};
+        uint64_t m_Overflows {0};
+};
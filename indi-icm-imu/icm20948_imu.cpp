@@ -19,6 +19,7 @@
 */
 
 #include "icm20948_imu.h"
+#include "icm20948_fifo.h"
 #include <indicom.h>
 #include <indilogger.h>
 #include <cmath>
@@ -28,8 +29,9 @@ std::unique_ptr<ICM20948IMU> imu(new ICM20948IMU());
 
 ICM20948IMU::ICM20948IMU()
 {
-    // ICM-20948 provides raw sensor data only (no sensor fusion/orientation)
-    SetCapability(IMU_HAS_ACCELERATION | IMU_HAS_GYROSCOPE | IMU_HAS_MAGNETOMETER | IMU_HAS_CALIBRATION);
+    // ICM-20948 provides raw sensor data only, orientation is fused by the driver at the native sample rate
+    SetCapability(IMU_HAS_ORIENTATION | IMU_HAS_ACCELERATION | IMU_HAS_GYROSCOPE | IMU_HAS_MAGNETOMETER |
+                  IMU_HAS_CALIBRATION);
 
     setSupportedConnections(INDI::IMU::CONNECTION_I2C);
     setDriverInterface(IMU_INTERFACE);
@@ -44,6 +46,15 @@ bool ICM20948IMU::initProperties()
     // Define calibration offset properties
     defineCalibrationProperties();
 
+    // Acquisition statistics
+    AcquisitionNP[ACQUISITION_RATE].fill("SAMPLE_RATE", "Sample rate (Hz)", "%.1f", 0, 2000, 0, 0);
+    AcquisitionNP[ACQUISITION_CPU].fill("CPU_PER_SAMPLE", "CPU per sample (us)", "%.2f", 0, 1e6, 0, 0);
+    AcquisitionNP.fill(getDeviceName(), "ACQUISITION", "Acquisition", MAIN_CONTROL_TAB, IP_RO, 60, IPS_IDLE);
+
+    // Record raw samples for offline replay
+    RecordTP[0].fill("FILE", "File", "");
+    RecordTP.fill(getDeviceName(), "RECORD_SAMPLES", "Record", OPTIONS_TAB, IP_RW, 60, IPS_IDLE);
+
     return true;
 }
 
@@ -57,9 +68,13 @@ bool ICM20948IMU::updateProperties()
         defineProperty(AccelOffsetNP);
         defineProperty(GyroOffsetNP);
         defineProperty(MagOffsetNP);
+        defineProperty(AcquisitionNP);
+        defineProperty(RecordTP);
     }
     else
     {
+        deleteProperty(AcquisitionNP);
+        deleteProperty(RecordTP);
         // Delete calibration properties when disconnected
         deleteProperty(AccelOffsetNP);
         deleteProperty(GyroOffsetNP);
@@ -97,7 +112,7 @@ bool ICM20948IMU::Handshake()
         // Load calibration data if available
         LoadCalibrationData();
 
-        return true;
+        return startAcquisition();
     }
     catch (const ICM20948_exception &e)
     {
@@ -106,52 +121,78 @@ bool ICM20948IMU::Handshake()
     }
 }
 
+bool ICM20948IMU::Disconnect()
+{
+    // The worker drains the FIFO through PortFD and the FIFO source resets the sensor when destroyed,
+    // both must be done before the connection closes the port.
+    m_Acquisition.stop();
+    m_Acquisition.setRecordFile("");
+    return IMU::Disconnect();
+}
+
 void ICM20948IMU::TimerHit()
 {
     if (!isConnected())
         return;
 
-    // Update calibration if in progress
-    if (m_CalibrationState != CAL_IDLE)
+    IMUAcquisition::Snapshot snapshot = m_Acquisition.fetch();
+
+    if (snapshot.samples > 0)
     {
-        collectCalibrationSample();
-    }
+        // Update calibration if in progress
+        if (m_CalibrationState != CAL_IDLE)
+        {
+            collectCalibrationSample(snapshot);
+        }
 
-    readSensorData();
+        publishSensorData(snapshot);
+    }
+    else
+        LOG_DEBUG("ICM20948: No new samples since last update.");
 
     SetTimer(getPollingPeriod());
 }
 
-bool ICM20948IMU::readSensorData()
+bool ICM20948IMU::startAcquisition()
 {
-    icm20948_agmt_t agmt;
-    icm20948_status_e status = icm20948.readSensor(&agmt);
+    updateAcquisitionOffsets();
 
-    if (status == ICM_20948_STAT_OK)
-    {
-        // Apply calibration offsets and update INDI properties
-        double accelX = icm20948.getAccelX_mss() - m_Offsets.accel[0];
-        double accelY = icm20948.getAccelY_mss() - m_Offsets.accel[1];
-        double accelZ = icm20948.getAccelZ_mss() - m_Offsets.accel[2];
-        SetAccelerationData(accelX, accelY, accelZ);
-
-        double gyroX = icm20948.getGyroX_dps() - m_Offsets.gyro[0];
-        double gyroY = icm20948.getGyroY_dps() - m_Offsets.gyro[1];
-        double gyroZ = icm20948.getGyroZ_dps() - m_Offsets.gyro[2];
-        SetGyroscopeData(gyroX, gyroY, gyroZ);
-
-        double magX = icm20948.getMagX_uT() - m_Offsets.mag[0];
-        double magY = icm20948.getMagY_uT() - m_Offsets.mag[1];
-        double magZ = icm20948.getMagZ_uT() - m_Offsets.mag[2];
-        SetMagnetometerData(magX, magY, magZ);
-
-        return true;
-    }
-    else
+    // The AK09916 magnetometer Y and Z axes are inverted with respect to the accelerometer and gyroscope.
+    m_Acquisition.setMagneticAxisSigns(1, -1, -1);
+
+    std::unique_ptr<IMUAcquisition::SampleSource> source(
+        new ICM20948FIFOSource(std::unique_ptr<I2CRegisterBus>(new LinuxI2CBus(PortFD)), icm20948));
+
+    if (!m_Acquisition.start(std::move(source), m_SampleRate))
     {
-        LOGF_ERROR("ICM20948: Failed to read sensor data, status: %d", static_cast<int>(status));
+        LOG_ERROR("ICM20948: Failed to start sample acquisition.");
         return false;
     }
+
+    LOGF_INFO("ICM20948: Acquiring samples through the sensor FIFO at %.1f Hz.", m_SampleRate);
+    return true;
+}
+
+void ICM20948IMU::updateAcquisitionOffsets()
+{
+    m_Acquisition.setOffsets(m_Offsets.accel, m_Offsets.gyro, m_Offsets.mag);
+}
+
+void ICM20948IMU::publishSensorData(const IMUAcquisition::Snapshot &snapshot)
+{
+    // Calibration offsets are already applied by the acquisition thread
+    SetAccelerationData(snapshot.accel[0], snapshot.accel[1], snapshot.accel[2]);
+    SetGyroscopeData(snapshot.gyro[0], snapshot.gyro[1], snapshot.gyro[2]);
+
+    if (snapshot.magSamples > 0)
+        SetMagnetometerData(snapshot.mag[0], snapshot.mag[1], snapshot.mag[2]);
+
+    SetOrientationData(snapshot.quaternion[0], snapshot.quaternion[1], snapshot.quaternion[2], snapshot.quaternion[3]);
+
+    AcquisitionNP[ACQUISITION_RATE].setValue(snapshot.sampleRate);
+    AcquisitionNP[ACQUISITION_CPU].setValue(snapshot.cpuPerSample * 1e6);
+    AcquisitionNP.setState(snapshot.busErrors > 0 ? IPS_ALERT : IPS_OK);
+    AcquisitionNP.apply();
 }
 
 void ICM20948IMU::defineCalibrationProperties()
@@ -188,6 +229,7 @@ bool ICM20948IMU::ISNewNumber(const char *dev, const char *name, double values[]
             m_Offsets.accel[2] = AccelOffsetNP[2].getValue();
             AccelOffsetNP.setState(IPS_OK);
             AccelOffsetNP.apply();
+            updateAcquisitionOffsets();
             LOG_INFO("Accelerometer offsets updated.");
             return true;
         }
@@ -201,6 +243,7 @@ bool ICM20948IMU::ISNewNumber(const char *dev, const char *name, double values[]
             m_Offsets.gyro[2] = GyroOffsetNP[2].getValue();
             GyroOffsetNP.setState(IPS_OK);
             GyroOffsetNP.apply();
+            updateAcquisitionOffsets();
             LOG_INFO("Gyroscope offsets updated.");
             return true;
         }
@@ -214,6 +257,7 @@ bool ICM20948IMU::ISNewNumber(const char *dev, const char *name, double values[]
             m_Offsets.mag[2] = MagOffsetNP[2].getValue();
             MagOffsetNP.setState(IPS_OK);
             MagOffsetNP.apply();
+            updateAcquisitionOffsets();
             LOG_INFO("Magnetometer offsets updated.");
             return true;
         }
@@ -222,29 +266,52 @@ bool ICM20948IMU::ISNewNumber(const char *dev, const char *name, double values[]
     return IMU::ISNewNumber(dev, name, values, names, n);
 }
 
-bool ICM20948IMU::collectCalibrationSample()
+bool ICM20948IMU::ISNewText(const char *dev, const char *name, char *texts[], char *names[], int n)
 {
-    icm20948_agmt_t agmt;
-    icm20948_status_e status = icm20948.readSensor(&agmt);
+    if (dev != nullptr && strcmp(dev, getDeviceName()) == 0)
+    {
+        if (RecordTP.isNameMatch(name))
+        {
+            RecordTP.update(texts, names, n);
+            std::string filename = RecordTP[0].getText() ? RecordTP[0].getText() : "";
+            if (m_Acquisition.setRecordFile(filename))
+            {
+                RecordTP.setState(filename.empty() ? IPS_IDLE : IPS_BUSY);
+                if (!filename.empty())
+                    LOGF_INFO("Recording raw samples to %s", filename.c_str());
+            }
+            else
+            {
+                RecordTP.setState(IPS_ALERT);
+                LOGF_ERROR("Failed to open %s for recording.", filename.c_str());
+            }
+            RecordTP.apply();
+            return true;
+        }
+    }
 
-    if (status != ICM_20948_STAT_OK)
-        return false;
+    return IMU::ISNewText(dev, name, texts, names, n);
+}
 
+bool ICM20948IMU::collectCalibrationSample(const IMUAcquisition::Snapshot &snapshot)
+{
+    // Each snapshot carries the mean of all samples acquired since the last update
     switch (m_CalibrationState)
     {
         case CAL_GYRO_COLLECTING:
             // Collect gyroscope samples (device should be stationary)
-            m_CalibrationSum[0] += icm20948.getGyroX_dps();
-            m_CalibrationSum[1] += icm20948.getGyroY_dps();
-            m_CalibrationSum[2] += icm20948.getGyroZ_dps();
-            m_CalibrationSamples++;
+            m_CalibrationSum[0] += snapshot.rawGyro[0] * snapshot.samples;
+            m_CalibrationSum[1] += snapshot.rawGyro[1] * snapshot.samples;
+            m_CalibrationSum[2] += snapshot.rawGyro[2] * snapshot.samples;
+            m_CalibrationSamples += snapshot.samples;
 
             if (m_CalibrationSamples >= CALIBRATION_SAMPLES)
             {
                 // Calculate average offset
-                m_Offsets.gyro[0] = m_CalibrationSum[0] / CALIBRATION_SAMPLES;
-                m_Offsets.gyro[1] = m_CalibrationSum[1] / CALIBRATION_SAMPLES;
-                m_Offsets.gyro[2] = m_CalibrationSum[2] / CALIBRATION_SAMPLES;
+                m_Offsets.gyro[0] = m_CalibrationSum[0] / m_CalibrationSamples;
+                m_Offsets.gyro[1] = m_CalibrationSum[1] / m_CalibrationSamples;
+                m_Offsets.gyro[2] = m_CalibrationSum[2] / m_CalibrationSamples;
+                updateAcquisitionOffsets();
 
                 // Update properties
                 GyroOffsetNP[0].setValue(m_Offsets.gyro[0]);
@@ -269,17 +336,18 @@ bool ICM20948IMU::collectCalibrationSample()
 
         case CAL_ACCEL_COLLECTING:
             // Collect accelerometer samples (device should be flat on level surface)
-            m_CalibrationSum[0] += icm20948.getAccelX_mss();
-            m_CalibrationSum[1] += icm20948.getAccelY_mss();
-            m_CalibrationSum[2] += icm20948.getAccelZ_mss();
-            m_CalibrationSamples++;
+            m_CalibrationSum[0] += snapshot.rawAccel[0] * snapshot.samples;
+            m_CalibrationSum[1] += snapshot.rawAccel[1] * snapshot.samples;
+            m_CalibrationSum[2] += snapshot.rawAccel[2] * snapshot.samples;
+            m_CalibrationSamples += snapshot.samples;
 
             if (m_CalibrationSamples >= CALIBRATION_SAMPLES)
             {
                 // Calculate offsets (Z-axis should read ~9.81 m/s² when level)
-                m_Offsets.accel[0] = m_CalibrationSum[0] / CALIBRATION_SAMPLES;
-                m_Offsets.accel[1] = m_CalibrationSum[1] / CALIBRATION_SAMPLES;
-                m_Offsets.accel[2] = (m_CalibrationSum[2] / CALIBRATION_SAMPLES) - 9.80665;
+                m_Offsets.accel[0] = m_CalibrationSum[0] / m_CalibrationSamples;
+                m_Offsets.accel[1] = m_CalibrationSum[1] / m_CalibrationSamples;
+                m_Offsets.accel[2] = (m_CalibrationSum[2] / m_CalibrationSamples) - 9.80665;
+                updateAcquisitionOffsets();
 
                 // Update properties
                 AccelOffsetNP[0].setValue(m_Offsets.accel[0]);
@@ -305,29 +373,24 @@ bool ICM20948IMU::collectCalibrationSample()
         case CAL_MAG_COLLECTING:
         {
             // Collect min/max values for hard iron offset calibration
-            static double magMin[3] = {999999.0, 999999.0, 999999.0};
-            static double magMax[3] = {-999999.0, -999999.0, -999999.0};
+            if (snapshot.magSamples == 0)
+                break;
 
-            double magX = icm20948.getMagX_uT();
-            double magY = icm20948.getMagY_uT();
-            double magZ = icm20948.getMagZ_uT();
-
-            magMin[0] = std::min(magMin[0], magX);
-            magMin[1] = std::min(magMin[1], magY);
-            magMin[2] = std::min(magMin[2], magZ);
-
-            magMax[0] = std::max(magMax[0], magX);
-            magMax[1] = std::max(magMax[1], magY);
-            magMax[2] = std::max(magMax[2], magZ);
+            for (int i = 0; i < 3; i++)
+            {
+                m_MagMin[i] = std::min(m_MagMin[i], snapshot.rawMagMin[i]);
+                m_MagMax[i] = std::max(m_MagMax[i], snapshot.rawMagMax[i]);
+            }
 
-            m_CalibrationSamples++;
+            m_CalibrationSamples += snapshot.magSamples;
 
-            if (m_CalibrationSamples >= CALIBRATION_SAMPLES * 2) // More samples for mag
+            if (m_CalibrationSamples >= MAG_CALIBRATION_SAMPLES)
             {
                 // Calculate hard iron offset (center of min/max sphere)
-                m_Offsets.mag[0] = (magMax[0] + magMin[0]) / 2.0;
-                m_Offsets.mag[1] = (magMax[1] + magMin[1]) / 2.0;
-                m_Offsets.mag[2] = (magMax[2] + magMin[2]) / 2.0;
+                m_Offsets.mag[0] = (m_MagMax[0] + m_MagMin[0]) / 2.0;
+                m_Offsets.mag[1] = (m_MagMax[1] + m_MagMin[1]) / 2.0;
+                m_Offsets.mag[2] = (m_MagMax[2] + m_MagMin[2]) / 2.0;
+                updateAcquisitionOffsets();
 
                 // Update properties
                 MagOffsetNP[0].setValue(m_Offsets.mag[0]);
@@ -340,9 +403,9 @@ bool ICM20948IMU::collectCalibrationSample()
                 LOGF_INFO("Mag offsets: X=%.4f, Y=%.4f, Z=%.4f µT",
                           m_Offsets.mag[0], m_Offsets.mag[1], m_Offsets.mag[2]);
 
-                // Reset static variables for next calibration
-                magMin[0] = magMin[1] = magMin[2] = 999999.0;
-                magMax[0] = magMax[1] = magMax[2] = -999999.0;
+                // Reset extrema for next calibration
+                m_MagMin[0] = m_MagMin[1] = m_MagMin[2] = 999999.0;
+                m_MagMax[0] = m_MagMax[1] = m_MagMax[2] = -999999.0;
 
                 // Calibration complete
                 m_CalibrationState = CAL_COMPLETE;
@@ -419,6 +482,8 @@ bool ICM20948IMU::StartCalibration()
     m_CalibrationState = CAL_GYRO_COLLECTING;
     m_CalibrationSamples = 0;
     m_CalibrationSum[0] = m_CalibrationSum[1] = m_CalibrationSum[2] = 0.0;
+    m_MagMin[0] = m_MagMin[1] = m_MagMin[2] = 999999.0;
+    m_MagMax[0] = m_MagMax[1] = m_MagMax[2] = -999999.0;
 
     return true;
 }
@@ -457,6 +522,7 @@ bool ICM20948IMU::LoadCalibrationData()
     m_Offsets.mag[0] = MagOffsetNP[0].getValue();
     m_Offsets.mag[1] = MagOffsetNP[1].getValue();
     m_Offsets.mag[2] = MagOffsetNP[2].getValue();
+    updateAcquisitionOffsets();
 
     updateCalibrationStatus();
 
@@ -479,6 +545,7 @@ bool ICM20948IMU::ResetCalibration()
     m_Offsets.accel[0] = m_Offsets.accel[1] = m_Offsets.accel[2] = 0.0;
     m_Offsets.gyro[0] = m_Offsets.gyro[1] = m_Offsets.gyro[2] = 0.0;
     m_Offsets.mag[0] = m_Offsets.mag[1] = m_Offsets.mag[2] = 0.0;
+    updateAcquisitionOffsets();
 
     // Update properties
     AccelOffsetNP[0].setValue(0.0);
@@ -546,7 +613,16 @@ bool ICM20948IMU::SetAngularUnits(bool degrees)
 
 bool ICM20948IMU::SetUpdateRate(double rate)
 {
-    LOGF_INFO("ICM20948: Update rate controlled by polling period (requested: %.2f Hz).", rate);
+    // The update rate sets the native sensor output rate, results are still published every polling period.
+    if (rate <= 0)
+        return false;
+
+    m_SampleRate = rate;
+    LOGF_INFO("ICM20948: Sample rate set to %.2f Hz.", rate);
+
+    if (isConnected())
+        return startAcquisition();
+
     return true;
 }
 
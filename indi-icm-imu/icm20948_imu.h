@@ -25,6 +25,8 @@
 #include <ICM20948.h>
 #include <cmath>
 
+#include "imu_acquisition.h"
+
 class ICM20948IMU : public INDI::IMU
 {
     public:
@@ -39,8 +41,10 @@ class ICM20948IMU : public INDI::IMU
         virtual bool initProperties() override;
         virtual bool updateProperties() override;
         virtual bool Handshake() override;
+        virtual bool Disconnect() override;
         virtual void TimerHit() override;
         virtual bool ISNewNumber(const char *dev, const char *name, double values[], char *names[], int n) override;
+        virtual bool ISNewText(const char *dev, const char *name, char *texts[], char *names[], int n) override;
 
     protected:
         // Implement virtual functions from IMUInterface
@@ -58,7 +62,14 @@ class ICM20948IMU : public INDI::IMU
                                    const std::string &sensorStatus) override;
     private:
         ICM20948 icm20948; // ICM20948 sensor object
-        bool readSensorData();
+        void publishSensorData(const IMUAcquisition::Snapshot &snapshot);
+
+        // Samples are drained from the sensor FIFO and fused on a background thread,
+        // TimerHit only publishes the decimated result.
+        IMUAcquisition::Acquisition m_Acquisition;
+        bool startAcquisition();
+        void updateAcquisitionOffsets();
+        double m_SampleRate = 112.5;
 
         // Calibration offsets
         struct CalibrationOffsets
@@ -82,19 +93,32 @@ class ICM20948IMU : public INDI::IMU
 
         CalibrationState m_CalibrationState = CAL_IDLE;
         int m_CalibrationSamples = 0;
-        static constexpr int CALIBRATION_SAMPLES = 100;
+        // Sample counts at the native rate, roughly 10 seconds each
+        static constexpr int CALIBRATION_SAMPLES = 1000;
+        static constexpr int MAG_CALIBRATION_SAMPLES = 500;
 
         // Temporary storage during calibration
         double m_CalibrationSum[3] = {0.0, 0.0, 0.0};
+        double m_MagMin[3] = {999999.0, 999999.0, 999999.0};
+        double m_MagMax[3] = {-999999.0, -999999.0, -999999.0};
 
         // Calibration properties
         INDI::PropertyNumber AccelOffsetNP{3};
         INDI::PropertyNumber GyroOffsetNP{3};
         INDI::PropertyNumber MagOffsetNP{3};
 
+        // Acquisition statistics and raw sample recording
+        INDI::PropertyNumber AcquisitionNP{2};
+        enum
+        {
+            ACQUISITION_RATE,
+            ACQUISITION_CPU
+        };
+        INDI::PropertyText RecordTP{1};
+
         // Helper methods
         void defineCalibrationProperties();
         void deleteCalibrationProperties();
-        bool collectCalibrationSample();
+        bool collectCalibrationSample(const IMUAcquisition::Snapshot &snapshot);
         void updateCalibrationStatus();
 };
@@ -0,0 +1,464 @@
+/*
+    ICM-20948 IMU Driver - Background acquisition and sensor fusion
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "imu_acquisition.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace IMUAcquisition
+{
+
+static constexpr int MAX_BURST_SAMPLES = 512;
+static constexpr double DEG_TO_RAD = M_PI / 180.0;
+
+static double threadCPUTime()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Replay source
+/////////////////////////////////////////////////////////////////////////////
+ReplaySampleSource::ReplaySampleSource(const std::string &filename, bool realtime) : m_Realtime(realtime)
+{
+    m_File = fopen(filename.c_str(), "r");
+}
+
+ReplaySampleSource::~ReplaySampleSource()
+{
+    if (m_File)
+        fclose(m_File);
+}
+
+double ReplaySampleSource::configure(double rateHz)
+{
+    // The recorded rate is fixed, the requested rate only paces realtime replay.
+    m_Rate = rateHz;
+    return m_Rate;
+}
+
+double ReplaySampleSource::burstInterval() const
+{
+    return m_Realtime ? 0.02 : 0;
+}
+
+bool ReplaySampleSource::parseLine(const char *line, Sample &sample)
+{
+    double v[10];
+    int n = sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf",
+                   &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8], &v[9]);
+    if (n != 7 && n != 10)
+        return false;
+
+    sample.timestamp = v[0];
+    for (int i = 0; i < 3; i++)
+    {
+        sample.accel[i] = v[1 + i];
+        sample.gyro[i] = v[4 + i];
+        sample.mag[i] = (n == 10) ? v[7 + i] : 0;
+    }
+    sample.hasMag = (n == 10);
+    return true;
+}
+
+int ReplaySampleSource::readBurst(Sample *samples, int maxSamples)
+{
+    if (m_File == nullptr)
+        return -1;
+
+    // In realtime mode deliver as many samples as the sensor would have buffered during one interval.
+    int limit = m_Realtime ? std::min(maxSamples, std::max(1, static_cast<int>(m_Rate * burstInterval()))) : maxSamples;
+    int count = 0;
+    char line[256];
+
+    while (count < limit && fgets(line, sizeof(line), m_File))
+    {
+        if (parseLine(line, samples[count]))
+            count++;
+    }
+
+    if (count < limit)
+        m_EOF = true;
+
+    return count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Madgwick filter
+/////////////////////////////////////////////////////////////////////////////
+void MadgwickFilter::reset()
+{
+    q[0] = 1;
+    q[1] = q[2] = q[3] = 0;
+}
+
+void MadgwickFilter::updateIMU(const double gyro[3], const double accel[3], double dt)
+{
+    double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    double gx = gyro[0], gy = gyro[1], gz = gyro[2];
+    double ax = accel[0], ay = accel[1], az = accel[2];
+
+    // Rate of change of quaternion from gyroscope
+    double qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
+    double qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
+    double qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
+    double qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+
+    double norm = std::sqrt(ax * ax + ay * ay + az * az);
+    if (norm > 0)
+    {
+        ax /= norm;
+        ay /= norm;
+        az /= norm;
+
+        double _2q0 = 2 * q0, _2q1 = 2 * q1, _2q2 = 2 * q2, _2q3 = 2 * q3;
+        double _4q0 = 4 * q0, _4q1 = 4 * q1, _4q2 = 4 * q2;
+        double _8q1 = 8 * q1, _8q2 = 8 * q2;
+        double q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+        // Gradient descent corrective step
+        double s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        double s1 = _4q1 * q3q3 - _2q3 * ax + 4 * q0q0 * q1 - _2q0 * ay - _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        double s2 = 4 * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        double s3 = 4 * q1q1 * q3 - _2q1 * ax + 4 * q2q2 * q3 - _2q2 * ay;
+        double sNorm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        if (sNorm > 0)
+        {
+            qDot1 -= m_Beta * s0 / sNorm;
+            qDot2 -= m_Beta * s1 / sNorm;
+            qDot3 -= m_Beta * s2 / sNorm;
+            qDot4 -= m_Beta * s3 / sNorm;
+        }
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    double qNorm = std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q[0] = q0 / qNorm;
+    q[1] = q1 / qNorm;
+    q[2] = q2 / qNorm;
+    q[3] = q3 / qNorm;
+}
+
+void MadgwickFilter::update(const double gyro[3], const double accel[3], const double mag[3], double dt)
+{
+    double mx = mag[0], my = mag[1], mz = mag[2];
+    double mNorm = std::sqrt(mx * mx + my * my + mz * mz);
+    double ax = accel[0], ay = accel[1], az = accel[2];
+    double aNorm = std::sqrt(ax * ax + ay * ay + az * az);
+
+    if (mNorm == 0 || aNorm == 0)
+    {
+        updateIMU(gyro, accel, dt);
+        return;
+    }
+
+    double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    double gx = gyro[0], gy = gyro[1], gz = gyro[2];
+
+    double qDot1 = 0.5 * (-q1 * gx - q2 * gy - q3 * gz);
+    double qDot2 = 0.5 * (q0 * gx + q2 * gz - q3 * gy);
+    double qDot3 = 0.5 * (q0 * gy - q1 * gz + q3 * gx);
+    double qDot4 = 0.5 * (q0 * gz + q1 * gy - q2 * gx);
+
+    ax /= aNorm;
+    ay /= aNorm;
+    az /= aNorm;
+    mx /= mNorm;
+    my /= mNorm;
+    mz /= mNorm;
+
+    double _2q0mx = 2 * q0 * mx, _2q0my = 2 * q0 * my, _2q0mz = 2 * q0 * mz, _2q1mx = 2 * q1 * mx;
+    double _2q0 = 2 * q0, _2q1 = 2 * q1, _2q2 = 2 * q2, _2q3 = 2 * q3;
+    double _2q0q2 = 2 * q0 * q2, _2q2q3 = 2 * q2 * q3;
+    double q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+    double q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+    double q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+    // Reference direction of Earth's magnetic field
+    double hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2 + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+    double hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1 + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+    double _2bx = std::sqrt(hx * hx + hy * hy);
+    double _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+    double _4bx = 2 * _2bx, _4bz = 2 * _2bz;
+
+    // Residuals of the gravity and magnetic field estimates
+    double fg1 = 2 * q1q3 - _2q0q2 - ax;
+    double fg2 = 2 * q0q1 + _2q2q3 - ay;
+    double fg3 = 1 - 2 * q1q1 - 2 * q2q2 - az;
+    double fm1 = _2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+    double fm2 = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+    double fm3 = _2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - mz;
+
+    double s0 = -_2q2 * fg1 + _2q1 * fg2 - _2bz * q2 * fm1 + (-_2bx * q3 + _2bz * q1) * fm2 + _2bx * q2 * fm3;
+    double s1 = _2q3 * fg1 + _2q0 * fg2 - 4 * q1 * fg3 + _2bz * q3 * fm1 + (_2bx * q2 + _2bz * q0) * fm2 +
+                (_2bx * q3 - _4bz * q1) * fm3;
+    double s2 = -_2q0 * fg1 + _2q3 * fg2 - 4 * q2 * fg3 + (-_4bx * q2 - _2bz * q0) * fm1 + (_2bx * q1 + _2bz * q3) * fm2 +
+                (_2bx * q0 - _4bz * q2) * fm3;
+    double s3 = _2q1 * fg1 + _2q2 * fg2 + (-_4bx * q3 + _2bz * q1) * fm1 + (-_2bx * q0 + _2bz * q2) * fm2 + _2bx * q1 * fm3;
+
+    double sNorm = std::sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+    if (sNorm > 0)
+    {
+        qDot1 -= m_Beta * s0 / sNorm;
+        qDot2 -= m_Beta * s1 / sNorm;
+        qDot3 -= m_Beta * s2 / sNorm;
+        qDot4 -= m_Beta * s3 / sNorm;
+    }
+
+    q0 += qDot1 * dt;
+    q1 += qDot2 * dt;
+    q2 += qDot3 * dt;
+    q3 += qDot4 * dt;
+
+    double qNorm = std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+    q[0] = q0 / qNorm;
+    q[1] = q1 / qNorm;
+    q[2] = q2 / qNorm;
+    q[3] = q3 / qNorm;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/// Acquisition
+/////////////////////////////////////////////////////////////////////////////
+Acquisition::~Acquisition()
+{
+    stop();
+    setRecordFile("");
+}
+
+bool Acquisition::start(std::unique_ptr<SampleSource> source, double rateHz)
+{
+    stop();
+
+    if (!source)
+        return false;
+
+    m_Source = std::move(source);
+    m_Source->configure(rateHz);
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Filter.reset();
+        m_LastTimestamp = -1;
+        resetAccumulator();
+    }
+
+    m_Running = true;
+    m_Thread = std::thread(&Acquisition::worker, this);
+    return true;
+}
+
+void Acquisition::stop()
+{
+    m_Running = false;
+    if (m_Thread.joinable())
+        m_Thread.join();
+    m_Source.reset();
+}
+
+void Acquisition::setOffsets(const double accel[3], const double gyro[3], const double mag[3])
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (int i = 0; i < 3; i++)
+    {
+        m_Offsets[0][i] = accel[i];
+        m_Offsets[1][i] = gyro[i];
+        m_Offsets[2][i] = mag[i];
+    }
+}
+
+void Acquisition::setBeta(double beta)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Filter.setBeta(beta);
+}
+
+void Acquisition::setMagneticAxisSigns(int x, int y, int z)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_MagSigns[0] = x < 0 ? -1 : 1;
+    m_MagSigns[1] = y < 0 ? -1 : 1;
+    m_MagSigns[2] = z < 0 ? -1 : 1;
+}
+
+bool Acquisition::setRecordFile(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_RecordFile)
+    {
+        fclose(m_RecordFile);
+        m_RecordFile = nullptr;
+    }
+
+    if (filename.empty())
+        return true;
+
+    m_RecordFile = fopen(filename.c_str(), "w");
+    return m_RecordFile != nullptr;
+}
+
+void Acquisition::resetAccumulator()
+{
+    double quaternion[4];
+    std::copy(m_Accumulator.quaternion, m_Accumulator.quaternion + 4, quaternion);
+    uint64_t busErrors = m_Accumulator.busErrors;
+
+    m_Accumulator = Snapshot();
+    std::copy(quaternion, quaternion + 4, m_Accumulator.quaternion);
+    m_Accumulator.busErrors = busErrors;
+    for (int i = 0; i < 3; i++)
+    {
+        m_Sum[0][i] = m_Sum[1][i] = m_Sum[2][i] = 0;
+        m_RawSum[0][i] = m_RawSum[1][i] = 0;
+        m_Accumulator.rawMagMin[i] = 1e9;
+        m_Accumulator.rawMagMax[i] = -1e9;
+    }
+    m_FirstTimestamp = -1;
+    m_CPUSeconds = 0;
+}
+
+void Acquisition::process(const Sample *samples, int count)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (int n = 0; n < count; n++)
+    {
+        const Sample &s = samples[n];
+        double accel[3], gyro[3], gyroRad[3], mag[3], alignedMag[3];
+
+        for (int i = 0; i < 3; i++)
+        {
+            accel[i] = s.accel[i] - m_Offsets[0][i];
+            gyro[i] = s.gyro[i] - m_Offsets[1][i];
+            gyroRad[i] = gyro[i] * DEG_TO_RAD;
+            mag[i] = s.mag[i] - m_Offsets[2][i];
+            alignedMag[i] = mag[i] * m_MagSigns[i];
+        }
+
+        double dt = (m_LastTimestamp < 0) ? 0 : s.timestamp - m_LastTimestamp;
+        m_LastTimestamp = s.timestamp;
+
+        if (dt > 0 && dt < 1)
+        {
+            if (s.hasMag)
+                m_Filter.update(gyroRad, accel, alignedMag, dt);
+            else
+                m_Filter.updateIMU(gyroRad, accel, dt);
+        }
+
+        for (int i = 0; i < 3; i++)
+        {
+            m_Sum[0][i] += accel[i];
+            m_Sum[1][i] += gyro[i];
+            m_RawSum[0][i] += s.accel[i];
+            m_RawSum[1][i] += s.gyro[i];
+            if (s.hasMag)
+            {
+                m_Sum[2][i] += mag[i];
+                m_Accumulator.rawMagMin[i] = std::min(m_Accumulator.rawMagMin[i], s.mag[i]);
+                m_Accumulator.rawMagMax[i] = std::max(m_Accumulator.rawMagMax[i], s.mag[i]);
+            }
+        }
+
+        if (s.hasMag)
+            m_Accumulator.magSamples++;
+        if (m_FirstTimestamp < 0)
+            m_FirstTimestamp = s.timestamp;
+        m_Accumulator.samples++;
+
+        if (m_RecordFile)
+            fprintf(m_RecordFile, "%.6f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f,%.3f,%.3f,%.3f\n", s.timestamp,
+                    s.accel[0], s.accel[1], s.accel[2], s.gyro[0], s.gyro[1], s.gyro[2], s.mag[0], s.mag[1], s.mag[2]);
+    }
+
+    if (count > 0)
+    {
+        m_Filter.getQuaternion(m_Accumulator.quaternion[0], m_Accumulator.quaternion[1], m_Accumulator.quaternion[2],
+                               m_Accumulator.quaternion[3]);
+        if (m_Accumulator.samples > 1 && m_LastTimestamp > m_FirstTimestamp)
+            m_Accumulator.sampleRate = (m_Accumulator.samples - 1) / (m_LastTimestamp - m_FirstTimestamp);
+    }
+}
+
+Snapshot Acquisition::fetch()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Snapshot result = m_Accumulator;
+    if (result.samples > 0)
+    {
+        for (int i = 0; i < 3; i++)
+        {
+            result.accel[i] = m_Sum[0][i] / result.samples;
+            result.gyro[i] = m_Sum[1][i] / result.samples;
+            result.rawAccel[i] = m_RawSum[0][i] / result.samples;
+            result.rawGyro[i] = m_RawSum[1][i] / result.samples;
+            result.mag[i] = result.magSamples > 0 ? m_Sum[2][i] / result.magSamples : 0;
+        }
+        result.cpuPerSample = m_CPUSeconds / result.samples;
+    }
+
+    resetAccumulator();
+    return result;
+}
+
+void Acquisition::worker()
+{
+    std::vector<Sample> burst(MAX_BURST_SAMPLES);
+
+    while (m_Running)
+    {
+        auto next = std::chrono::steady_clock::now() + std::chrono::duration<double>(m_Source->burstInterval());
+
+        double cpuStart = threadCPUTime();
+        int count = m_Source->readBurst(burst.data(), MAX_BURST_SAMPLES);
+        if (count > 0)
+            process(burst.data(), count);
+        double cpu = threadCPUTime() - cpuStart;
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_CPUSeconds += cpu;
+            if (count < 0)
+                m_Accumulator.busErrors++;
+        }
+
+        if (m_Source->endOfStream())
+        {
+            m_Running = false;
+            break;
+        }
+
+        std::this_thread::sleep_until(next);
+    }
+}
+
+}
@@ -0,0 +1,217 @@
+/*
+    ICM-20948 IMU Driver - Background acquisition and sensor fusion
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace IMUAcquisition
+{
+
+/**
+ * @brief One sample as delivered by the sensor.
+ * Acceleration in m/s², angular rate in deg/s, magnetic field in µT, timestamp in seconds.
+ */
+struct Sample
+{
+    double timestamp {0};
+    double accel[3] {0, 0, 0};
+    double gyro[3] {0, 0, 0};
+    double mag[3] {0, 0, 0};
+    bool hasMag {false};
+};
+
+/**
+ * @brief Source of sensor samples. Implementations drain whatever the sensor buffered since the last call.
+ */
+class SampleSource
+{
+    public:
+        virtual ~SampleSource() = default;
+
+        /** Configure the native output data rate. Returns the rate actually set in Hz. */
+        virtual double configure(double rateHz) = 0;
+
+        /** Read up to maxSamples buffered samples. Returns the number read, or -1 on bus error. */
+        virtual int readBurst(Sample *samples, int maxSamples) = 0;
+
+        /** Interval in seconds after which the source should be drained again. */
+        virtual double burstInterval() const = 0;
+
+        /** True once the source will never deliver another sample, the worker then stops. */
+        virtual bool endOfStream() const
+        {
+            return false;
+        }
+};
+
+/**
+ * @brief Replays samples recorded as CSV lines: t,ax,ay,az,gx,gy,gz[,mx,my,mz]
+ * When realtime is false, every call returns the next burst immediately which is used for offline benchmarks.
+ */
+class ReplaySampleSource : public SampleSource
+{
+    public:
+        explicit ReplaySampleSource(const std::string &filename, bool realtime = false);
+        virtual ~ReplaySampleSource() override;
+
+        bool isOpen() const
+        {
+            return m_File != nullptr;
+        }
+        virtual double configure(double rateHz) override;
+        virtual int readBurst(Sample *samples, int maxSamples) override;
+        virtual double burstInterval() const override;
+        virtual bool endOfStream() const override
+        {
+            return m_EOF;
+        }
+
+        /** Parse one CSV line, returns false if the line is not a sample. */
+        static bool parseLine(const char *line, Sample &sample);
+
+    private:
+        FILE *m_File {nullptr};
+        bool m_Realtime {false};
+        bool m_EOF {false};
+        double m_Rate {100};
+};
+
+/**
+ * @brief Madgwick gradient descent orientation filter, operating on gyro in rad/s.
+ * Falls back to the 6-axis update when no magnetometer reading is available.
+ */
+class MadgwickFilter
+{
+    public:
+        explicit MadgwickFilter(double beta = 0.1) : m_Beta(beta) {}
+
+        void reset();
+        void setBeta(double beta)
+        {
+            m_Beta = beta;
+        }
+
+        void update(const double gyro[3], const double accel[3], const double mag[3], double dt);
+        void updateIMU(const double gyro[3], const double accel[3], double dt);
+
+        /** Quaternion as i, j, k, w. */
+        void getQuaternion(double &i, double &j, double &k, double &w) const
+        {
+            i = q[1];
+            j = q[2];
+            k = q[3];
+            w = q[0];
+        }
+
+    private:
+        double m_Beta;
+        double q[4] {1, 0, 0, 0};
+};
+
+/**
+ * @brief Decimated result handed to the INDI thread.
+ * Means are taken over all samples acquired since the previous fetch.
+ */
+struct Snapshot
+{
+    uint32_t samples {0};
+    // Offset corrected means
+    double accel[3] {0, 0, 0};
+    double gyro[3] {0, 0, 0};
+    double mag[3] {0, 0, 0};
+    // Uncorrected means and magnetometer extrema, used for calibration
+    double rawAccel[3] {0, 0, 0};
+    double rawGyro[3] {0, 0, 0};
+    double rawMagMin[3] {0, 0, 0};
+    double rawMagMax[3] {0, 0, 0};
+    uint32_t magSamples {0};
+    // Latest fused orientation
+    double quaternion[4] {0, 0, 0, 1};
+    // Measured native rate and worker load
+    double sampleRate {0};
+    double cpuPerSample {0};
+    uint64_t busErrors {0};
+};
+
+/**
+ * @brief Drains a sample source in bursts from a dedicated thread and runs the fusion at the native rate.
+ */
+class Acquisition
+{
+    public:
+        Acquisition() = default;
+        ~Acquisition();
+
+        /** Start acquiring from the source. Ownership of the source is taken. The worker ends with the stream. */
+        bool start(std::unique_ptr<SampleSource> source, double rateHz);
+        void stop();
+        bool isRunning() const
+        {
+            return m_Running;
+        }
+
+        /** Offsets subtracted before fusion and averaging. */
+        void setOffsets(const double accel[3], const double gyro[3], const double mag[3]);
+        void setBeta(double beta);
+
+        /** Signs mapping the magnetometer axes onto the accelerometer/gyroscope frame for the fusion. */
+        void setMagneticAxisSigns(int x, int y, int z);
+
+        /** Record every acquired raw sample to a CSV file readable by ReplaySampleSource. Empty filename stops recording. */
+        bool setRecordFile(const std::string &filename);
+
+        /** Fetch the decimated result since the previous call. */
+        Snapshot fetch();
+
+        /** Process one burst synchronously. Used by the worker thread and by offline benchmarks. */
+        void process(const Sample *samples, int count);
+
+    private:
+        void worker();
+        void resetAccumulator();
+
+        std::unique_ptr<SampleSource> m_Source;
+        std::thread m_Thread;
+        std::atomic<bool> m_Running {false};
+
+        std::mutex m_Mutex;
+        MadgwickFilter m_Filter;
+        double m_Offsets[3][3] {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+        double m_MagSigns[3] {1, 1, 1};
+        double m_LastTimestamp {-1};
+        FILE *m_RecordFile {nullptr};
+
+        // Accumulators since the last fetch
+        Snapshot m_Accumulator;
+        double m_Sum[3][3] {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+        double m_RawSum[2][3] {{0, 0, 0}, {0, 0, 0}};
+        double m_FirstTimestamp {-1};
+        double m_CPUSeconds {0};
+};
+
+}
@@ -0,0 +1,176 @@
+/*
+    ICM-20948 IMU Driver - Offline acquisition and fusion tests
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "imu_acquisition.h"
+
+using namespace IMUAcquisition;
+
+// Write a recording of a level sensor turning about Z at a constant rate, with sensor noise.
+static std::string writeRecording(double rate, double seconds, double yawRateDeg)
+{
+    std::string filename = testing::TempDir() + "icm20948_replay.csv";
+    FILE *fp = fopen(filename.c_str(), "w");
+
+    std::mt19937 rng(42);
+    std::normal_distribution<double> accelNoise(0, 0.05), gyroNoise(0, 0.2), magNoise(0, 0.5);
+
+    const double magNorth = 20, magDown = -40;
+    int count = static_cast<int>(rate * seconds);
+    for (int i = 0; i < count; i++)
+    {
+        double t = i / rate;
+        double yaw = yawRateDeg * t * M_PI / 180.0;
+        // Magnetic field as seen by the rotated sensor
+        double mx = magNorth * cos(yaw), my = -magNorth * sin(yaw), mz = magDown;
+        fprintf(fp, "%.6f,%.5f,%.5f,%.5f,%.5f,%.5f,%.5f,%.3f,%.3f,%.3f\n", t,
+                accelNoise(rng), accelNoise(rng), 9.80665 + accelNoise(rng),
+                gyroNoise(rng), gyroNoise(rng), yawRateDeg + gyroNoise(rng),
+                mx + magNoise(rng), my + magNoise(rng), mz + magNoise(rng));
+    }
+
+    fclose(fp);
+    return filename;
+}
+
+static double yawFromQuaternion(const double q[4])
+{
+    // q is i, j, k, w
+    return atan2(2 * (q[3] * q[2] + q[0] * q[1]), 1 - 2 * (q[1] * q[1] + q[2] * q[2]));
+}
+
+TEST(ReplaySampleSource, ParseLine)
+{
+    Sample sample;
+    ASSERT_TRUE(ReplaySampleSource::parseLine("1.5,0.1,0.2,9.8,1,2,3,10,20,30", sample));
+    EXPECT_DOUBLE_EQ(sample.timestamp, 1.5);
+    EXPECT_DOUBLE_EQ(sample.accel[2], 9.8);
+    EXPECT_DOUBLE_EQ(sample.gyro[1], 2);
+    EXPECT_TRUE(sample.hasMag);
+    EXPECT_DOUBLE_EQ(sample.mag[2], 30);
+
+    ASSERT_TRUE(ReplaySampleSource::parseLine("1.5,0.1,0.2,9.8,1,2,3", sample));
+    EXPECT_FALSE(sample.hasMag);
+
+    EXPECT_FALSE(ReplaySampleSource::parseLine("# t,ax,ay,az", sample));
+}
+
+TEST(Acquisition, DecimatesWithOffsets)
+{
+    Acquisition acquisition;
+    double accelOffset[3] = {0.1, 0.2, 0.3}, gyroOffset[3] = {1, 1, 1}, magOffset[3] = {0, 0, 0};
+    acquisition.setOffsets(accelOffset, gyroOffset, magOffset);
+
+    std::vector<Sample> samples(10);
+    for (size_t i = 0; i < samples.size(); i++)
+    {
+        samples[i].timestamp = i * 0.01;
+        samples[i].accel[0] = i;
+        samples[i].gyro[2] = 2;
+    }
+    acquisition.process(samples.data(), samples.size());
+
+    Snapshot snapshot = acquisition.fetch();
+    EXPECT_EQ(snapshot.samples, 10u);
+    EXPECT_NEAR(snapshot.accel[0], 4.5 - 0.1, 1e-9);
+    EXPECT_NEAR(snapshot.rawAccel[0], 4.5, 1e-9);
+    EXPECT_NEAR(snapshot.gyro[2], 1, 1e-9);
+    EXPECT_NEAR(snapshot.sampleRate, 100, 1e-6);
+
+    // Accumulators restart after each fetch
+    EXPECT_EQ(acquisition.fetch().samples, 0u);
+}
+
+TEST(Acquisition, ReplayFusionAccuracyAndCost)
+{
+    const double rate = 225, seconds = 60, yawRate = 6;
+    std::string filename = writeRecording(rate, seconds, yawRate);
+
+    ReplaySampleSource source(filename);
+    ASSERT_TRUE(source.isOpen());
+
+    Acquisition acquisition;
+    std::vector<Sample> burst(64);
+    double maxError = 0;
+    uint32_t total = 0;
+    double elapsed = 0;
+
+    while (!source.endOfStream())
+    {
+        int count = source.readBurst(burst.data(), burst.size());
+        if (count <= 0)
+            break;
+
+        auto start = std::chrono::steady_clock::now();
+        acquisition.process(burst.data(), count);
+        elapsed += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        Snapshot snapshot = acquisition.fetch();
+        total += snapshot.samples;
+
+        // Skip the initial convergence of the filter
+        double t = burst[count - 1].timestamp;
+        if (t > 10)
+        {
+            double truth = remainder(yawRate * t * M_PI / 180.0, 2 * M_PI);
+            double error = std::fabs(remainder(yawFromQuaternion(snapshot.quaternion) - truth, 2 * M_PI));
+            maxError = std::max(maxError, error);
+        }
+    }
+
+    EXPECT_EQ(total, static_cast<uint32_t>(rate * seconds));
+    EXPECT_LT(maxError * 180.0 / M_PI, 3.0);
+
+    std::cout << "Fused " << total << " samples, max heading error " << maxError * 180.0 / M_PI
+              << " deg, " << elapsed / total * 1e6 << " us per sample" << std::endl;
+
+    remove(filename.c_str());
+}
+
+TEST(Acquisition, WorkerStopsAtEndOfReplay)
+{
+    std::string filename = writeRecording(100, 2, 0);
+
+    Acquisition acquisition;
+    ASSERT_TRUE(acquisition.start(std::unique_ptr<SampleSource>(new ReplaySampleSource(filename)), 100));
+
+    // The worker leaves on its own once the recording is exhausted
+    for (int i = 0; i < 500 && acquisition.isRunning(); i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(acquisition.isRunning());
+    EXPECT_EQ(acquisition.fetch().samples, 200u);
+
+    acquisition.stop();
+    remove(filename.c_str());
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -28,10 +28,9 @@
 
 #include "image/image.hpp"
 #include "core/still_options.hpp"
-#include "core/rpicam_encoder.hpp"
-#include "output/output.hpp"
 
 #include <libcamera/camera_manager.h>
+#include <libcamera/formats.h>
 
 #include <algorithm>
 #include <chrono>
@@ -134,9 +133,9 @@ void INDILibCamera::shutdownVideo()
 int INDILibCamera::getColorspaceFlags(std::string const &codec)
 {
     if (codec == "mjpeg" || codec == "yuv420")
-        return RPiCamEncoder::FLAG_VIDEO_JPEG_COLOURSPACE;
+        return RPiCamApp::FLAG_VIDEO_JPEG_COLOURSPACE;
     else
-        return RPiCamEncoder::FLAG_VIDEO_NONE;
+        return RPiCamApp::FLAG_VIDEO_NONE;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -145,19 +144,27 @@ int INDILibCamera::getColorspaceFlags(std::string const &codec)
 void INDILibCamera::workerStreamVideo(const std::atomic_bool &isAboutToQuit, double framerate)
 {
     LOGF_INFO("Starting video stream at %.2f fps", framerate);
-    RPiCamEncoder app;
+    RPiCamINDIVideoApp app;
     auto options = app.GetOptions();
     configureVideoOptions(options, framerate);
-    std::unique_ptr<Output> output = std::unique_ptr<Output>(Output::Create(options));
-    app.SetEncodeOutputReadyCallback(std::bind(&INDILibCamera::outputReady, this, std::placeholders::_1, std::placeholders::_2,
-                                     std::placeholders::_3, std::placeholders::_4));
-    app.SetMetadataReadyCallback(std::bind(&INDILibCamera::metadataReady, this, std::placeholders::_1));
+
+    // The ISP converts: colour sensors get packed RGB (BGR888 is R, G, B in memory) and mono sensors the luma
+    // plane of YUV420, so frames only lose the padding of their rows on their way to the streamer. rpicam only
+    // configures RGB on the still stream, triple buffered here to stream.
+    bool colour = m_pixel_format != INDI_MONO;
+    if (colour)
+    {
+        options->Set().width = PrimaryCCD.getSubW();
+        options->Set().height = PrimaryCCD.getSubH();
+    }
 
     try
     {
         app.OpenCamera();
-        app.ConfigureVideo(getColorspaceFlags(options->Get().codec));
-        app.StartEncoder();
+        if (colour)
+            app.ConfigureStill(RPiCamApp::FLAG_STILL_BGR | RPiCamApp::FLAG_STILL_TRIPLE_BUFFER);
+        else
+            app.ConfigureVideo(getColorspaceFlags(options->Get().codec));
         app.StartCamera();
     }
     catch (std::exception &e)
@@ -167,19 +174,34 @@ void INDILibCamera::workerStreamVideo(const std::atomic_bool &isAboutToQuit, dou
         return;
     }
 
+    StreamInfo info;
+    libcamera::Stream *stream = colour ? app.StillStream(&info) : app.VideoStream(&info);
+    libcamera::PixelFormat const expected = colour ? libcamera::formats::BGR888 : libcamera::formats::YUV420;
+    if (stream == nullptr || info.pixel_format != expected)
+    {
+        LOGF_ERROR("Unsupported video format %s", info.pixel_format.toString().c_str());
+        app.StopCamera();
+        app.Teardown();
+        shutdownVideo();
+        return;
+    }
+
+    Streamer->setPixelFormat(colour ? INDI_RGB : INDI_MONO);
+    Streamer->setSize(info.width, info.height);
+
     if (m_LiveVideoWidth <= 0)
     {
         m_LiveVideoWidth = PrimaryCCD.getSubW();
         m_LiveVideoHeight = PrimaryCCD.getSubH();
         PrimaryCCD.setBin(1, 1);
         PrimaryCCD.setFrame(0, 0, m_LiveVideoWidth, m_LiveVideoHeight);
-        Streamer->setPixelFormat(INDI_JPG);
-        Streamer->setSize(m_LiveVideoWidth, m_LiveVideoHeight);
     }
 
+    LibCameraFrameStatistics statistics;
+
     while (!isAboutToQuit)
     {
-        RPiCamEncoder::Msg msg = app.Wait();
+        RPiCamApp::Msg msg = app.Wait();
 
         if (msg.type == RPiCamApp::MsgType::Timeout)
         {
@@ -188,53 +210,81 @@ void INDILibCamera::workerStreamVideo(const std::atomic_bool &isAboutToQuit, dou
             app.StartCamera();
             continue;
         }
-        else if (msg.type == RPiCamEncoder::MsgType::Quit)
+        else if (msg.type == RPiCamApp::MsgType::Quit)
         {
-            return;
+            break;
         }
-        else if (msg.type != RPiCamEncoder::MsgType::RequestComplete)
+        else if (msg.type != RPiCamApp::MsgType::RequestComplete)
         {
             LOGF_ERROR("Video Streaming failed: %d", msg.type);
             shutdownVideo();
-            return;
+            break;
         }
 
-        CompletedRequestPtr &completed_request = std::get<CompletedRequestPtr>(msg.payload);
-        //auto completed_request = std::get<CompletedRequestPtr>(msg.payload);
-        app.EncodeBuffer(completed_request, app.VideoStream());
-    }
+        double cpuStart = LibCameraFrames::threadCPUTime();
+        std::shared_ptr<LibCameraFrame> frame;
 
-    app.StopCamera();
-    app.StopEncoder();
-    app.Teardown();
-}
+        // The request is queued again as soon as its planes are packed, before the streamer gets the frame
+        {
+            auto payload = std::move(std::get<CompletedRequestPtr>(msg.payload));
+            BufferReadSync r(&app, payload->buffers[stream]);
+            const std::vector<libcamera::Span<uint8_t>> mem = r.Get();
 
-/////////////////////////////////////////////////////////////////////////////
-///
-/////////////////////////////////////////////////////////////////////////////
-void INDILibCamera::outputReady(void *mem, size_t size, int64_t timestamp_us, bool keyframe)
-{
-    INDI_UNUSED(timestamp_us);
+            LibCameraFrames::FramePlane plane;
+            plane.data = mem[0].data();
+            plane.width = info.width;
+            plane.height = info.height;
+            plane.stride = info.stride;
+            plane.bytesPerPixel = colour ? 3 : 1;
 
-    if (!keyframe)
-        return;
+            frame = m_FramePool.acquire(LibCameraFrames::packedSize(plane));
+            if (!frame)
+                continue;
+
+            LibCameraFrames::packRows(plane, frame->data.data());
+            frame->metadata = metadataReady(payload->metadata);
+        }
+
+        uint64_t timestamp = 0;
+        if (frame->metadata.sensorTimestamp)
+            timestamp = LibCameraFrames::toStreamTime(LibCameraFrames::toUnixTime(*frame->metadata.sensorTimestamp));
 
-    // Read buffer from memory
-    std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
+        std::unique_lock<std::mutex> ccdguard(ccdBufferLock);
+        Streamer->newFrame(frame->data.data(), frame->size, timestamp);
+        ccdguard.unlock();
 
-    Streamer->newFrame(static_cast<uint8_t*>(mem), size);
+        statistics.add(frame->metadata, LibCameraFrames::threadCPUTime() - cpuStart);
+    }
+
+    LOGF_INFO("Video stream: %u frames at %.2f fps, %.2f ms CPU per frame, %u dropped, %u out of order.",
+              statistics.frames(), statistics.frameRate(), statistics.cpuPerFrame(), statistics.dropped(),
+              statistics.outOfOrder());
 
-    // We are done with writing to CCD buffer
-    ccdguard.unlock();
+    app.StopCamera();
+    app.Teardown();
 }
 
 /////////////////////////////////////////////////////////////////////////////
 ///
 /////////////////////////////////////////////////////////////////////////////
-void INDILibCamera::metadataReady(libcamera::ControlList &metadata)
+LibCameraFrameMetadata INDILibCamera::metadataReady(const libcamera::ControlList &metadata)
 {
-    // TODO could this metadata be useful?
-    INDI_UNUSED(metadata);
+    LibCameraFrameMetadata frameMetadata;
+
+    if (auto value = metadata.get(controls::SensorTimestamp))
+        frameMetadata.sensorTimestamp = *value;
+    if (auto value = metadata.get(controls::ExposureTime))
+        frameMetadata.exposureTime = *value;
+    if (auto value = metadata.get(controls::FrameDuration))
+        frameMetadata.frameDuration = *value;
+    if (auto value = metadata.get(controls::AnalogueGain))
+        frameMetadata.analogueGain = *value;
+    if (auto value = metadata.get(controls::ColourTemperature))
+        frameMetadata.colourTemperature = *value;
+
+    std::lock_guard<std::mutex> lock(m_FrameMetadataLock);
+    m_FrameMetadata = frameMetadata;
+    return frameMetadata;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -315,6 +365,7 @@ void INDILibCamera::workerExposure(const std::atomic_bool &isAboutToQuit, float
 
             // Copy metadata before releasing payload
             frameMetadata = payload->metadata;
+            metadataReady(frameMetadata);
         }
         catch (std::exception &e)
         {
@@ -1001,7 +1052,7 @@ void INDILibCamera::configureVideoOptions(VideoOptions *options, double framerat
     options->Set().camera = m_CameraIndex;
     options->Set().nopreview = true;
 
-    options->Set().codec = "mjpeg";
+    options->Set().codec = "yuv420";
     options->Set().brightness = AdjustmentNP[AdjustBrightness].getValue();
     options->Set().contrast = AdjustmentNP[AdjustContrast].getValue();
     options->Set().saturation = AdjustmentNP[AdjustSaturation].getValue();
@@ -1353,6 +1404,32 @@ void INDILibCamera::addFITSKeywords(INDI::CCDChip * targetChip, std::vector<INDI
             + std::to_string(m_black_levels[3]);
     }
     fitsKeywords.push_back({"BLACKLEVEL", black_level_str.c_str(), "CCD Black Levels"});
+
+    LibCameraFrameMetadata metadata;
+    {
+        std::lock_guard<std::mutex> lock(m_FrameMetadataLock);
+        metadata = m_FrameMetadata;
+    }
+
+    if (metadata.sensorTimestamp)
+    {
+        // Date the frame from the start of its exposure on the sensor rather than from the request
+        int64_t unixTime = LibCameraFrames::toUnixTime(*metadata.sensorTimestamp);
+        std::string dateObs = LibCameraFrames::toISOTime(unixTime);
+        auto record = std::find_if(fitsKeywords.begin(), fitsKeywords.end(), [](const INDI::FITSRecord & r)
+        {
+            return r.key() == "DATE-OBS";
+        });
+        if (record != fitsKeywords.end())
+            *record = INDI::FITSRecord("DATE-OBS", dateObs.c_str(), "UTC start date of observation");
+        fitsKeywords.push_back({"SENSTIME", static_cast<int64_t>(*metadata.sensorTimestamp), "Sensor timestamp, ns"});
+    }
+    if (metadata.exposureTime)
+        fitsKeywords.push_back({"SENSEXP", *metadata.exposureTime / 1e6, 6, "Sensor exposure time, s"});
+    if (metadata.analogueGain)
+        fitsKeywords.push_back({"AGAIN", static_cast<double>(*metadata.analogueGain), 3, "Analogue gain"});
+    if (metadata.colourTemperature)
+        fitsKeywords.push_back({"COLORTMP", static_cast<int64_t>(*metadata.colourTemperature), "Colour temperature, K"});
 }
 
 /////////////////////////////////////////////////////////////////////////////
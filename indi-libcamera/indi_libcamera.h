@@ -27,8 +27,10 @@
 #include <mutex>
 
 #include "core/rpicam_app.hpp"
-#include "core/rpicam_encoder.hpp"
 #include "core/still_options.hpp"
+#include "core/video_options.hpp"
+
+#include "indi_libcamera_frames.h"
 
 #include <vector>
 
@@ -70,6 +72,17 @@ class RPiCamINDIApp : public RPiCamApp
         }
 };
 
+class RPiCamINDIVideoApp : public RPiCamApp
+{
+    public:
+        RPiCamINDIVideoApp() : RPiCamApp(std::make_unique<VideoOptions>()) {}
+
+        VideoOptions *GetOptions() const
+        {
+            return static_cast<VideoOptions *>(options_.get());
+        }
+};
+
 class SingleWorker;
 class INDILibCamera : public INDI::CCD
 {
@@ -116,8 +129,8 @@ class INDILibCamera : public INDI::CCD
         INDI::SingleThreadPool m_Worker;
         void workerStreamVideo(const std::atomic_bool &isAboutToQuit, double framerate);
         void workerExposure(const std::atomic_bool &isAboutToQuit, float duration);
-        void outputReady(void *mem, size_t size, int64_t timestamp_us, bool keyframe);
-        void metadataReady(libcamera::ControlList &metadata);
+        /** Keeps the metadata of a completed request for the FITS header, and returns it */
+        LibCameraFrameMetadata metadataReady(const libcamera::ControlList &metadata);
         bool SetCaptureFormat(uint8_t index) override;
         void initSwitch(INDI::PropertySwitch &switchSP, int n, const char **names);
 
@@ -166,6 +179,11 @@ class INDILibCamera : public INDI::CCD
         // std::unique_ptr<RPiCamApp> m_CameraApp;
         // std::unique_ptr<RPiCamEncoder> m_CameraEncoder;
 
+        // Metadata of the last frame, and frames of the video stream
+        LibCameraFrameMetadata m_FrameMetadata;
+        std::mutex m_FrameMetadataLock;
+        LibCameraFramePool m_FramePool {2};
+
         INDI_PIXEL_FORMAT m_pixel_format {INDI_BAYER_RGGB};
         bool m_csi_format_packed {false};
         unsigned int m_bit_depth {8};
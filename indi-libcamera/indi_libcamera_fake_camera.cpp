@@ -0,0 +1,88 @@
+/*
+    INDI LibCamera Fake Camera
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "indi_libcamera_fake_camera.h"
+
+#include <ctime>
+#include <thread>
+
+LibCameraFakeCamera::LibCameraFakeCamera(uint32_t width, uint32_t height, double framerate, bool colour, size_t buffers)
+    : m_Width(width), m_Height(height), m_BytesPerPixel(colour ? 3 : 1),
+      m_Stride((width * m_BytesPerPixel + 63) / 64 * 64),
+      m_FrameDuration(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1 / framerate))),
+      // Chroma planes follow the luma plane in YUV420
+      m_Buffers(buffers, std::vector<uint8_t>(static_cast<size_t>(m_Stride) * height * (colour ? 2 : 3) / 2)),
+      m_Next(Clock::now() + m_FrameDuration)
+{
+}
+
+uint8_t LibCameraFakeCamera::sample(uint32_t frame, uint32_t x, uint32_t y, uint32_t channel)
+{
+    return static_cast<uint8_t>(x + 3 * y + frame + 85 * channel);
+}
+
+LibCameraFakeCamera::Request LibCameraFakeCamera::wait()
+{
+    if (dropEvery > 0 && m_Sequence > 0 && m_Sequence % dropEvery == 0)
+    {
+        m_Next += m_FrameDuration;
+        m_Sequence++;
+    }
+
+    std::this_thread::sleep_until(m_Next);
+
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    int64_t const frameDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(m_FrameDuration).count();
+    // Late waits still get the timestamp of when the frame was due
+    int64_t const late = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - m_Next).count();
+
+    std::vector<uint8_t> &buffer = m_Buffers[frames % m_Buffers.size()];
+    for (uint32_t row = 0; row < m_Height; row++)
+        for (uint32_t column = 0; column < m_Width; column++)
+            for (uint32_t channel = 0; channel < m_BytesPerPixel; channel++)
+                buffer[static_cast<size_t>(row) * m_Stride + column * m_BytesPerPixel + channel] =
+                    sample(m_Sequence, column, row, channel);
+
+    if (m_BytesPerPixel == 1)
+    {
+        uint8_t *u = buffer.data() + static_cast<size_t>(m_Stride) * m_Height;
+        uint8_t *v = u + static_cast<size_t>(m_Stride / 2) * (m_Height / 2);
+        for (uint32_t row = 0; row < m_Height / 2; row++)
+            for (uint32_t column = 0; column < m_Width / 2; column++)
+            {
+                u[static_cast<size_t>(row) * (m_Stride / 2) + column] = static_cast<uint8_t>(128 + column - row);
+                v[static_cast<size_t>(row) * (m_Stride / 2) + column] = static_cast<uint8_t>(128 - column + row);
+            }
+    }
+
+    Request request;
+    request.plane = {buffer.data(), m_Width, m_Height, m_Stride, m_BytesPerPixel};
+    request.metadata.sensorTimestamp = (now.tv_sec * 1000000000LL + now.tv_nsec) - late - frameDuration;
+    request.metadata.exposureTime = static_cast<int32_t>(frameDuration / 1000);
+    request.metadata.frameDuration = frameDuration / 1000;
+    request.metadata.analogueGain = 1.0f;
+    request.metadata.colourTemperature = 5500;
+
+    m_Next += m_FrameDuration;
+    m_Sequence++;
+    frames++;
+    return request;
+}
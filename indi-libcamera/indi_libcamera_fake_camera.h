@@ -0,0 +1,66 @@
+/*
+    INDI LibCamera Fake Camera
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include "indi_libcamera_frames.h"
+
+#include <chrono>
+
+/*
+    A video stream with the timing of a pipeline handler, without hardware.
+
+    Frames come one frame duration apart into a ring of buffers with padded rows, as the ISP writes them,
+    each with the metadata of its request: RGB888 for colour, YUV420 otherwise. Waits for a frame sleep
+    until it is due.
+*/
+class LibCameraFakeCamera
+{
+    public:
+        struct Request
+        {
+            /** The RGB frame, or the luma plane */
+            LibCameraFrames::FramePlane plane;
+            LibCameraFrameMetadata metadata;
+        };
+
+        LibCameraFakeCamera(uint32_t width, uint32_t height, double framerate, bool colour, size_t buffers = 4);
+
+        /** The next completed request, its planes are valid until the buffer is used again */
+        Request wait();
+
+        /** Channel of pixel x, y of frame, 0 alone for the luma */
+        static uint8_t sample(uint32_t frame, uint32_t x, uint32_t y, uint32_t channel);
+
+        /** A frame is lost every dropEvery frames, never if 0 */
+        uint32_t dropEvery {0};
+
+        /** Frames delivered */
+        uint32_t frames {0};
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        uint32_t m_Width, m_Height, m_BytesPerPixel, m_Stride;
+        Clock::duration m_FrameDuration;
+        std::vector<std::vector<uint8_t>> m_Buffers;
+        Clock::time_point m_Next;
+        uint32_t m_Sequence {0};
+};
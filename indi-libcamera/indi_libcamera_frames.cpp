@@ -0,0 +1,192 @@
+/*
+    INDI LibCamera Frames
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "indi_libcamera_frames.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+// Seconds from January 1, 1 AD to the Unix epoch
+constexpr uint64_t STREAM_EPOCH_OFFSET = 62135596800ULL;
+
+int64_t clockTime(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////
+int64_t LibCameraFrames::toUnixTime(int64_t sensorTimestamp)
+{
+    int64_t const boot = clockTime(CLOCK_BOOTTIME);
+    int64_t const real = clockTime(CLOCK_REALTIME);
+    return sensorTimestamp + (real - boot);
+}
+
+uint64_t LibCameraFrames::toStreamTime(int64_t unixTime)
+{
+    return static_cast<uint64_t>(unixTime / 1000) + STREAM_EPOCH_OFFSET * 1000000ULL;
+}
+
+std::string LibCameraFrames::toISOTime(int64_t unixTime)
+{
+    time_t const seconds = static_cast<time_t>(unixTime / 1000000000LL);
+    int const milliseconds = static_cast<int>((unixTime / 1000000LL) % 1000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+
+    char date[32], iso[40];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", &utc);
+    snprintf(iso, sizeof(iso), "%s.%03d", date, milliseconds);
+    return iso;
+}
+
+double LibCameraFrames::threadCPUTime()
+{
+    return clockTime(CLOCK_THREAD_CPUTIME_ID) / 1e6;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////
+size_t LibCameraFrames::packedSize(const FramePlane &plane)
+{
+    return static_cast<size_t>(plane.width) * plane.height * plane.bytesPerPixel;
+}
+
+void LibCameraFrames::packRows(const FramePlane &plane, uint8_t *dst)
+{
+    size_t const rowBytes = static_cast<size_t>(plane.width) * plane.bytesPerPixel;
+
+    if (plane.stride == rowBytes)
+    {
+        memcpy(dst, plane.data, rowBytes * plane.height);
+        return;
+    }
+
+    for (uint32_t row = 0; row < plane.height; row++)
+        memcpy(dst + row * rowBytes, plane.data + static_cast<size_t>(row) * plane.stride, rowBytes);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////
+LibCameraFramePool::LibCameraFramePool(size_t frames) : m_State(std::make_shared<State>())
+{
+    for (size_t i = 0; i < frames; i++)
+        m_State->free.push_back(std::make_unique<LibCameraFrame>());
+}
+
+std::shared_ptr<LibCameraFrame> LibCameraFramePool::acquire(size_t bytes)
+{
+    std::unique_ptr<LibCameraFrame> frame;
+    {
+        std::lock_guard<std::mutex> lock(m_State->lock);
+        if (m_State->free.empty())
+            return nullptr;
+
+        frame = std::move(m_State->free.back());
+        m_State->free.pop_back();
+
+        if (frame->data.size() < bytes)
+        {
+            frame->data.resize(bytes);
+            m_State->allocations++;
+        }
+    }
+
+    frame->size = bytes;
+    frame->metadata = LibCameraFrameMetadata();
+
+    // The frame returns to the pool, which it keeps alive, once the last reference is dropped
+    std::shared_ptr<State> state = m_State;
+    return std::shared_ptr<LibCameraFrame>(frame.release(), [state](LibCameraFrame * released)
+    {
+        std::lock_guard<std::mutex> lock(state->lock);
+        state->free.emplace_back(released);
+    });
+}
+
+size_t LibCameraFramePool::available() const
+{
+    std::lock_guard<std::mutex> lock(m_State->lock);
+    return m_State->free.size();
+}
+
+size_t LibCameraFramePool::allocations() const
+{
+    std::lock_guard<std::mutex> lock(m_State->lock);
+    return m_State->allocations;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+///
+/////////////////////////////////////////////////////////////////////////////
+void LibCameraFrameStatistics::add(const LibCameraFrameMetadata &metadata, double cpuTime)
+{
+    m_Frames++;
+    m_CPUTime += cpuTime;
+
+    if (!metadata.sensorTimestamp)
+    {
+        m_Untimed++;
+        return;
+    }
+
+    int64_t const timestamp = *metadata.sensorTimestamp;
+    if (m_Timed == 0)
+        m_First = m_Last = timestamp;
+    else if (timestamp <= m_Last)
+    {
+        m_OutOfOrder++;
+        return;
+    }
+    else
+    {
+        if (metadata.frameDuration && *metadata.frameDuration > 0)
+        {
+            double const periods = (timestamp - m_Last) / (*metadata.frameDuration * 1000.0);
+            if (periods > 1.5)
+                m_Dropped += static_cast<uint32_t>(std::lround(periods)) - 1;
+        }
+        m_Last = timestamp;
+    }
+    m_Timed++;
+}
+
+void LibCameraFrameStatistics::reset()
+{
+    *this = LibCameraFrameStatistics();
+}
+
+double LibCameraFrameStatistics::frameRate() const
+{
+    if (m_Timed < 2 || m_Last <= m_First)
+        return 0;
+    return (m_Timed - 1) * 1e9 / (m_Last - m_First);
+}
@@ -0,0 +1,159 @@
+/*
+    INDI LibCamera Frames
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+/*
+    Per frame metadata of a completed request, as reported by the pipeline handler.
+*/
+struct LibCameraFrameMetadata
+{
+    /** Start of the exposure of the first row, ns of CLOCK_BOOTTIME */
+    std::optional<int64_t> sensorTimestamp;
+    /** Exposure time actually used, us */
+    std::optional<int32_t> exposureTime;
+    /** Frame duration, us */
+    std::optional<int64_t> frameDuration;
+    std::optional<float> analogueGain;
+    /** Estimated colour temperature, K */
+    std::optional<int32_t> colourTemperature;
+};
+
+namespace LibCameraFrames
+{
+/** Sensor timestamp to ns since the Unix epoch, using the current offset of CLOCK_REALTIME to CLOCK_BOOTTIME */
+int64_t toUnixTime(int64_t sensorTimestamp);
+/** ns since the Unix epoch to us since January 1, 1 AD, the epoch of the streamer timestamps */
+uint64_t toStreamTime(int64_t unixTime);
+/** ns since the Unix epoch to YYYY-MM-DDThh:mm:ss.sss, UTC */
+std::string toISOTime(int64_t unixTime);
+
+/** CPU time used by the calling thread, ms */
+double threadCPUTime();
+
+/*
+    A frame as mapped from the buffer of the video stream: rows of width pixels, stride bytes apart. Packed
+    RGB from the ISP for colour sensors, 3 bytes per pixel, the luma plane of YUV420 for mono ones.
+*/
+struct FramePlane
+{
+    const uint8_t *data {nullptr};
+    uint32_t width {0}, height {0};
+    uint32_t stride {0};
+    uint32_t bytesPerPixel {1};
+};
+
+/** Bytes packRows writes for a frame */
+size_t packedSize(const FramePlane &plane);
+
+/** Copies the rows of a frame for the streamer, without their padding */
+void packRows(const FramePlane &plane, uint8_t *dst);
+}
+
+/*
+    A frame handed to the streamer, and the metadata of the request it came from.
+*/
+struct LibCameraFrame
+{
+    std::vector<uint8_t> data;
+    size_t size {0};
+    LibCameraFrameMetadata metadata;
+};
+
+/*
+    A fixed number of frames, kept across streams so that frames are not allocated while streaming. A frame
+    goes back to the pool when its last reference is dropped, and only grows when a larger one is needed.
+*/
+class LibCameraFramePool
+{
+    public:
+        explicit LibCameraFramePool(size_t frames);
+
+        /** A frame of at least bytes, or nullptr if all frames are in use */
+        std::shared_ptr<LibCameraFrame> acquire(size_t bytes);
+
+        size_t available() const;
+        /** Times a frame had to grow */
+        size_t allocations() const;
+
+    private:
+        struct State
+        {
+            mutable std::mutex lock;
+            std::vector<std::unique_ptr<LibCameraFrame>> free;
+            size_t allocations {0};
+        };
+
+        std::shared_ptr<State> m_State;
+};
+
+/*
+    Timing of a stream of frames, from their sensor timestamps, and the CPU spent on each.
+*/
+class LibCameraFrameStatistics
+{
+    public:
+        void add(const LibCameraFrameMetadata &metadata, double cpuTime);
+        void reset();
+
+        uint32_t frames() const
+        {
+            return m_Frames;
+        }
+        /** Frames without a sensor timestamp */
+        uint32_t untimed() const
+        {
+            return m_Untimed;
+        }
+        /** Frames not after the one before */
+        uint32_t outOfOrder() const
+        {
+            return m_OutOfOrder;
+        }
+        /** Frames missing between two frames, from their frame duration */
+        uint32_t dropped() const
+        {
+            return m_Dropped;
+        }
+        /** Mean over all timed frames */
+        double frameRate() const;
+        /** Mean CPU time per frame, ms */
+        double cpuPerFrame() const
+        {
+            return m_Frames > 0 ? m_CPUTime / m_Frames : 0;
+        }
+
+    private:
+        uint32_t m_Frames {0};
+        uint32_t m_Untimed {0};
+        uint32_t m_OutOfOrder {0};
+        uint32_t m_Dropped {0};
+        uint32_t m_Timed {0};
+        int64_t m_First {0}, m_Last {0};
+        double m_CPUTime {0};
+};
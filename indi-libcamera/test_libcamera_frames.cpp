@@ -0,0 +1,190 @@
+/*
+    INDI LibCamera Frames tests
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <gtest/gtest.h>
+
+#include "indi_libcamera_frames.h"
+#include "indi_libcamera_fake_camera.h"
+
+#include <ctime>
+#include <iostream>
+
+static int64_t now(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+TEST(LibCameraFrames, PackLuma)
+{
+    LibCameraFakeCamera camera(100, 50, 1000, false);
+    auto request = camera.wait();
+    ASSERT_GT(request.plane.stride, request.plane.width);
+
+    std::vector<uint8_t> mono(LibCameraFrames::packedSize(request.plane));
+    ASSERT_EQ(mono.size(), 100u * 50);
+    LibCameraFrames::packRows(request.plane, mono.data());
+
+    for (uint32_t y = 0; y < 50; y++)
+        for (uint32_t x = 0; x < 100; x++)
+            ASSERT_EQ(mono[y * 100 + x], LibCameraFakeCamera::sample(0, x, y, 0)) << x << "," << y;
+}
+
+TEST(LibCameraFrames, PackRGB)
+{
+    LibCameraFakeCamera camera(100, 50, 1000, true);
+    auto request = camera.wait();
+    ASSERT_GT(request.plane.stride, request.plane.width * 3);
+
+    // One byte more, to catch a copy of the padding
+    std::vector<uint8_t> rgb(LibCameraFrames::packedSize(request.plane) + 1, 0xA5);
+    ASSERT_EQ(rgb.size(), 100u * 50 * 3 + 1);
+    LibCameraFrames::packRows(request.plane, rgb.data());
+
+    for (uint32_t y = 0; y < 50; y++)
+        for (uint32_t x = 0; x < 100; x++)
+            for (uint32_t channel = 0; channel < 3; channel++)
+                ASSERT_EQ(rgb[(y * 100 + x) * 3 + channel], LibCameraFakeCamera::sample(0, x, y, channel))
+                        << x << "," << y << " channel " << channel;
+    EXPECT_EQ(rgb.back(), 0xA5);
+
+    // Rows without padding are copied at once
+    std::vector<uint8_t> const packed(rgb.begin(), rgb.end() - 1);
+    std::vector<uint8_t> copy(packed.size());
+    LibCameraFrames::packRows({packed.data(), 100, 50, 300, 3}, copy.data());
+    EXPECT_EQ(copy, packed);
+}
+
+TEST(LibCameraFrames, Times)
+{
+    // 2000-01-01T00:00:00.250 UTC
+    int64_t const unixTime = 946684800250000000LL;
+    EXPECT_EQ(LibCameraFrames::toISOTime(unixTime), "2000-01-01T00:00:00.250");
+    EXPECT_EQ(LibCameraFrames::toStreamTime(unixTime), (946684800ULL + 62135596800ULL) * 1000000ULL + 250000ULL);
+
+    // A frame just taken is dated now
+    int64_t const sensorTimestamp = now(CLOCK_BOOTTIME) - 10000000;
+    int64_t const expected = now(CLOCK_REALTIME) - 10000000;
+    EXPECT_NEAR(static_cast<double>(LibCameraFrames::toUnixTime(sensorTimestamp)), static_cast<double>(expected), 5e6);
+}
+
+TEST(LibCameraFrames, PoolReusesFrames)
+{
+    LibCameraFramePool pool(2);
+
+    auto first = pool.acquire(1000);
+    auto second = pool.acquire(500);
+    ASSERT_NE(first, nullptr);
+    ASSERT_NE(second, nullptr);
+    EXPECT_EQ(pool.acquire(10), nullptr);
+    EXPECT_EQ(pool.available(), 0u);
+
+    first->metadata.sensorTimestamp = 1;
+    uint8_t *data = first->data.data();
+    first.reset();
+    EXPECT_EQ(pool.available(), 1u);
+
+    // Smaller frames reuse the memory, and come back without the metadata of the last one
+    auto third = pool.acquire(800);
+    ASSERT_NE(third, nullptr);
+    EXPECT_EQ(third->data.data(), data);
+    EXPECT_EQ(third->size, 800u);
+    EXPECT_FALSE(third->metadata.sensorTimestamp);
+    EXPECT_EQ(pool.allocations(), 2u);
+
+    second.reset();
+    third.reset();
+    EXPECT_EQ(pool.available(), 2u);
+}
+
+TEST(LibCameraFrames, FramesOutliveThePool)
+{
+    std::shared_ptr<LibCameraFrame> frame;
+    {
+        LibCameraFramePool pool(1);
+        frame = pool.acquire(100);
+    }
+    ASSERT_NE(frame, nullptr);
+    frame->data[99] = 1;
+    frame.reset();
+}
+
+TEST(LibCameraFrames, Statistics)
+{
+    LibCameraFrameStatistics statistics;
+    LibCameraFrameMetadata metadata;
+    metadata.frameDuration = 100000;
+
+    for (int64_t timestamp : {1000000000LL, 1100000000LL, 1200000000LL, 1500000000LL, 1400000000LL, 1600000000LL})
+    {
+        metadata.sensorTimestamp = timestamp;
+        statistics.add(metadata, 2);
+    }
+    statistics.add(LibCameraFrameMetadata(), 2);
+
+    EXPECT_EQ(statistics.frames(), 7u);
+    EXPECT_EQ(statistics.untimed(), 1u);
+    EXPECT_EQ(statistics.outOfOrder(), 1u);
+    EXPECT_EQ(statistics.dropped(), 2u);
+    EXPECT_NEAR(statistics.frameRate(), 4 / 0.6, 1e-6);
+    EXPECT_DOUBLE_EQ(statistics.cpuPerFrame(), 2);
+
+    statistics.reset();
+    EXPECT_EQ(statistics.frames(), 0u);
+    EXPECT_EQ(statistics.frameRate(), 0);
+}
+
+// The video path of the driver, against a stream at 60 frames per second
+TEST(LibCameraFrames, Stream)
+{
+    constexpr double framerate = 60;
+    LibCameraFakeCamera camera(1280, 720, framerate, true);
+    camera.dropEvery = 50;
+    LibCameraFramePool pool(3);
+    LibCameraFrameStatistics statistics;
+
+    int64_t last = 0;
+    for (int i = 0; i < 120; i++)
+    {
+        auto request = camera.wait();
+        double const cpuStart = LibCameraFrames::threadCPUTime();
+
+        auto frame = pool.acquire(LibCameraFrames::packedSize(request.plane));
+        ASSERT_NE(frame, nullptr);
+        LibCameraFrames::packRows(request.plane, frame->data.data());
+        frame->metadata = request.metadata;
+
+        statistics.add(frame->metadata, LibCameraFrames::threadCPUTime() - cpuStart);
+
+        ASSERT_TRUE(frame->metadata.sensorTimestamp);
+        EXPECT_GT(*frame->metadata.sensorTimestamp, last);
+        last = *frame->metadata.sensorTimestamp;
+    }
+
+    EXPECT_EQ(statistics.outOfOrder(), 0u);
+    EXPECT_EQ(statistics.untimed(), 0u);
+    EXPECT_EQ(statistics.dropped(), 2u);
+    EXPECT_NEAR(statistics.frameRate(), framerate * 120 / 122, 3);
+    EXPECT_EQ(pool.allocations(), 1u);
+
+    std::cout << "1280x720 RGB888 rows: " << statistics.frameRate() << " frames/s, "
+              << statistics.cpuPerFrame() << " ms CPU per frame" << std::endl;
+}
@@ -21,13 +21,12 @@
 
 #include <stdio.h>
 #include <string.h>
-#include <termios.h>
 #include <indicom.h>
 #include <indilogger.h>
 
 #include "maxdomeiidriver.h"
 
-#define MAXDOME_TIMEOUT 5  // FD timeout in seconds
+#define MAXDOME_TIMEOUT 5  // Response timeout in seconds
 #define BUFFER_SIZE     16 // Maximum message length
 
 // Start byte
@@ -85,6 +84,7 @@ void hexDump(char *buf, const char *data, int size)
 void MaxDomeIIDriver::SetPortFD(int port_fd)
 {
     fd = port_fd;
+    framer.setFD(fd);
 }
 
 // This method is required by the logging macros
@@ -109,6 +109,7 @@ int MaxDomeIIDriver::Connect(const char *device)
     if (tty_connect(device, 19200, 8, 0, 1, &fd) != TTY_OK)
         return -1;
 
+    framer.setFD(fd);
     return fd;
 }
 
@@ -122,6 +123,7 @@ int MaxDomeIIDriver::Disconnect()
 {
     //ExitShutter(); // Really don't know why this is needed, but ASCOM driver does it
     tty_disconnect(fd);
+    framer.setFD(-1);
 
     return 0;
 }
@@ -159,40 +161,26 @@ signed char computeChecksum(char *msg, int len)
 */
 int MaxDomeIIDriver::ReadResponse()
 {
-    int nbytes;
-    int err = TTY_OK;
-
-    buffer[0] = 0x00;
-    buffer[13] = 0x00;
-
-    // Look for a starting byte until time out occurs or BUFFER_SIZE bytes were read
-    while (*buffer != START_BYTE && err == TTY_OK)
-        err = tty_read(fd, buffer, 1, MAXDOME_TIMEOUT, &nbytes);
+    // Start byte, length of the rest of the message and the message
+    static const SerialFramer::PacketFormat format = { START_BYTE, 1, 2, 0x02, 0x0e };
 
-    if (err != TTY_OK || buffer[0] != START_BYTE)
-    {
-        LOG_ERROR(ErrorMessages[1]);
-        return -1;
-    }
+    size_t size = 0;
+    SerialFramer::Result rc = framer.readPacket(buffer, BUFFER_SIZE, format, MAXDOME_TIMEOUT * 1000, &size);
 
-    // Read message length
-    err = tty_read(fd, buffer + 1, 1, MAXDOME_TIMEOUT, &nbytes);
-    if (err != TTY_OK || buffer[1] < 0x02 || buffer[1] > 0x0e)
+    if (rc == SerialFramer::FRAME_BAD_LENGTH)
     {
         LOG_ERROR(ErrorMessages[2]);
         return -2;
     }
-
-    int len = buffer[1];
-
-    // Read the rest of the message
-    err = tty_read(fd, buffer + 2, len, MAXDOME_TIMEOUT, &nbytes);
-    if (err != TTY_OK || nbytes != len)
+    if (rc != SerialFramer::FRAME_OK)
     {
-        LOG_ERROR(ErrorMessages[3]);
-        return -3;
+        // Nothing or only part of a message
+        LOG_ERROR(ErrorMessages[framer.available() > 0 ? 3 : 1]);
+        return framer.available() > 0 ? -3 : -1;
     }
 
+    int len = buffer[1];
+
     if (computeChecksum(buffer, len + 2) != 0)
     {
         LOG_ERROR(ErrorMessages[4]);
@@ -221,7 +209,6 @@ int MaxDomeIIDriver::SendCommand(char cmdId, const char *payload, int payloadLen
 {
     int err;
     int nbytes;
-    char errmsg[MAXRBUF];
     char cmd[BUFFER_SIZE];
     char hexbuf[3 * BUFFER_SIZE];
 
@@ -240,12 +227,12 @@ int MaxDomeIIDriver::SendCommand(char cmdId, const char *payload, int payloadLen
     hexDump(hexbuf, cmd, 4 + payloadLen);
     LOGF_DEBUG("CMD (%s)", hexbuf);
 
-    tcflush(fd, TCIOFLUSH);
+    // The answer to a command that timed out must not be taken for the answer to this one
+    framer.discardInput();
 
-    if ((err = tty_write(fd, cmd, 4 + payloadLen, &nbytes)) != TTY_OK)
+    if ((err = framer.write(cmd, 4 + payloadLen, MAXDOME_TIMEOUT * 1000)) != SerialFramer::FRAME_OK)
     {
-        tty_error_msg(err, errmsg, MAXRBUF);
-        LOG_ERROR(errmsg);
+        LOG_ERROR(SerialFramer::resultMessage(static_cast<SerialFramer::Result>(err)));
         return -5;
     }
 
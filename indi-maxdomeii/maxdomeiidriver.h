@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include "serialframer.h"
+
 // Direction fo azimuth movement
 #define MAXDOMEII_EW_DIR 0x01
 #define MAXDOMEII_WE_DIR 0x02
@@ -59,6 +61,11 @@ class MaxDomeIIDriver
             fd = 0;
         }
 
+        const SerialFramer &getFramer() const
+        {
+            return framer;
+        }
+
         const char *getDeviceName();
         void SetPortFD(int port_fd);
         void SetDevice(const char *name);
@@ -92,4 +99,5 @@ class MaxDomeIIDriver
     private:
         int fd;
         char buffer[16];
+        SerialFramer framer;
 };
@@ -1,5 +1,26 @@
 #include <gtest/gtest.h>
 #include "maxdomeiidriver.h"
+#include "serialscript.h"
+
+#define POLLS 20
+
+// Packets with their checksum, the bytes after the start byte add up to zero
+static std::string packet(std::initializer_list<uint8_t> body)
+{
+    std::string data(1, '\x01');
+    data += static_cast<char>(body.size() + 1);
+    char checksum = -static_cast<char>(body.size() + 1);
+    for (uint8_t byte : body)
+    {
+        data += static_cast<char>(byte);
+        checksum -= static_cast<char>(byte);
+    }
+    return data + checksum;
+}
+
+static const std::string STATUS_REQUEST = packet({ 0x07 });
+// Shutter closed, azimuth idle at tick 300, home at tick 12
+static const std::string STATUS_RESPONSE = packet({ 0x87, 0x00, 0x01, 0x01, 0x2c, 0x00, 0x0c });
 
 
 TEST(MaxDomeIIDriver, hexDump)
@@ -11,6 +32,81 @@ TEST(MaxDomeIIDriver, hexDump)
     ASSERT_STREQ(out, "61 62 63 64");
 }
 
+class MaxDomeIIProtocol : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            script.add(STATUS_REQUEST, STATUS_RESPONSE);
+            script.setPacing(3, 200);
+            fd = script.start();
+            ASSERT_GE(fd, 0);
+            driver.SetPortFD(fd);
+        }
+
+        void expectStatus()
+        {
+            ShStatus shutter;
+            AzStatus azimuth;
+            unsigned position = 0, home = 0;
+            ASSERT_EQ(driver.Status(&shutter, &azimuth, &position, &home), 0);
+            EXPECT_EQ(shutter, SS_CLOSED);
+            EXPECT_EQ(position, 300u);
+            EXPECT_EQ(home, 12u);
+        }
+
+        SerialScript script;
+        MaxDomeIIDriver driver;
+        int fd { -1 };
+};
+
+TEST_F(MaxDomeIIProtocol, StatusPoll)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < POLLS; i++)
+        expectStatus();
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / POLLS;
+    double calls = static_cast<double>(driver.getFramer().getStatistics().syscalls()) / POLLS;
+
+    // tcflush(), then tty_read() for the start byte, the length and the rest
+    LegacyTty legacy(fd);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < POLLS; i++)
+    {
+        char buffer[16];
+        legacy.flush();
+        ASSERT_TRUE(legacy.write(STATUS_REQUEST));
+        do
+            ASSERT_EQ(legacy.read(buffer, 1, 5), 1);
+        while (buffer[0] != 0x01);
+        ASSERT_EQ(legacy.read(buffer + 1, 1, 5), 1);
+        ASSERT_EQ(legacy.read(buffer + 2, buffer[1], 5), buffer[1]);
+    }
+    double legacyTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / POLLS;
+    double legacyCalls = static_cast<double>(legacy.getSyscalls()) / POLLS;
+
+    printf("Status poll: %.1f syscalls %.2f ms, tty_read %.1f syscalls %.2f ms\n", calls, elapsed, legacyCalls, legacyTime);
+
+    EXPECT_LT(calls, legacyCalls);
+}
+
+TEST_F(MaxDomeIIProtocol, GarbageBeforeStartByte)
+{
+    // Line noise ahead of the response
+    script.add(packet({ 0x0a }), std::string("\x55\xaa\x03") + packet({ 0x8a }));
+    EXPECT_EQ(driver.Ack(), 0);
+    EXPECT_EQ(driver.getFramer().getStatistics().bytesDiscarded, 3u);
+}
+
+TEST_F(MaxDomeIIProtocol, BadLengthResync)
+{
+    // A start byte with an impossible length, then a good response
+    script.add(packet({ 0x0a }), std::string("\x01\x7f") + packet({ 0x8a }));
+    EXPECT_EQ(driver.Ack(), -2);
+    // What is left of the response is dropped before the next command
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    expectStatus();
+}
 
 int main(int argc, char **argv)
 {
@@ -42,6 +42,7 @@
 #include "mgen.h"
 #include "mgenautoguider.h"
 #include "mgen_device.h"
+#include "mgen_io.h"
 
 // There is no official way to detect the version of the FTDI library from headers, hence this ugly method
 #pragma GCC diagnostic push
@@ -53,8 +54,22 @@ int ftdi_tcioflush(struct ftdi_context *ftdi)
 }
 #pragma GCC diagnostic pop
 
+/** \internal The link to the device through libftdi. */
+class MGenFtdiLink : public MGenLink
+{
+  protected:
+    struct ftdi_context *ftdi;
+
+  public:
+    virtual int write(IOByte const *data, int size) { return ftdi_write_data(ftdi, data, size); }
+    virtual int read(IOByte *data, int size) { return ftdi_read_data(ftdi, data, size); }
+
+  public:
+    MGenFtdiLink(struct ftdi_context *ftdi) : ftdi(ftdi) {}
+};
+
 MGenDevice::MGenDevice()
-    : _lock(), ftdi(NULL), is_device_connected(false), tried_turn_on(false), mode(OPM_UNKNOWN), vid(0), pid(0)
+    : _lock(), ftdi(NULL), link(NULL), is_device_connected(false), tried_turn_on(false), mode(OPM_UNKNOWN), vid(0), pid(0)
 {
     pthread_mutexattr_t attr;
     pthread_mutexattr_init(&attr);
@@ -91,10 +106,13 @@ void MGenDevice::disable()
     if (lock())
     {
         is_device_connected = false;
+        delete link;
+        link = NULL;
         if (ftdi)
         {
             ftdi_usb_close(ftdi);
             ftdi_free(ftdi);
+            ftdi = NULL;
         }
         unlock();
     }
@@ -113,6 +131,8 @@ int MGenDevice::Connect(unsigned short vid, unsigned short pid)
            ftdi_version.major, ftdi_version.minor, ftdi_version.micro, ftdi_version.snapshot_str);
 
         /* Cleanup in case we try to reconnect after turning on */
+        delete link;
+        link = NULL;
         if (ftdi)
         {
             ftdi_usb_close(ftdi);
@@ -176,6 +196,7 @@ int MGenDevice::Connect(unsigned short vid, unsigned short pid)
         {
             this->vid = vid;
             this->pid = pid;
+            link      = new MGenFtdiLink(ftdi);
             _S("FTDI device 0x%04X:0x%04X connected successfully", vid, pid);
             unlock();
             return 0;
@@ -266,7 +287,7 @@ int MGenDevice::setOpMode(IOMode const _mode)
         {
             _E("failed purging I/O buffers (%d: %s)", res, ftdi_get_error_string(ftdi));
         }
-        /* Set latency to minimal 2ms */
+        /* Set latency to minimal 2ms, this is how long a read waits when the device is not answering yet */
         else if ((res = ftdi_set_latency_timer(ftdi, 2)) < 0)
         {
             _E("failed setting latency timer (%d: %s)", res, ftdi_get_error_string(ftdi));
@@ -287,16 +308,13 @@ int MGenDevice::setOpMode(IOMode const _mode)
 
 int MGenDevice::write(IOBuffer const &query) //throw(IOError)
 {
-    if (!ftdi)
+    if (!link)
         return -1;
 
     _D("writing %d bytes to device: %02X %02X %02X %02X %02X ...", query.size(), query.size() > 0 ? query[0] : 0,
        query.size() > 1 ? query[1] : 0, query.size() > 2 ? query[2] : 0, query.size() > 3 ? query[3] : 0,
        query.size() > 4 ? query[4] : 0);
-    int const bytes_written = ftdi_write_data(ftdi, query.data(), query.size());
-
-    /* FIXME: Adjust this to optimize how long device absorb the command for */
-    usleep(20000);
+    int const bytes_written = link->write(query.data(), query.size());
 
     if (bytes_written < 0)
         throw IOError(bytes_written);
@@ -306,13 +324,14 @@ int MGenDevice::write(IOBuffer const &query) //throw(IOError)
 
 int MGenDevice::read(IOBuffer &answer) //throw(IOError)
 {
-    if (!ftdi)
+    if (!link)
         return -1;
 
     if (answer.size() > 0)
     {
         _D("reading %d bytes from device", answer.size());
-        int const bytes_read = ftdi_read_data(ftdi, answer.data(), answer.size());
+        /* The answer is not waited for after writing the query, so read until it is complete */
+        int const bytes_read = MGenIO::readAnswer(*link, answer.data(), answer.size());
 
         if (bytes_read < 0)
             throw IOError(bytes_read);
@@ -326,6 +345,19 @@ int MGenDevice::read(IOBuffer &answer) //throw(IOError)
     return 0;
 }
 
+int MGenDevice::readDisplayFrame(IOByte opcode, IOBuffer &bitmap) //throw(IOError)
+{
+    if (!link)
+        return -1;
+
+    int const blocks = MGenIO::readDisplayFrame(*link, opcode, bitmap);
+
+    if (blocks < 0)
+        throw IOError(blocks);
+
+    return blocks;
+}
+
 char const * MGenDevice::DBG_OpModeString(IOMode mode)
 {
     switch (mode)
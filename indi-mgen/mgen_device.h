@@ -34,12 +34,17 @@
 #ifndef MGEN_DEVICE_H
 #define MGEN_DEVICE_H
 
+#include <atomic>
+
+class MGenLink;
+
 class MGenDevice
 {
   protected:
     pthread_mutex_t _lock;
     struct ftdi_context *ftdi;
-    bool is_device_connected;
+    MGenLink *link;
+    std::atomic<bool> is_device_connected;
     bool tried_turn_on;
     IOMode mode;
     unsigned short vid, pid;
@@ -86,11 +91,21 @@ class MGenDevice
     int write(IOBuffer const &); //throw(IOError);
 
     /** \brief Reading the answer part of a command from the device.
+     *
+     * This function waits until the device sent as many bytes as the answer buffer holds, or until it times out.
+     *
      * \return the number of bytes read, or -1 if the command is invalid or device is not accessible.
      * \throw IOError when device communication is malfunctioning.
      */
     int read(IOBuffer &); //throw(IOError);
 
+    /** \brief Reading the display frame with pipelined block queries.
+     * \return the number of blocks acknowledged, or -1 if device is not accessible.
+     * \throw IOError when device communication is malfunctioning.
+     * \see MGenIO::readDisplayFrame
+     */
+    int readDisplayFrame(IOByte opcode, IOBuffer &bitmap); //throw(IOError);
+
   public:
     /** \brief Turning the device on.
      *
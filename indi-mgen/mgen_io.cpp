@@ -0,0 +1,142 @@
+/*
+    INDI 3rd party driver
+    Lacerta MGen Autoguider INDI driver, implemented with help from
+    Tommy (teleskopaustria@gmail.com) and Zoltan (mgen@freemail.hu).
+
+    Teleskop & Mikroskop Zentrum (www.teleskop.austria.com)
+    A-1050 WIEN, Schönbrunner Strasse 96
+    +43 699 1197 0808 (Shop in Wien und Rechnungsanschrift)
+    A-4020 LINZ, Gärtnerstrasse 16
+    +43 699 1901 2165 (Shop in Linz)
+
+    Lacerta GmbH
+    UmsatzSt. Id. Nr.: AT U67203126
+    Firmenbuch Nr.: FN 379484s
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+ * mgen_io.cpp
+ *
+ *  Created on: 18 oct. 2026
+ */
+
+#include <time.h>
+
+#include <algorithm>
+
+#include "mgen_io.h"
+
+static long elapsed_ms(struct timespec const &since)
+{
+    struct timespec now = { .tv_sec = 0, .tv_nsec = 0 };
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - since.tv_sec) * 1000 + (now.tv_nsec - since.tv_nsec) / 1000000;
+}
+
+int MGenIO::readAnswer(MGenLink &link, IOByte *data, int size, int timeout_ms)
+{
+    struct timespec start = { .tv_sec = 0, .tv_nsec = 0 };
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int bytes_read = 0;
+
+    while (bytes_read < size)
+    {
+        /* Each read waits at most for the latency timer of the chip, so this does not spin */
+        int const res = link.read(data + bytes_read, size - bytes_read);
+
+        if (res < 0)
+            return res;
+
+        bytes_read += res;
+
+        if (0 == res && timeout_ms < elapsed_ms(start))
+            break;
+    }
+
+    return bytes_read;
+}
+
+/* Query:  IO_FUNC SUBFUNC ADDR_L ADDR_H COUNT, 10 bits of address
+ * Answer: IO_FUNC D0 D1 D2... (COUNT bytes)
+ */
+static void append_block_query(IOBuffer &query, IOByte opcode, unsigned int block)
+{
+    unsigned int const address = block * MGenIO::display_block_size;
+    query.push_back(opcode);
+    query.push_back(0x0D);
+    query.push_back((IOByte)((address & 0x03FF) >> 0));
+    query.push_back((IOByte)((address & 0x03FF) >> 8));
+    query.push_back((IOByte)MGenIO::display_block_size);
+}
+
+int MGenIO::readDisplayFrame(MGenLink &link, IOByte opcode, IOBuffer &bitmap, unsigned int depth, int timeout_ms)
+{
+    unsigned int const blocks = display_frame_size / display_block_size;
+    IOBuffer query;
+    IOBuffer answer(1 + display_block_size);
+    unsigned int queried = 0;
+    int acked = 0;
+    int res = 0;
+
+    depth = std::max(1u, std::min(depth, blocks));
+
+    bitmap.clear();
+    bitmap.reserve(display_frame_size);
+
+    for (; queried < depth; queried++)
+        append_block_query(query, opcode, queried);
+
+    if ((res = link.write(query.data(), query.size())) < 0)
+        return res;
+
+    for (unsigned int block = 0; block < blocks; block++)
+    {
+        /* Keep the device busy with the next block while this one is transferred */
+        int const bytes_read = readAnswer(link, answer.data(), answer.size(), timeout_ms);
+
+        if (bytes_read < 0)
+            return bytes_read;
+
+        if (queried < blocks)
+        {
+            query.clear();
+            append_block_query(query, opcode, queried++);
+            if ((res = link.write(query.data(), query.size())) < 0)
+                return res;
+        }
+
+        if (bytes_read == (int)answer.size() && opcode == answer[0])
+            acked++;
+
+        bitmap.insert(bitmap.end(), answer.begin() + 1, answer.end());
+    }
+
+    /* Finish with an invalid address to prevent breaking device sync, device replies with opcode only */
+    query.assign({ opcode, 0xFF });
+    if ((res = link.write(query.data(), query.size())) < 0)
+        return res;
+
+    answer.resize(1);
+    if ((res = readAnswer(link, answer.data(), answer.size(), timeout_ms)) < 0)
+        return res;
+
+    return acked;
+}
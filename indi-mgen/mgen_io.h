@@ -0,0 +1,102 @@
+/*
+    INDI 3rd party driver
+    Lacerta MGen Autoguider INDI driver, implemented with help from
+    Tommy (teleskopaustria@gmail.com) and Zoltan (mgen@freemail.hu).
+
+    Teleskop & Mikroskop Zentrum (www.teleskop.austria.com)
+    A-1050 WIEN, Schönbrunner Strasse 96
+    +43 699 1197 0808 (Shop in Wien und Rechnungsanschrift)
+    A-4020 LINZ, Gärtnerstrasse 16
+    +43 699 1901 2165 (Shop in Linz)
+
+    Lacerta GmbH
+    UmsatzSt. Id. Nr.: AT U67203126
+    Firmenbuch Nr.: FN 379484s
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+ * mgen_io.h
+ *
+ *  Created on: 18 oct. 2026
+ */
+
+#ifndef _3RDPARTY_INDI_MGEN_MGEN_IO_H_
+#define _3RDPARTY_INDI_MGEN_MGEN_IO_H_
+
+#include <vector>
+
+#include "mgen.h"
+
+/** \brief The byte pipe to the device, a FTDI chip or a mock standing in for it.
+ *
+ * Reads have the semantics of ftdi_read_data(): they return what the chip forwarded so far, possibly nothing when
+ * the latency timer expired before the device answered.
+ */
+class MGenLink
+{
+  public:
+    /** \return the number of bytes written, or a negative error code. */
+    virtual int write(IOByte const *data, int size) = 0;
+
+    /** \return the number of bytes read, zero if none arrived, or a negative error code. */
+    virtual int read(IOByte *data, int size) = 0;
+
+  public:
+    virtual ~MGenLink() {}
+};
+
+namespace MGenIO
+{
+/** \brief Milliseconds the device gets to complete an answer. */
+static int const answer_timeout = 500;
+
+/** \brief Display blocks queried in advance while the previous one is being read. */
+static unsigned int const display_pipeline_depth = 2;
+
+/** \brief Bytes in the display frame, and bytes in one display block query. */
+/** @{ */
+static unsigned int const display_frame_size = (128 * 64) / 8;
+static unsigned int const display_block_size = 128;
+/** @} */
+
+/** \brief Reading an answer of known length.
+ *
+ * The device may not have started answering when the first read returns, so this reads again until all bytes arrive.
+ *
+ * \return the number of bytes read, less than size if the device did not complete the answer in time.
+ * \return a negative error code if the link failed.
+ */
+int readAnswer(MGenLink &link, IOByte *data, int size, int timeout_ms = answer_timeout);
+
+/** \brief Reading the display frame through the IO_FUNC display read subfunction.
+ *
+ * Up to depth block queries are queued on the device, so that the next block is already requested when the answer to
+ * the current block is read, instead of one round trip per block.
+ *
+ * \param opcode is the IO_FUNC operation code.
+ * \param bitmap receives display_frame_size bytes, with whatever was read for blocks that failed.
+ * \return the number of blocks acknowledged, the frame is complete if it is display_frame_size / display_block_size.
+ * \return a negative error code if the link failed.
+ */
+int readDisplayFrame(MGenLink &link, IOByte opcode, IOBuffer &bitmap, unsigned int depth = display_pipeline_depth,
+                     int timeout_ms = answer_timeout);
+}
+
+#endif /* _3RDPARTY_INDI_MGEN_MGEN_IO_H_ */
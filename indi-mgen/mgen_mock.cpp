@@ -0,0 +1,220 @@
+/*
+    INDI 3rd party driver
+    Lacerta MGen Autoguider INDI driver, implemented with help from
+    Tommy (teleskopaustria@gmail.com) and Zoltan (mgen@freemail.hu).
+
+    Teleskop & Mikroskop Zentrum (www.teleskop.austria.com)
+    A-1050 WIEN, Schönbrunner Strasse 96
+    +43 699 1197 0808 (Shop in Wien und Rechnungsanschrift)
+    A-4020 LINZ, Gärtnerstrasse 16
+    +43 699 1901 2165 (Shop in Linz)
+
+    Lacerta GmbH
+    UmsatzSt. Id. Nr.: AT U67203126
+    Firmenbuch Nr.: FN 379484s
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+ * mgen_mock.cpp
+ *
+ *  Created on: 18 oct. 2026
+ */
+
+#include <thread>
+
+#include "mgen_mock.h"
+
+MGenMockLink::MGenMockLink(int baudrate, std::chrono::microseconds latency, std::chrono::microseconds processing)
+    : display(MGenIO::display_frame_size), byte_time(std::chrono::nanoseconds(10 * 1000000000LL / baudrate)),
+      latency(latency), processing(processing), line_in_free(clock::now()), device_free(clock::now()), commands(0),
+      unplugged(false)
+{
+    /* Something recognizable, different for each block */
+    for (unsigned int i = 0; i < display.size(); i++)
+        display[i] = (IOByte)(i * 7 + i / MGenIO::display_block_size);
+}
+
+unsigned int MGenMockLink::commandCount()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return commands;
+}
+
+std::deque<IOByte> MGenMockLink::buttons()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return inserted;
+}
+
+void MGenMockLink::unplug()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    unplugged = true;
+}
+
+int MGenMockLink::write(IOByte const *data, int size)
+{
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (unplugged)
+        return -1;
+
+    /* The query reaches the device once it is through the serial line */
+    line_in_free = std::max(clock::now(), line_in_free) + size * byte_time;
+    input.insert(input.end(), data, data + size);
+    process(line_in_free);
+
+    return size;
+}
+
+int MGenMockLink::read(IOByte *data, int size)
+{
+    std::unique_lock<std::mutex> guard(lock);
+
+    if (unplugged)
+        return -1;
+
+    clock::time_point now = clock::now();
+
+    /* Nothing forwarded yet, the chip sends an empty packet when its latency timer expires */
+    if (output.empty() || now < output.front().first)
+    {
+        clock::time_point until = now + latency;
+        if (!output.empty() && output.front().first < until)
+            until = output.front().first;
+
+        guard.unlock();
+        std::this_thread::sleep_until(until);
+        guard.lock();
+        now = clock::now();
+    }
+
+    int bytes_read = 0;
+    while (bytes_read < size && !output.empty() && output.front().first <= now)
+    {
+        data[bytes_read++] = output.front().second;
+        output.pop_front();
+    }
+
+    return bytes_read;
+}
+
+void MGenMockLink::process(clock::time_point received)
+{
+    IOBuffer out;
+    int length = 0;
+
+    while (0 <= (length = answer(out)))
+    {
+        if (0 == length)
+            continue;
+
+        commands++;
+
+        /* Commands are processed in order, and the answer is sent at line speed */
+        clock::time_point const start = std::max(received, device_free) + processing;
+        for (int i = 0; i < length; i++)
+            output.emplace_back(start + (i + 1) * byte_time + latency, out[i]);
+        device_free = start + length * byte_time;
+    }
+}
+
+int MGenMockLink::answer(IOBuffer &out)
+{
+    out.clear();
+
+    if (input.empty())
+        return -1;
+
+    IOByte const opcode = input[0];
+
+    switch (opcode)
+    {
+        /* NOP1 */
+        case 0xFF:
+            out.assign({ opcode });
+            input.pop_front();
+            break;
+
+        /* GET_FW_VERSION */
+        case 0x03:
+            out.assign({ opcode, 0x21, 0x43 });
+            input.pop_front();
+            break;
+
+        /* READ_ADCS, logic 5V, input 12V, reference 1.23V */
+        case 0xA0:
+            out.assign({ opcode, 0x2B, 0x74, 0x74, 0x95, 0, 0, 0, 0, 0xE2, 0x7A });
+            input.pop_front();
+            break;
+
+        /* IO_FUNC */
+        case 0x5D:
+            if (input.size() < 2)
+                return -1;
+
+            switch (input[1])
+            {
+                /* Display read */
+                case 0x0D:
+                {
+                    if (input.size() < 5)
+                        return -1;
+
+                    unsigned int const address = input[2] | ((input[3] & 0x03) << 8);
+                    unsigned int const count   = input[4];
+                    out.push_back(opcode);
+                    for (unsigned int i = 0; i < count; i++)
+                        out.push_back(display[(address + i) % display.size()]);
+                    input.erase(input.begin(), input.begin() + 5);
+                    break;
+                }
+
+                /* Insert button, press then release with bit 7 set */
+                case 0x01:
+                    if (input.size() < 3)
+                        return -1;
+
+                    if (!(input[2] & 0x80))
+                        inserted.push_back(input[2]);
+                    out.assign({ opcode, 0x01 });
+                    input.erase(input.begin(), input.begin() + 3);
+                    break;
+
+                /* End of subfunction */
+                case 0xFF:
+                    out.assign({ opcode });
+                    input.erase(input.begin(), input.begin() + 2);
+                    break;
+
+                default:
+                    input.erase(input.begin(), input.begin() + 2);
+                    break;
+            }
+            break;
+
+        /* Unknown commands are not acknowledged */
+        default:
+            input.pop_front();
+            break;
+    }
+
+    return out.size();
+}
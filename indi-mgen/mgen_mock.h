@@ -0,0 +1,99 @@
+/*
+    INDI 3rd party driver
+    Lacerta MGen Autoguider INDI driver, implemented with help from
+    Tommy (teleskopaustria@gmail.com) and Zoltan (mgen@freemail.hu).
+
+    Teleskop & Mikroskop Zentrum (www.teleskop.austria.com)
+    A-1050 WIEN, Schönbrunner Strasse 96
+    +43 699 1197 0808 (Shop in Wien und Rechnungsanschrift)
+    A-4020 LINZ, Gärtnerstrasse 16
+    +43 699 1901 2165 (Shop in Linz)
+
+    Lacerta GmbH
+    UmsatzSt. Id. Nr.: AT U67203126
+    Firmenbuch Nr.: FN 379484s
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+ * mgen_mock.h
+ *
+ *  Created on: 18 oct. 2026
+ */
+
+#ifndef _3RDPARTY_INDI_MGEN_MGEN_MOCK_H_
+#define _3RDPARTY_INDI_MGEN_MGEN_MOCK_H_
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+
+#include "mgen_io.h"
+
+/** \brief A MGen in applicative mode behind a FTDI chip, for tests.
+ *
+ * Implements NOP1, GET_FW_VERSION, READ_ADCS and the IO_FUNC display read and button subfunctions. Commands are
+ * answered one after the other at the serial line speed, after a processing delay. The chip forwards answer bytes
+ * to the host once its latency timer expires, and a read returns nothing if no byte is forwarded within that time.
+ */
+class MGenMockLink : public MGenLink
+{
+  public:
+    typedef std::chrono::steady_clock clock;
+
+  public:
+    virtual int write(IOByte const *data, int size);
+    virtual int read(IOByte *data, int size);
+
+  public:
+    /** \brief The display content read by IO_FUNC, display_frame_size bytes. */
+    IOBuffer display;
+
+    /** \brief Number of commands answered so far. */
+    unsigned int commandCount();
+
+    /** \brief Buttons inserted so far, in order. */
+    std::deque<IOByte> buttons();
+
+    /** \brief Making the link fail all subsequent reads and writes, as an unplugged device. */
+    void unplug();
+
+  public:
+    MGenMockLink(int baudrate = 250000, std::chrono::microseconds latency = std::chrono::milliseconds(2),
+                 std::chrono::microseconds processing = std::chrono::microseconds(100));
+
+  protected:
+    /** \internal Answering the commands complete in the input queue. */
+    void process(clock::time_point received);
+
+    /** \internal Answer of the command at the front of the input queue, or -1 if it is incomplete. */
+    int answer(IOBuffer &out);
+
+  protected:
+    std::mutex lock;
+    clock::duration byte_time, latency, processing;
+    clock::time_point line_in_free, device_free;
+    std::deque<IOByte> input;
+    std::deque<std::pair<clock::time_point, IOByte>> output;
+    std::deque<IOByte> inserted;
+    unsigned int commands;
+    bool unplugged;
+};
+
+#endif /* _3RDPARTY_INDI_MGEN_MGEN_MOCK_H_ */
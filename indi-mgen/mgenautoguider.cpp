@@ -41,6 +41,7 @@
 #include <stdio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <queue>
@@ -90,6 +91,7 @@ bool MGenAutoguider::ISNewSwitch(const char *dev, const char *name, ISState *sta
                 }
                 else ui.remote.property.s = IPS_ALERT;
                 IDSetSwitch(&ui.remote.property, NULL);
+                updatePoller();
             }
             if (!strcmp(name, "MGEN_UI_BUTTONS1"))
             {
@@ -98,7 +100,9 @@ bool MGenAutoguider::ISNewSwitch(const char *dev, const char *name, ISState *sta
                 if (key_switch)
                 {
                     MGIO_INSERT_BUTTON::Button button = *(reinterpret_cast<MGIO_INSERT_BUTTON::Button *>(key_switch->aux));
-                    MGIO_INSERT_BUTTON(button).ask(*device);
+                    std::unique_lock<std::mutex> guard(poller.lock);
+                    poller.buttons.push_back(button);
+                    poller.wake.notify_one();
                     key_switch->s              = ISS_OFF;
                     ui.buttons.properties[0].s = IPS_OK;
                 }
@@ -112,7 +116,9 @@ bool MGenAutoguider::ISNewSwitch(const char *dev, const char *name, ISState *sta
                 if (key_switch)
                 {
                     MGIO_INSERT_BUTTON::Button button = *(reinterpret_cast<MGIO_INSERT_BUTTON::Button *>(key_switch->aux));
-                    MGIO_INSERT_BUTTON(button).ask(*device);
+                    std::unique_lock<std::mutex> guard(poller.lock);
+                    poller.buttons.push_back(button);
+                    poller.wake.notify_one();
                     key_switch->s              = ISS_OFF;
                     ui.buttons.properties[1].s = IPS_OK;
                 }
@@ -126,7 +132,9 @@ bool MGenAutoguider::ISNewSwitch(const char *dev, const char *name, ISState *sta
                 if (key_switch)
                 {
                     MGIO_INSERT_BUTTON::Button button = *(reinterpret_cast<MGIO_INSERT_BUTTON::Button *>(key_switch->aux));
-                    MGIO_INSERT_BUTTON(button).ask(*device);
+                    std::unique_lock<std::mutex> guard(poller.lock);
+                    poller.buttons.push_back(button);
+                    poller.wake.notify_one();
                     key_switch->s              = ISS_OFF;
                     ui.buttons.properties[2].s = IPS_OK;
                 }
@@ -140,7 +148,9 @@ bool MGenAutoguider::ISNewSwitch(const char *dev, const char *name, ISState *sta
                 if (key_switch)
                 {
                     MGIO_INSERT_BUTTON::Button button = *(reinterpret_cast<MGIO_INSERT_BUTTON::Button *>(key_switch->aux));
-                    MGIO_INSERT_BUTTON(button).ask(*device);
+                    std::unique_lock<std::mutex> guard(poller.lock);
+                    poller.buttons.push_back(button);
+                    poller.wake.notify_one();
                     key_switch->s              = ISS_OFF;
                     ui.buttons.properties[3].s = IPS_OK;
                 }
@@ -183,6 +193,7 @@ bool MGenAutoguider::ISNewNumber(char const *dev, char const *name, double value
                 IUUpdateNumber(&ui.framerate.property, values, names, n);
                 ui.framerate.property.s = IPS_OK;
                 IDSetNumber(&ui.framerate.property, NULL);
+                updatePoller();
                 RemoveTimer(ui.timer);
                 TimerHit();
                 _S("UI refresh rate is now %+02.2f frames per second", ui.framerate.number.value);
@@ -263,7 +274,7 @@ bool MGenAutoguider::initProperties()
         IUFillSwitchVector(&ui.remote.property, &ui.remote.switches[0], 2, getDeviceName(), "MGEN_UI_REMOTE",
                            "Enable Remote UI", TAB, IP_RW, ISR_1OFMANY, 0, IPS_OK);
         /* FIXME frame rate kills connection quickly, make INDI::CCD blob compressed by default at the expense of server cpu power */
-        IUFillNumber(&ui.framerate.number, "MGEN_UI_FRAMERATE", "Frame rate", "%+02.2f fps", 0, 4, 0.25f, 0.5f);
+        IUFillNumber(&ui.framerate.number, "MGEN_UI_FRAMERATE", "Frame rate", "%+02.2f fps", 0, 10, 0.25f, 0.5f);
         IUFillNumberVector(&ui.framerate.property, &ui.framerate.number, 1, getDeviceName(), "MGEN_UI_OPTIONS", "UI",
                            TAB, IP_RW, 60, IPS_IDLE);
 
@@ -342,6 +353,8 @@ bool MGenAutoguider::Connect()
 
     _D("initiating connection.", "");
 
+    stopPoller();
+
     if (device)
         delete device;
     device = new MGenDevice();
@@ -416,6 +429,7 @@ bool MGenAutoguider::Connect()
                         if (getHeartbeat())
                         {
                             _S("considering device connected", "");
+                            startPoller();
                             /* FIXME: currently no way to tell which timer hit, so set one for the UI only */
                             TimerHit();
                             return device->isConnected();
@@ -444,6 +458,11 @@ bool MGenAutoguider::Connect()
 ***************************************************************************************/
 bool MGenAutoguider::Disconnect()
 {
+    if (!device)
+        return true;
+
+    stopPoller();
+
     if (device->isConnected())
     {
         _D("initiating disconnection.", "");
@@ -476,12 +495,133 @@ IOMode MGenAutoguider::getOpMode() const
  **************************************************************************************/
 void MGenAutoguider::TimerHit()
 {
-    if (device->isConnected())
+    if (!device)
+        return;
+
+    /* The worker disables the device when it stops answering */
+    if (!device->isConnected())
+    {
+        stopPoller();
+        if (isConnected())
+        {
+            setConnected(false, IPS_ALERT);
+            updateProperties();
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> guard(poller.lock);
+
+    if (poller.has_version)
+    {
+        sprintf(version.firmware.text.text, "%04X", poller.fw_version);
+        _D("received version %4.4s", version.firmware.text.text);
+        IDSetText(&version.firmware.property, NULL);
+        poller.has_version = false;
+    }
+
+    if (poller.has_voltages)
+    {
+        voltage.levels.logic.value = poller.logic;
+        _D("received logic voltage %fV (spec is between 4.8V and 5.1V)", voltage.levels.logic.value);
+        voltage.levels.input.value = poller.input;
+        _D("received input voltage %fV (spec is between 9V and 15V)", voltage.levels.input.value);
+        voltage.levels.reference.value = poller.reference;
+        _D("received reference voltage %fV (spec is around 1.23V)", voltage.levels.reference.value);
+
+        /* FIXME: my device has input at 15.07... */
+        if (4.8f <= voltage.levels.logic.value && voltage.levels.logic.value <= 5.1f)
+            if (9.0f <= voltage.levels.input.value && voltage.levels.input.value <= 15.0f)
+                if (1.1 <= voltage.levels.reference.value && voltage.levels.reference.value <= 1.3)
+                    voltage.property.s = IPS_OK;
+                else
+                    voltage.property.s = IPS_ALERT;
+            else
+                voltage.property.s = IPS_ALERT;
+        else
+            voltage.property.s = IPS_ALERT;
+
+        IDSetNumber(&voltage.property, NULL);
+        poller.has_voltages = false;
+    }
+
+    if (poller.has_frame)
+    {
+        std::unique_lock<std::mutex> ccd_guard(ccdBufferLock);
+        memcpy(PrimaryCCD.getFrameBuffer(), poller.frame.data(), poller.frame.size());
+        ccd_guard.unlock();
+        poller.has_frame = false;
+        guard.unlock();
+        ExposureComplete(&PrimaryCCD);
+    }
+    else guard.unlock();
+
+    /* Rearm the timer, use a minimal timer period of 1s, and shorter if frame rate is higher than 1fps */
+    ui.timer = SetTimer(1.0f < ui.framerate.number.value ? (long)(1000.0f / ui.framerate.number.value) : 1000);
+}
+
+/**************************************************************************************
+ * Device protocol thread
+ **************************************************************************************/
+void MGenAutoguider::startPoller()
+{
+    stopPoller();
+
+    std::unique_lock<std::mutex> guard(poller.lock);
+    poller.running      = true;
+    poller.ui_enabled   = ui.is_enabled;
+    poller.ui_framerate = ui.framerate.number.value;
+    poller.buttons.clear();
+    poller.thread = std::thread(&MGenAutoguider::runPoller, this);
+}
+
+void MGenAutoguider::stopPoller()
+{
+    std::unique_lock<std::mutex> guard(poller.lock);
+    poller.running = false;
+    poller.wake.notify_one();
+    guard.unlock();
+
+    if (poller.thread.joinable())
+        poller.thread.join();
+}
+
+void MGenAutoguider::updatePoller()
+{
+    std::unique_lock<std::mutex> guard(poller.lock);
+    poller.ui_enabled   = ui.is_enabled;
+    poller.ui_framerate = ui.framerate.number.value;
+    poller.wake.notify_one();
+}
+
+void MGenAutoguider::runPoller()
+{
+    std::unique_lock<std::mutex> guard(poller.lock);
+
+    while (poller.running && device->isConnected())
         try
         {
+            /* Buttons first, the end-user is waiting for the UI to react */
+            if (!poller.buttons.empty())
+            {
+                MGIO_INSERT_BUTTON::Button const button = (MGIO_INSERT_BUTTON::Button)poller.buttons.front();
+                poller.buttons.pop_front();
+                guard.unlock();
+
+                MGIO_INSERT_BUTTON(button).ask(*device);
+
+                /* Show the outcome without waiting for the next frame */
+                ui.timestamp = { .tv_sec = 0, .tv_nsec = 0 };
+                guard.lock();
+                continue;
+            }
+
+            bool const ui_enabled   = poller.ui_enabled;
+            double const ui_framerate = poller.ui_framerate;
+            guard.unlock();
+
             struct timespec tm = { .tv_sec = 0, .tv_nsec = 0 };
-            if (clock_gettime(CLOCK_MONOTONIC, &tm))
-                return;
+            clock_gettime(CLOCK_MONOTONIC, &tm);
 
             /* If we didn't get the firmware version, ask */
             if (0 == version.timestamp.tv_sec)
@@ -489,9 +629,9 @@ void MGenAutoguider::TimerHit()
                 MGCMD_GET_FW_VERSION cmd;
                 if (CR_SUCCESS == cmd.ask(*device))
                 {
-                    sprintf(version.firmware.text.text, "%04X", cmd.fw_version());
-                    _D("received version %4.4s", version.firmware.text.text);
-                    IDSetText(&version.firmware.property, NULL);
+                    std::unique_lock<std::mutex> result_guard(poller.lock);
+                    poller.fw_version  = cmd.fw_version();
+                    poller.has_version = true;
                 }
                 else
                     _E("failed retrieving firmware version", "");
@@ -513,26 +653,11 @@ void MGenAutoguider::TimerHit()
 
                 if (CR_SUCCESS == adcs.ask(*device))
                 {
-                    voltage.levels.logic.value = adcs.logic_voltage();
-                    _D("received logic voltage %fV (spec is between 4.8V and 5.1V)", voltage.levels.logic.value);
-                    voltage.levels.input.value = adcs.input_voltage();
-                    _D("received input voltage %fV (spec is between 9V and 15V)", voltage.levels.input.value);
-                    voltage.levels.reference.value = adcs.refer_voltage();
-                    _D("received reference voltage %fV (spec is around 1.23V)", voltage.levels.reference.value);
-
-                    /* FIXME: my device has input at 15.07... */
-                    if (4.8f <= voltage.levels.logic.value && voltage.levels.logic.value <= 5.1f)
-                        if (9.0f <= voltage.levels.input.value && voltage.levels.input.value <= 15.0f)
-                            if (1.1 <= voltage.levels.reference.value && voltage.levels.reference.value <= 1.3)
-                                voltage.property.s = IPS_OK;
-                            else
-                                voltage.property.s = IPS_ALERT;
-                        else
-                            voltage.property.s = IPS_ALERT;
-                    else
-                        voltage.property.s = IPS_ALERT;
-
-                    IDSetNumber(&voltage.property, NULL);
+                    std::unique_lock<std::mutex> result_guard(poller.lock);
+                    poller.logic        = adcs.logic_voltage();
+                    poller.input        = adcs.input_voltage();
+                    poller.reference    = adcs.refer_voltage();
+                    poller.has_voltages = true;
                 }
                 else
                     _E("failed retrieving voltages", "");
@@ -541,42 +666,44 @@ void MGenAutoguider::TimerHit()
             }
 
             /* Update UI frame - I'm trading efficiency for code clarity, sorry for the computation with doubles */
-            if (ui.is_enabled && (0 == ui.timestamp.tv_sec || 0 < ui.framerate.number.value))
+            double ui_wait = 1.0f;
+            if (ui_enabled && (0 == ui.timestamp.tv_sec || 0 < ui_framerate))
             {
-                double const ui_period = 1.0f / ui.framerate.number.value;
+                double const ui_period = 0 < ui_framerate ? 1.0f / ui_framerate : 0;
                 double const ui_next =
                     (double)ui.timestamp.tv_sec + (double)ui.timestamp.tv_nsec / 1000000000.0f + ui_period;
                 double const now = tm.tv_sec + tm.tv_nsec / 1000000000.0f;
 
-                if (ui_next < now)
+                if (ui_next <= now)
                 {
                     MGIO_READ_DISPLAY_FRAME read_frame;
 
                     if (CR_SUCCESS == read_frame.ask(*device))
                     {
-                        std::unique_lock<std::mutex> guard(ccdBufferLock);
-                        MGIO_READ_DISPLAY_FRAME::ByteFrame frame;
-                        read_frame.get_frame(frame);
-                        memcpy(PrimaryCCD.getFrameBuffer(), frame.data(), frame.size());
-                        guard.unlock();
-                        ExposureComplete(&PrimaryCCD);
+                        std::unique_lock<std::mutex> result_guard(poller.lock);
+                        read_frame.get_frame(poller.frame);
+                        poller.has_frame = true;
                     }
                     else
                         _E("failed reading remote UI frame", "");
 
                     ui.timestamp = tm;
+                    ui_wait      = ui_period;
                 }
+                else ui_wait = ui_next - now;
             }
 
-            /* Rearm the timer, use a minimal timer period of 1s, and shorter if frame rate is higher than 1fps */
-            ui.timer = SetTimer(1.0f < ui.framerate.number.value ? (long)(1000.0f / ui.framerate.number.value) : 1000);
+            /* Sleep until the next frame is due, or until the end-user clicks a button or changes UI settings */
+            guard.lock();
+            if (poller.running && poller.buttons.empty() && 0 < ui_wait)
+                poller.wake.wait_for(guard, std::chrono::microseconds((long)(std::min(ui_wait, 1.0) * 1000000.0)));
         }
         catch (IOError &e)
         {
             _S("device disconnected (%s)", e.what());
             device->disable();
-            setConnected(false, IPS_ALERT);
-            updateProperties();
+            if (!guard.owns_lock())
+                guard.lock();
         }
 }
 
@@ -590,12 +717,9 @@ bool MGenAutoguider::getHeartbeat()
     {
         heartbeat.no_ack_count++;
         _E("%d times no ack to heartbeat (NOP1 command)", heartbeat.no_ack_count);
+        /* The driver notices the device is disabled and reports the disconnection */
         if (5 < heartbeat.no_ack_count)
-        {
             device->disable();
-            setConnected(false, IPS_ALERT);
-            updateProperties();
-        }
         return false;
     }
     else
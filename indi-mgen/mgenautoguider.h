@@ -110,6 +110,12 @@
     do housework in the available ~2MB.
 */
 
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
 #include "indidevapi.h"
 #include "indiccd.h"
 
@@ -198,6 +204,31 @@ class MGenAutoguider : public INDI::CCD
         heartbeat(): timestamp({ .tv_sec = 0, .tv_nsec = 0 }), no_ack_count(0) {}
     } heartbeat;
 
+  protected:
+    /** \internal The device protocol runs in a worker thread, and TimerHit publishes its results.
+     *
+     * The worker owns the timestamps of the structures above. The driver hands requests over and retrieves results
+     * under the lock.
+     */
+    struct poller
+    {
+        std::thread thread;              /*!< The worker running the device protocol. */
+        std::mutex lock;                 /*!< Protecting the fields below. */
+        std::condition_variable wake;    /*!< Notified when there is a request for the worker. */
+        bool running;                    /*!< Whether the worker should keep on running. */
+        bool ui_enabled;                 /*!< Copy of the remote UI switch. */
+        double ui_framerate;             /*!< Copy of the remote UI frame rate. */
+        std::deque<int> buttons;         /*!< Buttons to insert, oldest first. */
+        bool has_version;                /*!< Whether fw_version is to be published. */
+        unsigned short fw_version;       /*!< Firmware version read by the worker. */
+        bool has_voltages;               /*!< Whether voltages are to be published. */
+        float logic, input, reference;   /*!< Voltages read by the worker. */
+        bool has_frame;                  /*!< Whether frame is to be published. */
+        std::array<unsigned char, 128 * 64> frame; /*!< Remote UI frame read by the worker. */
+        poller(): running(false), ui_enabled(false), ui_framerate(0), has_version(false), fw_version(0),
+            has_voltages(false), logic(0), input(0), reference(0), has_frame(false) {}
+    } poller;
+
   protected:
     virtual bool initProperties();
     virtual bool updateProperties();
@@ -217,6 +248,20 @@ class MGenAutoguider : public INDI::CCD
      * \return false if command was not acknowledged, and disconnect the device after 5 failures.
      */
     bool getHeartbeat();
+
+    /** \internal Starting and stopping the worker thread running the device protocol. */
+    /** @{ */
+    void startPoller();
+    void stopPoller();
+    /** @} */
+
+    /** \internal Copying the remote UI settings to the worker, and waking it up. */
+    void updatePoller();
+
+    /** \internal The worker thread, reading firmware version, heartbeat, voltages and UI frames when due, and inserting
+     * the buttons the end-user clicked.
+     */
+    void runPoller();
 };
 
 #endif // MGENAUTOGUIDER_H
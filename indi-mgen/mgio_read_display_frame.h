@@ -98,8 +98,6 @@ class MGIO_READ_DISPLAY_FRAME : MGC
         if (CR_SUCCESS != MGC::ask(root))
             return CR_FAILURE;
 
-        bitmap_frame.clear();
-
         /* Sorted out from spec and experiment:
          * Query:  IO_FUNC SUBFUNC ADDR_L ADDR_H COUNT for each block
          * Answer: IO_FUNC D0 D1 D2... (COUNT bytes)
@@ -107,44 +105,25 @@ class MGIO_READ_DISPLAY_FRAME : MGC
          * To finish communication (not exactly perfect, but keeps I/O synced)
          * Query:  IO_FUNC 0xFF
          * Answer: IO_FUNC
+         *
+         * We read 8 blocks of 128 bytes, with the query for the next block queued while the current one is read.
          */
-
-        /* We'll read 8 blocks of 128 bytes, not optimal, but it's working */
-        answer.resize(1 + 128);
-
         if (root.lock())
         {
             _D("reading UI frame",0);
 
-            for (unsigned int block = 0; block < 8 * 128; block += 128)
-            {
-                /* Query is using 10 bits of the address over two bytes, then 1 byte for the count */
-                IOByte const length = 128;
-                query[2]            = (unsigned char)((block & 0x03FF) >> 0);
-                query[3]            = (unsigned char)((block & 0x03FF) >> 8);
-                query[4]            = length;
-
-                root.write(query);
-                /* Reply is SUBFUNC plus the frame block */
-                if (root.read(answer) < length + 1)
-                    _E("failed reading frame block, pushing back nonetheless", "");
-                if (opCode() != answer[0])
-                    _E("failed acking frame block, command is desynced, pushing back nonetheless", "");
-                bitmap_frame.insert(bitmap_frame.end(), answer.begin() + 1, answer.end());
-            }
-
-            /* FIXME: don't ever try to reuse this command after ask() was called... */
-            /* Finish with an invalid address to prevent breaking device sync */
-            query.resize(2);
-            query[1] = 0xFF;
-            root.write(query);
-            /* Device replies with opcode only, and subfunc is done */
-            answer.resize(1);
-            root.read(answer);
-
-            _D("done reading UI frame",0);
+            int const blocks = root.readDisplayFrame(opCode(), bitmap_frame);
 
             root.unlock();
+
+            if (blocks < 0)
+                return CR_FAILURE;
+
+            int const missing = (int)(frame_size / 128) - blocks;
+            if (0 < missing)
+                _E("failed reading %d frame blocks, pushing back nonetheless", missing);
+
+            _D("done reading UI frame",0);
         }
 
         return CR_SUCCESS;
@@ -0,0 +1,258 @@
+/*
+    INDI 3rd party driver
+    Lacerta MGen Autoguider INDI driver, implemented with help from
+    Tommy (teleskopaustria@gmail.com) and Zoltan (mgen@freemail.hu).
+
+    Teleskop & Mikroskop Zentrum (www.teleskop.austria.com)
+    A-1050 WIEN, Schönbrunner Strasse 96
+    +43 699 1197 0808 (Shop in Wien und Rechnungsanschrift)
+    A-4020 LINZ, Gärtnerstrasse 16
+    +43 699 1901 2165 (Shop in Linz)
+
+    Lacerta GmbH
+    UmsatzSt. Id. Nr.: AT U67203126
+    Firmenbuch Nr.: FN 379484s
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+ * test_mgen_io.cpp
+ *
+ *  Created on: 18 oct. 2026
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mgen_io.h"
+#include "mgen_mock.h"
+
+typedef std::chrono::steady_clock test_clock;
+
+static double seconds_since(test_clock::time_point start)
+{
+    return std::chrono::duration<double>(test_clock::now() - start).count();
+}
+
+/* Exchanges as MGenDevice did them before: wait 20ms for the device to absorb the query, then read once */
+static int legacy_exchange(MGenLink &link, IOBuffer const &query, IOBuffer &answer)
+{
+    link.write(query.data(), query.size());
+    usleep(20000);
+    return link.read(answer.data(), answer.size());
+}
+
+static int legacy_display_frame(MGenLink &link, IOBuffer &bitmap)
+{
+    IOBuffer query { 0x5D, 0x0D, 0, 0, 128 };
+    IOBuffer answer(1 + 128);
+    int acked = 0;
+
+    bitmap.clear();
+    for (unsigned int block = 0; block < 8 * 128; block += 128)
+    {
+        query[2] = (IOByte)((block & 0x03FF) >> 0);
+        query[3] = (IOByte)((block & 0x03FF) >> 8);
+        if (legacy_exchange(link, query, answer) == (int)answer.size() && 0x5D == answer[0])
+            acked++;
+        bitmap.insert(bitmap.end(), answer.begin() + 1, answer.end());
+    }
+
+    IOBuffer end { 0x5D, 0xFF };
+    answer.resize(1);
+    legacy_exchange(link, end, answer);
+    return acked;
+}
+
+/* Records, each time display block queries are written, how many written before are still unanswered */
+class MGenQueueLink : public MGenMockLink
+{
+  public:
+    std::vector<unsigned int> queued;
+
+    virtual int write(IOByte const *data, int size)
+    {
+        if (5 <= size && 0x5D == data[0] && 0x0D == data[1])
+        {
+            queued.push_back(blocks - bytes / (1 + MGenIO::display_block_size));
+            blocks += size / 5;
+        }
+        return MGenMockLink::write(data, size);
+    }
+
+    virtual int read(IOByte *data, int size)
+    {
+        int const res = MGenMockLink::read(data, size);
+        if (0 < res)
+            bytes += res;
+        return res;
+    }
+
+  private:
+    unsigned int blocks { 0 }, bytes { 0 };
+};
+
+static int exchange(MGenLink &link, IOBuffer const &query, IOBuffer &answer)
+{
+    link.write(query.data(), query.size());
+    return MGenIO::readAnswer(link, answer.data(), answer.size());
+}
+
+TEST(MGenIO, ReadAnswerWaitsForSlowDevice)
+{
+    /* The device takes longer to answer than the latency timer */
+    MGenMockLink link(250000, std::chrono::milliseconds(2), std::chrono::milliseconds(10));
+    IOBuffer nop { 0xFF };
+    IOBuffer answer(1);
+
+    link.write(nop.data(), nop.size());
+    EXPECT_EQ(0, link.read(answer.data(), answer.size()));
+    EXPECT_EQ(1, MGenIO::readAnswer(link, answer.data(), answer.size()));
+    EXPECT_EQ(0xFF, answer[0]);
+}
+
+TEST(MGenIO, ReadAnswerTimesOut)
+{
+    MGenMockLink link;
+    IOBuffer unknown { 0x42 };
+    IOBuffer answer(1);
+
+    link.write(unknown.data(), unknown.size());
+    test_clock::time_point const start = test_clock::now();
+    EXPECT_EQ(0, MGenIO::readAnswer(link, answer.data(), answer.size(), 50));
+    EXPECT_LE(0.05, seconds_since(start));
+}
+
+TEST(MGenIO, ReadAnswerReportsLinkFailure)
+{
+    MGenMockLink link;
+    IOBuffer answer(1);
+
+    link.unplug();
+    EXPECT_GT(0, MGenIO::readAnswer(link, answer.data(), answer.size()));
+    EXPECT_GT(0, MGenIO::readDisplayFrame(link, 0x5D, answer));
+}
+
+TEST(MGenIO, Commands)
+{
+    MGenMockLink link;
+    IOBuffer answer(1 + 2);
+
+    ASSERT_EQ(3, exchange(link, IOBuffer{ 0x03 }, answer));
+    EXPECT_EQ(0x4321, (answer[2] << 8) | answer[1]);
+
+    answer.resize(1 + 5 * 2);
+    ASSERT_EQ(11, exchange(link, IOBuffer{ 0xA0 }, answer));
+    EXPECT_NEAR(5.0f, 1.6813e-4f * ((unsigned short)(answer[2] << 8) | answer[1]), 0.01f);
+    EXPECT_NEAR(12.0f, 3.1364e-4f * ((unsigned short)(answer[4] << 8) | answer[3]), 0.01f);
+    EXPECT_NEAR(1.23f, 3.91e-5f * ((unsigned short)(answer[10] << 8) | answer[9]), 0.01f);
+
+    answer.resize(2);
+    ASSERT_EQ(2, exchange(link, IOBuffer{ 0x5D, 0x01, 0x03 }, answer));
+    ASSERT_EQ(2, exchange(link, IOBuffer{ 0x5D, 0x01, 0x83 }, answer));
+    ASSERT_EQ(1u, link.buttons().size());
+    EXPECT_EQ(0x03, link.buttons().front());
+
+    EXPECT_EQ(4u, link.commandCount());
+}
+
+class MGenDisplayFrame : public ::testing::TestWithParam<unsigned int>
+{
+};
+
+TEST_P(MGenDisplayFrame, ReadsWholeFrame)
+{
+    MGenQueueLink link;
+    IOBuffer bitmap;
+
+    ASSERT_EQ(8, MGenIO::readDisplayFrame(link, 0x5D, bitmap, GetParam()));
+    ASSERT_EQ(MGenIO::display_frame_size, bitmap.size());
+    EXPECT_TRUE(link.display == bitmap);
+
+    /* The first queries go together, then each block read is replaced so that the device always has the next ones */
+    unsigned int const depth = std::min(GetParam(), 8u);
+    ASSERT_EQ(1u + 8u - depth, link.queued.size());
+    EXPECT_EQ(0u, link.queued.front());
+    for (size_t i = 1; i < link.queued.size(); i++)
+        EXPECT_EQ(depth - 1, link.queued[i]);
+
+    /* Eight blocks and the end of subfunction, and the device is still in sync */
+    EXPECT_EQ(9u, link.commandCount());
+    IOBuffer answer(1);
+    EXPECT_EQ(1, exchange(link, IOBuffer{ 0xFF }, answer));
+    EXPECT_EQ(0xFF, answer[0]);
+}
+
+INSTANTIATE_TEST_SUITE_P(Depth, MGenDisplayFrame, ::testing::Values(1u, 2u, 4u, 8u, 16u));
+
+TEST(MGenIO, CommandRate)
+{
+    unsigned int const count = 25;
+    IOBuffer nop { 0xFF };
+    IOBuffer answer(1);
+
+    MGenMockLink legacy_link;
+    test_clock::time_point start = test_clock::now();
+    for (unsigned int i = 0; i < count; i++)
+        ASSERT_EQ(1, legacy_exchange(legacy_link, nop, answer));
+    double const legacy_rate = count / seconds_since(start);
+
+    MGenMockLink link;
+    start = test_clock::now();
+    for (unsigned int i = 0; i < count; i++)
+        ASSERT_EQ(1, exchange(link, nop, answer));
+    double const rate = count / seconds_since(start);
+
+    printf("NOP1: %.0f commands/s, against %.0f commands/s waiting 20ms after each query\n", rate, legacy_rate);
+    EXPECT_EQ(count, legacy_link.commandCount());
+    EXPECT_EQ(count, link.commandCount());
+}
+
+TEST(MGenIO, DisplayFrameRate)
+{
+    unsigned int const count = 5;
+    IOBuffer bitmap;
+
+    MGenQueueLink legacy_link;
+    test_clock::time_point start = test_clock::now();
+    for (unsigned int i = 0; i < count; i++)
+        ASSERT_EQ(8, legacy_display_frame(legacy_link, bitmap));
+    double const legacy_rate = count / seconds_since(start);
+
+    MGenMockLink link;
+    start = test_clock::now();
+    for (unsigned int i = 0; i < count; i++)
+        ASSERT_EQ(8, MGenIO::readDisplayFrame(link, 0x5D, bitmap));
+    double const rate = count / seconds_since(start);
+
+    printf("Display: %.1f frames/s, against %.1f frames/s with one round trip per block\n", rate, legacy_rate);
+
+    /* Same commands, but with one round trip per block nothing is queued while a block is read */
+    EXPECT_EQ(count * 9, legacy_link.commandCount());
+    EXPECT_EQ(count * 9, link.commandCount());
+    ASSERT_EQ(count * 8, legacy_link.queued.size());
+    for (unsigned int const queued : legacy_link.queued)
+        EXPECT_EQ(0u, queued);
+}
@@ -26,10 +26,13 @@
 #include "config.h"
 
 #include <math.h>
+#include <algorithm>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <utility>
 #include <stdlib.h>
+#include <string.h>
 
 #define TEMP_THRESHOLD  0.2  /* Differential temperature threshold (°C) */
 #define TEMP_COOLER_OFF 100  /* High enough temperature for the camera cooler to turn off (°C) */
@@ -220,6 +223,17 @@ bool MICCD::initProperties()
     IUFillNumberVector(&PreflashNP, PreflashN, 2, getDeviceName(), "NIR_PRE_FLASH", "NIR Preflash",
                        MAIN_CONTROL_TAB, IP_RW, 60, IPS_IDLE);
 
+    // Image download progress
+    IUFillNumber(&DownloadN[0], "DOWNLOAD_PROGRESS", "Progress (%)", "%3.0f", 0, 100, 1, 0);
+    IUFillNumberVector(&DownloadNP, DownloadN, 1, getDeviceName(), "CCD_DOWNLOAD", "Download",
+                       MAIN_CONTROL_TAB, IP_RO, 60, IPS_IDLE);
+
+    // Simulated readout speed
+    IUFillNumber(&SimReadoutN[0], "SIM_READOUT_RATE", "Readout (Mpx/s)", "%4.2f", 0.01, 100, 0.1,
+                 simulator.getReadoutRate() / 1e6);
+    IUFillNumberVector(&SimReadoutNP, SimReadoutN, 1, getDeviceName(), "SIM_READOUT", "Simulator",
+                       OPTIONS_TAB, IP_RW, 60, IPS_IDLE);
+
     addAuxControls();
 
     setDriverInterface(getDriverInterface() | FILTER_INTERFACE);
@@ -254,6 +268,11 @@ void MICCD::ISGetProperties(const char *dev)
         if (canDoPreflash)
             defineProperty(&PreflashNP);
 
+        defineProperty(&DownloadNP);
+
+        if (isSimulation())
+            defineProperty(&SimReadoutNP);
+
         if (numFilters > 0)
         {
             INDI::FilterInterface::updateProperties();
@@ -289,6 +308,11 @@ bool MICCD::updateProperties()
         if (canDoPreflash)
             defineProperty(&PreflashNP);
 
+        defineProperty(&DownloadNP);
+
+        if (isSimulation())
+            defineProperty(&SimReadoutNP);
+
         if (numFilters > 0)
         {
             INDI::FilterInterface::updateProperties();
@@ -323,6 +347,11 @@ bool MICCD::updateProperties()
         if (canDoPreflash)
             deleteProperty(PreflashNP.name);
 
+        deleteProperty(DownloadNP.name);
+
+        if (isSimulation())
+            deleteProperty(SimReadoutNP.name);
+
         if (numFilters > 0)
         {
             INDI::FilterInterface::updateProperties();
@@ -345,6 +374,8 @@ bool MICCD::Connect()
         SetCCDCapability(cap);
 
         numFilters = 5;
+        maxBinX    = 4;
+        maxBinY    = 4;
 
         return true;
     }
@@ -411,6 +442,10 @@ bool MICCD::Connect()
 
 bool MICCD::Disconnect()
 {
+    // libgxccd must not be reading an image when the camera is released
+    worker.quit();
+    downloading = false;
+
     LOGF_INFO("Disconnected from %s.", name);
     gxccd_release(cameraHandle);
     cameraHandle = nullptr;
@@ -485,6 +520,7 @@ int MICCD::SetTemperature(double temperature)
 
     TemperatureRequest = temperature;
 
+    std::lock_guard<std::mutex> guard(cameraLock);
     if (!isSimulation() && gxccd_set_temperature(cameraHandle, temperature) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
@@ -501,19 +537,25 @@ bool MICCD::StartExposure(float duration)
     imageFrameType = PrimaryCCD.getFrameType();
     useShutter = (imageFrameType == INDI::CCDChip::LIGHT_FRAME || imageFrameType == INDI::CCDChip::FLAT_FRAME);
 
-    if (!isSimulation())
+    // send binned coords
+    int x = PrimaryCCD.getSubX() / PrimaryCCD.getBinX();
+    int y = PrimaryCCD.getSubY() / PrimaryCCD.getBinY();
+    int w = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
+    int d = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
+    // invert frame, libgxccd has 0 on the bottom
+    int fd = PrimaryCCD.getYRes() / PrimaryCCD.getBinY();
+    int fy = fd - y - d;
+
+    if (isSimulation())
     {
+        simulator.setBinning(PrimaryCCD.getBinX(), PrimaryCCD.getBinY());
+        simulator.startExposure(duration, x, fy, w, d);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> guard(cameraLock);
         int mode = IUFindOnSwitchIndex(&ReadModeSP);
         gxccd_set_read_mode(cameraHandle, mode);
-
-        // send binned coords
-        int x = PrimaryCCD.getSubX() / PrimaryCCD.getBinX();
-        int y = PrimaryCCD.getSubY() / PrimaryCCD.getBinY();
-        int w = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
-        int d = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
-        // invert frame, libgxccd has 0 on the bottom
-        int fd = PrimaryCCD.getYRes() / PrimaryCCD.getBinY();
-        int fy = fd - y - d;
         gxccd_start_exposure(cameraHandle, duration, useShutter, x, fy, w, d);
     }
 
@@ -529,8 +571,20 @@ bool MICCD::StartExposure(float duration)
 
 bool MICCD::AbortExposure()
 {
-    if (InExposure && !isSimulation())
+    // The simulated readout stops at once, a camera download is completed and discarded
+    if (downloading)
     {
+        worker.quit();
+        downloading = false;
+        DownloadNP.s = IPS_IDLE;
+        IDSetNumber(&DownloadNP, nullptr);
+    }
+
+    if (InExposure && isSimulation())
+        simulator.abortExposure();
+    else if (InExposure)
+    {
+        std::lock_guard<std::mutex> guard(cameraLock);
         if (gxccd_abort_exposure(cameraHandle, false) < 0)
         {
             char errorStr[MAX_ERROR_LEN];
@@ -585,7 +639,8 @@ bool MICCD::UpdateCCDBin(int hor, int ver)
                    hor, ver, maxBinX, maxBinY);
         return false;
     }
-    if (gxccd_set_binning(cameraHandle, hor, ver) < 0)
+    std::lock_guard<std::mutex> guard(cameraLock);
+    if (!isSimulation() && gxccd_set_binning(cameraHandle, hor, ver) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
         gxccd_get_last_error(cameraHandle, errorStr, sizeof(errorStr));
@@ -606,67 +661,81 @@ float MICCD::calcTimeLeft()
     return ExposureRequest - timesince / 1000.0;
 }
 
-static void mirror_image(void *buf, size_t w, size_t d)
+double MICCD::downloadProgress()
 {
-    size_t w2     = w * 2;
-    size_t half_d = d / 2;
+    if (isSimulation())
+        return simulator.getProgress();
 
-    for (size_t line = 1; line <= half_d; line++)
-    {
-        uint16_t *sa = (uint16_t *)((char *)buf + (line - 1) * w2);
-        uint16_t *da = (uint16_t *)((char *)buf + (d - line) * w2);
-        for (size_t index = 1; index <= w; index++)
-        {
-            uint16_t tmp = *sa;
-            *sa          = *da;
-            *da          = tmp;
-            ++sa;
-            ++da;
-        }
-    }
+    // gxccd_read_image() reports no progress, estimate it from the speed of the previous downloads
+    double rate = downloadRate;
+    if (rate <= 0 || downloadSize == 0)
+        return 0;
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - downloadStart).count();
+    return std::min(0.99, elapsed * rate / downloadSize);
 }
 
-/* Downloads the image from the CCD. */
-int MICCD::grabImage()
+/* Downloads the image from the CCD. Runs on the worker thread. */
+void MICCD::downloadImage(const std::atomic_bool &isAboutToQuit, int width, int height)
 {
-    std::unique_lock<std::mutex> guard(ccdBufferLock);
-    int ret              = 0;
-    unsigned char *image = (unsigned char *)PrimaryCCD.getFrameBuffer();
-    int width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
-    int height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
+    int ret         = 0;
+    size_t lineSize = width * 2;
+    size_t size     = lineSize * height;
+
+    // The readout buffer is reused for every frame, it only grows when a larger frame is requested
+    if (readoutBuffer.size() < size)
+        readoutBuffer.resize(size);
 
     if (isSimulation())
+        ret = simulator.readImage(readoutBuffer.data(), size, isAboutToQuit);
+    else
     {
-        uint16_t *buffer = (uint16_t *)image;
-
-        for (int i = 0; i < height; i++)
-            for (int j = 0; j < width; j++)
-                buffer[i * width + j] = rand() % UINT16_MAX;
+        std::lock_guard<std::mutex> guard(cameraLock);
+        ret = gxccd_read_image(cameraHandle, readoutBuffer.data(), size);
     }
-    else
+
+    if (isAboutToQuit)
+        return;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - downloadStart).count();
+
+    if (ret < 0 || size > static_cast<size_t>(PrimaryCCD.getFrameBufferSize()))
     {
-        ret = gxccd_read_image(cameraHandle, image, PrimaryCCD.getFrameBufferSize());
-        if (ret < 0)
-        {
-            char errorStr[MAX_ERROR_LEN];
+        char errorStr[MAX_ERROR_LEN] = "simulated readout failed";
+        if (!isSimulation())
             gxccd_get_last_error(cameraHandle, errorStr, sizeof(errorStr));
-            LOGF_ERROR("Error getting image: %s.", errorStr);
-        }
-        else
-        {
-            mirror_image(image, width, height);
-        }
+        LOGF_ERROR("Error getting image: %s.", errorStr);
+
+        downloadFailed = true;
+        downloading    = false;
+        PrimaryCCD.setExposureFailed();
+        return;
     }
 
-    guard.unlock();
+    if (seconds > 0)
+    {
+        double rate = size / seconds;
+        downloadRate = (downloadRate > 0) ? 0.7 * downloadRate + 0.3 * rate : rate;
+    }
 
-    if (ExposureRequest > 5 && !ret)
+    // libgxccd has the bottom line first, copying the lines in reverse order flips the image in the same pass
+    {
+        std::unique_lock<std::mutex> guard(ccdBufferLock);
+        uint8_t *image = PrimaryCCD.getFrameBuffer();
+        const uint8_t *source = readoutBuffer.data() + (height - 1) * lineSize;
+
+        for (int line = 0; line < height; line++, source -= lineSize)
+            memcpy(image + line * lineSize, source, lineSize);
+    }
+
+    LOGF_DEBUG("Downloaded %dx%d in %.2fs (%.1f MB/s), event loop delayed by %.0f ms at most.", width, height, seconds,
+               size / seconds / 1e6, loopDelayMax.load());
+
+    if (ExposureRequest > 5)
         LOG_INFO("Download complete.");
 
     downloading = false;
     ExposureComplete(&PrimaryCCD);
-
-    return ret;
 }
 
 void MICCD::TimerHit()
@@ -674,16 +743,24 @@ void MICCD::TimerHit()
     if (!isConnected())
         return; // No need to reset timer if we are not connected anymore
 
+    auto now = std::chrono::steady_clock::now();
+
     if (InExposure)
     {
         float timeleft = calcTimeLeft();
         bool ready     = false;
 
-        if (!downloading && (gxccd_image_ready(cameraHandle, &ready) < 0))
+        if (isSimulation())
+            ready = simulator.imageReady();
+        else if (!downloading)
         {
-            char errorStr[MAX_ERROR_LEN];
-            gxccd_get_last_error(cameraHandle, errorStr, sizeof(errorStr));
-            LOGF_ERROR("Getting image ready failed: %s.", errorStr);
+            std::lock_guard<std::mutex> guard(cameraLock);
+            if (gxccd_image_ready(cameraHandle, &ready) < 0)
+            {
+                char errorStr[MAX_ERROR_LEN];
+                gxccd_get_last_error(cameraHandle, errorStr, sizeof(errorStr));
+                LOGF_ERROR("Getting image ready failed: %s.", errorStr);
+            }
         }
         if (ready)
         {
@@ -695,8 +772,18 @@ void MICCD::TimerHit()
             if (ExposureRequest > 5)
                 LOG_INFO("Exposure done, downloading image...");
 
-            // grab and save image
-            grabImage();
+            DownloadN[0].value = 0;
+            DownloadNP.s       = IPS_BUSY;
+            IDSetNumber(&DownloadNP, nullptr);
+
+            // grab and save image on the worker, the event loop keeps serving clients meanwhile
+            int width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
+            int height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
+            downloadSize   = static_cast<size_t>(width) * height * 2;
+            downloadStart  = now;
+            downloadFailed = false;
+            loopDelayMax   = 0;
+            worker.start(std::bind(&MICCD::downloadImage, this, std::placeholders::_1, width, height));
         }
         // camera may need some time for image download -> update client only for positive values
         else if (timeleft >= 0)
@@ -705,7 +792,25 @@ void MICCD::TimerHit()
             PrimaryCCD.setExposureLeft(timeleft);
         }
     }
+    else if (downloading)
+    {
+        // How late this timer fired tells how responsive the event loop is during the download
+        double interval = std::chrono::duration<double, std::milli>(now - lastTimerHit).count();
+        loopDelayMax = std::max(loopDelayMax.load(), interval - getCurrentPollingPeriod());
+
+        DownloadN[0].value = downloadProgress() * 100;
+        IDSetNumber(&DownloadNP, nullptr);
+    }
+    else if (DownloadNP.s == IPS_BUSY)
+    {
+        // The worker is done, the property is only updated from the event loop
+        if (!downloadFailed)
+            DownloadN[0].value = 100;
+        DownloadNP.s = downloadFailed ? IPS_ALERT : IPS_OK;
+        IDSetNumber(&DownloadNP, nullptr);
+    }
 
+    lastTimerHit = now;
     SetTimer(getCurrentPollingPeriod());
 }
 
@@ -716,6 +821,7 @@ int MICCD::QueryFilter()
 
 bool MICCD::SelectFilter(int position)
 {
+    std::lock_guard<std::mutex> guard(cameraLock);
     if (!isSimulation() && gxccd_set_filter(cameraHandle, position - 1) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
@@ -732,6 +838,7 @@ bool MICCD::SelectFilter(int position)
 
 IPState MICCD::GuideNorth(uint32_t ms)
 {
+    std::lock_guard<std::mutex> guard(cameraLock);
     if (gxccd_move_telescope(cameraHandle, 0, static_cast<int16_t>(ms)) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
@@ -744,6 +851,7 @@ IPState MICCD::GuideNorth(uint32_t ms)
 
 IPState MICCD::GuideSouth(uint32_t ms)
 {
+    std::lock_guard<std::mutex> guard(cameraLock);
     if (gxccd_move_telescope(cameraHandle, 0, (-1 * static_cast<int16_t>(ms))) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
@@ -756,6 +864,7 @@ IPState MICCD::GuideSouth(uint32_t ms)
 
 IPState MICCD::GuideEast(uint32_t ms)
 {
+    std::lock_guard<std::mutex> guard(cameraLock);
     if (gxccd_move_telescope(cameraHandle, (-1 * static_cast<int16_t>(ms)), 0) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
@@ -768,6 +877,7 @@ IPState MICCD::GuideEast(uint32_t ms)
 
 IPState MICCD::GuideWest(uint32_t ms)
 {
+    std::lock_guard<std::mutex> guard(cameraLock);
     if (gxccd_move_telescope(cameraHandle, static_cast<int16_t>(ms), 0) < 0)
     {
         char errorStr[MAX_ERROR_LEN];
@@ -800,6 +910,7 @@ bool MICCD::ISNewSwitch(const char *dev, const char *name, ISState *states, char
                 bool on = !IUFindOnSwitchIndex(&CoolerSP);
                 double temp = on ? TemperatureRequest : TEMP_COOLER_OFF;
 
+                std::lock_guard<std::mutex> guard(cameraLock);
                 if (gxccd_set_temperature(cameraHandle, temp) < 0)
                 {
                     char errorStr[MAX_ERROR_LEN];
@@ -841,6 +952,7 @@ bool MICCD::ISNewNumber(const char *dev, const char *name, double values[], char
         {
             IUUpdateNumber(&FanNP, values, names, n);
 
+            std::lock_guard<std::mutex> guard(cameraLock);
             if (!isSimulation() && gxccd_set_fan(cameraHandle, FanN[0].value) < 0)
             {
                 char errorStr[MAX_ERROR_LEN];
@@ -861,6 +973,7 @@ bool MICCD::ISNewNumber(const char *dev, const char *name, double values[], char
         {
             IUUpdateNumber(&WindowHeatingNP, values, names, n);
 
+            std::lock_guard<std::mutex> guard(cameraLock);
             if (!isSimulation() && gxccd_set_window_heating(cameraHandle, WindowHeatingN[0].value) < 0)
             {
                 char errorStr[MAX_ERROR_LEN];
@@ -884,6 +997,7 @@ bool MICCD::ISNewNumber(const char *dev, const char *name, double values[], char
             // set NIR pre-flash if available.
             if (canDoPreflash)
             {
+                std::lock_guard<std::mutex> guard(cameraLock);
                 if (!isSimulation() && gxccd_set_preflash(cameraHandle, PreflashN[0].value, PreflashN[1].value) < 0)
                 {
                     char errorStr[MAX_ERROR_LEN];
@@ -901,10 +1015,20 @@ bool MICCD::ISNewNumber(const char *dev, const char *name, double values[], char
             return true;
         }
 
+        if (!strcmp(name, SimReadoutNP.name))
+        {
+            IUUpdateNumber(&SimReadoutNP, values, names, n);
+            simulator.setReadoutRate(SimReadoutN[0].value * 1e6);
+            SimReadoutNP.s = IPS_OK;
+            IDSetNumber(&SimReadoutNP, nullptr);
+            return true;
+        }
+
         if (!strcmp(name, GainNP.name))
         {
             IUUpdateNumber(&GainNP, values, names, n);
 
+            std::lock_guard<std::mutex> guard(cameraLock);
             if (!isSimulation() && gxccd_set_gain(cameraHandle, static_cast<uint16_t>(GainN[0].value)) < 0)
             {
                 char errorStr[MAX_ERROR_LEN];
@@ -937,6 +1061,14 @@ void MICCD::updateTemperature()
     float ccdpower = 0;
     int err        = 0;
 
+    // Skip this reading while the worker downloads an image, the camera is busy
+    std::unique_lock<std::mutex> guard(cameraLock, std::defer_lock);
+    if (!isSimulation() && !guard.try_lock())
+    {
+        temperatureID = IEAddTimer(getCurrentPollingPeriod(), MICCD::updateTemperatureHelper, this);
+        return;
+    }
+
     if (isSimulation())
     {
         ccdtemp = TemperatureNP[0].getValue();
@@ -1025,6 +1157,7 @@ void MICCD::addFITSKeywords(INDI::CCDChip *targetChip, std::vector<INDI::FITSRec
     if (hasGain)
         fitsKeywords.push_back({"GAIN", GainN[0].value, 3, "Gain"});
 
+    std::lock_guard<std::mutex> guard(cameraLock);
     if (!gxccd_get_integer_parameter(cameraHandle, GIP_MAX_PIXEL_VALUE, &ivalue))
         fitsKeywords.push_back({"DATAMAX", ivalue, nullptr});
 
@@ -25,6 +25,14 @@
 
 #include <indiccd.h>
 #include <indifilterinterface.h>
+#include <indisinglethreadpool.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "mi_simulator.h"
 
 class MICCD : public INDI::CCD, public INDI::FilterInterface
 {
@@ -89,6 +97,12 @@ class MICCD : public INDI::CCD, public INDI::FilterInterface
         INumber PreflashN[2];
         INumberVectorProperty PreflashNP;
 
+        INumber DownloadN[1];
+        INumberVectorProperty DownloadNP;
+
+        INumber SimReadoutN[1];
+        INumberVectorProperty SimReadoutNP;
+
     private:
         char name[MAXINDIDEVICE];
 
@@ -111,7 +125,7 @@ class MICCD : public INDI::CCD, public INDI::FilterInterface
         int temperatureID;
         int timerID;
 
-        bool downloading;
+        std::atomic_bool downloading { false };
 
         bool canDoPreflash;
 
@@ -124,7 +138,22 @@ class MICCD : public INDI::CCD, public INDI::FilterInterface
         bool setupParams();
 
         float calcTimeLeft();
-        int grabImage();
+        void downloadImage(const std::atomic_bool &isAboutToQuit, int width, int height);
+        double downloadProgress();
+
+        // Image download, off the event loop
+        INDI::SingleThreadPool worker;
+        std::vector<uint8_t> readoutBuffer;
+        // Serializes libgxccd between the download worker and the event loop
+        std::mutex cameraLock;
+        std::chrono::steady_clock::time_point downloadStart;
+        std::atomic<double> downloadRate { 0 };      // bytes per second, averaged over the last downloads
+        std::atomic<size_t> downloadSize { 0 };
+        std::atomic_bool downloadFailed { false };
+        std::atomic<double> loopDelayMax { 0 };      // ms the event loop was late during the download
+        std::chrono::steady_clock::time_point lastTimerHit;
+
+        MISimulator simulator;
 
         void updateTemperature();
         static void updateTemperatureHelper(void *);
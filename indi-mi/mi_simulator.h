@@ -0,0 +1,105 @@
+/*
+ Moravian INDI Driver - Camera simulator
+
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Stands in for libgxccd when the driver runs in simulation.
+ *
+ * The exposure and the readout take real time: the image becomes ready when the exposure
+ * time expires and readImage() blocks while the rows are transferred at the readout rate,
+ * like gxccd_read_image() does. The frame is a synthetic star field over bias, dark current,
+ * sky gradient and read noise, in the libgxccd orientation (first row at the bottom).
+ */
+class MISimulator
+{
+    public:
+        MISimulator(int width = 4032, int height = 2688);
+
+        int getWidth() const
+        {
+            return chipWidth;
+        }
+
+        int getHeight() const
+        {
+            return chipHeight;
+        }
+
+        /** Readout speed in (binned) pixels per second */
+        void setReadoutRate(double pixelsPerSecond);
+        double getReadoutRate() const
+        {
+            return readoutRate;
+        }
+
+        void setBinning(int x, int y);
+
+        /** Same arguments as gxccd_start_exposure(): binned coordinates, y from the bottom of the chip */
+        void startExposure(double duration, int x, int y, int w, int d);
+        void abortExposure();
+
+        bool imageReady() const;
+
+        /**
+         * @brief Transfers the image, taking the readout time.
+         * @param cancel checked between rows, the readout fails if it becomes true.
+         * @return 0 on success, -1 if no image is ready, the buffer is too small or the readout was cancelled.
+         */
+        int readImage(void *buf, size_t size, const std::atomic_bool &cancel);
+
+        /** Fraction of the current readout already transferred, 0 to 1 */
+        double getProgress() const
+        {
+            return progress;
+        }
+
+    private:
+        struct Star
+        {
+            double x, y;    // unbinned chip coordinates, y from the bottom
+            double flux;    // ADU per second at the peak
+        };
+
+        void renderRow(uint16_t *row, int y, std::vector<double> &line);
+
+        int chipWidth;
+        int chipHeight;
+        double readoutRate { 2.0e6 };
+        int binX { 1 };
+        int binY { 1 };
+
+        mutable std::mutex exposureLock;
+        bool exposing { false };
+        std::chrono::steady_clock::time_point exposureEnd;
+        double exposureTime { 0 };
+        int frameX { 0 }, frameY { 0 }, frameW { 0 }, frameD { 0 };
+
+        std::atomic<double> progress { 0 };
+        std::vector<Star> stars;
+        uint32_t seed { 1 };
+};
@@ -0,0 +1,120 @@
+/*
+ Moravian INDI Driver - Camera simulator tests
+
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <gtest/gtest.h>
+
+#include "mi_simulator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <thread>
+
+namespace
+{
+// Median of a band of rows, so stars do not weigh in
+double bandLevel(std::vector<uint16_t> image, int width, int first, int last)
+{
+    auto begin = image.begin() + first * width, end = image.begin() + (last + 1) * width;
+    std::nth_element(begin, begin + (end - begin) / 2, end);
+    return *(begin + (end - begin) / 2);
+}
+}
+
+TEST(MISimulator, ExposureTakesItsTime)
+{
+    MISimulator simulator(1000, 800);
+    std::vector<uint16_t> image(1000 * 800);
+    std::atomic_bool cancel { false };
+
+    simulator.startExposure(0.2, 0, 0, 1000, 800);
+    EXPECT_FALSE(simulator.imageReady());
+    EXPECT_EQ(simulator.readImage(image.data(), image.size() * 2, cancel), -1);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    EXPECT_TRUE(simulator.imageReady());
+
+    // A buffer too small is refused, as by gxccd_read_image()
+    EXPECT_EQ(simulator.readImage(image.data(), 1000, cancel), -1);
+}
+
+TEST(MISimulator, ReadoutRateAndOrientation)
+{
+    MISimulator simulator(1000, 800);
+    simulator.setReadoutRate(2e6);
+
+    std::vector<uint16_t> image(1000 * 800);
+    std::atomic_bool cancel { false };
+
+    simulator.startExposure(10, 0, 0, 1000, 800);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(simulator.imageReady());
+
+    // Full frame at 2 Mpx/s takes 0.4 s. Rows are paced with sleep_until, which never returns early,
+    // so only the lower bound holds on a loaded machine.
+    simulator.startExposure(0, 0, 0, 1000, 800);
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_EQ(simulator.readImage(image.data(), image.size() * 2, cancel), 0);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(seconds, 0.4 - 1e-3);
+    EXPECT_DOUBLE_EQ(simulator.getProgress(), 1.0);
+
+    // Zero seconds exposure, only bias and read noise
+    EXPECT_NEAR(bandLevel(image, 1000, 0, 799), 1000, 2);
+
+    // The sky is brighter at the top of the chip, which libgxccd sends last
+    simulator.startExposure(10, 0, 0, 1000, 800);
+    simulator.abortExposure();
+    simulator.startExposure(0.5, 0, 0, 1000, 800);
+    std::this_thread::sleep_for(std::chrono::milliseconds(550));
+    simulator.setReadoutRate(1e9);
+    ASSERT_EQ(simulator.readImage(image.data(), image.size() * 2, cancel), 0);
+    EXPECT_LT(bandLevel(image, 1000, 0, 99) + 5, bandLevel(image, 1000, 700, 799));
+}
+
+TEST(MISimulator, ReadoutCanBeCancelled)
+{
+    MISimulator simulator(1000, 800);
+    simulator.setReadoutRate(1e6);
+
+    std::vector<uint16_t> image(1000 * 800);
+    std::atomic_bool cancel { false };
+
+    simulator.startExposure(0, 0, 0, 1000, 800);
+    auto readout = std::async(std::launch::async, [&]
+    {
+        return simulator.readImage(image.data(), image.size() * 2, cancel);
+    });
+
+    // Cancel once the first rows are out, the 0.8 s readout is then left unfinished
+    for (int i = 0; i < 1000 && simulator.getProgress() == 0; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_GT(simulator.getProgress(), 0);
+
+    cancel = true;
+    EXPECT_EQ(readout.get(), -1);
+    EXPECT_LT(simulator.getProgress(), 1);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -27,12 +27,12 @@
 *******************************************************************************/
 #include "nex_dome.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <unistd.h>
 #include <string.h>
 #include <memory>
 #include <regex>
-#include <termios.h>
 
 #include <indicom.h>
 #include <cmath>
@@ -163,6 +163,12 @@ bool NexDome::Handshake()
     std::string value;
     bool rotatorOK = false;
 
+    if (!m_Channel.start(PortFD))
+    {
+        LOG_ERROR("Failed to start the serial reader.");
+        return false;
+    }
+
     if (getParameter(ND::SEMANTIC_VERSION, ND::ROTATOR, value))
     {
         LOGF_INFO("Detected rotator firmware version %s", value.c_str());
@@ -196,9 +202,22 @@ bool NexDome::Handshake()
     else
         LOG_WARN("No shutter detected.");
 
+    if (!rotatorOK)
+        m_Channel.stop();
+
     return rotatorOK;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+///
+//////////////////////////////////////////////////////////////////////////////
+bool NexDome::Disconnect()
+{
+    // The reader must let go of the port before it is closed
+    m_Channel.stop();
+    return INDI::Dome::Disconnect();
+}
+
 //////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////
@@ -591,10 +610,7 @@ bool NexDome::Sync(double az)
 ///////////////////////////////////////////////////////////////////////////////
 void NexDome::TimerHit()
 {
-    std::string response;
-
-    if (checkEvents(response))
-        processEvent(response);
+    processEvents();
 
     if (getDomeState() == DOME_MOVING || getDomeState() == DOME_PARKING)
     {
@@ -819,6 +835,9 @@ bool NexDome::getStartupValues()
         return false;
     }
 
+    // Events received while reading the settings, e.g. the XBee state
+    processEvents();
+
     // Rotator State
     if (getParameter(ND::REPORT, ND::ROTATOR, value))
         processEvent(value);
@@ -871,14 +890,16 @@ bool NexDome::setParameter(ND::Commands command, ND::Targets target, int32_t val
         cmd << "W";
     cmd << ((target == ND::ROTATOR) ? "R" : "S");
 
+    // The response echoes the command without its value
+    std::string prefix = cmd.str().substr(1);
+
     if (value != -1e6)
     {
         cmd << ",";
         cmd << value;
     }
 
-    char res[ND::DRIVER_LEN] = {0};
-    return sendCommand(cmd.str().c_str(), res);
+    return sendCommand(cmd.str(), prefix);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -908,7 +929,7 @@ bool NexDome::executeFactoryCommand(uint8_t command, ND::Targets target)
 
     cmd << ((target == ND::ROTATOR) ? "R" : "S");
 
-    return sendCommand(cmd.str().c_str());
+    return sendCommand(cmd.str());
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -916,10 +937,8 @@ bool NexDome::executeFactoryCommand(uint8_t command, ND::Targets target)
 //////////////////////////////////////////////////////////////////////////////
 bool NexDome::getParameter(ND::Commands command, ND::Targets target, std::string &value)
 {
-    char res[ND::DRIVER_LEN] = {0};
-    bool response_found = false;
-
     std::string verb = ND::CommandsMap.at(command) + "R";
+    std::string targetID = (target == ND::ROTATOR) ? "R" : "S";
 
     std::ostringstream cmd;
     // Magic start character
@@ -927,68 +946,39 @@ bool NexDome::getParameter(ND::Commands command, ND::Targets target, std::string
     // Command verb
     cmd << verb;
     // Target (Rotator or Shutter)
-    cmd << ((target == ND::ROTATOR) ? "R" : "S");
-
-    if (sendCommand(cmd.str().c_str(), res))
-    {
-        std::string response(res);
-
-        // Since we can get many unrelated responses from the firmware
-        // i.e. events, we need to parse all responses, and see which
-        // one is related to our get command.
-        std::vector<std::string> all = split(response, "\r\n");
-
-        // Let's find our match using this regex
-        std::regex re;
-
-        // Firmware is exception since the response does not include the target
-        // for everything else, the echo back includes the target.
-        if (command != ND::SEMANTIC_VERSION)
-            re = (verb + ((target == ND::ROTATOR) ? "R" : "S") + "([^#]+)");
-        else
-            re = (verb + "([^#]+)");
-
-        std::smatch match;
+    cmd << targetID;
+
+    // The response echoes the command back. Firmware is exception since the response
+    // does not include the target, and the status report is the same line as the report event.
+    std::string prefix;
+    if (command == ND::SEMANTIC_VERSION)
+        prefix = verb;
+    else if (command == ND::REPORT)
+        prefix = ND::EventsMap.at((target == ND::ROTATOR) ? ND::ROTATOR_REPORT : ND::SHUTTER_REPORT);
+    else
+        prefix = verb + targetID;
 
-        // Not iterate over all responses
-        for (auto &oneEvent : all)
-        {
-            std::string trimmedEvent = trim(oneEvent);
+    // Unrelated lines received meanwhile are queued by the channel as events
+    std::string response;
+    if (!sendCommand(cmd.str(), prefix, &response))
+        return false;
 
-            // If we find the match, tag it.
-            if (std::regex_search(trimmedEvent, match, re))
-            {
-                value = match.str(1);
-                response_found = true;
-            }
-            // Otherwise process the event
-            else
-                processEvent(trimmedEvent);
-        }
-    }
+    // Reports are passed whole to processEvent()
+    value = (command == ND::REPORT) ? response : response.substr(prefix.size());
 
-    return response_found;
+    return !value.empty();
 }
 
 //////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////
-bool NexDome::checkEvents(std::string &response)
+void NexDome::processEvents()
 {
-    int nbytes_read = 0;
-    char res[ND::DRIVER_LEN] = {0};
+    std::vector<std::string> events;
+    m_Channel.drainEvents(events);
 
-    int rc = tty_nread_section(PortFD, res, ND::DRIVER_LEN, ND::DRIVER_EVENT_CHAR, ND::DRIVER_EVENT_TIMEOUT, &nbytes_read);
-
-    if (rc != TTY_OK || nbytes_read < 3)
-        return false;
-
-    std::string raw_response = res;
-
-    // Trim
-    response = trim(raw_response);
-
-    return true;
+    for (const auto &event : events)
+        processEvent(event);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1302,80 +1292,43 @@ bool NexDome::processShutterReport(const std::string &report)
 //////////////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////////////
-bool NexDome::sendCommand(const char * cmd, char * res, int cmd_len, int res_len)
+bool NexDome::sendCommand(const std::string &cmd, const std::string &prefix, std::string *res)
 {
-    int nbytes_written = 0, nbytes_read = 0, rc = -1;
-
-    tcflush(PortFD, TCIOFLUSH);
+    LOGF_DEBUG("CMD <%s>", cmd.c_str());
 
-    if (cmd_len > 0)
+    if (prefix.empty())
     {
-        char hex_cmd[ND::DRIVER_LEN * 3] = {0};
-        hexDump(hex_cmd, cmd, cmd_len);
-        LOGF_DEBUG("CMD <%s>", hex_cmd);
-        rc = tty_write(PortFD, cmd, cmd_len, &nbytes_written);
-    }
-    else
-    {
-        LOGF_DEBUG("CMD <%s>", cmd);
-        char cmd_terminated[ND::DRIVER_LEN * 2] = {0};
-        snprintf(cmd_terminated, ND::DRIVER_LEN * 2, "%s\r\n", cmd);
-        rc = tty_write_string(PortFD, cmd_terminated, &nbytes_written);
+        if (!m_Channel.send(cmd))
+        {
+            LOGF_ERROR("Serial write error: %s.", strerror(errno));
+            return false;
+        }
+        return true;
     }
 
-    if (rc != TTY_OK)
+    std::string response;
+    switch (m_Channel.request(cmd, prefix, response, ND::DRIVER_TIMEOUT * 1000))
     {
-        char errstr[MAXRBUF] = {0};
-        tty_error_msg(rc, errstr, MAXRBUF);
-        LOGF_ERROR("Serial write error: %s.", errstr);
-        return false;
-    }
-
-    if (res == nullptr)
-        return true;
+        case NexDomeChannel::REQUEST_OK:
+            break;
 
-    if (res_len > 0)
-        rc = tty_read(PortFD, res, res_len, ND::DRIVER_TIMEOUT, &nbytes_read);
-    else
-        rc = tty_nread_section(PortFD, res, ND::DRIVER_LEN, ND::DRIVER_STOP_CHAR, ND::DRIVER_TIMEOUT, &nbytes_read);
+        case NexDomeChannel::REQUEST_TIMEOUT:
+            LOGF_ERROR("Serial read error: timed out waiting for %s response.", prefix.c_str());
+            return false;
 
-    if (rc != TTY_OK)
-    {
-        char errstr[MAXRBUF] = {0};
-        tty_error_msg(rc, errstr, MAXRBUF);
-        LOGF_ERROR("Serial read error: %s.", errstr);
-        return false;
+        case NexDomeChannel::REQUEST_ERROR:
+            LOGF_ERROR("Serial communication error: %s.", m_Channel.isRunning() ? strerror(errno) : "port closed");
+            return false;
     }
 
-    if (res_len > 0)
-    {
-        char hex_res[ND::DRIVER_LEN * 3] = {0};
-        hexDump(hex_res, res, res_len);
-        LOGF_DEBUG("RES <%s>", hex_res);
-    }
-    else
-    {
-        res[nbytes_read - 1] = 0;
-        LOGF_DEBUG("RES <%s>", res);
-    }
+    LOGF_DEBUG("RES <%s>", response.c_str());
 
-    tcflush(PortFD, TCIOFLUSH);
+    if (res)
+        *res = std::move(response);
 
     return true;
 }
 
-//////////////////////////////////////////////////////////////////////////////
-///
-//////////////////////////////////////////////////////////////////////////////
-void NexDome::hexDump(char * buf, const char * data, int size)
-{
-    for (int i = 0; i < size; i++)
-        sprintf(buf + 3 * i, "%02X ", static_cast<uint8_t>(data[i]));
-
-    if (size > 0)
-        buf[3 * size - 1] = '\0';
-}
-
 //////////////////////////////////////////////////////////////////////
 ///
 //////////////////////////////////////////////////////////////////////
@@ -34,6 +34,7 @@
 #include <sys/time.h>
 
 #include "nex_dome_constants.h"
+#include "nex_dome_channel.h"
 
 class NexDome : public INDI::Dome
 {
@@ -50,6 +51,7 @@ class NexDome : public INDI::Dome
 
     protected:
         bool Handshake() override;
+        bool Disconnect() override;
         void TimerHit() override;
 
         // Motion
@@ -135,10 +137,9 @@ class NexDome : public INDI::Dome
         ///////////////////////////////////////////////////////////////////////////////
         bool setParameter(ND::Commands command, ND::Targets target, int32_t value = -1e6);
         bool getParameter(ND::Commands command, ND::Targets target, std::string &value);
-        bool checkEvents(std::string &response);
+        void processEvents();
         bool processEvent(const std::string &event);
-        bool sendCommand(const char * cmd, char * res = nullptr, int cmd_len = -1, int res_len = -1);
-        void hexDump(char * buf, const char * data, int size);
+        bool sendCommand(const std::string &cmd, const std::string &prefix = "", std::string *res = nullptr);
 
         std::string &ltrim(std::string &str, const std::string &chars = "\t\n\v\f\r ");
         std::string &rtrim(std::string &str, const std::string &chars = "\t\n\v\f\r ");
@@ -152,5 +153,8 @@ class NexDome : public INDI::Dome
         int32_t m_TargetAZSteps {1000000};
         double StepsPerDegree { 153.0 };
 
+        // Owns the port once connected, responses and events are read by its thread
+        NexDomeChannel m_Channel;
+
 };
 
@@ -0,0 +1,228 @@
+/*******************************************************************************
+ NexDome
+
+ Copyright(c) 2026. All rights reserved.
+
+ Serial channel demultiplexing command responses and firmware events.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include "nex_dome_channel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+#include <poll.h>
+#include <unistd.h>
+
+namespace
+{
+// How often the reader checks for a stop request while the line is idle
+constexpr int READER_POLL_MS = 100;
+// Lines longer than this are garbage, e.g. noise while the port settles
+constexpr size_t MAX_LINE = 512;
+}
+
+NexDomeChannel::~NexDomeChannel()
+{
+    stop();
+}
+
+bool NexDomeChannel::start(int fd)
+{
+    stop();
+
+    if (fd < 0)
+        return false;
+
+    m_FD = fd;
+    m_Running = true;
+    m_Reader = std::thread(&NexDomeChannel::readerLoop, this);
+    return true;
+}
+
+void NexDomeChannel::stop()
+{
+    m_Running = false;
+
+    if (m_Reader.joinable())
+        m_Reader.join();
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_FD = -1;
+    m_Events.clear();
+    m_Responded.notify_all();
+}
+
+bool NexDomeChannel::writeAll(const std::string &data)
+{
+    std::lock_guard<std::mutex> lock(m_WriteMutex);
+
+    size_t written = 0;
+    while (written < data.size())
+    {
+        ssize_t n = write(m_FD, data.data() + written, data.size() - written);
+        if (n < 0)
+        {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            return false;
+        }
+        written += n;
+    }
+
+    return true;
+}
+
+bool NexDomeChannel::send(const std::string &command)
+{
+    if (!m_Running)
+        return false;
+
+    return writeAll(command + "\r\n");
+}
+
+NexDomeChannel::Result NexDomeChannel::request(const std::string &command, const std::string &prefix,
+        std::string &response, int timeout)
+{
+    if (!m_Running)
+        return REQUEST_ERROR;
+
+    // Register before writing, a fast response must not be taken for an event
+    Pending pending;
+    pending.prefix = prefix;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Pending.push_back(&pending);
+    }
+
+    Result result = REQUEST_ERROR;
+    bool written = writeAll(command + "\r\n");
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    if (written)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+        m_Responded.wait_until(lock, deadline, [&] { return pending.done || !m_Running; });
+
+        if (pending.done)
+        {
+            response = std::move(pending.response);
+            result = REQUEST_OK;
+        }
+        else if (m_Running)
+            result = REQUEST_TIMEOUT;
+    }
+
+    m_Pending.remove(&pending);
+    return result;
+}
+
+size_t NexDomeChannel::drainEvents(std::vector<std::string> &events)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    size_t count = m_Events.size();
+    for (auto &event : m_Events)
+        events.push_back(std::move(event));
+    m_Events.clear();
+
+    return count;
+}
+
+NexDomeChannel::Statistics NexDomeChannel::getStatistics() const
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Statistics;
+}
+
+void NexDomeChannel::dispatch(std::string &line)
+{
+    // Strip the whitespace and the ':' response framing, the terminator is already gone
+    const char *blank = "\t\n\v\f\r ";
+    line.erase(line.find_last_not_of(blank) + 1);
+    line.erase(0, line.find_first_not_of(blank));
+    if (!line.empty() && line.front() == ':')
+        line.erase(0, 1);
+    if (line.empty())
+        return;
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Statistics.lines++;
+
+    // Responses go to the oldest caller waiting for their prefix
+    for (Pending *pending : m_Pending)
+    {
+        if (!pending->done && line.compare(0, pending->prefix.size(), pending->prefix) == 0)
+        {
+            pending->response = std::move(line);
+            pending->done = true;
+            m_Statistics.responses++;
+            m_Responded.notify_all();
+            return;
+        }
+    }
+
+    if (m_Events.size() >= MAX_EVENTS)
+    {
+        m_Events.pop_front();
+        m_Statistics.droppedEvents++;
+    }
+    m_Events.push_back(std::move(line));
+    m_Statistics.events++;
+}
+
+void NexDomeChannel::readerLoop()
+{
+    std::string line;
+    char buffer[256];
+
+    while (m_Running)
+    {
+        pollfd pfd = { m_FD, POLLIN, 0 };
+        int rc = poll(&pfd, 1, READER_POLL_MS);
+        if (rc == 0 || (rc < 0 && errno == EINTR))
+            continue;
+
+        // Port closed or failed, waiting callers must not wait for the timeout
+        if (rc < 0 || !(pfd.revents & POLLIN))
+            break;
+
+        ssize_t n = read(m_FD, buffer, sizeof(buffer));
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+        if (n <= 0)
+            break;
+
+        for (ssize_t i = 0; i < n; i++)
+        {
+            char c = buffer[i];
+            // Responses end with '#', events with a new line
+            if (c == '#' || c == '\n')
+            {
+                dispatch(line);
+                line.clear();
+            }
+            else if (line.size() < MAX_LINE)
+                line += c;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Running = false;
+    m_Responded.notify_all();
+}
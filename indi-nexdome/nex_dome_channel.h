@@ -0,0 +1,121 @@
+/*******************************************************************************
+ NexDome
+
+ Copyright(c) 2026. All rights reserved.
+
+ Serial channel demultiplexing command responses and firmware events.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Owns the serial port of the NexDome controller.
+ *
+ * The firmware sends command responses and unsolicited events (position updates, motion
+ * and XBee state changes, status reports) on the same line. A reader thread splits the
+ * input into lines, terminated by '#' or '\n', and strips the ':' and '#' framing. A line
+ * starting with the prefix of a pending request is handed to the waiting caller, anything
+ * else is queued as an event for the driver to drain. The port is never flushed, so events
+ * arriving between or during commands are not lost.
+ */
+class NexDomeChannel
+{
+    public:
+        enum Result
+        {
+            REQUEST_OK,
+            REQUEST_TIMEOUT,
+            REQUEST_ERROR   // write failed or the reader stopped
+        };
+
+        struct Statistics
+        {
+            uint64_t lines { 0 };
+            uint64_t responses { 0 };
+            uint64_t events { 0 };
+            uint64_t droppedEvents { 0 };
+        };
+
+        // Oldest events are dropped past this, if the driver does not drain the queue
+        static constexpr size_t MAX_EVENTS = 1024;
+
+        NexDomeChannel() = default;
+        ~NexDomeChannel();
+
+        NexDomeChannel(const NexDomeChannel &) = delete;
+        NexDomeChannel &operator=(const NexDomeChannel &) = delete;
+
+        /** Starts the reader thread on an open port. The caller keeps ownership of the descriptor. */
+        bool start(int fd);
+
+        /** Stops the reader thread and wakes up all waiting callers. Must be called before closing the port. */
+        void stop();
+
+        bool isRunning() const
+        {
+            return m_Running;
+        }
+
+        /** Writes a command, terminated with CR LF, without waiting for any response. */
+        bool send(const std::string &command);
+
+        /**
+         * @brief Writes a command and waits for the response line starting with prefix.
+         * @param response full response line without framing, e.g. "PRR27540" for prefix "PRR".
+         * @param timeout milliseconds
+         */
+        Result request(const std::string &command, const std::string &prefix, std::string &response, int timeout);
+
+        /** Moves all queued events, oldest first, to events. Returns the number of events moved. */
+        size_t drainEvents(std::vector<std::string> &events);
+
+        Statistics getStatistics() const;
+
+    private:
+        struct Pending
+        {
+            std::string prefix;
+            std::string response;
+            bool done { false };
+        };
+
+        void readerLoop();
+        void dispatch(std::string &line);
+        bool writeAll(const std::string &data);
+
+        int m_FD { -1 };
+        std::thread m_Reader;
+        std::atomic<bool> m_Running { false };
+
+        std::mutex m_WriteMutex;
+
+        mutable std::mutex m_Mutex;
+        std::condition_variable m_Responded;
+        std::list<Pending *> m_Pending;
+        std::deque<std::string> m_Events;
+        Statistics m_Statistics;
+};
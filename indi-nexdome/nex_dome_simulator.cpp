@@ -0,0 +1,320 @@
+/*******************************************************************************
+ NexDome
+
+ Copyright(c) 2026. All rights reserved.
+
+ NexDome firmware v3 simulator on a pseudo terminal.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include "nex_dome_simulator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+const char *FIRMWARE_VERSION = "3.2.0";
+}
+
+NexDomeSimulator::~NexDomeSimulator()
+{
+    stop();
+}
+
+bool NexDomeSimulator::start()
+{
+    if (m_Running)
+        return true;
+
+    m_MasterFD = posix_openpt(O_RDWR | O_NOCTTY);
+    if (m_MasterFD < 0 || grantpt(m_MasterFD) != 0 || unlockpt(m_MasterFD) != 0)
+    {
+        stop();
+        return false;
+    }
+
+    m_PortName = ptsname(m_MasterFD);
+
+    termios settings;
+    tcgetattr(m_MasterFD, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(m_MasterFD, TCSANOW, &settings);
+
+    m_Running = true;
+    m_DeviceThread = std::thread(&NexDomeSimulator::deviceLoop, this);
+
+    return true;
+}
+
+void NexDomeSimulator::stop()
+{
+    m_Running = false;
+
+    if (m_DeviceThread.joinable())
+        m_DeviceThread.join();
+
+    if (m_MasterFD >= 0)
+    {
+        close(m_MasterFD);
+        m_MasterFD = -1;
+    }
+}
+
+void NexDomeSimulator::setMotion(int eventPeriod, int velocity)
+{
+    m_EventPeriod = std::chrono::milliseconds(std::max(1, eventPeriod));
+    m_Velocity = std::max(1, velocity);
+}
+
+std::vector<NexDomeSimulator::EmittedEvent> NexDomeSimulator::getEmittedEvents() const
+{
+    std::lock_guard<std::mutex> lock(m_EventsMutex);
+    return m_Emitted;
+}
+
+void NexDomeSimulator::emit(const std::string &text, bool event)
+{
+    if (event)
+    {
+        std::lock_guard<std::mutex> lock(m_EventsMutex);
+        m_Emitted.push_back({text, std::chrono::steady_clock::now()});
+    }
+
+    // Position updates are bare lines, everything else is framed like a response
+    std::string line;
+    if (event && (text[0] == 'P' || text[0] == 'S') && std::isdigit(static_cast<unsigned char>(text[1])))
+        line = text + "\r\n";
+    else
+        line = ":" + text + "#\r\n";
+
+    if (write(m_MasterFD, line.data(), line.size()) < 0)
+        return;
+}
+
+std::string NexDomeSimulator::rotatorReport() const
+{
+    int32_t position = m_RotatorPosition;
+    return "SER," + std::to_string(position) + "," + (position == m_HomePosition ? "1" : "0") + "," +
+           std::to_string(m_Circumference) + "," + std::to_string(m_HomePosition) + "," + std::to_string(m_DeadZone);
+}
+
+std::string NexDomeSimulator::shutterReport() const
+{
+    int32_t position = static_cast<int32_t>(std::lround(m_ShutterExact));
+    return "SES," + std::to_string(position) + "," + std::to_string(m_ShutterLimit) + "," +
+           (position >= m_ShutterLimit ? "1" : "0") + "," + (position <= 0 ? "1" : "0");
+}
+
+void NexDomeSimulator::deviceLoop()
+{
+    std::string input;
+    auto last = std::chrono::steady_clock::now();
+    auto nextEvent = last + m_EventPeriod;
+
+    while (m_Running)
+    {
+        pollfd fd = { m_MasterFD, POLLIN, 0 };
+        int rc = poll(&fd, 1, 5);
+        if (rc > 0 && (fd.revents & POLLIN))
+        {
+            char buffer[256];
+            ssize_t n = read(m_MasterFD, buffer, sizeof(buffer));
+            if (n > 0)
+                input.append(buffer, n);
+        }
+        // Nobody has the terminal open yet
+        else if (rc > 0 && (fd.revents & POLLHUP))
+            usleep(10000);
+
+        // Commands are terminated with CR LF
+        size_t end;
+        while ((end = input.find('\n')) != std::string::npos)
+        {
+            std::string command = input.substr(0, end);
+            input.erase(0, end + 1);
+            command.erase(command.find_last_not_of("\r ") + 1);
+            if (!command.empty() && command[0] == '@')
+            {
+                m_CommandCount++;
+                execute(command.substr(1));
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        move(std::chrono::duration<double>(now - last).count());
+        last = now;
+
+        if (now >= nextEvent)
+        {
+            if (m_Rotating)
+                emit("P" + std::to_string(m_RotatorPosition), true);
+            if (m_ShutterMoving)
+                emit("S" + std::to_string(std::lround(m_ShutterExact)), true);
+            nextEvent = now + m_EventPeriod;
+        }
+    }
+}
+
+void NexDomeSimulator::move(double seconds)
+{
+    double step = m_Velocity * seconds;
+
+    if (m_Rotating)
+    {
+        double remaining = m_RotatorTarget - m_RotatorExact;
+        if (std::fabs(remaining) <= step)
+        {
+            m_RotatorExact = m_RotatorTarget;
+            m_RotatorPosition = m_RotatorTarget;
+            m_Rotating = false;
+            emit("P" + std::to_string(m_RotatorTarget), true);
+            emit("STOP", true);
+            emit(rotatorReport(), true);
+        }
+        else
+        {
+            m_RotatorExact += std::copysign(step, remaining);
+            m_RotatorPosition = static_cast<int32_t>(std::lround(m_RotatorExact));
+        }
+    }
+
+    if (m_ShutterMoving)
+    {
+        double remaining = m_ShutterTarget - m_ShutterExact;
+        if (std::fabs(remaining) <= step)
+        {
+            m_ShutterExact = m_ShutterTarget;
+            m_ShutterMoving = false;
+            emit("S" + std::to_string(m_ShutterTarget), true);
+            emit(shutterReport(), true);
+        }
+        else
+            m_ShutterExact += std::copysign(step, remaining);
+    }
+}
+
+void NexDomeSimulator::execute(const std::string &command)
+{
+    // <verb><target>[,value], the target is R for the rotator and S for the shutter
+    size_t comma = command.find(',');
+    std::string name = command.substr(0, comma);
+    int32_t value = (comma == std::string::npos) ? 0 : std::atoi(command.c_str() + comma + 1);
+
+    if (name.size() < 2)
+    {
+        emit("Err", false);
+        return;
+    }
+
+    std::string verb = name.substr(0, name.size() - 1);
+    bool rotator = name.back() == 'R';
+
+    // A command received while moving is answered after the pending position update
+    if (m_Interleave && m_Rotating)
+        emit("P" + std::to_string(m_RotatorPosition), true);
+
+    std::string response = name;
+
+    if (verb == "FR")
+        response = "FR" + std::string(FIRMWARE_VERSION);
+    else if (verb == "PR")
+        response += rotator ? std::to_string(m_RotatorPosition) : std::to_string(std::lround(m_ShutterExact));
+    else if (verb == "PW")
+    {
+        if (rotator)
+        {
+            m_RotatorExact = value;
+            m_RotatorPosition = value;
+        }
+        else
+            m_ShutterExact = value;
+    }
+    else if (verb == "AR")
+        response += std::to_string(rotator ? m_Ramp : m_ShutterRamp);
+    else if (verb == "AW")
+        (rotator ? m_Ramp : m_ShutterRamp) = value;
+    else if (verb == "VR")
+        response += std::to_string(m_Velocity);
+    else if (verb == "VW")
+        m_Velocity = std::max(1, value);
+    else if (verb == "DR")
+        response += std::to_string(m_DeadZone);
+    else if (verb == "DW")
+        m_DeadZone = value;
+    else if (verb == "RR")
+        response += std::to_string(rotator ? m_Circumference : m_ShutterLimit);
+    else if (verb == "RW")
+        (rotator ? m_Circumference : m_ShutterLimit) = std::max(1, value);
+    else if (verb == "HR")
+        response += std::to_string(m_HomePosition);
+    else if (verb == "HW")
+        m_HomePosition = value;
+    else if (verb == "SR")
+    {
+        // The status report is answered with the same line as the unsolicited report
+        response = rotator ? rotatorReport() : shutterReport();
+    }
+    else if (verb == "SW")
+    {
+        if (rotator && m_Rotating)
+        {
+            m_Rotating = false;
+            m_RotatorExact = m_RotatorPosition;
+            emit(response, false);
+            emit("STOP", true);
+            return;
+        }
+        m_ShutterMoving = false;
+    }
+    else if (verb == "GS" || verb == "GA" || verb == "GH")
+    {
+        int32_t target = value;
+        if (verb == "GA")
+            target = static_cast<int32_t>(std::lround(value * m_Circumference / 360.0));
+        else if (verb == "GH")
+            target = m_HomePosition;
+        target = ((target % m_Circumference) + m_Circumference) % m_Circumference;
+
+        emit(response, false);
+        if (target != m_RotatorPosition)
+        {
+            m_RotatorTarget = target;
+            m_Rotating = true;
+            emit(target > m_RotatorPosition ? "right" : "left", true);
+        }
+        return;
+    }
+    else if (verb == "OP" || verb == "CL")
+    {
+        emit(response, false);
+        m_ShutterTarget = (verb == "OP") ? m_ShutterLimit : 0;
+        m_ShutterMoving = true;
+        emit(verb == "OP" ? "open" : "close", true);
+        return;
+    }
+    else if (verb != "ZD" && verb != "ZR" && verb != "ZW")
+        response = "Err";
+
+    emit(response, false);
+}
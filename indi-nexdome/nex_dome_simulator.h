@@ -0,0 +1,131 @@
+/*******************************************************************************
+ NexDome
+
+ Copyright(c) 2026. All rights reserved.
+
+ NexDome firmware v3 simulator on a pseudo terminal.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Emulates the NexDome rotator and shutter controllers with firmware v3 on a pseudo
+ * terminal, so the driver can be exercised without hardware.
+ *
+ * Commands are answered with ":<echo><value>#". While the rotator or the shutter moves,
+ * position events "P<steps>" and "S<steps>" are sent at the event period, bracketed by the
+ * "left", "right", "open", "close" and "STOP" events and a final status report. When
+ * interleaving is on, the current position event is also written right in front of every
+ * response, as the firmware does when a command arrives during a move.
+ */
+class NexDomeSimulator
+{
+    public:
+        struct EmittedEvent
+        {
+            std::string text;
+            std::chrono::steady_clock::time_point time;
+        };
+
+        NexDomeSimulator() = default;
+        ~NexDomeSimulator();
+
+        /** Opens the pseudo terminal and starts answering commands */
+        bool start();
+        void stop();
+
+        /** Name of the pseudo terminal to connect to, as a serial port */
+        const std::string &getPortName() const
+        {
+            return m_PortName;
+        }
+
+        /**
+         * @param eventPeriod milliseconds between position events while moving
+         * @param velocity rotator and shutter speed in steps per second
+         */
+        void setMotion(int eventPeriod, int velocity);
+
+        void setInterleave(bool enabled)
+        {
+            m_Interleave = enabled;
+        }
+
+        int32_t getRotatorPosition() const
+        {
+            return m_RotatorPosition;
+        }
+
+        bool isRotating() const
+        {
+            return m_Rotating;
+        }
+
+        uint32_t getCommandCount() const
+        {
+            return m_CommandCount;
+        }
+
+        /** All events written so far, in order, with the time they were written */
+        std::vector<EmittedEvent> getEmittedEvents() const;
+
+    private:
+        void deviceLoop();
+        void execute(const std::string &command);
+        void move(double seconds);
+        void emit(const std::string &text, bool event);
+        std::string rotatorReport() const;
+        std::string shutterReport() const;
+
+        int m_MasterFD { -1 };
+        std::string m_PortName;
+        std::thread m_DeviceThread;
+        std::atomic<bool> m_Running { false };
+        std::atomic<bool> m_Interleave { true };
+        std::atomic<uint32_t> m_CommandCount { 0 };
+
+        std::chrono::milliseconds m_EventPeriod { 50 };
+        int m_Velocity { 3000 };
+
+        // Rotator, all positions in steps
+        std::atomic<int32_t> m_RotatorPosition { 0 };
+        std::atomic<bool> m_Rotating { false };
+        double m_RotatorExact { 0 };
+        int32_t m_RotatorTarget { 0 };
+        int32_t m_Circumference { 55080 };
+        int32_t m_HomePosition { 0 };
+        int32_t m_DeadZone { 300 };
+        int32_t m_Ramp { 1500 };
+
+        // Shutter
+        bool m_ShutterMoving { false };
+        double m_ShutterExact { 0 };
+        int32_t m_ShutterTarget { 0 };
+        int32_t m_ShutterLimit { 46000 };
+        int32_t m_ShutterRamp { 1500 };
+
+        mutable std::mutex m_EventsMutex;
+        std::vector<EmittedEvent> m_Emitted;
+};
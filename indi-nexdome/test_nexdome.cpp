@@ -0,0 +1,340 @@
+/*******************************************************************************
+ NexDome
+
+ Copyright(c) 2026. All rights reserved.
+
+ Serial channel tests against the firmware simulator.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "nex_dome_channel.h"
+#include "nex_dome_simulator.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+constexpr int TIMEOUT_MS = 3000;
+constexpr auto POLLING_PERIOD = std::chrono::milliseconds(200);
+
+int openPort(const std::string &name)
+{
+    int fd = open(name.c_str(), O_RDWR | O_NOCTTY);
+    if (fd < 0)
+        return -1;
+
+    termios settings;
+    tcgetattr(fd, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(fd, TCSANOW, &settings);
+    return fd;
+}
+
+std::string unframe(std::string line)
+{
+    line.erase(line.find_last_not_of("\r\n #") + 1);
+    line.erase(0, line.find_first_not_of("\r\n :"));
+    return line;
+}
+
+// What the driver tracks from the rotator events and reports
+struct DomeModel
+{
+    int32_t position { 0 };
+    bool moving { false };
+    std::vector<std::string> seen;
+    std::map<std::string, Clock::time_point> seenAt;
+
+    void process(const std::string &line)
+    {
+        if (line.empty())
+            return;
+
+        seen.push_back(line);
+        seenAt.emplace(line, Clock::now());
+
+        if (line == "left" || line == "right")
+            moving = true;
+        else if (line == "STOP")
+            moving = false;
+        else if (line[0] == 'P' && line.size() > 1 && isdigit(line[1]))
+            position = std::atoi(line.c_str() + 1);
+        else if (line.compare(0, 4, "SER,") == 0)
+            position = std::atoi(line.c_str() + 4);
+    }
+};
+
+bool isMotionEvent(const std::string &event)
+{
+    return event == "left" || event == "right" || event == "STOP" || (event[0] == 'P' && isdigit(event[1]));
+}
+
+// tty_nread_section() as used by the previous driver
+bool readSection(int fd, char stop, int timeout, std::string &section)
+{
+    section.clear();
+    auto deadline = Clock::now() + std::chrono::milliseconds(timeout);
+    while (Clock::now() < deadline)
+    {
+        pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 10) <= 0)
+            continue;
+
+        char c;
+        if (read(fd, &c, 1) != 1)
+            return false;
+        section += c;
+        if (c == stop)
+            return true;
+    }
+    return false;
+}
+
+// The previous driver: one event line per poll, then the report request between two flushes
+void legacyTick(int fd, DomeModel &dome)
+{
+    std::string section;
+    if (readSection(fd, '\n', 1000, section) && section.size() >= 3)
+        dome.process(unframe(section));
+
+    if (!dome.moving)
+        return;
+
+    tcflush(fd, TCIOFLUSH);
+    if (write(fd, "@SRR\r\n", 6) != 6)
+        return;
+    if (readSection(fd, '#', TIMEOUT_MS, section))
+    {
+        size_t start = 0, end;
+        while ((end = section.find('\n', start)) != std::string::npos)
+        {
+            dome.process(unframe(section.substr(start, end - start)));
+            start = end + 1;
+        }
+        dome.process(unframe(section.substr(start)));
+    }
+    tcflush(fd, TCIOFLUSH);
+}
+
+void channelTick(NexDomeChannel &channel, DomeModel &dome)
+{
+    std::vector<std::string> events;
+    channel.drainEvents(events);
+    for (auto &event : events)
+        dome.process(event);
+
+    std::string report;
+    if (dome.moving && channel.request("@SRR", "SER,", report, TIMEOUT_MS) == NexDomeChannel::REQUEST_OK)
+        dome.process(report);
+}
+
+struct RunResult
+{
+    size_t emitted { 0 };
+    size_t seen { 0 };
+    bool stopSeen { false };
+    double meanEventDelay { 0 };    // ms between the firmware sending an event and the driver processing it
+};
+
+// Rotates 4000 steps at 2000 steps/s with a position event every 50 ms, polled like the driver does
+template <typename Tick>
+RunResult rotate(NexDomeSimulator &simulator, DomeModel &dome, Tick tick)
+{
+    RunResult result;
+
+    auto end = Clock::now() + std::chrono::seconds(4);
+    while (Clock::now() < end)
+    {
+        tick();
+        if (!dome.moving && dome.position == 4000)
+            break;
+        std::this_thread::sleep_for(POLLING_PERIOD);
+    }
+
+    result.stopSeen = dome.seenAt.count("STOP") > 0;
+
+    double delaySum = 0;
+    for (const auto &event : simulator.getEmittedEvents())
+    {
+        if (!isMotionEvent(event.text))
+            continue;
+        result.emitted++;
+        auto seen = dome.seenAt.find(event.text);
+        if (seen != dome.seenAt.end())
+        {
+            result.seen++;
+            delaySum += std::chrono::duration<double, std::milli>(seen->second - event.time).count();
+        }
+    }
+
+    result.meanEventDelay = result.seen ? delaySum / result.seen : 0;
+    return result;
+}
+}
+
+TEST(NexDomeChannel, RoutesResponsesByPrefix)
+{
+    NexDomeSimulator simulator;
+    ASSERT_TRUE(simulator.start());
+
+    int fd = openPort(simulator.getPortName());
+    ASSERT_GE(fd, 0);
+
+    NexDomeChannel channel;
+    ASSERT_TRUE(channel.start(fd));
+
+    std::string response;
+    ASSERT_EQ(channel.request("@FRR", "FR", response, TIMEOUT_MS), NexDomeChannel::REQUEST_OK);
+    EXPECT_EQ(response, "FR3.2.0");
+
+    ASSERT_EQ(channel.request("@RRR", "RRR", response, TIMEOUT_MS), NexDomeChannel::REQUEST_OK);
+    EXPECT_EQ(response, "RRR55080");
+
+    ASSERT_EQ(channel.request("@DWR,250", "DWR", response, TIMEOUT_MS), NexDomeChannel::REQUEST_OK);
+    ASSERT_EQ(channel.request("@DRR", "DRR", response, TIMEOUT_MS), NexDomeChannel::REQUEST_OK);
+    EXPECT_EQ(response, "DRR250");
+
+    ASSERT_EQ(channel.request("@SRR", "SER,", response, TIMEOUT_MS), NexDomeChannel::REQUEST_OK);
+    EXPECT_EQ(response, "SER,0,1,55080,0,250");
+
+    // Nothing else was sent
+    std::vector<std::string> events;
+    EXPECT_EQ(channel.drainEvents(events), 0u);
+
+    // A response nobody waits for is an event, and a missing one times out
+    ASSERT_TRUE(channel.send("@HRR"));
+    ASSERT_EQ(channel.request("@ZWR", "XYZ", response, 300), NexDomeChannel::REQUEST_TIMEOUT);
+    channel.drainEvents(events);
+    EXPECT_EQ(events, std::vector<std::string>({"HRR0", "ZWR"}));
+
+    channel.stop();
+    EXPECT_EQ(channel.request("@FRR", "FR", response, TIMEOUT_MS), NexDomeChannel::REQUEST_ERROR);
+
+    close(fd);
+}
+
+TEST(NexDomeChannel, NoEventsLostWhileRotating)
+{
+    NexDomeSimulator simulator;
+    simulator.setMotion(10, 2000);
+    ASSERT_TRUE(simulator.start());
+
+    int fd = openPort(simulator.getPortName());
+    ASSERT_GE(fd, 0);
+
+    NexDomeChannel channel;
+    ASSERT_TRUE(channel.start(fd));
+
+    std::string response;
+    ASSERT_EQ(channel.request("@GSR,3000", "GSR", response, TIMEOUT_MS), NexDomeChannel::REQUEST_OK);
+
+    // Hammer the firmware with queries while it streams position events
+    std::vector<std::string> events;
+    int requests = 0;
+    auto end = Clock::now() + std::chrono::seconds(5);
+    while ((simulator.isRotating() || requests == 0) && Clock::now() < end)
+    {
+        ASSERT_EQ(channel.request("@PRR", "PRR", response, TIMEOUT_MS), NexDomeChannel::REQUEST_OK);
+        ASSERT_EQ(channel.request("@VRR", "VRR", response, TIMEOUT_MS), NexDomeChannel::REQUEST_OK);
+        EXPECT_EQ(response, "VRR2000");
+        requests += 2;
+        channel.drainEvents(events);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    channel.drainEvents(events);
+
+    // Every event sent by the firmware arrived, in order and nothing else
+    std::vector<std::string> emitted;
+    for (const auto &event : simulator.getEmittedEvents())
+        emitted.push_back(event.text);
+
+    EXPECT_GT(requests, 20);
+    EXPECT_GT(emitted.size(), 100u);
+    EXPECT_EQ(events, emitted);
+    EXPECT_EQ(events.back(), "SER,3000,0,55080,0,300");
+    EXPECT_EQ(channel.getStatistics().droppedEvents, 0u);
+
+    channel.stop();
+    close(fd);
+}
+
+// Both readers are polled at the same period, so events are not processed any sooner.
+// What the channel changes is that none of them is lost, STOP included.
+TEST(NexDomeChannel, ProcessesEveryEventUnlikeFlushingReader)
+{
+    RunResult legacy, current;
+
+    {
+        NexDomeSimulator simulator;
+        simulator.setMotion(50, 2000);
+        ASSERT_TRUE(simulator.start());
+        int fd = openPort(simulator.getPortName());
+        ASSERT_GE(fd, 0);
+
+        DomeModel dome;
+        ASSERT_EQ(write(fd, "@GSR,4000\r\n", 11), 11);
+        legacy = rotate(simulator, dome, [&] { legacyTick(fd, dome); });
+        close(fd);
+    }
+
+    {
+        NexDomeSimulator simulator;
+        simulator.setMotion(50, 2000);
+        ASSERT_TRUE(simulator.start());
+        int fd = openPort(simulator.getPortName());
+        ASSERT_GE(fd, 0);
+
+        NexDomeChannel channel;
+        ASSERT_TRUE(channel.start(fd));
+
+        DomeModel dome;
+        ASSERT_TRUE(channel.send("@GSR,4000"));
+        current = rotate(simulator, dome, [&] { channelTick(channel, dome); });
+        EXPECT_EQ(dome.position, 4000);
+        EXPECT_FALSE(dome.moving);
+
+        channel.stop();
+        close(fd);
+    }
+
+    std::cout << "Flushing reader: " << legacy.seen << "/" << legacy.emitted << " motion events, mean delay "
+              << legacy.meanEventDelay << " ms, STOP " << (legacy.stopSeen ? "seen" : "missed") << std::endl;
+    std::cout << "Channel: " << current.seen << "/" << current.emitted << " motion events, mean delay "
+              << current.meanEventDelay << " ms, STOP " << (current.stopSeen ? "seen" : "missed") << std::endl;
+
+    EXPECT_EQ(current.seen, current.emitted);
+    EXPECT_TRUE(current.stopSeen);
+    EXPECT_LT(legacy.seen, legacy.emitted);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -375,6 +375,7 @@ bool NightscapeCCD::StartExposure(float duration)
     dn->setImgSize(m->getRawImgSize(zonestart, zonelen, framediv));
     dn->setFrameYBinning(framediv);
     dn->setFrameXBinning(PrimaryCCD.getBinX());
+    dn->setCooking(PrimaryCCD.getSubX(), PrimaryCCD.getSubW(), PrimaryCCD.getBinX());
     m->sendzone(zonestart, zonelen, framediv);
     INDI::CCDChip::CCD_FRAME ft = PrimaryCCD.getFrameType();
     if (ft == INDI::CCDChip::DARK_FRAME || ft == INDI::CCDChip::BIAS_FRAME) dark = true;
@@ -574,8 +575,11 @@ void NightscapeCCD::grabImage()
     // Get width and height
     //int width  = PrimaryCCD.getSubW() / PrimaryCCD.getBinX() * PrimaryCCD.getBPP() / 8;
     //int height = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
-    memset(image, 0, PrimaryCCD.getFrameBufferSize());
     dn->copydownload(image, PrimaryCCD.getSubX(), PrimaryCCD.getSubW(), PrimaryCCD.getBinX(), 1, 1);
+    // Only the lines the camera did not send are cleared
+    size_t copied = static_cast<size_t>(dn->getActWriteLines()) * (PrimaryCCD.getSubW() / PrimaryCCD.getBinX()) * 2;
+    if (copied < static_cast<size_t>(PrimaryCCD.getFrameBufferSize()))
+        memset(image + copied, 0, PrimaryCCD.getFrameBufferSize() - copied);
     guard.unlock();
     //IDLog("copied..\n");
 
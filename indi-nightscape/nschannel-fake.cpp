@@ -0,0 +1,103 @@
+#include <string.h>
+#include "nschannel-fake.h"
+#include "kaf_constants.h"
+
+NsChannelFake::NsChannelFake(const std::vector<unsigned char> & frame, size_t chunk, std::chrono::microseconds interval)
+		: frame(frame), chunk(chunk), interval(interval) {
+		maxxfer = DEFAULT_OLD_CHUNK_SIZE;
+		opened = 1;
+}
+
+NsChannelFake::~NsChannelFake() {
+		if (feeder) {
+			feeder->join();
+			delete feeder;
+		}
+}
+
+void NsChannelFake::start() {
+		feeder = new std::thread(&NsChannelFake::feed, this);
+}
+
+void NsChannelFake::feed() {
+		while (true) {
+			std::this_thread::sleep_for(interval);
+			std::unique_lock<std::mutex> ulock(mutx);
+			sent = std::min(sent + chunk, frame.size());
+			if (sent == frame.size()) lastbyte = std::chrono::steady_clock::now();
+			arrived.notify_all();
+			if (sent == frame.size()) break;
+		}
+}
+
+std::chrono::steady_clock::time_point NsChannelFake::lastByteTime() {
+		std::unique_lock<std::mutex> ulock(mutx);
+		return lastbyte;
+}
+
+int NsChannelFake::readData(unsigned char * buf, size_t n) {
+		std::unique_lock<std::mutex> ulock(mutx);
+		size_t rc = std::min(n, sent - taken);
+		memcpy(buf, frame.data() + taken, rc);
+		taken += rc;
+		return rc;
+}
+
+int NsChannelFake::readDataWait(unsigned char * buf, size_t n, int timeout_ms) {
+		std::unique_lock<std::mutex> ulock(mutx);
+		arrived.wait_for(ulock, std::chrono::milliseconds(timeout_ms), [this]() { return sent > taken; });
+		ulock.unlock();
+		return readData(buf, n);
+}
+
+int NsChannelFake::purgeData(void) {
+		std::unique_lock<std::mutex> ulock(mutx);
+		taken = sent;
+		return 0;
+}
+
+int NsChannelFake::readCommand(unsigned char * buf, size_t n) {
+		memset(buf, 0, n);
+		return n;
+}
+
+int NsChannelFake::writeCommand(const unsigned char * buf, size_t n) {
+		(void)buf;
+		return n;
+}
+
+int NsChannelFake::setDataRts(void) {
+		return 0;
+}
+
+int NsChannelFake::resetcontrol(void) {
+		return 0;
+}
+
+int NsChannelFake::opencontrol(void) {
+		return 0;
+}
+
+int NsChannelFake::opendownload(void) {
+		return 0;
+}
+
+int NsChannelFake::scan(void) {
+		return 0;
+}
+
+uint16_t NsChannelFake::pixel(int line, int col) {
+		// Spans the whole 16 bit range, so that signed arithmetic would show
+		return (uint16_t)(line * 7919 + col * 104729);
+}
+
+std::vector<unsigned char> NsChannelFake::syntheticFrame(int lines) {
+		std::vector<unsigned char> raw((size_t)lines * KAF8300_MAX_X * 2);
+		for (int l = 0; l < lines; l++) {
+			for (int c = 0; c < KAF8300_MAX_X; c++) {
+				uint16_t px = pixel(l, c);
+				memcpy(raw.data() + ((size_t)l * KAF8300_MAX_X + c) * 2, &px, 2);
+			}
+		}
+		return raw;
+}
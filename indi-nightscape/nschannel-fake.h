@@ -0,0 +1,55 @@
+#ifndef __NS_CHANNEL_FAKE_H__
+#define __NS_CHANNEL_FAKE_H__
+#include "nschannel.h"
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Stands in for the camera download channel: a feeder thread sends a raw frame,
+ * synthetic or recorded, a chunk at a time the way the FTDI chip does.
+ */
+class NsChannelFake : public NsChannel {
+	public:
+		NsChannelFake(const std::vector<unsigned char> & frame, size_t chunk, std::chrono::microseconds interval);
+		~NsChannelFake();
+
+		// Starts sending the frame
+		void start();
+		std::chrono::steady_clock::time_point lastByteTime();
+
+		int readCommand(unsigned char * buf, size_t n);
+		int writeCommand(const unsigned char * buf, size_t n);
+		int readData(unsigned char * buf, size_t n);
+		int readDataWait(unsigned char * buf, size_t n, int timeout_ms);
+		int purgeData(void);
+		int setDataRts(void);
+		int resetcontrol (void);
+
+		// Raw frame of lines KAF8300_MAX_X pixels wide, postamble first, as the camera sends it
+		static std::vector<unsigned char> syntheticFrame(int lines);
+		static uint16_t pixel(int line, int col);
+
+	protected:
+		int opencontrol (void);
+		int opendownload(void);
+		int scan(void);
+
+	private:
+		void feed();
+
+		std::vector<unsigned char> frame;
+		size_t chunk;
+		std::chrono::microseconds interval;
+		size_t sent {0};
+		size_t taken {0};
+		std::chrono::steady_clock::time_point lastbyte;
+		std::mutex mutx;
+		std::condition_variable arrived;
+		std::thread * feeder {nullptr};
+};
+
+#endif
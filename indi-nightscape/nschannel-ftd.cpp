@@ -1,4 +1,6 @@
 #include <stdio.h>
+#include <time.h>
+#include <pthread.h>
 #include "nschannel-ftd.h"
 #include  "nsdebug.h"
 
@@ -114,6 +116,14 @@ int  NsChannelFTD::opendownload(void)
         DO_ERR( "unable to set rts on data channel: %d (%s)\n", rc2, status_string(rc2));
         return (-1);
     }
+    pthread_mutex_init(&dataEvent.eMutex, NULL);
+    pthread_cond_init(&dataEvent.eCondVar, NULL);
+    rc2 = FT_SetEventNotification(ftdid, FT_EVENT_RXCHAR, (PVOID)&dataEvent);
+    if (rc2  != FT_OK)
+    {
+        DO_ERR( "unable to set event notification on data channel: %d (%s)\n", rc2, status_string(rc2));
+        return (-1);
+    }
     return maxxfer;
 }
 
@@ -275,6 +285,43 @@ int NsChannelFTD::readData(unsigned char *buf, size_t size)
     }
 }
 
+int NsChannelFTD::readDataWait(unsigned char *buf, size_t size, int timeout_ms)
+{
+    FT_STATUS rc2;
+    DWORD queued = 0;
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec  += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    // Sleep until the driver signals received data, instead of blocking in FT_Read for the read timeout
+    pthread_mutex_lock(&dataEvent.eMutex);
+    while ((rc2 = FT_GetQueueStatus(ftdid, &queued)) == FT_OK && queued == 0)
+    {
+        if (pthread_cond_timedwait(&dataEvent.eCondVar, &dataEvent.eMutex, &deadline) != 0)
+        {
+            rc2 = FT_GetQueueStatus(ftdid, &queued);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&dataEvent.eMutex);
+
+    if (rc2 != FT_OK)
+    {
+        DO_ERR( "unable to get data queue status: %d (%s)\n", (int)rc2, status_string(rc2));
+        return -1;
+    }
+    if (queued == 0)
+        return 0;
+    return readData(buf, queued < size ? queued : size);
+}
+
 int NsChannelFTD::purgeData(void)
 {
     FT_STATUS rc2;
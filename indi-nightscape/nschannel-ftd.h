@@ -26,6 +26,7 @@ class NsChannelFTD : public NsChannel {
 		int readCommand(unsigned char * buf, size_t n);
 		int writeCommand(const unsigned char * buf, size_t n);
 		int readData(unsigned char * buf, size_t n);
+		int readDataWait(unsigned char * buf, size_t n, int timeout_ms);
 		int purgeData(void);
 		int setDataRts(void);
 		int resetcontrol (void);
@@ -37,6 +38,8 @@ class NsChannelFTD : public NsChannel {
 		int scan(void);
 	private:
 		FT_HANDLE ftdic, ftdid;
+		// Signalled by the D2XX driver when data is received on the data channel
+		EVENT_HANDLE dataEvent;
     struct ftdi_device_list * devs;
 		int thedev;
 	
@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <sys/time.h>
 #include "nschannel.h"
 #include  "nsdebug.h"
 
@@ -19,3 +20,16 @@ int NsChannel::close() {
 int NsChannel::getMaxXfer() {
 		return maxxfer;	
 }
+
+int NsChannel::readDataWait(unsigned char * buf, size_t n, int timeout_ms) {
+		struct timeval start, now;
+		int rc;
+		gettimeofday(&start, NULL);
+		// An FTDI bulk read without data returns when the latency timer expires, so reading again is the wait
+		do {
+			rc = readData(buf, n);
+			if (rc != 0) return rc;
+			gettimeofday(&now, NULL);
+		} while ((now.tv_sec - start.tv_sec) * 1000 + (now.tv_usec - start.tv_usec) / 1000 < timeout_ms);
+		return 0;
+}
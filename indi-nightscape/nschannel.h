@@ -25,6 +25,8 @@ class NsChannel {
 		virtual int readCommand(unsigned char * buf, size_t n) = 0;
 		virtual int writeCommand(const unsigned char * buf, size_t n) = 0;
 		virtual int readData(unsigned char * buf, size_t n)= 0;
+		// Like readData, but waits up to timeout_ms for data to arrive. Returns 0 if none did.
+		virtual int readDataWait(unsigned char * buf, size_t n, int timeout_ms);
 		virtual int purgeData(void)= 0;
 		virtual int setDataRts(void)= 0;
 		virtual int resetcontrol (void)= 0;
@@ -8,6 +8,9 @@
 #include "nsdebug.h"
 #include <math.h>
 
+// Nothing more from the camera for this long means the readout is over
+#define DOWNLOAD_IDLE_MS 1500
+
 void NsDownload::setFrameYBinning(int binning)
 {
     ctx->imgp->ybinning = binning;
@@ -110,7 +113,13 @@ void NsDownload::setImgWrite(bool w)
 void NsDownload::freeBuf()
 {
     if (!retrBuf) return;
-    if (retrBuf->buffer) free(retrBuf->buffer);
+    if (retrBuf->buffer)
+    {
+        // Kept for the next download rather than freed and allocated again
+        std::unique_lock<std::mutex> block(bufmutx);
+        if (spare_buffer) free(spare_buffer);
+        spare_buffer = retrBuf->buffer;
+    }
     retrBuf->buffer = NULL;
     retrBuf = NULL;
 }
@@ -131,37 +140,87 @@ int NsDownload::getActWriteLines()
     return writelines;
 }
 
-int NsDownload::downloader()
+void NsDownload::setCooking(int xstart, int xlen, int xbin, bool rms)
 {
-    //struct ftdi_context * ftdid = cn->->getDataChannel();
-    //struct ftdi_transfer_control * ctl;
+    if (xbin < 1 || xbin > 4 || xstart < 0 || xlen < xbin || xstart + xlen > KAF8300_ACTIVE_X)
+    {
+        DO_ERR("cannot cook columns %d+%d binned %d\n", xstart, xlen, xbin);
+        cook_xlen = 0;
+        return;
+    }
+    cook_xstart = xstart;
+    cook_xlen = xlen;
+    cook_xbin = xbin;
+    cook_rms = rms;
+}
 
-    int rc2;
-    int hardloop = 20;
-    int sleepage = 1000;
+bool NsDownload::cookedMatches(int xstart, int xlen, int xbin)
+{
+    return cook_xlen > 0 && cook_xstart == xstart && cook_xlen == xlen && cook_xbin == xbin;
+}
+
+/* Strips the postamble of a raw line and bins its columns, xlen / xbin pixels into dest. */
+void NsDownload::cookLine(const uint8_t * raw, uint8_t * dest, int xstart, int xlen, int xbin, bool rms)
+{
+    const uint8_t * lbufp = raw + (KAF8300_POSTAMBLE * 2) + xstart * 2;
+
+    if (xbin <= 1)
+    {
+        memcpy (dest, lbufp, xlen * 2);
+        return;
+    }
+
+    int npx = xlen / xbin;
+    for (int x = 0; x < npx; x++)
+    {
+        uint16_t px[4];
+        uint32_t pxav = 0;
+        uint64_t pxsq = 0;
+        uint16_t pxa;
+        memcpy(px, lbufp, xbin * 2);
+        for (int a = 0; a < xbin; a++)
+        {
+            pxav += px[a];
+            pxsq += (uint32_t)px[a] * px[a];
+        }
+        if (rms)
+        {
+            pxa = (uint16_t)round(sqrt((double)pxsq / xbin));
+        }
+        else
+        {
+            pxa = pxav / xbin;
+        }
+        memcpy (dest + x * 2, &pxa, 2);
+        lbufp += 2 * xbin;
+    }
+}
+
+/* Cooks the lines completed since the last call, while the download goes on. */
+void NsDownload::cookLines()
+{
+    if (cook_xlen == 0 || rd->buffer == NULL) return;
+
+    int lines = rd->nread / (KAF8300_MAX_X * 2);
+    size_t rowbytes = (cook_xlen / cook_xbin) * 2;
+    for (; cooked_lines < lines && (size_t)(cooked_lines + 1) * rowbytes <= cookbuf.size(); cooked_lines++)
+    {
+        cookLine(rd->buffer + (size_t)cooked_lines * KAF8300_MAX_X * 2, cookbuf.data() + cooked_lines * rowbytes,
+                 cook_xstart, cook_xlen, cook_xbin, cook_rms);
+    }
+}
 
+int NsDownload::downloader()
+{
+    int rc2;
     int download = 1;
     if (rd->nread > rd->bufsiz)
     {
         DO_ERR("image too large %d\n", rd->nread);
         return (-1);
     }
-    while((rc2 = cn->readData(rd->buffer + rd->nread, cn->getMaxXfer())) == 0 && hardloop > 0)
-    {
-        if (hardloop % 5  == 0) DO_INFO("W%d\n", hardloop);
-        usleep(sleepage);
-        sleepage *= 2;
-        if (sleepage > 100000) sleepage = 100000;
-        hardloop--;
-    }
-    /* ctl = ftdi_read_data_submit(ftdid, rd->buffer+rd->nread,  maxxfer);
-    if (ctl == NULL) {
-    	DO_ERR( "unable to submit read: %d (%s)\n", rc2, ftdi_get_error_string(ftdid));
-    		return (-1);
-    }
-    DO_INFO( ".");
-    rc2 = ftdi_transfer_data_done(ctl);
-    */
+    // Blocks until the camera sends data, the readout is over when it does not for a while
+    rc2 = cn->readDataWait(rd->buffer + rd->nread, cn->getMaxXfer(), DOWNLOAD_IDLE_MS);
     if (rc2 < 0 )
     {
         DO_ERR("unable to read download data: %d\n", rc2);
@@ -180,6 +239,7 @@ int NsDownload::downloader()
     else
     {
         rd->nblks ++;
+        cookLines();
     }
     if (rd->nread >= rd->imgsz)
     {
@@ -342,6 +402,9 @@ void NsDownload::writedownload(int pad, int cooked)
     if (pad)
     {
         nwrite = retrBuf->imgsz;
+        // The buffer is not cleared before the download, only the missing end is
+        if (nwrite > retrBuf->nread && nwrite <= retrBuf->bufsiz)
+            memset(retrBuf->buffer + retrBuf->nread, 0, nwrite - retrBuf->nread);
     }
     else
     {
@@ -378,13 +441,8 @@ void NsDownload::writedownload(int pad, int cooked)
 
 void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin, int pad, int cooked)
 {
-    unsigned char linebuf[KAF8300_MAX_X * 2];
-    bool forwards = true;
-    bool rms = false;
-    int binning = xbin;
-    uint8_t * dbufp = buf;
-    uint8_t * bufp;
     int nwrite = 0;
+    writelines = 0;
 
     if (retrBuf == NULL)
     {
@@ -398,87 +456,32 @@ void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin
         if (pad)
         {
             nwrite = retrBuf->imgsz;
+            if (nwrite > retrBuf->nread && nwrite <= retrBuf->bufsiz)
+                memset(retrBuf->buffer + retrBuf->nread, 0, nwrite - retrBuf->nread);
         }
         else
         {
             nwrite = retrBuf->nread;
         }
-        memcpy (dbufp, retrBuf->buffer, nwrite);
+        memcpy (buf, retrBuf->buffer, nwrite);
     }
     else
     {
-        //int actlines = nwrite / (KAF8300_MAX_X*2);
-        //int rem = nwrite % (KAF8300_MAX_X*2);
-        nwrite = retrBuf->nread;
-        int nwriteleft = nwrite;
-        if (forwards)
+        int lines = retrBuf->nread / (KAF8300_MAX_X * 2);
+        int binning = xbin > 1 ? xbin : 1;
+        size_t rowbytes = (xlen / binning) * 2;
+
+        if (cookedMatches(xstart, xlen, binning) && cooked_lines == lines)
         {
-            bufp = retrBuf->buffer;
-            //dbufp =  (dbufp +(KAF8300_ACTIVE_X*2*IMG_Y)) - (KAF8300_ACTIVE_X*2);
+            // Cooked while downloading, the frame is ready
+            memcpy (buf, cookbuf.data(), lines * rowbytes);
         }
         else
         {
-            bufp = (retrBuf->buffer + nwrite) - (KAF8300_MAX_X * 2);
-            dbufp =  (dbufp + (KAF8300_ACTIVE_X * 2 * IMG_MAX_Y)) - (KAF8300_ACTIVE_X * 2);
-        }
-        writelines = 0;
-        while (nwriteleft >= (KAF8300_MAX_X * 2))
-        {
-            //swab (bufp + (KAF8300_POSTAMBLE*2),  linebuf, KAF8300_ACTIVE_X*2 );
-            //memcpy (dbufp, linebuf, KAF8300_ACTIVE_X*2);
-            if (binning > 1)
-            {
-                uint8_t * lbufp = bufp + (KAF8300_POSTAMBLE * 2) + xstart * 2;
-                int len = xlen * 2;
-                int linelen = 0;
-                while (len > 0)
-                {
-                    short px[4];
-                    long long pxsq = 0;
-                    long pxav = 0;
-                    short pxa;
-                    memcpy(px, lbufp, binning * 2);
-                    for (int a = 0; a < binning; a++)
-                    {
-                        pxav += px[a];
-                        pxsq	+= px[a] * px[a];
-                    }
-                    pxav /= binning;
-                    pxsq /= binning;
-                    if(rms)
-                    {
-                        pxa = round(sqrt((double)	pxsq));
-
-                    }
-                    else
-                    {
-                        pxa = pxav;
-                    }
-                    memcpy (linebuf + linelen, &pxa, 2);
-                    linelen += 2;
-                    lbufp += 2 * binning;
-                    len -= 2 * binning;
-                }
-                memcpy (dbufp, linebuf, (xlen * 2) / binning);
-
-            }
-            else
-            {
-                memcpy (dbufp, bufp + (KAF8300_POSTAMBLE * 2) + xstart * 2, xlen * 2 ); //KAF8300_ACTIVE_X*2 );
-            }
-            if (forwards)
-            {
-                bufp +=  KAF8300_MAX_X * 2;
-                dbufp += (xlen * 2) / binning;
-            }
-            else
-            {
-                bufp -=  KAF8300_MAX_X * 2;
-                dbufp -= (xlen * 2) / binning;
-            }
-            nwriteleft -= KAF8300_MAX_X * 2;
-            writelines++;
+            for (int l = 0; l < lines; l++)
+                cookLine(retrBuf->buffer + (size_t)l * KAF8300_MAX_X * 2, buf + l * rowbytes, xstart, xlen, binning, false);
         }
+        writelines = lines;
         DO_INFO( "wrote %d lines\n", writelines);
     }
 }
@@ -486,7 +489,10 @@ void NsDownload::copydownload(unsigned char *buf, int xstart, int xlen, int xbin
 int NsDownload::purgedownload()
 {
     int rc2;
-    rc2 = cn->readData(rd->buffer, rd->bufsiz);
+    // Whatever is left is thrown away, a chunk is enough to tell
+    if (purge_buffer.empty())
+        purge_buffer.resize(DEFAULT_CHUNK_SIZE);
+    rc2 = cn->readData(purge_buffer.data(), purge_buffer.size());
     if (rc2 < 0 )
     {
         DO_ERR( "purge: unable to read: %d \n", rc2);
@@ -509,8 +515,12 @@ int NsDownload::purgedownload()
 int NsDownload::fulldownload()
 {
     int rc2;
+    int want = rd->bufsiz - rd->nread;
 
-    rc2 = cn->readData(rd->buffer + rd->nread, rd->bufsiz - rd->nread);
+    // A chunk at a time, so that the lines are cooked as they come
+    if (cn->getMaxXfer() > 0 && cn->getMaxXfer() < want)
+        want = cn->getMaxXfer();
+    rc2 = cn->readData(rd->buffer + rd->nread, want);
     if (rc2 < 0 )
     {
         DO_ERR( "unable to read: %d\n", rc2);
@@ -522,7 +532,7 @@ int NsDownload::fulldownload()
         rd->nread += rc2;
         rd->nblks += rc2 / 65536;
         DO_INFO("read %d tot %d\n", rc2, rd->nread);
-
+        cookLines();
     }
     return rc2;
 }
@@ -535,12 +545,25 @@ void NsDownload::initdownload()
     rd->nread = 0;
     if(!rd->buffer)
     {
-        rd->buffer = (unsigned char *)malloc(imgszmax);
+        std::unique_lock<std::mutex> block(bufmutx);
+        rd->buffer = spare_buffer;
+        spare_buffer = NULL;
+        block.unlock();
+        if (!rd->buffer)
+            rd->buffer = (unsigned char *)malloc(imgszmax);
     }
-    memset(rd->buffer, 0, imgszmax);
+    // No need to clear the buffer: lines are used as they are read, and padding clears the missing end
 
     rd->bufsiz = imgszmax;
     rd->nblks = 0;
+
+    cooked_lines = 0;
+    if (cook_xlen > 0)
+    {
+        size_t size = (size_t)(imgszmax / (KAF8300_MAX_X * 2)) * (cook_xlen / cook_xbin) * 2;
+        if (cookbuf.size() < size)
+            cookbuf.resize(size);
+    }
 }
 
 
@@ -626,7 +649,6 @@ void NsDownload::trun()
         }
         if (!in_download && !do_download)
         {
-            initdownload();
             purgedownload ();
         }
     }
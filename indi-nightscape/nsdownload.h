@@ -4,8 +4,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>
+#include <stdint.h>
 #include <thread>         // std::thread
 #include <condition_variable>
+#include <vector>
 
 typedef struct ns_readdata {
 	int nread;
@@ -106,7 +108,12 @@ class NsDownload {
 		void copydownload(unsigned char *buf, int xstart, int xlen, int xbin, int pad, int cooked);
 		void writedownload(int pad, int cooked);
 		void setZeroReads(int zeroes);
+		// Columns of the cooked frame, to cook the lines of the next downloads as they arrive
+		void setCooking(int xstart, int xlen, int xbin, bool rms = false);
 	private:
+		void cookLines();
+		void cookLine(const uint8_t * raw, uint8_t * dest, int xstart, int xlen, int xbin, bool rms);
+		bool cookedMatches(int xstart, int xlen, int xbin);
 
 	  void fitsheader(int x, int y, char * fbase, struct img_params * ip);
 		int fulldownload(); 
@@ -136,5 +143,18 @@ class NsDownload {
 		ns_readdata_t * retrBuf;
 		int zero_reads { 1 };
 		int writelines{0};
+
+		// Cooking of the lines as they are downloaded, set before the download starts
+		int cook_xstart {0};
+		int cook_xlen {0};
+		int cook_xbin {1};
+		bool cook_rms {false};
+		std::vector<uint8_t> cookbuf;
+		int cooked_lines {0};
+
+		// Raw buffer handed back by freeBuf, for the next download
+		unsigned char * spare_buffer {nullptr};
+		std::mutex bufmutx;
+		std::vector<unsigned char> purge_buffer;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+/*
+    Nightscape download tests, against a fake download channel
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this library; if not, write to the Free Software Foundation,
+    Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include <gtest/gtest.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "kaf_constants.h"
+#include "nschannel-fake.h"
+#include "nsdownload.h"
+
+struct Download
+{
+    std::vector<unsigned char> image;
+    int lines;
+    double seconds; // from the last byte sent to the frame copied out
+};
+
+// Downloads lines raw lines sent in chunks, and copies out the columns xstart..xstart+xlen binned by xbin
+static Download download(NsChannelFake &channel, int lines, int xstart, int xlen, int xbin, bool cookAhead)
+{
+    NsDownload dn(&channel);
+    Download result;
+
+    dn.setNumExp(99999);
+    dn.setImgSize(lines * KAF8300_MAX_X * 2);
+    if (cookAhead)
+        dn.setCooking(xstart, xlen, xbin);
+    dn.startThread();
+    channel.start();
+    dn.doDownload();
+
+    while (dn.inDownload())
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+    result.image.resize((size_t)lines * (xlen / xbin) * 2);
+    dn.copydownload(result.image.data(), xstart, xlen, xbin, 1, 1);
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - channel.lastByteTime()).count();
+    result.lines = dn.getActWriteLines();
+    dn.freeBuf();
+    dn.stopThread();
+    return result;
+}
+
+static void expectImage(const Download &result, int lines, int xstart, int xlen, int xbin)
+{
+    int width = xlen / xbin;
+    ASSERT_EQ(result.lines, lines);
+    for (int l = 0; l < lines; l++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            uint32_t sum = 0;
+            for (int a = 0; a < xbin; a++)
+                sum += NsChannelFake::pixel(l, KAF8300_POSTAMBLE + xstart + x * xbin + a);
+            uint16_t px;
+            memcpy(&px, result.image.data() + ((size_t)l * width + x) * 2, 2);
+            ASSERT_EQ(px, sum / xbin) << "line " << l << " pixel " << x;
+        }
+    }
+}
+
+class NsDownloadTest : public ::testing::TestWithParam<int>
+{
+};
+
+TEST_P(NsDownloadTest, CookedWhileDownloading)
+{
+    int xbin = GetParam();
+    // Chunks that do not line up with the lines
+    NsChannelFake channel(NsChannelFake::syntheticFrame(40), 12345, std::chrono::microseconds(100));
+
+    Download result = download(channel, 40, 10, 3000, xbin, true);
+    expectImage(result, 40, 10, 3000, xbin);
+}
+
+TEST_P(NsDownloadTest, CookedOnCopy)
+{
+    int xbin = GetParam();
+    NsChannelFake channel(NsChannelFake::syntheticFrame(40), 7001, std::chrono::microseconds(100));
+
+    Download result = download(channel, 40, 100, 1203, xbin, false);
+    expectImage(result, 40, 100, 1203, xbin);
+}
+
+INSTANTIATE_TEST_SUITE_P(Binning, NsDownloadTest, ::testing::Values(1, 2, 3, 4));
+
+TEST(NsDownload, PartialLastLine)
+{
+    // The camera stops half way through line 20, the frame keeps the 20 whole lines
+    std::vector<unsigned char> raw = NsChannelFake::syntheticFrame(30);
+    raw.resize(20 * KAF8300_MAX_X * 2 + KAF8300_MAX_X);
+    NsChannelFake channel(raw, 30000, std::chrono::microseconds(100));
+
+    NsDownload dn(&channel);
+    dn.setNumExp(99999);
+    dn.setImgSize(30 * KAF8300_MAX_X * 2);
+    dn.setCooking(0, KAF8300_ACTIVE_X, 2);
+    dn.startThread();
+    channel.start();
+    dn.doDownload();
+    while (dn.inDownload())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    Download result;
+    result.image.resize(30 * (KAF8300_ACTIVE_X / 2) * 2);
+    dn.copydownload(result.image.data(), 0, KAF8300_ACTIVE_X, 2, 1, 1);
+    result.lines = dn.getActWriteLines();
+    dn.freeBuf();
+    dn.stopThread();
+
+    expectImage(result, 20, 0, KAF8300_ACTIVE_X, 2);
+}
+
+TEST(NsDownload, RmsBinning)
+{
+    NsChannelFake channel(NsChannelFake::syntheticFrame(4), 65536, std::chrono::microseconds(100));
+
+    NsDownload dn(&channel);
+    dn.setNumExp(99999);
+    dn.setImgSize(4 * KAF8300_MAX_X * 2);
+    dn.setCooking(0, 100, 2, true);
+    dn.startThread();
+    channel.start();
+    dn.doDownload();
+    while (dn.inDownload())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::vector<unsigned char> image(4 * 50 * 2);
+    dn.copydownload(image.data(), 0, 100, 2, 1, 1);
+    dn.freeBuf();
+    dn.stopThread();
+
+    for (int l = 0; l < 4; l++)
+    {
+        for (int x = 0; x < 50; x++)
+        {
+            double a = NsChannelFake::pixel(l, KAF8300_POSTAMBLE + 2 * x);
+            double b = NsChannelFake::pixel(l, KAF8300_POSTAMBLE + 2 * x + 1);
+            uint16_t px;
+            memcpy(&px, image.data() + (l * 50 + x) * 2, 2);
+            ASSERT_EQ(px, (uint16_t)round(sqrt((a * a + b * b) / 2))) << "line " << l << " pixel " << x;
+        }
+    }
+}
+
+TEST(NsDownloadBenchmark, FullFrame)
+{
+    // Full frame binned 2, in 63448 byte chunks at USB 2 speed
+    double seconds[2];
+    for (int ahead = 0; ahead < 2; ahead++)
+    {
+        NsChannelFake channel(NsChannelFake::syntheticFrame(IMG_MAX_Y), DEFAULT_OLD_CHUNK_SIZE,
+                              std::chrono::microseconds(2000));
+        Download result = download(channel, IMG_MAX_Y, 0, KAF8300_ACTIVE_X, 2, ahead == 1);
+        ASSERT_EQ(result.lines, IMG_MAX_Y);
+        seconds[ahead] = result.seconds;
+    }
+
+    printf("last byte to frame: %.1f ms cooked on copy, %.1f ms cooked while downloading\n",
+           seconds[0] * 1000, seconds[1] * 1000);
+}
@@ -6,5 +6,7 @@
 /* Define Driver version */
 #define NUT_VERSION_MAJOR @NUT_VERSION_MAJOR@
 #define NUT_VERSION_MINOR @NUT_VERSION_MINOR@
+/* libnutclient polls several devices at once (NUT 2.8) */
+#cmakedefine HAVE_NUT_DEVICES_VARIABLE_VALUES
 
 #endif // CONFIG_H
@@ -26,8 +26,10 @@
 #include "indi_nut.h"
 #include "config.h"
 
+#include <algorithm>
 #include <memory>
 #include <cstring>
+#include <sstream>
 
 // We declare an auto pointer to NetworkUPSToolsMonitor.
 std::unique_ptr<NetworkUPSToolsMonitor> nutMonitor(new NetworkUPSToolsMonitor());
@@ -49,15 +51,39 @@ const char *NetworkUPSToolsMonitor::getDefaultName()
 
 bool NetworkUPSToolsMonitor::Connect()
 {
-    nutClient.connect(nutMonitorUrl[INDEX_HOST].getText(), atoi(nutMonitorUrl[INDEX_PORT].getText()));
-    nutClient.authenticate(nutMonitorUrl[INDEX_USER].getText(), nutMonitorUrl[INDEX_PASSWORD].getText());
+    return openSession();
+}
+
+bool NetworkUPSToolsMonitor::Disconnect()
+{
+    telemetry.disconnect();
 
     return true;
 }
 
-bool NetworkUPSToolsMonitor::Disconnect()
+bool NetworkUPSToolsMonitor::openSession()
 {
-    nutClient.disconnect();
+    const char *host = nutMonitorUrl[INDEX_HOST].getText();
+    if (host == nullptr || host[0] == '\0')
+    {
+        LOG_ERROR("NUT monitor host is not set.");
+        return false;
+    }
+
+    if (!telemetry.connect(host, atoi(nutMonitorUrl[INDEX_PORT].getText())))
+    {
+        LOGF_ERROR("Connecting to upsd failed: %s.", telemetry.getLastError().c_str());
+        return false;
+    }
+
+    const char *user     = nutMonitorUrl[INDEX_USER].getText();
+    const char *password = nutMonitorUrl[INDEX_PASSWORD].getText();
+    if (!telemetry.login(user ? user : "", password ? password : ""))
+    {
+        LOGF_ERROR("Authenticating with upsd failed: %s.", telemetry.getLastError().c_str());
+        telemetry.disconnect();
+        return false;
+    }
 
     return true;
 }
@@ -73,7 +99,13 @@ bool NetworkUPSToolsMonitor::initProperties()
 
     nutMonitorUrl.fill(getDeviceName(), "NUT_MON_URL", "NetworkUPSToolsMonitor", OPTIONS_TAB, IP_RW, 60, IPS_IDLE);
 
+    upsVariables[0].fill("VARIABLES", "Variables", "battery.charge,battery.runtime,ups.load,input.voltage,output.voltage");
+    upsVariables.fill(getDeviceName(), "NUT_VARIABLES", "UPS Telemetry", OPTIONS_TAB, IP_RW, 60, IPS_IDLE);
+
+    // Worst values over all the UPSes
     addParameter("WEATHER_CHARGE_REMAINING", "Charge Remaining", 50, 100, 0);
+    addParameter("WEATHER_RUNTIME_REMAINING", "Runtime Remaining (min)", 10, 100000, 0);
+    addParameter("WEATHER_UPS_LOAD", "UPS Load (%)", 0, 80, 10);
 
     setCriticalParameter("WEATHER_CHARGE_REMAINING");
 
@@ -88,6 +120,9 @@ void NetworkUPSToolsMonitor::ISGetProperties(const char *dev)
 
     defineProperty(nutMonitorUrl);
     loadConfig(true, nutMonitorUrl.getName());
+
+    defineProperty(upsVariables);
+    loadConfig(true, upsVariables.getName());
 }
 
 bool NetworkUPSToolsMonitor::updateProperties()
@@ -102,6 +137,7 @@ bool NetworkUPSToolsMonitor::updateProperties()
     else
     {
         deleteProperty(nutMonitorUrl);
+        deleteUpsProperties();
     }
 
     return true;
@@ -118,6 +154,16 @@ bool NetworkUPSToolsMonitor::ISNewText(const char *dev, const char *name, char *
             nutMonitorUrl.apply();
             return true;
         }
+
+        if (upsVariables.isNameMatch(name))
+        {
+            upsVariables.update(texts, names, n);
+            upsVariables.setState(IPS_OK);
+            upsVariables.apply();
+            // Published again with the new selection on the next update
+            upsPropertiesValid = false;
+            return true;
+        }
     }
 
     return INDI::Weather::ISNewText(dev, name, texts, names, n);
@@ -132,23 +178,170 @@ bool NetworkUPSToolsMonitor::updateLocation(double latitude, double longitude, d
     return true;
 }
 
-IPState NetworkUPSToolsMonitor::updateWeather()
+std::vector<std::string> NetworkUPSToolsMonitor::getSelectedVariables() const
+{
+    std::vector<std::string> variables;
+    std::stringstream list(upsVariables[0].getText() ? upsVariables[0].getText() : "");
+    std::string variable;
+
+    while (std::getline(list, variable, ','))
+    {
+        variable.erase(0, variable.find_first_not_of(" \t"));
+        variable.erase(variable.find_last_not_of(" \t") + 1);
+        if (!variable.empty() && std::find(variables.begin(), variables.end(), variable) == variables.end())
+            variables.push_back(variable);
+    }
+
+    return variables;
+}
+
+IPState NetworkUPSToolsMonitor::getUpsState(const std::string &status)
+{
+    std::stringstream flags(status);
+    std::string flag;
+    IPState state = status.empty() ? IPS_IDLE : IPS_OK;
+
+    while (flags >> flag)
+    {
+        // Low battery, forced shutdown, off, overloaded or battery to replace
+        if (flag == "LB" || flag == "FSD" || flag == "OFF" || flag == "OVER" || flag == "RB")
+            return IPS_ALERT;
+        if (flag == "OB")
+            state = IPS_BUSY;
+    }
+
+    return state;
+}
+
+void NetworkUPSToolsMonitor::deleteUpsProperties()
+{
+    for (auto &ups : upsProperties)
+        deleteProperty(ups.property);
+
+    upsProperties.clear();
+    upsPropertiesValid = false;
+}
+
+void NetworkUPSToolsMonitor::defineUpsProperties()
 {
-    double charge = 0;
+    deleteUpsProperties();
 
-    auto devices = nutClient.getDeviceNames();
+    const auto &devices = telemetry.getDevices();
+    std::vector<std::string> selection = getSelectedVariables();
 
-    for (auto &device : devices)
+    upsPropertiesValid = true;
+    upsListVersion     = telemetry.getDeviceListVersion();
+
+    for (size_t i = 0; i < devices.size(); i++)
     {
-        auto variables = nutClient.getDeviceVariableValue(device, "battery.charge");
+        // Only the selected variables this UPS reports
+        std::vector<std::string> variables;
+        for (const auto &variable : selection)
+        {
+            if (devices[i].variables.count(variable))
+                variables.push_back(variable);
+        }
 
-        if (variables.size() == 0)
+        if (variables.empty())
+        {
+            // Nothing known yet if upsd had no data for it, try again on the next update
+            if (devices[i].variables.empty())
+                upsPropertiesValid = false;
             continue;
+        }
+
+        UpsProperty ups { i, variables, INDI::PropertyNumber(variables.size()) };
+        for (size_t j = 0; j < variables.size(); j++)
+            ups.property[j].fill(variables[j].c_str(), variables[j].c_str(), "%.1f", 0, 0, 0, 0);
+
+        std::string name  = "UPS_" + devices[i].name;
+        std::string group = "UPS " + devices[i].name;
+        ups.property.fill(getDeviceName(), name.c_str(), devices[i].description.c_str(), group.c_str(), IP_RO, 60, IPS_IDLE);
+
+        defineProperty(ups.property);
+        upsProperties.push_back(ups);
+    }
+}
+
+IPState NetworkUPSToolsMonitor::updateWeather()
+{
+    if (!telemetry.isConnected())
+    {
+        LOG_WARN("Connection to upsd lost, reconnecting...");
+        if (!openSession())
+            return IPS_ALERT;
+    }
+
+    // One exchange with upsd for all the variables of all the UPSes
+    if (!telemetry.poll())
+    {
+        LOGF_ERROR("Polling upsd failed: %s.", telemetry.getLastError().c_str());
+        return IPS_ALERT;
+    }
+
+    LOGF_DEBUG("Polled %zu UPS in %.1f ms.", telemetry.getDevices().size(), telemetry.getStatistics().lastPollDuration);
+
+    const auto &devices = telemetry.getDevices();
+    if (devices.empty())
+    {
+        LOG_WARN("upsd reports no UPS.");
+        return IPS_ALERT;
+    }
+
+    if (!upsPropertiesValid || upsListVersion != telemetry.getDeviceListVersion())
+        defineUpsProperties();
+
+    for (auto &ups : upsProperties)
+    {
+        const auto &device = devices[ups.device];
+        for (size_t j = 0; j < ups.variables.size(); j++)
+        {
+            auto value = device.variables.find(ups.variables[j]);
+            if (value != device.variables.end())
+                ups.property[j].setValue(atof(value->second.c_str()));
+        }
+
+        auto status = device.variables.find("ups.status");
+        ups.property.setState(device.stale ? IPS_IDLE :
+                              getUpsState(status != device.variables.end() ? status->second : ""));
+        ups.property.apply();
+    }
+
+    // The weather parameters follow the weakest UPS, with the last known values of a stale one
+    double charge = 100, runtime = -1, load = -1;
+    bool hasCharge = false;
+
+    for (const auto &device : devices)
+    {
+        if (device.stale && staleDevices.insert(device.name).second)
+            LOGF_WARN("UPS %s has no fresh data, using its last known values.", device.name.c_str());
+        else if (!device.stale && staleDevices.erase(device.name))
+            LOGF_INFO("UPS %s data is fresh again.", device.name.c_str());
+
+        auto value = device.variables.find("battery.charge");
+        if (value != device.variables.end())
+        {
+            charge    = std::min(charge, atof(value->second.c_str()));
+            hasCharge = true;
+        }
+
+        value = device.variables.find("battery.runtime");
+        if (value != device.variables.end())
+        {
+            double minutes = atof(value->second.c_str()) / 60;
+            runtime = (runtime < 0) ? minutes : std::min(runtime, minutes);
+        }
 
-        charge = atof(variables[0].c_str());
+        value = device.variables.find("ups.load");
+        if (value != device.variables.end())
+            load = std::max(load, atof(value->second.c_str()));
     }
 
-    setParameterValue("WEATHER_CHARGE_REMAINING", charge);
+    setParameterValue("WEATHER_CHARGE_REMAINING", hasCharge ? charge : 0);
+    if (runtime >= 0)
+        setParameterValue("WEATHER_RUNTIME_REMAINING", runtime);
+    if (load >= 0)
+        setParameterValue("WEATHER_UPS_LOAD", load);
 
     return IPS_OK;
 }
@@ -158,6 +351,7 @@ bool NetworkUPSToolsMonitor::saveConfigItems(FILE *fp)
     INDI::Weather::saveConfigItems(fp);
 
     nutMonitorUrl.save(fp);
+    upsVariables.save(fp);
 
     return true;
 }
@@ -27,8 +27,14 @@
 #pragma once
 
 #include <libindi/indiweather.h>
+#include <libindi/indipropertynumber.h>
 #include <libindi/indipropertytext.h>
-#include <nutclient.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "nut_telemetry.h"
 
 class NetworkUPSToolsMonitor : public INDI::Weather
 {
@@ -53,6 +59,12 @@ class NetworkUPSToolsMonitor : public INDI::Weather
         virtual bool updateLocation(double latitude, double longitude, double elevation) override;
 
     private:
+        bool openSession();
+        void defineUpsProperties();
+        void deleteUpsProperties();
+        std::vector<std::string> getSelectedVariables() const;
+        static IPState getUpsState(const std::string &status);
+
         INDI::PropertyText nutMonitorUrl{ 4 };
         enum
         {
@@ -62,5 +74,20 @@ class NetworkUPSToolsMonitor : public INDI::Weather
             INDEX_PASSWORD
         };
 
-        nut::TcpClient nutClient;
+        // Variables published for each UPS, comma separated
+        INDI::PropertyText upsVariables{ 1 };
+
+        // One property group per UPS, in the order of the telemetry device list
+        struct UpsProperty
+        {
+            size_t device;
+            std::vector<std::string> variables;
+            INDI::PropertyNumber property;
+        };
+        std::vector<UpsProperty> upsProperties;
+        uint32_t upsListVersion { 0 };
+        bool upsPropertiesValid { false };
+        std::set<std::string> staleDevices;
+
+        NutTelemetry telemetry;
 };
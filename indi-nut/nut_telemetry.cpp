@@ -0,0 +1,236 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+  INDI NUT Weather Driver
+
+  Batched UPS telemetry through libnutclient.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include "nut_telemetry.h"
+#include "config.h"
+
+#include <chrono>
+#include <set>
+
+NutTelemetry::~NutTelemetry()
+{
+    disconnect();
+}
+
+bool NutTelemetry::connect(const std::string &host, int port)
+{
+    disconnect();
+
+    try
+    {
+        m_Client.connect(host, port);
+    }
+    catch (nut::NutException &e)
+    {
+        return fail(std::string("cannot connect to ") + host + ": " + e.what());
+    }
+
+    m_DeviceListValid = false;
+    return true;
+}
+
+void NutTelemetry::disconnect()
+{
+    if (m_Client.isConnected())
+        m_Client.disconnect();
+}
+
+void NutTelemetry::setTimeout(int timeout)
+{
+    m_Client.setTimeout((timeout + 999) / 1000);
+}
+
+bool NutTelemetry::fail(const std::string &error)
+{
+    m_LastError = error;
+    disconnect();
+    return false;
+}
+
+std::string NutTelemetry::quote(const std::string &word)
+{
+    std::string quoted = "\"";
+    for (char c : word)
+    {
+        if (c == '"' || c == '\\')
+            quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+bool NutTelemetry::login(const std::string &user, const std::string &password)
+{
+    if (user.empty())
+        return true;
+
+    // libnutclient writes the credentials as they are, a line break would start another command
+    for (const std::string &word : { user, password })
+    {
+        for (unsigned char c : word)
+        {
+            if (c < 0x20 || c == 0x7f)
+            {
+                m_LastError = "control characters are not allowed in the user name and password";
+                return false;
+            }
+        }
+    }
+
+    try
+    {
+        m_Client.authenticate(quote(user), quote(password));
+    }
+    catch (nut::NutException &e)
+    {
+        m_LastError = std::string("login refused: ") + e.what();
+        return false;
+    }
+
+    return true;
+}
+
+bool NutTelemetry::fetchDevices()
+{
+    m_Statistics.deviceListRequests++;
+
+    std::vector<Device> devices;
+    try
+    {
+        for (const std::string &name : m_Client.getDeviceNames())
+        {
+            Device device;
+            // Keep what is known of the devices already listed, only new ones cost a request
+            for (const Device &known : m_Devices)
+            {
+                if (known.name == name)
+                {
+                    device = known;
+                    break;
+                }
+            }
+            if (device.name.empty())
+            {
+                device.name        = name;
+                device.description = m_Client.getDeviceDescription(name);
+                if (device.description.empty())
+                    device.description = name;
+            }
+            devices.push_back(device);
+        }
+    }
+    catch (nut::NutException &e)
+    {
+        return fail(std::string("listing the UPS failed: ") + e.what());
+    }
+
+    bool changed = devices.size() != m_Devices.size();
+    for (size_t i = 0; !changed && i < devices.size(); i++)
+        changed = devices[i].name != m_Devices[i].name || devices[i].description != m_Devices[i].description;
+
+    m_Devices.swap(devices);
+    m_DeviceListValid = true;
+    if (changed)
+        m_DeviceListVersion++;
+
+    return true;
+}
+
+bool NutTelemetry::poll()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if (!m_DeviceListValid && !fetchDevices())
+        return false;
+
+    if (m_Devices.empty())
+    {
+        // Nothing to poll, look for devices again next time
+        m_DeviceListValid = false;
+        m_Statistics.polls++;
+        return true;
+    }
+
+    std::map<std::string, std::map<std::string, std::vector<std::string>>> values;
+    try
+    {
+#ifdef HAVE_NUT_DEVICES_VARIABLE_VALUES
+        // All the requests in one go, upsd answers them in order. A UPS in error comes back empty.
+        std::set<std::string> names;
+        for (const Device &device : m_Devices)
+            names.insert(device.name);
+        values = m_Client.getDevicesVariableValues(names);
+#else
+        for (const Device &device : m_Devices)
+        {
+            try
+            {
+                values[device.name] = m_Client.getDeviceVariableValues(device.name);
+            }
+            catch (nut::IOException &)
+            {
+                throw;
+            }
+            catch (nut::NutException &)
+            {
+                // Stale data or unknown UPS, sorted out below
+            }
+        }
+#endif
+    }
+    catch (nut::NutException &e)
+    {
+        return fail(std::string("polling failed: ") + e.what());
+    }
+
+    bool missing = false;
+    for (Device &device : m_Devices)
+    {
+        auto found = values.find(device.name);
+        if (found == values.end() || found->second.empty())
+        {
+            // A UPS without fresh data keeps its last values
+            device.stale = true;
+            missing = true;
+            continue;
+        }
+
+        std::map<std::string, std::string> variables;
+        for (const auto &variable : found->second)
+            variables[variable.first] = variable.second.empty() ? "" : variable.second.front();
+        device.variables.swap(variables);
+        device.stale = false;
+    }
+
+    // The UPS may have been removed from upsd, and a lost connection also comes back empty
+    // from getDevicesVariableValues(). The device list tells which.
+    if (missing && !fetchDevices())
+        return false;
+
+    m_Statistics.polls++;
+    m_Statistics.lastPollDuration =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,127 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+  INDI NUT Weather Driver
+
+  Batched UPS telemetry over the NUT network protocol.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <nutclient.h>
+
+/**
+ * @brief Polls the variables of every UPS served by an upsd through libnutclient.
+ *
+ * The device list is fetched once and kept until a UPS comes back without variables or the
+ * connection is reopened. With NUT 2.8 or later a poll asks for the variables of all devices
+ * with getDevicesVariableValues(), which sends the requests together and costs one network
+ * round trip whatever the number of devices. Older libraries fall back to one request per device.
+ */
+class NutTelemetry
+{
+    public:
+        struct Device
+        {
+            std::string name;
+            std::string description;
+            std::map<std::string, std::string> variables;
+            // upsd has no fresh data from the driver of this UPS, the variables are the last known ones
+            bool stale { false };
+        };
+
+        struct Statistics
+        {
+            uint32_t polls { 0 };
+            uint32_t deviceListRequests { 0 };
+            double lastPollDuration { 0 };      // ms
+        };
+
+        NutTelemetry() = default;
+        ~NutTelemetry();
+
+        NutTelemetry(const NutTelemetry &) = delete;
+        NutTelemetry &operator=(const NutTelemetry &) = delete;
+
+        bool connect(const std::string &host, int port);
+        void disconnect();
+        bool isConnected()
+        {
+            return m_Client.isConnected();
+        }
+
+        /**
+         * @brief Authenticates the session, an empty user is accepted as no authentication.
+         *
+         * Credentials with control characters are refused, the others are sent quoted.
+         */
+        bool login(const std::string &user, const std::string &password);
+
+        /** Timeout of an exchange with upsd, in milliseconds, libnutclient rounds it up to whole seconds */
+        void setTimeout(int timeout);
+
+        /**
+         * @brief Refreshes the variables of all devices.
+         * @return false if the exchange failed, the connection is then closed.
+         */
+        bool poll();
+
+        const std::vector<Device> &getDevices() const
+        {
+            return m_Devices;
+        }
+
+        /** Changes every time the device list is fetched with a different content */
+        uint32_t getDeviceListVersion() const
+        {
+            return m_DeviceListVersion;
+        }
+
+        const Statistics &getStatistics() const
+        {
+            return m_Statistics;
+        }
+
+        const std::string &getLastError() const
+        {
+            return m_LastError;
+        }
+
+        /** Quotes a word for the NUT protocol, escaping quotes and backslashes */
+        static std::string quote(const std::string &word);
+
+    private:
+        bool fetchDevices();
+        bool fail(const std::string &error);
+
+        nut::TcpClient m_Client;
+        std::string m_LastError;
+
+        std::vector<Device> m_Devices;
+        bool m_DeviceListValid { false };
+        uint32_t m_DeviceListVersion { 0 };
+
+        Statistics m_Statistics;
+};
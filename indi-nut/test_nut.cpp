@@ -0,0 +1,493 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+  INDI NUT Weather Driver
+
+  Telemetry tests against a mock upsd on the loopback interface.
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "nut_telemetry.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+// Splits a protocol line in words, removing the quotes and escapes of quoted words
+std::vector<std::string> splitLine(const std::string &line)
+{
+    std::vector<std::string> words;
+    size_t i = 0;
+
+    while (i < line.size())
+    {
+        if (line[i] == ' ')
+        {
+            i++;
+            continue;
+        }
+
+        std::string word;
+        if (line[i] == '"')
+        {
+            for (i++; i < line.size() && line[i] != '"'; i++)
+            {
+                if (line[i] == '\\' && i + 1 < line.size())
+                    i++;
+                word += line[i];
+            }
+            i++;
+        }
+        else
+        {
+            for (; i < line.size() && line[i] != ' '; i++)
+                word += line[i];
+        }
+        words.push_back(word);
+    }
+
+    return words;
+}
+
+/**
+ * Answers LIST UPS, GET UPSDESC, LIST VAR, GET VAR and the login commands like upsd does. Every batch of
+ * requests received is answered after the configured latency, as if it crossed a network.
+ */
+class MockUpsd
+{
+    public:
+        MockUpsd(int devices, int latency) : m_Latency(latency)
+        {
+            for (int i = 0; i < devices; i++)
+            {
+                char name[16];
+                snprintf(name, sizeof(name), "ups%d", i);
+
+                auto &variables = m_Devices[name];
+                variables["battery.charge"]  = std::to_string(100 - i);
+                variables["battery.runtime"] = std::to_string(1800 + 60 * i);
+                variables["ups.load"]        = std::to_string(20 + i);
+                variables["input.voltage"]   = "230.1";
+                variables["ups.status"]      = "OL";
+                variables["ups.mfr"]         = "Eaton";
+                variables["ups.model"]       = "5P \"Rack\" 650\\i";
+                // A realistic UPS exposes a few dozen variables
+                for (int v = 0; v < 30; v++)
+                    variables["driver.parameter.p" + std::to_string(v)] = std::to_string(v);
+            }
+        }
+
+        ~MockUpsd()
+        {
+            m_Running = false;
+            if (m_Thread.joinable())
+                m_Thread.join();
+            close(m_Listener);
+        }
+
+        int start()
+        {
+            m_Listener = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address;
+            memset(&address, 0, sizeof(address));
+            address.sin_family      = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            socklen_t length = sizeof(address);
+            if (bind(m_Listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(m_Listener, 4) < 0 ||
+                    getsockname(m_Listener, reinterpret_cast<sockaddr *>(&address), &length) < 0)
+                return -1;
+
+            m_Running = true;
+            m_Thread = std::thread(&MockUpsd::serve, this);
+            return ntohs(address.sin_port);
+        }
+
+        void removeDevice(const std::string &name)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Devices.erase(name);
+        }
+
+        void setStale(const std::string &name, bool stale)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (stale)
+                m_Stale.insert(name);
+            else
+                m_Stale.erase(name);
+        }
+
+        int getCount(const std::string &command)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Counts[command];
+        }
+
+        std::string getUser()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_User;
+        }
+
+    private:
+        static std::string quote(const std::string &value)
+        {
+            std::string quoted = "\"";
+            for (char c : value)
+            {
+                if (c == '"' || c == '\\')
+                    quoted += '\\';
+                quoted += c;
+            }
+            return quoted + "\"";
+        }
+
+        std::string answer(const std::string &request)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            std::vector<std::string> words = splitLine(request);
+            std::string command = words.empty() ? "" : words[0] + (words.size() > 1 ? " " + words[1] : "");
+            m_Counts[command]++;
+
+            if (command == "LIST UPS")
+            {
+                std::string response = "BEGIN LIST UPS\n";
+                for (auto &device : m_Devices)
+                    response += "UPS " + device.first + " " + quote("Mock UPS " + device.first) + "\n";
+                return response + "END LIST UPS\n";
+            }
+
+            if (command == "GET UPSDESC" && words.size() == 3)
+            {
+                if (m_Devices.count(words[2]) == 0)
+                    return "ERR UNKNOWN-UPS\n";
+                return "UPSDESC " + words[2] + " " + quote("Mock UPS " + words[2]) + "\n";
+            }
+
+            if ((command == "LIST VAR" && words.size() == 3) || (command == "GET VAR" && words.size() == 4))
+            {
+                auto device = m_Devices.find(words[2]);
+                if (device == m_Devices.end())
+                    return "ERR UNKNOWN-UPS\n";
+                if (m_Stale.count(words[2]))
+                    return "ERR DATA-STALE\n";
+
+                if (command == "GET VAR")
+                {
+                    auto variable = device->second.find(words[3]);
+                    if (variable == device->second.end())
+                        return "ERR VAR-NOT-SUPPORTED\n";
+                    return "VAR " + words[2] + " " + words[3] + " " + quote(variable->second) + "\n";
+                }
+
+                std::string response = "BEGIN LIST VAR " + words[2] + "\n";
+                for (auto &variable : device->second)
+                    response += "VAR " + words[2] + " " + variable.first + " " + quote(variable.second) + "\n";
+                return response + "END LIST VAR " + words[2] + "\n";
+            }
+
+            if (words.size() == 2 && words[0] == "USERNAME")
+                m_User = words[1];
+            if (command.compare(0, 8, "USERNAME") == 0 || command.compare(0, 8, "PASSWORD") == 0)
+                return "OK\n";
+            if (command == "LOGOUT")
+                return "OK Goodbye\n";
+
+            return "ERR UNKNOWN-COMMAND\n";
+        }
+
+        void serve()
+        {
+            while (m_Running)
+            {
+                pollfd listener = { m_Listener, POLLIN, 0 };
+                if (poll(&listener, 1, 20) <= 0)
+                    continue;
+
+                int client = accept(m_Listener, nullptr, nullptr);
+                if (client < 0)
+                    continue;
+
+                std::string input;
+                while (m_Running)
+                {
+                    pollfd pfd = { client, POLLIN, 0 };
+                    if (poll(&pfd, 1, 20) <= 0)
+                        continue;
+
+                    char buffer[4096];
+                    ssize_t n = recv(client, buffer, sizeof(buffer), 0);
+                    if (n <= 0)
+                        break;
+                    input.append(buffer, n);
+
+                    std::this_thread::sleep_for(std::chrono::milliseconds(m_Latency));
+
+                    std::string output;
+                    size_t end;
+                    while ((end = input.find('\n')) != std::string::npos)
+                    {
+                        output += answer(input.substr(0, end));
+                        input.erase(0, end + 1);
+                    }
+                    if (!output.empty() && send(client, output.data(), output.size(), MSG_NOSIGNAL) < 0)
+                        break;
+                }
+                close(client);
+            }
+        }
+
+        int m_Latency;
+        int m_Listener { -1 };
+        std::atomic<bool> m_Running { false };
+        std::thread m_Thread;
+
+        std::mutex m_Mutex;
+        std::map<std::string, std::map<std::string, std::string>> m_Devices;
+        std::set<std::string> m_Stale;
+        std::map<std::string, int> m_Counts;
+        std::string m_User;
+};
+
+// One request at a time, as the driver used to poll
+class SequentialClient
+{
+    public:
+        explicit SequentialClient(int port)
+        {
+            m_FD = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address;
+            memset(&address, 0, sizeof(address));
+            address.sin_family      = AF_INET;
+            address.sin_port        = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (connect(m_FD, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+                m_FD = -1;
+        }
+
+        ~SequentialClient()
+        {
+            close(m_FD);
+        }
+
+        std::vector<std::string> query(const std::string &request, const std::string &last)
+        {
+            std::vector<std::string> lines;
+            std::string command = request + "\n";
+            if (send(m_FD, command.data(), command.size(), MSG_NOSIGNAL) < 0)
+                return lines;
+
+            while (true)
+            {
+                size_t end;
+                while ((end = m_Input.find('\n')) != std::string::npos)
+                {
+                    lines.push_back(m_Input.substr(0, end));
+                    m_Input.erase(0, end + 1);
+                    if (lines.back().compare(0, last.size(), last) == 0 || lines.back().compare(0, 3, "ERR") == 0)
+                        return lines;
+                }
+
+                char buffer[4096];
+                ssize_t n = recv(m_FD, buffer, sizeof(buffer), 0);
+                if (n <= 0)
+                    return lines;
+                m_Input.append(buffer, n);
+            }
+        }
+
+    private:
+        int m_FD { -1 };
+        std::string m_Input;
+};
+
+const std::vector<std::string> SELECTED = { "battery.charge", "battery.runtime", "ups.load", "input.voltage" };
+}
+
+TEST(NutTelemetry, QuotesCredentials)
+{
+    EXPECT_EQ(NutTelemetry::quote("monitor"), "\"monitor\"");
+    EXPECT_EQ(NutTelemetry::quote("se\"cr et\\"), "\"se\\\"cr et\\\\\"");
+
+    MockUpsd upsd(1, 0);
+    int port = upsd.start();
+    ASSERT_GT(port, 0);
+
+    NutTelemetry telemetry;
+    ASSERT_TRUE(telemetry.connect("127.0.0.1", port)) << telemetry.getLastError();
+    ASSERT_TRUE(telemetry.login("ups monitor", "secret")) << telemetry.getLastError();
+    EXPECT_EQ(upsd.getUser(), "ups monitor");
+
+    // A line break would let the password run another command
+    EXPECT_FALSE(telemetry.login("monitor", "secret\nFSD ups0"));
+    EXPECT_FALSE(telemetry.getLastError().empty());
+    EXPECT_EQ(upsd.getCount("FSD ups0"), 0);
+}
+
+TEST(NutTelemetry, PollsAllDevicesInOneExchange)
+{
+    MockUpsd upsd(3, 0);
+    int port = upsd.start();
+    ASSERT_GT(port, 0);
+
+    NutTelemetry telemetry;
+    ASSERT_TRUE(telemetry.connect("127.0.0.1", port)) << telemetry.getLastError();
+    ASSERT_TRUE(telemetry.login("monitor", "secret")) << telemetry.getLastError();
+
+    ASSERT_TRUE(telemetry.poll()) << telemetry.getLastError();
+    ASSERT_TRUE(telemetry.poll()) << telemetry.getLastError();
+
+    // Every UPS keeps its own values
+    const auto &devices = telemetry.getDevices();
+    ASSERT_EQ(devices.size(), 3u);
+    for (int i = 0; i < 3; i++)
+    {
+        EXPECT_EQ(devices[i].name, "ups" + std::to_string(i));
+        EXPECT_EQ(devices[i].description, "Mock UPS ups" + std::to_string(i));
+        EXPECT_EQ(devices[i].variables.at("battery.charge"), std::to_string(100 - i));
+        EXPECT_EQ(devices[i].variables.at("ups.model"), "5P \"Rack\" 650\\i");
+        EXPECT_EQ(devices[i].variables.size(), 37u);
+        EXPECT_FALSE(devices[i].stale);
+    }
+
+    // The device list is fetched once
+    EXPECT_EQ(upsd.getCount("LIST UPS"), 1);
+    EXPECT_EQ(upsd.getCount("GET UPSDESC"), 3);
+    EXPECT_EQ(upsd.getCount("LIST VAR"), 6);
+    EXPECT_EQ(telemetry.getStatistics().polls, 2u);
+}
+
+TEST(NutTelemetry, FollowsDeviceChanges)
+{
+    MockUpsd upsd(3, 0);
+    int port = upsd.start();
+    ASSERT_GT(port, 0);
+
+    NutTelemetry telemetry;
+    ASSERT_TRUE(telemetry.connect("127.0.0.1", port));
+    ASSERT_TRUE(telemetry.poll());
+    uint32_t version = telemetry.getDeviceListVersion();
+
+    // A UPS whose driver stopped answering keeps its place and its last values
+    upsd.setStale("ups1", true);
+    ASSERT_TRUE(telemetry.poll());
+    EXPECT_TRUE(telemetry.getDevices()[1].stale);
+    EXPECT_EQ(telemetry.getDevices()[1].variables.at("battery.charge"), "99");
+    EXPECT_EQ(telemetry.getDeviceListVersion(), version);
+
+    upsd.setStale("ups1", false);
+    ASSERT_TRUE(telemetry.poll());
+    EXPECT_FALSE(telemetry.getDevices()[1].stale);
+
+    // A removed UPS is dropped by the same poll, the others are not described again
+    upsd.removeDevice("ups1");
+    ASSERT_TRUE(telemetry.poll());
+    ASSERT_EQ(telemetry.getDevices().size(), 2u);
+    EXPECT_EQ(telemetry.getDevices()[1].name, "ups2");
+    EXPECT_EQ(telemetry.getDevices()[1].variables.at("battery.charge"), "98");
+    EXPECT_NE(telemetry.getDeviceListVersion(), version);
+    EXPECT_EQ(upsd.getCount("LIST UPS"), 3);
+    EXPECT_EQ(upsd.getCount("GET UPSDESC"), 3);
+}
+
+TEST(NutTelemetry, ReportsLostConnection)
+{
+    NutTelemetry telemetry;
+    telemetry.setTimeout(500);
+
+    {
+        MockUpsd upsd(1, 0);
+        int port = upsd.start();
+        ASSERT_TRUE(telemetry.connect("127.0.0.1", port));
+        ASSERT_TRUE(telemetry.poll());
+    }
+
+    EXPECT_FALSE(telemetry.poll());
+    EXPECT_FALSE(telemetry.isConnected());
+    EXPECT_FALSE(telemetry.getLastError().empty());
+}
+
+TEST(NutTelemetry, PollLatencyAsDevicesGrow)
+{
+    // 2 ms per network round trip
+    const int latency = 2;
+
+    for (int count : { 1, 4, 16, 64 })
+    {
+        MockUpsd upsd(count, latency);
+        int port = upsd.start();
+        ASSERT_GT(port, 0);
+
+        // The previous driver: list the devices, then one GET VAR per device and variable
+        double sequential = 0;
+        {
+            SequentialClient client(port);
+            auto start = std::chrono::steady_clock::now();
+            auto devices = client.query("LIST UPS", "END LIST UPS");
+            ASSERT_EQ(devices.size(), count + 2u);
+            for (int i = 0; i < count; i++)
+                for (const auto &variable : SELECTED)
+                    ASSERT_EQ(client.query("GET VAR ups" + std::to_string(i) + " " + variable, "VAR").size(), 1u);
+            sequential = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        NutTelemetry telemetry;
+        ASSERT_TRUE(telemetry.connect("127.0.0.1", port));
+        // The first poll also lists the devices
+        ASSERT_TRUE(telemetry.poll());
+        double polled = 0;
+        for (int i = 0; i < 5; i++)
+        {
+            ASSERT_TRUE(telemetry.poll());
+            polled += telemetry.getStatistics().lastPollDuration / 5;
+        }
+        ASSERT_EQ(telemetry.getDevices().size(), static_cast<size_t>(count));
+
+        std::cout << count << " UPS: sequential " << sequential << " ms for " << SELECTED.size()
+                  << " variables each, libnutclient " << polled << " ms for all " << telemetry.getDevices()[0].variables.size()
+                  << " variables each" << std::endl;
+
+        // Timings are only reported, a loaded machine makes them meaningless as asserts.
+        // Every poll asks once for every UPS, and the list is not fetched again.
+        EXPECT_EQ(upsd.getCount("LIST VAR"), 6 * count);
+        EXPECT_EQ(upsd.getCount("LIST UPS"), 2);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -136,25 +136,15 @@ int dcraw_parse_header_info(const char *filename, struct dcraw_header *header)
     return 0;
 }
 
-int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel,
-                char *bayer_pattern)
+static int unpack_libraw(LibRaw &RawProcessor, const char *name, uint8_t **memptr, size_t *memsize, int *n_axis, int *w,
+                         int *h, int *bitsperpixel, char *bayer_pattern)
 {
     int ret = 0;
-    // Creation of image processing object
-    LibRaw RawProcessor;
-
-    // Let us open the file
-    if ((ret = RawProcessor.open_file(filename)) != LIBRAW_SUCCESS)
-    {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open %s: %s", filename, libraw_strerror(ret));
-        RawProcessor.recycle();
-        return -1;
-    }
 
     // Let us unpack the image
     if ((ret = RawProcessor.unpack()) != LIBRAW_SUCCESS)
     {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot unpack %s: %s", filename, libraw_strerror(ret));
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot unpack %s: %s", name, libraw_strerror(ret));
         RawProcessor.recycle();
         return -1;
     }
@@ -162,7 +152,7 @@ int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_
     // Covert to image
     if ((ret = RawProcessor.raw2image()) != LIBRAW_SUCCESS)
     {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot convert %s : %s", filename, libraw_strerror(ret));
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot convert %s : %s", name, libraw_strerror(ret));
         RawProcessor.recycle();
         return -1;
     }
@@ -214,29 +204,50 @@ int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_
     return 0;
 }
 
-int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *naxis, int *w, int *h)
+int read_libraw(const char *filename, uint8_t **memptr, size_t *memsize, int *n_axis, int *w, int *h, int *bitsperpixel,
+                char *bayer_pattern)
 {
-    unsigned char *r_data = nullptr, *g_data = nullptr, *b_data = nullptr;
+    int ret = 0;
+    // Creation of image processing object
+    LibRaw RawProcessor;
 
-    /* these are standard libjpeg structures for reading(decompression) */
-    struct jpeg_decompress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    /* libjpeg data structure for storing one row, that is, scanline of an image */
-    JSAMPROW row_pointer[1] = { nullptr };
+    // Let us open the file
+    if ((ret = RawProcessor.open_file(filename)) != LIBRAW_SUCCESS)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open %s: %s", filename, libraw_strerror(ret));
+        RawProcessor.recycle();
+        return -1;
+    }
 
-    FILE *infile = fopen(filename, "rb");
+    return unpack_libraw(RawProcessor, filename, memptr, memsize, n_axis, w, h, bitsperpixel, bayer_pattern);
+}
 
-    if (!infile)
+int read_libraw_mem(const uint8_t *inBuffer, size_t inSize, uint8_t **memptr, size_t *memsize, int *n_axis, int *w,
+                    int *h, int *bitsperpixel, char *bayer_pattern)
+{
+    int ret = 0;
+    LibRaw RawProcessor;
+
+    // The buffer is used in place and must stay valid until the image is unpacked
+    if ((ret = RawProcessor.open_buffer(const_cast<uint8_t *>(inBuffer), inSize)) != LIBRAW_SUCCESS)
     {
-        DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG, "Error opening jpeg file %s!", filename);
+        DEBUGFDEVICE(device, INDI::Logger::DBG_ERROR, "Cannot open raw buffer: %s", libraw_strerror(ret));
+        RawProcessor.recycle();
         return -1;
     }
-    /* here we set up the standard libjpeg error handler */
-    cinfo.err = jpeg_std_error(&jerr);
-    /* setup decompression process and source, then read JPEG header */
-    jpeg_create_decompress(&cinfo);
-    /* this makes the library read from infile */
-    jpeg_stdio_src(&cinfo, infile);
+
+    return unpack_libraw(RawProcessor, "raw buffer", memptr, memsize, n_axis, w, h, bitsperpixel, bayer_pattern);
+}
+
+/* Decodes to one plane per component, for FITS, from whatever source cinfo was given */
+static int decode_jpeg_planes(struct jpeg_decompress_struct &cinfo, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
+                              int *h)
+{
+    unsigned char *r_data = nullptr, *g_data = nullptr, *b_data = nullptr;
+
+    /* libjpeg data structure for storing one row, that is, scanline of an image */
+    JSAMPROW row_pointer[1] = { nullptr };
+
     /* reading the image header which contains image information */
     jpeg_read_header(&cinfo, (boolean)TRUE);
 
@@ -288,20 +299,65 @@ int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *naxi
         }
     }
 
-    /* wrap up decompression, destroy objects, free pointers and close open files */
+    /* wrap up decompression, destroy objects, free pointers */
     jpeg_finish_decompress(&cinfo);
-    jpeg_destroy_decompress(&cinfo);
 
     if (row_pointer[0])
         free(row_pointer[0]);
-    if (infile)
-        fclose(infile);
 
     *memptr = oldmem;
 
     return 0;
 }
 
+int read_jpeg(const char *filename, uint8_t **memptr, size_t *memsize, int *naxis, int *w, int *h)
+{
+    /* these are standard libjpeg structures for reading(decompression) */
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    FILE *infile = fopen(filename, "rb");
+
+    if (!infile)
+    {
+        DEBUGFDEVICE(device, INDI::Logger::DBG_DEBUG, "Error opening jpeg file %s!", filename);
+        return -1;
+    }
+    /* here we set up the standard libjpeg error handler */
+    cinfo.err = jpeg_std_error(&jerr);
+    /* setup decompression process and source, then read JPEG header */
+    jpeg_create_decompress(&cinfo);
+    /* this makes the library read from infile */
+    jpeg_stdio_src(&cinfo, infile);
+
+    int rc = decode_jpeg_planes(cinfo, memptr, memsize, naxis, w, h);
+
+    jpeg_destroy_decompress(&cinfo);
+    fclose(infile);
+
+    return rc;
+}
+
+int read_jpeg_planes_mem(const uint8_t *inBuffer, size_t inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
+                         int *h)
+{
+    /* these are standard libjpeg structures for reading(decompression) */
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    /* here we set up the standard libjpeg error handler */
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    /* this makes the library read from the buffer, older libjpeg takes it as non const */
+    jpeg_mem_src(&cinfo, const_cast<uint8_t *>(inBuffer), inSize);
+
+    int rc = decode_jpeg_planes(cinfo, memptr, memsize, naxis, w, h);
+
+    jpeg_destroy_decompress(&cinfo);
+
+    return rc;
+}
+
 int read_jpeg_mem(unsigned char *inBuffer, unsigned long inSize, uint8_t **memptr, size_t *memsize, int *naxis, int *w,
                   int *h)
 {
@@ -22,10 +22,42 @@
 #include "pslr.h"
 #include <indimacros.h>
 
+#include <cerrno>
+
 #define MINISO 100
 #define MAXISO 102400
+#define PSLR_BUFFER_TIMEOUT 30000 /* Time for the camera to process an image (ms) */
 
-#define TMPFILEBASE (char *)"/tmp/indipentax.tmp"
+/* The camera image buffer, opened the way libpktriggercord save_buffer() does */
+class PslrCameraBuffer : public PslrBufferSource
+{
+    public:
+        PslrCameraBuffer(pslr_handle_t device, int bufno, pslr_buffer_type type, int resolution)
+            : device(device), bufno(bufno), type(type), resolution(resolution) {}
+
+        bool open() override
+        {
+            return pslr_buffer_open(device, bufno, type, resolution) == PSLR_OK;
+        }
+        uint32_t size() override
+        {
+            return pslr_buffer_get_size(device);
+        }
+        uint32_t read(uint8_t *buffer, uint32_t size) override
+        {
+            return pslr_buffer_read(device, buffer, size);
+        }
+        void close() override
+        {
+            pslr_buffer_close(device);
+        }
+
+    private:
+        pslr_handle_t device;
+        int bufno;
+        pslr_buffer_type type;
+        int resolution;
+};
 
 PkTriggerCordCCD::PkTriggerCordCCD(const char * name)
 {
@@ -266,6 +298,7 @@ bool PkTriggerCordCCD::Connect()
 
 bool PkTriggerCordCCD::Disconnect()
 {
+    worker.quit();
     pslr_disconnect(device);
     pslr_shutdown(device);
     return true;
@@ -299,41 +332,61 @@ bool PkTriggerCordCCD::shutterPress(pslr_rational_t shutter_speed)
     else
     {
         LOG_DEBUG("not bulb\n");
-        if (1)
-        {
-            pslr_shutter(device);
-        }
-        else
-        {
-            // TODO: fix waiting time
-            usleep(999999);
-            return false;
-        }
+        pslr_shutter(device);
     }
     LOG_DEBUG("Shutter pressed.");
     pslr_get_status(device, &status);
 
-    user_file_format_t ufft = *pslr_get_user_file_format_t(uff);
-    char * output_file = TMPFILEBASE;
-    int fd = open_file(output_file, 1, ufft);
+    return true;
+}
+
+bool PkTriggerCordCCD::downloadImage(const std::atomic_bool &isAboutToQuit)
+{
+    pslr_buffer_type type;
+    if (uff == USER_FILE_FORMAT_PEF)
+        type = PSLR_BUF_PEF;
+    else if (uff == USER_FILE_FORMAT_DNG)
+        type = PSLR_BUF_DNG;
+    else
+        type = pslr_get_jpeg_buffer_type(device, quality);
+
+    PslrCameraBuffer buffer(device, 0, type, status.jpeg_resolution);
 
-    int cnt = 0;
-    while ( save_buffer(device, 0, fd, &status, uff, quality ) )
-    {
-        LOGF_DEBUG("Saved buffer (%d)", cnt++);
-    }
+    // The buffer cannot be opened until the camera is done with the image. A non bulb exposure
+    // may still be running, and long exposure noise reduction takes as long again.
+    int timeout = PSLR_BUFFER_TIMEOUT + static_cast<int>(2000 * ExposureRequest);
+    int attempts = 0;
+    ssize_t size = download_pslr_buffer_wait(buffer, imageFile, isAboutToQuit, timeout, &attempts);
+
+    if (size < 0 && !isAboutToQuit)
+        LOGF_ERROR("Camera buffer could not be opened after %d attempts in %d seconds.", attempts, timeout / 1000);
+    else
+        LOGF_DEBUG("Downloaded %zd bytes to memory after %d attempts to open the buffer.", size, attempts);
 
     pslr_delete_buffer(device, 0);
-    if (fd != 1)
-    {
-        close(fd);
-    }
     if (need_bulb_new_cleanup)
     {
         bulb_new_cleanup(device);
+        need_bulb_new_cleanup = false;
     }
 
-    return 1;
+    return size > 0;
+}
+
+void PkTriggerCordCCD::captureImage(const std::atomic_bool &isAboutToQuit, pslr_rational_t shutter_speed)
+{
+    bool success = shutterPress(shutter_speed) && downloadImage(isAboutToQuit);
+
+    InDownload = false;
+    InExposure = false;
+
+    if (!success)
+        LOG_ERROR("Failed to download the image from the camera.");
+
+    if (success && grabImage())
+        ExposureComplete(&PrimaryCCD);
+    else
+        PrimaryCCD.setExposureFailed();
 }
 
 
@@ -416,7 +469,7 @@ bool PkTriggerCordCCD::StartExposure(float duration)
         gettimeofday(&ExpStart, nullptr);
         LOGF_INFO("Taking a %g seconds frame...", ExposureRequest);
 
-        shutter_result = std::async(std::launch::async, &PkTriggerCordCCD::shutterPress, this, shutter_speed);
+        worker.start(std::bind(&PkTriggerCordCCD::captureImage, this, std::placeholders::_1, shutter_speed));
 
         return true;
     }
@@ -552,22 +605,6 @@ void PkTriggerCordCCD::TimerHit()
                 PrimaryCCD.setExposureLeft(timeleft);
             }
         }
-
-        std::chrono::milliseconds span (100);
-        if ( shutter_result.wait_for(span) != std::future_status::timeout)
-        {
-            bool result = shutter_result.get();
-            INDI_UNUSED(result);
-            InDownload = false;
-            InExposure = false;
-
-            grabImage();
-            ExposureComplete(&PrimaryCCD);
-        }
-        else if (InDownload && isDebug())
-        {
-            IDLog("Still waiting for download...\n");
-        }
     }
 
     if (timerID == -1)
@@ -577,22 +614,7 @@ void PkTriggerCordCCD::TimerHit()
 
 bool PkTriggerCordCCD::grabImage()
 {
-    //set correct tmpfile location
-    char tmpfile[256];
-    if (uff == USER_FILE_FORMAT_JPEG)
-    {
-        snprintf(tmpfile, 256, "%s-0001.jpg", TMPFILEBASE);
-    }
-    else if (uff == USER_FILE_FORMAT_DNG)
-    {
-        snprintf(tmpfile, 256, "%s-0001.dng", TMPFILEBASE);
-    }
-    else
-    {
-        snprintf(tmpfile, 256, "%s-0001.pef", TMPFILEBASE);
-    }
-    LOGF_DEBUG("Reading temp file from: %s", tmpfile);
-
+    std::unique_lock<std::mutex> guard(ccdBufferLock);
 
     // fits handling code
     // if (transferFormatS[0].s == ISS_ON)
@@ -605,10 +627,9 @@ bool PkTriggerCordCCD::grabImage()
 
         if (uff == USER_FILE_FORMAT_JPEG)
         {
-            if (read_jpeg(tmpfile, &memptr, &memsize, &naxis, &w, &h))
+            if (read_jpeg_planes_mem(imageFile.data(), imageFile.size(), &memptr, &memsize, &naxis, &w, &h))
             {
                 LOG_ERROR("Exposure failed to parse jpeg.");
-                unlink(tmpfile);
                 return false;
             }
 
@@ -622,10 +643,9 @@ bool PkTriggerCordCCD::grabImage()
         {
             char bayer_pattern[8] = {};
 
-            if (read_libraw(tmpfile, &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern))
+            if (read_libraw_mem(imageFile.data(), imageFile.size(), &memptr, &memsize, &naxis, &w, &h, &bpp, bayer_pattern))
             {
                 LOG_ERROR("Exposure failed to parse raw image.");
-                unlink(tmpfile);
                 return false;
             }
 
@@ -648,59 +668,46 @@ bool PkTriggerCordCCD::grabImage()
         PrimaryCCD.setNAxis(naxis);
         PrimaryCCD.setBPP(bpp);
 
+        // Only the original ever touches the disk
         if (preserveOriginalS[1].s == ISS_ON)
-        {
-            char ts[32];
-            struct tm * tp;
-            time_t t;
-            time(&t);
-            tp = localtime(&t);
-            strftime(ts, sizeof(ts), "%Y-%m-%dT%H-%M-%S", tp);
-            std::string prefix = getUploadFilePrefix();
-            prefix = std::regex_replace(prefix, std::regex("XXX"), string(ts));
-            char newname[255];
-            snprintf(newname, 255, "%s.%s", prefix.c_str(), getFormatFileExtension(uff));
-            if (std::rename(tmpfile, newname))
-            {
-                LOGF_ERROR("File system error prevented saving original image to %s.  Saved to %s instead.", newname, tmpfile);
-            }
-            else
-            {
-                LOGF_INFO("Saved original image to %s.", newname);
-            }
-        }
-        else
-        {
-            std::remove(tmpfile);
-        }
-
+            saveOriginal();
     }
     // native handling code
     else
     {
         PrimaryCCD.setImageExtension(getFormatFileExtension(uff));
+        PrimaryCCD.setFrameBufferSize(imageFile.size());
+        memcpy(PrimaryCCD.getFrameBuffer(), imageFile.data(), imageFile.size());
+        LOG_DEBUG("Copied to frame buffer.");
+    }
 
-        FILE* f = fopen(tmpfile, "r");
-        fseek(f, 0, SEEK_END);
-        size_t size = ftell(f);
-        rewind(f);
+    return true;
+}
 
-        PrimaryCCD.setFrameBufferSize(size);
-        char * memptr = (char *)PrimaryCCD.getFrameBuffer();
-        size_t readSize = fread(memptr, sizeof(char), size, f);
-        if (readSize != size)
-        {
-            LOGF_ERROR("Error, %u bytes of data read instead of %u.", readSize, size);
-        }
-        PrimaryCCD.setFrameBuffer((unsigned char *)memptr);
-        fclose(f);
-        LOG_DEBUG("Copied to frame buffer.  Leaving temp file for debug purposes.");
-        if (!isDebug())
-        {
-            std::remove(tmpfile);
-        }
+bool PkTriggerCordCCD::saveOriginal()
+{
+    char ts[32];
+    struct tm * tp;
+    time_t t;
+    time(&t);
+    tp = localtime(&t);
+    strftime(ts, sizeof(ts), "%Y-%m-%dT%H-%M-%S", tp);
+    std::string prefix = getUploadFilePrefix();
+    prefix = std::regex_replace(prefix, std::regex("XXX"), string(ts));
+    char newname[255];
+    snprintf(newname, 255, "%s.%s", prefix.c_str(), getFormatFileExtension(uff));
+
+    FILE *f = fopen(newname, "wb");
+    if (f == nullptr || fwrite(imageFile.data(), 1, imageFile.size(), f) != imageFile.size())
+    {
+        LOGF_ERROR("File system error prevented saving original image to %s: %s.", newname, strerror(errno));
+        if (f)
+            fclose(f);
+        return false;
     }
+    fclose(f);
 
+    LOGF_INFO("Saved original image to %s.", newname);
     return true;
 }
 
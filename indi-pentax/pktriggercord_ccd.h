@@ -25,12 +25,15 @@
 #include <stream/streammanager.h>
 #include <unistd.h>
 #include <regex>
-#include <future>
+#include <atomic>
+#include <vector>
+#include <indisinglethreadpool.h>
 
 #include "config.h"
 #include "eventloop.h"
 
 #include "gphoto_readimage.h"
+#include "pktriggercord_download.h"
 
 extern "C" {
 #include "libpktriggercord.h"
@@ -116,6 +119,7 @@ protected:
 
     void updateCaptureSettingSwitch(ISwitchVectorProperty *sw, ISState *states, char *names[], int n);
     bool grabImage();
+    bool saveOriginal();
     string getUploadFilePrefix();
     const char * getFormatFileExtension(user_file_format format);
     void refreshBatteryStatus();
@@ -124,7 +128,13 @@ protected:
     void buildCaptureSettingSwitch(ISwitchVectorProperty *control, string optionList[], size_t numOptions, const char *label, const char *name, string currentsetting = "");
 
     bool shutterPress(pslr_rational_t shutter_speed);
-    std::future<bool> shutter_result;
+    bool downloadImage(const std::atomic_bool &isAboutToQuit);
+    void captureImage(const std::atomic_bool &isAboutToQuit, pslr_rational_t shutter_speed);
+
+    // Exposure, download and decoding run here, the worker completes the exposure
+    INDI::SingleThreadPool worker;
+    // The image file as sent by the camera, kept from frame to frame to reuse its memory
+    std::vector<uint8_t> imageFile;
 };
 
 #endif // PKTRIGGERCORD_CCD_H
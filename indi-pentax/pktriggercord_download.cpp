@@ -0,0 +1,83 @@
+/*
+ Pentax CCD Driver for Indi (using PkTriggerCord)
+ Camera buffer download to memory
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+ */
+
+#include "pktriggercord_download.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+ssize_t download_pslr_buffer(PslrBufferSource &source, std::vector<uint8_t> &image)
+{
+    image.clear();
+
+    if (!source.open())
+        return -1;
+
+    // The announced size is a hint only, reading goes on until the camera has no more.
+    // One more segment leaves room for the read that finds the end.
+    image.reserve(source.size() + PSLR_SEGMENT_SIZE);
+
+    while (true)
+    {
+        size_t offset = image.size();
+        if (image.capacity() - offset < PSLR_SEGMENT_SIZE)
+            image.reserve(offset + offset / 2 + PSLR_SEGMENT_SIZE);
+
+        // Segments land directly at the end of the image, no intermediate copy
+        image.resize(offset + PSLR_SEGMENT_SIZE);
+        uint32_t bytes = source.read(image.data() + offset, PSLR_SEGMENT_SIZE);
+        image.resize(offset + bytes);
+
+        if (bytes == 0)
+            break;
+    }
+
+    source.close();
+    return image.size();
+}
+
+ssize_t download_pslr_buffer_wait(PslrBufferSource &source, std::vector<uint8_t> &image,
+                                  const std::atomic_bool &abort, int timeout, int *attempts)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    std::chrono::milliseconds delay(10);
+    ssize_t size = -1;
+    int count = 0;
+
+    while (true)
+    {
+        count++;
+        if ((size = download_pslr_buffer(source, image)) >= 0 || abort)
+            break;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            break;
+
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(delay, deadline - now));
+        delay = std::min(delay * 2, std::chrono::milliseconds(500));
+    }
+
+    if (attempts != nullptr)
+        *attempts = count;
+    return size;
+}
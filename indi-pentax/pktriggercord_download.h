@@ -0,0 +1,73 @@
+/*
+ Pentax CCD Driver for Indi (using PkTriggerCord)
+ Camera buffer download to memory
+ Copyright (C) 2026
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <sys/types.h>
+
+/**
+ * @brief An image buffer of the camera, read in segments.
+ *
+ * Same calls as pslr_buffer_open(), pslr_buffer_get_size(), pslr_buffer_read() and
+ * pslr_buffer_close(), so the download can be tested without a camera.
+ */
+class PslrBufferSource
+{
+    public:
+        virtual ~PslrBufferSource() = default;
+
+        /** False if the buffer cannot be read yet */
+        virtual bool open() = 0;
+        /** Size announced by the camera, 0 if unknown */
+        virtual uint32_t size() = 0;
+        /** Reads the next segment, 0 at the end of the buffer */
+        virtual uint32_t read(uint8_t *buffer, uint32_t size) = 0;
+        virtual void close() = 0;
+};
+
+/** Segment size requested from the camera, as libpktriggercord save_buffer() does */
+#define PSLR_SEGMENT_SIZE 65536
+
+/**
+ * @brief Reads a whole camera buffer into memory.
+ * @param source the opened buffer is closed before returning.
+ * @param image receives the image file. Its capacity is kept from frame to frame, so
+ * reusing the same vector only allocates when the images grow.
+ * @return the size of the image, -1 if the buffer could not be opened.
+ */
+ssize_t download_pslr_buffer(PslrBufferSource &source, std::vector<uint8_t> &image);
+
+/**
+ * @brief Downloads a camera buffer once the camera lets it be opened.
+ *
+ * The camera refuses the buffer until the image is processed. Opening is retried with a
+ * delay doubling from 10 ms up to 500 ms, until timeout milliseconds have passed or abort
+ * is set.
+ * @param attempts if not null, receives the number of times the buffer was opened.
+ * @return the size of the image, -1 if the buffer could not be opened in time.
+ */
+ssize_t download_pslr_buffer_wait(PslrBufferSource &source, std::vector<uint8_t> &image,
+                                  const std::atomic_bool &abort, int timeout, int *attempts = nullptr);
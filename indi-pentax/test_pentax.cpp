@@ -0,0 +1,299 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : test_pentax.cpp
+ * Pentax camera buffer download and decoding, without a camera
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <jpeglib.h>
+#include <sharedblob.h>
+
+#include "gphoto_readimage.h"
+#include "pktriggercord_download.h"
+
+/* Serves an image the way the camera does, in segments that may be shorter than asked */
+class FakeBuffer : public PslrBufferSource
+{
+    public:
+        explicit FakeBuffer(const std::vector<uint8_t> &image) : image(image) {}
+
+        bool open() override
+        {
+            opens++;
+            offset = 0;
+            return failures-- <= 0;
+        }
+        uint32_t size() override
+        {
+            return announced;
+        }
+        uint32_t read(uint8_t *buffer, uint32_t size) override
+        {
+            reads++;
+            uint32_t bytes = std::min<size_t>({ size, segment, image.size() - offset });
+            memcpy(buffer, image.data() + offset, bytes);
+            offset += bytes;
+            return bytes;
+        }
+        void close() override
+        {
+            closes++;
+        }
+
+        const std::vector<uint8_t> &image;
+        uint32_t announced { 0 };
+        size_t segment { PSLR_SEGMENT_SIZE };
+        int failures { 0 };
+
+        size_t offset { 0 };
+        int opens { 0 }, reads { 0 }, closes { 0 };
+};
+
+static std::vector<uint8_t> makeJpeg(int width, int height, uint8_t noise = 0)
+{
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    unsigned char *buffer = nullptr;
+    unsigned long size = 0;
+    jpeg_mem_dest(&cinfo, &buffer, &size);
+
+    cinfo.image_width      = width;
+    cinfo.image_height     = height;
+    cinfo.input_components = 3;
+    cinfo.in_color_space   = JCS_RGB;
+    jpeg_set_defaults(&cinfo);
+    jpeg_set_quality(&cinfo, 95, TRUE);
+    jpeg_start_compress(&cinfo, TRUE);
+
+    // Gradients, with some sensor noise to get the size of a real frame
+    std::vector<uint8_t> row(width * 3);
+    uint32_t seed = 1;
+    while (cinfo.next_scanline < cinfo.image_height)
+    {
+        int y = cinfo.next_scanline;
+        for (int x = 0; x < width; x++)
+        {
+            seed = seed * 1103515245 + 12345;
+            uint8_t n = noise ? (seed >> 16) % noise : 0;
+            row[x * 3]     = x * 255 / width / 2 + n;
+            row[x * 3 + 1] = y * 255 / height / 2 + n;
+            row[x * 3 + 2] = 64 + n;
+        }
+        JSAMPROW pointer = row.data();
+        jpeg_write_scanlines(&cinfo, &pointer, 1);
+    }
+
+    jpeg_finish_compress(&cinfo);
+    jpeg_destroy_compress(&cinfo);
+
+    std::vector<uint8_t> image(buffer, buffer + size);
+    free(buffer);
+    return image;
+}
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(PslrDownload, WholeBufferInShortSegments)
+{
+    std::vector<uint8_t> image(200000);
+    for (size_t i = 0; i < image.size(); i++)
+        image[i] = i * 7;
+
+    FakeBuffer buffer(image);
+    buffer.segment   = 1000;
+    buffer.announced = 4096;    // wrong on purpose, the end of the data decides
+
+    std::vector<uint8_t> downloaded;
+    EXPECT_EQ(download_pslr_buffer(buffer, downloaded), static_cast<ssize_t>(image.size()));
+    EXPECT_EQ(downloaded, image);
+    EXPECT_EQ(buffer.opens, 1);
+    EXPECT_EQ(buffer.closes, 1);
+    EXPECT_EQ(buffer.reads, 201);
+}
+
+TEST(PslrDownload, NotReady)
+{
+    std::vector<uint8_t> image(1000, 1);
+    FakeBuffer buffer(image);
+    buffer.failures = 2;
+
+    std::vector<uint8_t> downloaded(10);
+    EXPECT_EQ(download_pslr_buffer(buffer, downloaded), -1);
+    EXPECT_TRUE(downloaded.empty());
+    EXPECT_EQ(download_pslr_buffer(buffer, downloaded), -1);
+    EXPECT_EQ(download_pslr_buffer(buffer, downloaded), 1000);
+    EXPECT_EQ(buffer.closes, 1);
+}
+
+TEST(PslrDownload, WaitsWithBackoff)
+{
+    std::vector<uint8_t> image(1000, 1);
+    std::vector<uint8_t> downloaded;
+    std::atomic_bool abort { false };
+    int attempts = 0;
+
+    // Ready on the fourth opening, after 10 + 20 + 40 ms of waits
+    FakeBuffer late(image);
+    late.failures = 3;
+    EXPECT_EQ(download_pslr_buffer_wait(late, downloaded, abort, 10000, &attempts), 1000);
+    EXPECT_EQ(attempts, 4);
+
+    // Never ready: the delays double, so a 1 s timeout allows only a few openings
+    FakeBuffer never(image);
+    never.failures = 1000000;
+    EXPECT_EQ(download_pslr_buffer_wait(never, downloaded, abort, 1000, &attempts), -1);
+    EXPECT_EQ(attempts, never.opens);
+    EXPECT_GE(attempts, 2);
+    EXPECT_LE(attempts, 9);
+
+    // Abort stops at once
+    abort = true;
+    FakeBuffer aborted(image);
+    aborted.failures = 1000000;
+    EXPECT_EQ(download_pslr_buffer_wait(aborted, downloaded, abort, 10000, &attempts), -1);
+    EXPECT_EQ(attempts, 1);
+}
+
+TEST(PslrDownload, MemoryIsReused)
+{
+    std::vector<uint8_t> large(3 * 1000 * 1000, 2), small(1000 * 1000, 3);
+    std::vector<uint8_t> downloaded;
+
+    FakeBuffer first(large);
+    first.announced = large.size();
+    download_pslr_buffer(first, downloaded);
+    const uint8_t *memory = downloaded.data();
+
+    FakeBuffer second(small);
+    second.announced = small.size();
+    download_pslr_buffer(second, downloaded);
+    EXPECT_EQ(downloaded.data(), memory);
+    EXPECT_EQ(downloaded, small);
+}
+
+TEST(PentaxDecode, JpegFromMemoryMatchesFile)
+{
+    std::vector<uint8_t> jpeg = makeJpeg(320, 240);
+
+    uint8_t *memory = nullptr;
+    size_t memsize = 0;
+    int naxis = 0, w = 0, h = 0;
+    ASSERT_EQ(read_jpeg_planes_mem(jpeg.data(), jpeg.size(), &memory, &memsize, &naxis, &w, &h), 0);
+    EXPECT_EQ(naxis, 3);
+    EXPECT_EQ(w, 320);
+    EXPECT_EQ(h, 240);
+    EXPECT_EQ(memsize, 320u * 240u * 3u);
+
+    // One plane per color: red grows along the rows, green down the columns, blue is flat
+    EXPECT_NEAR(memory[319], 127, 3);
+    EXPECT_NEAR(memory[320 * 240 + 239 * 320], 127, 3);
+    EXPECT_NEAR(memory[2 * 320 * 240 + 1000], 64, 3);
+
+    char name[] = "/tmp/test_pentax_XXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(write(fd, jpeg.data(), jpeg.size()), static_cast<ssize_t>(jpeg.size()));
+    close(fd);
+
+    uint8_t *fromFile = nullptr;
+    size_t fileSize = 0;
+    ASSERT_EQ(read_jpeg(name, &fromFile, &fileSize, &naxis, &w, &h), 0);
+    unlink(name);
+
+    ASSERT_EQ(fileSize, memsize);
+    EXPECT_EQ(memcmp(memory, fromFile, memsize), 0);
+
+    IDSharedBlobFree(memory);
+    IDSharedBlobFree(fromFile);
+}
+
+// PEF and DNG decoding go through LibRaw open_buffer too, they are left to camera samples
+TEST(PentaxDecode, CorruptRawIsRejected)
+{
+    std::vector<uint8_t> garbage(100000, 0x5a);
+    uint8_t *memory = nullptr;
+    size_t memsize = 0;
+    int naxis = 0, w = 0, h = 0, bpp = 0;
+    char bayer[8] = {};
+    EXPECT_NE(read_libraw_mem(garbage.data(), garbage.size(), &memory, &memsize, &naxis, &w, &h, &bpp, bayer), 0);
+}
+
+/* Per frame latency and file system traffic, against the temporary file the driver used */
+TEST(PentaxDecode, MemoryPathAgainstFileRoundTrip)
+{
+    const int frames = 3;
+    std::vector<uint8_t> jpeg = makeJpeg(3000, 2000, 64);
+    std::vector<uint8_t> downloaded;
+    uint8_t *memory = nullptr, *fromFile = nullptr;
+    size_t memsize = 0, fileSize = 0;
+    int naxis = 0, w = 0, h = 0;
+
+    // tmpfs when there is one, as /tmp usually is
+    std::string name = access("/dev/shm", W_OK) == 0 ? "/dev/shm/test_pentax.jpg" : "/tmp/test_pentax.jpg";
+
+    auto start = std::chrono::steady_clock::now();
+    size_t fileBytes = 0;
+    for (int i = 0; i < frames; i++)
+    {
+        FakeBuffer buffer(jpeg);
+        ASSERT_TRUE(buffer.open());
+        int fd = open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        ASSERT_GE(fd, 0);
+        uint8_t segment[PSLR_SEGMENT_SIZE];
+        uint32_t bytes;
+        while ((bytes = buffer.read(segment, sizeof(segment))) > 0)
+            fileBytes += write(fd, segment, bytes);
+        close(fd);
+        ASSERT_EQ(read_jpeg(name.c_str(), &fromFile, &fileSize, &naxis, &w, &h), 0);
+        fileBytes += jpeg.size();
+        unlink(name.c_str());
+    }
+    double fileMs = elapsedMs(start) / frames;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        FakeBuffer buffer(jpeg);
+        ASSERT_EQ(download_pslr_buffer(buffer, downloaded), static_cast<ssize_t>(jpeg.size()));
+        ASSERT_EQ(read_jpeg_planes_mem(downloaded.data(), downloaded.size(), &memory, &memsize, &naxis, &w, &h), 0);
+    }
+    double memoryMs = elapsedMs(start) / frames;
+
+    ASSERT_EQ(memsize, fileSize);
+    EXPECT_EQ(memcmp(memory, fromFile, memsize), 0);
+
+    printf("%zu bytes JPEG, per frame: file round trip %.1f ms with %zu bytes through %s, memory %.1f ms with none\n",
+           jpeg.size(), fileMs, fileBytes / frames, name.c_str(), memoryMs);
+
+    IDSharedBlobFree(memory);
+    IDSharedBlobFree(fromFile);
+}
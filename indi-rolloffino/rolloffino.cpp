@@ -840,6 +840,7 @@ bool RollOffIno::Handshake()
         LOG_WARN("The connection port has not been established");
         return false;
     }
+    framer.setFD(PortFD);
 
     if (!initialContact())
     {
@@ -1072,28 +1073,14 @@ bool RollOffIno::CommandOutput(uint32_t index, OutputState command)
 ////////////////////////////////////////////////////////////////////////////////////////
 bool RollOffIno::readIno(char* retBuf)
 {
-    const char stop_char {RORINO_STOP_CHAR};
-    int nbytes_read = 0;
-    int rc = TTY_OK;
-
-    for (int i = 0; i < 2; i++)
-    {
-        rc = tty_nread_section(PortFD, retBuf, MAXINPBUF - 1, stop_char, MAXINOWAIT, &nbytes_read);
-        if (rc != TTY_OK)
-        {
-            msSleep(1000);
-            continue;
-        }
-        LOGF_DEBUG("Read from roof controller: %s", retBuf);
-        return true;
-    }
-    if (rc != TTY_OK)
+    SerialFramer::Result rc = RollOffInoProtocol::readResponse(framer, retBuf);
+    if (rc != SerialFramer::FRAME_OK)
     {
-        char errstr[MAXRBUF] = {0};
-        tty_error_msg(rc, errstr, MAXRBUF - 1);
-        LOGF_ERROR("Arduino connection read error: %s.", errstr);
+        LOGF_ERROR("Arduino connection read error: %s.", SerialFramer::resultMessage(rc));
+        return false;
     }
-    return false;
+    LOGF_DEBUG("Read from roof controller: %s", retBuf);
+    return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -1101,22 +1088,20 @@ bool RollOffIno::readIno(char* retBuf)
 ////////////////////////////////////////////////////////////////////////////////////////
 bool RollOffIno::writeIno(const char* msg)
 {
-    int retMsgLen = 0;
-    int status;
-
     if (strlen(msg) >= MAXOUTBUF - 1)
     {
         LOG_ERROR("Roof controller command message too long");
         return false;
     }
     LOGF_DEBUG("Sent to roof controller: %s", msg);
-    tcflush(PortFD, TCIOFLUSH);
-    status = tty_write_string(PortFD, msg, &retMsgLen);
-    if (status != TTY_OK)
+    // Drop a late answer to a previous request
+    size_t stale = 0;
+    SerialFramer::Result status = RollOffInoProtocol::writeRequest(framer, msg, &stale);
+    if (stale > 0)
+        LOGF_DEBUG("Discarded %d stale bytes from roof controller", static_cast<int>(stale));
+    if (status != SerialFramer::FRAME_OK)
     {
-        char errstr[MAXRBUF];
-        tty_error_msg(status, errstr, MAXRBUF);
-        LOGF_DEBUG("Arduino Connection write error: %s", errstr);
+        LOGF_DEBUG("Arduino Connection write error: %s", SerialFramer::resultMessage(status));
         return false;
     }
     return true;
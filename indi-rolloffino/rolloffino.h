@@ -26,6 +26,7 @@
 #include "indiinputinterface.h"
 #include "indioutputinterface.h"
 #include "inditimer.h"
+#include "rolloffino_protocol.h"
 
 class RollOffIno : public INDI::Dome, public INDI::InputInterface, public INDI::OutputInterface
 {
@@ -70,9 +71,6 @@ private:
     void roofTimerExpired();
 
 #define MAX_CNTRL_COM_ERR 10         // Maximum consecutive errors communicating with Arduino
-#define MAXOUTBUF        64          // Sized to contain outgoing command requests
-#define MAXINPBUF        256         // Sized for maximum overall input
-#define MAXINOWAIT       3           // seconds
 #define MAX_ACTIONS 8
 #define POLLING_PERIOD    3000
 
@@ -138,7 +136,7 @@ const char* inpRoRino[MAX_ACTIONS] = {
     enum {ROOF_STATUS_OPENED, ROOF_STATUS_CLOSED, ROOF_STATUS_MOVING, ROOF_STATUS_LOCKED, ROOF_STATUS_AUXSTATE};
     INDI::PropertyLight ActionStatusLP {MAX_ACTIONS};
 
-    static const char RORINO_STOP_CHAR {0x29};         // ')'
+    SerialFramer framer { MAXINPBUF };
     enum {EXPIRED_CLEAR, EXPIRED_OPEN, EXPIRED_CLOSE, EXPIRED_ABORT};
     unsigned int roofTimedOut = EXPIRED_CLEAR;
     INDI::Timer roofMoveTimer;
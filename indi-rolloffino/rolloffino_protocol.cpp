@@ -0,0 +1,62 @@
+/*
+ RollOff ino serial exchanges
+ Copyright(c) 2026. All rights reserved.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "rolloffino_protocol.h"
+
+#include <cstring>
+
+namespace RollOffInoProtocol
+{
+SerialFramer::Result writeRequest(SerialFramer &framer, const char *msg, size_t *stale)
+{
+    if (strlen(msg) >= MAXOUTBUF - 1)
+        return SerialFramer::FRAME_OVERFLOW;
+
+    // Cheaper than flushing the port, and output queued for the controller is kept
+    size_t discarded = framer.discardInput();
+    if (stale != nullptr)
+        *stale = discarded;
+
+    return framer.write(msg, strlen(msg), MAXINOWAIT * 1000);
+}
+
+SerialFramer::Result readResponse(SerialFramer &framer, char *retBuf, int timeout)
+{
+    const char stop_char[] {STOP_CHAR, 0};
+    std::string response;
+    SerialFramer::Result rc = SerialFramer::FRAME_OK;
+
+    retBuf[0] = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        rc = framer.readFrame(response, stop_char, timeout);
+        if (rc == SerialFramer::FRAME_TIMEOUT)
+            continue;
+        if (rc != SerialFramer::FRAME_OK)
+            break;
+
+        response += STOP_CHAR;
+        strncpy(retBuf, response.c_str(), MAXINPBUF - 1);
+        retBuf[MAXINPBUF - 1] = 0;
+        break;
+    }
+
+    return rc;
+}
+}
@@ -0,0 +1,51 @@
+/*
+ RollOff ino serial exchanges
+ Copyright(c) 2026. All rights reserved.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License as published by the Free Software Foundation; either
+ version 2.1 of the License, or (at your option) any later version.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include "serialframer.h"
+
+#define MAXOUTBUF        64          // Sized to contain outgoing command requests
+#define MAXINPBUF        256         // Sized for maximum overall input
+#define MAXINOWAIT       3           // seconds
+
+/*
+ * Requests and responses of the roof controller are framed by parentheses, "(GET:OPENED:0)"
+ * is answered by "(ACK:OPENED:ON)". These helpers do not depend on INDI so the tests can run
+ * them against a script on a pseudo terminal.
+ */
+namespace RollOffInoProtocol
+{
+static const char STOP_CHAR {0x29};         // ')'
+
+/**
+ * @brief Sends a request, dropping first the late answer to a previous one.
+ * @param stale if not null, receives the number of bytes discarded.
+ * @return FRAME_OVERFLOW if the request does not fit MAXOUTBUF.
+ */
+SerialFramer::Result writeRequest(SerialFramer &framer, const char *msg, size_t *stale = nullptr);
+
+/**
+ * @brief Reads one response into retBuf, MAXINPBUF bytes, the stop character included.
+ *
+ * The read is tried twice, a response cut by the first timeout stays buffered and is completed
+ * by the second attempt.
+ */
+SerialFramer::Result readResponse(SerialFramer &framer, char *retBuf, int timeout = MAXINOWAIT * 1000);
+}
@@ -0,0 +1,148 @@
+/*
+    RollOff ino serial protocol on a pseudo terminal
+    Copyright(c) 2026. All rights reserved.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <gtest/gtest.h>
+
+#include "rolloffino_protocol.h"
+#include "serialscript.h"
+
+#include <cstring>
+
+#define POLLS 10
+
+// One status poll of the driver asks for each switch of the roof
+static const char *REQUESTS[] =
+{
+    "(GET:OPENED:0)", "(GET:CLOSED:0)", "(GET:LOCKED:0)", "(GET:AUXSTATE:0)"
+};
+
+class RollOffInoLink : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            script.add("(GET:OPENED:0)", "(ACK:OPENED:ON)");
+            script.add("(GET:CLOSED:0)", "(ACK:CLOSED:OFF)");
+            script.add("(GET:LOCKED:0)", "(ACK:LOCKED:OFF)");
+            script.add("(GET:AUXSTATE:0)", "(ACK:AUXSTATE:OFF)");
+            script.setPacing(4, 100);
+            fd = script.start();
+            ASSERT_GE(fd, 0);
+        }
+
+        SerialScript script;
+        int fd { -1 };
+};
+
+TEST_F(RollOffInoLink, StatusPoll)
+{
+    SerialFramer framer(MAXINPBUF);
+    framer.setFD(fd);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < POLLS; i++)
+    {
+        for (const char *request : REQUESTS)
+        {
+            char response[MAXINPBUF];
+            ASSERT_EQ(RollOffInoProtocol::writeRequest(framer, request), SerialFramer::FRAME_OK);
+            ASSERT_EQ(RollOffInoProtocol::readResponse(framer, response), SerialFramer::FRAME_OK);
+            EXPECT_EQ(strncmp(response, "(ACK:", 5), 0);
+            EXPECT_EQ(response[strlen(response) - 1], ')');
+        }
+    }
+    double framed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / POLLS;
+    double framedCalls = static_cast<double>(framer.getStatistics().syscalls()) / POLLS;
+
+    // The same polls with tcflush() and tty_nread_section()
+    LegacyTty legacy(fd);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < POLLS; i++)
+    {
+        for (const char *request : REQUESTS)
+        {
+            std::string frame;
+            legacy.flush();
+            ASSERT_TRUE(legacy.write(request));
+            ASSERT_GT(legacy.readSection(frame, ')', 2), 0);
+            EXPECT_EQ(frame.compare(0, 5, "(ACK:"), 0);
+        }
+    }
+    double legacyTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / POLLS;
+    double legacyCalls = static_cast<double>(legacy.getSyscalls()) / POLLS;
+
+    printf("Status poll: %.1f syscalls %.2f ms, byte by byte %.1f syscalls %.2f ms\n",
+           framedCalls, framed, legacyCalls, legacyTime);
+
+    EXPECT_LT(framedCalls * 3, legacyCalls);
+}
+
+TEST_F(RollOffInoLink, StaleAnswerIsDiscarded)
+{
+    SerialFramer framer(MAXINPBUF);
+    framer.setFD(fd);
+
+    // The late answer of a command that timed out
+    script.inject("(ACK:CLOSED:ON)");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    char response[MAXINPBUF];
+    size_t stale = 0;
+    ASSERT_EQ(RollOffInoProtocol::writeRequest(framer, "(GET:OPENED:0)", &stale), SerialFramer::FRAME_OK);
+    EXPECT_EQ(stale, 15u);
+    ASSERT_EQ(RollOffInoProtocol::readResponse(framer, response), SerialFramer::FRAME_OK);
+    EXPECT_STREQ(response, "(ACK:OPENED:ON)");
+
+    // Requests that would not fit the controller buffer are refused
+    EXPECT_EQ(RollOffInoProtocol::writeRequest(framer, std::string(MAXOUTBUF, 'x').c_str()), SerialFramer::FRAME_OVERFLOW);
+}
+
+TEST_F(RollOffInoLink, CutResponseStaysBuffered)
+{
+    SerialFramer framer(MAXINPBUF);
+    framer.setFD(fd);
+
+    // Both attempts time out on half a response, the rest completes it on the next read
+    char response[MAXINPBUF];
+    script.inject("(ACK:OPE");
+    EXPECT_EQ(RollOffInoProtocol::readResponse(framer, response, 100), SerialFramer::FRAME_TIMEOUT);
+    EXPECT_STREQ(response, "");
+
+    script.inject("NED:ON)");
+    ASSERT_EQ(RollOffInoProtocol::readResponse(framer, response, 2000), SerialFramer::FRAME_OK);
+    EXPECT_STREQ(response, "(ACK:OPENED:ON)");
+}
+
+TEST_F(RollOffInoLink, Overflow)
+{
+    SerialFramer framer(32);
+    framer.setFD(fd);
+
+    // Line noise without the end of message fills the buffer and is dropped
+    script.inject(std::string(40, 'x'));
+    char response[MAXINPBUF];
+    EXPECT_EQ(RollOffInoProtocol::readResponse(framer, response, 500), SerialFramer::FRAME_OVERFLOW);
+    EXPECT_EQ(framer.available(), 0u);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
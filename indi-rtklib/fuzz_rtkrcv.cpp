@@ -0,0 +1,54 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+
+  INDI RTKLIB Driver - Solution parser fuzz target
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include "gnss_stream.h"
+#include "rtkrcv_parser.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// The input is fed to the line framer in chunks, as the reader thread does, and every line is parsed.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    GNSSStream::LineBuffer<256> buffer(0xC);
+    rtkrcv_solution solution;
+
+    // The first byte selects the chunk size, to exercise lines split across reads
+    size_t chunk = size > 0 ? (data[0] % 64) + 1 : 1;
+    const char *input = reinterpret_cast<const char *>(data);
+
+    size_t offset = 0;
+    while (offset < size)
+    {
+        size_t length = size - offset < chunk ? size - offset : chunk;
+        offset += buffer.append(input + offset, length);
+
+        size_t lineLength;
+        char *line;
+        while ((line = buffer.next(&lineLength)) != nullptr)
+            rtkrcv_parse_solution(line, lineLength, &solution);
+    }
+
+    return 0;
+}
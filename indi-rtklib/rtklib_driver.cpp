@@ -41,6 +41,8 @@
 
 #define MAX_RTKRCV_PARSES     50              // Read 50 streams before giving up
 #define MAX_TIMEOUT_COUNT   5               // Maximum timeout before auto-connect
+#define READ_TIMEOUT_MS     3000            // Wait for data before counting a timeout
+#define RTKRCV_BUFFER_SIZE  1024            // Stream buffer, holds several solutions
 
 // We declare an auto pointer to GPSD.
 static std::unique_ptr<RTKLIB> rtkrcv(new RTKLIB());
@@ -103,18 +105,47 @@ bool RTKLIB::updateProperties()
 
 IPState RTKLIB::updateGPS()
 {
-    IPState rc = IPS_BUSY;
+    rtkrcv_solution solution;
+    if (!solutionSlot.consume(solution))
+        return IPS_BUSY;
 
-    pthread_mutex_lock(&lock);
-    if (locationPending == false && timePending == false)
+    if (strcmp(solution.status, lastStatus))
     {
-        rc = IPS_OK;
-        locationPending = true;
-        timePending = true;
+        strncpy(lastStatus, solution.status, sizeof(lastStatus) - 1);
+        GPSstatusTP.s = solution.fix == status_fix ? IPS_OK : IPS_BUSY;
+        IUSaveText(&GPSstatusT[0], solution.fix == status_no_fix ? "NO FIX" : solution.status);
+        IDSetText(&GPSstatusTP, nullptr);
     }
-    pthread_mutex_unlock(&lock);
 
-    return rc;
+    if (solution.fix != status_fix || solution.type != RTKRCV_TYPE_LLH)
+        return IPS_BUSY;
+
+    LocationNP[LOCATION_LATITUDE].value  = solution.position[0];
+    LocationNP[LOCATION_LONGITUDE].value = solution.position[1];
+    LocationNP[LOCATION_ELEVATION].value = solution.position[2];
+    if (LocationNP[LOCATION_LONGITUDE].value < 0)
+        LocationNP[LOCATION_LONGITUDE].value += 360;
+
+    // rtkrcv may be configured not to print the time of the solution
+    time_t raw_time = solution.timestamp > 0 ? static_cast<time_t>(solution.timestamp) : time(nullptr);
+
+    char ts[32] = {0};
+    struct tm utc, local;
+
+    m_GPSTime = raw_time;
+    gmtime_r(&raw_time, &utc);
+    strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%S", &utc);
+    TimeTP[0].setText(ts);
+
+    setSystemTime(raw_time);
+
+    localtime_r(&raw_time, &local);
+    snprintf(ts, sizeof(ts), "%4.2f", (local.tm_gmtoff / 3600.0));
+    TimeTP[1].setText(ts);
+
+    LOG_DEBUG("Location and Time updates complete.");
+
+    return IPS_OK;
 }
 
 bool RTKLIB::is_rtkrcv()
@@ -141,124 +172,61 @@ void* RTKLIB::parse_rtkrcv_helper(void *obj)
 
 void RTKLIB::parse_rtkrcv()
 {
-    static char ts[32] = {0};
-
-    char line[RTKRCV_MAX_LENGTH];
+    // Solutions are framed and parsed in place, nothing is allocated per line
+    GNSSStream::LineBuffer<RTKRCV_BUFFER_SIZE> buffer(0xC);
+    rtkrcv_solution solution;
 
     while (isConnected())
     {
-        int bytes_read = 0;
-        int tty_rc = tty_nread_section(PortFD, line, RTKRCV_MAX_LENGTH, 0xC, 3, &bytes_read);
-        if (tty_rc < 0)
+        ssize_t rc = buffer.fill(PortFD, READ_TIMEOUT_MS);
+        if (rc == GNSSStream::READ_CLOSED)
+        {
+            LOG_WARN("Connection closed. Possible remote GPS disconnection. Disconnecting driver...");
+            INDI::GPS::setConnected(false);
+            updateProperties();
+            break;
+        }
+        else if (rc == GNSSStream::READ_TIMEOUT || rc == GNSSStream::READ_ERROR)
         {
-            if (tty_rc == TTY_OVERFLOW)
+            if (rc == GNSSStream::READ_ERROR && errno == ECONNREFUSED)
             {
-                LOG_WARN("Overflow detected. Possible remote GPS disconnection. Disconnecting driver...");
-                INDI::GPS::setConnected(false);
-                updateProperties();
-                break;
+                // sleep for 10 seconds
+                tcpConnection->Disconnect();
+                usleep(10 * 1e6);
+                tcpConnection->Connect();
+                PortFD = tcpConnection->getPortFD();
+                buffer.clear();
             }
-            else
+            else if (timeoutCounter++ > MAX_TIMEOUT_COUNT)
             {
-                char errmsg[MAXRBUF];
-                tty_error_msg(tty_rc, errmsg, MAXRBUF);
-                if (tty_rc == TTY_TIME_OUT || errno == ECONNREFUSED)
-                {
-                    if (errno == ECONNREFUSED)
-                    {
-                        // sleep for 10 seconds
-                        tcpConnection->Disconnect();
-                        usleep(10 * 1e6);
-                        tcpConnection->Connect();
-                        PortFD = tcpConnection->getPortFD();
-                    }
-                    else if (timeoutCounter++ > MAX_TIMEOUT_COUNT)
-                    {
-                        LOG_WARN("Timeout limit reached, reconnecting...");
-
-                        tcpConnection->Disconnect();
-                        // sleep for 5 seconds
-                        usleep(5 * 1e6);
-                        tcpConnection->Connect();
-                        PortFD = tcpConnection->getPortFD();
-                        timeoutCounter = 0;
-                    }
-                }
-                continue;
+                LOG_WARN("Timeout limit reached, reconnecting...");
+
+                tcpConnection->Disconnect();
+                // sleep for 5 seconds
+                usleep(5 * 1e6);
+                tcpConnection->Connect();
+                PortFD = tcpConnection->getPortFD();
+                buffer.clear();
+                timeoutCounter = 0;
             }
+            continue;
         }
-        line[bytes_read] = '\0';
-
-        LOGF_DEBUG("%s", line);
-        char flags;
-        char type;
-        double enu[3];
-        double timestamp;
-        rtkrcv_fix_status fix;
-        scansolution(line, &flags, &type, enu, &fix, &timestamp);
-        switch (fix)
+
+        timeoutCounter = 0;
+
+        size_t length = 0;
+        char *line = nullptr;
+        while ((line = buffer.next(&length)) != nullptr)
         {
-            case status_no_fix:
-                LOG_DEBUG("no fix");
-                break;
-            case status_float:
-                LOG_DEBUG("float fix");
-                break;
-            case status_sbas:
-                LOG_DEBUG("sbas fix");
-                break;
-            case status_dgps:
-                LOG_DEBUG("dgps fix");
-                break;
-            case status_single:
-                LOG_DEBUG("single fix");
-                break;
-            case status_ppp:
-                LOG_DEBUG("ppp fix");
-                break;
-            case status_unknown:
-                LOG_DEBUG("unknown fix status");
-                break;
-            case status_fix:
+            LOGF_DEBUG("%s", line);
+
+            if (!rtkrcv_parse_solution(line, length, &solution))
             {
-                LocationNP[LOCATION_LATITUDE].value  = enu[0];
-                LocationNP[LOCATION_LONGITUDE].value = enu[1];
-                LocationNP[LOCATION_ELEVATION].value = enu[2];
-                if (LocationNP[LOCATION_LONGITUDE].value < 0)
-                    LocationNP[LOCATION_LONGITUDE].value += 360;
-
-                struct timespec timesp;
-                time_t raw_time;
-                struct tm *utc, *local;
-
-                timesp.tv_sec = (time_t)timestamp;
-                timesp.tv_nsec = (time_t)(timestamp * 1000000000.0);
-
-                raw_time = timesp.tv_sec;
-                m_GPSTime = raw_time;
-                utc = gmtime(&raw_time);
-                strftime(ts, 32, "%Y-%m-%dT%H:%M:%S", utc);
-                TimeTP[0].setText(ts);
-
-                setSystemTime(raw_time);
-
-                local = localtime(&raw_time);
-                snprintf(ts, 32, "%4.2f", (local->tm_gmtoff / 3600.0));
-                TimeTP[1].setText(ts);
-
-                pthread_mutex_lock(&lock);
-                locationPending = false;
-                timePending = false;
-                LOG_DEBUG("Threaded Location and Time updates complete.");
-                pthread_mutex_unlock(&lock);
-                break;
-
-                default:
-                {
-                    LOG_DEBUG("solution is not parsed");
-                }
-                break;
+                LOG_DEBUG("solution is not parsed");
+                continue;
             }
+
+            solutionSlot.publish(solution);
         }
     }
 
@@ -24,6 +24,9 @@
 
 #pragma once
 
+#include "gnss_stream.h"
+#include "rtkrcv_parser.h"
+
 #include <indigps.h>
 
 class RTKLIB : public INDI::GPS
@@ -51,8 +54,10 @@ private:
 
     int PortFD { -1 };
     uint8_t timeoutCounter=0;
-    bool locationPending = true, timePending=true;
+    char lastStatus[RTKRCV_STATUS_LENGTH] {};
+
+    // Latest solution, published by the reader thread and consumed in updateGPS()
+    GNSSStream::LatestSlot<rtkrcv_solution> solutionSlot;
 
-    pthread_mutex_t lock;
     pthread_t rtkThread;
 };
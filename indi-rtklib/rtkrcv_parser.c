@@ -23,97 +23,307 @@
 *******************************************************************************/
 
 #include "rtkrcv_parser.h"
-#include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <stdarg.h>
-#include <time.h>
 
-#define boolstr(s) ((s) ? "true" : "false")
+/* Character classes of the solution line, one lookup per character */
+enum {
+    CLS_OTHER = 0,
+    CLS_SPACE,
+    CLS_DIGIT,
+    CLS_SIGN,
+    CLS_DOT,
+    CLS_UPPER
+};
 
-void scansolution(char* solution, char *flags, char *type, double *dms, enum rtkrcv_fix_status *fix, double *timestamp)
+#define UPPER(c) [c] = CLS_UPPER
+
+static const unsigned char char_class[256] = {
+    [' '] = CLS_SPACE, ['\t'] = CLS_SPACE, ['\r'] = CLS_SPACE, ['\n'] = CLS_SPACE,
+    ['0'] = CLS_DIGIT, ['1'] = CLS_DIGIT, ['2'] = CLS_DIGIT, ['3'] = CLS_DIGIT, ['4'] = CLS_DIGIT,
+    ['5'] = CLS_DIGIT, ['6'] = CLS_DIGIT, ['7'] = CLS_DIGIT, ['8'] = CLS_DIGIT, ['9'] = CLS_DIGIT,
+    ['+'] = CLS_SIGN, ['-'] = CLS_SIGN,
+    ['.'] = CLS_DOT,
+    UPPER('A'), UPPER('B'), UPPER('C'), UPPER('D'), UPPER('E'), UPPER('F'), UPPER('G'),
+    UPPER('H'), UPPER('I'), UPPER('J'), UPPER('K'), UPPER('L'), UPPER('M'), UPPER('N'),
+    UPPER('O'), UPPER('P'), UPPER('Q'), UPPER('R'), UPPER('S'), UPPER('T'), UPPER('U'),
+    UPPER('V'), UPPER('W'), UPPER('X'), UPPER('Y'), UPPER('Z'),
+};
+
+static const double negative_powers[] = {
+    1, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8, 1e-9, 1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15
+};
+
+struct cursor {
+    const char *p;
+    const char *end;
+};
+
+static int class_at(const struct cursor *c)
 {
-    double pos[3]={0},Qe[9]={0},dms1[3]={0},dms2[3]={0},rr[3]={0};
-    double sol_age,sol_ratio;
-    int sol_ns;
-    char solflag, soltype;
-    char ns, we, el, enu[3]={0};
-    int matched;
-    char status[6];
-    sscanf(solution,"(%6c)",status);
-
-    if(!strncmp(status, RTKRCV_FIX_NONE, strlen(RTKRCV_FIX_NONE)))
-        *fix = status_no_fix;
-    else if(!strncmp(status, RTKRCV_FIX, strlen(RTKRCV_FIX)))
-        *fix = status_fix;
-    else if(!strncmp(status, RTKRCV_FIX_FLOAT, strlen(RTKRCV_FIX_FLOAT)))
-        *fix = status_float;
-    else if(!strncmp(status, RTKRCV_FIX_SBAS, strlen(RTKRCV_FIX_SBAS)))
-        *fix = status_sbas;
-    else if(!strncmp(status, RTKRCV_FIX_DGPS, strlen(RTKRCV_FIX_DGPS)))
-        *fix = status_dgps;
-    else if(!strncmp(status, RTKRCV_FIX_SINGLE, strlen(RTKRCV_FIX_SINGLE)))
-        *fix = status_single;
-    else if(!strncmp(status, RTKRCV_FIX_PPP, strlen(RTKRCV_FIX_PPP)))
-        *fix = status_ppp;
-    else if(!strncmp(status, RTKRCV_FIX_UNKNOWN, strlen(RTKRCV_FIX_UNKNOWN)))
-        *fix = status_unknown;
-
-    solflag = 0;
-    matched = 0;
-    soltype = 0;
-    matched += sscanf(solution," %c:%lf %lf %lf",&ns,&dms1[0],&dms1[1],&dms1[2]);
-    matched += sscanf(solution," %c:%lf %lf %lf",&we,&dms2[0],&dms2[1],&dms2[2]);
-    matched += sscanf(solution," %c:%lf",&el,&pos[2]);
-    if(matched != 9) {
-        matched += sscanf(solution," %c:%lf",&ns,&rr[0]);
-        matched += sscanf(solution," %c:%lf",&we,&rr[1]);
-        matched += sscanf(solution," %c:%lf",&el,&rr[2]);
-        if(matched == 6) {
-            switch (ns) {
-            case 'N':
-            case 'S':
-                soltype=1;
-                break;
-            case 'X':
-                soltype=2;
-                break;
-            case 'E':
-                soltype=3;
-                break;
-            case 'P':
-                soltype=4;
-                break;
+    return c->p < c->end ? char_class[(unsigned char)*c->p] : CLS_OTHER;
+}
+
+static void skip_spaces(struct cursor *c)
+{
+    while (c->p < c->end && char_class[(unsigned char)*c->p] == CLS_SPACE)
+        c->p++;
+}
+
+static int expect(struct cursor *c, char ch)
+{
+    if (c->p < c->end && *c->p == ch) {
+        c->p++;
+        return 1;
+    }
+    return 0;
+}
+
+/* Unsigned integer of at most max_digits digits */
+static int parse_uint(struct cursor *c, int max_digits, int *value)
+{
+    int digits = 0;
+    *value = 0;
+    while (digits < max_digits && class_at(c) == CLS_DIGIT) {
+        *value = *value * 10 + (*c->p++ - '0');
+        digits++;
+    }
+    return digits > 0;
+}
+
+/* Fixed point decimal as printed by rtkrcv: [sign] digits [. digits], no exponent */
+static int parse_number(struct cursor *c, double *value)
+{
+    const char *start = c->p;
+    double mantissa = 0;
+    int negative = 0, digits = 0, decimals = 0;
+
+    skip_spaces(c);
+    if (class_at(c) == CLS_SIGN)
+        negative = *c->p++ == '-';
+
+    while (class_at(c) == CLS_DIGIT) {
+        mantissa = mantissa * 10 + (*c->p++ - '0');
+        digits++;
+    }
+    if (class_at(c) == CLS_DOT) {
+        c->p++;
+        while (class_at(c) == CLS_DIGIT) {
+            if (decimals < 15) {
+                mantissa = mantissa * 10 + (*c->p - '0');
+                decimals++;
+                digits++;
             }
+            c->p++;
         }
     }
-    matched = sscanf(solution," (%c:%lf %c:%lf %c:%lf)",&enu[0],&Qe[0],&enu[1],&Qe[4],&enu[2],&Qe[8]);
-    if(matched == 6) {
-        solflag |= 1;
-        switch (enu[0]) {
-        case 'N':
-            dms[0] = Qe[0];
-            dms[1] = Qe[1];
-            dms[2] = Qe[2];
-            break;
-        case 'E':
-            dms[0] = Qe[1];
-            dms[1] = Qe[0];
-            dms[2] = Qe[2];
+
+    if (digits == 0) {
+        c->p = start;
+        return 0;
+    }
+
+    *value = mantissa * negative_powers[decimals];
+    if (negative)
+        *value = -*value;
+    return 1;
+}
+
+/* Days since 1970-01-01 of a proleptic Gregorian date */
+static long days_from_civil(int y, int m, int d)
+{
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+/* YYYY/MM/DD HH:MM:SS.sss */
+static int parse_time(struct cursor *c, double *timestamp)
+{
+    int year, month, day, hour, minute;
+    double second;
+
+    if (!parse_uint(c, 4, &year) || !expect(c, '/') ||
+        !parse_uint(c, 2, &month) || !expect(c, '/') ||
+        !parse_uint(c, 2, &day))
+        return 0;
+    skip_spaces(c);
+    if (!parse_uint(c, 2, &hour) || !expect(c, ':') ||
+        !parse_uint(c, 2, &minute) || !expect(c, ':') ||
+        class_at(c) != CLS_DIGIT || !parse_number(c, &second))
+        return 0;
+
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second >= 61)
+        return 0;
+
+    *timestamp = days_from_civil(year, month, day) * 86400.0 + hour * 3600 + minute * 60 + second;
+    return 1;
+}
+
+static const struct {
+    const char *name;
+    enum rtkrcv_fix_status fix;
+} status_table[] = {
+    { RTKRCV_FIX, status_fix },
+    { RTKRCV_FIX_FLOAT, status_float },
+    { RTKRCV_FIX_SBAS, status_sbas },
+    { RTKRCV_FIX_DGPS, status_dgps },
+    { RTKRCV_FIX_SINGLE, status_single },
+    { RTKRCV_FIX_PPP, status_ppp },
+};
+
+/* (STATUS), the status is padded with spaces and made of dashes when there is no solution */
+static int parse_status(struct cursor *c, struct rtkrcv_solution *solution)
+{
+    size_t length = 0, i;
+    int dashes = 1;
+
+    if (!expect(c, '('))
+        return 0;
+    skip_spaces(c);
+    while (c->p < c->end && *c->p != ')' && char_class[(unsigned char)*c->p] != CLS_SPACE) {
+        if (length >= RTKRCV_STATUS_LENGTH - 1)
+            return 0;
+        dashes &= *c->p == '-';
+        solution->status[length++] = *c->p++;
+    }
+    solution->status[length] = '\0';
+    skip_spaces(c);
+    if (!expect(c, ')'))
+        return 0;
+
+    solution->fix = status_unknown;
+    if (length > 0 && dashes) {
+        solution->fix = status_no_fix;
+        return 1;
+    }
+    for (i = 0; i < sizeof(status_table) / sizeof(status_table[0]); i++) {
+        if (!strcmp(solution->status, status_table[i].name)) {
+            solution->fix = status_table[i].fix;
             break;
-        case 'X':
-            dms[0] = Qe[0];
-            dms[1] = Qe[1];
-            dms[2] = Qe[2];
+        }
+    }
+    return 1;
+}
+
+/* (N: 0.001 E: 0.002 U: 0.003) or (X: .. Y: .. Z: ..) */
+static int parse_stddev(struct cursor *c, struct rtkrcv_solution *solution)
+{
+    int i;
+    double stddev[3];
+
+    if (!expect(c, '('))
+        return 0;
+    for (i = 0; i < 3; i++) {
+        skip_spaces(c);
+        if (class_at(c) != CLS_UPPER)
+            return 0;
+        c->p++;
+        if (!expect(c, ':') || !parse_number(c, &stddev[i]))
+            return 0;
+    }
+    skip_spaces(c);
+    if (!expect(c, ')'))
+        return 0;
+
+    memcpy(solution->stddev, stddev, sizeof(stddev));
+    solution->flags |= RTKRCV_FLAG_STDDEV;
+    return 1;
+}
+
+int rtkrcv_parse_solution(const char *line, size_t length, struct rtkrcv_solution *solution)
+{
+    struct cursor c = { line, line + length };
+    int quality = 0, components = 0;
+
+    memset(solution, 0, sizeof(*solution));
+    solution->fix = status_unknown;
+
+    /* Skip screen control sequences and prompts up to the time or the status */
+    while (c.p < c.end && *c.p != '(') {
+        const char *start = c.p;
+        if (class_at(&c) == CLS_DIGIT && parse_time(&c, &solution->timestamp)) {
+            skip_spaces(&c);
             break;
         }
+        c.p = start + 1;
     }
-    *timestamp = 0;
-    matched = sscanf(solution," A:%lf R:%lf N:%2d",&sol_age,&sol_ratio,&sol_ns);
-    if(matched == 3) {
-        *timestamp = sol_age+(sol_ratio/1000000000.0);
-        solflag |= 2;
+
+    if (!parse_status(&c, solution))
+        return 0;
+
+    while (1) {
+        double values[3];
+        int count = 0;
+        char key;
+
+        skip_spaces(&c);
+        if (c.p >= c.end)
+            break;
+
+        if (*c.p == '(') {
+            if (!parse_stddev(&c, solution))
+                break;
+            quality = 1;
+            continue;
+        }
+
+        if (class_at(&c) != CLS_UPPER || c.p + 1 >= c.end || c.p[1] != ':')
+            break;
+        key = *c.p;
+        c.p += 2;
+
+        while (count < 3 && parse_number(&c, &values[count]))
+            count++;
+        if (count == 0)
+            break;
+
+        if (quality || key == 'A' || key == 'R') {
+            /* A: age R: ratio N: satellites, after the position */
+            quality = 1;
+            if (key == 'A')
+                solution->age = values[0];
+            else if (key == 'R')
+                solution->ratio = values[0];
+            else if (key == 'N') {
+                if (values[0] < 0 || values[0] > 255)
+                    break;
+                solution->ns = (int)values[0];
+                solution->flags |= RTKRCV_FLAG_QUALITY;
+            }
+            continue;
+        }
+
+        if (count == 3 && (key == 'N' || key == 'S' || key == 'E' || key == 'W')) {
+            /* Degrees, minutes, seconds, the hemisphere gives the sign */
+            double degrees = values[0] + values[1] / 60.0 + values[2] / 3600.0;
+            if (key == 'S' || key == 'W')
+                degrees = -degrees;
+            solution->position[(key == 'N' || key == 'S') ? 0 : 1] = degrees;
+            solution->type = RTKRCV_TYPE_LLH;
+            components++;
+        } else if (key == 'H') {
+            solution->position[2] = values[0];
+            solution->type = RTKRCV_TYPE_LLH;
+            components++;
+        } else if (key == 'X' || key == 'Y' || key == 'Z') {
+            solution->position[key - 'X'] = values[0];
+            solution->type = RTKRCV_TYPE_XYZ;
+            components++;
+        } else if (key == 'E' || key == 'N' || key == 'U') {
+            solution->position[key == 'E' ? 0 : key == 'N' ? 1 : 2] = values[0];
+            solution->type = RTKRCV_TYPE_ENU;
+            components++;
+        }
     }
-    *flags = solflag;
-    *type = soltype;
+
+    /* A position is only reported when complete */
+    if (components != 3)
+        solution->type = RTKRCV_TYPE_NONE;
+
+    return 1;
 }
+
+/* vim: set ts=4 sw=4 et: */
@@ -29,6 +29,7 @@
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -37,6 +38,7 @@ extern "C" {
 #include <math.h>
 
 #define RTKRCV_MAX_LENGTH 150
+#define RTKRCV_STATUS_LENGTH 8
 
 #define RTKRCV_FIX_NONE "------"
 #define RTKRCV_FIX "FIX"
@@ -58,7 +60,36 @@ enum rtkrcv_fix_status {
     status_unknown
 };
 
-void scansolution(char* solution, char *flags, char *type, double *dms, enum rtkrcv_fix_status *fix, double *timestamp);
+/* Position formats, as selected by the rtkrcv out-solformat option */
+#define RTKRCV_TYPE_NONE 0
+#define RTKRCV_TYPE_LLH 1   /* latitude, longitude (degrees), height (m) */
+#define RTKRCV_TYPE_XYZ 2   /* ECEF X, Y, Z (m) */
+#define RTKRCV_TYPE_ENU 3   /* east, north, up from the base (m) */
+
+#define RTKRCV_FLAG_STDDEV 1    /* standard deviations are valid */
+#define RTKRCV_FLAG_QUALITY 2   /* age, ratio and satellite count are valid */
+
+struct rtkrcv_solution {
+    enum rtkrcv_fix_status fix;
+    char status[RTKRCV_STATUS_LENGTH];  /* status as printed, trimmed */
+    char type;                          /* RTKRCV_TYPE_* */
+    char flags;                         /* RTKRCV_FLAG_* */
+    double timestamp;                   /* UNIX time of the solution, 0 if not printed */
+    double position[3];
+    double stddev[3];
+    double age;                         /* age of differential (s) */
+    double ratio;                       /* ambiguity ratio */
+    int ns;                             /* number of valid satellites */
+};
+
+/**
+ * Parse one rtkrcv solution line, e.g.
+ * "2020/05/10 12:34:56.000 (FIX   ) N: 45 30 12.3456 E:  9 10 11.1234 H:  123.456 (N: 0.001 E: 0.002 U: 0.003) A: 1.0 R: 3.2 N: 12"
+ * The line is scanned once, in place, and does not need to be NUL terminated.
+ * Terminal control sequences before the solution are skipped.
+ * Returns 1 if at least the solution status was found, 0 otherwise.
+ */
+int rtkrcv_parse_solution(const char *line, size_t length, struct rtkrcv_solution *solution);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,177 @@
+/*******************************************************************************
+  Copyright(c) 2026. All rights reserved.
+
+  INDI RTKLIB Driver - Solution parser tests and replay benchmark
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include <gtest/gtest.h>
+
+#include "gnss_stream.h"
+#include "rtkrcv_parser.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static int parse(const std::string &line, rtkrcv_solution &solution)
+{
+    return rtkrcv_parse_solution(line.data(), line.size(), &solution);
+}
+
+TEST(RTKRCVParser, LatitudeLongitudeHeight)
+{
+    rtkrcv_solution solution;
+    ASSERT_TRUE(parse("2020/05/10 12:34:56.250 (FIX   ) N: 45 30 36.0000 W:  9 15 00.0000 H:  123.456 "
+                      "(N: 0.001 E: 0.002 U: 0.003) A: 1.5 R: 3.2 N: 12", solution));
+
+    EXPECT_EQ(solution.fix, status_fix);
+    EXPECT_STREQ(solution.status, "FIX");
+    EXPECT_EQ(solution.type, RTKRCV_TYPE_LLH);
+    EXPECT_DOUBLE_EQ(solution.timestamp, 1589114096.25);
+    EXPECT_NEAR(solution.position[0], 45.51, 1e-9);
+    EXPECT_NEAR(solution.position[1], -9.25, 1e-9);
+    EXPECT_NEAR(solution.position[2], 123.456, 1e-9);
+
+    EXPECT_EQ(solution.flags, RTKRCV_FLAG_STDDEV | RTKRCV_FLAG_QUALITY);
+    EXPECT_NEAR(solution.stddev[0], 0.001, 1e-12);
+    EXPECT_NEAR(solution.stddev[2], 0.003, 1e-12);
+    EXPECT_NEAR(solution.age, 1.5, 1e-12);
+    EXPECT_NEAR(solution.ratio, 3.2, 1e-12);
+    EXPECT_EQ(solution.ns, 12);
+}
+
+TEST(RTKRCVParser, OtherFormatsAndStatus)
+{
+    rtkrcv_solution solution;
+
+    // ECEF, without time, after terminal control sequences
+    ASSERT_TRUE(parse("\x1b[H\x1b[2J(FLOAT ) X: 4198944.658 Y:  174055.601 Z: 4781231.908 "
+                      "(X: 0.010 Y: 0.020 Z: 0.030) A: 0.0 R: 1.0 N:  8", solution));
+    EXPECT_EQ(solution.fix, status_float);
+    EXPECT_EQ(solution.type, RTKRCV_TYPE_XYZ);
+    EXPECT_DOUBLE_EQ(solution.timestamp, 0);
+    EXPECT_NEAR(solution.position[1], 174055.601, 1e-6);
+    EXPECT_EQ(solution.ns, 8);
+
+    // East, north, up from the base; N is a coordinate before the quality fields
+    ASSERT_TRUE(parse("2020/05/10 12:34:56.000 (SINGLE) E: -12.345 N: 6.789 U: -0.5 (E: 1.0 N: 2.0 U: 3.0) "
+                      "A: 0.0 R: 0.0 N: 5", solution));
+    EXPECT_EQ(solution.fix, status_single);
+    EXPECT_EQ(solution.type, RTKRCV_TYPE_ENU);
+    EXPECT_NEAR(solution.position[0], -12.345, 1e-9);
+    EXPECT_NEAR(solution.position[1], 6.789, 1e-9);
+    EXPECT_NEAR(solution.position[2], -0.5, 1e-9);
+    EXPECT_EQ(solution.ns, 5);
+
+    ASSERT_TRUE(parse("2020/05/10 12:34:56.000 (------)", solution));
+    EXPECT_EQ(solution.fix, status_no_fix);
+    EXPECT_EQ(solution.type, RTKRCV_TYPE_NONE);
+
+    ASSERT_TRUE(parse("(WHAT  ) N: 45 30 36.0000", solution));
+    EXPECT_EQ(solution.fix, status_unknown);
+    EXPECT_EQ(solution.type, RTKRCV_TYPE_NONE);
+
+    // Truncated lines and noise
+    EXPECT_FALSE(parse("2020/05/10 12:34", solution));
+    EXPECT_FALSE(parse("2020/05/10 12:34:56.000 (FIX", solution));
+    EXPECT_FALSE(parse("rtkrcv> status", solution));
+    EXPECT_FALSE(parse("", solution));
+}
+
+// rtkrcv refreshing its solution, one form feed separated screen per epoch
+static std::string writeLog(int epochs)
+{
+    std::string filename = testing::TempDir() + "rtklib_replay.log";
+    FILE *fp = fopen(filename.c_str(), "w");
+
+    for (int i = 0; i < epochs; i++)
+    {
+        const char *status = (i % 10 == 0) ? "FLOAT " : "FIX   ";
+        fprintf(fp, "2020/05/10 %02d:%02d:%02d.000 (%s) N: 45 30 %07.4f E:  9 10 11.1234 H: %8.3f "
+                "(N: 0.001 E: 0.002 U: 0.003) A: 1.0 R: %5.1f N: 12\f",
+                (i / 3600) % 24, (i / 60) % 60, i % 60, status, (i % 6000) / 100.0, 100 + (i % 50) / 10.0, 3.0 + i % 7);
+    }
+
+    fclose(fp);
+    return filename;
+}
+
+TEST(RTKRCVParser, ReplayThroughput)
+{
+    const int epochs = 50000;
+    std::string filename = writeLog(epochs);
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+
+    GNSSStream::LineBuffer<1024> buffer(0xC);
+    GNSSStream::LatestSlot<rtkrcv_solution> slot;
+    rtkrcv_solution solution;
+
+    uint32_t lines = 0, fixes = 0;
+    size_t bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    ssize_t rc;
+    while ((rc = buffer.fill(fd, 0)) > 0)
+    {
+        bytes += rc;
+
+        size_t length;
+        char *line;
+        while ((line = buffer.next(&length)) != nullptr)
+        {
+            lines++;
+            if (rtkrcv_parse_solution(line, length, &solution))
+            {
+                if (solution.fix == status_fix && solution.type == RTKRCV_TYPE_LLH)
+                    fixes++;
+                slot.publish(solution);
+            }
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    close(fd);
+    remove(filename.c_str());
+
+    EXPECT_EQ(rc, GNSSStream::READ_CLOSED);
+    EXPECT_EQ(lines, static_cast<uint32_t>(epochs));
+    EXPECT_EQ(fixes, static_cast<uint32_t>(epochs - epochs / 10));
+
+    ASSERT_TRUE(slot.consume(solution));
+    int last = epochs - 1;
+    EXPECT_NEAR(solution.position[0], 45.5 + (last % 6000) / 100.0 / 3600, 1e-9);
+    EXPECT_NEAR(solution.ratio, 3.0 + last % 7, 1e-9);
+
+    std::cout << "Replayed " << lines << " solutions (" << bytes / 1024 << " KiB) in " << elapsed * 1000 << " ms, "
+              << bytes / elapsed / 1e6 << " MB/s, " << elapsed / lines * 1e9 << " ns per solution" << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
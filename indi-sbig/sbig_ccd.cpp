@@ -35,6 +35,7 @@
 #include <eventloop.h>
 
 #include <math.h>
+#include <string.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -469,6 +470,13 @@ bool SBIGCCD::initProperties()
     IUFillNumberVector(&AOWENP, AOWEN, 2, getDeviceName(), "AO_WE", "AO Tilt East/West", GUIDE_CONTROL_TAB, IP_RW, 60,
                        IPS_IDLE);
 
+    /////////////////////////////////////////////////////////////////////////////
+    /// Download progress of the primary CCD
+    /////////////////////////////////////////////////////////////////////////////
+    IUFillNumber(&DownloadN[0], "DOWNLOAD_PROGRESS", "Progress (%)", "%3.0f", 0, 100, 1, 0);
+    IUFillNumberVector(&DownloadNP, DownloadN, 1, getDeviceName(), "CCD_DOWNLOAD", "Download", MAIN_CONTROL_TAB, IP_RO, 60,
+                       IPS_IDLE);
+
     IUFillSwitch(&CenterS[0], "CENTER", "Center", ISS_OFF);
     IUFillSwitchVector(&CenterSP, CenterS, 1, getDeviceName(), "AO_CENTER", "AO Center", GUIDE_CONTROL_TAB, IP_RW,
                        ISR_1OFMANY, 60, IPS_IDLE);
@@ -534,6 +542,7 @@ bool SBIGCCD::updateProperties()
             defineProperty(&CoolerNP);
         }
         defineProperty(&IgnoreErrorsSP);
+        defineProperty(&DownloadNP);
         if (m_hasFilterWheel)
         {
             defineProperty(&FilterConnectionSP);
@@ -576,6 +585,7 @@ bool SBIGCCD::updateProperties()
             deleteProperty(CoolerNP.name);
         }
         deleteProperty(IgnoreErrorsSP.name);
+        deleteProperty(DownloadNP.name);
 
         if (m_hasAO)
         {
@@ -903,13 +913,9 @@ bool SBIGCCD::Disconnect()
         return true;
     m_useExternalTrackingCCD = false;
     m_hasGuideHead           = false;
-#ifdef ASYNC_READOUT
-    pthread_mutex_lock(&condMutex);
-    grabPredicate   = GRAB_PRIMARY_CCD;
-    terminateThread = true;
-    pthread_cond_signal(&cv);
-    pthread_mutex_unlock(&condMutex);
-#endif
+    // A download in progress is ended and discarded before the device goes away
+    worker.quit();
+    m_downloading = false;
     if (FilterConnectionS[0].s == ISS_ON)
         CFWDisconnect();
     if (CloseDevice() == CE_NO_ERROR)
@@ -1099,7 +1105,7 @@ int SBIGCCD::StartExposure(INDI::CCDChip *targetChip, double duration)
 
     for (int i = 0; i < MAX_THREAD_RETRIES; i++)
     {
-        std::unique_lock<std::mutex> guard(sbigLock);
+        std::unique_lock<SBIGDriverLock> guard(sbigLock);
         res = StartExposure(&sep);
         guard.unlock();
         if (res == CE_NO_ERROR)
@@ -1185,7 +1191,7 @@ int SBIGCCD::AbortExposure(INDI::CCDChip *targetChip)
     }
     EndExposureParams eep;
     eep.ccd = ccd;
-    std::unique_lock<std::mutex> guard(sbigLock);
+    std::unique_lock<SBIGDriverLock> guard(sbigLock);
     int res = EndExposure(&eep);
     guard.unlock();
     return res;
@@ -1194,6 +1200,16 @@ int SBIGCCD::AbortExposure(INDI::CCDChip *targetChip)
 bool SBIGCCD::AbortExposure()
 {
     int res = CE_NO_ERROR;
+
+    // The readout stops at the next line and is discarded
+    if (m_downloading)
+    {
+        worker.quit();
+        m_downloading = false;
+        DownloadNP.s  = IPS_IDLE;
+        IDSetNumber(&DownloadNP, nullptr);
+    }
+
     LOG_DEBUG("Aborting primary camera exposure...");
     for (int i = 0; i < MAX_THREAD_RETRIES; i++)
     {
@@ -1408,84 +1424,68 @@ IPState SBIGCCD::GuideWest(uint32_t ms)
     return (ActivateRelay(&rp) == CE_NO_ERROR ? IPS_BUSY : IPS_ALERT);
 }
 
-#ifdef ASYNC_READOUT
-void *SBIGCCD::grabCCDHelper(void *context)
+bool SBIGCCD::grabImage(INDI::CCDChip *targetChip, const std::atomic_bool &isAboutToQuit)
 {
-    return ((SBIGCCD *)context)->grabCCD();
-}
+    SBIGReadout &readout = (targetChip == &PrimaryCCD) ? m_primaryReadout : m_guideReadout;
+    uint16_t width       = targetChip->getSubW() / targetChip->getBinX();
+    uint16_t height      = targetChip->getSubH() / targetChip->getBinY();
+    auto start           = std::chrono::steady_clock::now();
 
-void *SBIGCCD::grabCCD()
-{
-    LOG_DEBUG("grabCCD thread started...");
-    INDI::CCDChip *targetChip = nullptr;
-    pthread_mutex_lock(&condMutex);
-    while (true)
+    LOGF_DEBUG("%s readout in progress...", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
+
+    int res = CE_NO_ERROR;
+    for (int i = 0; i < MAX_THREAD_RETRIES && !isAboutToQuit; i++)
     {
-        while (grabPredicate == GRAB_NO_CCD)
-        {
-            pthread_cond_wait(&cv, &condMutex);
-        }
-        targetChip    = (grabPredicate == GRAB_PRIMARY_CCD) ? &PrimaryCCD : &GuideCCD;
-        grabPredicate = GRAB_NO_CCD;
-        if (terminateThread)
+        res = readoutCCD(targetChip, readout, isAboutToQuit);
+        if (res == CE_NO_ERROR)
             break;
-        pthread_mutex_unlock(&condMutex);
-        if (grabImage(targetChip) == false)
-        {
-            targetChip->setExposureFailed();
-        }
-        pthread_mutex_lock(&condMutex);
+        LOGF_DEBUG("Readout error (%s), retrying...", GetErrorString(res));
+        usleep(MAX_THREAD_WAIT);
     }
-    pthread_mutex_unlock(&condMutex);
-    LOG_DEBUG("grabCCD thread finished");
-    return 0;
-}
-#endif
-
-bool SBIGCCD::grabImage(INDI::CCDChip *targetChip)
-{
-    uint16_t left   = targetChip->getSubX() / targetChip->getBinX();
-    uint16_t top    = targetChip->getSubY() / targetChip->getBinX();
-    uint16_t width  = targetChip->getSubW() / targetChip->getBinX();
-    uint16_t height = targetChip->getSubH() / targetChip->getBinY();
 
-    LOGF_DEBUG("%s readout in progress...", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
+    if (isAboutToQuit)
+        return false;
 
-    if (isSimulation())
+    if (res != CE_NO_ERROR)
     {
-        uint8_t *image = targetChip->getFrameBuffer();
-        for (int i = 0; i < height * 2; i++)
-        {
-            for (int j = 0; j < width; j++)
-            {
-                image[i * width + j] = rand() % 255;
-            }
-        }
+        LOGF_ERROR("%s readout error", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
+        return false;
     }
-    else
+
+    // The readout buffer stays with the driver, the frame buffer is only locked for the copy
     {
-        uint16_t *buffer = reinterpret_cast<uint16_t *>(targetChip->getFrameBuffer());
-        int res                = 0;
-        for (int i = 0; i < MAX_THREAD_RETRIES; i++)
+        std::unique_lock<std::mutex> guard(ccdBufferLock);
+        size_t size = static_cast<size_t>(width) * height * sizeof(uint16_t);
+        if (size > static_cast<size_t>(targetChip->getFrameBufferSize()))
         {
-            res = readoutCCD(left, top, width, height, buffer, targetChip);
-            if (res == CE_NO_ERROR)
-                break;
-            LOGF_DEBUG("Readout error, retrying...", res);
-            usleep(MAX_THREAD_WAIT);
-        }
-        if (res != CE_NO_ERROR)
-        {
-            LOGF_ERROR("%s readout error",
-                       targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
+            LOGF_ERROR("%s frame buffer is too small for a %dx%d readout",
+                       targetChip == &PrimaryCCD ? "Primary camera" : "Guide head", width, height);
             return false;
         }
+        memcpy(targetChip->getFrameBuffer(), readout.image(), size);
     }
-    LOGF_DEBUG("%s readout complete", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head");
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    LOGF_DEBUG("%s readout complete, %dx%d in %.2fs", targetChip == &PrimaryCCD ? "Primary camera" : "Guide head", width,
+               height, seconds);
     ExposureComplete(targetChip);
     return true;
 }
 
+/* Reads the primary CCD out. Runs on the worker thread. */
+void SBIGCCD::downloadImage(const std::atomic_bool &isAboutToQuit)
+{
+    bool ok = grabImage(&PrimaryCCD, isAboutToQuit);
+
+    if (isAboutToQuit)
+        return;
+
+    m_downloadFailed = !ok;
+    m_downloading    = false;
+    if (!ok)
+        PrimaryCCD.setExposureFailed();
+}
+
 bool SBIGCCD::saveConfigItems(FILE *fp)
 {
     INDI::CCD::saveConfigItems(fp);
@@ -1519,8 +1519,15 @@ void SBIGCCD::TimerHit()
             LOG_DEBUG("Primay camera exposure done, downloading image...");
             targetChip->setExposureLeft(0);
             InExposure = false;
-            if (grabImage(targetChip) == false)
-                targetChip->setExposureFailed();
+
+            DownloadN[0].value = 0;
+            DownloadNP.s       = IPS_BUSY;
+            IDSetNumber(&DownloadNP, nullptr);
+
+            // the event loop keeps serving clients, guiding and the cooler while the frame comes in
+            m_downloading    = true;
+            m_downloadFailed = false;
+            worker.start(std::bind(&SBIGCCD::downloadImage, this, std::placeholders::_1));
         }
         else
         {
@@ -1539,7 +1546,8 @@ void SBIGCCD::TimerHit()
             LOG_DEBUG("Guide head exposure done, downloading image...");
             targetChip->setExposureLeft(0);
             InGuideExposure = false;
-            if (grabImage(targetChip) == false)
+            std::atomic_bool noAbort { false };
+            if (grabImage(targetChip, noAbort) == false)
                 targetChip->setExposureFailed();
         }
         else
@@ -1549,6 +1557,20 @@ void SBIGCCD::TimerHit()
         }
     }
 
+    if (m_downloading)
+    {
+        DownloadN[0].value = m_primaryReadout.progress() * 100;
+        IDSetNumber(&DownloadNP, nullptr);
+    }
+    else if (DownloadNP.s == IPS_BUSY)
+    {
+        // The worker is done, the property is only updated from the event loop
+        if (!m_downloadFailed)
+            DownloadN[0].value = 100;
+        DownloadNP.s = m_downloadFailed ? IPS_ALERT : IPS_OK;
+        IDSetNumber(&DownloadNP, nullptr);
+    }
+
     SetTimer(getCurrentPollingPeriod());
     return;
 }
@@ -2261,26 +2283,29 @@ int SBIGCCD::GetExtendedCCDInfo()
 
 int SBIGCCD::SBIGUnivDrvCommand(PAR_COMMAND command, void *params, void *results)
 {
-    int res;
-    SetDriverHandleParams sdhp;
     if (isSimulation())
     {
         return CE_NO_ERROR;
     }
+    // The readout worker and the event loop both talk to the driver
+    std::lock_guard<SBIGDriverLock> guard(sbigLock);
+    return m_univDriver.command(command, params, results);
+}
+
+short SBIGUniversalDriver::command(short command, void *params, void *results)
+{
     // Make sure we have a valid handle to the driver.
-    if (GetDriverHandle() == INVALID_HANDLE_VALUE)
+    if (handle == INVALID_HANDLE_VALUE)
     {
-        res = CE_DRIVER_NOT_OPEN;
+        return CE_DRIVER_NOT_OPEN;
     }
-    else
+    // Handle is valid so install it in the driver.
+    SetDriverHandleParams sdhp;
+    sdhp.handle = handle;
+    short res   = ::SBIGUnivDrvCommand(CC_SET_DRIVER_HANDLE, &sdhp, nullptr);
+    if (res == CE_NO_ERROR)
     {
-        // Handle is valid so install it in the driver.
-        sdhp.handle = GetDriverHandle();
-        res         = ::SBIGUnivDrvCommand(CC_SET_DRIVER_HANDLE, &sdhp, nullptr);
-        if (res == CE_NO_ERROR)
-        {
-            res = ::SBIGUnivDrvCommand(command, params, results);
-        }
+        res = ::SBIGUnivDrvCommand(command, params, results);
     }
     return res;
 }
@@ -2518,7 +2543,14 @@ void SBIGCCD::updateTemperature()
     bool enabled;
     double ccdTemp, setpointTemp, percentTE, power;
 
-    std::unique_lock<std::mutex> guard(sbigLock);
+    // Skip this reading while the worker reads the CCD out, the camera is busy
+    if (m_downloading)
+    {
+        IEAddTimer(TEMPERATURE_POLL_MS, SBIGCCD::updateTemperatureHelper, this);
+        return;
+    }
+
+    std::unique_lock<SBIGDriverLock> guard(sbigLock);
     int res = QueryTemperatureStatus(enabled, ccdTemp, setpointTemp, percentTE);
     guard.unlock();
 
@@ -2606,9 +2638,11 @@ bool SBIGCCD::isExposureDone(INDI::CCDChip *targetChip)
     QueryCommandStatusParams qcsp;
     QueryCommandStatusResults qcsr;
 
-    // Query command status:
+    // Query command status, unless a readout holds the camera, in which case it is asked again on the next timer
     qcsp.command = CC_START_EXPOSURE2;
-    std::unique_lock<std::mutex> guard(sbigLock);
+    std::unique_lock<SBIGDriverLock> guard(sbigLock, std::try_to_lock);
+    if (!guard.owns_lock())
+        return false;
     int res = QueryCommandStatus(&qcsp, &qcsr);
     if (res != CE_NO_ERROR)
     {
@@ -2639,57 +2673,37 @@ bool SBIGCCD::isExposureDone(INDI::CCDChip *targetChip)
 
 //==========================================================================
 
-int SBIGCCD::readoutCCD(uint16_t left, uint16_t top, uint16_t width, uint16_t height,
-                        uint16_t *buffer, INDI::CCDChip *targetChip)
+int SBIGCCD::readoutCCD(INDI::CCDChip *targetChip, SBIGReadout &readout, const std::atomic_bool &isAboutToQuit)
 {
-    int h, ccd, binning, res;
-    if (targetChip == &PrimaryCCD)
-    {
-        ccd = CCD_IMAGING;
-    }
-    else
-    {
-        ccd = m_useExternalTrackingCCD ? CCD_EXT_TRACKING : CCD_TRACKING;
-    }
+    int binning, res;
     if ((res = getBinningMode(targetChip, binning)) != CE_NO_ERROR)
     {
         return res;
     }
+
     StartReadoutParams srp;
-    srp.ccd         = ccd;
-    srp.readoutMode = binning;
-    srp.left        = left;
-    srp.top         = top;
-    srp.width       = width;
-    srp.height      = height;
-    std::unique_lock<std::mutex> guard(sbigLock);
-    res = StartReadout(&srp);
-    if (res != CE_NO_ERROR)
+    if (targetChip == &PrimaryCCD)
     {
-        LOGF_ERROR("%s readoutCCD - StartReadout error! (%s)",
-                   (targetChip == &PrimaryCCD) ? "Primary" : "Guide", GetErrorString(res));
-        guard.unlock();
-        return res;
+        srp.ccd = CCD_IMAGING;
     }
-    ReadoutLineParams rlp;
-    rlp.ccd         = ccd;
-    rlp.readoutMode = binning;
-    rlp.pixelStart  = left;
-    rlp.pixelLength = width;
-    for (h = 0; h < height; h++)
+    else
     {
-        ReadoutLine(&rlp, buffer + (h * width), false);
+        srp.ccd = m_useExternalTrackingCCD ? CCD_EXT_TRACKING : CCD_TRACKING;
     }
-    EndReadoutParams erp;
-    erp.ccd = ccd;
-    if ((res = EndReadout(&erp)) != CE_NO_ERROR)
+    srp.readoutMode = binning;
+    srp.left        = targetChip->getSubX() / targetChip->getBinX();
+    srp.top         = targetChip->getSubY() / targetChip->getBinX();
+    srp.width       = targetChip->getSubW() / targetChip->getBinX();
+    srp.height      = targetChip->getSubH() / targetChip->getBinY();
+
+    SBIGDriver *driver = isSimulation() ? static_cast<SBIGDriver *>(&m_simDriver) : &m_univDriver;
+
+    res = readout.read(*driver, sbigLock, srp, isAboutToQuit);
+    if (res != CE_NO_ERROR)
     {
-        LOGF_ERROR("%s readoutCCD - EndReadout error! (%s)",
-                   (targetChip == &PrimaryCCD) ? "Primary" : "Guide", GetErrorString(res));
-        guard.unlock();
-        return res;
+        LOGF_ERROR("%s readoutCCD error! (%s)", (targetChip == &PrimaryCCD) ? "Primary" : "Guide",
+                   GetErrorString(res));
     }
-    guard.unlock();
     return res;
 }
 
@@ -26,9 +26,11 @@
 #pragma once
 
 #include "config.h"
+#include "sbig_readout.h"
 
 #include <indiccd.h>
 #include <indifilterinterface.h>
+#include <indisinglethreadpool.h>
 
 #ifdef __APPLE__
 #include <libusb.h>
@@ -133,9 +135,6 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         virtual bool ISNewText(const char *dev, const char *name, char *texts[], char *names[], int n) override;
         void updateTemperature();
         static void updateTemperatureHelper(void *);
-#ifdef ASYNC_READOUT
-        static void *grabCCDHelper(void *context);
-#endif
         bool isExposureDone(INDI::CCDChip *targetChip);
 
         static void NSGuideHelper(void *context);
@@ -276,7 +275,22 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         /////////////////////////////////////////////////////////////////////////////
         /// Threading Variables
         /////////////////////////////////////////////////////////////////////////////
-        std::mutex sbigLock;
+        SBIGDriverLock sbigLock;
+
+        /////////////////////////////////////////////////////////////////////////////
+        /// Readout Variables
+        /////////////////////////////////////////////////////////////////////////////
+        // Primary CCD readouts run on the worker, the guide head ones are short and stay on the event loop
+        INDI::SingleThreadPool worker;
+        SBIGUniversalDriver m_univDriver;
+        SBIGSimulatedDriver m_simDriver;
+        SBIGReadout m_primaryReadout;
+        SBIGReadout m_guideReadout;
+        std::atomic_bool m_downloading { false };
+        std::atomic_bool m_downloadFailed { false };
+
+        INumber DownloadN[1];
+        INumberVectorProperty DownloadNP;
 
         /////////////////////////////////////////////////////////////////////////////
         /// Exposure Variables
@@ -320,6 +334,7 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         inline void SetDriverHandle(int val = INVALID_HANDLE_VALUE)
         {
             m_drv_handle = val;
+            m_univDriver.setHandle(val);
         }
         inline bool GetLinkStatus()
         {
@@ -407,8 +422,7 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         int getBinningMode(INDI::CCDChip *targetChip, int &binning);
         int getFrameType(INDI::CCDChip *targetChip, INDI::CCDChip::CCD_FRAME *frameType);
         int getShutterMode(INDI::CCDChip *targetChip, int &shutter);
-        int readoutCCD(unsigned short left, unsigned short top, unsigned short width, unsigned short height,
-                       unsigned short *buffer, INDI::CCDChip *targetChip);
+        int readoutCCD(INDI::CCDChip *targetChip, SBIGReadout &readout, const std::atomic_bool &isAboutToQuit);
 
         /////////////////////////////////////////////////////////////////////////////
         /// Filter Wheel Functions
@@ -433,7 +447,8 @@ class SBIGCCD : public INDI::CCD, public INDI::FilterInterface
         /////////////////////////////////////////////////////////////////////////////
         /// Utility Functions
         /////////////////////////////////////////////////////////////////////////////
-        bool grabImage(INDI::CCDChip *targetChip);
+        bool grabImage(INDI::CCDChip *targetChip, const std::atomic_bool &isAboutToQuit);
+        void downloadImage(const std::atomic_bool &isAboutToQuit);
         bool setupParams();
         // SBIG's software interface to the Universal Driver Library function:
         int SBIGUnivDrvCommand(PAR_COMMAND, void *, void *);
@@ -0,0 +1,116 @@
+/*
+    SBIG CCD readout, off the INDI event loop
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this library; if not, write to the Free Software Foundation,
+    Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include "sbig_readout.h"
+
+#include <thread>
+
+void SBIGSimulatedDriver::wait()
+{
+    callCount++;
+    if (callLatency.count() > 0)
+        std::this_thread::sleep_for(callLatency);
+}
+
+short SBIGSimulatedDriver::command(short command, void *params, void *results)
+{
+    wait();
+
+    switch (command)
+    {
+        case CC_START_READOUT:
+            readout    = *static_cast<StartReadoutParams *>(params);
+            readingOut = true;
+            nextLine   = 0;
+            return CE_NO_ERROR;
+
+        case CC_READOUT_LINE:
+        {
+            ReadoutLineParams *rlp = static_cast<ReadoutLineParams *>(params);
+            uint16_t *line         = static_cast<uint16_t *>(results);
+
+            if (!readingOut || nextLine >= readout.height)
+                return CE_NO_EXPOSURE_IN_PROGRESS;
+            if (static_cast<int>(nextLine) == failingLine)
+                return CE_AD_TIMEOUT;
+
+            for (uint16_t x = 0; x < rlp->pixelLength; x++)
+                line[x] = pixel(readout.top + nextLine, rlp->pixelStart + x);
+            nextLine++;
+            return CE_NO_ERROR;
+        }
+
+        case CC_END_READOUT:
+            readingOut = false;
+            return CE_NO_ERROR;
+
+        default:
+            return CE_NO_ERROR;
+    }
+}
+
+short SBIGReadout::read(SBIGDriver &driver, SBIGDriverLock &driverLock, const StartReadoutParams &params,
+                        const std::atomic_bool &isAboutToQuit)
+{
+    size_t size = static_cast<size_t>(params.width) * params.height;
+
+    // The buffer only grows, a smaller frame or a binned one reuses it as is
+    if (buffer.size() < size)
+        buffer.resize(size);
+
+    linesDone  = 0;
+    linesTotal = params.height;
+
+    StartReadoutParams srp = params;
+    ReadoutLineParams rlp;
+    rlp.ccd         = params.ccd;
+    rlp.readoutMode = params.readoutMode;
+    rlp.pixelStart  = params.left;
+    rlp.pixelLength = params.width;
+
+    EndReadoutParams erp;
+    erp.ccd = params.ccd;
+
+    short res;
+    {
+        std::lock_guard<SBIGDriverLock> guard(driverLock);
+        res = driver.command(CC_START_READOUT, &srp, nullptr);
+    }
+    if (res != CE_NO_ERROR)
+        return res;
+
+    for (uint16_t line = 0; line < params.height && !isAboutToQuit; line++)
+    {
+        // Commands of other threads go first, then one line under the lock
+        driverLock.yield();
+        {
+            std::lock_guard<SBIGDriverLock> guard(driverLock);
+            res = driver.command(CC_READOUT_LINE, &rlp, buffer.data() + static_cast<size_t>(line) * params.width);
+        }
+        if (res != CE_NO_ERROR)
+            break;
+
+        linesDone = line + 1;
+    }
+
+    // The readout is ended even on error or abort, so that the camera is ready for the next exposure
+    std::lock_guard<SBIGDriverLock> guard(driverLock);
+    short endRes = driver.command(CC_END_READOUT, &erp, nullptr);
+    return res != CE_NO_ERROR ? res : endRes;
+}
@@ -0,0 +1,170 @@
+/*
+    SBIG CCD readout, off the INDI event loop
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this library; if not, write to the Free Software Foundation,
+    Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#pragma once
+
+#ifdef __APPLE__
+#include <libsbig/sbigudrv.h>
+#else
+#include <sbigudrv.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Serializes the calls to the universal driver, which is not thread safe. It is recursive, as compound operations
+    hold it around several commands. A readout releases it after every line and steps aside while another thread
+    waits for it, so that guide pulses, filter wheel or cooler commands are not held up for the whole readout.
+ */
+class SBIGDriverLock
+{
+    public:
+        void lock()
+        {
+            waiting++;
+            mutex.lock();
+            waiting--;
+        }
+        bool try_lock()
+        {
+            return mutex.try_lock();
+        }
+        void unlock()
+        {
+            mutex.unlock();
+        }
+
+        // Called without the lock, returns once no other thread is waiting for it
+        void yield()
+        {
+            while (waiting > 0)
+                std::this_thread::yield();
+        }
+
+    private:
+        std::recursive_mutex mutex;
+        std::atomic<int> waiting { 0 };
+};
+
+/*
+    The SBIG universal driver as seen by the readout, so that a simulated camera can stand in for it.
+ */
+class SBIGDriver
+{
+    public:
+        virtual ~SBIGDriver() = default;
+
+        virtual short command(short command, void *params, void *results) = 0;
+};
+
+/*
+    SBIGUnivDrvCommand() of libsbig for one driver handle. The handle is installed before every command, as other
+    cameras may be open. The universal driver only reads one line per CC_READOUT_LINE call.
+ */
+class SBIGUniversalDriver : public SBIGDriver
+{
+    public:
+        short command(short command, void *params, void *results) override;
+
+        void setHandle(int value)
+        {
+            handle = value;
+        }
+
+    private:
+        std::atomic<int> handle { -1 };
+};
+
+/*
+    Answers the readout commands like a camera would, after a configurable latency per call. Each pixel holds its
+    row in the high byte and its column in the low byte, both of the full frame, so that the row order can be checked.
+    Other commands succeed and do nothing.
+ */
+class SBIGSimulatedDriver : public SBIGDriver
+{
+    public:
+        short command(short command, void *params, void *results) override;
+
+        // Time taken by each driver call
+        void setLatency(std::chrono::microseconds latency)
+        {
+            callLatency = latency;
+        }
+        // Fail the given line of the next readouts, -1 for none
+        void setFailingLine(int line)
+        {
+            failingLine = line;
+        }
+
+        unsigned int calls() const
+        {
+            return callCount;
+        }
+
+        static uint16_t pixel(unsigned int row, unsigned int column)
+        {
+            return static_cast<uint16_t>(((row & 0xff) << 8) | (column & 0xff));
+        }
+
+    private:
+        void wait();
+
+        std::chrono::microseconds callLatency { 0 };
+        int failingLine { -1 };
+        unsigned int callCount { 0 };
+
+        bool readingOut { false };
+        StartReadoutParams readout {};
+        unsigned int nextLine { 0 };
+};
+
+/*
+    Reads a frame between CC_START_READOUT and CC_END_READOUT, top row first, into a buffer kept from one frame to
+    the next. The driver lock is taken for each command and released between lines, where progress and abort
+    requests are also handled.
+ */
+class SBIGReadout
+{
+    public:
+        short read(SBIGDriver &driver, SBIGDriverLock &driverLock, const StartReadoutParams &params,
+                   const std::atomic_bool &isAboutToQuit);
+
+        // The frame of the last successful read, width * height pixels
+        const uint16_t *image() const
+        {
+            return buffer.data();
+        }
+
+        // Lines read so far over the lines of the frame, 0 to 1
+        double progress() const
+        {
+            uint32_t total = linesTotal;
+            return total == 0 ? 0 : static_cast<double>(linesDone) / total;
+        }
+
+    private:
+        std::vector<uint16_t> buffer;
+        std::atomic<uint32_t> linesDone { 0 };
+        std::atomic<uint32_t> linesTotal { 0 };
+};
@@ -0,0 +1,195 @@
+/*
+    SBIG CCD readout tests, against the simulated universal driver
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful, but
+    WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+    or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this library; if not, write to the Free Software Foundation,
+    Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301 USA
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include "sbig_readout.h"
+
+static StartReadoutParams frame(uint16_t left, uint16_t top, uint16_t width, uint16_t height)
+{
+    StartReadoutParams srp;
+    srp.ccd         = CCD_IMAGING;
+    srp.readoutMode = 0;
+    srp.left        = left;
+    srp.top         = top;
+    srp.width       = width;
+    srp.height      = height;
+    return srp;
+}
+
+static void expectFrame(const SBIGReadout &readout, const StartReadoutParams &srp)
+{
+    const uint16_t *image = readout.image();
+    for (uint16_t y = 0; y < srp.height; y++)
+        for (uint16_t x = 0; x < srp.width; x++)
+            ASSERT_EQ(image[y * srp.width + x], SBIGSimulatedDriver::pixel(srp.top + y, srp.left + x))
+                    << "pixel " << x << "," << y;
+}
+
+class SBIGReadoutTest : public ::testing::Test
+{
+    protected:
+        SBIGSimulatedDriver driver;
+        SBIGReadout readout;
+        SBIGDriverLock lock;
+        std::atomic_bool quit { false };
+};
+
+TEST_F(SBIGReadoutTest, RowsInOrder)
+{
+    StartReadoutParams srp = frame(10, 5, 100, 37);
+
+    ASSERT_EQ(readout.read(driver, lock, srp, quit), CE_NO_ERROR);
+    expectFrame(readout, srp);
+    EXPECT_DOUBLE_EQ(readout.progress(), 1.0);
+
+    // start, one call per line, end
+    EXPECT_EQ(driver.calls(), 2u + 37u);
+}
+
+TEST_F(SBIGReadoutTest, BufferIsReused)
+{
+    ASSERT_EQ(readout.read(driver, lock, frame(0, 0, 64, 48), quit), CE_NO_ERROR);
+    const uint16_t *first = readout.image();
+
+    StartReadoutParams smaller = frame(8, 8, 32, 16);
+    ASSERT_EQ(readout.read(driver, lock, smaller, quit), CE_NO_ERROR);
+    EXPECT_EQ(readout.image(), first);
+    expectFrame(readout, smaller);
+}
+
+TEST_F(SBIGReadoutTest, FailingLineEndsReadout)
+{
+    driver.setFailingLine(20);
+
+    EXPECT_EQ(readout.read(driver, lock, frame(0, 0, 16, 40), quit), CE_AD_TIMEOUT);
+    EXPECT_LT(readout.progress(), 1.0);
+
+    // the readout was ended, there is no line left to read
+    ReadoutLineParams rlp { CCD_IMAGING, 0, 0, 16 };
+    uint16_t line[16];
+    EXPECT_EQ(driver.command(CC_READOUT_LINE, &rlp, line), CE_NO_EXPOSURE_IN_PROGRESS);
+}
+
+TEST_F(SBIGReadoutTest, AbortStopsBetweenLines)
+{
+    driver.setLatency(std::chrono::microseconds(200));
+
+    std::thread worker([&]()
+    {
+        readout.read(driver, lock, frame(0, 0, 16, 2000), quit);
+    });
+
+    while (readout.progress() == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    quit = true;
+    worker.join();
+
+    EXPECT_LT(readout.progress(), 1.0);
+}
+
+TEST_F(SBIGReadoutTest, CommandsRunDuringReadout)
+{
+    driver.setLatency(std::chrono::microseconds(200));
+
+    std::thread worker([&]()
+    {
+        readout.read(driver, lock, frame(0, 0, 16, 4000), quit);
+    });
+
+    while (readout.progress() == 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // Guide pulses and cooler queries of the event loop, each between two lines of the 0.8 s readout
+    for (int i = 0; i < 20; i++)
+    {
+        std::lock_guard<SBIGDriverLock> guard(lock);
+        driver.command(CC_QUERY_TEMPERATURE_STATUS, nullptr, nullptr);
+    }
+    double progress = readout.progress();
+    worker.join();
+
+    EXPECT_LT(progress, 1.0);
+    EXPECT_DOUBLE_EQ(readout.progress(), 1.0);
+    EXPECT_EQ(driver.calls(), 2u + 4000u + 20u);
+}
+
+TEST_F(SBIGReadoutTest, ProgressFromAnotherThread)
+{
+    driver.setLatency(std::chrono::microseconds(100));
+    std::atomic_bool done { false };
+    double last = 0;
+    bool ordered = true;
+
+    std::thread worker([&]()
+    {
+        readout.read(driver, lock, frame(0, 0, 32, 400), quit);
+        done = true;
+    });
+
+    while (!done)
+    {
+        double progress = readout.progress();
+        ordered = ordered && progress >= last && progress <= 1.0;
+        last = progress;
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    worker.join();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_DOUBLE_EQ(readout.progress(), 1.0);
+}
+
+TEST(SBIGReadoutBenchmark, FullFrame)
+{
+    // STF-8300 sized frame, 150 us of driver overhead per call, and a cooler query every 100 ms from another thread
+    StartReadoutParams srp = frame(0, 0, 3326, 2504);
+
+    SBIGSimulatedDriver driver;
+    SBIGReadout readout;
+    SBIGDriverLock lock;
+    std::atomic_bool quit { false };
+    std::atomic_bool done { false };
+
+    driver.setLatency(std::chrono::microseconds(150));
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread worker([&]()
+    {
+        readout.read(driver, lock, srp, quit);
+        done = true;
+    });
+
+    std::chrono::duration<double> longest { 0 };
+    while (!done)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        auto asked = std::chrono::steady_clock::now();
+        std::lock_guard<SBIGDriverLock> guard(lock);
+        longest = std::max<std::chrono::duration<double>>(longest, std::chrono::steady_clock::now() - asked);
+        driver.command(CC_QUERY_TEMPERATURE_STATUS, nullptr, nullptr);
+    }
+    worker.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("3326x2504 readout: %.2fs, longest wait of a concurrent command %.2fms\n", seconds, longest.count() * 1000);
+}
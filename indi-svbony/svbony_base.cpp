@@ -83,9 +83,8 @@ bool SVBONYBase::SetROIFormat(int x, int y, int w, int h, int bin)
 // Discard unretrieved exposure data
 void SVBONYBase::discardVideoData()
 {
-    unsigned char* imageBuffer = PrimaryCCD.getFrameBuffer();
-    SVB_ERROR_CODE status = SVBGetVideoData(mCameraInfo.CameraID, imageBuffer, PrimaryCCD.getFrameBufferSize(),  1000);
-    LOGF_DEBUG("Discard unretrieved exposure data: SVBGetVideoData:result=%d", status);
+    mCapture->discard();
+    LOG_DEBUG("Discard unretrieved exposure data");
 }
 #endif
 
@@ -111,16 +110,21 @@ void SVBONYBase::workerStreamVideo(const std::atomic_bool &isAboutToQuit)
     }
     LOG_INFO("Camera normal mode");
 
+    prepareCapture();
+    mCapture->resetStatistics();
+
     ret = SVBStartVideoCapture(mCameraInfo.CameraID);
     if (ret == SVB_SUCCESS)
     {
+        INDI::ElapsedTimer statisticsTimer;
+        int waitMS = static_cast<int>((ExposureRequest * 2000.0) + 500);
+
         while (!isAboutToQuit)
         {
             uint8_t *targetFrame = PrimaryCCD.getFrameBuffer();
-            uint32_t totalBytes  = PrimaryCCD.getFrameBufferSize();
-            int waitMS           = static_cast<int>((ExposureRequest * 2000.0) + 500);
 
-            ret = SVBGetVideoData(mCameraInfo.CameraID, targetFrame, totalBytes, waitMS);
+            // RGB frames come swapped to RGB(A) for the streamer
+            ret = mCapture->readVideoFrame(targetFrame, waitMS);
             if (ret != SVB_SUCCESS)
             {
                 if (ret != SVB_ERROR_TIMEOUT)
@@ -130,22 +134,16 @@ void SVBONYBase::workerStreamVideo(const std::atomic_bool &isAboutToQuit)
                     break;
                 }
 
-                usleep(100);
                 continue;
             }
 
-            /*
-                RGB channel data align in targetFrame: 24bit:BGR, 32bit:BGRA
-                RGB channel data align in file: 24bit:RGB, 32bit:RGBA
-            */
-            if (Helpers::isRGB(mCurrentVideoFormat))
+            Streamer->newFrame(targetFrame, mCapture->frameBytes());
+
+            if (statisticsTimer.elapsed() >= 1000)
             {
-                int nChannels = Helpers::getNChannels(mCurrentVideoFormat);
-                for (uint32_t i = 0; i < totalBytes; i += nChannels)
-                    std::swap(targetFrame[i], targetFrame[i + 2]); // swap R and B channel.
+                updateCaptureStatistics();
+                statisticsTimer.start();
             }
-
-            Streamer->newFrame(targetFrame, totalBytes);
         }
 
         SVBStopVideoCapture(mCameraInfo.CameraID);
@@ -187,6 +185,8 @@ void SVBONYBase::workerExposure(const std::atomic_bool &isAboutToQuit, float dur
         return;
     }
 
+    prepareCapture();
+
 #ifdef WORKAROUND_latest_image_can_be_getten_next_time
     // Discard unretrieved exposure data
     discardVideoData();
@@ -195,171 +195,67 @@ void SVBONYBase::workerExposure(const std::atomic_bool &isAboutToQuit, float dur
     PrimaryCCD.setExposureDuration(duration);
 
     LOGF_DEBUG("StartExposure->setexp : %.3fs", duration);
-    ret = SVBSetControlValue(mCameraInfo.CameraID, SVB_EXPOSURE, duration * 1000 * 1000, SVB_FALSE);
-    if (ret != SVB_SUCCESS)
-    {
-        LOGF_ERROR("Failed to set exposure duration (%s).", Helpers::toString(ret));
-    }
-
-    // Try exposure for 3 times
-    int nRetry = 3; // Number of retries to start exposure
-    while (nRetry--)
-    {
-        ret = SVBSendSoftTrigger(mCameraInfo.CameraID);
-        if (ret == SVB_SUCCESS)
-            break;
-
-        LOGF_ERROR("Failed to start exposure (%s)", Helpers::toString(ret));
-        // Wait 100ms before trying again
-        usleep(100 * 1000);
-    }
-    if (!nRetry)
-    {
-        LOG_ERROR("Failed to start exposure three times.");
-        return;
-    }
-
-    INDI::ElapsedTimer exposureTimer;
-
     if (duration > VERBOSE_EXPOSURE)
         LOGF_INFO("Taking a %g seconds frame...", duration);
 
-    /*
-        Prepare a read buffer for SVB_IMG_RGB24 and SVB_IMG_RGB32
-    */
     SVB_IMG_TYPE type = getImageType();
 
+    /*
+        RGB 24/32 frames are read into the staging buffer of the capture, and converted to planes into the
+        frame buffer. Other formats are read into the frame buffer.
+    */
     std::unique_lock<std::mutex> guard(ccdBufferLock);
-    uint8_t *image = PrimaryCCD.getFrameBuffer();
-    uint8_t *buffer = image;
+    SVBONYCapture::Result result = mCapture->expose(duration, PrimaryCCD.getFrameBuffer(), isAboutToQuit,
+                                   [this](double timeLeft)
+    {
+        PrimaryCCD.setExposureLeft(timeLeft);
+    });
+    guard.unlock();
 
-    uint16_t subW = PrimaryCCD.getSubW() / PrimaryCCD.getBinX();
-    uint16_t subH = PrimaryCCD.getSubH() / PrimaryCCD.getBinY();
-    int nChannels = Helpers::getNChannels(type);
-    size_t nTotalBytes = subW * subH * nChannels * (PrimaryCCD.getBPP() / 8);
+    updateCaptureStatistics();
 
-    if (Helpers::isRGB(type))
+    switch (result)
     {
-        buffer = static_cast<uint8_t *>(malloc(nTotalBytes));
-        if (buffer == nullptr)
-        {
-            LOGF_ERROR("%s: %d malloc failed (RGB 24/32).", getDeviceName(), nTotalBytes);
-            guard.unlock();
-            return;
-        }
-    }
+        case SVBONYCapture::CAPTURE_OK:
+            LOGF_DEBUG("Retrieved exposure data, readout %.0f ms, conversion %.1f ms",
+                       mCapture->statistics().readout, mCapture->statistics().conversion);
+            sendImage(type, duration);
+
+            mExposureRetry = 0;
+            PrimaryCCD.setExposureLeft(0.0);
+            if (PrimaryCCD.getExposureDuration() > VERBOSE_EXPOSURE)
+                LOG_INFO("Exposure done, downloading image...");
+            break;
 
-    /*
-        Perform exposure and image data reading
-    */
-    nRetry = 50; // Number of retries when ret is SVB_ERROR_TIMEOUT
-    while (1)
-    {
-        if (isAboutToQuit)
-        {
-            ret = SVBGetVideoData(mCameraInfo.CameraID, buffer, nTotalBytes,  1000);
-            LOGF_DEBUG("Discard unretrieved exposure data: SVBGetVideoData(%s)", Helpers::toString(ret));
-            if (Helpers::isRGB(type))
-                free(buffer);
-            guard.unlock();
+        case SVBONYCapture::CAPTURE_ABORTED:
             PrimaryCCD.setExposureLeft(0);
-            return;
-        }
-
-        float delay = 0.1;
-        float timeLeft = std::max(duration - exposureTimer.elapsed() / 1000.0, 0.0);
-
-        /*
-         * Check the status every second until the time left is
-         * about one second, after which decrease the poll interval
-         *
-         * For expsoures with more than a second left try
-         * to keep the displayed "exposure left" value at
-         * a full second boundary, which keeps the
-         * count down neat
-         */
-        if (timeLeft > 1.1)
-        {
-            delay = std::max(timeLeft - std::trunc(timeLeft), 0.005f);
-            timeLeft = std::round(timeLeft);
-        }
-        if (timeLeft > 0)
-        {
-            PrimaryCCD.setExposureLeft(timeLeft);
-        }
-        else
-        {
-            ret = SVBGetVideoData(mCameraInfo.CameraID, buffer, nTotalBytes, 1000);
-            LOGF_DEBUG("Retrieved exposure data: SVBGetVideoData(%s)", Helpers::toString(ret));
-            switch (ret)
-            {
-                case SVB_SUCCESS:
-                    if (Helpers::isRGB(type))
-                    {
-                        uint8_t *dstR = image;
-                        uint8_t *dstG = image + subW * subH;
-                        uint8_t *dstB = image + subW * subH * 2;
-
-                        const uint8_t *src = buffer;
-
-                        /*
-                            To optimize execution speed, RGB32 and RGB24 are discriminated outside of while loop.
-                        */
-                        if (type == SVB_IMG_RGB32)
-                        {
-                            const uint8_t *end = buffer + subW * subH * 4;
-                            uint8_t *dstA = image + subW * subH * 3; // Alpha channel destination address
-                            while (src != end)
-                            {
-                                *dstB++ = *src++;
-                                *dstG++ = *src++;
-                                *dstR++ = *src++;
-                                *dstA++ = *src++;
-                            }
-                        }
-                        else
-                        {
-                            const uint8_t *end = buffer + subW * subH * 3;
-                            while (src != end)
-                            {
-                                *dstB++ = *src++;
-                                *dstG++ = *src++;
-                                *dstR++ = *src++;
-                            }
-                        }
-                        free(buffer);
-                    }
-                    guard.unlock();
-                    sendImage(type, duration);
+            break;
 
-                    mExposureRetry = 0;
-                    PrimaryCCD.setExposureLeft(0.0);
-                    if (PrimaryCCD.getExposureDuration() > VERBOSE_EXPOSURE)
-                        LOG_INFO("Exposure done, downloading image...");
+        case SVBONYCapture::CAPTURE_FAILED:
+            LOGF_ERROR("%s (%s).", mCapture->error().c_str(), Helpers::toString(mCapture->errorCode()));
+            PrimaryCCD.setExposureLeft(0);
+            PrimaryCCD.setExposureFailed();
+            break;
+    }
+}
 
-                    return;
+void SVBONYBase::prepareCapture()
+{
+    mCapture->setFormat(PrimaryCCD.getSubW() / PrimaryCCD.getBinX(), PrimaryCCD.getSubH() / PrimaryCCD.getBinY(),
+                        getImageType());
+}
 
-                case SVB_ERROR_TIMEOUT:
-                    --nRetry;
-                    LOGF_DEBUG("Remaining retry count for SVBGetVideoData:%d", nRetry);
-                    if (nRetry)
-                    {
-                        // No image data is prepared in the buffer yet. Retry next step of while loop.
-                        delay = 0.5f;
-                        break;
-                    }
-                //fall through
-                default: // Cannot continue to retrive image data when ret is any error except timeout.
-                    if (Helpers::isRGB(type))
-                        free(buffer);
-                    guard.unlock();
-                    PrimaryCCD.setExposureLeft(0);
-                    PrimaryCCD.setExposureFailed();
-                    return;
-            }
-        }
-        usleep(delay * 1000 * 1000);
-    }
+void SVBONYBase::updateCaptureStatistics()
+{
+    const SVBONYCapture::Statistics &statistics = mCapture->statistics();
+
+    CaptureStatsNP[STATS_READOUT].setValue(statistics.readout);
+    CaptureStatsNP[STATS_MEAN_READOUT].setValue(statistics.meanReadout);
+    CaptureStatsNP[STATS_CONVERSION].setValue(statistics.conversion);
+    CaptureStatsNP[STATS_FRAME_RATE].setValue(statistics.frameRate);
+    CaptureStatsNP[STATS_TIMEOUTS].setValue(statistics.timeouts);
+    CaptureStatsNP.setState(IPS_OK);
+    CaptureStatsNP.apply();
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -411,6 +307,13 @@ bool SVBONYBase::initProperties()
     ADCDepthNP[0].fill("BITS", "Bits", "%2.0f", 0, 32, 1, 16);
     ADCDepthNP.fill(getDeviceName(), "ADC_DEPTH", "ADC Depth", IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
 
+    CaptureStatsNP[STATS_READOUT].fill("READOUT", "Readout (ms)", "%.0f", 0, 1e6, 0, 0);
+    CaptureStatsNP[STATS_MEAN_READOUT].fill("MEAN_READOUT", "Mean readout (ms)", "%.0f", 0, 1e6, 0, 0);
+    CaptureStatsNP[STATS_CONVERSION].fill("CONVERSION", "RGB conversion (ms)", "%.1f", 0, 1e6, 0, 0);
+    CaptureStatsNP[STATS_FRAME_RATE].fill("FRAME_RATE", "Video frame rate", "%.1f", 0, 1e6, 0, 0);
+    CaptureStatsNP[STATS_TIMEOUTS].fill("TIMEOUTS", "Timeouts", "%.0f", 0, 1e9, 0, 0);
+    CaptureStatsNP.fill(getDeviceName(), "CCD_CAPTURE_STATISTICS", "Capture", IMAGE_INFO_TAB, IP_RO, 60, IPS_IDLE);
+
     SDKVersionSP[0].fill("VERSION", "Version", SVBGetSDKVersion());
     SDKVersionSP.fill(getDeviceName(), "SDK", "SDK", INFO_TAB, IP_RO, 60, IPS_IDLE);
 
@@ -483,6 +386,7 @@ bool SVBONYBase::updateProperties()
         }
 
         defineProperty(ADCDepthNP);
+        defineProperty(CaptureStatsNP);
         defineProperty(SDKVersionSP);
         if (!mSerialNumber.empty())
         {
@@ -512,6 +416,7 @@ bool SVBONYBase::updateProperties()
         if (!VideoFormatSP.isEmpty())
             deleteProperty(VideoFormatSP.getName());
 
+        deleteProperty(CaptureStatsNP.getName());
         deleteProperty(SDKVersionSP.getName());
         if (!mSerialNumber.empty())
         {
@@ -570,6 +475,9 @@ bool SVBONYBase::Connect()
 
     ADCDepthNP[0].setValue(mCameraProperty.MaxBitDepth);
 
+    mCameraIO.reset(new SVBONYSDKCamera(mCameraInfo.CameraID));
+    mCapture.reset(new SVBONYCapture(*mCameraIO));
+
     int maxBin = 1;
 
     for (const auto &supportedBin : mCameraProperty.SupportedBins)
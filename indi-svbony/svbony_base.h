@@ -25,11 +25,14 @@
 
 #include <SVBCameraSDK.h>
 
+#include "svbony_capture.h"
+
 #include "indipropertyswitch.h"
 #include "indipropertynumber.h"
 #include "indipropertytext.h"
 #include "indisinglethreadpool.h"
 
+#include <memory>
 #include <vector>
 
 #include <indiccd.h>
@@ -103,6 +106,15 @@ class SVBONYBase : public INDI::CCD
         /** Send CCD image to client */
         void sendImage(SVB_IMG_TYPE type, float duration);
 
+        /** SDK calls and staging buffer of exposures and video, created on connection */
+        std::unique_ptr<SVBONYSDKCamera> mCameraIO;
+        std::unique_ptr<SVBONYCapture> mCapture;
+
+        /** Size the capture to the current binned ROI and format */
+        void prepareCapture();
+        /** Publish the capture timing statistics */
+        void updateCaptureStatistics();
+
 #ifdef WORKAROUND_latest_image_can_be_getten_next_time
         // Discard unretrieved exposure data
         void discardVideoData();
@@ -160,6 +172,16 @@ class SVBONYBase : public INDI::CCD
         INDI::PropertyText    SerialNumberTP {1};
         INDI::PropertyText    NicknameTP {1};
 
+        INDI::PropertyNumber  CaptureStatsNP {5};
+        enum
+        {
+            STATS_READOUT,
+            STATS_MEAN_READOUT,
+            STATS_CONVERSION,
+            STATS_FRAME_RATE,
+            STATS_TIMEOUTS
+        };
+
         INDI::PropertySwitch  FlipSP {2};
         enum
         {
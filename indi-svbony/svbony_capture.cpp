@@ -0,0 +1,532 @@
+/*
+    SVBony Camera Driver - capture
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "svbony_capture.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SVBONY_SIMD_X86
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SVBONY_SIMD_NEON
+#endif
+
+#define TRIGGER_TRIES       3
+#define TRIGGER_RETRY_MS    100
+/* Longest single wait for the data in the SDK, abort is checked in between (ms) */
+#define READOUT_WAIT_MS     500
+/* A frame left in the SDK is already there, no need to wait long for it (ms) */
+#define DISCARD_WAIT_MS     100
+
+namespace SVBONYConvert
+{
+
+static bool gUseSimd = true;
+
+/*
+    Scalar kernels, also used for the pixels left over by the vectorised ones
+*/
+static void toPlanarScalar(const uint8_t *src, uint8_t *r, uint8_t *g, uint8_t *b, uint8_t *a, size_t from,
+                           size_t pixels)
+{
+    if (a != nullptr)
+    {
+        for (size_t i = from; i < pixels; i++)
+        {
+            b[i] = src[4 * i];
+            g[i] = src[4 * i + 1];
+            r[i] = src[4 * i + 2];
+            a[i] = src[4 * i + 3];
+        }
+    }
+    else
+    {
+        for (size_t i = from; i < pixels; i++)
+        {
+            b[i] = src[3 * i];
+            g[i] = src[3 * i + 1];
+            r[i] = src[3 * i + 2];
+        }
+    }
+}
+
+static void swapRedBlueScalar(uint8_t *data, size_t from, size_t pixels, int channels)
+{
+    for (size_t i = from * channels; i < pixels * channels; i += channels)
+        std::swap(data[i], data[i + 2]);
+}
+
+#if defined(SVBONY_SIMD_X86)
+
+/*
+    16 BGR pixels are 48 bytes in 3 registers, each output register is assembled from byte shuffles of the
+    3 of them. mask[out][in] picks the bytes of register in going to register out, 0x80 clears the others.
+*/
+struct Shuffle
+{
+    alignas(16) uint8_t mask[3][3][16];
+
+    // source(k) is the input byte of output byte k
+    template <typename Source>
+    explicit Shuffle(Source source)
+    {
+        for (int k = 0; k < 48; k++)
+        {
+            int from = source(k);
+            for (int in = 0; in < 3; in++)
+                mask[k / 16][in][k % 16] = (from / 16 == in) ? from % 16 : 0x80;
+        }
+    }
+};
+
+// Output register c holds channel c of the 16 pixels
+static const Shuffle gBGRPlanes([](int k)
+{
+    return (k % 16) * 3 + k / 16;
+});
+
+// Output is the input with the first and third byte of each pixel exchanged
+static const Shuffle gBGRSwap([](int k)
+{
+    return k - k % 3 + 2 - k % 3;
+});
+
+__attribute__((target("ssse3")))
+static inline void shuffle48(const Shuffle &shuffle, const uint8_t *src, __m128i out[3])
+{
+    __m128i in[3];
+    for (int i = 0; i < 3; i++)
+        in[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 16 * i));
+    for (int o = 0; o < 3; o++)
+    {
+        __m128i const *mask = reinterpret_cast<const __m128i *>(shuffle.mask[o]);
+        out[o] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(in[0], _mm_load_si128(mask)),
+                                           _mm_shuffle_epi8(in[1], _mm_load_si128(mask + 1))),
+                              _mm_shuffle_epi8(in[2], _mm_load_si128(mask + 2)));
+    }
+}
+
+__attribute__((target("ssse3")))
+static size_t toPlanarSimd(const uint8_t *src, uint8_t *r, uint8_t *g, uint8_t *b, uint8_t *a, size_t pixels)
+{
+    size_t i = 0;
+
+    if (a != nullptr)
+    {
+        // Gather each channel of 4 pixels in a 32 bit lane, then transpose the 4x4 lanes of 16 pixels
+        __m128i const gather = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+        for (; i + 16 <= pixels; i += 16)
+        {
+            __m128i p[4];
+            for (int j = 0; j < 4; j++)
+                p[j] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + 4 * i + 16 * j)), gather);
+            __m128i const bg01 = _mm_unpacklo_epi32(p[0], p[1]);
+            __m128i const bg23 = _mm_unpacklo_epi32(p[2], p[3]);
+            __m128i const ra01 = _mm_unpackhi_epi32(p[0], p[1]);
+            __m128i const ra23 = _mm_unpackhi_epi32(p[2], p[3]);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(b + i), _mm_unpacklo_epi64(bg01, bg23));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(g + i), _mm_unpackhi_epi64(bg01, bg23));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(r + i), _mm_unpacklo_epi64(ra01, ra23));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(a + i), _mm_unpackhi_epi64(ra01, ra23));
+        }
+    }
+    else
+    {
+        for (; i + 16 <= pixels; i += 16)
+        {
+            __m128i planes[3];
+            shuffle48(gBGRPlanes, src + 3 * i, planes);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(b + i), planes[0]);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(g + i), planes[1]);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(r + i), planes[2]);
+        }
+    }
+    return i;
+}
+
+__attribute__((target("ssse3")))
+static size_t swapRedBlueSimd(uint8_t *data, size_t pixels, int channels)
+{
+    size_t i = 0;
+
+    if (channels == 4)
+    {
+        __m128i const swap = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+        for (; i + 4 <= pixels; i += 4)
+        {
+            __m128i *p = reinterpret_cast<__m128i *>(data + 4 * i);
+            _mm_storeu_si128(p, _mm_shuffle_epi8(_mm_loadu_si128(p), swap));
+        }
+    }
+    else
+    {
+        for (; i + 16 <= pixels; i += 16)
+        {
+            __m128i swapped[3];
+            shuffle48(gBGRSwap, data + 3 * i, swapped);
+            for (int j = 0; j < 3; j++)
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(data + 3 * i + 16 * j), swapped[j]);
+        }
+    }
+    return i;
+}
+
+static bool cpuHasSimd()
+{
+    return __builtin_cpu_supports("ssse3");
+}
+
+#elif defined(SVBONY_SIMD_NEON)
+
+static size_t toPlanarSimd(const uint8_t *src, uint8_t *r, uint8_t *g, uint8_t *b, uint8_t *a, size_t pixels)
+{
+    size_t i = 0;
+
+    if (a != nullptr)
+    {
+        for (; i + 16 <= pixels; i += 16)
+        {
+            uint8x16x4_t p = vld4q_u8(src + 4 * i);
+            vst1q_u8(b + i, p.val[0]);
+            vst1q_u8(g + i, p.val[1]);
+            vst1q_u8(r + i, p.val[2]);
+            vst1q_u8(a + i, p.val[3]);
+        }
+    }
+    else
+    {
+        for (; i + 16 <= pixels; i += 16)
+        {
+            uint8x16x3_t p = vld3q_u8(src + 3 * i);
+            vst1q_u8(b + i, p.val[0]);
+            vst1q_u8(g + i, p.val[1]);
+            vst1q_u8(r + i, p.val[2]);
+        }
+    }
+    return i;
+}
+
+static size_t swapRedBlueSimd(uint8_t *data, size_t pixels, int channels)
+{
+    size_t i = 0;
+
+    if (channels == 4)
+    {
+        for (; i + 16 <= pixels; i += 16)
+        {
+            uint8x16x4_t p = vld4q_u8(data + 4 * i);
+            std::swap(p.val[0], p.val[2]);
+            vst4q_u8(data + 4 * i, p);
+        }
+    }
+    else
+    {
+        for (; i + 16 <= pixels; i += 16)
+        {
+            uint8x16x3_t p = vld3q_u8(data + 3 * i);
+            std::swap(p.val[0], p.val[2]);
+            vst3q_u8(data + 3 * i, p);
+        }
+    }
+    return i;
+}
+
+static bool cpuHasSimd()
+{
+    return true;
+}
+
+#else
+
+static size_t toPlanarSimd(const uint8_t *, uint8_t *, uint8_t *, uint8_t *, uint8_t *, size_t)
+{
+    return 0;
+}
+
+static size_t swapRedBlueSimd(uint8_t *, size_t, int)
+{
+    return 0;
+}
+
+static bool cpuHasSimd()
+{
+    return false;
+}
+
+#endif
+
+bool haveSimd()
+{
+    static const bool available = cpuHasSimd();
+    return available && gUseSimd;
+}
+
+void setSimd(bool useSimd)
+{
+    gUseSimd = useSimd;
+}
+
+void toPlanar(const uint8_t *src, uint8_t *dst, size_t pixels, int channels)
+{
+    uint8_t *r = dst;
+    uint8_t *g = dst + pixels;
+    uint8_t *b = dst + pixels * 2;
+    uint8_t *a = (channels == 4) ? dst + pixels * 3 : nullptr;
+    size_t done = haveSimd() ? toPlanarSimd(src, r, g, b, a, pixels) : 0;
+
+    toPlanarScalar(src, r, g, b, a, done, pixels);
+}
+
+void swapRedBlue(uint8_t *data, size_t pixels, int channels)
+{
+    size_t done = haveSimd() ? swapRedBlueSimd(data, pixels, channels) : 0;
+
+    swapRedBlueScalar(data, done, pixels, channels);
+}
+
+}
+
+SVB_ERROR_CODE SVBONYSDKCamera::setExposure(long microseconds)
+{
+    return SVBSetControlValue(mCameraID, SVB_EXPOSURE, microseconds, SVB_FALSE);
+}
+
+SVB_ERROR_CODE SVBONYSDKCamera::sendSoftTrigger()
+{
+    return SVBSendSoftTrigger(mCameraID);
+}
+
+SVB_ERROR_CODE SVBONYSDKCamera::getVideoData(unsigned char *buffer, long size, int waitMS)
+{
+    return SVBGetVideoData(mCameraID, buffer, size, waitMS);
+}
+
+static size_t bytesPerPixel(SVB_IMG_TYPE type)
+{
+    switch (type)
+    {
+        case SVB_IMG_RAW10:
+        case SVB_IMG_RAW12:
+        case SVB_IMG_RAW14:
+        case SVB_IMG_RAW16:
+        case SVB_IMG_Y16:
+            return 2;
+        case SVB_IMG_RGB24:
+            return 3;
+        case SVB_IMG_RGB32:
+            return 4;
+        default:
+            return 1;
+    }
+}
+
+static bool isRGB(SVB_IMG_TYPE type)
+{
+    return (type == SVB_IMG_RGB24) || (type == SVB_IMG_RGB32);
+}
+
+static double milliseconds(std::chrono::steady_clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+SVBONYCapture::SVBONYCapture(SVBONYCameraIO &camera) : mCamera(camera)
+{
+}
+
+void SVBONYCapture::setFormat(uint32_t width, uint32_t height, SVB_IMG_TYPE type)
+{
+    mWidth      = width;
+    mHeight     = height;
+    mType       = type;
+    mFrameBytes = static_cast<size_t>(width) * height * bytesPerPixel(type);
+
+    if (mStaging.size() < mFrameBytes)
+        mStaging.resize(mFrameBytes);
+}
+
+void SVBONYCapture::resetStatistics()
+{
+    mStatistics = Statistics();
+    mReadouts   = 0;
+    mRateStart  = Clock::time_point();
+    mRateFrames = 0;
+}
+
+void SVBONYCapture::discard()
+{
+    mCamera.getVideoData(mStaging.data(), mFrameBytes, DISCARD_WAIT_MS);
+}
+
+void SVBONYCapture::convert(uint8_t *image)
+{
+    Clock::time_point const start = Clock::now();
+
+    SVBONYConvert::toPlanar(mStaging.data(), image, static_cast<size_t>(mWidth) * mHeight, static_cast<int>(bytesPerPixel(mType)));
+    mStatistics.conversion = milliseconds(Clock::now() - start);
+}
+
+SVBONYCapture::Result SVBONYCapture::expose(double duration, uint8_t *image, const std::atomic_bool &abort,
+        const std::function<void(double)> &timeLeft)
+{
+    SVB_ERROR_CODE ret;
+
+    mError.clear();
+    mErrorCode = SVB_SUCCESS;
+
+    ret = mCamera.setExposure(static_cast<long>(duration * 1000 * 1000));
+    if (ret != SVB_SUCCESS)
+    {
+        mError     = "Failed to set exposure duration";
+        mErrorCode = ret;
+        return CAPTURE_FAILED;
+    }
+
+    for (int tries = 1; (ret = mCamera.sendSoftTrigger()) != SVB_SUCCESS; tries++)
+    {
+        if (tries == TRIGGER_TRIES)
+        {
+            mError     = "Failed to start exposure three times";
+            mErrorCode = ret;
+            return CAPTURE_FAILED;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRIGGER_RETRY_MS));
+    }
+
+    Clock::time_point const end = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                      std::chrono::duration<double>(duration));
+
+    /*
+        Nothing to ask the camera until the end of the exposure.
+        With more than a second left, wake up on whole seconds left so that the countdown is neat.
+    */
+    while (true)
+    {
+        if (abort)
+        {
+            discard();
+            return CAPTURE_ABORTED;
+        }
+
+        Clock::time_point const now = Clock::now();
+        double left = std::chrono::duration<double>(end - now).count();
+        if (left <= 0)
+            break;
+
+        Clock::time_point wake = end;
+        if (left > 1.1)
+        {
+            double const delay = std::max(left - std::trunc(left), 0.005);
+            wake = now + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(delay));
+            left = std::round(left);
+        }
+        if (timeLeft)
+            timeLeft(left);
+        std::this_thread::sleep_until(wake);
+    }
+
+    /*
+        The SDK returns as soon as the data is there
+    */
+    uint8_t *buffer = isRGB(mType) ? mStaging.data() : image;
+    Clock::time_point const deadline = end + std::chrono::milliseconds(mReadoutTimeout);
+    while (true)
+    {
+        if (abort)
+        {
+            discard();
+            return CAPTURE_ABORTED;
+        }
+
+        ret = mCamera.getVideoData(buffer, mFrameBytes, READOUT_WAIT_MS);
+        if (ret == SVB_SUCCESS)
+            break;
+
+        if (ret != SVB_ERROR_TIMEOUT)
+        {
+            mError     = "Failed to read exposure data";
+            mErrorCode = ret;
+            return CAPTURE_FAILED;
+        }
+
+        mStatistics.timeouts++;
+        if (Clock::now() >= deadline)
+        {
+            mError     = "Timed out waiting for exposure data";
+            mErrorCode = ret;
+            return CAPTURE_FAILED;
+        }
+    }
+
+    mStatistics.readout = milliseconds(Clock::now() - end);
+    mReadouts++;
+    mStatistics.meanReadout += (mStatistics.readout - mStatistics.meanReadout) / mReadouts;
+
+    if (isRGB(mType))
+        convert(image);
+    mStatistics.frames++;
+
+    return CAPTURE_OK;
+}
+
+SVB_ERROR_CODE SVBONYCapture::readVideoFrame(uint8_t *frame, int waitMS)
+{
+    SVB_ERROR_CODE ret = mCamera.getVideoData(frame, mFrameBytes, waitMS);
+    if (ret != SVB_SUCCESS)
+    {
+        if (ret == SVB_ERROR_TIMEOUT)
+            mStatistics.timeouts++;
+        return ret;
+    }
+
+    /*
+        RGB channel data align in frame: 24bit:BGR, 32bit:BGRA
+        RGB channel data align for the streamer: 24bit:RGB, 32bit:RGBA
+    */
+    if (isRGB(mType))
+    {
+        Clock::time_point const start = Clock::now();
+        SVBONYConvert::swapRedBlue(frame, static_cast<size_t>(mWidth) * mHeight, static_cast<int>(bytesPerPixel(mType)));
+        mStatistics.conversion = milliseconds(Clock::now() - start);
+    }
+    mStatistics.frames++;
+
+    // Frames after the first one of each second
+    Clock::time_point const now = Clock::now();
+    if (mRateStart == Clock::time_point())
+    {
+        mRateStart = now;
+        return SVB_SUCCESS;
+    }
+    mRateFrames++;
+    if (now - mRateStart >= std::chrono::seconds(1))
+    {
+        mStatistics.frameRate = mRateFrames / std::chrono::duration<double>(now - mRateStart).count();
+        mRateStart  = now;
+        mRateFrames = 0;
+    }
+
+    return SVB_SUCCESS;
+}
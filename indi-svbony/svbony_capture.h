@@ -0,0 +1,178 @@
+/*
+    SVBony Camera Driver - capture
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include <SVBCameraSDK.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+    The SDK calls a capture makes, so that captures can run against a fake camera.
+*/
+class SVBONYCameraIO
+{
+    public:
+        virtual ~SVBONYCameraIO() = default;
+
+        virtual SVB_ERROR_CODE setExposure(long microseconds) = 0;
+        virtual SVB_ERROR_CODE sendSoftTrigger() = 0;
+        virtual SVB_ERROR_CODE getVideoData(unsigned char *buffer, long size, int waitMS) = 0;
+};
+
+/*
+    SVBONYCameraIO on an opened SDK camera.
+*/
+class SVBONYSDKCamera : public SVBONYCameraIO
+{
+    public:
+        explicit SVBONYSDKCamera(int cameraID) : mCameraID(cameraID) {}
+
+        SVB_ERROR_CODE setExposure(long microseconds) override;
+        SVB_ERROR_CODE sendSoftTrigger() override;
+        SVB_ERROR_CODE getVideoData(unsigned char *buffer, long size, int waitMS) override;
+
+    private:
+        int mCameraID;
+};
+
+/*
+    Conversion of the SDK RGB formats, BGR for RGB24 and BGRA for RGB32.
+    Vectorised with SSSE3 or NEON when available, scalar otherwise.
+*/
+namespace SVBONYConvert
+{
+/** True if the vectorised kernels are used */
+bool haveSimd();
+/** Use the vectorised kernels if available, or the scalar ones, for testing */
+void setSimd(bool useSimd);
+
+/** BGR(A) pixels to the R, G, B (and A) planes of a FITS image, one after the other in dst */
+void toPlanar(const uint8_t *src, uint8_t *dst, size_t pixels, int channels);
+/** BGR(A) pixels to RGB(A) in place, for the streamer */
+void swapRedBlue(uint8_t *data, size_t pixels, int channels);
+}
+
+/*
+    Exposures and video frames of one camera, read through a staging buffer kept across frames.
+
+    An exposure sleeps until its end, giving the time left once a second on the way, then waits for the
+    data in the SDK rather than polling it. The capture mode and video capture are handled by the caller.
+*/
+class SVBONYCapture
+{
+    public:
+        struct Statistics
+        {
+            uint32_t frames {0};
+            /** SDK waits that ended without data */
+            uint32_t timeouts {0};
+            /** Last exposure, from the end of the exposure to the data, ms */
+            double readout {0};
+            double meanReadout {0};
+            /** Last frame, RGB conversion, ms */
+            double conversion {0};
+            /** Video, frames per second over about the last second */
+            double frameRate {0};
+        };
+
+        enum Result
+        {
+            CAPTURE_OK,
+            CAPTURE_ABORTED,
+            CAPTURE_FAILED
+        };
+
+        explicit SVBONYCapture(SVBONYCameraIO &camera);
+
+        /** Binned ROI size and output type. The staging buffer only grows, and is kept across frames. */
+        void setFormat(uint32_t width, uint32_t height, SVB_IMG_TYPE type);
+        /** Bytes of a frame as sent by the SDK, also the size of the FITS image */
+        size_t frameBytes() const
+        {
+            return mFrameBytes;
+        }
+        const uint8_t *staging() const
+        {
+            return mStaging.data();
+        }
+
+        /** Time the data may take to come after the end of an exposure, ms */
+        void setReadoutTimeout(int ms)
+        {
+            mReadoutTimeout = ms;
+        }
+
+        /** Reads a frame left in the SDK by an earlier capture, if any */
+        void discard();
+
+        /**
+         * Triggers an exposure of duration seconds and reads it into image, converted to planes for RGB.
+         * timeLeft is called with the seconds left while exposing, abort is checked at the same time and
+         * between waits for the data.
+         */
+        Result expose(double duration, uint8_t *image, const std::atomic_bool &abort,
+                      const std::function<void(double)> &timeLeft);
+
+        /** Reads the next video frame into frame, RGB swapped to RGB(A) */
+        SVB_ERROR_CODE readVideoFrame(uint8_t *frame, int waitMS);
+
+        const Statistics &statistics() const
+        {
+            return mStatistics;
+        }
+        void resetStatistics();
+
+        /** Why the last capture failed, and the SDK error */
+        const std::string &error() const
+        {
+            return mError;
+        }
+        SVB_ERROR_CODE errorCode() const
+        {
+            return mErrorCode;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        void convert(uint8_t *image);
+
+        SVBONYCameraIO &mCamera;
+        uint32_t mWidth {0}, mHeight {0};
+        SVB_IMG_TYPE mType {SVB_IMG_RAW8};
+        size_t mFrameBytes {0};
+        std::vector<uint8_t> mStaging;
+        int mReadoutTimeout {60000};
+
+        Statistics mStatistics;
+        uint32_t mReadouts {0};
+        Clock::time_point mRateStart;
+        uint32_t mRateFrames {0};
+
+        std::string mError;
+        SVB_ERROR_CODE mErrorCode {SVB_SUCCESS};
+};
@@ -0,0 +1,108 @@
+/*
+    SVBony Camera Driver - fake camera
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "svbony_fake_camera.h"
+
+#include <thread>
+
+static size_t bytesPerPixel(SVB_IMG_TYPE type)
+{
+    switch (type)
+    {
+        case SVB_IMG_RAW8:
+        case SVB_IMG_Y8:
+            return 1;
+        case SVB_IMG_RGB24:
+            return 3;
+        case SVB_IMG_RGB32:
+            return 4;
+        default:
+            return 2;
+    }
+}
+
+SVBONYFakeCamera::SVBONYFakeCamera(uint32_t width, uint32_t height, SVB_IMG_TYPE type)
+    : mFrameBytes(static_cast<size_t>(width) * height * bytesPerPixel(type))
+{
+}
+
+void SVBONYFakeCamera::startVideo()
+{
+    mVideo   = true;
+    mPending = true;
+    mReady   = Clock::now() + mExposure;
+}
+
+uint8_t SVBONYFakeCamera::pattern(uint32_t frame, size_t i)
+{
+    return static_cast<uint8_t>(i * 7 + i / 251 + frame * 13);
+}
+
+SVB_ERROR_CODE SVBONYFakeCamera::setExposure(long microseconds)
+{
+    mExposure = std::chrono::microseconds(microseconds);
+    return SVB_SUCCESS;
+}
+
+SVB_ERROR_CODE SVBONYFakeCamera::sendSoftTrigger()
+{
+    triggers++;
+    if (failingTriggers > 0)
+    {
+        failingTriggers--;
+        return SVB_ERROR_GENERAL_ERROR;
+    }
+
+    mPending = true;
+    mReady   = Clock::now() + mExposure +
+               std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(readout));
+    return SVB_SUCCESS;
+}
+
+SVB_ERROR_CODE SVBONYFakeCamera::getVideoData(unsigned char *buffer, long size, int waitMS)
+{
+    videoDataCalls++;
+    if (size < static_cast<long>(mFrameBytes))
+        return SVB_ERROR_BUFFER_TOO_SMALL;
+
+    Clock::time_point const timeout = Clock::now() + std::chrono::milliseconds(waitMS);
+    if (!mPending || stalled || mReady > timeout)
+    {
+        std::this_thread::sleep_until(timeout);
+        return SVB_ERROR_TIMEOUT;
+    }
+    std::this_thread::sleep_until(mReady);
+
+    for (size_t i = 0; i < mFrameBytes; i++)
+        buffer[i] = pattern(frames, i);
+    frames++;
+
+    if (mVideo)
+    {
+        // Frames not read in time are replaced by the latest one
+        mReady += mExposure;
+        if (mReady < Clock::now())
+            mReady = Clock::now();
+    }
+    else
+        mPending = false;
+
+    return SVB_SUCCESS;
+}
@@ -0,0 +1,70 @@
+/*
+    SVBony Camera Driver - fake camera
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#pragma once
+
+#include "svbony_capture.h"
+
+#include <chrono>
+
+/*
+    A camera with the timing of the SDK, without hardware.
+
+    In trigger mode, a frame is ready readout ms after the end of each triggered exposure. In video mode,
+    frames come one exposure apart, the latest one replacing any frame not read yet. Waits for a frame
+    sleep, as the SDK does. Frames are filled with pattern(), in the SDK byte order.
+*/
+class SVBONYFakeCamera : public SVBONYCameraIO
+{
+    public:
+        SVBONYFakeCamera(uint32_t width, uint32_t height, SVB_IMG_TYPE type);
+
+        /** Switch to video mode, frames start coming one exposure later */
+        void startVideo();
+
+        /** Byte i of frame */
+        static uint8_t pattern(uint32_t frame, size_t i);
+
+        /** Time from the end of an exposure to its data, ms */
+        double readout {20};
+        /** Number of triggers failing before one succeeds */
+        int failingTriggers {0};
+        /** No data ever comes */
+        bool stalled {false};
+
+        /** Calls made */
+        int triggers {0};
+        int videoDataCalls {0};
+        /** Frames delivered */
+        uint32_t frames {0};
+
+        SVB_ERROR_CODE setExposure(long microseconds) override;
+        SVB_ERROR_CODE sendSoftTrigger() override;
+        SVB_ERROR_CODE getVideoData(unsigned char *buffer, long size, int waitMS) override;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        size_t mFrameBytes;
+        bool mVideo {false};
+        Clock::duration mExposure {std::chrono::seconds(1)};
+        bool mPending {false};
+        Clock::time_point mReady;
+};
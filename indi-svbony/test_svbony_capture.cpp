@@ -0,0 +1,312 @@
+/*
+    SVBony Camera Driver - capture tests
+
+    Copyright (C) 2026
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <gtest/gtest.h>
+
+#include "svbony_capture.h"
+#include "svbony_fake_camera.h"
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static std::vector<uint8_t> randomPixels(size_t bytes, unsigned int seed)
+{
+    std::mt19937 random(seed);
+    std::vector<uint8_t> pixels(bytes);
+    for (auto &byte : pixels)
+        byte = static_cast<uint8_t>(random());
+    return pixels;
+}
+
+class SimdTest : public ::testing::TestWithParam<bool>
+{
+    protected:
+        void SetUp() override
+        {
+            SVBONYConvert::setSimd(GetParam());
+        }
+        void TearDown() override
+        {
+            SVBONYConvert::setSimd(true);
+        }
+};
+
+TEST_P(SimdTest, ToPlanar)
+{
+    for (int channels : {3, 4})
+    {
+        // Sizes around the 16 pixel blocks, and a full frame
+        for (size_t pixels : {0, 1, 15, 16, 17, 33, 47, 48, 1000, 1920 * 1080 + 5})
+        {
+            std::vector<uint8_t> const src = randomPixels(pixels * channels, static_cast<unsigned int>(pixels));
+            std::vector<uint8_t> dst(pixels * channels + 1, 0xA5);
+
+            SVBONYConvert::toPlanar(src.data(), dst.data(), pixels, channels);
+
+            for (size_t i = 0; i < pixels; i++)
+            {
+                ASSERT_EQ(dst[i], src[channels * i + 2]) << "R of pixel " << i << " of " << pixels;
+                ASSERT_EQ(dst[pixels + i], src[channels * i + 1]) << "G of pixel " << i << " of " << pixels;
+                ASSERT_EQ(dst[2 * pixels + i], src[channels * i]) << "B of pixel " << i << " of " << pixels;
+                if (channels == 4)
+                {
+                    ASSERT_EQ(dst[3 * pixels + i], src[channels * i + 3]) << "A of pixel " << i << " of " << pixels;
+                }
+            }
+            EXPECT_EQ(dst.back(), 0xA5) << "Wrote past the image";
+        }
+    }
+}
+
+TEST_P(SimdTest, SwapRedBlue)
+{
+    for (int channels : {3, 4})
+    {
+        for (size_t pixels : {0, 1, 3, 4, 5, 15, 16, 17, 31, 1000, 1920 * 1080 + 7})
+        {
+            std::vector<uint8_t> const src = randomPixels(pixels * channels + 1, static_cast<unsigned int>(pixels + 1));
+            std::vector<uint8_t> data = src;
+
+            SVBONYConvert::swapRedBlue(data.data(), pixels, channels);
+
+            for (size_t i = 0; i < pixels * channels; i += channels)
+            {
+                ASSERT_EQ(data[i], src[i + 2]) << "byte " << i << " of " << pixels << " pixels";
+                ASSERT_EQ(data[i + 1], src[i + 1]) << "byte " << i + 1 << " of " << pixels << " pixels";
+                ASSERT_EQ(data[i + 2], src[i]) << "byte " << i + 2 << " of " << pixels << " pixels";
+                if (channels == 4)
+                {
+                    ASSERT_EQ(data[i + 3], src[i + 3]) << "byte " << i + 3 << " of " << pixels << " pixels";
+                }
+            }
+            EXPECT_EQ(data.back(), src.back()) << "Wrote past the frame";
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, SimdTest, ::testing::Bool());
+
+TEST(SVBONYConvert, Throughput)
+{
+    size_t const pixels = 4144 * 2822;
+    std::vector<uint8_t> const src = randomPixels(pixels * 4, 1);
+    std::vector<uint8_t> dst(pixels * 4);
+
+    for (int channels : {3, 4})
+    {
+        double seconds[2];
+        for (int simd = 0; simd < 2; simd++)
+        {
+            SVBONYConvert::setSimd(simd);
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < 5; i++)
+                SVBONYConvert::toPlanar(src.data(), dst.data(), pixels, channels);
+            seconds[simd] = secondsSince(start) / 5;
+        }
+        SVBONYConvert::setSimd(true);
+
+        std::cout << (channels == 3 ? "RGB24" : "RGB32") << " " << pixels / 1e6 << " Mpx to planes: "
+                  << seconds[0] * 1e3 << " ms scalar, " << seconds[1] * 1e3 << " ms "
+                  << (SVBONYConvert::haveSimd() ? "vectorised" : "scalar (no SIMD)") << std::endl;
+    }
+}
+
+TEST(SVBONYCapture, StagingBufferKeptAcrossFrames)
+{
+    SVBONYFakeCamera camera(64, 32, SVB_IMG_RGB32);
+    SVBONYCapture capture(camera);
+
+    capture.setFormat(64, 32, SVB_IMG_RGB32);
+    EXPECT_EQ(capture.frameBytes(), 64u * 32 * 4);
+    const uint8_t *staging = capture.staging();
+
+    // Smaller ROI and format, same buffer
+    capture.setFormat(32, 16, SVB_IMG_RGB24);
+    EXPECT_EQ(capture.frameBytes(), 32u * 16 * 3);
+    EXPECT_EQ(capture.staging(), staging);
+    capture.setFormat(64, 32, SVB_IMG_RAW16);
+    EXPECT_EQ(capture.frameBytes(), 64u * 32 * 2);
+    EXPECT_EQ(capture.staging(), staging);
+}
+
+TEST(SVBONYCapture, ExposureWaitsInTheSDK)
+{
+    uint32_t const width = 160, height = 120;
+    SVBONYFakeCamera camera(width, height, SVB_IMG_RGB24);
+    SVBONYCapture capture(camera);
+    std::atomic_bool abort {false};
+    std::vector<uint8_t> image(width * height * 3);
+    std::vector<double> left;
+
+    camera.readout = 80;
+    capture.setFormat(width, height, SVB_IMG_RGB24);
+
+    Clock::time_point start = Clock::now();
+    ASSERT_EQ(capture.expose(1.7, image.data(), abort, [&](double seconds)
+    {
+        left.push_back(seconds);
+    }), SVBONYCapture::CAPTURE_OK) << capture.error();
+    double const elapsed = secondsSince(start);
+
+    // Exposure and readout in a single call to the SDK, no polling. Sleeps never return early, only the lower
+    // bounds are tight, the upper ones leave room for a loaded machine.
+    EXPECT_GE(elapsed, 1.78);
+    EXPECT_LT(elapsed, 3);
+    EXPECT_EQ(camera.triggers, 1);
+    EXPECT_EQ(camera.videoDataCalls, 1);
+    EXPECT_GE(capture.statistics().readout, 79);
+    EXPECT_LT(capture.statistics().readout, 1000);
+    EXPECT_EQ(capture.statistics().frames, 1u);
+    EXPECT_EQ(capture.statistics().timeouts, 0u);
+
+    // Countdown on whole seconds, then the last second at once
+    ASSERT_EQ(left.size(), 2u);
+    EXPECT_EQ(left[0], 2);
+    EXPECT_GT(left[1], 0);
+    EXPECT_LE(left[1], 1);
+
+    // Planes of the BGR frame
+    size_t const pixels = width * height;
+    for (size_t i = 0; i < pixels; i++)
+    {
+        ASSERT_EQ(image[i], SVBONYFakeCamera::pattern(0, 3 * i + 2));
+        ASSERT_EQ(image[pixels + i], SVBONYFakeCamera::pattern(0, 3 * i + 1));
+        ASSERT_EQ(image[2 * pixels + i], SVBONYFakeCamera::pattern(0, 3 * i));
+    }
+}
+
+TEST(SVBONYCapture, RawExposureReadsIntoImage)
+{
+    SVBONYFakeCamera camera(64, 48, SVB_IMG_RAW16);
+    SVBONYCapture capture(camera);
+    std::atomic_bool abort {false};
+    std::vector<uint8_t> image(64 * 48 * 2);
+
+    capture.setFormat(64, 48, SVB_IMG_RAW16);
+    ASSERT_EQ(capture.expose(0.05, image.data(), abort, nullptr), SVBONYCapture::CAPTURE_OK);
+    for (size_t i = 0; i < image.size(); i++)
+        ASSERT_EQ(image[i], SVBONYFakeCamera::pattern(0, i));
+}
+
+TEST(SVBONYCapture, TriggerRetries)
+{
+    SVBONYFakeCamera camera(16, 16, SVB_IMG_RAW8);
+    SVBONYCapture capture(camera);
+    std::atomic_bool abort {false};
+    std::vector<uint8_t> image(16 * 16);
+
+    capture.setFormat(16, 16, SVB_IMG_RAW8);
+    camera.failingTriggers = 2;
+    EXPECT_EQ(capture.expose(0.01, image.data(), abort, nullptr), SVBONYCapture::CAPTURE_OK);
+    EXPECT_EQ(camera.triggers, 3);
+
+    camera.failingTriggers = 3;
+    EXPECT_EQ(capture.expose(0.01, image.data(), abort, nullptr), SVBONYCapture::CAPTURE_FAILED);
+    EXPECT_EQ(camera.triggers, 6);
+    EXPECT_FALSE(capture.error().empty());
+}
+
+TEST(SVBONYCapture, Abort)
+{
+    SVBONYFakeCamera camera(16, 16, SVB_IMG_RAW8);
+    SVBONYCapture capture(camera);
+    std::atomic_bool abort {false};
+    std::vector<uint8_t> image(16 * 16);
+
+    capture.setFormat(16, 16, SVB_IMG_RAW8);
+    std::thread aborter([&]
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        abort = true;
+    });
+
+    Clock::time_point start = Clock::now();
+    EXPECT_EQ(capture.expose(30, image.data(), abort, nullptr), SVBONYCapture::CAPTURE_ABORTED);
+    EXPECT_LT(secondsSince(start), 1.5);
+    aborter.join();
+}
+
+TEST(SVBONYCapture, ReadoutTimeout)
+{
+    SVBONYFakeCamera camera(16, 16, SVB_IMG_RAW8);
+    SVBONYCapture capture(camera);
+    std::atomic_bool abort {false};
+    std::vector<uint8_t> image(16 * 16);
+
+    camera.stalled = true;
+    capture.setFormat(16, 16, SVB_IMG_RAW8);
+    capture.setReadoutTimeout(1200);
+
+    // Waits of READOUT_WAIT_MS until 1.2 s after the end of the exposure, three of them unless one overran
+    Clock::time_point start = Clock::now();
+    EXPECT_EQ(capture.expose(0.1, image.data(), abort, nullptr), SVBONYCapture::CAPTURE_FAILED);
+    EXPECT_GE(secondsSince(start), 1.3);
+    EXPECT_LT(secondsSince(start), 5);
+    EXPECT_GE(capture.statistics().timeouts, 1u);
+    EXPECT_LE(capture.statistics().timeouts, 3u);
+    EXPECT_EQ(capture.statistics().frames, 0u);
+}
+
+TEST(SVBONYCapture, VideoFrameRate)
+{
+    uint32_t const width = 640, height = 480;
+    SVBONYFakeCamera camera(width, height, SVB_IMG_RGB24);
+    SVBONYCapture capture(camera);
+    std::vector<uint8_t> frame(width * height * 3);
+
+    // 100 frames per second
+    camera.setExposure(10000);
+    camera.startVideo();
+    capture.setFormat(width, height, SVB_IMG_RGB24);
+
+    Clock::time_point start = Clock::now();
+    while (secondsSince(start) < 2.2)
+        ASSERT_EQ(capture.readVideoFrame(frame.data(), 500), SVB_SUCCESS);
+
+    std::cout << "Video: " << capture.statistics().frameRate << " frames/s, conversion "
+              << capture.statistics().conversion << " ms" << std::endl;
+    // Frames are paced by the exposure, a loaded machine can only drop some
+    EXPECT_LE(capture.statistics().frameRate, 105);
+    EXPECT_GT(capture.statistics().frameRate, 50);
+
+    // Last frame, swapped to RGB
+    uint32_t const last = camera.frames - 1;
+    for (size_t i = 0; i < frame.size(); i += 3)
+    {
+        ASSERT_EQ(frame[i], SVBONYFakeCamera::pattern(last, i + 2));
+        ASSERT_EQ(frame[i + 1], SVBONYFakeCamera::pattern(last, i + 1));
+        ASSERT_EQ(frame[i + 2], SVBONYFakeCamera::pattern(last, i));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -116,6 +116,7 @@ bool Talon6::Handshake()
         return true;
     }
 
+    framer.setFD(PortFD);
     return true;
 }
 
@@ -279,51 +280,21 @@ void Talon6::getFirmwareVersion()
     WriteString("&V#");
 }
 
-/* Read string from serial connection tty.
- Every string has a # (HEX23) as a trailing char*/
-int Talon6::ReadString(char *buf, int size)
+// This function sends command to the device through serial connection
+int Talon6::WriteString(const char *buf)
 {
-    int count;
-    int bytesRead;
-    char a;
-    int rc;
-
-    count = 0;
-    buf[count] = 0;
-
-    rc = tty_read(PortFD, &a, 1, 2, &bytesRead);
-
-    while(rc == TTY_OK)
-    {
-
-        if((a == '\n') || (a == '\r')) return count;
-
-        buf[count] = a;
-        count++;
-
-        if(count == size) return count;
-        rc = tty_read(PortFD, &a, 1, 1, &bytesRead);
-        //fprintf(stderr,"read returns %d %x\n",rc,a&0xFF);
+    char ReadBuf[40];
+    SerialFramer::Result result;
 
-    }
-    if(rc != TTY_OK)
+    int rc = Talon6Protocol::exchange(framer, buf, ReadBuf, 40, &result);
+    if (rc < 0)
     {
-        //fprintf(stderr,"Readstring returns error %d\n",rc);
+        LOGF_DEBUG("Error sending %s: %s", buf, SerialFramer::resultMessage(result));
         return -1;
     }
-    return count;
-}
 
-// This function sends command to the device through serial connection
-int Talon6::WriteString(const char *buf)
-{
-    char ReadBuf[40];
-    int bytesWritten;
-    int rc;
-
-    tty_write(PortFD, buf, strlen(buf), &bytesWritten);
-    rc = ReadString(ReadBuf, 40);
-    ProcessDomeMessage(ReadBuf);
+    if (rc > 0)
+        ProcessDomeMessage(ReadBuf, rc);
 
     return rc;
 }
@@ -368,7 +339,7 @@ void Talon6::TimerHit()
     }
 }
 
-void Talon6::ProcessDomeMessage(char *buf)
+void Talon6::ProcessDomeMessage(char *buf, int length)
 {
     // Only process not empty messages
     // and messages that start with &
@@ -380,23 +351,14 @@ void Talon6::ProcessDomeMessage(char *buf)
         return;
     }
     //Parse status respnse, second byte contains specs
-    if(buf[1] == 'G')
+    Talon6Protocol::Status status;
+    if(Talon6Protocol::decodeStatus(buf, length, status))
     {
-
-        //Parse first byte that contains Status and Last Action
-        int l;
-        int lStatus;
-        int lLastAction;
-
         std::string statusString;
         std::string lastActionString;
 
         //Parse Roof Status
-        l = buf[2] & 0x7F;
-        lStatus = l >> 4;
-        lLastAction = l  & 0x0F;
-
-        switch (lStatus)
+        switch (status.status)
         {
             case 0:
                 statusString = "OPEN";
@@ -430,7 +392,7 @@ void Talon6::ProcessDomeMessage(char *buf)
         IUSaveText(&StatusValueT[0], statusString.c_str());
 
         //Parse roof Last Action
-        switch (lLastAction)
+        switch (status.lastAction)
         {
             case 0:
                 lastActionString = "NONE";
@@ -489,18 +451,10 @@ void Talon6::ProcessDomeMessage(char *buf)
         IUSaveText(&StatusValueT[1], lastActionString.c_str());
 
         //Parse roof position
-        int x1, x2, x3;
-        int xxx;
+        int xxx = status.position;
         int xxxp;
         std::string xxxString, xxxpString;
 
-        // Roof position is encoded using a custom 3 hex bytes encoding (see Talon6 documentation).
-        x1 = (buf[3] & 0x7F) << 14;
-        x2 = (buf[4] & 0x7F) << 7;
-        x3 = buf[5]  & 0x7F;
-
-        // The 3 bytes are packed together to store the absolute position of the roof
-        xxx = x1 + x2 + x3;
         xxxp = (int)100 * ( xxx / EncoderTicksN[0].value);
         if (xxxp == 100)
         {
@@ -521,76 +475,20 @@ void Talon6::ProcessDomeMessage(char *buf)
         IUSaveText(&StatusValueT[3], xxxpString.c_str());
 
         //Parse power supply voltage
-        int b1, b2;
-        int  bb;
-        std::string bbString;
-
-        // Voltage is encoded using a custom 2 hex bytes encoding (see Talon6 documentation).
-        b1 = (buf[6] & 0x07) << 7 ;
-        b2 = buf[7]  & 0x7F;
-
-        // Values are then added. To get tension in V the result is *15/1024 (see Talon6 documentation)
-        bb = (b1 + b2) * 15 / 1024;
-        bbString = std::to_string(bb);
-
-        IUSaveText(&StatusValueT[4], bbString.c_str());
+        IUSaveText(&StatusValueT[4], std::to_string(status.voltage).c_str());
 
         //Parse closing timer
-        int t1, t2, t3;
-        int ttt;
-        std::string tttString;
-
-        // Closing timer is encoded using a custom 3 hex bytes encoding (see Talon6 documentation).
-        t1 = (buf[8] & 0x7F) << 14;
-        t2 = (buf[9] & 0x7F) << 7;
-        t3 = buf[10] & 0x7F;
-
-        // The 3 bytes are packed together
-        ttt = t1 + t2 +  t3;
-        tttString = std::to_string(ttt);
-
-        IUSaveText(&StatusValueT[5], tttString.c_str());
+        IUSaveText(&StatusValueT[5], std::to_string(status.closingTimer).c_str());
 
         //Parse power lost timer
-        int p1, p2;
-        int pp;
-        std::string ppString;
-
-        // Power lost timer is encoded using a custom 2 hex bytes encoding (see Talon6 documentation).
-        p1 = (buf[11] & 0x07) << 7 ;
-        p2 = buf[12] & 0x7F;
-
-
-        // Values are then added (see Talon6 documentation)
-        pp = (p1 + p2);
-        ppString = std::to_string(pp);
-
-        IUSaveText(&StatusValueT[6], ppString.c_str());
+        IUSaveText(&StatusValueT[6], std::to_string(status.powerLostTimer).c_str());
 
         // Weather Condition timer
-        int c1, c2;
-        int cc;
-        std::string ccString;
-
-        // Weather Condition timer is encoded using a custom 2 hex bytes encoding (see Talon6 documentation).
-        c1 = (buf[13] & 0x07) << 7 ;
-        c2 = buf[14] & 0x7F;
-
-        // Values are then added (see Talon6 documentation)
-        cc = (c1 + c2);
-        ccString = std::to_string(cc);
-
-        IUSaveText(&StatusValueT[7], ccString.c_str());
+        IUSaveText(&StatusValueT[7], std::to_string(status.weatherTimer).c_str());
 
         // Sensor & Switches Status
-        int m1, m2;
-
-        //Sensors status  is encoded using a custom 2 hex bytes encoding (see Talon6 documentation).
-        m1 = (buf[15] & 0x07) << 7 ; //Switches
-        m2 = buf[16] & 0x7F; //Sensors
-
-        // fprintf(stderr,"Readstring returns buf 15 %x\n",m1);
-        // fprintf(stderr,"Readstring returns buf 16 %x\n",m2);
+        int m1 = status.switches;
+        int m2 = status.sensors;
 
         //First bit contains Power Lost status
         if (m2 & 0x01 )
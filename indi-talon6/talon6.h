@@ -21,6 +21,8 @@
 
 #include <indidome.h>
 
+#include "talon6_protocol.h"
+
 /*  Some headers we need */
 #include <math.h>
 #include <sys/time.h>
@@ -91,11 +93,13 @@ class Talon6 : public INDI::Dome
         double MotionRequest { 0 };
         void getDeviceStatus();
         void getFirmwareVersion();
-        int ReadString(char *,int);
         int WriteString(const char *);
-        void ProcessDomeMessage(char *);
+        void ProcessDomeMessage(char *, int);
         char ShiftChar(char shiftChar);
 
+        // Buffered reads of the controller answers
+        SerialFramer framer;
+
 };
 
 #endif
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ Talon6
+ Copyright(c) 2026. All rights reserved.
+
+ Serial exchanges and status decoding of the Talon6 controller.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include "talon6_protocol.h"
+
+#include <algorithm>
+#include <string.h>
+
+namespace Talon6Protocol
+{
+int readAnswer(SerialFramer &framer, char *buf, int size, SerialFramer::Result *result)
+{
+    std::string answer;
+
+    buf[0] = 0;
+
+    SerialFramer::Result rc = framer.readFrame(answer, "\r\n", TALON6_TIMEOUT);
+    if (result != nullptr)
+        *result = rc;
+    if (rc != SerialFramer::FRAME_OK)
+        return -1;
+
+    int count = std::min<int>(answer.size(), size - 1);
+    memcpy(buf, answer.data(), count);
+    buf[count] = 0;
+
+    return count;
+}
+
+int exchange(SerialFramer &framer, const char *command, char *buf, int size, SerialFramer::Result *result)
+{
+    SerialFramer::Result rc = framer.write(command, strlen(command), TALON6_TIMEOUT);
+    if (rc != SerialFramer::FRAME_OK)
+    {
+        if (result != nullptr)
+            *result = rc;
+        buf[0] = 0;
+        return -1;
+    }
+
+    return readAnswer(framer, buf, size, result);
+}
+
+// Values spread over 3 or 2 bytes of 7 bits, the first of 2 bytes only has 3 bits
+static int pack3(const char *buf)
+{
+    return ((buf[0] & 0x7F) << 14) + ((buf[1] & 0x7F) << 7) + (buf[2] & 0x7F);
+}
+
+static int pack2(const char *buf)
+{
+    return ((buf[0] & 0x07) << 7) + (buf[1] & 0x7F);
+}
+
+bool decodeStatus(const char *buf, int length, Status &status)
+{
+    if (length < 17 || buf[0] != '&' || buf[1] != 'G')
+        return false;
+
+    int l = buf[2] & 0x7F;
+    status.status     = l >> 4;
+    status.lastAction = l & 0x0F;
+    status.position   = pack3(buf + 3);
+    // To get tension in V the result is *15/1024
+    status.voltage        = pack2(buf + 6) * 15 / 1024;
+    status.closingTimer   = pack3(buf + 8);
+    status.powerLostTimer = pack2(buf + 11);
+    status.weatherTimer   = pack2(buf + 13);
+    status.switches       = (buf[15] & 0x07) << 7;
+    status.sensors        = buf[16] & 0x7F;
+
+    return true;
+}
+}
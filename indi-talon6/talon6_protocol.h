@@ -0,0 +1,56 @@
+/*******************************************************************************
+ Talon6
+ Copyright(c) 2026. All rights reserved.
+
+ Serial exchanges and status decoding of the Talon6 controller, without INDI
+ so the tests can run them on a pseudo terminal.
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include "serialframer.h"
+
+#define TALON6_TIMEOUT 2000 /* Time for a whole answer from the controller (ms) */
+
+namespace Talon6Protocol
+{
+/** Fields of the answer to &G#, each one packed in 7 bits per byte (see Talon6 documentation) */
+struct Status
+{
+    int status;             // 0 open, 1 closed, 2 opening, 3 closing, 4 error
+    int lastAction;
+    int position;           // encoder ticks
+    int voltage;            // V
+    int closingTimer;
+    int powerLostTimer;
+    int weatherTimer;
+    int switches;
+    int sensors;
+};
+
+/**
+ * @brief Reads one answer, terminated by CR or LF, that has to arrive within TALON6_TIMEOUT.
+ * @return the length of the answer copied in buf, truncated to size - 1, or -1 on error.
+ */
+int readAnswer(SerialFramer &framer, char *buf, int size, SerialFramer::Result *result = nullptr);
+
+/** Sends a command and reads its answer, same return as readAnswer() */
+int exchange(SerialFramer &framer, const char *command, char *buf, int size, SerialFramer::Result *result = nullptr);
+
+/** Decodes an answer to &G#, false if buf is not one */
+bool decodeStatus(const char *buf, int length, Status &status);
+}
@@ -0,0 +1,156 @@
+/*
+    Talon6 serial protocol on a pseudo terminal
+    Copyright(c) 2026. All rights reserved.
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2.1 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include <gtest/gtest.h>
+
+#include "talon6_protocol.h"
+#include "serialscript.h"
+
+#define POLLS 20
+
+// Answer to &G#: 7 bit values with the high bit set, then the end of message and CR LF.
+// Closed by user, at 12345 ticks, 12 V, closing in 300 s, 5 s and 7 s on the other timers.
+static const std::string STATUS = std::string("&G") + "\x92" + "\x80\xe0\xb9" + "\x86\xb4" + "\x80\x82\xac" + "\x80\x85" +
+                                  "\x80\x87" + "\x81\x95" + std::string(13, '\x81') + "#\r\n";
+
+class Talon6Link : public ::testing::Test
+{
+    protected:
+        void SetUp() override
+        {
+            script.add("&G#", STATUS);
+            script.add("&V#", "&V2.3#\r\n");
+            // A USB adapter hands the answer over in small pieces
+            script.setPacing(8, 200);
+            fd = script.start();
+            ASSERT_GE(fd, 0);
+        }
+
+        SerialScript script;
+        int fd { -1 };
+};
+
+TEST_F(Talon6Link, StatusPoll)
+{
+    SerialFramer framer;
+    framer.setFD(fd);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < POLLS; i++)
+    {
+        char answer[40];
+        ASSERT_EQ(Talon6Protocol::exchange(framer, "&G#", answer, sizeof(answer)), static_cast<int>(STATUS.size() - 2));
+        EXPECT_EQ(std::string(answer), STATUS.substr(0, STATUS.size() - 2));
+    }
+    double framed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / POLLS;
+    double framedCalls = static_cast<double>(framer.getStatistics().syscalls()) / POLLS;
+
+    // The LF of the last CR LF may still be on its way
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    framer.discardInput();
+
+    // The same polls the way ReadString() used to read them, one byte at a time
+    LegacyTty legacy(fd);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < POLLS; i++)
+    {
+        std::string frame;
+        ASSERT_TRUE(legacy.write("&G#"));
+        ASSERT_GT(legacy.readSection(frame, '\n', 2), 0);
+        EXPECT_EQ(frame, STATUS);
+    }
+    double legacyTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / POLLS;
+    double legacyCalls = static_cast<double>(legacy.getSyscalls()) / POLLS;
+
+    printf("Status poll: %.1f syscalls %.2f ms, byte by byte %.1f syscalls %.2f ms\n",
+           framedCalls, framed, legacyCalls, legacyTime);
+
+    EXPECT_LT(framedCalls * 4, legacyCalls);
+}
+
+TEST_F(Talon6Link, DecodesStatus)
+{
+    SerialFramer framer;
+    framer.setFD(fd);
+
+    char answer[40];
+    int length = Talon6Protocol::exchange(framer, "&G#", answer, sizeof(answer));
+    ASSERT_GT(length, 0);
+
+    Talon6Protocol::Status status;
+    ASSERT_TRUE(Talon6Protocol::decodeStatus(answer, length, status));
+    EXPECT_EQ(status.status, 1);
+    EXPECT_EQ(status.lastAction, 2);
+    EXPECT_EQ(status.position, 12345);
+    EXPECT_EQ(status.voltage, 12);
+    EXPECT_EQ(status.closingTimer, 300);
+    EXPECT_EQ(status.powerLostTimer, 5);
+    EXPECT_EQ(status.weatherTimer, 7);
+    EXPECT_EQ(status.sensors, 0x15);
+
+    // The firmware version is not a status, nor is a truncated answer
+    length = Talon6Protocol::exchange(framer, "&V#", answer, sizeof(answer));
+    EXPECT_STREQ(answer, "&V2.3#");
+    EXPECT_FALSE(Talon6Protocol::decodeStatus(answer, length, status));
+    EXPECT_FALSE(Talon6Protocol::decodeStatus(STATUS.data(), 10, status));
+}
+
+TEST_F(Talon6Link, AnswersStayInOrder)
+{
+    SerialFramer framer;
+    framer.setFD(fd);
+
+    // Both commands before reading, the second answer waits in the buffer
+    char answer[40];
+    ASSERT_EQ(framer.write("&V#", 1000), SerialFramer::FRAME_OK);
+    ASSERT_EQ(Talon6Protocol::exchange(framer, "&G#", answer, sizeof(answer)), 6);
+    EXPECT_STREQ(answer, "&V2.3#");
+    ASSERT_GT(Talon6Protocol::readAnswer(framer, answer, sizeof(answer)), 0);
+    EXPECT_EQ(answer[1], 'G');
+    EXPECT_EQ(framer.available(), 0u);
+
+    // An answer longer than the buffer is truncated, as ReadString() did
+    ASSERT_EQ(Talon6Protocol::exchange(framer, "&G#", answer, 8), 7);
+    EXPECT_EQ(std::string(answer), STATUS.substr(0, 7));
+}
+
+TEST_F(Talon6Link, TimeoutIsPerFrame)
+{
+    SerialFramer framer;
+    framer.setFD(fd);
+
+    // Half a frame then silence, the whole frame must fail in one timeout
+    script.inject("&G\x81\x81");
+    char answer[40];
+    SerialFramer::Result result;
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(Talon6Protocol::readAnswer(framer, answer, sizeof(answer), &result), -1);
+    EXPECT_EQ(result, SerialFramer::FRAME_TIMEOUT);
+    EXPECT_STREQ(answer, "");
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(elapsed, TALON6_TIMEOUT - 10);
+
+    EXPECT_EQ(framer.discardInput(), 4u);
+}
+
+int main(int argc, char **argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
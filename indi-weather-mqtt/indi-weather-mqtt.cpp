@@ -19,15 +19,24 @@
 *******************************************************************************/
 
 #include "indi-weather-mqtt.h"
+#include "mqtt-mosquitto.h"
 
 #include <memory>
 #include <cstring>
 #include <unistd.h>
 #include <functional>
+#include <set>
 #include "config.h"
 
 #define MQTT_POLL (200) // 0.2 sec
 
+// Weather parameter of each topic in MqttTopicsT
+static const char *const MqttParameters[8] =
+{
+	"WEATHER_TEMPERATURE", "WEATHER_HUMIDITY", "WEATHER_PRESSURE", "WEATHER_WIND_SPEED",
+	"WEATHER_WIND_GUST", "WEATHER_RAINFALL", "WEATHER_CLOUDS", "WEATHER_LIGHT"
+};
+
 std::unique_ptr<WeatherMQTT> weatherMQTT(new WeatherMQTT());
 
 WeatherMQTT::WeatherMQTT()
@@ -35,16 +44,18 @@ WeatherMQTT::WeatherMQTT()
     setVersion(VERSION_MAJOR,VERSION_MINOR);
     setWeatherConnection(CONNECTION_NONE);
 
-    mosquitto_lib_init();
     snprintf(mqtt_clientid, 31, "indi-weather-mqtt-%d", getpid());
-    mosq = mosquitto_new(mqtt_clientid, true, this);
-    mosquitto_message_callback_set(mosq, mqttMsgCallback);
+    broker.reset(new MosquittoBroker(mqtt_clientid));
+    broker->setMessageHandler([this](const char *topic, const void *payload, int length)
+    {
+        ingest.ingest(topic, payload, length);
+    });
 }
 
 WeatherMQTT::~WeatherMQTT()
 {
-	mosquitto_destroy(mosq);
-	mosquitto_lib_cleanup();
+	// stop the network thread before ingest goes away
+	broker.reset();
 }
 
 const char *WeatherMQTT::getDefaultName()
@@ -55,23 +66,17 @@ const char *WeatherMQTT::getDefaultName()
 bool WeatherMQTT::Connect()
 {
 	// connect to mqtt broker
-	if (mosq)
+	if (broker)
 	{
 		DEBUGF(INDI::Logger::DBG_DEBUG, "Connecting to MQTT broker (mqtt_host=%s, mqtt_port=%s, mqtt_user=%s, mqtt_pass=%s)", MqttServerT[0].text, MqttServerT[1].text, MqttServerT[2].text, MqttServerT[3].text);
 
-		// set mqtt username and password
-		mosquitto_username_pw_set(mosq, MqttServerT[2].text, MqttServerT[3].text);
-
-		// connect to broker
-		int rc = mosquitto_connect(mosq, MqttServerT[0].text, atoi(MqttServerT[1].text), 60);
-		DEBUGF(INDI::Logger::DBG_DEBUG, "MQTT broker connection status: %d", rc);
-
-		if ( rc == 0)
+		// connect to broker, and start its network thread
+		if (broker->connect(MqttServerT[0].text, atoi(MqttServerT[1].text), MqttServerT[2].text, MqttServerT[3].text))
 		{
 			DEBUG(INDI::Logger::DBG_SESSION, "MQTT Weather connected successfully.");
 			// subscribe topics
 			mqttSubscribe();
-			// set mqtt loop timer
+			// set timer applying received values
 			MqttLoopTimerID = IEAddTimer(MQTT_POLL, MqttLoopHelper, this);
 			return true;
 		}  else {
@@ -84,8 +89,14 @@ bool WeatherMQTT::Connect()
 
 bool WeatherMQTT::Disconnect()
 {
+	if (MqttLoopTimerID >= 0)
+	{
+		IERmTimer(MqttLoopTimerID);
+		MqttLoopTimerID = -1;
+	}
+
 	// disconnect from mqtt broker
-	mosquitto_disconnect(mosq);
+	broker->disconnect();
     return true;
 }
 
@@ -111,6 +122,17 @@ bool WeatherMQTT::initProperties()
 	IUFillText(&MqttTopicsT[7], "MQTT_LIGHT", "Light", "");
 	IUFillTextVector(&MqttTopicsTP, MqttTopicsT, 8, getDeviceName(), "MQTT_TOPICS", "MQTT Topics", OPTIONS_TAB,IP_RW, 0, IPS_IDLE);
 
+	// MQTT JSON fields, as "main.temp" or "sensors.0.value"
+	IUFillText(&MqttFieldsT[0], "MQTT_TEMPERATURE_FIELD", "Temperature", "");
+	IUFillText(&MqttFieldsT[1], "MQTT_HUMIDITY_FIELD", "Humidity", "");
+	IUFillText(&MqttFieldsT[2], "MQTT_PRESSURE_FIELD", "Pressure", "");
+	IUFillText(&MqttFieldsT[3], "MQTT_WIND_FIELD", "Wind", "");
+	IUFillText(&MqttFieldsT[4], "MQTT_GUST_FIELD", "Gust", "");
+	IUFillText(&MqttFieldsT[5], "MQTT_RAIN_FIELD", "Rain", "");
+	IUFillText(&MqttFieldsT[6], "MQTT_CLOUDS_FIELD", "Clouds", "");
+	IUFillText(&MqttFieldsT[7], "MQTT_LIGHT_FIELD", "Light", "");
+	IUFillTextVector(&MqttFieldsTP, MqttFieldsT, 8, getDeviceName(), "MQTT_FIELDS", "MQTT JSON Fields", OPTIONS_TAB,IP_RW, 0, IPS_IDLE);
+
 	// add weather parameters
     addParameter("WEATHER_FORECAST", "Weather", 0, 1, 15);
     addParameter("WEATHER_TEMPERATURE", "Temperature (C)", -10, 30, 15);
@@ -147,10 +169,12 @@ bool WeatherMQTT::initProperties()
 	// we need this before connecting to mqtt broker
 	defineProperty(&MqttServerTP);
 	defineProperty(&MqttTopicsTP);
+	defineProperty(&MqttFieldsTP);
 
 	// load saved config
 	loadConfig(false, "MQTT_SERVER");
 	loadConfig(false, "MQTT_TOPICS");
+	loadConfig(false, "MQTT_FIELDS");
 
     //addDebugControl();
 
@@ -175,6 +199,33 @@ bool WeatherMQTT::updateProperties()
 
 IPState WeatherMQTT::updateWeather()
 {
+	// apply the values received since the last update at once
+	MqttIngest::Batch batch = ingest.take();
+
+	for (const auto &entry : batch)
+	{
+		DEBUGF(INDI::Logger::DBG_DEBUG, "%s received: %g (%u messages)", MqttParameters[entry.first], entry.second.value, entry.second.count);
+		setParameterValue(MqttParameters[entry.first], entry.second.value);
+	}
+
+	// clear
+	if (checkParameterState("WEATHER_TEMPERATURE") == IPS_OK && checkParameterState("WEATHER_HUMIDITY") == IPS_OK && checkParameterState("WEATHER_WIND_SPEED") == IPS_OK && checkParameterState("WEATHER_RAINFALL") == IPS_OK && checkParameterState("WEATHER_CLOUDS") == IPS_OK && checkParameterState("WEATHER_LIGHT") == IPS_OK)
+	{
+		setParameterValue("WEATHER_FORECAST", 0);
+	}
+
+	// warning zone
+	if (checkParameterState("WEATHER_TEMPERATURE") == IPS_BUSY || checkParameterState("WEATHER_HUMIDITY") == IPS_BUSY || checkParameterState("WEATHER_WIND_SPEED") == IPS_BUSY || checkParameterState("WEATHER_RAINFALL") == IPS_BUSY || checkParameterState("WEATHER_CLOUDS") == IPS_BUSY || checkParameterState("WEATHER_LIGHT") == IPS_BUSY)
+	{
+		setParameterValue("WEATHER_FORECAST", 1);
+	}
+
+	// danger zone
+	if (checkParameterState("WEATHER_TEMPERATURE") == IPS_ALERT || checkParameterState("WEATHER_HUMIDITY") == IPS_ALERT || checkParameterState("WEATHER_WIND_SPEED") == IPS_ALERT || checkParameterState("WEATHER_RAINFALL") == IPS_ALERT || checkParameterState("WEATHER_CLOUDS") == IPS_ALERT || checkParameterState("WEATHER_LIGHT") == IPS_ALERT)
+	{
+		setParameterValue("WEATHER_FORECAST", 2);
+	}
+
 	return IPS_OK;
 }
 
@@ -210,6 +261,19 @@ bool WeatherMQTT::ISNewText (const char *dev, const char *name, char *texts[], c
 			mqttSubscribe();
 			return true;
 		}
+
+		// handle mqtt json fields
+		if (!strcmp(name, MqttFieldsTP.name))
+		{
+			IUUpdateText(&MqttFieldsTP,texts,names,n);
+			MqttFieldsTP.s=IPS_OK;
+			IDSetText(&MqttFieldsTP, nullptr);
+			DEBUG(INDI::Logger::DBG_SESSION, "MQTT weather fields set.");
+
+			// route topics to the new fields
+			mqttSubscribe();
+			return true;
+		}
 	}
 
 	return INDI::Weather::ISNewText(dev,name,texts,names,n);
@@ -221,6 +285,7 @@ bool WeatherMQTT::saveConfigItems(FILE *fp)
 
 	IUSaveConfigText(fp, &MqttServerTP);
 	IUSaveConfigText(fp, &MqttTopicsTP);
+	IUSaveConfigText(fp, &MqttFieldsTP);
 
     return true;
 }
@@ -236,20 +301,10 @@ void WeatherMQTT::MqttLoop()
 	if (!isConnected())
 		return;
 
-	// mqtt ping
-	DEBUG(INDI::Logger::DBG_DEBUG, "MQTT ping.");
-
-	// keep alive and reconnect if neccessary
-	if (mosquitto_loop(mosq, -1, 1))
-	{
-		DEBUG(INDI::Logger::DBG_SESSION, "Connection to MQTT broker lost. Reconnecting.");
-		mosquitto_reconnect(mosq);
-		if (mosq)
-		{
-			DEBUG(INDI::Logger::DBG_SESSION, "Successfully connected to MQTT broker.");
-			mqttSubscribe();
-		}
-	}
+	// the network thread of the broker client keeps the connection alive and reconnects,
+	// publish what it received during this cycle
+	if (ingest.pending())
+		TimerHit();
 
 	// restart timer
 	MqttLoopTimerID = IEAddTimer(MQTT_POLL, MqttLoopHelper, this);
@@ -261,13 +316,22 @@ void WeatherMQTT::mqttSubscribe()
 
 	// calculate number of topics
 	int topics = *(&MqttTopicsT + 1) - MqttTopicsT;
+	std::set<std::string> subscribed;
+
+	ingest.clearRoutes();
 
 	// subscribe to each topic
 	for (int i=0; i < topics; i++)
 	{
 		if (MqttTopicsT[i].text != NULL && MqttTopicsT[i].text[0] != '\0')
 		{
-			if (!mosquitto_subscribe(mosq, NULL, MqttTopicsT[i].text, 0))
+			ingest.route(i, MqttTopicsT[i].text, MqttFieldsT[i].text != NULL ? MqttFieldsT[i].text : "");
+
+			// several parameters may be fields of the same topic
+			if (!subscribed.insert(MqttTopicsT[i].text).second)
+				continue;
+
+			if (broker->subscribe(MqttTopicsT[i].text))
 			{
 				DEBUGF(INDI::Logger::DBG_DEBUG, "Subscribed to %s", MqttTopicsT[i].text);
 			} else {
@@ -283,13 +347,19 @@ void WeatherMQTT::mqttUnSubscribe()
 
 	// calculate number of topics
 	int topics = *(&MqttTopicsT + 1) - MqttTopicsT;
+	std::set<std::string> unsubscribed;
+
+	ingest.clearRoutes();
 
 	// unsubscribe each topic
 	for (int i=0; i < topics; i++)
 	{
 		if (MqttTopicsT[i].text != NULL && MqttTopicsT[i].text[0] != '\0')
 		{
-			if (!mosquitto_unsubscribe(mosq, NULL, MqttTopicsT[i].text))
+			if (!unsubscribed.insert(MqttTopicsT[i].text).second)
+				continue;
+
+			if (broker->unsubscribe(MqttTopicsT[i].text))
 			{
 				DEBUGF(INDI::Logger::DBG_DEBUG, "Unsubscribed %s", MqttTopicsT[i].text);
 			} else {
@@ -298,73 +368,3 @@ void WeatherMQTT::mqttUnSubscribe()
 		}
 	}
 }
-
-void WeatherMQTT::mqttMsgCallback(struct mosquitto *, void *obj, const struct mosquitto_message *message)
-{
-	static_cast<WeatherMQTT*>(obj)->mqttMsg((char*) message->topic, (char*) message->payload);
-}
-
-void WeatherMQTT::mqttMsg(char* topic, char* msg)
-{
-	DEBUGF(INDI::Logger::DBG_DEBUG, "Received MQTT message '%s for topic %s", topic, msg);
-
-	if (MqttTopicsT[0].text != NULL && !strcmp(MqttTopicsT[0].text, topic)) {
-		DEBUG(INDI::Logger::DBG_DEBUG, "Temperature received.");
-		setParameterValue("WEATHER_TEMPERATURE", atof(msg));
-	}
-
-	if (MqttTopicsT[1].text != NULL && !strcmp(MqttTopicsT[1].text, topic)) {
-		DEBUG(INDI::Logger::DBG_DEBUG, "Humidity received.");
-		setParameterValue("WEATHER_HUMIDITY", atof(msg));
-	}
-
-	if (MqttTopicsT[2].text != NULL && !strcmp(MqttTopicsT[2].text, topic)) {
-		DEBUG(INDI::Logger::DBG_DEBUG, "Pressure received.");
-		setParameterValue("WEATHER_PRESSURE", atof(msg));
-	}
-
-	if (MqttTopicsT[3].text != NULL && !strcmp(MqttTopicsT[3].text, topic)) {
-		DEBUG(INDI::Logger::DBG_DEBUG, "Wind received.");
-		setParameterValue("WEATHER_WIND_SPEED", atof(msg));
-	}
-
-	if (MqttTopicsT[4].text != NULL && !strcmp(MqttTopicsT[4].text, topic)) {
-		DEBUG(INDI::Logger::DBG_DEBUG, "Wind gust received.");
-		setParameterValue("WEATHER_WIND_GUST", atof(msg));
-	}
-
-	if (MqttTopicsT[5].text != NULL && !strcmp(MqttTopicsT[5].text, topic)) {
-		DEBUG(INDI::Logger::DBG_DEBUG, "Rain received.");
-		setParameterValue("WEATHER_RAINFALL", atof(msg));
-	}
-
-	if (MqttTopicsT[6].text != NULL && !strcmp(MqttTopicsT[6].text, topic)) {
-		DEBUG(INDI::Logger::DBG_DEBUG, "Clouds received.");
-		setParameterValue("WEATHER_CLOUDS", atof(msg));
-	}
-
-	if (MqttTopicsT[7].text != NULL && !strcmp(MqttTopicsT[7].text, topic)) {
-		DEBUG(INDI::Logger::DBG_DEBUG, "Light received.");
-		setParameterValue("WEATHER_LIGHT", atof(msg));
-	}
-
-	// clear
-	if (checkParameterState("WEATHER_TEMPERATURE") == IPS_OK && checkParameterState("WEATHER_HUMIDITY") == IPS_OK && checkParameterState("WEATHER_WIND_SPEED") == IPS_OK && checkParameterState("WEATHER_RAINFALL") == IPS_OK && checkParameterState("WEATHER_CLOUDS") == IPS_OK && checkParameterState("WEATHER_LIGHT") == IPS_OK)
-	{
-		setParameterValue("WEATHER_FORECAST", 0);
-	}
-
-	// warning zone
-	if (checkParameterState("WEATHER_TEMPERATURE") == IPS_BUSY || checkParameterState("WEATHER_HUMIDITY") == IPS_BUSY || checkParameterState("WEATHER_WIND_SPEED") == IPS_BUSY || checkParameterState("WEATHER_RAINFALL") == IPS_BUSY || checkParameterState("WEATHER_CLOUDS") == IPS_BUSY || checkParameterState("WEATHER_LIGHT") == IPS_BUSY)
-	{
-		setParameterValue("WEATHER_FORECAST", 1);
-	}
-
-	// danger zone
-	if (checkParameterState("WEATHER_TEMPERATURE") == IPS_ALERT || checkParameterState("WEATHER_HUMIDITY") == IPS_ALERT || checkParameterState("WEATHER_WIND_SPEED") == IPS_ALERT || checkParameterState("WEATHER_RAINFALL") == IPS_ALERT || checkParameterState("WEATHER_CLOUDS") == IPS_ALERT || checkParameterState("WEATHER_LIGHT") == IPS_ALERT)
-	{
-		setParameterValue("WEATHER_FORECAST", 2);
-	}
-
-	TimerHit();
-}
@@ -21,7 +21,9 @@
 #pragma once
 
 #include "indiweather.h"
-#include <mosquitto.h>
+#include "mqtt-ingest.h"
+
+#include <memory>
 
 class WeatherMQTT : public INDI::Weather
 {
@@ -47,13 +49,16 @@ class WeatherMQTT : public INDI::Weather
 	ITextVectorProperty MqttServerTP;
 	IText MqttTopicsT[8];
 	ITextVectorProperty MqttTopicsTP;
+	// JSON field paths, empty for plain number payloads
+	IText MqttFieldsT[8];
+	ITextVectorProperty MqttFieldsTP;
 
-	struct mosquitto *mosq = NULL;
+	// Messages arrive on the network thread of the broker client, and are applied once per MQTT_POLL
+	std::unique_ptr<MqttBroker> broker;
+	MqttIngest ingest;
 	void mqttSubscribe();
 	void mqttUnSubscribe();
 	int MqttLoopTimerID { -1 };
 	static void MqttLoopHelper(void *context);
 	void MqttLoop();
-	static void mqttMsgCallback(struct mosquitto *, void *, const struct mosquitto_message *message);
-	void mqttMsg(char *topic, char *message);
 };
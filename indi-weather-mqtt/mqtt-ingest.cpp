@@ -0,0 +1,269 @@
+/*******************************************************************************
+ Copyright(c) 2026
+
+ INDI MQTT Weather Driver - message ingestion
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include "mqtt-ingest.h"
+
+#ifdef _USE_SYSTEM_JSONLIB
+#include <nlohmann/json.hpp>
+#else
+#include <indijson.hpp>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+
+// Topics resolved against wildcard subscriptions that are remembered
+#define MQTT_RESOLVED_MAX (1024)
+
+using json = nlohmann::json;
+
+namespace
+{
+
+// A number, a boolean or a string holding a number
+bool numberOf(const json &node, double &value)
+{
+	if (node.is_number() || node.is_boolean())
+	{
+		value = node.is_boolean() ? node.get<bool>() : node.get<double>();
+		return true;
+	}
+	if (!node.is_string())
+		return false;
+
+	const std::string &text = node.get_ref<const std::string &>();
+	char *last;
+	value = strtod(text.c_str(), &last);
+	if (last == text.c_str())
+		return false;
+	while (*last == ' ' || *last == '\t' || *last == '\n' || *last == '\r')
+		last++;
+	return *last == '\0';
+}
+
+}
+
+void MqttIngest::route(int parameter, const std::string &topic, const std::string &path)
+{
+	std::lock_guard<std::mutex> guard(routesLock);
+	Route entry { parameter, splitPath(path) };
+
+	if (topic.find_first_of("+#") != std::string::npos)
+	{
+		wildcards.emplace_back(topic, entry);
+		resolved.clear();
+	}
+	else
+		routes[topic].push_back(entry);
+}
+
+void MqttIngest::clearRoutes()
+{
+	std::lock_guard<std::mutex> guard(routesLock);
+	routes.clear();
+	wildcards.clear();
+	resolved.clear();
+}
+
+const std::vector<MqttIngest::Route> &MqttIngest::resolve(const std::string &topic)
+{
+	static const std::vector<Route> none;
+
+	if (wildcards.empty())
+	{
+		auto exact = routes.find(topic);
+		return exact == routes.end() ? none : exact->second;
+	}
+
+	auto known = resolved.find(topic);
+	if (known != resolved.end())
+		return known->second;
+
+	// First message on this topic, collect the exact route and all matching wildcards
+	if (resolved.size() >= MQTT_RESOLVED_MAX)
+		resolved.clear();
+	std::vector<Route> &matches = resolved[topic];
+	auto exact = routes.find(topic);
+	if (exact != routes.end())
+		matches = exact->second;
+	for (const auto &wildcard : wildcards)
+	{
+		if (topicMatches(wildcard.first.c_str(), topic.c_str()))
+			matches.push_back(wildcard.second);
+	}
+	return matches;
+}
+
+void MqttIngest::ingest(const char *topic, const void *payload, int length)
+{
+	clock::time_point now = clock::now();
+	const char *text = static_cast<const char *>(payload);
+	double values[8];
+	int parameters[8];
+	int count = 0;
+
+	receivedCount++;
+
+	{
+		std::lock_guard<std::mutex> guard(routesLock);
+		const std::vector<Route> &matches = resolve(topic);
+
+		if (matches.empty())
+		{
+			unroutedCount++;
+			return;
+		}
+
+		for (const Route &match : matches)
+		{
+			if (count == 8)
+				break;
+			if (text != NULL && parseValue(text, length, match.path, values[count]))
+				parameters[count++] = match.parameter;
+		}
+	}
+
+	if (count == 0)
+	{
+		rejectedCount++;
+		return;
+	}
+
+	std::lock_guard<std::mutex> guard(batchLock);
+	for (int i = 0; i < count; i++)
+	{
+		auto entry = batch.find(parameters[i]);
+		if (entry == batch.end())
+			batch.emplace(parameters[i], Value { values[i], 1, now });
+		else
+		{
+			entry->second.value = values[i];
+			entry->second.count++;
+		}
+	}
+}
+
+MqttIngest::Batch MqttIngest::take()
+{
+	Batch taken;
+	std::lock_guard<std::mutex> guard(batchLock);
+	taken.swap(batch);
+	return taken;
+}
+
+bool MqttIngest::pending()
+{
+	std::lock_guard<std::mutex> guard(batchLock);
+	return !batch.empty();
+}
+
+bool MqttIngest::topicMatches(const char *filter, const char *topic)
+{
+	// Wildcards do not match the $SYS like topics
+	if (topic[0] == '$' && filter[0] != '$')
+		return false;
+
+	while (*filter != '\0')
+	{
+		if (filter[0] == '#')
+			return true;
+
+		if (filter[0] == '+')
+		{
+			while (*topic != '\0' && *topic != '/')
+				topic++;
+			filter++;
+		}
+		else
+		{
+			while (*filter != '\0' && *filter != '/')
+			{
+				if (*filter++ != *topic++)
+					return false;
+			}
+			if (*topic != '\0' && *topic != '/')
+				return false;
+		}
+
+		if (*filter == '\0')
+			return *topic == '\0';
+
+		// Both are at a level separator, or the topic ended
+		if (*topic == '\0')
+			// "a/#" also matches "a"
+			return !strcmp(filter, "/#");
+		filter++;
+		topic++;
+	}
+
+	return *topic == '\0';
+}
+
+bool MqttIngest::parseValue(const char *payload, int length, const std::vector<std::string> &path, double &value)
+{
+	if (length <= 0)
+		return false;
+
+	json document = json::parse(payload, payload + length, nullptr, false);
+	if (document.is_discarded())
+		return false;
+
+	const json *node = &document;
+	for (const std::string &level : path)
+	{
+		if (node->is_object())
+		{
+			auto member = node->find(level);
+			if (member == node->end())
+				return false;
+			node = &*member;
+		}
+		else if (node->is_array())
+		{
+			char *last;
+			long index = strtol(level.c_str(), &last, 10);
+			if (level.empty() || *last != '\0' || index < 0 || static_cast<size_t>(index) >= node->size())
+				return false;
+			node = &(*node)[index];
+		}
+		else
+			return false;
+	}
+	return numberOf(*node, value);
+}
+
+std::vector<std::string> MqttIngest::splitPath(const std::string &path)
+{
+	std::vector<std::string> levels;
+	size_t start = 0;
+
+	if (path.empty())
+		return levels;
+
+	while (true)
+	{
+		size_t dot = path.find('.', start);
+		levels.push_back(path.substr(start, dot - start));
+		if (dot == std::string::npos)
+			break;
+		start = dot + 1;
+	}
+	return levels;
+}
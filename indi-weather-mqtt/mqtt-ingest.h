@@ -0,0 +1,118 @@
+/*******************************************************************************
+ Copyright(c) 2026
+
+ INDI MQTT Weather Driver - message ingestion
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Connection to a broker, the messages are delivered from the network thread of the broker client
+class MqttBroker
+{
+  public:
+	typedef std::function<void(const char *topic, const void *payload, int length)> MessageHandler;
+
+	virtual ~MqttBroker() {}
+
+	void setMessageHandler(MessageHandler messageHandler) { handler = messageHandler; }
+
+	virtual bool connect(const char *host, int port, const char *user, const char *pass) = 0;
+	virtual void disconnect() = 0;
+	virtual bool subscribe(const char *topic) = 0;
+	virtual bool unsubscribe(const char *topic) = 0;
+
+  protected:
+	MessageHandler handler;
+};
+
+/*
+ Routes the messages of the broker thread to the weather parameters, and keeps the last value of each parameter
+ until the INDI thread takes them all at once.
+
+ Topics are looked up in a hash map. A topic matching wildcard subscriptions is resolved once, then added to the
+ map. A payload is either a number, or a JSON document and the path to the number in it, as "wind.speed" or
+ "sensors.0.value".
+*/
+class MqttIngest
+{
+  public:
+	typedef std::chrono::steady_clock clock;
+
+	struct Value
+	{
+		double value;
+		// Messages received for the parameter since the last batch, only the last value is kept
+		unsigned int count;
+		// Arrival of the first of these messages
+		clock::time_point received;
+	};
+
+	// Parameter index to its last value
+	typedef std::map<int, Value> Batch;
+
+	// Empty path for a plain number payload
+	void route(int parameter, const std::string &topic, const std::string &path);
+	void clearRoutes();
+
+	// Called by the broker thread
+	void ingest(const char *topic, const void *payload, int length);
+
+	// Values received since the last call
+	Batch take();
+	bool pending();
+
+	// Messages received, and those that matched no route or had no value at their path
+	uint64_t received() const { return receivedCount; }
+	uint64_t unrouted() const { return unroutedCount; }
+	uint64_t rejected() const { return rejectedCount; }
+
+	// MQTT topic filter matching, with + and # wildcards
+	static bool topicMatches(const char *filter, const char *topic);
+	// Number at path in payload, which is not NUL terminated
+	static bool parseValue(const char *payload, int length, const std::vector<std::string> &path, double &value);
+	static std::vector<std::string> splitPath(const std::string &path);
+
+  private:
+	struct Route
+	{
+		int parameter;
+		std::vector<std::string> path;
+	};
+
+	const std::vector<Route> &resolve(const std::string &topic);
+
+	std::mutex routesLock;
+	std::unordered_map<std::string, std::vector<Route>> routes;
+	std::vector<std::pair<std::string, Route>> wildcards;
+	// Topics resolved against the wildcards, dropped when it grows too large
+	std::unordered_map<std::string, std::vector<Route>> resolved;
+
+	std::mutex batchLock;
+	Batch batch;
+
+	std::atomic<uint64_t> receivedCount { 0 }, unroutedCount { 0 }, rejectedCount { 0 };
+};
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ Copyright(c) 2026
+
+ INDI MQTT Weather Driver - mosquitto broker client
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include "mqtt-mosquitto.h"
+
+MosquittoBroker::MosquittoBroker(const char *clientid)
+{
+	mosquitto_lib_init();
+	mosq = mosquitto_new(clientid, true, this);
+	mosquitto_connect_callback_set(mosq, connectCallback);
+	mosquitto_message_callback_set(mosq, messageCallback);
+	mosquitto_reconnect_delay_set(mosq, 1, 30, true);
+}
+
+MosquittoBroker::~MosquittoBroker()
+{
+	disconnect();
+	mosquitto_destroy(mosq);
+	mosquitto_lib_cleanup();
+}
+
+bool MosquittoBroker::connect(const char *host, int port, const char *user, const char *pass)
+{
+	if (mosq == NULL)
+		return false;
+
+	disconnect();
+
+	mosquitto_username_pw_set(mosq, user, pass);
+	if (mosquitto_connect(mosq, host, port, 60) != MOSQ_ERR_SUCCESS)
+		return false;
+
+	looping = mosquitto_loop_start(mosq) == MOSQ_ERR_SUCCESS;
+	return looping;
+}
+
+void MosquittoBroker::disconnect()
+{
+	if (!looping)
+		return;
+
+	mosquitto_disconnect(mosq);
+	mosquitto_loop_stop(mosq, false);
+	looping = false;
+}
+
+bool MosquittoBroker::subscribe(const char *topic)
+{
+	std::lock_guard<std::mutex> guard(topicsLock);
+	topics.insert(topic);
+	return mosquitto_subscribe(mosq, NULL, topic, 0) == MOSQ_ERR_SUCCESS;
+}
+
+bool MosquittoBroker::unsubscribe(const char *topic)
+{
+	std::lock_guard<std::mutex> guard(topicsLock);
+	topics.erase(topic);
+	return mosquitto_unsubscribe(mosq, NULL, topic) == MOSQ_ERR_SUCCESS;
+}
+
+void MosquittoBroker::connectCallback(struct mosquitto *mosq, void *obj, int rc)
+{
+	MosquittoBroker *broker = static_cast<MosquittoBroker*>(obj);
+
+	if (rc != 0)
+		return;
+
+	// The session is clean, so subscriptions are lost when the network thread reconnects
+	std::lock_guard<std::mutex> guard(broker->topicsLock);
+	for (const std::string &topic : broker->topics)
+		mosquitto_subscribe(mosq, NULL, topic.c_str(), 0);
+}
+
+void MosquittoBroker::messageCallback(struct mosquitto *, void *obj, const struct mosquitto_message *message)
+{
+	MosquittoBroker *broker = static_cast<MosquittoBroker*>(obj);
+
+	if (broker->handler)
+		broker->handler(message->topic, message->payload, message->payloadlen);
+}
@@ -0,0 +1,49 @@
+/*******************************************************************************
+ Copyright(c) 2026
+
+ INDI MQTT Weather Driver - mosquitto broker client
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#pragma once
+
+#include "mqtt-ingest.h"
+
+#include <mosquitto.h>
+#include <set>
+
+// Broker client running the mosquitto network loop in its own thread, which also reconnects
+class MosquittoBroker : public MqttBroker
+{
+  public:
+	explicit MosquittoBroker(const char *clientid);
+	~MosquittoBroker();
+
+	bool connect(const char *host, int port, const char *user, const char *pass) override;
+	void disconnect() override;
+	bool subscribe(const char *topic) override;
+	bool unsubscribe(const char *topic) override;
+
+  private:
+	static void connectCallback(struct mosquitto *, void *obj, int rc);
+	static void messageCallback(struct mosquitto *, void *obj, const struct mosquitto_message *message);
+
+	struct mosquitto *mosq = NULL;
+	bool looping = false;
+	// Subscribed again when the network thread reconnects
+	std::mutex topicsLock;
+	std::set<std::string> topics;
+};
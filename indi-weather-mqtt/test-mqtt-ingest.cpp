@@ -0,0 +1,222 @@
+/*******************************************************************************
+ Copyright(c) 2026
+
+ INDI MQTT Weather Driver - message ingestion tests
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Library General Public
+ License version 2 as published by the Free Software Foundation.
+ .
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Library General Public License for more details.
+ .
+ You should have received a copy of the GNU Library General Public License
+ along with this library; see the file COPYING.LIB.  If not, write to
+ the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ Boston, MA 02110-1301, USA.
+*******************************************************************************/
+
+#include "mqtt-ingest.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+// Delivers messages from its own thread, as the mosquitto network thread does
+class FakeBroker : public MqttBroker
+{
+  public:
+	bool connect(const char *, int, const char *, const char *) override { return true; }
+	void disconnect() override {}
+	bool subscribe(const char *) override { return true; }
+	bool unsubscribe(const char *) override { return true; }
+
+	void deliver(const std::string &topic, const std::string &payload)
+	{
+		// Payloads are not NUL terminated
+		std::vector<char> buffer(payload.begin(), payload.end());
+		buffer.push_back('X');
+		handler(topic.c_str(), buffer.data(), payload.size());
+	}
+
+	// Sends count messages on each topic, topic after topic, with the message number as value
+	std::thread burst(const std::vector<std::string> &topics, int count)
+	{
+		return std::thread([this, topics, count]()
+		{
+			char payload[32];
+			for (int i = 1; i <= count; i++)
+				for (const std::string &topic : topics)
+				{
+					int length = snprintf(payload, sizeof(payload), "%d", i);
+					handler(topic.c_str(), payload, length);
+				}
+		});
+	}
+};
+
+class MqttIngestTest : public ::testing::Test
+{
+  protected:
+	void SetUp() override
+	{
+		broker.setMessageHandler([this](const char *topic, const void *payload, int length)
+		{
+			ingest.ingest(topic, payload, length);
+		});
+	}
+
+	FakeBroker broker;
+	MqttIngest ingest;
+};
+
+static bool parse(const char *payload, const char *path, double &value)
+{
+	return MqttIngest::parseValue(payload, strlen(payload), MqttIngest::splitPath(path), value);
+}
+
+TEST(MqttIngestStatic, TopicMatches)
+{
+	EXPECT_TRUE(MqttIngest::topicMatches("weather/temp", "weather/temp"));
+	EXPECT_FALSE(MqttIngest::topicMatches("weather/temp", "weather/temperature"));
+	EXPECT_FALSE(MqttIngest::topicMatches("weather/temperature", "weather/temp"));
+	EXPECT_FALSE(MqttIngest::topicMatches("weather", "weather/temp"));
+	EXPECT_TRUE(MqttIngest::topicMatches("weather/+/temp", "weather/roof/temp"));
+	EXPECT_FALSE(MqttIngest::topicMatches("weather/+/temp", "weather/roof/wind"));
+	EXPECT_FALSE(MqttIngest::topicMatches("weather/+", "weather/roof/temp"));
+	EXPECT_TRUE(MqttIngest::topicMatches("weather/#", "weather/roof/temp"));
+	EXPECT_TRUE(MqttIngest::topicMatches("weather/#", "weather"));
+	EXPECT_TRUE(MqttIngest::topicMatches("#", "weather/roof"));
+	EXPECT_TRUE(MqttIngest::topicMatches("+/+", "weather/roof"));
+	EXPECT_FALSE(MqttIngest::topicMatches("#", "$SYS/broker/load"));
+	EXPECT_TRUE(MqttIngest::topicMatches("$SYS/#", "$SYS/broker/load"));
+}
+
+TEST(MqttIngestStatic, PlainPayload)
+{
+	double value = 0;
+
+	EXPECT_TRUE(MqttIngest::parseValue("12.5X", 4, {}, value));
+	EXPECT_DOUBLE_EQ(12.5, value);
+	EXPECT_TRUE(parse(" -3e1\n", "", value));
+	EXPECT_DOUBLE_EQ(-30, value);
+	EXPECT_TRUE(parse("\"7\"", "", value));
+	EXPECT_DOUBLE_EQ(7, value);
+	EXPECT_FALSE(parse("cloudy", "", value));
+	EXPECT_FALSE(parse("12 mm", "", value));
+	EXPECT_FALSE(MqttIngest::parseValue("12", 0, {}, value));
+}
+
+TEST(MqttIngestStatic, JsonPayload)
+{
+	const char *json = "{ \"name\": \"roof, \\\"north\\\"\", \"main\": { \"temp\": 21.5, \"rain\": false },"
+	                   " \"sensors\": [ { \"id\": 1, \"value\": 3 }, { \"id\": 2, \"value\": \"4.25\" } ], \"wind\": 12 }";
+	double value = 0;
+
+	EXPECT_TRUE(parse(json, "main.temp", value));
+	EXPECT_DOUBLE_EQ(21.5, value);
+	EXPECT_TRUE(parse(json, "main.rain", value));
+	EXPECT_DOUBLE_EQ(0, value);
+	EXPECT_TRUE(parse(json, "sensors.1.value", value));
+	EXPECT_DOUBLE_EQ(4.25, value);
+	EXPECT_TRUE(parse(json, "wind", value));
+	EXPECT_DOUBLE_EQ(12, value);
+	EXPECT_FALSE(parse(json, "main.humidity", value));
+	EXPECT_FALSE(parse(json, "sensors.2.value", value));
+	EXPECT_FALSE(parse(json, "name", value));
+	EXPECT_FALSE(parse(json, "main", value));
+	EXPECT_FALSE(parse("{ \"main\": { \"temp\": ", "main.temp", value));
+}
+
+TEST_F(MqttIngestTest, Routes)
+{
+	ingest.route(0, "station/temp", "");
+	ingest.route(3, "station/+/json", "wind.speed");
+	ingest.route(4, "station/+/json", "wind.gust");
+	ingest.route(6, "sky/#", "");
+
+	broker.deliver("station/temp", "11.5");
+	broker.deliver("station/roof/json", "{\"wind\":{\"speed\":5,\"gust\":9}}");
+	broker.deliver("sky/clouds", "40");
+	broker.deliver("station/humidity", "80");
+	broker.deliver("sky/clouds", "n/a");
+
+	MqttIngest::Batch batch = ingest.take();
+	ASSERT_EQ(4u, batch.size());
+	EXPECT_DOUBLE_EQ(11.5, batch[0].value);
+	EXPECT_DOUBLE_EQ(5, batch[3].value);
+	EXPECT_DOUBLE_EQ(9, batch[4].value);
+	EXPECT_DOUBLE_EQ(40, batch[6].value);
+	EXPECT_EQ(5u, ingest.received());
+	EXPECT_EQ(1u, ingest.unrouted());
+	EXPECT_EQ(1u, ingest.rejected());
+
+	EXPECT_FALSE(ingest.pending());
+	EXPECT_TRUE(ingest.take().empty());
+
+	ingest.clearRoutes();
+	broker.deliver("station/temp", "11.5");
+	EXPECT_FALSE(ingest.pending());
+}
+
+TEST_F(MqttIngestTest, BurstIsNotDropped)
+{
+	const int count = 20000;
+	const std::vector<std::string> topics =
+	{
+		"station/temperature", "station/humidity", "station/pressure", "station/wind",
+		"station/gust", "station/rain", "sky/clouds", "sky/sqm"
+	};
+
+	for (int i = 0; i < 6; i++)
+		ingest.route(i, topics[i], "");
+	ingest.route(6, "sky/+", "");
+	ingest.route(7, "sky/sqm", "");
+
+	// sky/+ routes sky/sqm to parameter 6 as well
+	unsigned int expected[8] = { count, count, count, count, count, count, 2 * count, count };
+	unsigned int counts[8] = { 0 };
+	double last[8] = { 0 };
+	double worst = 0;
+	int batches = 0;
+
+	MqttIngest::clock::time_point start = MqttIngest::clock::now();
+	std::thread sender = broker.burst(topics, count);
+
+	// The INDI thread takes a batch per update cycle
+	bool done = false;
+	while (!done)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		done = ingest.received() == count * topics.size();
+
+		MqttIngest::clock::time_point now = MqttIngest::clock::now();
+		MqttIngest::Batch batch = ingest.take();
+		for (const auto &entry : batch)
+		{
+			counts[entry.first] += entry.second.count;
+			last[entry.first] = entry.second.value;
+			worst = std::max(worst, std::chrono::duration<double>(now - entry.second.received).count());
+		}
+		batches++;
+	}
+	double elapsed = std::chrono::duration<double>(MqttIngest::clock::now() - start).count();
+	sender.join();
+
+	for (int i = 0; i < 8; i++)
+	{
+		EXPECT_EQ(expected[i], counts[i]) << "parameter " << i;
+		EXPECT_DOUBLE_EQ(count, last[i]) << "parameter " << i;
+	}
+	EXPECT_EQ(0u, ingest.unrouted());
+	EXPECT_EQ(0u, ingest.rejected());
+
+	printf("%d messages in %.1f ms, %d batches, worst latency %.1f ms for a 5 ms cycle\n",
+	       count * (int)topics.size(), elapsed * 1000, batches, worst * 1000);
+	EXPECT_LT(worst, 0.5);
+}
@@ -25,39 +25,21 @@
 #include "indi_weewx_json.h"
 #include "config.h"
 
-#include <curl/curl.h>
-
 #include <memory>
 #include <cstring>
 #include <string>
 
-struct response_t
+// Keys of the "current" object of the report that are mapped to weather parameters
+static const std::set<std::string> currentKeys =
 {
-    char *response;
-    size_t size;
+    "temperature", "dewpoint", "humidity", "heat index", "barometer",
+    "wind speed", "wind gust", "wind direction", "wind chill", "rain rate"
 };
 
-static size_t cb(void *data, size_t size, size_t nmemb, void *userp)
-{
-    size_t realsize        = size * nmemb;
-    struct response_t *mem = (struct response_t *)userp;
-
-    char *ptr = (char *)realloc(mem->response, mem->size + realsize + 1);
-    if (ptr == NULL)
-        return 0; /* out of memory! */
-
-    mem->response = ptr;
-    memcpy(&(mem->response[mem->size]), data, realsize);
-    mem->size += realsize;
-    mem->response[mem->size] = 0;
-
-    return realsize;
-}
-
 // We declare an auto pointer to WeewxJSON.
 std::unique_ptr<WeewxJSON> weewx_json(new WeewxJSON());
 
-WeewxJSON::WeewxJSON()
+WeewxJSON::WeewxJSON() : poller(currentKeys)
 {
     setVersion(WEEWX_VERSION_MAJOR, WEEWX_VERSION_MINOR);
 
@@ -73,14 +55,28 @@ const char *WeewxJSON::getDefaultName()
 
 bool WeewxJSON::Connect()
 {
+    hasReport = false;
+    poller.setUrl(weewxJsonUrl[WEEWX_URL].getText() != nullptr ? weewxJsonUrl[WEEWX_URL].getText() : "");
+    poller.start(updatePeriod());
     return true;
 }
 
 bool WeewxJSON::Disconnect()
 {
+    poller.stop();
     return true;
 }
 
+std::chrono::milliseconds WeewxJSON::updatePeriod() const
+{
+    double seconds = UpdatePeriodNP[0].getValue();
+
+    // Updates may be disabled, the report is still kept fresh
+    if (seconds <= 0)
+        seconds = 60;
+    return std::chrono::milliseconds(static_cast<long>(seconds * 1000));
+}
+
 bool WeewxJSON::initProperties()
 {
     INDI::Weather::initProperties();
@@ -148,6 +144,8 @@ bool WeewxJSON::ISNewText(const char *dev, const char *name, char *texts[], char
             weewxJsonUrl.update(texts, names, n);
             weewxJsonUrl.setState(IPS_OK);
             weewxJsonUrl.apply();
+            poller.setUrl(weewxJsonUrl[WEEWX_URL].getText() != nullptr ? weewxJsonUrl[WEEWX_URL].getText() : "");
+            poller.trigger();
             return true;
         }
     }
@@ -155,13 +153,10 @@ bool WeewxJSON::ISNewText(const char *dev, const char *name, char *texts[], char
     return INDI::Weather::ISNewText(dev, name, texts, names, n);
 }
 
-void WeewxJSON::handleTemperatureData(json value, std::string key)
+void WeewxJSON::handleTemperatureData(const WeewxObservation &value, std::string key)
 {
-    double temperatureValue = 0.0;
-    std::string units;
-
-    value["value"].get_to(temperatureValue);
-    value["units"].get_to(units);
+    double temperatureValue = value.value;
+    const std::string &units = value.units;
 
     if (strcmp(units.c_str(), "°F") == 0)
     {
@@ -171,22 +166,17 @@ void WeewxJSON::handleTemperatureData(json value, std::string key)
     setParameterValue(key, temperatureValue);
 }
 
-void WeewxJSON::handleRawData(json value, std::string key)
+void WeewxJSON::handleRawData(const WeewxObservation &value, std::string key)
 {
-    double rawValue = 0.0;
-
-    value["value"].get_to(rawValue);
+    double rawValue = value.value;
 
     setParameterValue(key, rawValue);
 }
 
-void WeewxJSON::handleBarometerData(json value, std::string key)
+void WeewxJSON::handleBarometerData(const WeewxObservation &value, std::string key)
 {
-    double pressureValue = 0.0;
-    std::string units;
-
-    value["value"].get_to(pressureValue);
-    value["units"].get_to(units);
+    double pressureValue = value.value;
+    const std::string &units = value.units;
 
     if (strcmp(units.c_str(), "inHg") == 0)
     {
@@ -196,13 +186,10 @@ void WeewxJSON::handleBarometerData(json value, std::string key)
     setParameterValue(key, pressureValue);
 }
 
-void WeewxJSON::handleWindSpeedData(json value, std::string key)
+void WeewxJSON::handleWindSpeedData(const WeewxObservation &value, std::string key)
 {
-    double speedValue = 0.0;
-    std::string units;
-
-    value["value"].get_to(speedValue);
-    value["units"].get_to(units);
+    double speedValue = value.value;
+    const std::string &units = value.units;
 
     if (strcmp(units.c_str(), "mph") == 0)
     {
@@ -212,13 +199,10 @@ void WeewxJSON::handleWindSpeedData(json value, std::string key)
     setParameterValue(key, speedValue);
 }
 
-void WeewxJSON::handleRainRateData(json value, std::string key)
+void WeewxJSON::handleRainRateData(const WeewxObservation &value, std::string key)
 {
-    double rainRate = 0.0;
-    std::string units;
-
-    value["value"].get_to(rainRate);
-    value["units"].get_to(units);
+    double rainRate = value.value;
+    const std::string &units = value.units;
 
     if (strcmp(units.c_str(), "in/hr") == 0)
     {
@@ -228,28 +212,30 @@ void WeewxJSON::handleRainRateData(json value, std::string key)
     setParameterValue(key, rainRate);
 }
 
-void WeewxJSON::handleWeatherData(json value)
+void WeewxJSON::handleWeatherData(const WeewxCurrent &current)
 {
-    if (value.contains("temperature"))
-        handleTemperatureData(value["temperature"], "WEATHER_TEMPERATURE");
-    if (value.contains("dewpoint"))
-        handleTemperatureData(value["dewpoint"], "WEATHER_DEW_POINT");
-    if (value.contains("humidity"))
-        handleRawData(value["humidity"], "WEATHER_HUMIDITY");
-    if (value.contains("heat index"))
-        handleTemperatureData(value["heat index"], "WEATHER_HEAT_INDEX");
-    if (value.contains("barometer"))
-        handleBarometerData(value["barometer"], "WEATHER_BAROMETER");
-    if (value.contains("wind speed"))
-        handleWindSpeedData(value["wind speed"], "WEATHER_WIND_SPEED");
-    if (value.contains("wind gust"))
-        handleWindSpeedData(value["wind gust"], "WEATHER_WIND_GUST");
-    if (value.contains("wind direction"))
-        handleRawData(value["wind direction"], "WEATHER_WIND_DIRECTION");
-    if (value.contains("wind chill"))
-        handleTemperatureData(value["wind chill"], "WEATHER_WIND_CHILL");
-    if (value.contains("rain rate"))
-        handleRainRateData(value["rain rate"], "WEATHER_RAIN_RATE");
+    WeewxCurrent::const_iterator value;
+
+    if ((value = current.find("temperature")) != current.end())
+        handleTemperatureData(value->second, "WEATHER_TEMPERATURE");
+    if ((value = current.find("dewpoint")) != current.end())
+        handleTemperatureData(value->second, "WEATHER_DEW_POINT");
+    if ((value = current.find("humidity")) != current.end())
+        handleRawData(value->second, "WEATHER_HUMIDITY");
+    if ((value = current.find("heat index")) != current.end())
+        handleTemperatureData(value->second, "WEATHER_HEAT_INDEX");
+    if ((value = current.find("barometer")) != current.end())
+        handleBarometerData(value->second, "WEATHER_BAROMETER");
+    if ((value = current.find("wind speed")) != current.end())
+        handleWindSpeedData(value->second, "WEATHER_WIND_SPEED");
+    if ((value = current.find("wind gust")) != current.end())
+        handleWindSpeedData(value->second, "WEATHER_WIND_GUST");
+    if ((value = current.find("wind direction")) != current.end())
+        handleRawData(value->second, "WEATHER_WIND_DIRECTION");
+    if ((value = current.find("wind chill")) != current.end())
+        handleTemperatureData(value->second, "WEATHER_WIND_CHILL");
+    if ((value = current.find("rain rate")) != current.end())
+        handleRainRateData(value->second, "WEATHER_RAIN_RATE");
 }
 
 IPState WeewxJSON::updateWeather()
@@ -257,49 +243,43 @@ IPState WeewxJSON::updateWeather()
     if (isDebug())
         IDLog("%s: updateWeather()\n", getDeviceName());
 
-    CURL *curl;
-    CURLcode res;
-
-    curl = curl_easy_init();
-    if (curl)
-    {
-        struct response_t chunk = { .response = nullptr, .size = 0 };
+    WeewxPoller::Result result;
 
-        curl_easy_setopt(curl, CURLOPT_URL, weewxJsonUrl[WEEWX_URL].text);
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, cb);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &chunk);
+    poller.setPeriod(updatePeriod());
 
-        res = curl_easy_perform(curl);
-        curl_easy_cleanup(curl);
-
-        if (res == CURLcode::CURLE_OK)
+    if (!poller.take(result))
+    {
+        if (!hasReport)
         {
-            nlohmann::json report = nlohmann::json::parse(chunk.response);
-
-            if (report.contains("current"))
-            {
-                handleWeatherData(report["current"]);
-            }
-            else
-            {
-                LOG_ERROR("No current weather data found in report.");
-                return IPS_ALERT;
-            }
-
-            return IPS_OK;
+            // The first report is still being fetched
+            return IPS_BUSY;
         }
-        else
+
+        if (std::chrono::steady_clock::now() - lastReport > 3 * updatePeriod())
         {
-            LOGF_ERROR("HTTP request to %s failed.", weewxJsonUrl[WEEWX_URL].text);
+            LOGF_ERROR("No report received from %s recently.", weewxJsonUrl[WEEWX_URL].getText());
             return IPS_ALERT;
         }
+
+        return IPS_OK;
     }
-    else
+
+    if (!result.ok)
     {
-        LOGF_ERROR("Cannot initialize CURL, connection to HTTP server %s failed.", weewxJsonUrl[WEEWX_URL].text);
+        LOGF_ERROR("HTTP request to %s failed: %s.", weewxJsonUrl[WEEWX_URL].getText(), result.error.c_str());
         return IPS_ALERT;
     }
 
+    hasReport  = true;
+    lastReport = result.time;
+
+    if (result.modified)
+        handleWeatherData(result.current);
+    else
+        LOG_DEBUG("Report not modified since last update.");
+
+    LOGF_DEBUG("Report polled in %.3f s, %ld new connection(s).", result.seconds, result.connects);
+
     return IPS_OK;
 }
 
@@ -27,13 +27,8 @@
 
 #include <libindi/indiweather.h>
 #include <libindi/indipropertytext.h>
-#ifdef _USE_SYSTEM_JSONLIB
-#include <nlohmann/json.hpp>
-#else
-#include <indijson.hpp>
-#endif
 
-using json = nlohmann::json;
+#include "weewx_poller.h"
 
 class WeewxJSON : public INDI::Weather
 {
@@ -52,12 +47,12 @@ class WeewxJSON : public INDI::Weather
     virtual bool ISNewText(const char *dev, const char *name, char *texts[], char *names[], int n) override;
 
   protected:
-    void handleTemperatureData(json value, std::string key);
-    void handleRawData(json value, std::string key);
-    void handleBarometerData(json value, std::string key);
-    void handleWindSpeedData(json value, std::string key);
-    void handleRainRateData(json value, std::string key);
-    void handleWeatherData(json value);
+    void handleTemperatureData(const WeewxObservation &value, std::string key);
+    void handleRawData(const WeewxObservation &value, std::string key);
+    void handleBarometerData(const WeewxObservation &value, std::string key);
+    void handleWindSpeedData(const WeewxObservation &value, std::string key);
+    void handleRainRateData(const WeewxObservation &value, std::string key);
+    void handleWeatherData(const WeewxCurrent &current);
 
     virtual IPState updateWeather() override;
 
@@ -69,4 +64,10 @@ class WeewxJSON : public INDI::Weather
     {
         WEEWX_URL,
     };
+
+    // Fetches the report in the background, updateWeather() takes the last one
+    WeewxPoller poller;
+    bool hasReport { false };
+    std::chrono::steady_clock::time_point lastReport;
+    std::chrono::milliseconds updatePeriod() const;
 };
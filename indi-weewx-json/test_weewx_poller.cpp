@@ -0,0 +1,366 @@
+/*******************************************************************************
+
+  Copyright(c) 2026
+
+  INDI WeeWx JSON Weather Driver - report polling tests
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include "weewx_poller.h"
+
+#include <gtest/gtest.h>
+#include <httplib.h>
+#include <curl/curl.h>
+
+#ifdef _USE_SYSTEM_JSONLIB
+#include <nlohmann/json.hpp>
+#else
+#include <indijson.hpp>
+#endif
+
+#include <atomic>
+#include <ctime>
+
+static const std::set<std::string> keys =
+{
+    "temperature", "dewpoint", "humidity", "heat index", "barometer",
+    "wind speed", "wind gust", "wind direction", "wind chill", "rain rate"
+};
+
+// A report as written by the weewx JSON skins, with the current conditions followed by a day of history
+static std::string makeReport(int version, int history)
+{
+    char current[1024];
+    std::string report;
+
+    snprintf(current, sizeof(current),
+             "{\"station\": {\"location\": \"Test\", \"latitude\": 45.0, \"longitude\": -93.0, \"altitude (meters)\": 300},"
+             " \"generation\": {\"time\": \"Sun, 18 Oct 2026 20:00:00 GMT\", \"generator\": \"weewx 4.10\"},"
+             " \"current\": {"
+             "\"temperature\": {\"value\": %d.0, \"units\": \"°F\"},"
+             " \"dewpoint\": {\"value\": 41.2, \"units\": \"°F\"},"
+             " \"humidity\": {\"value\": 81, \"units\": \"%%\"},"
+             " \"heat index\": {\"value\": 50.0, \"units\": \"°F\"},"
+             " \"barometer\": {\"value\": \"29.920\", \"units\": \"inHg\"},"
+             " \"wind speed\": {\"value\": 5.0, \"units\": \"mph\"},"
+             " \"wind gust\": {\"value\": 9.0, \"units\": \"mph\"},"
+             " \"wind direction\": {\"value\": 270, \"units\": \"°\"},"
+             " \"wind chill\": {\"value\": 48.5, \"units\": \"°F\"},"
+             " \"rain rate\": {\"value\": 0.01, \"units\": \"in/hr\"},"
+             " \"UV\": {\"value\": null, \"units\": \"\"},"
+             " \"insideTemp\": {\"value\": 68.4, \"units\": \"°F\"}},",
+             50 + version);
+    report = current;
+
+    report += " \"day\": [";
+    for (int i = 0; i < history; i++)
+    {
+        char entry[256];
+        snprintf(entry, sizeof(entry),
+                 "%s{\"time\": %d, \"outTemp\": {\"value\": %.1f, \"units\": \"°F\"}, \"barometer\": {\"value\": %.3f, \"units\": \"inHg\"}}",
+                 i > 0 ? ", " : "", 1792000000 + i * 300, 40.0 + (i % 100) * 0.1, 29.5 + (i % 50) * 0.01);
+        report += entry;
+    }
+    report += "]}";
+    return report;
+}
+
+class ReportServer
+{
+    public:
+        explicit ReportServer(int history) : history(history)
+        {
+            server.set_keep_alive_max_count(100000);
+            server.Get("/weewx.json", [this](const httplib::Request &request, httplib::Response &response)
+            {
+                std::string etag = "\"report-" + std::to_string(version.load()) + "\"";
+
+                requests++;
+                response.set_header("ETag", etag);
+                response.set_header("Last-Modified", "Sun, 18 Oct 2026 20:00:00 GMT");
+                if (request.get_header_value("If-None-Match") == etag)
+                {
+                    response.status = 304;
+                    return;
+                }
+                response.set_content(makeReport(version, this->history), "application/json");
+                bodies++;
+            });
+            port = server.bind_to_any_port("127.0.0.1");
+            thread = std::thread([this]()
+            {
+                server.listen_after_bind();
+            });
+            while (!server.is_running())
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        ~ReportServer()
+        {
+            server.stop();
+            thread.join();
+        }
+
+        std::string url() const
+        {
+            return "http://127.0.0.1:" + std::to_string(port) + "/weewx.json";
+        }
+
+        std::atomic<int> version { 0 };
+        std::atomic<int> requests { 0 };
+        std::atomic<int> bodies { 0 };
+
+    private:
+        httplib::Server server;
+        std::thread thread;
+        int port = 0;
+        int history;
+};
+
+TEST(WeewxParse, ReadsMappedKeysOfCurrent)
+{
+    std::string report = makeReport(0, 10);
+    WeewxCurrent current;
+
+    ASSERT_TRUE(weewx_parse_current(report.data(), report.size(), keys, current));
+    EXPECT_EQ(current.size(), keys.size());
+    EXPECT_DOUBLE_EQ(current["temperature"].value, 50.0);
+    EXPECT_EQ(current["temperature"].units, "°F");
+    EXPECT_DOUBLE_EQ(current["humidity"].value, 81);
+    // Formatted as a string by some skins
+    EXPECT_DOUBLE_EQ(current["barometer"].value, 29.92);
+    EXPECT_EQ(current["barometer"].units, "inHg");
+    EXPECT_DOUBLE_EQ(current["rain rate"].value, 0.01);
+    EXPECT_EQ(current.count("insideTemp"), 0u);
+}
+
+TEST(WeewxParse, StopsAtEndOfCurrent)
+{
+    // What follows "current" is never read, even if it is truncated
+    std::string report = makeReport(0, 10000);
+    report.resize(report.size() / 2);
+    WeewxCurrent current;
+
+    ASSERT_TRUE(weewx_parse_current(report.data(), report.size(), keys, current));
+    EXPECT_EQ(current.size(), keys.size());
+}
+
+TEST(WeewxParse, RejectsReportWithoutCurrent)
+{
+    const std::string reports[] =
+    {
+        "{\"station\": {\"location\": \"Test\"}, \"day\": [{\"current\": {}}]}",
+        "{\"current\": {\"temperature\": {\"value\": 1",
+        "<html>Not Found</html>"
+    };
+
+    for (const std::string &report : reports)
+    {
+        WeewxCurrent current;
+        EXPECT_FALSE(weewx_parse_current(report.data(), report.size(), keys, current)) << report;
+    }
+}
+
+TEST(WeewxPoller, ConditionalRequestsOnOneConnection)
+{
+    ReportServer server(1000);
+    WeewxPoller poller(keys);
+
+    poller.setUrl(server.url());
+
+    WeewxPoller::Result result = poller.poll();
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_TRUE(result.modified);
+    EXPECT_EQ(result.httpCode, 200);
+    EXPECT_EQ(result.connects, 1);
+    EXPECT_DOUBLE_EQ(result.current["temperature"].value, 50.0);
+
+    // Unchanged, answered without a body, on the same connection
+    result = poller.poll();
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_FALSE(result.modified);
+    EXPECT_EQ(result.httpCode, 304);
+    EXPECT_EQ(result.connects, 0);
+    EXPECT_TRUE(result.current.empty());
+
+    server.version = 1;
+    result = poller.poll();
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_TRUE(result.modified);
+    EXPECT_EQ(result.connects, 0);
+    EXPECT_DOUBLE_EQ(result.current["temperature"].value, 51.0);
+
+    EXPECT_EQ(server.requests, 3);
+    EXPECT_EQ(server.bodies, 2);
+
+    // A new URL is fetched in full
+    poller.setUrl(server.url() + "?station=2");
+    result = poller.poll();
+    EXPECT_TRUE(result.modified);
+    EXPECT_EQ(server.bodies, 3);
+}
+
+TEST(WeewxPoller, ReportsFailures)
+{
+    ReportServer server(10);
+    WeewxPoller poller(keys);
+
+    poller.setUrl(server.url() + ".missing");
+    WeewxPoller::Result result = poller.poll();
+    EXPECT_FALSE(result.ok);
+    EXPECT_EQ(result.httpCode, 404);
+
+    // Nothing listens on the discard port
+    poller.setUrl("http://127.0.0.1:9/weewx.json");
+    result = poller.poll();
+    EXPECT_FALSE(result.ok);
+    EXPECT_FALSE(result.error.empty());
+}
+
+// Waits for condition to hold, the bound is only there so that a broken poller fails instead of hanging
+template <typename Condition>
+static bool waitFor(Condition condition)
+{
+    for (int i = 0; i < 2000; i++)
+    {
+        if (condition())
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return false;
+}
+
+TEST(WeewxPoller, WorkerPollsPeriodically)
+{
+    ReportServer server(100);
+    WeewxPoller poller(keys);
+    WeewxPoller::Result result;
+    auto taken = [&]()
+    {
+        return poller.take(result);
+    };
+
+    poller.setUrl(server.url());
+
+    // Long period, the first poll as soon as started and then only a trigger polls
+    poller.start(std::chrono::seconds(60));
+    ASSERT_TRUE(waitFor(taken));
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_TRUE(result.modified);
+    EXPECT_EQ(server.requests, 1);
+
+    poller.trigger();
+    ASSERT_TRUE(waitFor(taken));
+    EXPECT_EQ(server.requests, 2);
+    EXPECT_TRUE(result.ok);
+    EXPECT_FALSE(result.modified);
+
+    // A shorter period applies at once. The modified report of the first poll after the change is kept until taken,
+    // whatever is polled after it: once a fifth request is received, the fourth poll is over.
+    server.version = 1;
+    poller.setPeriod(std::chrono::milliseconds(10));
+    ASSERT_TRUE(waitFor([&]()
+    {
+        return server.requests >= 5;
+    }));
+    ASSERT_TRUE(poller.take(result));
+    EXPECT_TRUE(result.modified);
+    EXPECT_DOUBLE_EQ(result.current["temperature"].value, 51.0);
+
+    // Nothing comes after stop()
+    poller.stop();
+    poller.take(result);
+    EXPECT_FALSE(poller.take(result));
+}
+
+static double threadSeconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static size_t appendBody(void *data, size_t size, size_t nmemb, void *userp)
+{
+    static_cast<std::string *>(userp)->append(static_cast<const char *>(data), size * nmemb);
+    return size * nmemb;
+}
+
+// What the driver did before: a new handle and connection, the whole report, parsed into a document
+static bool legacyPoll(const std::string &url, double &temperature)
+{
+    std::string body;
+    CURL *curl = curl_easy_init();
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, appendBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &body);
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_cleanup(curl);
+    if (res != CURLE_OK)
+        return false;
+
+    nlohmann::json report = nlohmann::json::parse(body);
+    if (!report.contains("current"))
+        return false;
+    report["current"]["temperature"]["value"].get_to(temperature);
+    return true;
+}
+
+TEST(WeewxPoller, CostPerPoll)
+{
+    // About 500 kB, a report with a day of history at 5 minutes is larger still
+    const int polls = 50;
+    ReportServer server(5000);
+    WeewxPoller poller(keys);
+
+    poller.setUrl(server.url());
+
+    double cpu = threadSeconds();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < polls; i++)
+    {
+        double temperature = 0;
+        ASSERT_TRUE(legacyPoll(server.url(), temperature));
+        ASSERT_DOUBLE_EQ(temperature, 50.0);
+    }
+    double legacyCpu = (threadSeconds() - cpu) / polls;
+    double legacyLatency = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / polls;
+
+    cpu = threadSeconds();
+    start = std::chrono::steady_clock::now();
+    long connects = 0;
+    for (int i = 0; i < polls; i++)
+    {
+        // The report changes every tenth poll
+        if (i % 10 == 9)
+            server.version++;
+        WeewxPoller::Result result = poller.poll();
+        ASSERT_TRUE(result.ok) << result.error;
+        connects += result.connects;
+    }
+    double newCpu = (threadSeconds() - cpu) / polls;
+    double newLatency = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / polls;
+
+    printf("Per poll of a %zu byte report: legacy %.3f ms CPU, %.3f ms latency; conditional %.3f ms CPU, %.3f ms latency, %ld connection(s)\n",
+           makeReport(0, 5000).size(), legacyCpu * 1000, legacyLatency * 1000, newCpu * 1000, newLatency * 1000, connects);
+
+    EXPECT_EQ(connects, 1);
+    EXPECT_LT(newCpu, legacyCpu);
+}
@@ -0,0 +1,404 @@
+/*******************************************************************************
+
+  Copyright(c) 2026
+
+  INDI WeeWx JSON Weather Driver - report polling
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#include "weewx_poller.h"
+
+#include <curl/curl.h>
+
+#ifdef _USE_SYSTEM_JSONLIB
+#include <nlohmann/json.hpp>
+#else
+#include <indijson.hpp>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+
+namespace
+{
+
+// SAX handler keeping the observations of "current", and stopping at its end
+class CurrentHandler
+{
+    public:
+        CurrentHandler(const std::set<std::string> &keys, WeewxCurrent &current) : keys(keys), current(current) {}
+
+        bool found = false;
+        bool done = false;
+
+        bool null()
+        {
+            return true;
+        }
+        bool boolean(bool)
+        {
+            return true;
+        }
+        bool number_integer(nlohmann::json::number_integer_t value)
+        {
+            return number(static_cast<double>(value));
+        }
+        bool number_unsigned(nlohmann::json::number_unsigned_t value)
+        {
+            return number(static_cast<double>(value));
+        }
+        bool number_float(nlohmann::json::number_float_t value, const nlohmann::json::string_t &)
+        {
+            return number(value);
+        }
+        bool string(nlohmann::json::string_t &value)
+        {
+            if (depth == 3 && wanted)
+            {
+                if (member == "units")
+                    units = value;
+                else if (member == "value")
+                {
+                    // Some skins format the value as a string
+                    char *end;
+                    double number = strtod(value.c_str(), &end);
+                    if (end != value.c_str())
+                        return this->number(number);
+                }
+            }
+            return true;
+        }
+        bool binary(nlohmann::json::binary_t &)
+        {
+            return true;
+        }
+        bool start_object(std::size_t)
+        {
+            depth++;
+            if (depth == 2 && member == "current")
+                found = true;
+            else if (depth == 3 && found)
+            {
+                wanted = keys.count(member) > 0;
+                hasValue = false;
+                value = 0.0;
+                units.clear();
+            }
+            member.clear();
+            return true;
+        }
+        bool end_object()
+        {
+            if (depth == 3 && found && wanted && hasValue)
+            {
+                WeewxObservation &entry = current[name];
+                entry.value = value;
+                entry.units = units;
+            }
+            if (depth == 2 && found)
+            {
+                // Nothing else is needed from the report
+                done = true;
+                return false;
+            }
+            depth--;
+            return true;
+        }
+        bool start_array(std::size_t)
+        {
+            depth++;
+            member.clear();
+            return true;
+        }
+        bool end_array()
+        {
+            depth--;
+            return true;
+        }
+        bool key(nlohmann::json::string_t &value)
+        {
+            member = value;
+            // Remember which observation is being read, member is reused for its members
+            if (depth == 2 && found)
+                name = value;
+            return true;
+        }
+        bool parse_error(std::size_t, const std::string &, const nlohmann::json::exception &)
+        {
+            return false;
+        }
+
+    private:
+        bool number(double number)
+        {
+            if (depth == 3 && wanted && member == "value")
+            {
+                value = number;
+                hasValue = true;
+            }
+            return true;
+        }
+
+        const std::set<std::string> &keys;
+        WeewxCurrent &current;
+        int depth = 0;
+        // Last member name seen
+        std::string member;
+        std::string name, units;
+        bool wanted = false;
+        double value = 0.0;
+        bool hasValue = false;
+};
+
+// Header value if line is "name: value", without the line end
+bool headerValue(const char *line, size_t size, const char *name, std::string &value)
+{
+    size_t length = strlen(name);
+
+    if (size <= length || strncasecmp(line, name, length) != 0 || line[length] != ':')
+        return false;
+
+    const char *start = line + length + 1;
+    const char *end = line + size;
+    while (start < end && (*start == ' ' || *start == '\t'))
+        start++;
+    while (end > start && (end[-1] == '\r' || end[-1] == '\n' || end[-1] == ' '))
+        end--;
+    value.assign(start, end);
+    return true;
+}
+
+}
+
+bool weewx_parse_current(const char *report, size_t size, const std::set<std::string> &keys, WeewxCurrent &current)
+{
+    CurrentHandler handler(keys, current);
+
+    current.clear();
+    nlohmann::json::sax_parse(report, report + size, &handler);
+    return handler.done;
+}
+
+WeewxPoller::WeewxPoller(const std::set<std::string> &keys) : keys(keys)
+{
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+}
+
+WeewxPoller::~WeewxPoller()
+{
+    stop();
+    if (curl != nullptr)
+        curl_easy_cleanup(curl);
+    curl_global_cleanup();
+}
+
+void WeewxPoller::setUrl(const std::string &newUrl)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (url == newUrl)
+        return;
+    url = newUrl;
+
+    std::lock_guard<std::mutex> curlGuard(curlLock);
+    etag.clear();
+    lastModified.clear();
+}
+
+size_t WeewxPoller::writeCallback(void *data, size_t size, size_t nmemb, void *userp)
+{
+    WeewxPoller *poller = static_cast<WeewxPoller *>(userp);
+    poller->body.append(static_cast<const char *>(data), size * nmemb);
+    return size * nmemb;
+}
+
+size_t WeewxPoller::headerCallback(char *data, size_t size, size_t nitems, void *userp)
+{
+    WeewxPoller *poller = static_cast<WeewxPoller *>(userp);
+    size_t length = size * nitems;
+
+    // Headers of each response, the validators are only kept if the report is read
+    if (!headerValue(data, length, "ETag", poller->newEtag))
+        headerValue(data, length, "Last-Modified", poller->newLastModified);
+    return length;
+}
+
+WeewxPoller::Result WeewxPoller::poll()
+{
+    Result result;
+    std::string target;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        target = url;
+    }
+
+    std::lock_guard<std::mutex> curlGuard(curlLock);
+    result.time = std::chrono::steady_clock::now();
+
+    if (curl == nullptr)
+    {
+        curl = curl_easy_init();
+        if (curl == nullptr)
+        {
+            result.error = "Cannot initialize CURL";
+            return result;
+        }
+
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, headerCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, this);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        // Any compression curl supports, reports compress well
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+    }
+
+    struct curl_slist *headers = nullptr;
+    if (!etag.empty())
+        headers = curl_slist_append(headers, ("If-None-Match: " + etag).c_str());
+    if (!lastModified.empty())
+        headers = curl_slist_append(headers, ("If-Modified-Since: " + lastModified).c_str());
+
+    curl_easy_setopt(curl, CURLOPT_URL, target.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    body.clear();
+    newEtag.clear();
+    newLastModified.clear();
+
+    CURLcode res = curl_easy_perform(curl);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, nullptr);
+    curl_slist_free_all(headers);
+
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &result.httpCode);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME, &result.seconds);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &result.connects);
+
+    if (res != CURLE_OK)
+    {
+        result.error = curl_easy_strerror(res);
+        return result;
+    }
+
+    if (result.httpCode == 304)
+    {
+        result.ok = true;
+        return result;
+    }
+
+    if (result.httpCode != 200)
+    {
+        result.error = "HTTP status " + std::to_string(result.httpCode);
+        return result;
+    }
+
+    if (!weewx_parse_current(body.data(), body.size(), keys, result.current))
+    {
+        result.error = "No current weather data found in report";
+        return result;
+    }
+
+    etag = newEtag;
+    lastModified = newLastModified;
+    result.ok = true;
+    result.modified = true;
+    return result;
+}
+
+void WeewxPoller::start(std::chrono::milliseconds newPeriod)
+{
+    stop();
+
+    std::lock_guard<std::mutex> guard(lock);
+    period = newPeriod;
+    running = true;
+    triggered = true;
+    hasResult = false;
+    worker = std::thread(&WeewxPoller::run, this);
+}
+
+void WeewxPoller::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        running = false;
+        wake.notify_all();
+    }
+    if (worker.joinable())
+        worker.join();
+}
+
+void WeewxPoller::setPeriod(std::chrono::milliseconds newPeriod)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (period == newPeriod)
+        return;
+    period = newPeriod;
+    wake.notify_all();
+}
+
+void WeewxPoller::trigger()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    triggered = true;
+    wake.notify_all();
+}
+
+bool WeewxPoller::take(Result &taken)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (!hasResult)
+        return false;
+    taken = std::move(result);
+    hasResult = false;
+    return true;
+}
+
+void WeewxPoller::run()
+{
+    std::unique_lock<std::mutex> guard(lock);
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+
+    while (running)
+    {
+        // The period may change while waiting
+        if (!triggered && std::chrono::steady_clock::now() < last + period)
+        {
+            wake.wait_until(guard, last + period);
+            continue;
+        }
+        triggered = false;
+
+        guard.unlock();
+        Result polled = poll();
+        guard.lock();
+
+        last = polled.time;
+
+        // Only a newer report replaces one the driver did not take yet, else its values would never be applied
+        if (!hasResult || !result.modified || polled.modified)
+            result = std::move(polled);
+        hasResult = true;
+    }
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+
+  Copyright(c) 2026
+
+  INDI WeeWx JSON Weather Driver - report polling
+
+  This program is free software; you can redistribute it and/or modify it
+  under the terms of the GNU General Public License as published by the Free
+  Software Foundation; either version 2 of the License, or (at your option)
+  any later version.
+
+  This program is distributed in the hope that it will be useful, but WITHOUT
+  ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+  FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+  more details.
+
+  You should have received a copy of the GNU Library General Public License
+  along with this library; see the file COPYING.LIB.  If not, write to
+  the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+  Boston, MA 02110-1301, USA.
+
+  The full GNU General Public License is included in this distribution in the
+  file called LICENSE.
+*******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+typedef void CURL;
+
+struct WeewxObservation
+{
+    double value = 0.0;
+    std::string units;
+};
+
+// Observations of the "current" object of a report, by key
+typedef std::map<std::string, WeewxObservation> WeewxCurrent;
+
+/*
+ * Reads the members of the top level "current" object that are in keys, without building a document.
+ * Parsing stops at the end of "current". Observations without a numeric value are left out.
+ * Returns false if the report has no "current" object.
+ */
+bool weewx_parse_current(const char *report, size_t size, const std::set<std::string> &keys, WeewxCurrent &current);
+
+/*
+ * Fetches the weewx report.
+ *
+ * A single curl handle is kept, so the connection to the server and the TLS session are reused from one poll to the
+ * next. The ETag and Last-Modified of the last report are sent back, and an unchanged report is answered by the
+ * server with 304 Not Modified, without a body to transfer and parse.
+ *
+ * poll() fetches on the calling thread. Once started, a worker thread polls periodically, and the driver takes the
+ * last result.
+ */
+class WeewxPoller
+{
+    public:
+        struct Result
+        {
+            bool ok = false;
+            // False when the report is the same as the previous one, current is then empty
+            bool modified = false;
+            long httpCode = 0;
+            std::string error;
+            WeewxCurrent current;
+            std::chrono::steady_clock::time_point time;
+            // Transfer time and connections opened for this poll
+            double seconds = 0.0;
+            long connects = 0;
+        };
+
+        explicit WeewxPoller(const std::set<std::string> &keys);
+        ~WeewxPoller();
+
+        // Forgets the validators of the previous report
+        void setUrl(const std::string &url);
+
+        Result poll();
+
+        void start(std::chrono::milliseconds period);
+        void stop();
+        void setPeriod(std::chrono::milliseconds period);
+        // Polls now instead of waiting for the end of the period
+        void trigger();
+        // The last result of the worker, false if there is none since the last call
+        bool take(Result &result);
+
+    private:
+        static size_t writeCallback(void *data, size_t size, size_t nmemb, void *userp);
+        static size_t headerCallback(char *data, size_t size, size_t nitems, void *userp);
+        void run();
+
+        std::set<std::string> keys;
+
+        // Only used by one thread at a time
+        std::mutex curlLock;
+        CURL *curl = nullptr;
+        std::string body;
+        std::string etag, lastModified, newEtag, newLastModified;
+
+        std::mutex lock;
+        std::condition_variable wake;
+        std::thread worker;
+        bool running = false;
+        bool triggered = false;
+        std::string url;
+        std::chrono::milliseconds period { 60000 };
+        bool hasResult = false;
+        Result result;
+};
@@ -34,6 +34,7 @@ POSSIBILITY OF SUCH DAMAGE.
 */
 
 #include "fishcamp.h"
+#include "fishcamp_image.h"
 #include "indimacros.h"
 
 #include <errno.h>
@@ -93,6 +94,9 @@ SInt32 gProBlackColOffsets[4096]; // offsets.  one for each column
 SInt32 gProBlackRowOffsets[4096]; // offsets.  one for each row
 bool gProWantColNormalization;    // true if we want column normalization
 
+// row caches of the normalization and filtering done on every frame read
+fcImage_pipeline gImagePipeline;
+
 //CCyUSBDevice*		gUSBDevice;
 
 bool gDoLogging;    // set to TRUE to enable logging to the log file
@@ -1039,213 +1043,6 @@ UInt16 fcUsb_GetUsbCmdCksum(UInt16 *cmdParams)
     return theCksum;
 }
 
-// helper routine for fcImage_doFullFrameRowLevelNormalization.
-// will calculate the average level of the pixels in the
-// black cols of the image sensor
-//
-float fcImage_calcFullFrameAllColAvg(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
-{
-    float floatPixel;
-    float retValue;
-    int row, col;
-    //bool evenRow;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-
-    retValue = 0.0;
-
-    // we will average all of the pixels in cols 0 -> 14
-    for (row = 0; row < imageHeight; row++)
-    {
-        inputPtr = frameBufferPtr;
-        inputPtr = inputPtr + (row * imageWidth);
-
-        for (col = 0; col < 14; col++)
-        {
-            // get the next pixel
-            aPixel = *inputPtr++;
-
-            floatPixel = (float)aPixel;
-            retValue += floatPixel;
-        }
-    }
-
-    //divide by the number of pixels in the black col
-    retValue = retValue / (14.0 * (float)imageHeight);
-
-    return retValue;
-}
-
-// helper routine for fcImage_doFullFrameRowLevelNormalization.
-// will calculate the average level of the pixels in the
-// defined ROW's black columns
-float fcImage_calcFullFrameRowAvgForRow(UInt16 *frameBufferPtr, int imageWidth, int imageHeight, int theRow)
-{
-	INDI_UNUSED(imageHeight);
-    float floatPixel;
-    float retValue;
-    int /*row,*/ col;
-    //bool evenRow;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-
-    UInt16 lowPixel;
-    UInt16 hiPixel;
-
-    retValue = 0.0;
-
-    lowPixel = 0xffff;
-    hiPixel  = 0;
-
-    // we will average all of the pixels in cols 0 -> 14
-    inputPtr = frameBufferPtr;
-    inputPtr = inputPtr + (theRow * imageWidth);
-
-    for (col = 0; col < 14; col++)
-    {
-        // get the next pixel
-        aPixel = *inputPtr++;
-
-        // find lowest and highest pixel
-        if (lowPixel > aPixel)
-            lowPixel = aPixel;
-
-        if (hiPixel < aPixel)
-            hiPixel = aPixel;
-
-        floatPixel = (float)aPixel;
-        retValue += floatPixel;
-    }
-
-    // throw out lowest and highest
-    //	floatPixel = (float) lowPixel;
-    //	retValue  -= floatPixel;
-    //	floatPixel = (float) hiPixel;
-    //	retValue  -= floatPixel;
-
-    //divide by the number of pixels in the black col
-    retValue = retValue / 14.0;
-    //	retValue = retValue / 12.0;
-
-    return retValue;
-}
-
-// routine to perform line level normalization on the RAW camera image
-// Used to get rid of the camera's read noise associated with ROWs
-// enter with pointer to 16 bit image
-//
-void fcImage_doFullFrameRowLevelNormalization(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
-{
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-    float rowAvg = 0;
-    float thisRowAvg;
-    //float minRowAvg;
-    //float colAvg;
-    float frameAvg;
-    float rowOffset;
-    //float colOffset;
-    float floatPixel;
-
-    if (gDoSimulation)
-    {
-        srand(time(NULL));
-        int i = 0, j = 0;
-
-        for (i = 0; i < imageHeight; i++)
-            for (j = 0; j < imageWidth; j++)
-                frameBufferPtr[i * imageWidth + j] = rand() % 65535;
-
-        return;
-    }
-
-    // make sure we are dealing with 16 bit pixels
-    //	printf("fcImage_doFullFrameRowLevelNormalization\n");
-
-    // calculate the average of all the black pixels
-    frameAvg = fcImage_calcFullFrameAllColAvg(frameBufferPtr, imageWidth, imageHeight);
-
-    for (row = 0; row < imageHeight; row++)
-    {
-        if (row > 0)
-            rowAvg = fcImage_calcFullFrameRowAvgForRow(frameBufferPtr, imageWidth, imageHeight, (row - 1));
-        //		rowAvg  = [self calcFullFrameRowMedianForRow: (row - 1)];
-
-        thisRowAvg = fcImage_calcFullFrameRowAvgForRow(frameBufferPtr, imageWidth, imageHeight, row);
-        //		thisRowAvg = [self calcFullFrameRowMedianForRow: row];
-
-        if (row == 0)
-            rowOffset = frameAvg - thisRowAvg;
-        else
-            rowOffset = rowAvg - thisRowAvg; // 11-23-07
-
-        inputPtr = frameBufferPtr;
-        inputPtr = inputPtr + (row * imageWidth);
-        for (col = 0; col < imageWidth; col++)
-        //		for (col = 0; col < (imageWidth / 2); col++)
-        {
-            // get the next pixel
-            aPixel = *inputPtr;
-
-            floatPixel = (float)aPixel;
-
-            floatPixel += rowOffset;
-
-            if (floatPixel > 65535.0)
-                floatPixel = 65535.0;
-
-            if (floatPixel < 0.0)
-                floatPixel = 0.0;
-
-            // put corrected value back
-            *inputPtr++ = (UInt16)floatPixel;
-        }
-    }
-}
-
-// routine to strip the black columns form the image read from the camera.  the camera's image is
-// assumed to be in gFrameBuffer and the pointer passed to this routine is where we will put the
-// stripped image;
-void fcImage_StripBlackCols(int camNum, UInt16 *frameBuffer)
-{
-    //float reference;
-    int row, col;
-    int imageHeight, imageWidth;
-    UInt16 *inputPtr;
-    UInt16 *outputPtr;
-    //UInt16 aPixel;
-    //float rowAvg;
-    //float thisRowAvg;
-    //float minRowAvg;
-    //float colAvg;
-    //float frameAvg;
-    //float rowOffset;
-    //float colOffset;
-    //float floatPixel;
-
-    imageHeight = (gRoi_bottom[camNum - 1] - gRoi_top[camNum - 1]) + 1;
-    imageWidth  = (gRoi_right[camNum - 1] - gRoi_left[camNum - 1]) + 1;
-
-    for (row = 0; row < imageHeight; row++)
-    {
-        inputPtr = gFrameBuffer;
-        //		if (row < (imageHeight / 2))
-        inputPtr = inputPtr + (row * (imageWidth + 16)) + 16;
-        //		else
-        //			inputPtr = inputPtr + (row * (imageWidth + 16));
-        outputPtr = frameBuffer;
-        outputPtr = outputPtr + (row * imageWidth);
-
-        for (col = 0; col < imageWidth; col++)
-        {
-            // transfer pixel
-            *outputPtr++ = *inputPtr++;
-        }
-    }
-}
-
 // the following three routines are used to touch up the images from the IBIS1300 sensor
 // it normalizes the offsets in the columns.
 // clear out the black row vector for the IBIS1300 image sensor
@@ -1287,7 +1084,7 @@ void fcImage_IBIS_divideBlackRowAverage(void)
         gBlackOffsets[i] = gBlackOffsets[i] / 4;
 }
 
-// helper routine for fcImage_IBIS_doFullFrameColLevelNormalization.
+// helper routine for the IBIS column normalization.
 // will calculate the average level of the pixels in the
 // first black row of the image sensor
 //
@@ -1321,56 +1118,6 @@ float fcImage_IBIS_calcFirstBlackRowAverage(UInt16 *frameBufferPtr, int imageWid
     return retValue;
 }
 
-// routine which will subtract out the offset pedestal from the image.  It looks at the
-// first row of black pixels to determine the average of the row.  Then it subtracts out
-// that number from each pixel in the image.
-void fcImage_IBIS_subtractPedestal(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
-{
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-    SInt32 bigPixel;
-    SInt32 thePedestal;
-    //float rowAvg;
-    //float thisColBlack;
-    //float minRowAvg;
-    //float colAvg;
-    float frameAvg;
-    //float rowOffset;
-    //float colOffset;
-    //float floatPixel;
-
-    // calculate the average of all the black pixels in the first row
-    frameAvg    = fcImage_IBIS_calcFirstBlackRowAverage(frameBufferPtr, imageWidth, imageHeight);
-    thePedestal = (SInt32)frameAvg;
-
-    // don't touch the black row.  Start at row '1'
-    inputPtr = frameBufferPtr;
-    inputPtr = inputPtr + imageWidth;
-    for (col = 0; col < imageWidth; col++)
-    {
-        for (row = 1; row < imageHeight; row++)
-        {
-            aPixel   = *inputPtr;
-            bigPixel = (SInt32)aPixel;
-            bigPixel = bigPixel - thePedestal;
-
-            if (bigPixel > 65535)
-                bigPixel = 65535;
-
-            if (bigPixel < 0)
-                bigPixel = 0;
-
-            // put corrected value back
-            *inputPtr = (UInt16)bigPixel;
-
-            // point to next
-            inputPtr++;
-        }
-    }
-}
-
 // this routine is called everytime the gain setting is changed on the IBIS1300 image sensor.  I takes 8 frames
 // and stores the average of the first black row of pixels in the sensor.  The resulting vector is then used
 // to normalize the columns everytime a new image is readout.
@@ -1430,66 +1177,6 @@ void fcImage_IBIS_computeAvgColOffsets(int camNum)
     fcUsb_cmd_setIntegrationTime(camNum, savedIntegrationTime);
 }
 
-// routine to perform column level normalization on the RAW camera image
-// Used to get rid of the camera's fixed pattern noise associated with COLs
-// enter with pointer to 16 bit image
-//
-void fcImage_IBIS_doFullFrameColLevelNormalization(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
-{
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-    //float rowAvg;
-    SInt32 thisColBlack;
-    //float minRowAvg;
-    //float colAvg;
-    float frameAvg;
-    //float rowOffset;
-    SInt32 colOffset;
-    //float floatPixel;
-    SInt32 blackAvg;
-    SInt32 bigPixel;
-    //SInt32 theOffset;
-
-    // make sure we are dealing with 16 bit pixels
-
-    //	printf("fcImage_IBIS_doFullFrameColLevelNormalization\n");
-
-    // calculate the average of all the black pixels
-    frameAvg = fcImage_IBIS_calcFirstBlackRowAverage(frameBufferPtr, imageWidth, imageHeight);
-    blackAvg = (SInt32)frameAvg;
-
-    for (col = 0; col < imageWidth; col++)
-    {
-        // first get this cols black pixel from the first row of the image
-        thisColBlack = gBlackOffsets[col];
-
-        colOffset = blackAvg - thisColBlack;
-
-        for (row = 1; row < imageHeight; row++)
-        {
-            // get the pixel for this row/col
-            inputPtr = frameBufferPtr;
-            inputPtr = inputPtr + (row * imageWidth) + col;
-            aPixel   = *inputPtr;
-            bigPixel = (SInt32)aPixel;
-
-            // normalize
-            bigPixel = bigPixel + colOffset;
-
-            if (bigPixel > 65535)
-                bigPixel = 65535;
-
-            if (bigPixel < 0)
-                bigPixel = 0;
-
-            // put corrected value back
-            *inputPtr = (UInt16)bigPixel;
-        }
-    }
-}
-
 // routine to compute the column level offsets in the image.
 // We do this by examining the vertical overscan region in the image
 // Computing the average in the particular column.
@@ -1557,59 +1244,6 @@ void fcImage_PRO_calcColOffsets(UInt16 *frameBufferPtr, int imageWidth, int imag
     }
 }
 
-// routine to perform column level normalization on the RAW camera image
-// Used to get rid of the sensor's fixed pattern noise associated with COLs
-// enter with pointer to 16 bit image
-//
-void fcImage_PRO_doFullFrameColLevelNormalization(UInt16 *frameBufferPtr, int imageWidth, int imageHeight)
-{
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 aPixel;
-    //float rowAvg;
-    //float thisRowAvg;
-    //float minRowAvg;
-    //float colAvg;
-    //float frameAvg;
-    //float rowOffset;
-    float colOffset;
-    float floatPixel;
-
-    //	printf("fcImage_PRO_doFullFrameColLevelNormalization\n");
-    Starfish_Log("fcImage_PRO_doFullFrameColLevelNormalization\n");
-
-    // calculate the average of all the black pixels in the vertical overscan area
-    //	fcImage_PRO_calcColOffsets(frameBufferPtr, imageWidth, imageHeight);
-
-    for (row = 0; row < imageHeight; row++)
-    {
-        inputPtr = frameBufferPtr;
-        inputPtr = inputPtr + (row * imageWidth);
-        for (col = 0; col < imageWidth; col++)
-        {
-            // get the next pixel
-            aPixel = *inputPtr;
-
-            // get the offset for this column
-            colOffset = (float)gProBlackColOffsets[col];
-
-            floatPixel = (float)aPixel;
-
-            floatPixel -= colOffset;
-
-            if (floatPixel > 65535.0)
-                floatPixel = 65535.0;
-
-            if (floatPixel < 0.0)
-                floatPixel = 0.0;
-
-            // put corrected value back
-            *inputPtr++ = (UInt16)floatPixel;
-        }
-    }
-}
-
 // this routine is used internally to calibrate the PRO series cameras.  We do this each time
 // the fcPROP_NUMSAMPLES property is changed or if the sensor's temperature changes by more than 1 degree C.
 //
@@ -1669,274 +1303,6 @@ void fcImage_PRO_calibrateProCamera(int camNum, UInt16 *frameBufferPtr, int imag
     gProWantColNormalization = savedWantNorm;
 }
 
-// routine to perform a 3x3 kernel filter on the image buffer
-//
-void fcImage_do_3x3_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
-{
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 *outputPtr;
-    UInt16 aPixel;
-    UInt32 accumPixel;
-    UInt16 *tempBuffer;
-    size_t size;
-
-    // this routine will work 'in place'.  We will first allocate a temporary image buffer
-    // we copy the image to it and then fill the original buffer with the filtered image
-    //
-    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
-    tempBuffer = (UInt16 *)malloc(size);
-
-    if (tempBuffer != NULL)
-    {
-        // copy the image buffer to my local storage
-        memcpy(tempBuffer, frameBuffer, size);
-
-        // Start at row '1'
-        for (row = 1; row < (imageHeight - 1); row++)
-        {
-            for (col = 1; col < (imageWidth - 1); col++)
-            {
-                inputPtr  = tempBuffer;
-                inputPtr  = inputPtr + (row * imageWidth) + col;
-                outputPtr = frameBuffer;
-                outputPtr = outputPtr + (row * imageWidth) + col;
-
-                accumPixel = 0;
-
-                inputPtr   = inputPtr - imageWidth - 1; // 1
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                inputPtr++; // 2
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                inputPtr++; // 3
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                inputPtr   = inputPtr + imageWidth - 2; // 4
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                inputPtr++; // 5
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                inputPtr++; // 6
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                inputPtr   = inputPtr + imageWidth - 2; // 7
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                inputPtr++; // 8
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                inputPtr++; // 9
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-
-                // divide by the kernel size
-                accumPixel = accumPixel / 9;
-
-                // put filtered value back
-                *outputPtr = (UInt16)accumPixel;
-            }
-        }
-
-        free(tempBuffer);
-    }
-}
-
-// routine to perform a 5x5 kernel filter on the image buffer
-//
-void fcImage_do_5x5_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
-{
-    //float reference;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 *outputPtr;
-    UInt16 aPixel;
-    UInt32 accumPixel;
-    UInt16 *tempBuffer;
-    size_t size;
-    int x, y;
-
-    // this routine will work 'in place'.  We will first allocate a temporary image buffer
-    // we copy the image to it and then fill the original buffer with the filtered image
-    //
-    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
-    tempBuffer = (UInt16 *)malloc(size);
-
-    if (tempBuffer != NULL)
-    {
-        // copy the image buffer to my local storage
-        memcpy(tempBuffer, frameBuffer, size);
-
-        // Start at row '2'
-        for (row = 2; row < (imageHeight - 2); row++)
-        {
-            for (col = 2; col < (imageWidth - 2); col++)
-            {
-                inputPtr  = tempBuffer;
-                inputPtr  = inputPtr + (row * imageWidth) + col;
-                outputPtr = frameBuffer;
-                outputPtr = outputPtr + (row * imageWidth) + col;
-
-                accumPixel = 0;
-
-                inputPtr = inputPtr - (3 * imageWidth) + 2;
-
-                for (y = 0; y < 5; y++)
-                {
-                    inputPtr   = inputPtr + imageWidth - 4;
-                    aPixel     = *inputPtr;
-                    accumPixel = accumPixel + (UInt32)aPixel;
-
-                    for (x = 0; x < 4; x++)
-                    {
-                        inputPtr++;
-                        aPixel     = *inputPtr;
-                        accumPixel = accumPixel + (UInt32)aPixel;
-                    }
-                }
-
-                // divide by the kernel size
-                accumPixel = accumPixel / 25;
-
-                // put filtered value back
-                *outputPtr = (UInt16)accumPixel;
-            }
-        }
-
-        free(tempBuffer);
-    }
-}
-
-// routine to perform hot pixel removal filter on the image buffer
-//
-// algorithm looks for the center pixel ina 3x3 grid being more than 20%
-// brighter than the brightest of the neigboring pixels.  If it is
-// then it will replace it with the average of the neighboring pixels.
-//
-void fcImage_do_hotPixel_kernel(UInt16 imageHeight, UInt16 imageWidth, UInt16 *frameBuffer)
-{
-    float floatBrightPixel;
-    float floatCenterPixel;
-    int row, col;
-    UInt16 *inputPtr;
-    UInt16 *outputPtr;
-    UInt16 aPixel;
-    UInt32 accumPixel;
-    UInt16 *tempBuffer;
-    size_t size;
-    UInt16 brightestNeighbor;
-    UInt16 thisPixel;
-
-    // this routine will work 'in place'.  We will first allocate a temporary image buffer
-    // we copy the image to it and then fill the original buffer with the filtered image
-    //
-    size       = imageWidth * imageHeight * 2; // 2 bytes/pixel
-    tempBuffer = (UInt16 *)malloc(size);
-
-    if (tempBuffer != NULL)
-    {
-
-        // copy the image buffer to my local storage
-        memcpy(tempBuffer, frameBuffer, size);
-
-        // Start at row '1'
-        for (row = 1; row < (imageHeight - 1); row++)
-        {
-            for (col = 1; col < (imageWidth - 1); col++)
-            {
-                inputPtr  = tempBuffer;
-                inputPtr  = inputPtr + (row * imageWidth) + col;
-                outputPtr = frameBuffer;
-                outputPtr = outputPtr + (row * imageWidth) + col;
-
-                accumPixel        = 0;
-                brightestNeighbor = 0;
-
-                inputPtr   = inputPtr - imageWidth - 1; // 1
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 2
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 3
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr   = inputPtr + imageWidth - 2; // 4
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 5 - center pixel
-                aPixel    = *inputPtr;
-                thisPixel = aPixel;
-
-                inputPtr++; // 6
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr   = inputPtr + imageWidth - 2; // 7
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 8
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                inputPtr++; // 9
-                aPixel     = *inputPtr;
-                accumPixel = accumPixel + (UInt32)aPixel;
-                if (brightestNeighbor < aPixel)
-                    brightestNeighbor = aPixel;
-
-                // divide by the number of surrounding pixels
-                accumPixel = accumPixel / 8;
-
-                floatBrightPixel = (float)brightestNeighbor;
-                floatBrightPixel = floatBrightPixel * 1.2;
-
-                floatCenterPixel = (float)thisPixel;
-
-                if (floatCenterPixel > floatBrightPixel)
-                {
-                    // substitute average
-                    *outputPtr = (UInt16)accumPixel;
-                }
-            }
-        }
-
-        free(tempBuffer);
-    }
-
-    //	Starfish_LogFmt("fcImage_do_hotPixel_kernel numHotPixels = %d\n", numHotPixels);
-}
-
 // This is the framework initialization routine and needs to be called once upon application startup
 void fcUsb_init(void)
 {
@@ -3781,6 +3147,9 @@ int fcUsb_cmd_getRawFrame(int camNum, UInt16 numRows, UInt16 numCols, UInt16 *fr
     //int i;
     //char errorString[513];
     int maxBytes;
+    fcImage_filter filter;
+    SInt32 blackAvg;
+    int col;
     
 
     Starfish_Log("fcUsb_cmd_getRawFrame\n");
@@ -3800,26 +3169,43 @@ int fcUsb_cmd_getRawFrame(int camNum, UInt16 numRows, UInt16 numCols, UInt16 *fr
 
     // get the response to the command
 
+    // the normalization of each camera and the selected filter are done in a single pass over the frame
+    filter = (fcImage_filter)gCameraImageFilter[camNum - 1];
+
     if (gCamerasFound[camNum - 1].camFinalProduct == starfish_pro4m_final_deviceID)
     {
         maxBytes     = numRows * numCols * 2; // 2 bytes / pixel
-        numBytesRead = RcvUSB(camNum, (unsigned char *)&frameBuffer, maxBytes);
+        numBytesRead = RcvUSB(camNum, (unsigned char *)frameBuffer, maxBytes);
 
         Starfish_LogFmt("   read - %ld bytes\n", numBytesRead);
         
 
         if (gProWantColNormalization)
-            fcImage_PRO_doFullFrameColLevelNormalization(frameBuffer, numCols, numRows);
+        {
+            Starfish_Log("PRO column level normalization\n");
+
+            for (col = 0; col < numCols && col < FC_IMAGE_MAX_WIDTH; col++)
+                gImagePipeline.colOffsets[col] = -gProBlackColOffsets[col];
+
+            fcImage_colNormalizeFrame(&gImagePipeline, frameBuffer, numCols, numRows, 0, 0, filter);
+        }
+        else
+            fcImage_filterFrame(&gImagePipeline, frameBuffer, numCols, numRows, filter);
     }
     else
     {
         if (gCamerasFound[camNum - 1].camFinalProduct == starfish_ibis13_final_deviceID)
         {
             maxBytes     = numRows * numCols * 2; // 2 bytes / pixel
-            numBytesRead = RcvUSB(camNum, (unsigned char *)&frameBuffer, maxBytes);
+            numBytesRead = RcvUSB(camNum, (unsigned char *)frameBuffer, maxBytes);
+
+            // columns are brought to the average of the black row, which is then subtracted as the pedestal.
+            // the black row itself is left alone.
+            blackAvg = (SInt32)fcImage_IBIS_calcFirstBlackRowAverage(frameBuffer, numCols, numRows);
+            for (col = 0; col < numCols && col < 1280; col++)
+                gImagePipeline.colOffsets[col] = blackAvg - gBlackOffsets[col];
 
-            fcImage_IBIS_doFullFrameColLevelNormalization(frameBuffer, numCols, numRows);
-            fcImage_IBIS_subtractPedestal(frameBuffer, numCols, numRows);
+            fcImage_colNormalizeFrame(&gImagePipeline, frameBuffer, numCols, numRows, 1, blackAvg, filter);
         }
         else
         {
@@ -3827,7 +3213,7 @@ int fcUsb_cmd_getRawFrame(int camNum, UInt16 numRows, UInt16 numCols, UInt16 *fr
             // then strip out the balck cols after we are done with them
             if (gReadBlack[camNum - 1])
             {
-                maxBytes     = numRows * (numCols + 16) * 2; // 2 bytes / pixel
+                maxBytes     = numRows * (numCols + FC_IMAGE_BLACK_COLS) * 2; // 2 bytes / pixel
                 numBytesRead = RcvUSB(camNum, (unsigned char *)gFrameBuffer, maxBytes);
             }
             else
@@ -3838,31 +3224,12 @@ int fcUsb_cmd_getRawFrame(int camNum, UInt16 numRows, UInt16 numCols, UInt16 *fr
             Starfish_LogFmt("   fcUsb_cmd_getRawFrame - numBytesRead - %i\n", (unsigned int)numBytesRead);
             
             if (gReadBlack[camNum - 1] && numBytesRead != 0)
-            {
-                fcImage_doFullFrameRowLevelNormalization(gFrameBuffer, (numCols + 16), numRows);
-                fcImage_StripBlackCols(camNum, frameBuffer);
-            }
+                fcImage_rowNormalizeFrame(&gImagePipeline, gFrameBuffer, frameBuffer, numCols, numRows, filter);
+            else
+                fcImage_filterFrame(&gImagePipeline, frameBuffer, numCols, numRows, filter);
         } // if Starfish
     }
 
-    if (gCameraImageFilter[camNum - 1] == fc_filter_3x3)
-    {
-        // perform 3x3 kernel filter
-        fcImage_do_3x3_kernel(numRows, numCols, frameBuffer);
-    }
-
-    if (gCameraImageFilter[camNum - 1] == fc_filter_5x5)
-    {
-        // perform 5x5 kernel filter
-        fcImage_do_5x5_kernel(numRows, numCols, frameBuffer);
-    }
-
-    if (gCameraImageFilter[camNum - 1] == fc_filter_hotPixel)
-    {
-        // perform hot pixel removal filter
-        fcImage_do_hotPixel_kernel(numRows, numCols, frameBuffer);
-    }
-
     return (numBytesRead);
 }
 
@@ -0,0 +1,350 @@
+/*
+
+fishcamp_image.c
+
+Single pass post processing of the frames read from the Starfish cameras
+
+Copyright (C) 2026
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#include "fishcamp_image.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define FC_IMAGE_SSE2
+#endif
+
+// number of black columns the row normalization averages, the last two are not reliable
+#define FC_IMAGE_BLACK_AVG_COLS 14
+
+// sums of 9 or 25 pixels divided by 9 or 25 as a multiplication and a shift, exact for any 32 bit sum
+#define FC_DIV9_MUL    0x38E38E39u
+#define FC_DIV9_SHIFT  33
+#define FC_DIV25_MUL   0x51EB851Fu
+#define FC_DIV25_SHIFT 35
+
+static bool gImageUseSimd = true;
+
+bool fcImage_haveSimd(void)
+{
+#ifdef FC_IMAGE_SSE2
+    return gImageUseSimd;
+#else
+    return false;
+#endif
+}
+
+void fcImage_setSimd(bool useSimd)
+{
+    gImageUseSimd = useSimd;
+}
+
+static inline uint16_t fcImage_clamp(int32_t value)
+{
+    if (value > 65535)
+        return 65535;
+    if (value < 0)
+        return 0;
+    return (uint16_t)value;
+}
+
+#ifdef FC_IMAGE_SSE2
+// 4 unsigned 32 bit divisions, _mm_mul_epu32 only multiplies lanes 0 and 2
+static inline __m128i fcImage_divideSse2(__m128i sum, __m128i mul, __m128i shift)
+{
+    __m128i even = _mm_srl_epi64(_mm_mul_epu32(sum, mul), shift);
+    __m128i odd  = _mm_srl_epi64(_mm_mul_epu32(_mm_srli_epi64(sum, 32), mul), shift);
+    return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+}
+
+// box filter row, 8 columns at a time.  Returns the first column left to do.
+static int fcImage_boxRowSse2(const uint16_t *in, uint32_t *slot, uint32_t *colSums, uint16_t *out, int col, int end,
+                              int radius, uint32_t mul, int shift)
+{
+    const __m128i zero     = _mm_setzero_si128();
+    const __m128i mulv     = _mm_set_epi32(0, (int)mul, 0, (int)mul);
+    const __m128i shiftv   = _mm_cvtsi32_si128(shift);
+    const __m128i bias32   = _mm_set1_epi32(32768);
+    const __m128i bias16   = _mm_set1_epi16((short)0x8000);
+    int d;
+
+    for (; col + 8 <= end; col += 8)
+    {
+        __m128i sumLo = zero, sumHi = zero;
+
+        // horizontal sum of each column's neighbours
+        for (d = -radius; d <= radius; d++)
+        {
+            __m128i pixels = _mm_loadu_si128((const __m128i *)(in + col + d));
+            sumLo = _mm_add_epi32(sumLo, _mm_unpacklo_epi16(pixels, zero));
+            sumHi = _mm_add_epi32(sumHi, _mm_unpackhi_epi16(pixels, zero));
+        }
+
+        // the new row enters the box, the oldest one leaves it
+        __m128i colLo = _mm_loadu_si128((const __m128i *)(colSums + col));
+        __m128i colHi = _mm_loadu_si128((const __m128i *)(colSums + col + 4));
+        colLo = _mm_add_epi32(colLo, _mm_sub_epi32(sumLo, _mm_loadu_si128((const __m128i *)(slot + col))));
+        colHi = _mm_add_epi32(colHi, _mm_sub_epi32(sumHi, _mm_loadu_si128((const __m128i *)(slot + col + 4))));
+        _mm_storeu_si128((__m128i *)(colSums + col), colLo);
+        _mm_storeu_si128((__m128i *)(colSums + col + 4), colHi);
+        _mm_storeu_si128((__m128i *)(slot + col), sumLo);
+        _mm_storeu_si128((__m128i *)(slot + col + 4), sumHi);
+
+        if (out != NULL)
+        {
+            __m128i lo = fcImage_divideSse2(colLo, mulv, shiftv);
+            __m128i hi = fcImage_divideSse2(colHi, mulv, shiftv);
+            // no unsigned 32 to 16 bit pack before SSE4.1, go through the signed one
+            __m128i packed = _mm_packs_epi32(_mm_sub_epi32(lo, bias32), _mm_sub_epi32(hi, bias32));
+            _mm_storeu_si128((__m128i *)(out + col), _mm_add_epi16(packed, bias16));
+        }
+    }
+
+    return col;
+}
+#endif
+
+// feeds row 'row' of the frame to the box filter, writes row 'row - radius' once the box is full
+static inline void fcImage_boxPushRow(fcImage_pipeline *p, int row, const int radius)
+{
+    const int size   = 2 * radius + 1;
+    const int end    = p->width - radius;
+    const uint32_t mul = radius == 1 ? FC_DIV9_MUL : FC_DIV25_MUL;
+    const int shift  = radius == 1 ? FC_DIV9_SHIFT : FC_DIV25_SHIFT;
+    const uint16_t *in = p->frame + (size_t)row * p->width;
+    uint32_t *slot     = p->rowSums[row % size];
+    uint32_t *colSums  = p->colSums;
+    uint16_t *out      = NULL;
+    int col            = radius;
+    int d;
+
+    if (row >= size - 1)
+        out = p->frame + (size_t)(row - radius) * p->width;
+
+#ifdef FC_IMAGE_SSE2
+    if (gImageUseSimd)
+        col = fcImage_boxRowSse2(in, slot, colSums, out, col, end, radius, mul, shift);
+#endif
+
+    for (; col < end; col++)
+    {
+        uint32_t sum = 0;
+
+        for (d = -radius; d <= radius; d++)
+            sum += in[col + d];
+
+        colSums[col] += sum - slot[col];
+        slot[col] = sum;
+
+        if (out != NULL)
+            out[col] = (uint16_t)(((uint64_t)colSums[col] * mul) >> shift);
+    }
+}
+
+// feeds a row to the hot pixel filter, which fixes the row before once it has the row after.
+//
+// The center pixel of a 3x3 grid more than 20% brighter than the brightest of its neighbours is
+// replaced with the average of the neighbours.
+static void fcImage_hotPixelPushRow(fcImage_pipeline *p, int row)
+{
+    const int width = p->width;
+    const uint16_t *above, *center, *below;
+    uint16_t *out;
+    int col;
+
+    memcpy(p->rows[row % 3], p->frame + (size_t)row * width, width * sizeof(uint16_t));
+    if (row < 2)
+        return;
+
+    above  = p->rows[(row - 2) % 3];
+    center = p->rows[(row - 1) % 3];
+    below  = p->rows[row % 3];
+    out    = p->frame + (size_t)(row - 1) * width;
+
+    for (col = 1; col < width - 1; col++)
+    {
+        uint16_t neighbours[8] = { above[col - 1], above[col],     above[col + 1], center[col - 1],
+                                   center[col + 1], below[col - 1], below[col],     below[col + 1] };
+        uint32_t accumPixel        = 0;
+        uint16_t brightestNeighbor = 0;
+        float floatBrightPixel;
+        int i;
+
+        for (i = 0; i < 8; i++)
+        {
+            accumPixel += neighbours[i];
+            if (brightestNeighbor < neighbours[i])
+                brightestNeighbor = neighbours[i];
+        }
+
+        floatBrightPixel = (float)brightestNeighbor;
+        floatBrightPixel = floatBrightPixel * 1.2;
+
+        if ((float)center[col] > floatBrightPixel)
+            out[col] = (uint16_t)(accumPixel / 8);
+    }
+}
+
+static int fcImage_beginFrame(fcImage_pipeline *p, uint16_t *frame, int width, int height, fcImage_filter filter)
+{
+    int i;
+
+    if (width > FC_IMAGE_MAX_WIDTH || width < 0 || height < 0)
+        return -1;
+
+    p->frame  = frame;
+    p->width  = width;
+    p->height = height;
+    p->filter = filter;
+
+    // a box with nothing in it yet
+    if (filter == fcImage_filter_3x3 || filter == fcImage_filter_5x5)
+    {
+        memset(p->colSums, 0, width * sizeof(uint32_t));
+        for (i = 0; i < 5; i++)
+            memset(p->rowSums[i], 0, width * sizeof(uint32_t));
+    }
+
+    return 0;
+}
+
+static inline void fcImage_pushRow(fcImage_pipeline *p, int row)
+{
+    switch (p->filter)
+    {
+        case fcImage_filter_3x3:
+            fcImage_boxPushRow(p, row, 1);
+            break;
+
+        case fcImage_filter_5x5:
+            fcImage_boxPushRow(p, row, 2);
+            break;
+
+        case fcImage_filter_hotPixel:
+            fcImage_hotPixelPushRow(p, row);
+            break;
+
+        default:
+            break;
+    }
+}
+
+int fcImage_filterFrame(fcImage_pipeline *p, uint16_t *frame, int width, int height, fcImage_filter filter)
+{
+    int row;
+
+    if (filter == fcImage_filter_none)
+        return 0;
+
+    if (fcImage_beginFrame(p, frame, width, height, filter) != 0)
+        return -1;
+
+    for (row = 0; row < height; row++)
+        fcImage_pushRow(p, row);
+
+    return 0;
+}
+
+int fcImage_colNormalizeFrame(fcImage_pipeline *p, uint16_t *frame, int width, int height, int firstRow,
+                              int32_t pedestal, fcImage_filter filter)
+{
+    const int32_t *offsets = p->colOffsets;
+    int row, col;
+
+    if (fcImage_beginFrame(p, frame, width, height, filter) != 0)
+        return -1;
+
+    for (row = 0; row < height; row++)
+    {
+        uint16_t *pixels = frame + (size_t)row * width;
+
+        if (row >= firstRow)
+        {
+            for (col = 0; col < width; col++)
+                pixels[col] = fcImage_clamp((int32_t)fcImage_clamp(pixels[col] + offsets[col]) - pedestal);
+        }
+
+        fcImage_pushRow(p, row);
+    }
+
+    return 0;
+}
+
+// a pixel once the row offset is applied, in floating point as the camera software always did
+static inline uint16_t fcImage_rowCorrect(uint16_t pixel, float rowOffset)
+{
+    float floatPixel = (float)pixel;
+
+    floatPixel += rowOffset;
+
+    if (floatPixel > 65535.0)
+        floatPixel = 65535.0;
+
+    if (floatPixel < 0.0)
+        floatPixel = 0.0;
+
+    return (uint16_t)floatPixel;
+}
+
+int fcImage_rowNormalizeFrame(fcImage_pipeline *p, const uint16_t *raw, uint16_t *frame, int width, int height,
+                              fcImage_filter filter)
+{
+    const int stride = width + FC_IMAGE_BLACK_COLS;
+    float frameAvg   = 0.0;
+    float prevRowAvg = 0.0;
+    int row, col;
+
+    if (fcImage_beginFrame(p, frame, width, height, filter) != 0)
+        return -1;
+
+    // the average level of all the black pixels is the reference of the first row
+    for (row = 0; row < height; row++)
+        for (col = 0; col < FC_IMAGE_BLACK_AVG_COLS; col++)
+            frameAvg += (float)raw[(size_t)row * stride + col];
+    frameAvg = frameAvg / (14.0 * (float)height);
+
+    for (row = 0; row < height; row++)
+    {
+        const uint16_t *in = raw + (size_t)row * stride;
+        uint16_t *out      = frame + (size_t)row * width;
+        float thisRowAvg   = 0.0;
+        float correctedAvg = 0.0;
+        float rowOffset;
+
+        for (col = 0; col < FC_IMAGE_BLACK_AVG_COLS; col++)
+            thisRowAvg += (float)in[col];
+        thisRowAvg = thisRowAvg / 14.0;
+
+        // each row is brought to the level of the row before, once corrected
+        rowOffset = (row == 0 ? frameAvg : prevRowAvg) - thisRowAvg;
+
+        for (col = 0; col < FC_IMAGE_BLACK_AVG_COLS; col++)
+            correctedAvg += (float)fcImage_rowCorrect(in[col], rowOffset);
+        prevRowAvg = correctedAvg / 14.0;
+
+        in += FC_IMAGE_BLACK_COLS;
+        for (col = 0; col < width; col++)
+            out[col] = fcImage_rowCorrect(in[col], rowOffset);
+
+        fcImage_pushRow(p, row);
+    }
+
+    return 0;
+}
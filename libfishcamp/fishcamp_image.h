@@ -0,0 +1,88 @@
+/*
+
+fishcamp_image.h
+
+Single pass post processing of the frames read from the Starfish cameras
+
+Copyright (C) 2026
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// widest frame the row caches can hold, the internal frame buffer is 3364 columns wide
+#define FC_IMAGE_MAX_WIDTH 4096
+
+// number of black columns in front of each row when the camera is asked to read them
+#define FC_IMAGE_BLACK_COLS 16
+
+// same values as the fc_filter type of fishcamp.h
+typedef enum {
+	fcImage_filter_none,
+	fcImage_filter_3x3,
+	fcImage_filter_5x5,
+	fcImage_filter_hotPixel
+} fcImage_filter;
+
+// Every frame goes through the normalization and the filter row by row: each row is normalized
+// into the frame, then feeds the filter, which writes its result a few rows behind.  The filter only
+// keeps a few rows, so no full frame copy is needed:
+//  - box filters keep the horizontal sums of the last 3 or 5 rows and the vertical sum of those per column
+//  - the hot pixel filter keeps the last 3 rows before filtering
+// The results are the same, bit for bit, as the full frame routines they replace.
+typedef struct {
+	uint32_t rowSums[5][FC_IMAGE_MAX_WIDTH]; // horizontal sums, rolling over the rows of the box
+	uint32_t colSums[FC_IMAGE_MAX_WIDTH];    // sum of rowSums per column
+	uint16_t rows[3][FC_IMAGE_MAX_WIDTH];    // unfiltered rows, rolling, for the hot pixel filter
+	int32_t colOffsets[FC_IMAGE_MAX_WIDTH];  // added to each column by fcImage_colNormalizeFrame
+
+	// frame being processed
+	uint16_t *frame;
+	int width;
+	int height;
+	fcImage_filter filter;
+} fcImage_pipeline;
+
+// filter only
+int fcImage_filterFrame(fcImage_pipeline *p, uint16_t *frame, int width, int height, fcImage_filter filter);
+
+// column normalization with the offsets of p->colOffsets, then pedestal subtraction, each result clamped to 16 bits.
+// Rows before firstRow are left alone.  Starfish PRO: offsets are minus the overscan offsets, no pedestal.  IBIS1300:
+// offsets are the pedestal minus the black row average of each column, rows start at 1 after the black row.
+int fcImage_colNormalizeFrame(fcImage_pipeline *p, uint16_t *frame, int width, int height, int firstRow,
+                              int32_t pedestal, fcImage_filter filter);
+
+// row normalization on the black columns of the first 14 columns of raw, which has FC_IMAGE_BLACK_COLS more
+// columns than the frame.  The black columns are not copied to the frame.
+int fcImage_rowNormalizeFrame(fcImage_pipeline *p, const uint16_t *raw, uint16_t *frame, int width, int height,
+                              fcImage_filter filter);
+
+// true if the vector routines are compiled in and in use
+bool fcImage_haveSimd(void);
+// use the vector routines when compiled in, on by default.  Both give the same results.
+void fcImage_setSimd(bool useSimd);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,415 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Name         : test_fishcamp_image.cpp
+ * Frame post processing against the full frame routines it replaced
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "fishcamp_image.h"
+
+/*
+ * The golden results come from the full frame routines of fishcamp.c as they were, here with the
+ * loads and stores written plainly.  SInt32 of the library is a long.
+ */
+namespace reference
+{
+
+void do_3x3_kernel(int imageHeight, int imageWidth, uint16_t *frameBuffer)
+{
+    std::vector<uint16_t> temp(frameBuffer, frameBuffer + imageWidth * imageHeight);
+    for (int row = 1; row < (imageHeight - 1); row++)
+        for (int col = 1; col < (imageWidth - 1); col++)
+        {
+            uint32_t accumPixel = 0;
+            for (int y = -1; y <= 1; y++)
+                for (int x = -1; x <= 1; x++)
+                    accumPixel += temp[(row + y) * imageWidth + col + x];
+            frameBuffer[row * imageWidth + col] = accumPixel / 9;
+        }
+}
+
+void do_5x5_kernel(int imageHeight, int imageWidth, uint16_t *frameBuffer)
+{
+    std::vector<uint16_t> temp(frameBuffer, frameBuffer + imageWidth * imageHeight);
+    for (int row = 2; row < (imageHeight - 2); row++)
+        for (int col = 2; col < (imageWidth - 2); col++)
+        {
+            uint32_t accumPixel = 0;
+            for (int y = -2; y <= 2; y++)
+                for (int x = -2; x <= 2; x++)
+                    accumPixel += temp[(row + y) * imageWidth + col + x];
+            frameBuffer[row * imageWidth + col] = accumPixel / 25;
+        }
+}
+
+void do_hotPixel_kernel(int imageHeight, int imageWidth, uint16_t *frameBuffer)
+{
+    std::vector<uint16_t> temp(frameBuffer, frameBuffer + imageWidth * imageHeight);
+    for (int row = 1; row < (imageHeight - 1); row++)
+        for (int col = 1; col < (imageWidth - 1); col++)
+        {
+            uint32_t accumPixel        = 0;
+            uint16_t brightestNeighbor = 0;
+            for (int y = -1; y <= 1; y++)
+                for (int x = -1; x <= 1; x++)
+                {
+                    if (x == 0 && y == 0)
+                        continue;
+                    uint16_t aPixel = temp[(row + y) * imageWidth + col + x];
+                    accumPixel += aPixel;
+                    if (brightestNeighbor < aPixel)
+                        brightestNeighbor = aPixel;
+                }
+            accumPixel = accumPixel / 8;
+
+            float floatBrightPixel = (float)brightestNeighbor;
+            floatBrightPixel       = floatBrightPixel * 1.2;
+            float floatCenterPixel = (float)temp[row * imageWidth + col];
+
+            if (floatCenterPixel > floatBrightPixel)
+                frameBuffer[row * imageWidth + col] = (uint16_t)accumPixel;
+        }
+}
+
+void PRO_doFullFrameColLevelNormalization(uint16_t *frameBufferPtr, int imageWidth, int imageHeight, const long *offsets)
+{
+    for (int row = 0; row < imageHeight; row++)
+        for (int col = 0; col < imageWidth; col++)
+        {
+            float floatPixel = (float)frameBufferPtr[row * imageWidth + col];
+            floatPixel -= (float)offsets[col];
+            if (floatPixel > 65535.0)
+                floatPixel = 65535.0;
+            if (floatPixel < 0.0)
+                floatPixel = 0.0;
+            frameBufferPtr[row * imageWidth + col] = (uint16_t)floatPixel;
+        }
+}
+
+float IBIS_calcFirstBlackRowAverage(int imageWidth, const long *blackOffsets)
+{
+    float retValue = 0.0;
+    for (int col = 0; col < imageWidth; col++)
+        retValue += (float)blackOffsets[col];
+    return retValue / (float)imageWidth;
+}
+
+void IBIS_doFullFrameColLevelNormalization(uint16_t *frameBufferPtr, int imageWidth, int imageHeight,
+        const long *blackOffsets)
+{
+    long blackAvg = (long)IBIS_calcFirstBlackRowAverage(imageWidth, blackOffsets);
+    for (int col = 0; col < imageWidth; col++)
+    {
+        long colOffset = blackAvg - blackOffsets[col];
+        for (int row = 1; row < imageHeight; row++)
+        {
+            long bigPixel = (long)frameBufferPtr[row * imageWidth + col] + colOffset;
+            if (bigPixel > 65535)
+                bigPixel = 65535;
+            if (bigPixel < 0)
+                bigPixel = 0;
+            frameBufferPtr[row * imageWidth + col] = (uint16_t)bigPixel;
+        }
+    }
+}
+
+void IBIS_subtractPedestal(uint16_t *frameBufferPtr, int imageWidth, int imageHeight, const long *blackOffsets)
+{
+    long thePedestal = (long)IBIS_calcFirstBlackRowAverage(imageWidth, blackOffsets);
+    uint16_t *inputPtr = frameBufferPtr + imageWidth;
+    for (int i = 0; i < imageWidth * (imageHeight - 1); i++, inputPtr++)
+    {
+        long bigPixel = (long)*inputPtr - thePedestal;
+        if (bigPixel > 65535)
+            bigPixel = 65535;
+        if (bigPixel < 0)
+            bigPixel = 0;
+        *inputPtr = (uint16_t)bigPixel;
+    }
+}
+
+float calcFullFrameAllColAvg(uint16_t *frameBufferPtr, int imageWidth, int imageHeight)
+{
+    float retValue = 0.0;
+    for (int row = 0; row < imageHeight; row++)
+        for (int col = 0; col < 14; col++)
+            retValue += (float)frameBufferPtr[row * imageWidth + col];
+    retValue = retValue / (14.0 * (float)imageHeight);
+    return retValue;
+}
+
+float calcFullFrameRowAvgForRow(uint16_t *frameBufferPtr, int imageWidth, int theRow)
+{
+    float retValue = 0.0;
+    for (int col = 0; col < 14; col++)
+        retValue += (float)frameBufferPtr[theRow * imageWidth + col];
+    retValue = retValue / 14.0;
+    return retValue;
+}
+
+void doFullFrameRowLevelNormalization(uint16_t *frameBufferPtr, int imageWidth, int imageHeight)
+{
+    float rowAvg = 0, rowOffset = 0;
+    float frameAvg = calcFullFrameAllColAvg(frameBufferPtr, imageWidth, imageHeight);
+
+    for (int row = 0; row < imageHeight; row++)
+    {
+        if (row > 0)
+            rowAvg = calcFullFrameRowAvgForRow(frameBufferPtr, imageWidth, row - 1);
+        float thisRowAvg = calcFullFrameRowAvgForRow(frameBufferPtr, imageWidth, row);
+
+        if (row == 0)
+            rowOffset = frameAvg - thisRowAvg;
+        else
+            rowOffset = rowAvg - thisRowAvg;
+
+        for (int col = 0; col < imageWidth; col++)
+        {
+            float floatPixel = (float)frameBufferPtr[row * imageWidth + col];
+            floatPixel += rowOffset;
+            if (floatPixel > 65535.0)
+                floatPixel = 65535.0;
+            if (floatPixel < 0.0)
+                floatPixel = 0.0;
+            frameBufferPtr[row * imageWidth + col] = (uint16_t)floatPixel;
+        }
+    }
+}
+
+void StripBlackCols(const uint16_t *raw, uint16_t *frameBuffer, int imageWidth, int imageHeight)
+{
+    for (int row = 0; row < imageHeight; row++)
+        memcpy(frameBuffer + row * imageWidth, raw + row * (imageWidth + 16) + 16, imageWidth * sizeof(uint16_t));
+}
+
+void filter(fcImage_filter filter, int height, int width, uint16_t *frame)
+{
+    if (filter == fcImage_filter_3x3)
+        do_3x3_kernel(height, width, frame);
+    if (filter == fcImage_filter_5x5)
+        do_5x5_kernel(height, width, frame);
+    if (filter == fcImage_filter_hotPixel)
+        do_hotPixel_kernel(height, width, frame);
+}
+
+}
+
+/* A star field on a bias level with read noise, hot pixels, and some saturation */
+static std::vector<uint16_t> makeFrame(int width, int height, unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::normal_distribution<float> noise(1200, 40);
+    std::vector<uint16_t> frame(width * height);
+
+    for (auto &pixel : frame)
+        pixel = static_cast<uint16_t>(std::max(0.0f, noise(random)));
+    for (int i = 0; i < width * height / 500; i++)
+        frame[random() % frame.size()] = 20000 + random() % 45535;
+    for (int i = 0; i < width * height / 5000; i++)
+        frame[random() % frame.size()] = 65535;
+    for (int i = 0; i < width * height / 5000; i++)
+        frame[random() % frame.size()] = 0;
+    return frame;
+}
+
+static const fcImage_filter filters[] = { fcImage_filter_none, fcImage_filter_3x3, fcImage_filter_5x5, fcImage_filter_hotPixel };
+
+struct FrameSize
+{
+    int width, height;
+};
+
+// camera frames, then odd sizes for the vector tails and the borders
+static const FrameSize sizes[] = { { 1280, 1024 }, { 2304, 2305 }, { 37, 23 }, { 9, 9 }, { 5, 5 }, { 3, 2 }, { 1, 1 } };
+
+class FishcampImage : public ::testing::TestWithParam<bool>
+{
+    protected:
+        void SetUp() override
+        {
+            fcImage_setSimd(GetParam());
+            pipeline.reset(new fcImage_pipeline);
+        }
+        void TearDown() override
+        {
+            fcImage_setSimd(true);
+        }
+
+        std::unique_ptr<fcImage_pipeline> pipeline;
+};
+
+TEST_P(FishcampImage, Filters)
+{
+    for (const auto &size : sizes)
+        for (auto filter : filters)
+        {
+            std::vector<uint16_t> expected = makeFrame(size.width, size.height, size.width);
+            std::vector<uint16_t> frame    = expected;
+
+            reference::filter(filter, size.height, size.width, expected.data());
+            ASSERT_EQ(fcImage_filterFrame(pipeline.get(), frame.data(), size.width, size.height, filter), 0);
+            ASSERT_EQ(frame, expected) << size.width << "x" << size.height << " filter " << filter;
+        }
+}
+
+TEST_P(FishcampImage, ProColumns)
+{
+    std::mt19937 random(4);
+    std::vector<long> offsets(4096);
+    for (auto &offset : offsets)
+        offset = static_cast<long>(random() % 400) - 200;
+    // enough to clamp both ways
+    offsets[7]  = 2000;
+    offsets[11] = -65000;
+
+    for (const auto &size : sizes)
+        for (auto filter : filters)
+        {
+            std::vector<uint16_t> expected = makeFrame(size.width, size.height, size.height);
+            std::vector<uint16_t> frame    = expected;
+
+            reference::PRO_doFullFrameColLevelNormalization(expected.data(), size.width, size.height, offsets.data());
+            reference::filter(filter, size.height, size.width, expected.data());
+
+            for (int col = 0; col < size.width; col++)
+                pipeline->colOffsets[col] = -offsets[col];
+            ASSERT_EQ(fcImage_colNormalizeFrame(pipeline.get(), frame.data(), size.width, size.height, 0, 0, filter), 0);
+            ASSERT_EQ(frame, expected) << size.width << "x" << size.height << " filter " << filter;
+        }
+}
+
+TEST_P(FishcampImage, IbisColumnsAndPedestal)
+{
+    const int width = 1280, height = 1024;
+    std::mt19937 random(5);
+    std::vector<long> blackOffsets(width);
+    for (auto &offset : blackOffsets)
+        offset = 1150 + random() % 100;
+    blackOffsets[3] = 40000;
+
+    for (auto filter : filters)
+    {
+        std::vector<uint16_t> expected = makeFrame(width, height, 6);
+        std::vector<uint16_t> frame    = expected;
+
+        reference::IBIS_doFullFrameColLevelNormalization(expected.data(), width, height, blackOffsets.data());
+        reference::IBIS_subtractPedestal(expected.data(), width, height, blackOffsets.data());
+        reference::filter(filter, height, width, expected.data());
+
+        long blackAvg = (long)reference::IBIS_calcFirstBlackRowAverage(width, blackOffsets.data());
+        for (int col = 0; col < width; col++)
+            pipeline->colOffsets[col] = blackAvg - blackOffsets[col];
+        ASSERT_EQ(fcImage_colNormalizeFrame(pipeline.get(), frame.data(), width, height, 1, blackAvg, filter), 0);
+        ASSERT_EQ(frame, expected) << "filter " << filter;
+    }
+}
+
+TEST_P(FishcampImage, BlackColumnRows)
+{
+    for (const auto &size : sizes)
+        for (auto filter : filters)
+        {
+            int stride = size.width + FC_IMAGE_BLACK_COLS;
+            std::vector<uint16_t> raw = makeFrame(stride, size.height, stride);
+            // row to row level changes in the black columns as well as in the image
+            for (int row = 0; row < size.height; row++)
+                for (int col = 0; col < stride; col++)
+                    raw[row * stride + col] = std::min(65535, raw[row * stride + col] + (row % 7) * 31);
+
+            std::vector<uint16_t> work = raw, expected(size.width * size.height), frame(size.width * size.height);
+            reference::doFullFrameRowLevelNormalization(work.data(), stride, size.height);
+            reference::StripBlackCols(work.data(), expected.data(), size.width, size.height);
+            reference::filter(filter, size.height, size.width, expected.data());
+
+            ASSERT_EQ(fcImage_rowNormalizeFrame(pipeline.get(), raw.data(), frame.data(), size.width, size.height, filter), 0);
+            ASSERT_EQ(frame, expected) << size.width << "x" << size.height << " filter " << filter;
+        }
+}
+
+TEST_P(FishcampImage, TooWide)
+{
+    std::vector<uint16_t> frame(FC_IMAGE_MAX_WIDTH + 1, 1);
+    EXPECT_EQ(fcImage_filterFrame(pipeline.get(), frame.data(), FC_IMAGE_MAX_WIDTH + 1, 1, fcImage_filter_3x3), -1);
+}
+
+INSTANTIATE_TEST_SUITE_P(Simd, FishcampImage, ::testing::Values(true, false),
+                         [](const ::testing::TestParamInfo<bool> &info)
+{
+    return info.param ? "Vector" : "Scalar";
+});
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Per frame time against the full frame routines, on the 1280x1024 Starfish and Pro4M frame sizes */
+TEST(FishcampImageBenchmark, PerFrame)
+{
+    const FrameSize frames[] = { { 1280, 1024 }, { 2304, 2305 } };
+    const char *names[]      = { "none", "3x3", "5x5", "hot pixel" };
+    const int repeat         = 3;
+    std::unique_ptr<fcImage_pipeline> pipeline(new fcImage_pipeline);
+    std::vector<long> offsets(4096, 10);
+
+    for (const auto &size : frames)
+    {
+        const std::vector<uint16_t> source = makeFrame(size.width, size.height, 1);
+
+        for (int i = 0; i < 4; i++)
+        {
+            fcImage_filter filter = filters[i];
+            std::vector<uint16_t> frame;
+
+            auto start = std::chrono::steady_clock::now();
+            for (int n = 0; n < repeat; n++)
+            {
+                frame = source;
+                reference::PRO_doFullFrameColLevelNormalization(frame.data(), size.width, size.height, offsets.data());
+                reference::filter(filter, size.height, size.width, frame.data());
+            }
+            double legacyMs = elapsedMs(start) / repeat;
+
+            double ms[2];
+            for (bool simd : { false, true })
+            {
+                fcImage_setSimd(simd);
+                for (int col = 0; col < size.width; col++)
+                    pipeline->colOffsets[col] = -offsets[col];
+                start = std::chrono::steady_clock::now();
+                for (int n = 0; n < repeat; n++)
+                {
+                    frame = source;
+                    fcImage_colNormalizeFrame(pipeline.get(), frame.data(), size.width, size.height, 0, 0, filter);
+                }
+                ms[simd] = elapsedMs(start) / repeat;
+            }
+            fcImage_setSimd(true);
+
+            printf("%dx%d column normalization + %-9s: full frame passes %7.2f ms, single pass %7.2f ms scalar, %7.2f ms vector\n",
+                   size.width, size.height, names[i], legacyMs, ms[0], ms[1]);
+        }
+    }
+}